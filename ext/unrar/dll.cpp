@@ -421,6 +421,39 @@ int PASCAL RARGetDllVersion()
 }
 
 
+/* SumatraPDF: returns the position of the file header most recently read
+   by RARReadHeaderEx */
+int PASCAL RARGetHeaderPos(HANDLE hArcData,unsigned int *PosLow,unsigned int *PosHigh)
+{
+  DataSet *Data=(DataSet *)hArcData;
+  if (Data->Arc.GetHeaderType()!=HEAD_FILE)
+    return ERAR_EREFERENCE;
+  *PosLow=uint(Data->Arc.CurBlockPos & 0xffffffff);
+  *PosHigh=uint(Data->Arc.CurBlockPos>>32);
+  return ERAR_SUCCESS;
+}
+
+
+/* SumatraPDF: makes the next RARReadHeaderEx read the file header at a
+   position returned by RARGetHeaderPos (unpacking a file only depends on
+   the files preceding it in solid archives, where this isn't supported) */
+int PASCAL RARSeekToHeader(HANDLE hArcData,unsigned int PosLow,unsigned int PosHigh)
+{
+  DataSet *Data=(DataSet *)hArcData;
+  if (Data->Arc.Solid || Data->Arc.Volume)
+    return ERAR_EREFERENCE;
+  try
+  {
+    Data->Arc.Seek(int64(PosLow)+(int64(PosHigh)<<32),SEEK_SET);
+  }
+  catch (RAR_EXIT ErrCode)
+  {
+    return RarErrorToDll(ErrCode);
+  }
+  return ERAR_SUCCESS;
+}
+
+
 static int RarErrorToDll(RAR_EXIT ErrCode)
 {
   switch(ErrCode)
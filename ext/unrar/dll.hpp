@@ -155,6 +155,9 @@ void   PASCAL RARSetChangeVolProc(HANDLE hArcData,CHANGEVOLPROC ChangeVolProc);
 void   PASCAL RARSetProcessDataProc(HANDLE hArcData,PROCESSDATAPROC ProcessDataProc);
 void   PASCAL RARSetPassword(HANDLE hArcData,char *Password);
 int    PASCAL RARGetDllVersion();
+/* SumatraPDF: allow extracting single files from non-solid archives */
+int    PASCAL RARGetHeaderPos(HANDLE hArcData,unsigned int *PosLow,unsigned int *PosHigh);
+int    PASCAL RARSeekToHeader(HANDLE hArcData,unsigned int PosLow,unsigned int PosHigh);
 
 #ifdef __cplusplus
 }
@@ -20,6 +20,8 @@ typedef struct fz_store_s fz_store;
 typedef struct fz_glyph_cache_s fz_glyph_cache;
 typedef struct fz_document_handler_context_s fz_document_handler_context;
 typedef struct fz_context_s fz_context;
+/* SumatraPDF: called with begin set to 1 and 0 at the start and end of a span */
+typedef void (fz_trace_fn)(const char *name, int begin);
 
 struct fz_alloc_context_s
 {
@@ -114,8 +116,18 @@ struct fz_context_s
 	fz_store *store;
 	fz_glyph_cache *glyph_cache;
 	fz_document_handler_context *handler;
+	/* SumatraPDF: optional hook for tracing hot paths */
+	fz_trace_fn *trace;
 };
 
+/*
+	fz_trace_begin, fz_trace_end: Mark the beginning and the end of
+	a span of work in a hot path, if the context has a tracing hook
+	(SumatraPDF). name must be a static string.
+*/
+#define fz_trace_begin(ctx, name) do { if ((ctx)->trace) (ctx)->trace(name, 1); } while (0)
+#define fz_trace_end(ctx, name) do { if ((ctx)->trace) (ctx)->trace(name, 0); } while (0)
+
 /*
 	Specifies the maximum size in bytes of the resource store in
 	fz_context. Given as argument to fz_new_context.
@@ -94,10 +94,20 @@ struct fz_aes_s
 	int nr; /* number of rounds */
 	unsigned long *rk; /* AES round keys */
 	unsigned long buf[68]; /* unaligned data */
+	/* SumatraPDF: round keys as bytes for AES instructions */
+	int hw;
+	unsigned char hw_rk[15][16];
 };
 
 int aes_setkey_enc( fz_aes *ctx, const unsigned char *key, int keysize );
 int aes_setkey_dec( fz_aes *ctx, const unsigned char *key, int keysize );
+/*
+	aes_crypt_cbc: Encrypt or decrypt length bytes (a multiple of 16)
+	in CBC mode. input and output may be the same buffer. iv is updated
+	so that consecutive calls continue the chain, allowing whole buffers
+	to be processed at once. Uses the CPU's AES instructions (AES-NI)
+	when available.
+*/
 void aes_crypt_cbc( fz_aes *ctx, int mode, int length,
 	unsigned char iv[16],
 	const unsigned char *input,
@@ -88,4 +88,14 @@ fz_display_list *fz_keep_display_list(fz_context *ctx, fz_display_list *list);
 */
 void fz_drop_display_list(fz_context *ctx, fz_display_list *list);
 
+/*
+	fz_display_list_size: Estimate the amount of memory used by
+	a display list (not counting shared resources such as fonts,
+	images and shadings), e.g. for storing it in the fz_store.
+
+	Does not throw exceptions.
+*/
+/* SumatraPDF: allow caching display lists for Form XObjects */
+unsigned int fz_display_list_size(fz_context *ctx, fz_display_list *list);
+
 #endif
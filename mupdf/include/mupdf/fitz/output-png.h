@@ -33,6 +33,43 @@ typedef struct fz_png_output_context_s fz_png_output_context;
 
 fz_png_output_context *fz_output_png_header(fz_output *out, int w, int h, int n, int savealpha);
 
+/*
+	SumatraPDF: fz_png_options: Settings for writing PNG images.
+
+	level: zlib compression level (0 to 9 or -1 for zlib's default).
+
+	filter: How rows are predicted before compression (one of the
+	FZ_PNG_FILTER_* values). FZ_PNG_FILTER_ADAPTIVE picks the filter
+	with the smallest sum of absolute differences for each row.
+
+	threads: The maximum number of threads compressing a band (0 for
+	one per processor). Bands are only compressed in the background
+	under Windows and in builds defining HAVE_PTHREADS.
+
+	fz_output_png_header uses zlib's default level, the sub filter
+	and one thread per processor.
+*/
+enum
+{
+	FZ_PNG_FILTER_NONE,
+	FZ_PNG_FILTER_SUB,
+	FZ_PNG_FILTER_UP,
+	FZ_PNG_FILTER_AVERAGE,
+	FZ_PNG_FILTER_PAETH,
+	FZ_PNG_FILTER_ADAPTIVE
+};
+
+typedef struct fz_png_options_s fz_png_options;
+
+struct fz_png_options_s
+{
+	int level;
+	int filter;
+	int threads;
+};
+
+fz_png_output_context *fz_output_png_header_with_options(fz_output *out, int w, int h, int n, int savealpha, const fz_png_options *opts);
+
 void fz_output_png_band(fz_output *out, int w, int h, int n, int band, int bandheight, unsigned char *samples, int savealpha, fz_png_output_context *poc);
 
 void fz_output_png_trailer(fz_output *out, fz_png_output_context *poc);
@@ -81,6 +81,12 @@ struct fz_store_hash_s
 			int id;
 			float m[4];
 		} im;
+		/* SumatraPDF: allow keys made up of two pointers */
+		struct
+		{
+			void *ptr0;
+			void *ptr1;
+		} pp;
 	} u;
 };
 
@@ -183,6 +189,31 @@ void fz_empty_store(fz_context *ctx);
 */
 int fz_store_scavenge(fz_context *ctx, unsigned int size, int *phase);
 
+/*
+	fz_get_store_stats: Retrieve the store's current usage for
+	benchmarking (SumatraPDF).
+
+	size, max: The number of bytes held and the store's limit
+	(FZ_STORE_UNLIMITED for no limit).
+
+	items: The number of items currently in the store.
+
+	hits, misses: The number of successful and failed lookups
+	through fz_find_item since the store was created.
+*/
+typedef struct fz_store_stats_s fz_store_stats;
+
+struct fz_store_stats_s
+{
+	unsigned int size;
+	unsigned int max;
+	int items;
+	int hits;
+	int misses;
+};
+
+void fz_get_store_stats(fz_context *ctx, fz_store_stats *stats);
+
 /*
 	fz_print_store: Dump the contents of the store for debugging.
 */
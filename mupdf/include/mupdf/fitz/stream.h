@@ -148,7 +148,10 @@ fz_buffer *fz_read_all(fz_stream *stm, int initial);
 enum
 {
 	FZ_STREAM_META_PROGRESSIVE = 1,
-	FZ_STREAM_META_LENGTH = 2
+	FZ_STREAM_META_LENGTH = 2,
+	/* SumatraPDF: all data between rp and wp stays valid (and in place)
+	   until the stream is closed, so that filters don't have to copy it */
+	FZ_STREAM_META_MEMORY = 3
 };
 
 int fz_stream_meta(fz_stream *stm, int key, int size, void *ptr);
@@ -22,6 +22,12 @@ struct fz_write_options_s
 				garbage collect the file before writing. */
 	int do_linear; /* If non-zero then write linearised. */
 	int do_clean; /* If non-zero then clean contents */
+	int do_objstms; /* SumatraPDF: If non-zero then pack objects into
+				compressed object streams and write a
+				cross-reference stream. */
+	int do_appending; /* SumatraPDF: If non-zero (and do_incremental)
+				then only write the objects changed since the
+				last pdf_xref_end_incremental_section. */
 	int continue_on_error; /* If non-zero, errors are (optionally)
 					counted and writing continues. */
 	int *errors; /* Pointer to a place to store a count of errors */
@@ -12,6 +12,8 @@ typedef struct pdf_annot_s pdf_annot;
 typedef struct pdf_widget_s pdf_widget;
 typedef struct pdf_hotspot_s pdf_hotspot;
 typedef struct pdf_js_s pdf_js;
+/* SumatraPDF: page tree index (cf. pdf_load_page_tree) */
+typedef struct pdf_page_tree_s pdf_page_tree;
 
 enum
 {
@@ -213,10 +215,15 @@ struct pdf_document_s
 	int num_xref_sections;
 	pdf_xref *xref_sections;
 	int xref_altered;
+	/* SumatraPDF: number of xref sections (at the start of xref_sections)
+	 * holding changes (cf. pdf_xref_end_incremental_section) */
+	int num_incremental_sections;
 	int freeze_updates;
 	int has_xref_streams;
 
 	int page_count;
+	/* SumatraPDF: page tree index (cf. pdf_load_page_tree) */
+	pdf_page_tree *page_tree;
 
 	int repair_attempted;
 
@@ -11,6 +11,23 @@ typedef struct pdf_document_s pdf_document;
 
 typedef struct pdf_obj_s pdf_obj;
 
+/*
+ * Well-known names (see name-table.h) are constant objects instead of
+ * allocated ones, so that dictionary lookups can compare keys by identity.
+ * pdf_new_name returns the constant for any listed name, PDF_NAME(Type)
+ * names one at compile time. Keeping or dropping them is a no-op.
+ */
+enum
+{
+	PDF_OBJ_ENUM_NAME__NONE,
+#define PDF_MAKE_NAME(STRING,NAME) PDF_OBJ_ENUM_NAME_##NAME,
+#include "mupdf/pdf/name-table.h"
+#undef PDF_MAKE_NAME
+	PDF_OBJ_ENUM_NAME__LIMIT
+};
+
+#define PDF_NAME(X) ((pdf_obj *)(intptr_t)PDF_OBJ_ENUM_NAME_##X)
+
 pdf_obj *pdf_new_null(pdf_document *doc);
 pdf_obj *pdf_new_bool(pdf_document *doc, int b);
 pdf_obj *pdf_new_int(pdf_document *doc, int i);
@@ -44,6 +61,7 @@ int pdf_is_indirect(pdf_obj *obj);
 int pdf_is_stream(pdf_document *doc, int num, int gen);
 
 int pdf_objcmp(pdf_obj *a, pdf_obj *b);
+int pdf_name_eq(pdf_obj *a, pdf_obj *b);
 
 /* obj marking and unmarking functions - to avoid infinite recursions. */
 int pdf_obj_marked(pdf_obj *obj);
@@ -86,10 +104,12 @@ int pdf_dict_len(pdf_obj *dict);
 pdf_obj *pdf_dict_get_key(pdf_obj *dict, int idx);
 pdf_obj *pdf_dict_get_val(pdf_obj *dict, int idx);
 pdf_obj *pdf_dict_get(pdf_obj *dict, pdf_obj *key);
+pdf_obj *pdf_dict_geta(pdf_obj *dict, pdf_obj *key, pdf_obj *abbrev);
 pdf_obj *pdf_dict_gets(pdf_obj *dict, const char *key);
 pdf_obj *pdf_dict_getp(pdf_obj *dict, const char *key);
 pdf_obj *pdf_dict_getsa(pdf_obj *dict, const char *key, const char *abbrev);
 void pdf_dict_put(pdf_obj *dict, pdf_obj *key, pdf_obj *val);
+void pdf_dict_put_drop(pdf_obj *dict, pdf_obj *key, pdf_obj *val);
 void pdf_dict_puts(pdf_obj *dict, const char *key, pdf_obj *val);
 void pdf_dict_puts_drop(pdf_obj *dict, const char *key, pdf_obj *val);
 void pdf_dict_putp(pdf_obj *dict, const char *key, pdf_obj *val);
@@ -7,6 +7,44 @@ pdf_obj *pdf_lookup_page_obj(pdf_document *doc, int needle);
 /* SumatraPDF: make pdf_lookup_inherited_page_item externally available */
 pdf_obj *pdf_lookup_inherited_page_item(pdf_document *doc, pdf_obj *node, const char *key);
 
+/*
+	SumatraPDF: pdf_load_page_tree: Index the page tree for constant time
+	lookups through pdf_lookup_page_obj, pdf_lookup_page_number and
+	pdf_lookup_page_item.
+
+	The index is built incrementally: each call continues walking the
+	page tree where the previous one stopped until at least count pages
+	(or all pages for count < 0) have been indexed. Lookups extend the
+	index on demand, so calling this function is optional.
+
+	Returns the number of pages indexed so far. Throws if the page tree
+	is broken, in which case the pages indexed before remain available.
+*/
+int pdf_load_page_tree(pdf_document *doc, int count);
+
+/*
+	SumatraPDF: pdf_drop_page_tree: Drop the page tree index. Modifying
+	the catalog or a /Pages node invalidates the index automatically
+	(cf. pdf_page_tree_altered).
+*/
+void pdf_drop_page_tree(pdf_document *doc);
+
+/*
+	SumatraPDF: pdf_page_tree_altered: Called whenever object num (or
+	an object contained in it) is modified, updated or deleted. Marks
+	the page tree index for rebuilding if num is the catalog or one of
+	the indexed /Pages nodes.
+*/
+void pdf_page_tree_altered(pdf_document *doc, int num);
+
+/*
+	SumatraPDF: pdf_lookup_page_item: Faster pdf_lookup_inherited_page_item
+	for the page at index number: the values of MediaBox, CropBox, Rotate
+	and Resources inherited from the page's ancestors are resolved once
+	when the page is indexed.
+*/
+pdf_obj *pdf_lookup_page_item(pdf_document *doc, int number, pdf_obj *pageobj, const char *key);
+
 /*
 	pdf_load_page: Load a page and its resources.
 
@@ -127,6 +165,8 @@ struct pdf_page_s
 	int transition_present;
 	fz_transition transition;
 	int incomplete;
+	/* SumatraPDF: allow constant time lookups of a page's number */
+	int number;
 };
 
 enum
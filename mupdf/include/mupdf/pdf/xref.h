@@ -86,6 +86,19 @@ void pdf_replace_xref(pdf_document *doc, pdf_xref_entry *entries, int n);
 void pdf_xref_ensure_incremental_object(pdf_document *doc, int num);
 int pdf_xref_is_incremental(pdf_document *doc, int num);
 
+/*
+	SumatraPDF: pdf_xref_end_incremental_section: Start a new
+	incremental xref section with the next change to the document.
+
+	pdf_xref_is_incremental is only true for objects changed after
+	this call, so that incremental updates appended to a file which
+	already contains all previous changes (cf. fz_write_options'
+	do_appending) don't have to repeat them. pdf_xref_is_altered is
+	true for all objects changed since the document was loaded.
+*/
+void pdf_xref_end_incremental_section(pdf_document *doc);
+int pdf_xref_is_altered(pdf_document *doc, int num);
+
 void pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf);
 void pdf_repair_obj_stms(pdf_document *doc);
 pdf_obj *pdf_new_ref(pdf_document *doc, pdf_obj *obj);
@@ -98,6 +111,36 @@ int pdf_repair_obj(pdf_document *doc, pdf_lexbuf *buf, int *stmofsp, int *stmlen
 
 pdf_obj *pdf_progressive_advance(pdf_document *doc, int pagenum);
 
+/*
+	SumatraPDF: warm up the xref cache by decoding object streams ahead of time
+
+	pdf_new_obj_stm_jobs: Read the (raw) data of all not yet loaded object
+	streams (up to max_raw_len bytes in total) and prepare their decoding
+	filters.
+
+	pdf_run_obj_stm_job: Decode a job's data. This may be called from any
+	thread with a context of its own (which must however use the same
+	allocator as the document's context), as it doesn't access the document.
+	Streams decoding to more than max_len bytes are left to be loaded on
+	demand.
+
+	pdf_finish_obj_stm_job: Parse the decoded objects into the xref cache.
+	Jobs that haven't been run are skipped and loaded on demand later on.
+*/
+typedef struct pdf_obj_stm_job_s pdf_obj_stm_job;
+
+struct pdf_obj_stm_job_s
+{
+	int num;
+	fz_stream *stm;
+	fz_buffer *data;
+};
+
+pdf_obj_stm_job *pdf_new_obj_stm_jobs(pdf_document *doc, int max_raw_len, int *count);
+void pdf_run_obj_stm_job(fz_context *ctx, pdf_obj_stm_job *job, int max_len);
+void pdf_finish_obj_stm_job(pdf_document *doc, pdf_obj_stm_job *job);
+void pdf_drop_obj_stm_jobs(pdf_document *doc, pdf_obj_stm_job *jobs, int count);
+
 void pdf_print_xref(pdf_document *);
 
 #endif
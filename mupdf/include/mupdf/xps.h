@@ -74,6 +74,7 @@ struct xps_part_s
 	int size;
 	int cap;
 	unsigned char *data;
+	xps_part *next; /* SumatraPDF: list of prefetched parts */
 };
 
 xps_part *xps_new_part(xps_document *doc, char *name, int size);
@@ -81,6 +82,35 @@ int xps_has_part(xps_document *doc, char *partname);
 xps_part *xps_read_part(xps_document *doc, char *partname);
 void xps_free_part(xps_document *doc, xps_part *part);
 
+/*
+	SumatraPDF: inflate the parts a page refers to in parallel
+
+	xps_new_prefetch_jobs: Collect the fonts, images and remote resource
+	dictionaries referenced by a loaded page which haven't been loaded
+	before, until their total size exceeds max_len. This only works for
+	documents read from memory (see FZ_STREAM_META_MEMORY) and returns
+	NULL for all others.
+
+	xps_run_prefetch_job: Read and inflate a job's part. This may be called
+	from any thread with a context of its own, as it only reads the shared
+	zip data (the context must use the same allocator as the document's).
+
+	xps_finish_prefetch_jobs: Hand all prefetched parts over to the
+	document (where the next xps_read_part for the same name picks them
+	up) and free the jobs.
+*/
+typedef struct xps_prefetch_job_s xps_prefetch_job;
+
+struct xps_prefetch_job_s
+{
+	char *name;
+	xps_part *part;
+};
+
+xps_prefetch_job *xps_new_prefetch_jobs(xps_document *doc, xps_page *page, int max_len, int *count);
+void xps_run_prefetch_job(fz_context *ctx, xps_document *doc, xps_prefetch_job *job);
+void xps_finish_prefetch_jobs(xps_document *doc, xps_prefetch_job *jobs, int count);
+
 /*
  * Document structure.
  */
@@ -232,6 +262,15 @@ struct xps_document_s
 	fz_stream *file;
 	int zip_count;
 	xps_entry *zip_table;
+	/* SumatraPDF: case-insensitive hash index into zip_table */
+	int *zip_hash;
+	int zip_hash_size;
+	/* SumatraPDF: the whole zip file, if it's been read from memory */
+	unsigned char *zip_data;
+	int zip_data_len;
+	/* SumatraPDF: parts inflated ahead of time (cf. xps_new_prefetch_jobs) */
+	xps_part *prefetched;
+	int prefetched_size;
 
 	char *start_part; /* fixed document sequence */
 	xps_fixdoc *first_fixdoc; /* first fixed document */
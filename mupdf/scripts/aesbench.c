@@ -0,0 +1,118 @@
+/* aesbench.c -- Measure the throughput of AES decryption with and without AES instructions */
+
+/*
+	Build with "make build/release/aesbench" and run with the number of
+	megabytes to decrypt per measurement (default 256).
+*/
+
+#include "mupdf/fitz.h"
+
+#include <time.h>
+
+enum { MB = 1 << 20 };
+
+static double
+now(void)
+{
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void
+bench_cbc(unsigned char *buf, int rounds, int keysize, int hw)
+{
+	static unsigned char key[32];
+	unsigned char iv[16] = { 0 };
+	fz_aes aes;
+	double t;
+	int i;
+
+	aes_setkey_dec(&aes, key, keysize);
+	if (hw && !aes.hw)
+	{
+		printf("aes_crypt_cbc AES-%d (AES instructions): not available\n", keysize);
+		return;
+	}
+	aes.hw = hw;
+
+	t = now();
+	for (i = 0; i < rounds; i++)
+		aes_crypt_cbc(&aes, AES_DECRYPT, MB, iv, buf, buf);
+	t = now() - t;
+	printf("aes_crypt_cbc AES-%d (%s): %.0f MB/s\n", keysize, hw ? "AES instructions" : "tables", rounds / t);
+}
+
+static void
+bench_filter(fz_context *ctx, unsigned char *buf, int rounds)
+{
+	static unsigned char key[16];
+	unsigned char iv[16] = { 0 }, out[4096];
+	unsigned char *data;
+	fz_stream *stm = NULL;
+	fz_aes aes;
+	double t;
+	int i;
+
+	fz_var(stm);
+
+	/* an IV followed by the encrypted (and correctly padded) data */
+	data = fz_malloc(ctx, MB);
+	memcpy(data + 16, buf, MB - 32);
+	memset(data + MB - 16, 16, 16);
+	aes_setkey_enc(&aes, key, 128);
+	aes_crypt_cbc(&aes, AES_ENCRYPT, MB - 16, iv, data + 16, data + 16);
+	memset(data, 0, 16);
+
+	t = now();
+	for (i = 0; i < rounds; i++)
+	{
+		fz_try(ctx)
+		{
+			stm = fz_open_aesd(fz_open_memory(ctx, data, MB), key, sizeof(key));
+			while (fz_read(stm, out, sizeof(out)) > 0)
+				;
+		}
+		fz_always(ctx)
+		{
+			fz_close(stm);
+			stm = NULL;
+		}
+		fz_catch(ctx)
+		{
+			fz_warn(ctx, "cannot decrypt stream");
+		}
+	}
+	t = now() - t;
+	printf("fz_open_aesd AES-128: %.0f MB/s\n", rounds / t);
+
+	fz_free(ctx, data);
+}
+
+int
+main(int argc, char **argv)
+{
+	int rounds = argc > 1 ? atoi(argv[1]) : 256;
+	fz_context *ctx;
+	unsigned char *buf;
+	int i;
+
+	ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+	if (!ctx)
+	{
+		fprintf(stderr, "cannot initialise context\n");
+		return 1;
+	}
+	buf = fz_malloc(ctx, MB);
+	for (i = 0; i < MB; i++)
+		buf[i] = (unsigned char)(i * 7 + 3);
+
+	printf("decrypting %d MB per measurement\n", rounds);
+	bench_cbc(buf, rounds, 128, 0);
+	bench_cbc(buf, rounds, 128, 1);
+	bench_cbc(buf, rounds, 256, 0);
+	bench_cbc(buf, rounds, 256, 1);
+	bench_filter(ctx, buf, rounds);
+
+	fz_free(ctx, buf);
+	fz_free_context(ctx);
+	return 0;
+}
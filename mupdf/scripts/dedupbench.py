@@ -0,0 +1,48 @@
+#!/usr/bin/python
+#
+# Generates a PDF with many objects, a large share of which are duplicates
+# (font descriptors, annotation appearance dicts, identical and nearly
+# identical streams), for timing the duplicate object removal of
+# mutool clean -ggg (dictionaries) and -gggg (streams as well):
+#
+#	python dedupbench.py dedupbench.pdf 2000
+#	mutool clean -gggg dedupbench.pdf out.pdf
+#
+# Arguments: [output file] [page count] [mutool]
+# With a mutool binary, the file is cleaned with both -ggg and -gggg into
+# <output file>.clean.pdf and both garbage collection levels are timed.
+
+import sys
+from pdfgen import add, write, run
+
+pagecount = len(sys.argv) > 2 and int(sys.argv[2]) or 1000
+
+kids = []
+for i in range(pagecount):
+	# identical on every page
+	descriptor = add("<< /Type /FontDescriptor /FontName /Helvetica /Flags 32 /FontBBox [-166 -225 1000 931] "
+		"/ItalicAngle 0 /Ascent 718 /Descent -207 /CapHeight 718 /StemV 88 >>")
+	font = add("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /FontDescriptor %s >>" % descriptor)
+	# one of a few variants
+	gstate = add("<< /Type /ExtGState /CA %.1f /ca %.1f >>" % (i % 5 / 5.0, i % 5 / 5.0))
+	logo = add("<< /Type /XObject /Subtype /Form /BBox [0 0 100 100] >>",
+		bytearray(b"0 0 1 rg 10 10 80 80 re f"))
+	# same dictionary and length, different contents
+	stamp = add("<< /Type /XObject /Subtype /Form /BBox [0 0 100 100] >>",
+		bytearray(("%05d 0 0 rg 0 0 m 100 100 l S" % (i * 7 % 100000)).encode("latin-1")))
+	annots = []
+	for j in range(5):
+		ap = add("<< /Type /XObject /Subtype /Form /BBox [0 0 20 20] >>", bytearray(b"1 1 0 rg 0 0 20 20 re f"))
+		annots.append(add("<< /Type /Annot /Subtype /Square /Rect [%d 700 %d 720] /AP << /N %s >> >>" % (j * 30, j * 30 + 20, ap)))
+	content = add("<< >>", bytearray(("BT /F1 12 Tf 72 720 Td (Page %d) Tj ET /GS0 gs /Im0 Do /Im1 Do\n" % (i + 1)).encode("latin-1")))
+	kids.append(add("<< /Type /Page /Parent 1 0 R /MediaBox [0 0 612 792] /Contents %s /Annots [%s] "
+		"/Resources << /Font << /F1 %s >> /ExtGState << /GS0 %s >> /XObject << /Im0 %s /Im1 %s >> >> >>" %
+		(content, " ".join(annots), font, gstate, logo, stamp)))
+
+filename = len(sys.argv) > 1 and sys.argv[1] or "dedupbench.pdf"
+objcount = write(filename, kids)
+sys.stderr.write("%s: %d pages, %d objects\n" % (filename, pagecount, objcount))
+
+if len(sys.argv) > 3:
+	for garbage in ("-ggg", "-gggg"):
+		run([sys.argv[3], "clean", garbage, filename, filename + ".clean.pdf"])
@@ -0,0 +1,57 @@
+#!/usr/bin/python
+#
+# Generates a PDF with pages full of invocations of two small Form XObjects
+# (a logo with its own colors and a symbol inheriting the caller's fill
+# color) for timing the display list cache for repeatedly used forms:
+#
+#	python formbench.py formbench.pdf 10 800
+#	mudraw -m formbench.pdf
+#
+# Arguments: [output file] [page count] [form invocations per page] [mudraw]
+# If a mudraw binary is given, the file is rendered with -m after writing.
+
+import sys, math, zlib
+from pdfgen import add, write, run
+
+def flate(obj, data):
+	return add(obj[:-2] + " /Filter /FlateDecode >>", bytearray(zlib.compress(data.encode("latin-1"))))
+
+pagecount = len(sys.argv) > 2 and int(sys.argv[2]) or 10
+perpage = len(sys.argv) > 3 and int(sys.argv[3]) or 800
+
+logo = []
+for i in range(40):
+	logo.append("%.2f %.2f %.2f rg %d %d m %d %d l %d %d l h f" % (i / 40.0, 0.3, 1 - i / 40.0, i, 0, 40, i, 40 - i, 40))
+logo.append("0 0 0 RG 0.5 w 0 0 40 40 re S")
+logo.append("BT /F1 6 Tf 2 2 Td (Logo) Tj ET")
+font = add("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>")
+logo = flate("<< /Type /XObject /Subtype /Form /BBox [0 0 40 40] /Resources << /Font << /F1 %s >> >> >>" % font, "\n".join(logo))
+
+symbol = []
+for k in range(16):
+	a = k * math.pi / 8
+	symbol.append("%.3f %.3f %s" % (5 + 5 * math.cos(a), 5 + 5 * math.sin(a), k == 0 and "m" or "l"))
+symbol.append("h f 0 0 m 10 10 l S")
+symbol = flate("<< /Type /XObject /Subtype /Form /BBox [0 0 10 10] >>", "\n".join(symbol))
+
+# the symbol is drawn in three colors, i.e. three cached variants
+colors = ["1 0 0 rg", "0 0 1 rg", "0 0.5 0 rg"]
+
+kids = []
+for p in range(pagecount):
+	content = []
+	for i in range(perpage):
+		x, y = 20 + (i % 25) * 22, 20 + (i // 25) * 22 % 740
+		if i % 2:
+			content.append("q 0.5 0 0 0.5 %d %d cm /Fm1 Do Q" % (x, y))
+		else:
+			content.append("q %s 1 w 1 0 0 1 %d %d cm /Fm2 Do Q" % (colors[i // 2 % 3], x, y))
+	contents = flate("<< >>", "\n".join(content))
+	kids.append(add("<< /Type /Page /Parent 1 0 R /MediaBox [0 0 595 842] "
+		"/Resources << /XObject << /Fm1 %s /Fm2 %s >> >> /Contents %s >>" % (logo, symbol, contents)))
+
+filename = len(sys.argv) > 1 and sys.argv[1] or "formbench.pdf"
+write(filename, kids)
+
+if len(sys.argv) > 4:
+	run([sys.argv[4], "-m", filename])
@@ -0,0 +1,49 @@
+#!/usr/bin/python
+#
+# Compares output size and write time of mutool clean with and without
+# object streams (-o) for a corpus of PDF files:
+#
+#	python objstmbench.py mutool [-ggg] file1.pdf file2.pdf ...
+#
+# Options (the same as for mutool clean) are passed on to mutool clean.
+
+import os, sys, time, getopt, tempfile, subprocess
+
+def clean(mutool, args, infile, outfile):
+	start = time.time()
+	subprocess.call([mutool, "clean"] + args + [infile, outfile], stderr=open(os.devnull, "w"))
+	return time.time() - start, os.path.getsize(outfile)
+
+def usage():
+	sys.stderr.write("usage: %s mutool [options] file1.pdf [file2.pdf ...]\n" % os.path.basename(sys.argv[0]))
+	sys.exit(1)
+
+if len(sys.argv) < 3:
+	usage()
+
+mutool = sys.argv[1]
+# same option string as pdfclean, so that e.g. the password of -p isn't taken for a file
+try:
+	opts, files = getopt.getopt(sys.argv[2:], "adfgilop:s")
+except getopt.GetoptError:
+	usage()
+if not files:
+	usage()
+args = []
+for opt, value in opts:
+	args += [opt, value] if opt == "-p" else [opt]
+outfile = os.path.join(tempfile.gettempdir(), "objstmbench.pdf")
+
+totals = [0, 0, 0, 0, 0]
+print("File\tInput\tClassic\tTime\tObjStm\tTime")
+for infile in files:
+	size = os.path.getsize(infile)
+	time1, size1 = clean(mutool, args, infile, outfile)
+	time2, size2 = clean(mutool, args + ["-o"], infile, outfile)
+	print("%s\t%d\t%d\t%.2fs\t%d (%+.1f%%)\t%.2fs" % (os.path.basename(infile), size, size1, time1, size2, (size2 - size1) * 100.0 / size1, time2))
+	for i, value in enumerate((size, size1, time1, size2, time2)):
+		totals[i] += value
+if os.path.exists(outfile):
+	os.remove(outfile)
+
+print("Total\t%d\t%d\t%.2fs\t%d (%+.1f%%)\t%.2fs" % (totals[0], totals[1], totals[2], totals[3], (totals[3] - totals[1]) * 100.0 / max(totals[1], 1), totals[4]))
@@ -0,0 +1,51 @@
+# pdfgen.py -- Minimal PDF writer shared by the benchmark file generators
+#
+#	from pdfgen import add, write
+#	font = add("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>")
+#	contents = add("<< >>", bytearray(b"BT /F1 12 Tf (Hello) Tj ET"))
+#	kids = [add("<< /Type /Page /Parent 1 0 R ... /Contents %s >>" % contents)]
+#	write("out.pdf", kids)
+#	run(["mudraw", "-m", "out.pdf"])
+#
+# Pages must refer to "1 0 R" as their parent.
+
+import sys, time, subprocess
+
+# object 1 is the page tree, written once all pages are known
+objects = [None]
+
+def add(obj, stream=None):
+	"""Adds a dictionary (and its stream data) and returns a reference to it."""
+	if stream is not None:
+		obj = obj[:-2] + " /Length %d >>" % len(stream)
+		data = (obj + "\nstream\n").encode("latin-1") + bytes(stream) + b"\nendstream"
+	else:
+		data = obj.encode("latin-1")
+	objects.append(data)
+	return "%d 0 R" % len(objects)
+
+def write(filename, kids):
+	"""Writes all objects with a page tree for the given pages and returns the object count."""
+	objects[0] = ("<< /Type /Pages /Kids [%s] /Count %d >>" % (" ".join(kids), len(kids))).encode("latin-1")
+	objects.append(b"<< /Type /Catalog /Pages 1 0 R >>")
+
+	pdf = bytearray(b"%PDF-1.5\n")
+	offsets = []
+	for i, obj in enumerate(objects):
+		offsets.append(len(pdf))
+		pdf += ("%d 0 obj\n" % (i + 1)).encode("latin-1") + obj + b"\nendobj\n"
+	startxref = len(pdf)
+	pdf += ("xref\n0 %d\n0000000000 65535 f \n" % (len(objects) + 1)).encode("latin-1")
+	for ofs in offsets:
+		pdf += ("%010d 00000 n \n" % ofs).encode("latin-1")
+	pdf += ("trailer\n<< /Size %d /Root %d 0 R >>\nstartxref\n%d\n%%%%EOF\n" %
+		(len(objects) + 1, len(objects), startxref)).encode("latin-1")
+
+	open(filename, "wb").write(pdf)
+	return len(objects)
+
+def run(args):
+	"""Runs a tool on a generated file and reports the wall clock time it took."""
+	start = time.time()
+	subprocess.call(args)
+	sys.stderr.write("%s: %.2fs\n" % (" ".join(args), time.time() - start))
@@ -0,0 +1,122 @@
+#!/usr/bin/python
+#
+# Generates a PDF with shading-heavy pages for timing function evaluation
+# (PostScript calculator and sampled functions used as shading functions
+# and as tint transforms of Separation and DeviceN colorspaces):
+#
+#	python shadebench.py shadebench.pdf
+#	mudraw -m -r 150 shadebench.pdf
+#
+# Arguments: [output file] [mudraw]
+# The page content is fixed; a mudraw binary given after the file name
+# renders all five pages at 150 dpi with -m.
+
+import sys
+from pdfgen import add, write, run
+
+# 3 colorants -> CMYK
+DEVICEN_TINT_PS = "2 index 0.9 mul 1 index 0.1 mul add 2 index 0.8 mul 2 index " \
+	"5 index 5 index gt { 5 index } { 4 index } ifelse 0.3 mul 7 -3 roll pop pop pop"
+# 1 colorant -> CMYK
+SEPARATION_TINT_PS = "dup 0.2 mul exch dup 0.7 mul exch dup 0.1 mul exch " \
+	"dup 0.5 gt { 0.5 sub } { pop 0 } ifelse"
+AXIAL_PS = "dup mul 360 mul sin abs"
+FUNCTION_BASED_PS = "2 copy mul 3 1 roll 2 copy add 2 div 3 1 roll " \
+	"360 mul sin abs exch 360 mul cos abs mul"
+
+def calculator(inputs, outputs, code):
+	code = ("{ " + code + " }").encode("latin-1")
+	return add("<< /FunctionType 4 /Domain [%s] /Range [%s] >>" %
+		(" ".join(["0 1"] * inputs), " ".join(["0 1"] * outputs)), bytearray(code))
+
+def sampled(inputs, outputs, size):
+	data = bytearray()
+	count = outputs
+	for i in range(inputs):
+		count *= size
+	for i in range(count):
+		data.append((i * 7919 + (i >> 3) * 104729) % 256)
+	return add("<< /FunctionType 0 /Domain [%s] /Range [%s] /Size [%s] /BitsPerSample 8 >>" %
+		(" ".join(["0 1"] * inputs), " ".join(["0 1"] * outputs), " ".join([str(size)] * inputs)), data)
+
+separation = "[/Separation /Spot1 /DeviceCMYK %s]" % calculator(1, 4, SEPARATION_TINT_PS)
+devicen = "[/DeviceN [/Cyan2 /Orange /Green2] /DeviceCMYK %s]" % calculator(3, 4, DEVICEN_TINT_PS)
+devicen_sampled = "[/DeviceN [/Cyan3 /Orange3 /Green3] /DeviceCMYK %s]" % sampled(3, 4, 9)
+
+def page(content, shadings={}, xobjects={}):
+	res = "<< /ColorSpace << /CS0 %s >>" % separation
+	if shadings:
+		res += " /Shading << %s >>" % " ".join(["/%s %s" % kv for kv in sorted(shadings.items())])
+	if xobjects:
+		res += " /XObject << %s >>" % " ".join(["/%s %s" % kv for kv in sorted(xobjects.items())])
+	res += " >>"
+	contents = add("<< >>", bytearray(content.encode("latin-1")))
+	return "<< /Type /Page /Parent 1 0 R /MediaBox [0 0 600 800] /Resources %s /Contents %s >>" % (res, contents)
+
+def image(colorspace, size, seed):
+	data = bytearray()
+	for y in range(size):
+		for x in range(size):
+			data.append(x * 255 // (size - 1))
+			data.append(y * 255 // (size - 1))
+			data.append((x * y + seed * (x ^ y)) % 256)
+	return add("<< /Type /XObject /Subtype /Image /Width %d /Height %d /ColorSpace %s /BitsPerComponent 8 >>" %
+		(size, size, colorspace), data)
+
+def mesh(colorspace, count):
+	data = bytearray()
+	for i in range(count):
+		cx, cy = (i % 40) * 1600 + 800, (i // 40) * 1300 + 800
+		for dx, dy in ((-900, -700), (900, -700), (0, 800)):
+			data.append(0)
+			for v in (cx + dx, cy + dy):
+				v = max(0, min(65535, v))
+				data.extend(((v >> 8) & 255, v & 255))
+			data.extend(((i * 37 + dx) % 256, (i * 11 + dy) % 256, (i * 5) % 256))
+	return add("<< /ShadingType 4 /ColorSpace %s /BitsPerCoordinate 16 /BitsPerComponent 8 "
+		"/BitsPerFlag 8 /Decode [0 600 0 800 0 1 0 1 0 1] >>" % colorspace, data)
+
+pages = []
+
+# axial shadings in a Separation colorspace
+shadings, content = {}, ""
+for i in range(40):
+	fn = calculator(1, 1, AXIAL_PS + " %d mul dup 1 gt { pop 1 } if" % (i % 3 + 1))
+	shadings["Sh%d" % i] = add("<< /ShadingType 2 /ColorSpace %s /Coords [%d 0 %d 800] /Function %s /Extend [true true] >>" %
+		(separation, i * 15, 600 - i * 15, fn))
+	content += "q %d %d 150 150 re W n /Sh%d sh Q\n" % (i % 4 * 150, i // 4 * 80, i)
+pages.append(page(content, shadings))
+
+# function-based shadings in a DeviceN colorspace
+shadings, content = {}, ""
+for i in range(20):
+	shadings["Sh%d" % i] = add("<< /ShadingType 1 /ColorSpace %s /Domain [0 1 0 1] /Matrix [150 0 0 160 %d %d] /Function %s >>" %
+		(devicen, i % 4 * 150, i // 4 * 160, calculator(2, 3, FUNCTION_BASED_PS + " %d.%d mul" % (i % 2, i))))
+	content += "/Sh%d sh\n" % i
+pages.append(page(content, shadings))
+
+# radial shadings with sampled functions and separation fills
+shadings, content = {}, ""
+for i in range(20):
+	shadings["Sh%d" % i] = add("<< /ShadingType 3 /ColorSpace /DeviceRGB /Coords [%d %d 0 %d %d 150] /Function %s >>" %
+		(i % 4 * 150 + 75, i // 4 * 160 + 80, i % 4 * 150 + 75, i // 4 * 160 + 80, sampled(1, 3, 64 + i)))
+	content += "/Sh%d sh\n" % i
+for i in range(2000):
+	content += "/CS0 cs %.4f scn %d %d 12 12 re f\n" % (i / 2000.0, i % 50 * 12, i // 50 * 20)
+pages.append(page(content, shadings))
+
+# DeviceN images with calculator and sampled tint transforms
+pages.append(page("q 600 0 0 400 0 400 cm /Im0 Do Q q 600 0 0 400 0 0 cm /Im1 Do Q\n",
+	xobjects={"Im0": image(devicen, 256, 3), "Im1": image(devicen_sampled, 256, 5)}))
+
+# free-form triangle mesh in a DeviceN colorspace
+pages.append(page("/Sh0 sh\n", shadings={"Sh0": mesh(devicen, 1200)}))
+
+kids = []
+for p in pages:
+	kids.append(add(p))
+filename = len(sys.argv) > 1 and sys.argv[1] or "shadebench.pdf"
+write(filename, kids)
+
+if len(sys.argv) > 2:
+	run([sys.argv[2], "-m", "-r", "150", filename])
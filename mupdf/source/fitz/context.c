@@ -186,6 +186,9 @@ fz_clone_context_internal(fz_context *ctx)
 	/* Inherit AA defaults from old context. */
 	fz_copy_aa_context(new_ctx, ctx);
 
+	/* SumatraPDF: inherit the tracing hook */
+	new_ctx->trace = ctx->trace;
+
 	/* Keep thread lock checking happy by copying pointers first and locking under new context */
 	new_ctx->store = ctx->store;
 	new_ctx->store = fz_keep_store_context(new_ctx);
@@ -40,6 +40,19 @@
 
 #define aes_context fz_aes
 
+/* SumatraPDF: use AES-NI instructions where the CPU supports them */
+#if (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)) && !defined(FZ_NO_AESNI)
+#define HAVE_AESNI
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AESNI_TARGET
+#else
+#include <cpuid.h>
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif
+#endif
+
 /* AES block cipher implementation from XYSSL */
 
 /*
@@ -173,6 +186,198 @@ static void aes_gen_tables( void )
 	}
 }
 
+#ifdef HAVE_AESNI
+
+AESNI_TARGET static void
+aesni_crypt_block( aes_context *ctx, int mode, const unsigned char input[16], unsigned char output[16] )
+{
+	__m128i x = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)input ), _mm_loadu_si128( (const __m128i *)ctx->hw_rk[0] ) );
+	int r;
+
+	if( mode == AES_DECRYPT )
+	{
+		for( r = 1; r < ctx->nr; r++ )
+			x = _mm_aesdec_si128( x, _mm_loadu_si128( (const __m128i *)ctx->hw_rk[r] ) );
+		x = _mm_aesdeclast_si128( x, _mm_loadu_si128( (const __m128i *)ctx->hw_rk[r] ) );
+	}
+	else
+	{
+		for( r = 1; r < ctx->nr; r++ )
+			x = _mm_aesenc_si128( x, _mm_loadu_si128( (const __m128i *)ctx->hw_rk[r] ) );
+		x = _mm_aesenclast_si128( x, _mm_loadu_si128( (const __m128i *)ctx->hw_rk[r] ) );
+	}
+	_mm_storeu_si128( (__m128i *)output, x );
+}
+
+/*
+ * CBC decryption doesn't depend on the previous block's output, so four
+ * blocks are decrypted at once to hide the latency of the instructions.
+ */
+AESNI_TARGET static void
+aesni_crypt_cbc( aes_context *ctx, int mode, int length, unsigned char iv[16], const unsigned char *input, unsigned char *output )
+{
+	__m128i rk[15];
+	__m128i prev = _mm_loadu_si128( (const __m128i *)iv );
+	int nr = ctx->nr, r;
+
+	for( r = 0; r <= nr; r++ )
+		rk[r] = _mm_loadu_si128( (const __m128i *)ctx->hw_rk[r] );
+
+	if( mode == AES_DECRYPT )
+	{
+		while( length >= 64 )
+		{
+			__m128i c0 = _mm_loadu_si128( (const __m128i *)input );
+			__m128i c1 = _mm_loadu_si128( (const __m128i *)( input + 16 ) );
+			__m128i c2 = _mm_loadu_si128( (const __m128i *)( input + 32 ) );
+			__m128i c3 = _mm_loadu_si128( (const __m128i *)( input + 48 ) );
+			__m128i x0 = _mm_xor_si128( c0, rk[0] );
+			__m128i x1 = _mm_xor_si128( c1, rk[0] );
+			__m128i x2 = _mm_xor_si128( c2, rk[0] );
+			__m128i x3 = _mm_xor_si128( c3, rk[0] );
+
+			for( r = 1; r < nr; r++ )
+			{
+				x0 = _mm_aesdec_si128( x0, rk[r] );
+				x1 = _mm_aesdec_si128( x1, rk[r] );
+				x2 = _mm_aesdec_si128( x2, rk[r] );
+				x3 = _mm_aesdec_si128( x3, rk[r] );
+			}
+			x0 = _mm_aesdeclast_si128( x0, rk[nr] );
+			x1 = _mm_aesdeclast_si128( x1, rk[nr] );
+			x2 = _mm_aesdeclast_si128( x2, rk[nr] );
+			x3 = _mm_aesdeclast_si128( x3, rk[nr] );
+
+			_mm_storeu_si128( (__m128i *)output, _mm_xor_si128( x0, prev ) );
+			_mm_storeu_si128( (__m128i *)( output + 16 ), _mm_xor_si128( x1, c0 ) );
+			_mm_storeu_si128( (__m128i *)( output + 32 ), _mm_xor_si128( x2, c1 ) );
+			_mm_storeu_si128( (__m128i *)( output + 48 ), _mm_xor_si128( x3, c2 ) );
+			prev = c3;
+
+			input += 64;
+			output += 64;
+			length -= 64;
+		}
+		while( length > 0 )
+		{
+			__m128i c = _mm_loadu_si128( (const __m128i *)input );
+			__m128i x = _mm_xor_si128( c, rk[0] );
+
+			for( r = 1; r < nr; r++ )
+				x = _mm_aesdec_si128( x, rk[r] );
+			x = _mm_aesdeclast_si128( x, rk[nr] );
+
+			_mm_storeu_si128( (__m128i *)output, _mm_xor_si128( x, prev ) );
+			prev = c;
+
+			input += 16;
+			output += 16;
+			length -= 16;
+		}
+	}
+	else
+	{
+		while( length > 0 )
+		{
+			__m128i x = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)input ), prev );
+
+			x = _mm_xor_si128( x, rk[0] );
+			for( r = 1; r < nr; r++ )
+				x = _mm_aesenc_si128( x, rk[r] );
+			prev = _mm_aesenclast_si128( x, rk[nr] );
+
+			_mm_storeu_si128( (__m128i *)output, prev );
+
+			input += 16;
+			output += 16;
+			length -= 16;
+		}
+	}
+
+	_mm_storeu_si128( (__m128i *)iv, prev );
+}
+
+static int aesni_supported( void )
+{
+	unsigned int ecx;
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid( info, 1 );
+	ecx = (unsigned int)info[2];
+#else
+	unsigned int eax, ebx, edx;
+	if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+		return 0;
+#endif
+	/* bit 25: AES-NI, bit 19: SSE4.1 (implies SSE2) */
+	return ( ecx & ( 1 << 25 ) ) && ( ecx & ( 1 << 19 ) );
+}
+
+#endif
+
+/* -1: not checked yet, 0: software only, 1: AES instructions */
+static int aes_hw_state = -1;
+
+static void aes_set_hw_keys( aes_context *ctx )
+{
+	int i;
+
+	for( i = 0; i < ( ctx->nr + 1 ) * 4; i++ )
+		PUT_ULONG_LE( ctx->rk[i], ctx->hw_rk[i >> 2], ( i & 3 ) << 2 );
+	ctx->hw = 1;
+}
+
+/*
+ * Only use the AES instructions if they produce the results of the
+ * FIPS-197 (appendix C) examples for all key sizes
+ */
+static int aes_hw_self_test( void )
+{
+#ifdef HAVE_AESNI
+	static const unsigned char expected[3][16] =
+	{
+		{ 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a },
+		{ 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 },
+		{ 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 },
+	};
+	unsigned char key[32], plain[16], block[16];
+	aes_context aes;
+	int i;
+
+	if( !aesni_supported() )
+		return 0;
+
+	for( i = 0; i < 32; i++ )
+		key[i] = (unsigned char)i;
+	for( i = 0; i < 16; i++ )
+		plain[i] = (unsigned char)( i * 0x11 );
+
+	for( i = 0; i < 3; i++ )
+	{
+		aes_setkey_enc( &aes, key, 128 + 64 * i );
+		aes_set_hw_keys( &aes );
+		aesni_crypt_block( &aes, AES_ENCRYPT, plain, block );
+		if( memcmp( block, expected[i], 16 ) )
+			return 0;
+		aes_setkey_dec( &aes, key, 128 + 64 * i );
+		aes_set_hw_keys( &aes );
+		aesni_crypt_block( &aes, AES_DECRYPT, expected[i], block );
+		if( memcmp( block, plain, 16 ) )
+			return 0;
+	}
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+static void aes_init_hw( void )
+{
+	/* use the software implementation while testing */
+	aes_hw_state = 0;
+	aes_hw_state = aes_hw_self_test();
+}
+
 /*
  * AES key schedule (encryption)
  */
@@ -188,6 +393,8 @@ int aes_setkey_enc( aes_context *ctx, const unsigned char *key, int keysize )
 		aes_init_done = 1;
 	}
 #endif
+	if( aes_hw_state < 0 )
+		aes_init_hw();
 
 	switch( keysize )
 	{
@@ -274,6 +481,10 @@ int aes_setkey_enc( aes_context *ctx, const unsigned char *key, int keysize )
 
 		break;
 	}
+
+	ctx->hw = 0;
+	if( aes_hw_state > 0 )
+		aes_set_hw_keys( ctx );
 	return 0;
 }
 
@@ -328,6 +539,10 @@ int aes_setkey_dec(aes_context *ctx, const unsigned char *key, int keysize)
 	*RK = *SK;
 
 	memset( &cty, 0, sizeof( aes_context ) );
+
+	ctx->hw = 0;
+	if( aes_hw_state > 0 )
+		aes_set_hw_keys( ctx );
 	return 0;
 }
 
@@ -491,6 +706,14 @@ void aes_crypt_cbc( aes_context *ctx,
 	}
 #endif
 
+#ifdef HAVE_AESNI
+	if( ctx->hw )
+	{
+		aesni_crypt_cbc( ctx, mode, length, iv, input, output );
+		return;
+	}
+#endif
+
 	if( mode == AES_DECRYPT )
 	{
 		while( length > 0 )
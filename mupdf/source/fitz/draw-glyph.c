@@ -34,6 +34,9 @@ struct fz_glyph_cache_s
 {
 	int refs;
 	int total;
+	/* SumatraPDF: count lookups for benchmarking */
+	int hits;
+	int misses;
 #ifndef NDEBUG
 	int num_evictions;
 	int evicted;
@@ -296,11 +299,13 @@ fz_render_glyph(fz_context *ctx, fz_font *font, int gid, fz_matrix *ctm, fz_colo
 		{
 			move_to_front(cache, entry);
 			val = fz_keep_glyph(ctx, entry->val);
+			cache->hits++;
 			fz_unlock(ctx, FZ_LOCK_GLYPHCACHE);
 			return val;
 		}
 		entry = entry->bucket_next;
 	}
+	cache->misses++;
 
 	locked = 1;
 	caching = 0;
@@ -449,6 +454,26 @@ fz_render_glyph_pixmap(fz_context *ctx, fz_font *font, int gid, fz_matrix *ctm,
 	return val;
 }
 
+/* SumatraPDF: allow benchmarks to report the glyph cache's usage */
+void
+fz_get_glyph_cache_stats(fz_context *ctx, fz_glyph_cache_stats *stats)
+{
+	fz_glyph_cache *cache = ctx->glyph_cache;
+	fz_glyph_cache_entry *entry;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!cache)
+		return;
+
+	fz_lock(ctx, FZ_LOCK_GLYPHCACHE);
+	stats->size = cache->total;
+	for (entry = cache->lru_head; entry; entry = entry->lru_next)
+		stats->entries++;
+	stats->hits = cache->hits;
+	stats->misses = cache->misses;
+	fz_unlock(ctx, FZ_LOCK_GLYPHCACHE);
+}
+
 void
 fz_dump_glyph_cache_stats(fz_context *ctx)
 {
@@ -1,6 +1,10 @@
 #include "mupdf/fitz.h"
 #include "draw-imp.h"
 
+#if defined(_WIN32) && !defined(_WINRT)
+#include <windows.h>
+#endif
+
 enum { MAXN = 2 + FZ_MAX_COLORS };
 
 static void paint_scan(fz_pixmap *restrict pix, int y, int fx0, int fx1, int cx0, int cx1, const int *restrict v0, const int *restrict v1, int n)
@@ -92,8 +96,11 @@ static inline void step_edge(edge_data *edge, int n)
 	}
 }
 
+/* SumatraPDF: only rows band_y0 to band_y1 are painted so that a shading
+   can be painted in several strips. The edges are still stepped from the
+   top of bbox so that every strip produces the very same pixels. */
 static void
-fz_paint_triangle(fz_pixmap *pix, float *v[3], int n, const fz_irect *bbox)
+fz_paint_triangle(fz_pixmap *pix, float *v[3], int n, const fz_irect *bbox, int band_y0, int band_y1)
 {
 	edge_data e0, e1;
 	int top, mid, bot;
@@ -109,6 +116,8 @@ fz_paint_triangle(fz_pixmap *pix, float *v[3], int n, const fz_irect *bbox)
 	/* Test if the triangle is completely outside the scissor rect */
 	if (v[bot][1] < bbox->y0) return;
 	if (v[top][1] > bbox->y1) return;
+	if (v[bot][1] < band_y0) return;
+	if (v[top][1] > band_y1) return;
 
 	/* Magic! Ensure that mid/top/bot are all different */
 	mid = 3^top^bot;
@@ -129,7 +138,10 @@ fz_paint_triangle(fz_pixmap *pix, float *v[3], int n, const fz_irect *bbox)
 
 		do
 		{
-			paint_scan(pix, y, (int)e0.x, (int)e1.x, minx, maxx, &e0.v[0], &e1.v[0], n);
+			if (y >= band_y1)
+				return;
+			if (y >= band_y0)
+				paint_scan(pix, y, (int)e0.x, (int)e1.x, minx, maxx, &e0.v[0], &e1.v[0], n);
 			step_edge(&e0, n);
 			step_edge(&e1, n);
 			y ++;
@@ -144,7 +156,10 @@ fz_paint_triangle(fz_pixmap *pix, float *v[3], int n, const fz_irect *bbox)
 
 		do
 		{
-			paint_scan(pix, y, (int)e0.x, (int)e1.x, minx, maxx, &e0.v[0], &e1.v[0], n);
+			if (y >= band_y1)
+				break;
+			if (y >= band_y0)
+				paint_scan(pix, y, (int)e0.x, (int)e1.x, minx, maxx, &e0.v[0], &e1.v[0], n);
 			y ++;
 			if (y >= y1)
 				break;
@@ -162,8 +177,305 @@ struct paint_tri_data
 	fz_pixmap *dest;
 	const fz_irect *bbox;
 	fz_color_converter cc;
+	/* SumatraPDF: triangles collected for painting in strips */
+	int strips;
+	float *tris;
+	int tri_count;
+	int tri_cap;
+	/* SumatraPDF: color lookup for shadings with functions */
+	fz_pixmap *conv;
+	unsigned char (*clut)[FZ_MAX_COLORS];
+};
+
+/* SumatraPDF: cache color lookup tables of shadings with functions */
+
+typedef struct fz_shade_clut_s fz_shade_clut;
+
+struct fz_shade_clut_s
+{
+	fz_storable storable;
+	unsigned char clut[256][FZ_MAX_COLORS];
+};
+
+typedef struct fz_shade_clut_key_s fz_shade_clut_key;
+
+struct fz_shade_clut_key_s
+{
+	int refs;
+	fz_shade *shade;
+	fz_colorspace *colorspace;
 };
 
+static void
+fz_free_shade_clut_imp(fz_context *ctx, fz_storable *clut)
+{
+	fz_free(ctx, clut);
+}
+
+static int
+fz_make_hash_shade_clut_key(fz_store_hash *hash, void *key_)
+{
+	fz_shade_clut_key *key = (fz_shade_clut_key *)key_;
+
+	hash->u.pp.ptr0 = key->shade;
+	hash->u.pp.ptr1 = key->colorspace;
+	return 1;
+}
+
+static void *
+fz_keep_shade_clut_key(fz_context *ctx, void *key_)
+{
+	fz_shade_clut_key *key = (fz_shade_clut_key *)key_;
+
+	fz_lock(ctx, FZ_LOCK_ALLOC);
+	key->refs++;
+	fz_unlock(ctx, FZ_LOCK_ALLOC);
+
+	return (void *)key;
+}
+
+static void
+fz_drop_shade_clut_key(fz_context *ctx, void *key_)
+{
+	fz_shade_clut_key *key = (fz_shade_clut_key *)key_;
+	int drop;
+
+	if (key == NULL)
+		return;
+	fz_lock(ctx, FZ_LOCK_ALLOC);
+	drop = --key->refs;
+	fz_unlock(ctx, FZ_LOCK_ALLOC);
+	if (drop == 0)
+	{
+		fz_drop_shade(ctx, key->shade);
+		fz_drop_colorspace(ctx, key->colorspace);
+		fz_free(ctx, key);
+	}
+}
+
+static int
+fz_cmp_shade_clut_key(void *k0_, void *k1_)
+{
+	fz_shade_clut_key *k0 = (fz_shade_clut_key *)k0_;
+	fz_shade_clut_key *k1 = (fz_shade_clut_key *)k1_;
+
+	return k0->shade == k1->shade && k0->colorspace == k1->colorspace;
+}
+
+#ifndef NDEBUG
+static void
+fz_debug_shade_clut(FILE *out, void *key_)
+{
+	fz_shade_clut_key *key = (fz_shade_clut_key *)key_;
+
+	fprintf(out, "(shade clut type=%d cs=%s) ", key->shade->type, key->colorspace->name);
+}
+#endif
+
+static fz_store_type fz_shade_clut_store_type =
+{
+	fz_make_hash_shade_clut_key,
+	fz_keep_shade_clut_key,
+	fz_drop_shade_clut_key,
+	fz_cmp_shade_clut_key,
+#ifndef NDEBUG
+	fz_debug_shade_clut
+#endif
+};
+
+static fz_shade_clut *
+fz_load_shade_clut(fz_context *ctx, fz_shade *shade, fz_colorspace *colorspace)
+{
+	fz_shade_clut_key key, *keyp = NULL;
+	fz_shade_clut *clut, *existing;
+	fz_color_converter cc;
+	float color[FZ_MAX_COLORS];
+	int i, k;
+
+	key.refs = 1;
+	key.shade = shade;
+	key.colorspace = colorspace;
+	clut = fz_find_item(ctx, fz_free_shade_clut_imp, &key, &fz_shade_clut_store_type);
+	if (clut)
+		return clut;
+
+	clut = fz_malloc_struct(ctx, fz_shade_clut);
+	FZ_INIT_STORABLE(clut, 1, fz_free_shade_clut_imp);
+
+	fz_lookup_color_converter(&cc, ctx, colorspace, shade->colorspace);
+	for (i = 0; i < 256; i++)
+	{
+		cc.convert(&cc, color, shade->function[i]);
+		for (k = 0; k < colorspace->n; k++)
+			clut->clut[i][k] = color[k] * 255;
+		clut->clut[i][k] = shade->function[i][shade->colorspace->n] * 255;
+	}
+
+	fz_var(keyp);
+
+	fz_try(ctx)
+	{
+		keyp = fz_malloc_struct(ctx, fz_shade_clut_key);
+		keyp->refs = 1;
+		keyp->shade = fz_keep_shade(ctx, shade);
+		keyp->colorspace = fz_keep_colorspace(ctx, colorspace);
+		existing = fz_store_item(ctx, keyp, clut, sizeof(fz_shade_clut), &fz_shade_clut_store_type);
+		if (existing)
+		{
+			/* Another thread got there first */
+			fz_drop_storable(ctx, &clut->storable);
+			clut = existing;
+		}
+	}
+	fz_always(ctx)
+	{
+		fz_drop_shade_clut_key(ctx, keyp);
+	}
+	fz_catch(ctx)
+	{
+		/* the table is still usable without having been cached */
+	}
+
+	return clut;
+}
+
+/* SumatraPDF: paint large shadings in parallel strips */
+
+#define MAX_SHADE_STRIPS 4
+#define MIN_SHADE_STRIP_HEIGHT 64
+#define MIN_SHADE_STRIPS_AREA (256 * 256)
+/* flush collected triangles once they'd use more than 4 MB */
+#define MAX_SHADE_STRIP_TRIS ((4 << 20) / (3 * MAXN * (int)sizeof(float)))
+
+typedef struct shade_strip_s shade_strip;
+
+struct shade_strip_s
+{
+	struct paint_tri_data *ptd;
+	int y0;
+	int y1;
+	int convert;
+};
+
+static void
+convert_shade_rows(fz_pixmap *temp, fz_pixmap *conv, unsigned char (*clut)[FZ_MAX_COLORS], int y0, int y1)
+{
+	unsigned char *s = temp->samples + (y0 - temp->y) * temp->w * temp->n;
+	unsigned char *d = conv->samples + (y0 - conv->y) * conv->w * conv->n;
+	int len = temp->w * (y1 - y0);
+	int k;
+
+	while (len--)
+	{
+		int v = *s++;
+		int a = fz_mul255(*s++, clut[v][conv->n - 1]);
+		for (k = 0; k < conv->n - 1; k++)
+			*d++ = fz_mul255(clut[v][k], a);
+		*d++ = a;
+	}
+}
+
+static void
+paint_shade_strip(shade_strip *strip)
+{
+	struct paint_tri_data *ptd = strip->ptd;
+	fz_pixmap *dest = ptd->dest;
+	int n = 2 + dest->colorspace->n;
+	float *tri = ptd->tris;
+	float *vertices[3];
+	int i;
+
+	for (i = 0; i < ptd->tri_count; i++, tri += 3 * n)
+	{
+		vertices[0] = tri;
+		vertices[1] = tri + n;
+		vertices[2] = tri + 2 * n;
+		fz_paint_triangle(dest, vertices, n, ptd->bbox, strip->y0, strip->y1);
+	}
+
+	if (strip->convert)
+		convert_shade_rows(dest, ptd->conv, ptd->clut, strip->y0, strip->y1);
+}
+
+#if defined(_WIN32) && !defined(_WINRT)
+
+static DWORD WINAPI
+shade_strip_thread(LPVOID arg)
+{
+	paint_shade_strip((shade_strip *)arg);
+	return 0;
+}
+
+static int
+fz_shade_strip_threads(void)
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors;
+}
+
+static void
+run_shade_strips(shade_strip *strips, int count)
+{
+	HANDLE threads[MAX_SHADE_STRIPS];
+	int i;
+
+	for (i = 1; i < count; i++)
+	{
+		threads[i] = CreateThread(NULL, 0, shade_strip_thread, &strips[i], 0, NULL);
+		if (!threads[i])
+			paint_shade_strip(&strips[i]);
+	}
+	paint_shade_strip(&strips[0]);
+	for (i = 1; i < count; i++)
+	{
+		if (threads[i])
+		{
+			WaitForSingleObject(threads[i], INFINITE);
+			CloseHandle(threads[i]);
+		}
+	}
+}
+
+#else
+
+static int
+fz_shade_strip_threads(void)
+{
+	return 1;
+}
+
+static void
+run_shade_strips(shade_strip *strips, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		paint_shade_strip(&strips[i]);
+}
+
+#endif
+
+static void
+paint_collected_tris(struct paint_tri_data *ptd, int convert)
+{
+	shade_strip strips[MAX_SHADE_STRIPS];
+	const fz_irect *bbox = ptd->bbox;
+	int i, y = bbox->y0;
+
+	for (i = 0; i < ptd->strips; i++)
+	{
+		strips[i].ptd = ptd;
+		strips[i].y0 = y;
+		y = bbox->y0 + (bbox->y1 - bbox->y0) * (i + 1) / ptd->strips;
+		strips[i].y1 = y;
+		strips[i].convert = convert;
+	}
+
+	run_shade_strips(strips, ptd->strips);
+	ptd->tri_count = 0;
+}
+
 static void
 prepare_vertex(void *arg, fz_vertex *v, const float *input)
 {
@@ -195,22 +507,40 @@ do_paint_tri(void *arg, fz_vertex *av, fz_vertex *bv, fz_vertex *cv)
 	vertices[2] = (float *)cv;
 
 	dest = ptd->dest;
-	fz_paint_triangle(dest, vertices, 2 + dest->colorspace->n, ptd->bbox);
+	if (ptd->strips > 1)
+	{
+		int n = 2 + dest->colorspace->n;
+		if (ptd->tri_count == MAX_SHADE_STRIP_TRIS)
+			paint_collected_tris(ptd, 0);
+		if (ptd->tri_count == ptd->tri_cap)
+		{
+			int cap = fz_maxi(ptd->tri_cap * 2, 256);
+			ptd->tris = fz_resize_array(ptd->ctx, ptd->tris, cap, 3 * n * sizeof(float));
+			ptd->tri_cap = cap;
+		}
+		memcpy(ptd->tris + ptd->tri_count * 3 * n, vertices[0], n * sizeof(float));
+		memcpy(ptd->tris + ptd->tri_count * 3 * n + n, vertices[1], n * sizeof(float));
+		memcpy(ptd->tris + ptd->tri_count * 3 * n + 2 * n, vertices[2], n * sizeof(float));
+		ptd->tri_count++;
+		return;
+	}
+	fz_paint_triangle(dest, vertices, 2 + dest->colorspace->n, ptd->bbox, ptd->bbox->y0, ptd->bbox->y1);
 }
 
 void
 fz_paint_shade(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_pixmap *dest, const fz_irect *bbox)
 {
-	unsigned char clut[256][FZ_MAX_COLORS];
+	fz_shade_clut *clut = NULL;
 	fz_pixmap *temp = NULL;
 	fz_pixmap *conv = NULL;
-	float color[FZ_MAX_COLORS];
 	struct paint_tri_data ptd = { 0 };
-	int i, k;
 	fz_matrix local_ctm;
+	int height = bbox->y1 - bbox->y0;
 
 	fz_var(temp);
 	fz_var(conv);
+	fz_var(clut);
+	fz_var(ptd.tris);
 
 	fz_try(ctx)
 	{
@@ -218,15 +548,7 @@ fz_paint_shade(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_pixmap
 
 		if (shade->use_function)
 		{
-			fz_color_converter cc;
-			fz_lookup_color_converter(&cc, ctx, dest->colorspace, shade->colorspace);
-			for (i = 0; i < 256; i++)
-			{
-				cc.convert(&cc, color, shade->function[i]);
-				for (k = 0; k < dest->colorspace->n; k++)
-					clut[i][k] = color[k] * 255;
-				clut[i][k] = shade->function[i][shade->colorspace->n] * 255;
-			}
+			clut = fz_load_shade_clut(ctx, shade, dest->colorspace);
 			conv = fz_new_pixmap_with_bbox(ctx, dest->colorspace, bbox);
 			temp = fz_new_pixmap_with_bbox(ctx, fz_device_gray(ctx), bbox);
 			fz_clear_pixmap(ctx, temp);
@@ -240,23 +562,23 @@ fz_paint_shade(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_pixmap
 		ptd.dest = temp;
 		ptd.shade = shade;
 		ptd.bbox = bbox;
+		ptd.conv = conv;
+		ptd.clut = clut ? clut->clut : NULL;
+
+		ptd.strips = 1;
+		if (height * (bbox->x1 - bbox->x0) >= MIN_SHADE_STRIPS_AREA)
+			ptd.strips = fz_clampi(fz_mini(fz_shade_strip_threads(), height / MIN_SHADE_STRIP_HEIGHT), 1, MAX_SHADE_STRIPS);
 
 		fz_init_cached_color_converter(ctx, &ptd.cc, temp->colorspace, shade->colorspace);
 		fz_process_mesh(ctx, shade, &local_ctm, &prepare_vertex, &do_paint_tri, &ptd);
 
+		if (ptd.strips > 1)
+			paint_collected_tris(&ptd, shade->use_function);
+		else if (shade->use_function)
+			convert_shade_rows(temp, conv, ptd.clut, bbox->y0, bbox->y1);
+
 		if (shade->use_function)
 		{
-			unsigned char *s = temp->samples;
-			unsigned char *d = conv->samples;
-			int len = temp->w * temp->h;
-			while (len--)
-			{
-				int v = *s++;
-				int a = fz_mul255(*s++, clut[v][conv->n - 1]);
-				for (k = 0; k < conv->n - 1; k++)
-					*d++ = fz_mul255(clut[v][k], a);
-				*d++ = a;
-			}
 			fz_paint_pixmap(dest, conv, 255);
 			fz_drop_pixmap(ctx, conv);
 			fz_drop_pixmap(ctx, temp);
@@ -265,6 +587,9 @@ fz_paint_shade(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_pixmap
 	fz_always(ctx)
 	{
 		fz_fin_cached_color_converter(&ptd.cc);
+		fz_free(ctx, ptd.tris);
+		if (clut)
+			fz_drop_storable(ctx, &clut->storable);
 	}
 	fz_catch(ctx)
 	{
@@ -15,6 +15,7 @@ struct null_filter
 	fz_stream *chain;
 	int remain;
 	int offset;
+	int in_memory;
 	unsigned char buffer[4096];
 };
 
@@ -30,10 +31,16 @@ next_null(fz_stream *stm, int max)
 	n = fz_available(state->chain, max);
 	if (n > state->remain)
 		n = state->remain;
-	if (n > sizeof(state->buffer))
-		n = sizeof(state->buffer);
-	memcpy(state->buffer, state->chain->rp, n);
-	stm->rp = state->buffer;
+	/* SumatraPDF: data from memory (or mapped files) doesn't have to be copied */
+	if (state->in_memory)
+		stm->rp = state->chain->rp;
+	else
+	{
+		if (n > sizeof(state->buffer))
+			n = sizeof(state->buffer);
+		memcpy(state->buffer, state->chain->rp, n);
+		stm->rp = state->buffer;
+	}
 	stm->wp = stm->rp + n;
 	if (n == 0)
 		return EOF;
@@ -74,6 +81,7 @@ fz_open_null(fz_stream *chain, int len, int offset)
 		state->chain = chain;
 		state->remain = len;
 		state->offset = offset;
+		state->in_memory = fz_stream_meta(chain, FZ_STREAM_META_MEMORY, 0, NULL) > 0;
 	}
 	fz_catch(ctx)
 	{
@@ -684,21 +692,31 @@ struct fz_aesd_s
 	fz_aes aes;
 	unsigned char iv[16];
 	int ivcount;
-	unsigned char bp[16];
-	unsigned char *rp, *wp;
-	unsigned char buffer[256];
+	int error;
+	int pad;
+	unsigned char buffer[4096];
 };
 
+/* SumatraPDF: errors are reported once all preceding blocks have been passed on */
+static void
+throw_aesd_error(fz_stream *stm, fz_aesd *state)
+{
+	if (state->error == 1)
+		fz_throw(stm->ctx, FZ_ERROR_GENERIC, "partial block in aes filter");
+	fz_throw(stm->ctx, FZ_ERROR_GENERIC, "aes padding out of range: %d", state->pad);
+}
+
+/* SumatraPDF: decrypt as many blocks at once as the caller asks for */
 static int
 next_aesd(fz_stream *stm, int max)
 {
 	fz_aesd *state = stm->state;
-	unsigned char *p = state->buffer;
-	unsigned char *ep;
+	int n;
 
 	if (max > sizeof(state->buffer))
 		max = sizeof(state->buffer);
-	ep = p + max;
+	else if (max < 16)
+		max = 16;
 
 	while (state->ivcount < 16)
 	{
@@ -708,39 +726,39 @@ next_aesd(fz_stream *stm, int max)
 		state->iv[state->ivcount++] = c;
 	}
 
-	while (state->rp < state->wp && p < ep)
-		*p++ = *state->rp++;
+	if (state->error)
+		throw_aesd_error(stm, state);
 
-	while (p < ep)
+	n = fz_read(state->chain, state->buffer, (max + 15) & ~15);
+	if (n & 15)
 	{
-		int n = fz_read(state->chain, state->bp, 16);
-		if (n == 0)
-			break;
-		else if (n < 16)
-			fz_throw(stm->ctx, FZ_ERROR_GENERIC, "partial block in aes filter");
+		state->error = 1;
+		n &= ~15;
+	}
 
-		aes_crypt_cbc(&state->aes, AES_DECRYPT, 16, state->iv, state->bp, state->bp);
-		state->rp = state->bp;
-		state->wp = state->bp + 16;
+	aes_crypt_cbc(&state->aes, AES_DECRYPT, n, state->iv, state->buffer, state->buffer);
 
-		/* strip padding at end of file */
-		if (fz_is_eof(state->chain))
+	/* strip padding at end of file */
+	if (n > 0 && !state->error && fz_is_eof(state->chain))
+	{
+		state->pad = state->buffer[n - 1];
+		if (state->pad < 1 || state->pad > 16)
 		{
-			int pad = state->bp[15];
-			if (pad < 1 || pad > 16)
-				fz_throw(stm->ctx, FZ_ERROR_GENERIC, "aes padding out of range: %d", pad);
-			state->wp -= pad;
+			state->error = 2;
+			n -= 16;
 		}
-
-		while (state->rp < state->wp && p < ep)
-			*p++ = *state->rp++;
+		else
+			n -= state->pad;
 	}
 
+	if (n == 0 && state->error)
+		throw_aesd_error(stm, state);
+
 	stm->rp = state->buffer;
-	stm->wp = p;
-	stm->pos += p - state->buffer;
+	stm->wp = state->buffer + n;
+	stm->pos += n;
 
-	if (p == stm->rp)
+	if (n == 0)
 		return EOF;
 
 	return *stm->rp++;
@@ -778,8 +796,7 @@ fz_open_aesd(fz_stream *chain, unsigned char *key, unsigned keylen)
 		if (aes_setkey_dec(&state->aes, key, keylen * 8))
 			fz_throw(ctx, FZ_ERROR_GENERIC, "AES key init failed (keylen=%d)", keylen * 8);
 		state->ivcount = 0;
-		state->rp = state->bp;
-		state->wp = state->bp;
+		state->error = 0;
 	}
 	fz_catch(ctx)
 	{
@@ -103,6 +103,8 @@ static fz_stream *
 rebind_flated(fz_stream *s)
 {
 	fz_flate *state = s->state;
+	/* SumatraPDF: zlib allocates through the stream's (current) context */
+	state->z.opaque = s->ctx;
 	return state->chain;
 }
 
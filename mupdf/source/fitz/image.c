@@ -319,15 +319,55 @@ fz_free_image(fz_context *ctx, fz_storable *image_)
 	fz_free(ctx, image);
 }
 
+/* SumatraPDF: decode separately so that decoding can be traced */
+static fz_pixmap *
+decode_image_tile(fz_context *ctx, fz_image *image, int l2factor)
+{
+	fz_pixmap *tile = NULL;
+	fz_stream *stm;
+	int native_l2factor;
+	int indexed;
+
+	/* First check for ones that we can't decode using streams */
+	switch (image->buffer->params.type)
+	{
+	case FZ_IMAGE_PNG:
+		tile = fz_load_png(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
+		break;
+	case FZ_IMAGE_TIFF:
+		tile = fz_load_tiff(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
+		break;
+	case FZ_IMAGE_JXR:
+		tile = fz_load_jxr(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
+		break;
+	default:
+		native_l2factor = l2factor;
+		stm = fz_open_image_decomp_stream_from_buffer(ctx, image->buffer, &native_l2factor);
+
+		indexed = fz_colorspace_is_indexed(image->colorspace);
+		tile = fz_decomp_image_from_stream(ctx, stm, image, indexed, l2factor, native_l2factor);
+
+		/* CMYK JPEGs in XPS documents have to be inverted */
+		if (image->invert_cmyk_jpeg &&
+			image->buffer->params.type == FZ_IMAGE_JPEG &&
+			image->colorspace == fz_device_cmyk(ctx) &&
+			image->buffer->params.u.jpeg.color_transform)
+		{
+			fz_invert_pixmap(ctx, tile);
+		}
+
+		break;
+	}
+
+	return tile;
+}
+
 fz_pixmap *
 fz_image_get_pixmap(fz_context *ctx, fz_image *image, int w, int h)
 {
 	fz_pixmap *tile;
-	fz_stream *stm;
 	int l2factor;
 	fz_image_key key;
-	int native_l2factor;
-	int indexed;
 	fz_image_key *keyp;
 
 	/* Check for 'simple' images which are just pixmaps */
@@ -368,35 +408,18 @@ fz_image_get_pixmap(fz_context *ctx, fz_image *image, int w, int h)
 	while (key.l2factor >= 0);
 
 	/* We need to make a new one. */
-	/* First check for ones that we can't decode using streams */
-	switch (image->buffer->params.type)
+	fz_trace_begin(ctx, "fz_image_get_pixmap");
+	fz_try(ctx)
 	{
-	case FZ_IMAGE_PNG:
-		tile = fz_load_png(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
-		break;
-	case FZ_IMAGE_TIFF:
-		tile = fz_load_tiff(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
-		break;
-	case FZ_IMAGE_JXR:
-		tile = fz_load_jxr(ctx, image->buffer->buffer->data, image->buffer->buffer->len);
-		break;
-	default:
-		native_l2factor = l2factor;
-		stm = fz_open_image_decomp_stream_from_buffer(ctx, image->buffer, &native_l2factor);
-
-		indexed = fz_colorspace_is_indexed(image->colorspace);
-		tile = fz_decomp_image_from_stream(ctx, stm, image, indexed, l2factor, native_l2factor);
-
-		/* CMYK JPEGs in XPS documents have to be inverted */
-		if (image->invert_cmyk_jpeg &&
-			image->buffer->params.type == FZ_IMAGE_JPEG &&
-			image->colorspace == fz_device_cmyk(ctx) &&
-			image->buffer->params.u.jpeg.color_transform)
-		{
-			fz_invert_pixmap(ctx, tile);
-		}
-
-		break;
+		tile = decode_image_tile(ctx, image, l2factor);
+	}
+	fz_always(ctx)
+	{
+		fz_trace_end(ctx, "fz_image_get_pixmap");
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
 	}
 
 	/* Now we try to cache the pixmap. Any failure here will just result
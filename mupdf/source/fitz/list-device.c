@@ -655,6 +655,39 @@ fz_drop_display_list(fz_context *ctx, fz_display_list *list)
 	fz_drop_storable(ctx, &list->storable);
 }
 
+/* SumatraPDF: allow caching display lists for Form XObjects */
+unsigned int
+fz_display_list_size(fz_context *ctx, fz_display_list *list)
+{
+	fz_display_node *node;
+	unsigned int size = sizeof(fz_display_list);
+
+	for (node = list->first; node; node = node->next)
+	{
+		size += sizeof(fz_display_node);
+		switch (node->cmd)
+		{
+		case FZ_CMD_FILL_PATH:
+		case FZ_CMD_STROKE_PATH:
+		case FZ_CMD_CLIP_PATH:
+		case FZ_CMD_CLIP_STROKE_PATH:
+			size += sizeof(fz_path) + node->item.path->cmd_cap + node->item.path->coord_cap * sizeof(float);
+			break;
+		case FZ_CMD_FILL_TEXT:
+		case FZ_CMD_STROKE_TEXT:
+		case FZ_CMD_CLIP_TEXT:
+		case FZ_CMD_CLIP_STROKE_TEXT:
+		case FZ_CMD_IGNORE_TEXT:
+			size += sizeof(fz_text) + node->item.text->cap * sizeof(fz_text_item);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return size;
+}
+
 static fz_display_node *
 skip_to_end_tile(fz_display_node *node, int *progress)
 {
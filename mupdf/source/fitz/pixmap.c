@@ -1,5 +1,12 @@
 #include "mupdf/fitz.h"
 
+#if defined(_WIN32) && !defined(_WINRT)
+#include <windows.h>
+#elif defined(HAVE_PTHREADS)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 fz_pixmap *
 fz_keep_pixmap(fz_context *ctx, fz_pixmap *pix)
 {
@@ -679,16 +686,371 @@ fz_output_png(fz_output *out, const fz_pixmap *pixmap, int savealpha)
 	}
 }
 
+/* SumatraPDF: compress PNG bands in segments of about 256 KB which are
+ * deflated independently (on background threads under Windows and where
+ * HAVE_PTHREADS is defined, else synchronously on the calling thread) and
+ * concatenated with sync flushes into a single zlib stream. Each segment
+ * is primed with the preceding 32 KB of data so that compression doesn't
+ * suffer much from the split. Since compressing a band only depends on
+ * a copy of its filtered rows, the caller can already render the next
+ * band while the previous one is still being compressed. */
+
+#define PNG_SEGMENT_SIZE (256 * 1024)
+#define PNG_DICT_SIZE (32 * 1024)
+#define PNG_MAX_THREADS 8
+
+typedef struct png_segment_s png_segment;
+
+struct png_segment_s
+{
+	unsigned char *in;
+	int in_len;
+	unsigned char *dict;
+	int dict_len;
+	/* room for the zlib header before and the Adler-32 checksum after out */
+	unsigned char *buf;
+	unsigned char *out;
+	int out_cap, out_len;
+	int level;
+	int final;
+	uLong adler;
+	int err;
+};
+
 struct fz_png_output_context_s
 {
+	fz_png_options opts;
+	int rows_written;
+	/* filtered rows of the band being compressed */
 	unsigned char *udata;
-	unsigned char *cdata;
-	uLong usize, csize;
-	z_stream stream;
+	uLong usize;
+	/* the previous (unfiltered) row and space for packing and filtering rows */
+	unsigned char *prev;
+	unsigned char *rows;
+	unsigned char *scratch;
+	/* the tail of the previously compressed band */
+	unsigned char *dict;
+	int dict_len;
+	png_segment *segments;
+	int segment_count, segment_cap;
+	uLong adler;
+	int header_written;
+	/* background compression */
+	volatile long next_segment;
+	int thread_count;
+#if defined(_WIN32) && !defined(_WINRT)
+	HANDLE threads[PNG_MAX_THREADS];
+#elif defined(HAVE_PTHREADS)
+	pthread_t threads[PNG_MAX_THREADS];
+	/* guards next_segment while thread_count > 0 */
+	pthread_mutex_t lock;
+#endif
 };
 
+static void
+png_deflate_segment(png_segment *seg)
+{
+	z_stream stream;
+	int err;
+
+	memset(&stream, 0, sizeof(stream));
+	/* raw deflate data, the zlib wrapper is written separately */
+	err = deflateInit2(&stream, seg->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	if (err == Z_OK && seg->dict_len > 0)
+		err = deflateSetDictionary(&stream, seg->dict, seg->dict_len);
+	if (err == Z_OK)
+	{
+		stream.next_in = seg->in;
+		stream.avail_in = seg->in_len;
+		stream.next_out = seg->out;
+		stream.avail_out = seg->out_cap;
+		err = deflate(&stream, seg->final ? Z_FINISH : Z_SYNC_FLUSH);
+		if (seg->final && err == Z_STREAM_END)
+			err = Z_OK;
+		else if (seg->final || (err == Z_OK && (stream.avail_in != 0 || stream.avail_out == 0)))
+			err = Z_BUF_ERROR;
+		seg->out_len = (int)(stream.next_out - seg->out);
+		deflateEnd(&stream);
+	}
+	seg->adler = adler32(adler32(0, NULL, 0), seg->in, seg->in_len);
+	seg->err = err;
+}
+
+#if defined(_WIN32) && !defined(_WINRT)
+
+static DWORD WINAPI
+png_deflate_thread(LPVOID arg)
+{
+	fz_png_output_context *poc = (fz_png_output_context *)arg;
+	long i;
+
+	while ((i = InterlockedIncrement(&poc->next_segment) - 1) < poc->segment_count)
+		png_deflate_segment(&poc->segments[i]);
+	return 0;
+}
+
+static int
+png_default_threads(void)
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors;
+}
+
+static void
+png_start_deflating(fz_png_output_context *poc)
+{
+	int i, count = fz_mini(poc->opts.threads, poc->segment_count);
+
+	poc->next_segment = 0;
+	poc->thread_count = 0;
+	for (i = 0; i < count; i++)
+	{
+		poc->threads[i] = CreateThread(NULL, 0, png_deflate_thread, poc, 0, NULL);
+		if (!poc->threads[i])
+			break;
+		poc->thread_count++;
+	}
+	/* fall back to compressing on the calling thread */
+	if (poc->thread_count == 0)
+		png_deflate_thread(poc);
+}
+
+static void
+png_finish_deflating(fz_png_output_context *poc)
+{
+	int i;
+
+	for (i = 0; i < poc->thread_count; i++)
+	{
+		WaitForSingleObject(poc->threads[i], INFINITE);
+		CloseHandle(poc->threads[i]);
+	}
+	poc->thread_count = 0;
+}
+
+#elif defined(HAVE_PTHREADS)
+
+static void *
+png_deflate_thread(void *arg)
+{
+	fz_png_output_context *poc = (fz_png_output_context *)arg;
+	long i;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&poc->lock);
+		i = poc->next_segment++;
+		pthread_mutex_unlock(&poc->lock);
+		if (i >= poc->segment_count)
+			break;
+		png_deflate_segment(&poc->segments[i]);
+	}
+	return NULL;
+}
+
+static int
+png_default_threads(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+static void
+png_start_deflating(fz_png_output_context *poc)
+{
+	int i, count = fz_mini(poc->opts.threads, poc->segment_count);
+
+	poc->next_segment = 0;
+	poc->thread_count = 0;
+	if (count > 0 && pthread_mutex_init(&poc->lock, NULL) == 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (pthread_create(&poc->threads[i], NULL, png_deflate_thread, poc) != 0)
+				break;
+			poc->thread_count++;
+		}
+		if (poc->thread_count == 0)
+			pthread_mutex_destroy(&poc->lock);
+	}
+	/* fall back to compressing on the calling thread */
+	if (poc->thread_count == 0)
+	{
+		for (i = 0; i < poc->segment_count; i++)
+			png_deflate_segment(&poc->segments[i]);
+	}
+}
+
+static void
+png_finish_deflating(fz_png_output_context *poc)
+{
+	int i;
+
+	if (poc->thread_count == 0)
+		return;
+	for (i = 0; i < poc->thread_count; i++)
+		pthread_join(poc->threads[i], NULL);
+	pthread_mutex_destroy(&poc->lock);
+	poc->thread_count = 0;
+}
+
+#else
+
+static int
+png_default_threads(void)
+{
+	return 1;
+}
+
+static void
+png_start_deflating(fz_png_output_context *poc)
+{
+	int i;
+
+	for (i = 0; i < poc->segment_count; i++)
+		png_deflate_segment(&poc->segments[i]);
+}
+
+static void
+png_finish_deflating(fz_png_output_context *poc)
+{
+}
+
+#endif
+
+static void
+png_drop_segments(fz_context *ctx, fz_png_output_context *poc)
+{
+	int i;
+
+	for (i = 0; i < poc->segment_count; i++)
+		fz_free(ctx, poc->segments[i].buf);
+	poc->segment_count = 0;
+}
+
+/* writes the compressed segments of the previous band (if any) */
+static void
+png_flush_segments(fz_output *out, fz_png_output_context *poc)
+{
+	fz_context *ctx = out->ctx;
+	int i, err = Z_OK;
+
+	png_finish_deflating(poc);
+
+	for (i = 0; i < poc->segment_count; i++)
+	{
+		png_segment *seg = &poc->segments[i];
+		unsigned char *start = seg->out;
+		unsigned char *end = seg->out + seg->out_len;
+
+		if (err == Z_OK)
+			err = seg->err;
+		if (err != Z_OK)
+			continue;
+		if (!poc->header_written)
+		{
+			int flevel = poc->opts.level < 0 || poc->opts.level == 6 ? 2 : poc->opts.level < 2 ? 0 : poc->opts.level < 6 ? 1 : 3;
+			start -= 2;
+			start[0] = 0x78;
+			start[1] = flevel << 6;
+			start[1] += 31 - (start[0] * 256 + start[1]) % 31;
+			poc->header_written = 1;
+		}
+		poc->adler = adler32_combine(poc->adler, seg->adler, seg->in_len);
+		if (seg->final)
+		{
+			big32(end, (unsigned int)poc->adler);
+			end += 4;
+		}
+		putchunk("IDAT", start, (int)(end - start), out);
+	}
+
+	png_drop_segments(ctx, poc);
+
+	if (err != Z_OK)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "compression error %d", err);
+}
+
+static inline int
+paeth(int a, int b, int c)
+{
+	/* The definitions of ac and bc are correct, not a typo. */
+	int ac = b - c, bc = a - c, abcc = ac + bc;
+	int pa = (ac < 0 ? -ac : ac);
+	int pb = (bc < 0 ? -bc : bc);
+	int pc = (abcc < 0 ? -abcc : abcc);
+	return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+static void
+png_filter_row(unsigned char *dp, const unsigned char *cur, const unsigned char *prev, int len, int bpp, int filter)
+{
+	int i;
+
+	*dp++ = filter;
+	switch (filter)
+	{
+	case FZ_PNG_FILTER_NONE:
+		memcpy(dp, cur, len);
+		break;
+	case FZ_PNG_FILTER_SUB:
+		for (i = 0; i < bpp; i++)
+			dp[i] = cur[i];
+		for (; i < len; i++)
+			dp[i] = cur[i] - cur[i - bpp];
+		break;
+	case FZ_PNG_FILTER_UP:
+		for (i = 0; i < len; i++)
+			dp[i] = cur[i] - prev[i];
+		break;
+	case FZ_PNG_FILTER_AVERAGE:
+		for (i = 0; i < bpp; i++)
+			dp[i] = cur[i] - (prev[i] >> 1);
+		for (; i < len; i++)
+			dp[i] = cur[i] - ((cur[i - bpp] + prev[i]) >> 1);
+		break;
+	case FZ_PNG_FILTER_PAETH:
+		for (i = 0; i < bpp; i++)
+			dp[i] = cur[i] - prev[i];
+		for (; i < len; i++)
+			dp[i] = cur[i] - paeth(cur[i - bpp], prev[i], prev[i - bpp]);
+		break;
+	}
+}
+
+/* picks the filter with the smallest sum of absolute (signed) differences */
+static void
+png_filter_row_adaptive(unsigned char *dp, const unsigned char *cur, const unsigned char *prev, int len, int bpp, unsigned char *scratch)
+{
+	int filter, i, best = FZ_PNG_FILTER_NONE;
+	unsigned int sum, best_sum = UINT_MAX;
+
+	for (filter = FZ_PNG_FILTER_NONE; filter <= FZ_PNG_FILTER_PAETH; filter++)
+	{
+		unsigned char *row = scratch + filter * (len + 1);
+		png_filter_row(row, cur, prev, len, bpp, filter);
+		for (sum = 0, i = 1; i <= len && sum < best_sum; i++)
+			sum += row[i] < 128 ? row[i] : 256 - row[i];
+		if (sum < best_sum)
+		{
+			best = filter;
+			best_sum = sum;
+		}
+	}
+	memcpy(dp, scratch + best * (len + 1), len + 1);
+}
+
 fz_png_output_context *
 fz_output_png_header(fz_output *out, int w, int h, int n, int savealpha)
+{
+	fz_png_options opts = { -1, FZ_PNG_FILTER_SUB, 0 };
+
+	return fz_output_png_header_with_options(out, w, h, n, savealpha, &opts);
+}
+
+fz_png_output_context *
+fz_output_png_header_with_options(fz_output *out, int w, int h, int n, int savealpha, const fz_png_options *opts)
 {
 	static const unsigned char pngsig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 	unsigned char head[13];
@@ -703,8 +1065,17 @@ fz_output_png_header(fz_output *out, int w, int h, int n, int savealpha)
 
 	if (n != 1 && n != 2 && n != 4)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "pixmap must be grayscale or rgb to write as png");
+	if (opts->level < -1 || opts->level > 9)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "invalid png compression level %d", opts->level);
+	if (opts->filter < FZ_PNG_FILTER_NONE || opts->filter > FZ_PNG_FILTER_ADAPTIVE)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "invalid png filter %d", opts->filter);
 
 	poc = fz_malloc_struct(ctx, fz_png_output_context);
+	poc->opts = *opts;
+	if (poc->opts.threads <= 0)
+		poc->opts.threads = png_default_threads();
+	poc->opts.threads = fz_clampi(poc->opts.threads, 1, PNG_MAX_THREADS);
+	poc->adler = adler32(0, NULL, 0);
 
 	if (!savealpha && n > 1)
 		n--;
@@ -735,8 +1106,8 @@ fz_output_png_header(fz_output *out, int w, int h, int n, int savealpha)
 void
 fz_output_png_band(fz_output *out, int w, int h, int n, int band, int bandheight, unsigned char *sp, int savealpha, fz_png_output_context *poc)
 {
-	unsigned char *dp;
-	int y, x, k, sn, dn, err, finalband;
+	unsigned char *dp, *prev;
+	int y, x, k, sn, dn, finalband, rowlen, seg_rows;
 	fz_context *ctx;
 
 	if (!out || !sp || !poc)
@@ -756,82 +1127,108 @@ fz_output_png_band(fz_output *out, int w, int h, int n, int band, int bandheight
 	dn = n;
 	if (!savealpha && dn > 1)
 		dn--;
+	rowlen = w * dn;
+
+	/* write out the previous band before reusing its buffers */
+	png_flush_segments(out, poc);
 
 	if (poc->udata == NULL)
 	{
-		poc->usize = (w * dn + 1) * bandheight;
-		/* Sadly the bound returned by compressBound is just for a
-		 * single usize chunk; if you compress a sequence of them
-		 * the buffering can result in you suddenly getting a block
-		 * larger than compressBound outputted in one go, even if you
-		 * take all the data out each time. */
-		poc->csize = compressBound(poc->usize);
-		fz_try(ctx)
-		{
-			poc->udata = fz_malloc(ctx, poc->usize);
-			poc->cdata = fz_malloc(ctx, poc->csize);
-		}
-		fz_catch(ctx)
-		{
-			fz_free(ctx, poc->udata);
-			poc->udata = NULL;
-			poc->cdata = NULL;
-			fz_rethrow(ctx);
-		}
-		err = deflateInit(&poc->stream, Z_DEFAULT_COMPRESSION);
-		if (err != Z_OK)
-			fz_throw(ctx, FZ_ERROR_GENERIC, "compression error %d", err);
+		poc->usize = (rowlen + 1) * bandheight;
+		/* all buffers are freed by fz_output_png_trailer */
+		poc->udata = fz_malloc(ctx, poc->usize);
+		poc->prev = fz_calloc(ctx, rowlen, 1);
+		poc->rows = fz_malloc(ctx, 2 * rowlen);
+		if (poc->opts.filter == FZ_PNG_FILTER_ADAPTIVE)
+			poc->scratch = fz_malloc(ctx, 5 * (rowlen + 1));
+		poc->dict = fz_malloc(ctx, PNG_DICT_SIZE);
+	}
+	else if (poc->usize < (uLong)(rowlen + 1) * bandheight)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "png bands must not grow");
+	else if (poc->rows_written > 0)
+	{
+		/* keep the end of the previous band for priming the first segment */
+		uLong used = (uLong)(rowlen + 1) * poc->rows_written;
+		poc->dict_len = (int)fz_mini(used, PNG_DICT_SIZE);
+		memcpy(poc->dict, poc->udata + used - poc->dict_len, poc->dict_len);
 	}
 
+	/* pack and filter the rows */
 	dp = poc->udata;
+	prev = poc->prev;
 	for (y = 0; y < bandheight; y++)
 	{
-		*dp++ = 1; /* sub prediction filter */
-		for (x = 0; x < w; x++)
+		unsigned char *cur;
+		if (sn == dn)
+			cur = sp;
+		else
 		{
-			for (k = 0; k < dn; k++)
-			{
-				if (x == 0)
-					dp[k] = sp[k];
-				else
-					dp[k] = sp[k] - sp[k-sn];
-			}
-			sp += sn;
-			dp += dn;
+			unsigned char *s = sp;
+			cur = poc->rows + (y & 1) * rowlen;
+			for (x = 0; x < w; x++, s += sn)
+				for (k = 0; k < dn; k++)
+					cur[x * dn + k] = s[k];
 		}
+		if (poc->opts.filter == FZ_PNG_FILTER_ADAPTIVE)
+			png_filter_row_adaptive(dp, cur, prev, rowlen, dn, poc->scratch);
+		else
+			png_filter_row(dp, cur, prev, rowlen, dn, poc->opts.filter);
+		dp += rowlen + 1;
+		prev = cur;
+		sp += w * sn;
 	}
+	memcpy(poc->prev, prev, rowlen);
+	poc->rows_written = bandheight;
 
-	poc->stream.next_in = (Bytef*)poc->udata;
-	poc->stream.avail_in = (uInt)(dp - poc->udata);
-	do
+	/* split the band into segments at row boundaries */
+	seg_rows = fz_maxi(1, PNG_SEGMENT_SIZE / (rowlen + 1));
+	k = (bandheight + seg_rows - 1) / seg_rows;
+	if (k > poc->segment_cap)
+	{
+		poc->segments = fz_resize_array(ctx, poc->segments, k, sizeof(png_segment));
+		poc->segment_cap = k;
+	}
+	for (y = 0; y < bandheight; y += seg_rows)
 	{
-		poc->stream.next_out = poc->cdata;
-		poc->stream.avail_out = (uInt)poc->csize;
+		png_segment *seg = &poc->segments[poc->segment_count];
+		int rows = fz_mini(seg_rows, bandheight - y);
 
-		if (!finalband)
+		memset(seg, 0, sizeof(png_segment));
+		seg->in = poc->udata + (uLong)y * (rowlen + 1);
+		seg->in_len = rows * (rowlen + 1);
+		if (y > 0)
 		{
-			err = deflate(&poc->stream, Z_NO_FLUSH);
-			if (err != Z_OK)
-				fz_throw(ctx, FZ_ERROR_GENERIC, "compression error %d", err);
+			seg->dict_len = (int)fz_mini(y * (rowlen + 1), PNG_DICT_SIZE);
+			seg->dict = seg->in - seg->dict_len;
 		}
 		else
 		{
-			err = deflate(&poc->stream, Z_FINISH);
-			if (err != Z_STREAM_END)
-				fz_throw(ctx, FZ_ERROR_GENERIC, "compression error %d", err);
+			seg->dict = poc->dict;
+			seg->dict_len = poc->dict_len;
 		}
-
-		if (poc->stream.next_out != poc->cdata)
-			putchunk("IDAT", poc->cdata, poc->stream.next_out - poc->cdata, out);
+		seg->level = poc->opts.level;
+		seg->final = finalband && y + rows >= bandheight;
+		/* a sync flush adds up to 10 bytes to the compressed data */
+		seg->out_cap = compressBound(seg->in_len) + 16;
+		seg->buf = fz_malloc_no_throw(ctx, 2 + seg->out_cap + 4);
+		if (!seg->buf)
+		{
+			png_drop_segments(ctx, poc);
+			fz_throw(ctx, FZ_ERROR_GENERIC, "out of memory compressing png band");
+		}
+		seg->out = seg->buf + 2;
+		poc->segment_count++;
 	}
-	while (poc->stream.avail_out == 0);
+
+	png_start_deflating(poc);
+	if (finalband)
+		png_flush_segments(out, poc);
 }
 
 void
 fz_output_png_trailer(fz_output *out, fz_png_output_context *poc)
 {
 	unsigned char block[1];
-	int err;
 	fz_context *ctx;
 
 	if (!out || !poc)
@@ -839,13 +1236,24 @@ fz_output_png_trailer(fz_output *out, fz_png_output_context *poc)
 
 	ctx = out->ctx;
 
-	err = deflateEnd(&poc->stream);
-	if (err != Z_OK)
-		fz_throw(ctx, FZ_ERROR_GENERIC, "compression error %d", err);
-
-	fz_free(ctx, poc->cdata);
-	fz_free(ctx, poc->udata);
-	fz_free(ctx, poc);
+	fz_try(ctx)
+	{
+		png_flush_segments(out, poc);
+	}
+	fz_always(ctx)
+	{
+		fz_free(ctx, poc->segments);
+		fz_free(ctx, poc->dict);
+		fz_free(ctx, poc->scratch);
+		fz_free(ctx, poc->rows);
+		fz_free(ctx, poc->prev);
+		fz_free(ctx, poc->udata);
+		fz_free(ctx, poc);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
 
 	putchunk("IEND", block, 0, out);
 }
@@ -268,10 +268,267 @@ static inline float read_sample(fz_stream *stream, int bits, float min, float ma
 	return min + fz_read_bits(stream, bits) * (max - min) * bitscale;
 }
 
+/* SumatraPDF: decode the sample streams of mesh shadings only once */
+
+/*
+	The flags and samples of mesh shadings of types 4 to 7 are recorded
+	(scaled to their decode ranges, but not yet transformed) while they
+	are read for the first time. Later renderings (at other zoom levels
+	or for other tiles) replay them from the store instead of inflating
+	and unpacking the stream again.
+*/
+
+#define MAX_MESH_SAMPLES (4 << 20)
+
+typedef struct fz_mesh_samples_s fz_mesh_samples;
+
+struct fz_mesh_samples_s
+{
+	fz_storable storable;
+	int len;
+	int cap;
+	float *values;
+};
+
+typedef struct fz_mesh_samples_key_s fz_mesh_samples_key;
+
+struct fz_mesh_samples_key_s
+{
+	int refs;
+	fz_shade *shade;
+};
+
+static void
+fz_free_mesh_samples_imp(fz_context *ctx, fz_storable *samples_)
+{
+	fz_mesh_samples *samples = (fz_mesh_samples *)samples_;
+
+	fz_free(ctx, samples->values);
+	fz_free(ctx, samples);
+}
+
+static int
+fz_make_hash_mesh_samples_key(fz_store_hash *hash, void *key_)
+{
+	fz_mesh_samples_key *key = (fz_mesh_samples_key *)key_;
+
+	hash->u.pi.ptr = key->shade;
+	hash->u.pi.i = 0;
+	return 1;
+}
+
+static void *
+fz_keep_mesh_samples_key(fz_context *ctx, void *key_)
+{
+	fz_mesh_samples_key *key = (fz_mesh_samples_key *)key_;
+
+	fz_lock(ctx, FZ_LOCK_ALLOC);
+	key->refs++;
+	fz_unlock(ctx, FZ_LOCK_ALLOC);
+
+	return (void *)key;
+}
+
+static void
+fz_drop_mesh_samples_key(fz_context *ctx, void *key_)
+{
+	fz_mesh_samples_key *key = (fz_mesh_samples_key *)key_;
+	int drop;
+
+	if (key == NULL)
+		return;
+	fz_lock(ctx, FZ_LOCK_ALLOC);
+	drop = --key->refs;
+	fz_unlock(ctx, FZ_LOCK_ALLOC);
+	if (drop == 0)
+	{
+		fz_drop_shade(ctx, key->shade);
+		fz_free(ctx, key);
+	}
+}
+
+static int
+fz_cmp_mesh_samples_key(void *k0_, void *k1_)
+{
+	fz_mesh_samples_key *k0 = (fz_mesh_samples_key *)k0_;
+	fz_mesh_samples_key *k1 = (fz_mesh_samples_key *)k1_;
+
+	return k0->shade == k1->shade;
+}
+
+#ifndef NDEBUG
+static void
+fz_debug_mesh_samples(FILE *out, void *key_)
+{
+	fz_mesh_samples_key *key = (fz_mesh_samples_key *)key_;
+
+	fprintf(out, "(mesh samples type=%d) ", key->shade->type);
+}
+#endif
+
+static fz_store_type fz_mesh_samples_store_type =
+{
+	fz_make_hash_mesh_samples_key,
+	fz_keep_mesh_samples_key,
+	fz_drop_mesh_samples_key,
+	fz_cmp_mesh_samples_key,
+#ifndef NDEBUG
+	fz_debug_mesh_samples
+#endif
+};
+
+typedef struct mesh_reader_s mesh_reader;
+
+struct mesh_reader_s
+{
+	fz_context *ctx;
+	fz_shade *shade;
+	/* stream is NULL when replaying cached samples */
+	fz_stream *stream;
+	/* samples is NULL if the stream isn't (or no longer) being recorded */
+	fz_mesh_samples *samples;
+	int pos;
+};
+
+static void
+open_mesh_reader(fz_context *ctx, mesh_reader *r, fz_shade *shade)
+{
+	fz_mesh_samples_key key;
+
+	r->ctx = ctx;
+	r->shade = shade;
+	r->stream = NULL;
+	r->pos = 0;
+
+	key.refs = 1;
+	key.shade = shade;
+	r->samples = fz_find_item(ctx, fz_free_mesh_samples_imp, &key, &fz_mesh_samples_store_type);
+	if (r->samples)
+		return;
+
+	r->samples = fz_malloc_no_throw(ctx, sizeof(fz_mesh_samples));
+	if (r->samples)
+	{
+		FZ_INIT_STORABLE(r->samples, 1, fz_free_mesh_samples_imp);
+		r->samples->len = r->samples->cap = 0;
+		r->samples->values = NULL;
+	}
+	fz_try(ctx)
+	{
+		r->stream = fz_open_compressed_buffer(ctx, shade->buffer);
+	}
+	fz_catch(ctx)
+	{
+		if (r->samples)
+			fz_drop_storable(ctx, &r->samples->storable);
+		fz_rethrow(ctx);
+	}
+}
+
+static void
+cache_mesh_samples(mesh_reader *r)
+{
+	fz_context *ctx = r->ctx;
+	fz_mesh_samples_key *key = NULL;
+	fz_mesh_samples *existing;
+
+	if (!r->stream || !r->samples)
+		return;
+
+	fz_var(key);
+
+	fz_try(ctx)
+	{
+		key = fz_malloc_struct(ctx, fz_mesh_samples_key);
+		key->refs = 1;
+		key->shade = fz_keep_shade(ctx, r->shade);
+		existing = fz_store_item(ctx, key, r->samples, sizeof(fz_mesh_samples) + r->samples->cap * sizeof(float), &fz_mesh_samples_store_type);
+		if (existing)
+			fz_drop_storable(ctx, &existing->storable);
+	}
+	fz_always(ctx)
+	{
+		fz_drop_mesh_samples_key(ctx, key);
+	}
+	fz_catch(ctx)
+	{
+		/* caching the samples is optional */
+	}
+}
+
+static void
+close_mesh_reader(mesh_reader *r)
+{
+	fz_close(r->stream);
+	if (r->samples)
+		fz_drop_storable(r->ctx, &r->samples->storable);
+}
+
+static void
+record_mesh_value(mesh_reader *r, float value)
+{
+	fz_mesh_samples *samples = r->samples;
+
+	if (samples->len == samples->cap)
+	{
+		int cap = samples->cap ? samples->cap * 2 : 1024;
+		float *values = NULL;
+		if (cap <= MAX_MESH_SAMPLES)
+			values = fz_resize_array_no_throw(r->ctx, samples->values, cap, sizeof(float));
+		if (!values)
+		{
+			/* stop recording and just keep reading the stream */
+			fz_drop_storable(r->ctx, &samples->storable);
+			r->samples = NULL;
+			return;
+		}
+		samples->values = values;
+		samples->cap = cap;
+	}
+	samples->values[samples->len++] = value;
+}
+
+static inline int mesh_is_eof(mesh_reader *r)
+{
+	if (r->stream)
+		return fz_is_eof_bits(r->stream);
+	return r->pos >= r->samples->len;
+}
+
+static inline int read_mesh_flag(mesh_reader *r, int bits)
+{
+	int flag;
+
+	if (!r->stream)
+		return r->pos < r->samples->len ? (int)r->samples->values[r->pos++] : 0;
+	flag = fz_read_bits(r->stream, bits);
+	if (r->samples)
+		record_mesh_value(r, flag);
+	return flag;
+}
+
+static inline void skip_mesh_flag(mesh_reader *r, int bits)
+{
+	if (r->stream)
+		fz_read_bits(r->stream, bits);
+}
+
+static inline float read_mesh_sample(mesh_reader *r, int bits, float min, float max)
+{
+	float value;
+
+	if (!r->stream)
+		return r->pos < r->samples->len ? r->samples->values[r->pos++] : 0;
+	value = read_sample(r->stream, bits, min, max);
+	if (r->samples)
+		record_mesh_value(r, value);
+	return value;
+}
+
 static void
 fz_process_mesh_type4(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_mesh_processor *painter)
 {
-	fz_stream *stream = fz_open_compressed_buffer(ctx, shade->buffer);
+	mesh_reader reader;
 	fz_vertex v[4];
 	fz_vertex *va = &v[0];
 	fz_vertex *vb = &v[1];
@@ -289,15 +546,17 @@ fz_process_mesh_type4(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 	float *c1 = shade->u.m.c1;
 	float x, y, c[FZ_MAX_COLORS];
 
+	open_mesh_reader(ctx, &reader, shade);
+
 	fz_try(ctx)
 	{
-		while (!fz_is_eof_bits(stream))
+		while (!mesh_is_eof(&reader))
 		{
-			flag = fz_read_bits(stream, bpflag);
-			x = read_sample(stream, bpcoord, x0, x1);
-			y = read_sample(stream, bpcoord, y0, y1);
+			flag = read_mesh_flag(&reader, bpflag);
+			x = read_mesh_sample(&reader, bpcoord, x0, x1);
+			y = read_mesh_sample(&reader, bpcoord, y0, y1);
 			for (i = 0; i < ncomp; i++)
-				c[i] = read_sample(stream, bpcomp, c0[i], c1[i]);
+				c[i] = read_mesh_sample(&reader, bpcomp, c0[i], c1[i]);
 			fz_prepare_vertex(painter, vd, ctm, x, y, c);
 
 			switch (flag)
@@ -305,18 +564,18 @@ fz_process_mesh_type4(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			case 0: /* start new triangle */
 				SWAP(va, vd);
 
-				fz_read_bits(stream, bpflag);
-				x = read_sample(stream, bpcoord, x0, x1);
-				y = read_sample(stream, bpcoord, y0, y1);
+				skip_mesh_flag(&reader, bpflag);
+				x = read_mesh_sample(&reader, bpcoord, x0, x1);
+				y = read_mesh_sample(&reader, bpcoord, y0, y1);
 				for (i = 0; i < ncomp; i++)
-					c[i] = read_sample(stream, bpcomp, c0[i], c1[i]);
+					c[i] = read_mesh_sample(&reader, bpcomp, c0[i], c1[i]);
 				fz_prepare_vertex(painter, vb, ctm, x, y, c);
 
-				fz_read_bits(stream, bpflag);
-				x = read_sample(stream, bpcoord, x0, x1);
-				y = read_sample(stream, bpcoord, y0, y1);
+				skip_mesh_flag(&reader, bpflag);
+				x = read_mesh_sample(&reader, bpcoord, x0, x1);
+				y = read_mesh_sample(&reader, bpcoord, y0, y1);
 				for (i = 0; i < ncomp; i++)
-					c[i] = read_sample(stream, bpcomp, c0[i], c1[i]);
+					c[i] = read_mesh_sample(&reader, bpcomp, c0[i], c1[i]);
 				fz_prepare_vertex(painter, vc, ctm, x, y, c);
 
 				paint_tri(painter, va, vb, vc);
@@ -336,10 +595,11 @@ fz_process_mesh_type4(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 				break;
 			}
 		}
+		cache_mesh_samples(&reader);
 	}
 	fz_always(ctx)
 	{
-		fz_close(stream);
+		close_mesh_reader(&reader);
 	}
 	fz_catch(ctx)
 	{
@@ -350,7 +610,7 @@ fz_process_mesh_type4(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 static void
 fz_process_mesh_type5(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_mesh_processor *painter)
 {
-	fz_stream *stream = fz_open_compressed_buffer(ctx, shade->buffer);
+	mesh_reader reader;
 	fz_vertex *buf = NULL;
 	fz_vertex *ref = NULL;
 	int first;
@@ -370,20 +630,22 @@ fz_process_mesh_type5(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 	fz_var(buf);
 	fz_var(ref);
 
+	open_mesh_reader(ctx, &reader, shade);
+
 	fz_try(ctx)
 	{
 		ref = fz_malloc_array(ctx, vprow, sizeof(fz_vertex));
 		buf = fz_malloc_array(ctx, vprow, sizeof(fz_vertex));
 		first = 1;
 
-		while (!fz_is_eof_bits(stream))
+		while (!mesh_is_eof(&reader))
 		{
 			for (i = 0; i < vprow; i++)
 			{
-				x = read_sample(stream, bpcoord, x0, x1);
-				y = read_sample(stream, bpcoord, y0, y1);
+				x = read_mesh_sample(&reader, bpcoord, x0, x1);
+				y = read_mesh_sample(&reader, bpcoord, y0, y1);
 				for (k = 0; k < ncomp; k++)
-					c[k] = read_sample(stream, bpcomp, c0[k], c1[k]);
+					c[k] = read_mesh_sample(&reader, bpcomp, c0[k], c1[k]);
 				fz_prepare_vertex(painter, &buf[i], ctm, x, y, c);
 			}
 
@@ -394,12 +656,13 @@ fz_process_mesh_type5(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			SWAP(ref,buf);
 			first = 0;
 		}
+		cache_mesh_samples(&reader);
 	}
 	fz_always(ctx)
 	{
 		fz_free(ctx, ref);
 		fz_free(ctx, buf);
-		fz_close(stream);
+		close_mesh_reader(&reader);
 	}
 	fz_catch(ctx)
 	{
@@ -665,7 +928,7 @@ make_tensor_patch(tensor_patch *p, int type, fz_point *pt)
 static void
 fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_mesh_processor *painter)
 {
-	fz_stream *stream = fz_open_compressed_buffer(ctx, shade->buffer);
+	mesh_reader reader;
 	float color_storage[2][4][FZ_MAX_COLORS];
 	fz_point point_storage[2][12];
 	int store = 0;
@@ -681,11 +944,13 @@ fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 	float *c0 = shade->u.m.c0;
 	float *c1 = shade->u.m.c1;
 
+	open_mesh_reader(ctx, &reader, shade);
+
 	fz_try(ctx)
 	{
 		float (*prevc)[FZ_MAX_COLORS] = NULL;
 		fz_point *prevp = NULL;
-		while (!fz_is_eof_bits(stream))
+		while (!mesh_is_eof(&reader))
 		{
 			float (*c)[FZ_MAX_COLORS] = color_storage[store];
 			fz_point *v = point_storage[store];
@@ -694,7 +959,7 @@ fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			int flag;
 			tensor_patch patch;
 
-			flag = fz_read_bits(stream, bpflag);
+			flag = read_mesh_flag(&reader, bpflag);
 
 			if (flag == 0)
 			{
@@ -709,15 +974,15 @@ fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 
 			for (i = startpt; i < 12; i++)
 			{
-				v[i].x = read_sample(stream, bpcoord, x0, x1);
-				v[i].y = read_sample(stream, bpcoord, y0, y1);
+				v[i].x = read_mesh_sample(&reader, bpcoord, x0, x1);
+				v[i].y = read_mesh_sample(&reader, bpcoord, y0, y1);
 				fz_transform_point(&v[i], ctm);
 			}
 
 			for (i = startcolor; i < 4; i++)
 			{
 				for (k = 0; k < ncomp; k++)
-					c[i][k] = read_sample(stream, bpcomp, c0[k], c1[k]);
+					c[i][k] = read_mesh_sample(&reader, bpcomp, c0[k], c1[k]);
 			}
 
 			if (flag == 0)
@@ -764,10 +1029,11 @@ fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			prevc = c;
 			store ^= 1;
 		}
+		cache_mesh_samples(&reader);
 	}
 	fz_always(ctx)
 	{
-		fz_close(stream);
+		close_mesh_reader(&reader);
 	}
 	fz_catch(ctx)
 	{
@@ -778,7 +1044,7 @@ fz_process_mesh_type6(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 static void
 fz_process_mesh_type7(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz_mesh_processor *painter)
 {
-	fz_stream *stream = fz_open_compressed_buffer(ctx, shade->buffer);
+	mesh_reader reader;
 	int bpflag = shade->u.m.bpflag;
 	int bpcoord = shade->u.m.bpcoord;
 	int bpcomp = shade->u.m.bpcomp;
@@ -796,9 +1062,11 @@ fz_process_mesh_type7(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 	float (*prevc)[FZ_MAX_COLORS] = NULL;
 	fz_point (*prevp) = NULL;
 
+	open_mesh_reader(ctx, &reader, shade);
+
 	fz_try(ctx)
 	{
-		while (!fz_is_eof_bits(stream))
+		while (!mesh_is_eof(&reader))
 		{
 			float (*c)[FZ_MAX_COLORS] = color_storage[store];
 			fz_point *v = point_storage[store];
@@ -807,7 +1075,7 @@ fz_process_mesh_type7(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			int flag;
 			tensor_patch patch;
 
-			flag = fz_read_bits(stream, bpflag);
+			flag = read_mesh_flag(&reader, bpflag);
 
 			if (flag == 0)
 			{
@@ -822,15 +1090,15 @@ fz_process_mesh_type7(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 
 			for (i = startpt; i < 16; i++)
 			{
-				v[i].x = read_sample(stream, bpcoord, x0, x1);
-				v[i].y = read_sample(stream, bpcoord, y0, y1);
+				v[i].x = read_mesh_sample(&reader, bpcoord, x0, x1);
+				v[i].y = read_mesh_sample(&reader, bpcoord, y0, y1);
 				fz_transform_point(&v[i], ctm);
 			}
 
 			for (i = startcolor; i < 4; i++)
 			{
 				for (k = 0; k < ncomp; k++)
-					c[i][k] = read_sample(stream, bpcomp, c0[k], c1[k]);
+					c[i][k] = read_mesh_sample(&reader, bpcomp, c0[k], c1[k]);
 			}
 
 			if (flag == 0)
@@ -877,10 +1145,11 @@ fz_process_mesh_type7(fz_context *ctx, fz_shade *shade, const fz_matrix *ctm, fz
 			prevc = c;
 			store ^= 1;
 		}
+		cache_mesh_samples(&reader);
 	}
 	fz_always(ctx)
 	{
-		fz_close(stream);
+		close_mesh_reader(&reader);
 	}
 	fz_catch(ctx)
 	{
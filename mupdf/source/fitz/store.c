@@ -29,6 +29,10 @@ struct fz_store_s
 	/* We keep track of the size of the store, and keep it below max. */
 	unsigned int max;
 	unsigned int size;
+
+	/* SumatraPDF: count lookups for benchmarking */
+	int hits;
+	int misses;
 };
 
 void
@@ -391,9 +395,11 @@ fz_find_item(fz_context *ctx, fz_store_free_fn *free, void *key, fz_store_type *
 		/* And bump the refcount before returning */
 		if (item->val->refs > 0)
 			item->val->refs++;
+		store->hits++;
 		fz_unlock(ctx, FZ_LOCK_ALLOC);
 		return (void *)item->val;
 	}
+	store->misses++;
 	fz_unlock(ctx, FZ_LOCK_ALLOC);
 
 	return NULL;
@@ -549,6 +555,27 @@ fz_print_store(fz_context *ctx, FILE *out)
 }
 #endif
 
+/* SumatraPDF: allow benchmarks to report the store's usage */
+void
+fz_get_store_stats(fz_context *ctx, fz_store_stats *stats)
+{
+	fz_store *store = ctx->store;
+	fz_item *item;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!store)
+		return;
+
+	fz_lock(ctx, FZ_LOCK_ALLOC);
+	stats->size = store->size;
+	stats->max = store->max;
+	for (item = store->head; item; item = item->next)
+		stats->items++;
+	stats->hits = store->hits;
+	stats->misses = store->misses;
+	fz_unlock(ctx, FZ_LOCK_ALLOC);
+}
+
 /* This is now an n^2 algorithm - not ideal, but it'll only be bad if we are
  * actually managing to scavenge lots of blocks back. */
 static int
@@ -219,6 +219,14 @@ static void seek_buffer(fz_stream *stm, int offset, int whence)
 	stm->rp += offset - pos;
 }
 
+/* SumatraPDF: allow filters to read directly from memory */
+static int meta_buffer(fz_stream *stm, int key, int size, void *ptr)
+{
+	if (key == FZ_STREAM_META_MEMORY)
+		return 1;
+	return -1;
+}
+
 static void close_buffer(fz_context *ctx, void *state_)
 {
 	fz_buffer *state = (fz_buffer *)state_;
@@ -247,6 +255,7 @@ fz_open_buffer(fz_context *ctx, fz_buffer *buf)
 	fz_keep_buffer(ctx, buf);
 	stm = fz_new_stream(ctx, buf, next_buffer, close_buffer, NULL);
 	stm->seek = seek_buffer;
+	stm->meta = meta_buffer;
 	stm->reopen = reopen_buffer;
 
 	stm->rp = buf->data;
@@ -264,6 +273,7 @@ fz_open_memory(fz_context *ctx, unsigned char *data, int len)
 
 	stm = fz_new_stream(ctx, NULL, next_buffer, close_buffer, NULL);
 	stm->seek = seek_buffer;
+	stm->meta = meta_buffer;
 	stm->reopen = reopen_buffer;
 
 	stm->rp = data;
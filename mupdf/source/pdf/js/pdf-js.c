@@ -799,9 +799,9 @@ static pdf_js *pdf_new_js(pdf_document *doc)
 		js->doc = doc;
 
 		/* Find the form array */
-		root = pdf_dict_gets(pdf_trailer(doc), "Root");
-		acroform = pdf_dict_gets(root, "AcroForm");
-		js->form = pdf_dict_gets(acroform, "Fields");
+		root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+		acroform = pdf_dict_get(root, PDF_NAME(AcroForm));
+		js->form = pdf_dict_get(acroform, PDF_NAME(Fields));
 
 		/* Initialise the javascript engine, passing the main context
 		 * for use in memory allocation and exception handling. Also
@@ -839,7 +839,7 @@ static void pdf_js_load_document_level(pdf_js *js)
 		for (i = 0; i < len; i++)
 		{
 			pdf_obj *fragment = pdf_dict_get_val(javascript, i);
-			pdf_obj *code = pdf_dict_gets(fragment, "JS");
+			pdf_obj *code = pdf_dict_get(fragment, PDF_NAME(JS));
 
 			fz_var(codebuf);
 			fz_try(ctx)
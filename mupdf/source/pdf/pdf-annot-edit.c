@@ -48,8 +48,8 @@ pdf_update_annot(pdf_document *doc, pdf_annot *annot)
 
 	obj = annot->obj;
 
-	ap = pdf_dict_gets(obj, "AP");
-	as = pdf_dict_gets(obj, "AS");
+	ap = pdf_dict_get(obj, PDF_NAME(AP));
+	as = pdf_dict_get(obj, PDF_NAME(AS));
 
 	if (pdf_is_dict(ap))
 	{
@@ -61,11 +61,11 @@ pdf_update_annot(pdf_document *doc, pdf_annot *annot)
 			&& hp->gen == pdf_to_gen(obj)
 			&& (hp->state & HOTSPOT_POINTER_DOWN))
 		{
-			n = pdf_dict_gets(ap, "D"); /* down state */
+			n = pdf_dict_get(ap, PDF_NAME(D)); /* down state */
 		}
 
 		if (n == NULL)
-			n = pdf_dict_gets(ap, "N"); /* normal state */
+			n = pdf_dict_get(ap, PDF_NAME(N)); /* normal state */
 
 		/* lookup current state in sub-dictionary */
 		if (!pdf_is_stream(doc, pdf_to_num(n), pdf_to_gen(n)))
@@ -107,20 +107,20 @@ pdf_create_annot(pdf_document *doc, pdf_page *page, fz_annot_type type)
 		int ind_obj_num;
 		fz_rect rect = {0.0, 0.0, 0.0, 0.0};
 		const char *type_str = annot_type_str(type);
-		pdf_obj *annot_arr = pdf_dict_gets(page->me, "Annots");
+		pdf_obj *annot_arr = pdf_dict_get(page->me, PDF_NAME(Annots));
 		if (annot_arr == NULL)
 		{
 			annot_arr = pdf_new_array(doc, 0);
-			pdf_dict_puts_drop(page->me, "Annots", annot_arr);
+			pdf_dict_put_drop(page->me, PDF_NAME(Annots), annot_arr);
 		}
 
-		pdf_dict_puts_drop(annot_obj, "Type", pdf_new_name(doc, "Annot"));
+		pdf_dict_put_drop(annot_obj, PDF_NAME(Type), pdf_new_name(doc, "Annot"));
 
-		pdf_dict_puts_drop(annot_obj, "Subtype", pdf_new_name(doc, type_str));
-		pdf_dict_puts_drop(annot_obj, "Rect", pdf_new_rect(doc, &rect));
+		pdf_dict_put_drop(annot_obj, PDF_NAME(Subtype), pdf_new_name(doc, type_str));
+		pdf_dict_put_drop(annot_obj, PDF_NAME(Rect), pdf_new_rect(doc, &rect));
 
 		/* Make printable as default */
-		pdf_dict_puts_drop(annot_obj, "F", pdf_new_int(doc, F_Print));
+		pdf_dict_put_drop(annot_obj, PDF_NAME(F), pdf_new_int(doc, F_Print));
 
 		annot = fz_malloc_struct(ctx, pdf_annot);
 		annot->page = page;
@@ -200,7 +200,7 @@ pdf_delete_annot(pdf_document *doc, pdf_page *page, pdf_annot *annot)
 	annot->ap = NULL;
 
 	/* Recreate the "Annots" array with this annot removed */
-	old_annot_arr = pdf_dict_gets(page->me, "Annots");
+	old_annot_arr = pdf_dict_get(page->me, PDF_NAME(Annots));
 
 	if (old_annot_arr)
 	{
@@ -220,7 +220,7 @@ pdf_delete_annot(pdf_document *doc, pdf_page *page, pdf_annot *annot)
 			if (pdf_is_indirect(old_annot_arr))
 				pdf_update_object(doc, pdf_to_num(old_annot_arr), annot_arr);
 			else
-				pdf_dict_puts(page->me, "Annots", annot_arr);
+				pdf_dict_put(page->me, PDF_NAME(Annots), annot_arr);
 
 			if (pdf_is_indirect(annot->obj))
 				pdf_delete_object(doc, pdf_to_num(annot->obj));
@@ -249,7 +249,7 @@ pdf_set_markup_annot_quadpoints(pdf_document *doc, pdf_annot *annot, fz_point *q
 
 	fz_invert_matrix(&ctm, &annot->page->ctm);
 
-	pdf_dict_puts_drop(annot->obj, "QuadPoints", arr);
+	pdf_dict_put_drop(annot->obj, PDF_NAME(QuadPoints), arr);
 
 	for (i = 0; i < n; i++)
 	{
@@ -266,7 +266,7 @@ pdf_set_markup_annot_quadpoints(pdf_document *doc, pdf_annot *annot, fz_point *q
 
 static void update_rect(fz_context *ctx, pdf_annot *annot)
 {
-	pdf_to_rect(ctx, pdf_dict_gets(annot->obj, "Rect"), &annot->rect);
+	pdf_to_rect(ctx, pdf_dict_get(annot->obj, PDF_NAME(Rect)), &annot->rect);
 	annot->pagerect = annot->rect;
 	fz_transform_rect(&annot->pagerect, &annot->page->ctm);
 }
@@ -283,7 +283,7 @@ pdf_set_ink_annot_list(pdf_document *doc, pdf_annot *annot, fz_point *pts, int *
 
 	fz_invert_matrix(&ctm, &annot->page->ctm);
 
-	pdf_dict_puts_drop(annot->obj, "InkList", list);
+	pdf_dict_put_drop(annot->obj, PDF_NAME(InkList), list);
 
 	for (i = 0; i < ncount; i++)
 	{
@@ -327,15 +327,15 @@ pdf_set_ink_annot_list(pdf_document *doc, pdf_annot *annot, fz_point *pts, int *
 		rect.y1 += thickness;
 	}
 
-	pdf_dict_puts_drop(annot->obj, "Rect", pdf_new_rect(doc, &rect));
+	pdf_dict_put_drop(annot->obj, PDF_NAME(Rect), pdf_new_rect(doc, &rect));
 	update_rect(ctx, annot);
 
 	bs = pdf_new_dict(doc, 1);
-	pdf_dict_puts_drop(annot->obj, "BS", bs);
-	pdf_dict_puts_drop(bs, "W", pdf_new_real(doc, thickness));
+	pdf_dict_put_drop(annot->obj, PDF_NAME(BS), bs);
+	pdf_dict_put_drop(bs, PDF_NAME(W), pdf_new_real(doc, thickness));
 
 	col = pdf_new_array(doc, 3);
-	pdf_dict_puts_drop(annot->obj, "C", col);
+	pdf_dict_put_drop(annot->obj, PDF_NAME(C), col);
 	for (i = 0; i < 3; i++)
 		pdf_array_push_drop(col, pdf_new_real(doc, color[i]));
 }
@@ -367,18 +367,18 @@ void pdf_set_text_annot_position(pdf_document *doc, pdf_annot *annot, fz_point p
 	rect.y1 = pt.y + TEXT_ANNOT_SIZE;
 	fz_transform_rect(&rect, &ctm);
 
-	pdf_dict_puts_drop(annot->obj, "Rect", pdf_new_rect(doc, &rect));
+	pdf_dict_put_drop(annot->obj, PDF_NAME(Rect), pdf_new_rect(doc, &rect));
 
-	flags = pdf_to_int(pdf_dict_gets(annot->obj, "F"));
+	flags = pdf_to_int(pdf_dict_get(annot->obj, PDF_NAME(F)));
 	flags |= (F_NoZoom|F_NoRotate);
-	pdf_dict_puts_drop(annot->obj, "F", pdf_new_int(doc, flags));
+	pdf_dict_put_drop(annot->obj, PDF_NAME(F), pdf_new_int(doc, flags));
 
 	update_rect(doc->ctx, annot);
 }
 
 void pdf_set_annot_contents(pdf_document *doc, pdf_annot *annot, char *text)
 {
-	pdf_dict_puts_drop(annot->obj, "Contents", pdf_new_string(doc, text, strlen(text)));
+	pdf_dict_put_drop(annot->obj, PDF_NAME(Contents), pdf_new_string(doc, text, strlen(text)));
 }
 
 char *pdf_annot_contents(pdf_document *doc, pdf_annot *annot)
@@ -402,7 +402,7 @@ void pdf_set_free_text_details(pdf_document *doc, pdf_annot *annot, fz_point *po
 
 	fz_invert_matrix(&ctm, &annot->page->ctm);
 
-	dr = pdf_dict_gets(annot->page->me, "Resources");
+	dr = pdf_dict_get(annot->page->me, PDF_NAME(Resources));
 	if (!dr)
 	{
 		dr = pdf_new_dict(doc, 1);
@@ -410,11 +410,11 @@ void pdf_set_free_text_details(pdf_document *doc, pdf_annot *annot, fz_point *po
 	}
 
 	/* Ensure the resource dictionary includes a font dict */
-	form_fonts = pdf_dict_gets(dr, "Font");
+	form_fonts = pdf_dict_get(dr, PDF_NAME(Font));
 	if (!form_fonts)
 	{
 		form_fonts = pdf_new_dict(doc, 1);
-		pdf_dict_puts_drop(dr, "Font", form_fonts);
+		pdf_dict_put_drop(dr, PDF_NAME(Font), form_fonts);
 		/* form_fonts is still valid if execution continues past the above call */
 	}
 
@@ -432,10 +432,10 @@ void pdf_set_free_text_details(pdf_document *doc, pdf_annot *annot, fz_point *po
 		ref = pdf_new_ref(doc, font);
 		pdf_dict_puts_drop(form_fonts, nbuf, ref);
 
-		pdf_dict_puts_drop(font, "Type", pdf_new_name(doc, "Font"));
-		pdf_dict_puts_drop(font, "Subtype", pdf_new_name(doc, "Type1"));
-		pdf_dict_puts_drop(font, "BaseFont", pdf_new_name(doc, font_name));
-		pdf_dict_puts_drop(font, "Encoding", pdf_new_name(doc, "WinAnsiEncoding"));
+		pdf_dict_put_drop(font, PDF_NAME(Type), pdf_new_name(doc, "Font"));
+		pdf_dict_put_drop(font, PDF_NAME(Subtype), pdf_new_name(doc, "Type1"));
+		pdf_dict_put_drop(font, PDF_NAME(BaseFont), pdf_new_name(doc, font_name));
+		pdf_dict_put_drop(font, PDF_NAME(Encoding), pdf_new_name(doc, "WinAnsiEncoding"));
 
 		memcpy(da_info.col, color, sizeof(float)*3);
 		da_info.col_size = 3;
@@ -446,10 +446,10 @@ void pdf_set_free_text_details(pdf_document *doc, pdf_annot *annot, fz_point *po
 		pdf_fzbuf_print_da(ctx, fzbuf, &da_info);
 
 		da_len = fz_buffer_storage(ctx, fzbuf, &da_str);
-		pdf_dict_puts_drop(annot->obj, "DA", pdf_new_string(doc, (char *)da_str, da_len));
+		pdf_dict_put_drop(annot->obj, PDF_NAME(DA), pdf_new_string(doc, (char *)da_str, da_len));
 
 		/* FIXME: should convert to WinAnsiEncoding */
-		pdf_dict_puts_drop(annot->obj, "Contents", pdf_new_string(doc, text, strlen(text)));
+		pdf_dict_put_drop(annot->obj, PDF_NAME(Contents), pdf_new_string(doc, text, strlen(text)));
 
 		font_desc = pdf_load_font(doc, NULL, font, 0);
 		pdf_measure_text(ctx, font_desc, (unsigned char *)text, strlen(text), &bounds);
@@ -467,7 +467,7 @@ void pdf_set_free_text_details(pdf_document *doc, pdf_annot *annot, fz_point *po
 		bounds.y0 += page_pos.y;
 		bounds.y1 += page_pos.y;
 
-		pdf_dict_puts_drop(annot->obj, "Rect", pdf_new_rect(doc, &bounds));
+		pdf_dict_put_drop(annot->obj, PDF_NAME(Rect), pdf_new_rect(doc, &bounds));
 		update_rect(ctx, annot);
 	}
 	fz_always(ctx)
@@ -24,7 +24,7 @@ resolve_dest_rec(pdf_document *doc, pdf_obj *dest, fz_link_kind kind, int depth)
 
 	else if (pdf_is_dict(dest))
 	{
-		dest = pdf_dict_gets(dest, "D");
+		dest = pdf_dict_get(dest, PDF_NAME(D));
 		return resolve_dest_rec(doc, dest, kind, depth+1);
 	}
 
@@ -235,19 +235,19 @@ pdf_file_spec_to_str(pdf_document *doc, pdf_obj *file_spec)
 	else if (pdf_is_dict(file_spec))
 	{
 #ifdef _WIN32
-		obj = pdf_dict_gets(file_spec, "DOS");
+		obj = pdf_dict_get(file_spec, PDF_NAME(DOS));
 #else
-		obj = pdf_dict_gets(file_spec, "Unix");
+		obj = pdf_dict_get(file_spec, PDF_NAME(Unix));
 #endif
 		if (!obj)
-			obj = pdf_dict_getsa(file_spec, "UF", "F");
+			obj = pdf_dict_geta(file_spec, PDF_NAME(UF), PDF_NAME(F));
 	}
 	if (!pdf_is_string(obj))
 		return NULL;
 
 	path = pdf_to_utf8(doc, obj);
 #ifdef _WIN32
-	if (strcmp(pdf_to_name(pdf_dict_gets(file_spec, "FS")), "URL") != 0)
+	if (strcmp(pdf_to_name(pdf_dict_get(file_spec, PDF_NAME(FS))), "URL") != 0)
 	{
 		/* move the file name into the expected place and use the expected path separator */
 		if (path[0] == '/' && (('A' <= path[1] && path[1] <= 'Z') || ('a' <= path[1] && path[1] <= 'z')) && path[2] == '/')
@@ -275,15 +275,15 @@ pdf_parse_file_spec(pdf_document *doc, pdf_obj *file_spec)
 		return pdf_to_utf8(doc, file_spec);
 
 	if (pdf_is_dict(file_spec)) {
-		filename = pdf_dict_gets(file_spec, "UF");
+		filename = pdf_dict_get(file_spec, PDF_NAME(UF));
 		if (!filename)
-			filename = pdf_dict_gets(file_spec, "F");
+			filename = pdf_dict_get(file_spec, PDF_NAME(F));
 		if (!filename)
-			filename = pdf_dict_gets(file_spec, "Unix");
+			filename = pdf_dict_get(file_spec, PDF_NAME(Unix));
 		if (!filename)
-			filename = pdf_dict_gets(file_spec, "Mac");
+			filename = pdf_dict_get(file_spec, PDF_NAME(Mac));
 		if (!filename)
-			filename = pdf_dict_gets(file_spec, "DOS");
+			filename = pdf_dict_get(file_spec, PDF_NAME(DOS));
 
 		return pdf_to_utf8(doc, filename);
 	}
@@ -306,55 +306,55 @@ pdf_parse_action(pdf_document *doc, pdf_obj *action)
 	if (!action)
 		return ld;
 
-	obj = pdf_dict_gets(action, "S");
-	if (!strcmp(pdf_to_name(obj), "GoTo"))
+	obj = pdf_dict_get(action, PDF_NAME(S));
+	if (pdf_name_eq(obj, PDF_NAME(GoTo)))
 	{
-		dest = pdf_dict_gets(action, "D");
+		dest = pdf_dict_get(action, PDF_NAME(D));
 		ld = pdf_parse_link_dest(doc, FZ_LINK_GOTO, dest);
 	}
-	else if (!strcmp(pdf_to_name(obj), "URI"))
+	else if (pdf_name_eq(obj, PDF_NAME(URI)))
 	{
 		ld.kind = FZ_LINK_URI;
-		ld.ld.uri.is_map = pdf_to_bool(pdf_dict_gets(action, "IsMap"));
-		ld.ld.uri.uri = pdf_to_utf8(doc, pdf_dict_gets(action, "URI"));
+		ld.ld.uri.is_map = pdf_to_bool(pdf_dict_get(action, PDF_NAME(IsMap)));
+		ld.ld.uri.uri = pdf_to_utf8(doc, pdf_dict_get(action, PDF_NAME(URI)));
 	}
-	else if (!strcmp(pdf_to_name(obj), "Launch"))
+	else if (pdf_name_eq(obj, PDF_NAME(Launch)))
 	{
 		ld.kind = FZ_LINK_LAUNCH;
-		file_spec = pdf_dict_gets(action, "F");
+		file_spec = pdf_dict_get(action, PDF_NAME(F));
 		/* SumatraPDF: parse full file specifications */
 		ld.ld.launch.file_spec = pdf_file_spec_to_str(doc, file_spec);
-		ld.ld.launch.new_window = pdf_to_int(pdf_dict_gets(action, "NewWindow"));
+		ld.ld.launch.new_window = pdf_to_int(pdf_dict_get(action, PDF_NAME(NewWindow)));
 		/* SumatraPDF: support launching embedded files */
 #ifdef _WIN32
-		obj = pdf_dict_getsa(pdf_dict_gets(file_spec, "EF"), "DOS", "F");
+		obj = pdf_dict_geta(pdf_dict_get(file_spec, PDF_NAME(EF)), PDF_NAME(DOS), PDF_NAME(F));
 #else
-		obj = pdf_dict_getsa(pdf_dict_gets(file_spec, "EF"), "Unix", "F");
+		obj = pdf_dict_geta(pdf_dict_get(file_spec, PDF_NAME(EF)), PDF_NAME(Unix), PDF_NAME(F));
 #endif
 		ld.ld.launch.embedded_num = pdf_to_num(obj);
 		ld.ld.launch.embedded_gen = pdf_to_gen(obj);
 		/* SumatraPDF: support URL /Filespec */
-		ld.ld.launch.is_uri = !obj && !strcmp(pdf_to_name(pdf_dict_gets(file_spec, "FS")), "URL");
+		ld.ld.launch.is_uri = !obj && pdf_name_eq(pdf_dict_get(file_spec, PDF_NAME(FS)), PDF_NAME(URL));
 	}
-	else if (!strcmp(pdf_to_name(obj), "Named"))
+	else if (pdf_name_eq(obj, PDF_NAME(Named)))
 	{
 		ld.kind = FZ_LINK_NAMED;
-		ld.ld.named.named = fz_strdup(ctx, pdf_to_name(pdf_dict_gets(action, "N")));
+		ld.ld.named.named = fz_strdup(ctx, pdf_to_name(pdf_dict_get(action, PDF_NAME(N))));
 	}
-	else if (!strcmp(pdf_to_name(obj), "GoToR"))
+	else if (pdf_name_eq(obj, PDF_NAME(GoToR)))
 	{
-		dest = pdf_dict_gets(action, "D");
-		file_spec = pdf_dict_gets(action, "F");
+		dest = pdf_dict_get(action, PDF_NAME(D));
+		file_spec = pdf_dict_get(action, PDF_NAME(F));
 		ld = pdf_parse_link_dest(doc, FZ_LINK_GOTOR, dest);
 		/* SumatraPDF: parse full file specifications */
 		ld.ld.gotor.file_spec = pdf_file_spec_to_str(doc, file_spec);
-		ld.ld.gotor.new_window = pdf_to_int(pdf_dict_gets(action, "NewWindow"));
+		ld.ld.gotor.new_window = pdf_to_int(pdf_dict_get(action, PDF_NAME(NewWindow)));
 	}
 	/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=2117 */
-	else if (!strcmp(pdf_to_name(obj), "JavaScript"))
+	else if (pdf_name_eq(obj, PDF_NAME(JavaScript)))
 	{
 		/* hackily extract the first URL the JavaScript action might open */
-		char *js = pdf_to_utf8(doc, pdf_dict_gets(action, "JS"));
+		char *js = pdf_to_utf8(doc, pdf_dict_get(action, PDF_NAME(JS)));
 		char *url = strstr(js, "getURL(\"");
 		if (url && strchr(url + 8, '"'))
 		{
@@ -378,7 +378,7 @@ pdf_load_link(pdf_document *doc, pdf_obj *dict, const fz_matrix *page_ctm)
 	fz_context *ctx = doc->ctx;
 	fz_link_dest ld;
 
-	obj = pdf_dict_gets(dict, "Rect");
+	obj = pdf_dict_get(dict, PDF_NAME(Rect));
 	if (obj)
 		pdf_to_rect(ctx, obj, &bbox);
 	else
@@ -386,36 +386,36 @@ pdf_load_link(pdf_document *doc, pdf_obj *dict, const fz_matrix *page_ctm)
 
 	fz_transform_rect(&bbox, page_ctm);
 
-	obj = pdf_dict_gets(dict, "Dest");
+	obj = pdf_dict_get(dict, PDF_NAME(Dest));
 	if (obj)
 		ld = pdf_parse_link_dest(doc, FZ_LINK_GOTO, obj);
 	else
 	{
-		action = pdf_dict_gets(dict, "A");
+		action = pdf_dict_get(dict, PDF_NAME(A));
 		/* fall back to additional action button's down/up action */
 		if (!action)
-			action = pdf_dict_getsa(pdf_dict_gets(dict, "AA"), "U", "D");
+			action = pdf_dict_geta(pdf_dict_get(dict, PDF_NAME(AA)), PDF_NAME(U), PDF_NAME(D));
 
 		ld = pdf_parse_action(doc, action);
 	}
 	/* support clicking on embedded Flash movies, etc. (PDF 1.7 ExtensionLevel 3) */
 	if (!obj && !action && (obj = pdf_dict_getp(dict, "RichMediaContent/Configurations")) != NULL)
 	{
-		obj = pdf_dict_gets(pdf_array_get(obj, 0), "Instances");
-		action = pdf_dict_gets(pdf_array_get(obj, 0), "Asset");
+		obj = pdf_dict_get(pdf_array_get(obj, 0), PDF_NAME(Instances));
+		action = pdf_dict_get(pdf_array_get(obj, 0), PDF_NAME(Asset));
 		if (action)
 		{
 			ld.kind = FZ_LINK_LAUNCH;
 			ld.ld.launch.file_spec = pdf_file_spec_to_str(doc, action);
 			ld.ld.launch.new_window = 1;
 #ifdef _WIN32
-			obj = pdf_dict_getsa(pdf_dict_gets(action, "EF"), "DOS", "F");
+			obj = pdf_dict_geta(pdf_dict_get(action, PDF_NAME(EF)), PDF_NAME(DOS), PDF_NAME(F));
 #else
-			obj = pdf_dict_getsa(pdf_dict_gets(action, "EF"), "Unix", "F");
+			obj = pdf_dict_geta(pdf_dict_get(action, PDF_NAME(EF)), PDF_NAME(Unix), PDF_NAME(F));
 #endif
 			ld.ld.launch.embedded_num = pdf_to_num(obj);
 			ld.ld.launch.embedded_gen = pdf_to_gen(obj);
-			ld.ld.launch.is_uri = !obj && !strcmp(pdf_to_name(pdf_dict_gets(action, "FS")), "URL");
+			ld.ld.launch.is_uri = !obj && pdf_name_eq(pdf_dict_get(action, PDF_NAME(FS)), PDF_NAME(URL));
 		}
 	}
 	if (ld.kind == FZ_LINK_NONE)
@@ -503,7 +503,7 @@ pdf_transform_annot(pdf_annot *annot)
 
 fz_annot_type pdf_annot_obj_type(pdf_obj *obj)
 {
-	char *subtype = pdf_to_name(pdf_dict_gets(obj, "Subtype"));
+	char *subtype = pdf_to_name(pdf_dict_get(obj, PDF_NAME(Subtype)));
 	if (!strcmp(subtype, "Text"))
 		return FZ_ANNOT_TEXT;
 	else if (!strcmp(subtype, "Link"))
@@ -625,7 +625,7 @@ pdf_clone_for_view_only(pdf_document *doc, pdf_obj *obj)
 
 	fz_try(ctx)
 	{
-		pdf_dict_puts_drop(obj, "OC", pdf_new_obj_from_str(doc, ANNOT_OC_VIEW_ONLY));
+		pdf_dict_put_drop(obj, PDF_NAME(OC), pdf_new_obj_from_str(doc, ANNOT_OC_VIEW_ONLY));
 	}
 	fz_catch(ctx)
 	{
@@ -639,7 +639,7 @@ static void
 pdf_get_annot_color(pdf_obj *obj, float rgb[3])
 {
 	int k;
-	obj = pdf_dict_gets(obj, "C");
+	obj = pdf_dict_get(obj, PDF_NAME(C));
 	for (k = 0; k < 3; k++)
 		rgb[k] = pdf_to_real(pdf_array_get(obj, k));
 }
@@ -658,7 +658,7 @@ pdf_create_link_annot(pdf_document *doc, pdf_obj *obj)
 
 	fz_var(content);
 
-	border = pdf_dict_gets(obj, "Border");
+	border = pdf_dict_get(obj, PDF_NAME(Border));
 	border_width = pdf_to_real(pdf_array_get(border, 2));
 	dashes = pdf_array_get(border, 3);
 
@@ -671,7 +671,7 @@ pdf_create_link_annot(pdf_document *doc, pdf_obj *obj)
 	}
 
 	pdf_get_annot_color(obj, rgb);
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
 
 	fz_try(ctx)
 	{
@@ -778,8 +778,8 @@ pdf_create_text_annot(pdf_document *doc, pdf_obj *obj)
 
 	fz_var(content);
 
-	icon_name = pdf_to_name(pdf_dict_gets(obj, "Name"));
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
+	icon_name = pdf_to_name(pdf_dict_get(obj, PDF_NAME(Name)));
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
 	rect.x1 = rect.x0 + 24;
 	rect.y0 = rect.y1 - 24;
 	pdf_get_annot_color(obj, rgb);
@@ -874,8 +874,8 @@ pdf_create_file_annot(pdf_document *doc, pdf_obj *obj)
 
 	fz_var(content);
 
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
-	icon_name = pdf_to_name(pdf_dict_gets(obj, "Name"));
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
+	icon_name = pdf_to_name(pdf_dict_get(obj, PDF_NAME(Name)));
 	pdf_get_annot_color(obj, rgb);
 
 	if (!strcmp(icon_name, "Graph"))
@@ -952,8 +952,8 @@ pdf_create_highlight_annot(pdf_document *doc, pdf_obj *obj)
 
 	fz_var(content);
 
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
-	quad_points = pdf_dict_gets(obj, "QuadPoints");
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
+	quad_points = pdf_dict_get(obj, PDF_NAME(QuadPoints));
 	for (i = 0, n = pdf_array_len(quad_points) / 8; i < n; i++)
 	{
 		pdf_get_quadrilaterals(quad_points, i, &a, &b);
@@ -1008,8 +1008,8 @@ pdf_create_markup_annot(pdf_document *doc, pdf_obj *obj, char *type)
 	fz_var(content);
 
 	annot_type = !strcmp(type, "Underline") ? FZ_ANNOT_UNDERLINE : !strcmp(type, "StrikeOut") ? FZ_ANNOT_STRIKEOUT : FZ_ANNOT_SQUIGGLY;
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
-	quad_points = pdf_dict_gets(obj, "QuadPoints");
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
+	quad_points = pdf_dict_get(obj, PDF_NAME(QuadPoints));
 	for (i = 0, n = pdf_array_len(quad_points) / 8; i < n; i++)
 	{
 		pdf_get_quadrilaterals(quad_points, i, &a, &b);
@@ -1067,9 +1067,9 @@ pdf_dict_get_inheritable(pdf_document *doc, pdf_obj *obj, char *key)
 		pdf_obj *val = pdf_dict_gets(obj, key);
 		if (val)
 			return val;
-		obj = pdf_dict_gets(obj, "Parent");
+		obj = pdf_dict_get(obj, PDF_NAME(Parent));
 	}
-	return pdf_dict_gets(pdf_dict_gets(pdf_dict_gets(pdf_trailer(doc), "Root"), "AcroForm"), key);
+	return pdf_dict_gets(pdf_dict_get(pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)), PDF_NAME(AcroForm)), key);
 }
 
 static float
@@ -1126,13 +1126,13 @@ pdf_extract_font_size(pdf_document *doc, char *appearance, char **font_name)
 static pdf_obj *
 pdf_get_ap_stream(pdf_document *doc, pdf_obj *obj)
 {
-	pdf_obj *ap = pdf_dict_gets(obj, "AP");
+	pdf_obj *ap = pdf_dict_get(obj, PDF_NAME(AP));
 	if (!pdf_is_dict(ap))
 		return NULL;
 
-	ap = pdf_dict_gets(ap, "N");
+	ap = pdf_dict_get(ap, PDF_NAME(N));
 	if (!pdf_is_stream(doc, pdf_to_num(ap), pdf_to_gen(ap)))
-		ap = pdf_dict_get(ap, pdf_dict_gets(obj, "AS"));
+		ap = pdf_dict_get(ap, pdf_dict_get(obj, PDF_NAME(AS)));
 	if (!pdf_is_stream(doc, pdf_to_num(ap), pdf_to_gen(ap)))
 		return NULL;
 
@@ -1313,7 +1313,7 @@ pdf_update_tx_widget_annot(pdf_document *doc, pdf_obj *obj)
 	fz_var(font_name);
 	fz_var(ucs2);
 
-	if (strcmp(pdf_to_name(pdf_dict_gets(obj, "Subtype")), "Widget") != 0)
+	if (strcmp(pdf_to_name(pdf_dict_get(obj, PDF_NAME(Subtype))), "Widget") != 0)
 		return NULL;
 	if (!pdf_to_bool(pdf_dict_get_inheritable(doc, NULL, "NeedAppearances")) && pdf_get_ap_stream(doc, obj))
 		return NULL;
@@ -1327,15 +1327,15 @@ pdf_update_tx_widget_annot(pdf_document *doc, pdf_obj *obj)
 		return NULL;
 
 	res = pdf_dict_get_inheritable(doc, obj, "DR");
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
-	rotate = pdf_to_int(pdf_dict_gets(pdf_dict_gets(obj, "MK"), "R"));
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
+	rotate = pdf_to_int(pdf_dict_get(pdf_dict_get(obj, PDF_NAME(MK)), PDF_NAME(R)));
 	fz_transform_rect(&rect, fz_rotate(&ctm, rotate));
 
-	flags = pdf_to_int(pdf_dict_gets(obj, "Ff"));
+	flags = pdf_to_int(pdf_dict_get(obj, PDF_NAME(Ff)));
 	is_multiline = (flags & (1 << 12)) != 0;
 	if ((flags & (1 << 25) /* richtext */))
 		fz_warn(ctx, "missing support for richtext fields");
-	align = pdf_to_int(pdf_dict_gets(obj, "Q"));
+	align = pdf_to_int(pdf_dict_get(obj, PDF_NAME(Q)));
 
 	font_size = pdf_extract_font_size(doc, pdf_to_str_buf(ap), &font_name);
 	if (!font_size || !font_name)
@@ -1353,7 +1353,7 @@ pdf_update_tx_widget_annot(pdf_document *doc, pdf_obj *obj)
 		if (font_name)
 		{
 			pdf_font_desc *fontdesc = NULL;
-			pdf_obj *font_obj = pdf_dict_gets(pdf_dict_gets(res, "Font"), font_name);
+			pdf_obj *font_obj = pdf_dict_gets(pdf_dict_get(res, PDF_NAME(Font)), font_name);
 			if (font_obj)
 			{
 				fz_try(ctx)
@@ -1366,13 +1366,13 @@ pdf_update_tx_widget_annot(pdf_document *doc, pdf_obj *obj)
 				}
 			}
 			/* TODO: try to reverse the encoding instead of replacing the font */
-			if (fontdesc && fontdesc->cid_to_gid && !fontdesc->cid_to_ucs || !fontdesc && pdf_dict_gets(res, "Font"))
+			if (fontdesc && fontdesc->cid_to_gid && !fontdesc->cid_to_ucs || !fontdesc && pdf_dict_get(res, PDF_NAME(Font)))
 			{
 				pdf_obj *new_font = pdf_new_obj_from_str(doc, "<< /Type /Font /BaseFont /Helvetica /Subtype /Type1 >>");
 				fz_free(ctx, font_name);
 				font_name = NULL;
 				font_name = fz_strdup(ctx, "Default");
-				pdf_dict_puts_drop(pdf_dict_gets(res, "Font"), font_name, new_font);
+				pdf_dict_puts_drop(pdf_dict_get(res, PDF_NAME(Font)), font_name, new_font);
 			}
 			pdf_drop_font(ctx, fontdesc);
 			fontdesc = NULL;
@@ -1435,8 +1435,8 @@ pdf_create_freetext_annot(pdf_document *doc, pdf_obj *obj)
 	fz_context *ctx = doc->ctx;
 	fz_buffer *content = NULL, *base_ap = NULL;
 	pdf_obj *ap = pdf_dict_get_inheritable(doc, obj, "DA");
-	pdf_obj *value = pdf_dict_gets(obj, "Contents");
-	int align = pdf_to_int(pdf_dict_gets(obj, "Q"));
+	pdf_obj *value = pdf_dict_get(obj, PDF_NAME(Contents));
+	int align = pdf_to_int(pdf_dict_get(obj, PDF_NAME(Q)));
 	pdf_obj *res = pdf_new_obj_from_str(doc, ANNOT_FREETEXT_AP_RESOURCES);
 	unsigned short *ucs2 = NULL, *rest;
 	fz_rect rect;
@@ -1445,7 +1445,7 @@ pdf_create_freetext_annot(pdf_document *doc, pdf_obj *obj)
 
 	char *font_name = NULL;
 	float font_size = pdf_extract_font_size(doc, pdf_to_str_buf(ap), &font_name);
-	pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), &rect);
+	pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), &rect);
 
 	fz_var(content);
 	fz_var(base_ap);
@@ -1461,8 +1461,8 @@ pdf_create_freetext_annot(pdf_document *doc, pdf_obj *obj)
 		/* TODO: what resource dictionary does this font name refer to? */
 		if (font_name)
 		{
-			pdf_obj *font = pdf_dict_gets(res, "Font");
-			pdf_dict_puts(font, font_name, pdf_dict_gets(font, "Default"));
+			pdf_obj *font = pdf_dict_get(res, PDF_NAME(Font));
+			pdf_dict_puts(font, font_name, pdf_dict_get(font, PDF_NAME(Default)));
 			fz_free(ctx, font_name);
 		}
 
@@ -1513,7 +1513,7 @@ pdf_create_freetext_annot(pdf_document *doc, pdf_obj *obj)
 static pdf_annot *
 pdf_create_annot_with_appearance(pdf_document *doc, pdf_obj *obj)
 {
-	char *type = pdf_to_name(pdf_dict_gets(obj, "Subtype"));
+	char *type = pdf_to_name(pdf_dict_get(obj, PDF_NAME(Subtype)));
 
 	if (!strcmp(type, "Link"))
 		return pdf_create_link_annot(doc, obj);
@@ -1612,9 +1612,9 @@ pdf_load_annots(pdf_document *doc, pdf_page *page, pdf_obj *annots)
 				doc->update_appearance(doc, annot);
 
 			obj = annot->obj;
-			rect = pdf_dict_gets(obj, "Rect");
-			ap = pdf_dict_gets(obj, "AP");
-			as = pdf_dict_gets(obj, "AS");
+			rect = pdf_dict_get(obj, PDF_NAME(Rect));
+			ap = pdf_dict_get(obj, PDF_NAME(AP));
+			as = pdf_dict_get(obj, PDF_NAME(AS));
 
 			/* We only collect annotations with an appearance
 			 * stream into this list, so remove any that don't
@@ -1627,11 +1627,11 @@ pdf_load_annots(pdf_document *doc, pdf_page *page, pdf_obj *annots)
 				&& hp->gen == pdf_to_gen(obj)
 				&& (hp->state & HOTSPOT_POINTER_DOWN))
 			{
-				n = pdf_dict_gets(ap, "D"); /* down state */
+				n = pdf_dict_get(ap, PDF_NAME(D)); /* down state */
 			}
 
 			if (n == NULL)
-				n = pdf_dict_gets(ap, "N"); /* normal state */
+				n = pdf_dict_get(ap, PDF_NAME(N)); /* normal state */
 
 			/* lookup current state in sub-dictionary */
 			if (!pdf_is_stream(doc, pdf_to_num(n), pdf_to_gen(n)))
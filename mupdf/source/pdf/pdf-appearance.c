@@ -165,7 +165,7 @@ static void get_font_info(pdf_document *doc, pdf_obj *dr, char *da, font_info *f
 	if (font_rec->da_rec.font_name == NULL)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "No font name in default appearance");
 
-	font_rec->font = font = pdf_load_font(doc, dr, pdf_dict_gets(pdf_dict_gets(dr, "Font"), font_rec->da_rec.font_name), 0);
+	font_rec->font = font = pdf_load_font(doc, dr, pdf_dict_gets(pdf_dict_get(dr, PDF_NAME(Font)), font_rec->da_rec.font_name), 0);
 	font_rec->lineheight = 1.0;
 	if (font && font->ascent != 0.0f && font->descent != 0.0f)
 		font_rec->lineheight = (font->ascent - font->descent) / 1000.0;
@@ -789,7 +789,7 @@ static int get_matrix(pdf_document *doc, pdf_xobject *form, int q, fz_matrix *mt
 		if (found)
 		{
 			fz_rect bbox;
-			pdf_to_rect(ctx, pdf_dict_gets(form->contents, "BBox"), &bbox);
+			pdf_to_rect(ctx, pdf_dict_get(form->contents, PDF_NAME(BBox)), &bbox);
 
 			switch (q)
 			{
@@ -944,17 +944,17 @@ static pdf_xobject *load_or_create_form(pdf_document *doc, pdf_obj *obj, fz_rect
 	fz_try(ctx)
 	{
 		rot = pdf_to_int(pdf_dict_getp(obj, "MK/R"));
-		pdf_to_rect(ctx, pdf_dict_gets(obj, "Rect"), rect);
+		pdf_to_rect(ctx, pdf_dict_get(obj, PDF_NAME(Rect)), rect);
 		rect->x1 -= rect->x0;
 		rect->y1 -= rect->y0;
 		rect->x0 = rect->y0 = 0;
 		account_for_rot(rect, &mat, rot);
 
-		ap = pdf_dict_gets(obj, "AP");
+		ap = pdf_dict_get(obj, PDF_NAME(AP));
 		if (ap == NULL)
 		{
 			ap = pdf_new_dict(doc, 1);
-			pdf_dict_puts_drop(obj, "AP", ap);
+			pdf_dict_put_drop(obj, PDF_NAME(AP), ap);
 		}
 
 		formobj = pdf_dict_gets(ap, dn);
@@ -1340,7 +1340,7 @@ void pdf_update_text_markup_appearance(pdf_document *doc, pdf_annot *annot, fz_a
 
 static void update_rect(fz_context *ctx, pdf_annot *annot)
 {
-	pdf_to_rect(ctx, pdf_dict_gets(annot->obj, "Rect"), &annot->rect);
+	pdf_to_rect(ctx, pdf_dict_get(annot->obj, PDF_NAME(Rect)), &annot->rect);
 	annot->pagerect = annot->rect;
 	fz_transform_rect(&annot->pagerect, &annot->page->ctm);
 }
@@ -1365,7 +1365,7 @@ void pdf_set_annot_appearance(pdf_document *doc, pdf_annot *annot, fz_rect *rect
 
 		fz_transform_rect(&trect, &ctm);
 
-		pdf_dict_puts_drop(obj, "Rect", pdf_new_rect(doc, &trect));
+		pdf_dict_put_drop(obj, PDF_NAME(Rect), pdf_new_rect(doc, &trect));
 
 		/* See if there is a current normal appearance */
 		ap_obj = pdf_dict_getp(obj, "AP/N");
@@ -1381,11 +1381,11 @@ void pdf_set_annot_appearance(pdf_document *doc, pdf_annot *annot, fz_rect *rect
 		{
 			pdf_xref_ensure_incremental_object(doc, pdf_to_num(ap_obj));
 			/* Update bounding box and matrix in reused xobject obj */
-			pdf_dict_puts_drop(ap_obj, "BBox", pdf_new_rect(doc, &trect));
-			pdf_dict_puts_drop(ap_obj, "Matrix", pdf_new_matrix(doc, &mat));
+			pdf_dict_put_drop(ap_obj, PDF_NAME(BBox), pdf_new_rect(doc, &trect));
+			pdf_dict_put_drop(ap_obj, PDF_NAME(Matrix), pdf_new_matrix(doc, &mat));
 		}
 
-		dev = pdf_new_pdf_device(doc, ap_obj, pdf_dict_gets(ap_obj, "Resources"), &mat);
+		dev = pdf_new_pdf_device(doc, ap_obj, pdf_dict_get(ap_obj, PDF_NAME(Resources)), &mat);
 		fz_run_display_list(disp_list, dev, &ctm, &fz_infinite_rect, NULL);
 		fz_free_device(dev);
 
@@ -1415,7 +1415,7 @@ static fz_point *
 quadpoints(pdf_document *doc, pdf_obj *annot, int *nout)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *quad = pdf_dict_gets(annot, "QuadPoints");
+	pdf_obj *quad = pdf_dict_get(annot, PDF_NAME(QuadPoints));
 	fz_point *qp = NULL;
 	int i, n;
 
@@ -1582,7 +1582,7 @@ void pdf_update_ink_appearance(pdf_document *doc, pdf_annot *annot)
 		int n, m, i, j;
 		int empty = 1;
 
-		cs = pdf_to_color(doc, pdf_dict_gets(annot->obj, "C"), color);
+		cs = pdf_to_color(doc, pdf_dict_get(annot->obj, PDF_NAME(C)), color);
 		if (!cs)
 		{
 			cs = fz_device_rgb(ctx);
@@ -1591,11 +1591,11 @@ void pdf_update_ink_appearance(pdf_document *doc, pdf_annot *annot)
 			color[2] = 0.0f;
 		}
 
-		width = pdf_to_real(pdf_dict_gets(pdf_dict_gets(annot->obj, "BS"), "W"));
+		width = pdf_to_real(pdf_dict_get(pdf_dict_get(annot->obj, PDF_NAME(BS)), PDF_NAME(W)));
 		if (width == 0.0f)
 			width = 1.0f;
 
-		list = pdf_dict_gets(annot->obj, "InkList");
+		list = pdf_dict_get(annot->obj, PDF_NAME(InkList));
 
 		n = pdf_array_len(list);
 
@@ -1872,7 +1872,7 @@ void pdf_update_text_annot_appearance(pdf_document *doc, pdf_annot *annot)
 		fz_rect bounds;
 		fz_matrix tm;
 
-		pdf_to_rect(ctx, pdf_dict_gets(annot->obj, "Rect"), &rect);
+		pdf_to_rect(ctx, pdf_dict_get(annot->obj, PDF_NAME(Rect)), &rect);
 		dlist = fz_new_display_list(ctx);
 		dev = fz_new_list_device(ctx, dlist);
 		stroke = fz_new_stroke_state(ctx);
@@ -1942,8 +1942,8 @@ void pdf_update_free_text_annot_appearance(pdf_document *doc, pdf_annot *annot)
 	fz_var(cs);
 	fz_try(ctx)
 	{
-		char *contents = pdf_to_str_buf(pdf_dict_gets(obj, "Contents"));
-		char *da = pdf_to_str_buf(pdf_dict_gets(obj, "DA"));
+		char *contents = pdf_to_str_buf(pdf_dict_get(obj, PDF_NAME(Contents)));
+		char *da = pdf_to_str_buf(pdf_dict_get(obj, PDF_NAME(DA)));
 		fz_rect rect = annot->rect;
 		fz_point pos;
 
@@ -2053,7 +2053,7 @@ static void insert_signature_appearance_layers(pdf_document *doc, pdf_annot *ann
 	fz_rect bbox;
 	fz_buffer *fzbuf = NULL;
 
-	pdf_to_rect(ctx, pdf_dict_gets(ap, "BBox"), &bbox);
+	pdf_to_rect(ctx, pdf_dict_get(ap, PDF_NAME(BBox)), &bbox);
 
 	fz_var(main_ap);
 	fz_var(frm);
@@ -2069,7 +2069,7 @@ static void insert_signature_appearance_layers(pdf_document *doc, pdf_annot *ann
 		fzbuf = fz_new_buffer(ctx, 8);
 		fz_buffer_printf(ctx, fzbuf, "/FRM Do");
 		pdf_update_stream(doc, pdf_to_num(main_ap), fzbuf);
-		pdf_dict_puts_drop(main_ap, "Length", pdf_new_int(doc, fzbuf->len));
+		pdf_dict_put_drop(main_ap, PDF_NAME(Length), pdf_new_int(doc, fzbuf->len));
 		fz_drop_buffer(ctx, fzbuf);
 		fzbuf = NULL;
 
@@ -2078,14 +2078,14 @@ static void insert_signature_appearance_layers(pdf_document *doc, pdf_annot *ann
 		fzbuf = fz_new_buffer(ctx, 8);
 		fz_buffer_printf(ctx, fzbuf, "q 1 0 0 1 0 0 cm /n0 Do Q q 1 0 0 1 0 0 cm /n2 Do Q");
 		pdf_update_stream(doc, pdf_to_num(frm), fzbuf);
-		pdf_dict_puts_drop(frm, "Length", pdf_new_int(doc, fzbuf->len));
+		pdf_dict_put_drop(frm, PDF_NAME(Length), pdf_new_int(doc, fzbuf->len));
 		fz_drop_buffer(ctx, fzbuf);
 		fzbuf = NULL;
 
 		fzbuf = fz_new_buffer(ctx, 8);
 		fz_buffer_printf(ctx, fzbuf, "%% DSBlank");
 		pdf_update_stream(doc, pdf_to_num(n0), fzbuf);
-		pdf_dict_puts_drop(n0, "Length", pdf_new_int(doc, fzbuf->len));
+		pdf_dict_put_drop(n0, PDF_NAME(Length), pdf_new_int(doc, fzbuf->len));
 		fz_drop_buffer(ctx, fzbuf);
 		fzbuf = NULL;
 
@@ -2134,7 +2134,7 @@ void pdf_set_signature_appearance(pdf_document *doc, pdf_annot *annot, char *nam
 	fz_var(fzbuf);
 	fz_try(ctx)
 	{
-		char *da = pdf_to_str_buf(pdf_dict_gets(obj, "DA"));
+		char *da = pdf_to_str_buf(pdf_dict_get(obj, PDF_NAME(DA)));
 		fz_rect rect = annot->rect;
 		fz_rect logo_bounds;
 		fz_matrix logo_tm;
@@ -2211,7 +2211,7 @@ void pdf_set_signature_appearance(pdf_document *doc, pdf_annot *annot, char *nam
 void pdf_update_appearance(pdf_document *doc, pdf_annot *annot)
 {
 	pdf_obj *obj = annot->obj;
-	if (!pdf_dict_gets(obj, "AP") || pdf_obj_is_dirty(obj))
+	if (!pdf_dict_get(obj, PDF_NAME(AP)) || pdf_obj_is_dirty(obj))
 	{
 		fz_annot_type type = pdf_annot_obj_type(obj);
 		switch (type)
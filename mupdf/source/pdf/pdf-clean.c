@@ -22,7 +22,7 @@ pdf_clean_stream_object(pdf_document *doc, pdf_obj *obj, pdf_obj *orig_res, fz_c
 	{
 		if (own_res)
 		{
-			pdf_obj *r = pdf_dict_gets(obj, "Resources");
+			pdf_obj *r = pdf_dict_get(obj, PDF_NAME(Resources));
 			if (r)
 				orig_res = r;
 		}
@@ -35,13 +35,13 @@ pdf_clean_stream_object(pdf_document *doc, pdf_obj *obj, pdf_obj *orig_res, fz_c
 		pdf_process_stream_object(doc, obj, &process, orig_res, cookie);
 
 		num = pdf_to_num(obj);
-		pdf_dict_dels(obj, "Filter");
+		pdf_dict_del(obj, PDF_NAME(Filter));
 		pdf_update_stream(doc, num, buffer);
 
 		if (own_res)
 		{
 			ref = pdf_new_ref(doc, res);
-			pdf_dict_puts(obj, "Resources", ref);
+			pdf_dict_put(obj, PDF_NAME(Resources), ref);
 		}
 	}
 	fz_always(ctx)
@@ -72,14 +72,14 @@ pdf_clean_type3(pdf_document *doc, pdf_obj *obj, pdf_obj *orig_res, fz_cookie *c
 
 	fz_try(ctx)
 	{
-		res = pdf_dict_gets(obj, "Resources");
+		res = pdf_dict_get(obj, PDF_NAME(Resources));
 		if (res)
 			orig_res = res;
 		res = NULL;
 
 		res = pdf_new_dict(doc, 1);
 
-		charprocs = pdf_dict_gets(obj, "CharProcs");
+		charprocs = pdf_dict_get(obj, PDF_NAME(CharProcs));
 		l = pdf_dict_len(charprocs);
 
 		for (i = 0; i < l; i++)
@@ -94,7 +94,7 @@ pdf_clean_type3(pdf_document *doc, pdf_obj *obj, pdf_obj *orig_res, fz_cookie *c
 			pdf_process_stream_object(doc, val, &process, orig_res, cookie);
 
 			num = pdf_to_num(val);
-			pdf_dict_dels(val, "Filter");
+			pdf_dict_del(val, PDF_NAME(Filter));
 			pdf_update_stream(doc, num, buffer);
 			pdf_dict_put(charprocs, key, val);
 			fz_drop_buffer(ctx, buffer);
@@ -102,10 +102,10 @@ pdf_clean_type3(pdf_document *doc, pdf_obj *obj, pdf_obj *orig_res, fz_cookie *c
 		}
 
 		/* ProcSet - no cleaning possible. Inherit this from the old dict. */
-		pdf_dict_puts(res, "ProcSet", pdf_dict_gets(orig_res, "ProcSet"));
+		pdf_dict_put(res, PDF_NAME(ProcSet), pdf_dict_get(orig_res, PDF_NAME(ProcSet)));
 
 		ref = pdf_new_ref(doc, res);
-		pdf_dict_puts(obj, "Resources", ref);
+		pdf_dict_put(obj, PDF_NAME(Resources), ref);
 	}
 	fz_always(ctx)
 	{
@@ -162,12 +162,12 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 			new_ref = pdf_new_ref(doc, new_obj);
 			num = pdf_to_num(new_ref);
 			pdf_array_put(contents, 0, new_ref);
-			pdf_dict_dels(new_obj, "Filter");
+			pdf_dict_del(new_obj, PDF_NAME(Filter));
 		}
 		else
 		{
 			num = pdf_to_num(contents);
-			pdf_dict_dels(contents, "Filter");
+			pdf_dict_del(contents, PDF_NAME(Filter));
 		}
 		pdf_update_stream(doc, num, buffer);
 
@@ -177,7 +177,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 		 * conceivably cause changes in rendering, but we don't care. */
 
 		/* ExtGState */
-		obj = pdf_dict_gets(res, "ExtGState");
+		obj = pdf_dict_get(res, PDF_NAME(ExtGState));
 		if (obj)
 		{
 			int i, l;
@@ -185,11 +185,11 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 			l = pdf_dict_len(obj);
 			for (i = 0; i < l; i++)
 			{
-				pdf_obj *o = pdf_dict_gets(pdf_dict_get_val(obj, i), "SMask");
+				pdf_obj *o = pdf_dict_get(pdf_dict_get_val(obj, i), PDF_NAME(SMask));
 
 				if (!o)
 					continue;
-				o = pdf_dict_gets(o, "G");
+				o = pdf_dict_get(o, PDF_NAME(G));
 				if (!o)
 					continue;
 
@@ -201,7 +201,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 		/* ColorSpace - no cleaning possible */
 
 		/* Pattern */
-		obj = pdf_dict_gets(res, "Pattern");
+		obj = pdf_dict_get(res, PDF_NAME(Pattern));
 		if (obj)
 		{
 			int i, l;
@@ -213,7 +213,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 
 				if (!pat)
 					continue;
-				if (pdf_to_int(pdf_dict_gets(pat, "PatternType")) == 1)
+				if (pdf_to_int(pdf_dict_get(pat, PDF_NAME(PatternType))) == 1)
 					pdf_clean_stream_object(doc, pat, page->resources, cookie, 0);
 			}
 		}
@@ -221,7 +221,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 		/* Shading - no cleaning possible */
 
 		/* XObject */
-		obj = pdf_dict_gets(res, "XObject");
+		obj = pdf_dict_get(res, PDF_NAME(XObject));
 		if (obj)
 		{
 			int i, l;
@@ -231,7 +231,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 			{
 				pdf_obj *xobj = pdf_dict_get_val(obj, i);
 
-				if (strcmp(pdf_to_name(pdf_dict_gets(xobj, "Subtype")), "Form"))
+				if (strcmp(pdf_to_name(pdf_dict_get(xobj, PDF_NAME(Subtype))), "Form"))
 					continue;
 
 				pdf_clean_stream_object(doc, xobj, page->resources, cookie, 1);
@@ -239,7 +239,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 		}
 
 		/* Font */
-		obj = pdf_dict_gets(res, "Font");
+		obj = pdf_dict_get(res, PDF_NAME(Font));
 		if (obj)
 		{
 			int i, l;
@@ -249,7 +249,7 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 			{
 				pdf_obj *o = pdf_dict_get_val(obj, i);
 
-				if (!strcmp(pdf_to_name(pdf_dict_gets(o, "Subtype")), "Type3"))
+				if (pdf_name_eq(pdf_dict_get(o, PDF_NAME(Subtype)), PDF_NAME(Type3)))
 				{
 					pdf_clean_type3(doc, o, page->resources, cookie);
 				}
@@ -257,16 +257,16 @@ void pdf_clean_page_contents(pdf_document *doc, pdf_page *page, fz_cookie *cooki
 		}
 
 		/* ProcSet - no cleaning possible. Inherit this from the old dict. */
-		obj = pdf_dict_gets(page->resources, "ProcSet");
+		obj = pdf_dict_get(page->resources, PDF_NAME(ProcSet));
 		if (obj)
-			pdf_dict_puts(res, "ProcSet", obj);
+			pdf_dict_put(res, PDF_NAME(ProcSet), obj);
 
 		/* Properties - no cleaning possible. */
 
 		pdf_drop_obj(page->resources);
 		ref = pdf_new_ref(doc, res);
 		page->resources = pdf_keep_obj(ref);
-		pdf_dict_puts(page->me, "Resources", ref);
+		pdf_dict_put(page->me, PDF_NAME(Resources), ref);
 	}
 	fz_always(ctx)
 	{
@@ -47,10 +47,10 @@ pdf_load_embedded_cmap(pdf_document *doc, pdf_obj *stmobj)
 		fz_close(file);
 		file = NULL;
 
-		wmode = pdf_dict_gets(stmobj, "WMode");
+		wmode = pdf_dict_get(stmobj, PDF_NAME(WMode));
 		if (pdf_is_int(wmode))
 			pdf_set_cmap_wmode(ctx, cmap, pdf_to_int(wmode));
-		obj = pdf_dict_gets(stmobj, "UseCMap");
+		obj = pdf_dict_get(stmobj, PDF_NAME(UseCMap));
 		if (pdf_is_name(obj))
 		{
 			usecmap = pdf_load_system_cmap(ctx, pdf_to_name(obj));
@@ -9,8 +9,8 @@ load_icc_based(pdf_document *doc, pdf_obj *dict)
 	pdf_obj *obj;
 	fz_context *ctx = doc->ctx;
 
-	n = pdf_to_int(pdf_dict_gets(dict, "N"));
-	obj = pdf_dict_gets(dict, "Alternate");
+	n = pdf_to_int(pdf_dict_get(dict, PDF_NAME(N)));
+	obj = pdf_dict_get(dict, PDF_NAME(Alternate));
 
 	if (obj)
 	{
@@ -198,20 +198,20 @@ send_image(pdf_device *pdev, fz_image *image, int mask, int smask)
 		pdev->images[num].ref = NULL; /* Will be filled in later */
 
 		imobj = pdf_new_dict(doc, 3);
-		pdf_dict_puts_drop(imobj, "Type", pdf_new_name(doc, "XObject"));
-		pdf_dict_puts_drop(imobj, "Subtype", pdf_new_name(doc, "Image"));
-		pdf_dict_puts_drop(imobj, "Width", pdf_new_int(doc, image->w));
-		pdf_dict_puts_drop(imobj, "Height", pdf_new_int(doc, image->h));
+		pdf_dict_put_drop(imobj, PDF_NAME(Type), pdf_new_name(doc, "XObject"));
+		pdf_dict_put_drop(imobj, PDF_NAME(Subtype), pdf_new_name(doc, "Image"));
+		pdf_dict_put_drop(imobj, PDF_NAME(Width), pdf_new_int(doc, image->w));
+		pdf_dict_put_drop(imobj, PDF_NAME(Height), pdf_new_int(doc, image->h));
 		if (mask)
 		{}
 		else if (!colorspace || colorspace->n == 1)
-			pdf_dict_puts_drop(imobj, "ColorSpace", pdf_new_name(doc, "DeviceGray"));
+			pdf_dict_put_drop(imobj, PDF_NAME(ColorSpace), pdf_new_name(doc, "DeviceGray"));
 		else if (colorspace->n == 3)
-			pdf_dict_puts_drop(imobj, "ColorSpace", pdf_new_name(doc, "DeviceRGB"));
+			pdf_dict_put_drop(imobj, PDF_NAME(ColorSpace), pdf_new_name(doc, "DeviceRGB"));
 		else if (colorspace->n == 4)
-			pdf_dict_puts_drop(imobj, "ColorSpace", pdf_new_name(doc, "DeviceCMYK"));
+			pdf_dict_put_drop(imobj, PDF_NAME(ColorSpace), pdf_new_name(doc, "DeviceCMYK"));
 		if (!mask)
-			pdf_dict_puts_drop(imobj, "BitsPerComponent", pdf_new_int(doc, image->bpc));
+			pdf_dict_put_drop(imobj, PDF_NAME(BitsPerComponent), pdf_new_int(doc, image->bpc));
 		switch (cp ? cp->type : FZ_IMAGE_UNKNOWN)
 		{
 		case FZ_IMAGE_UNKNOWN: /* Unknown also means raw */
@@ -219,32 +219,32 @@ send_image(pdf_device *pdev, fz_image *image, int mask, int smask)
 			break;
 		case FZ_IMAGE_JPEG:
 			if (cp->u.jpeg.color_transform != -1)
-				pdf_dict_puts_drop(imobj, "ColorTransform", pdf_new_int(doc, cp->u.jpeg.color_transform));
-			pdf_dict_puts_drop(imobj, "Filter", pdf_new_name(doc, "DCTDecode"));
+				pdf_dict_put_drop(imobj, PDF_NAME(ColorTransform), pdf_new_int(doc, cp->u.jpeg.color_transform));
+			pdf_dict_put_drop(imobj, PDF_NAME(Filter), pdf_new_name(doc, "DCTDecode"));
 			break;
 		case FZ_IMAGE_JPX:
 			if (cp->u.jpx.smask_in_data)
-				pdf_dict_puts_drop(imobj, "SMaskInData", pdf_new_int(doc, cp->u.jpx.smask_in_data));
-			pdf_dict_puts_drop(imobj, "Filter", pdf_new_name(doc, "JPXDecode"));
+				pdf_dict_put_drop(imobj, PDF_NAME(SMaskInData), pdf_new_int(doc, cp->u.jpx.smask_in_data));
+			pdf_dict_put_drop(imobj, PDF_NAME(Filter), pdf_new_name(doc, "JPXDecode"));
 			break;
 		case FZ_IMAGE_FAX:
 			if (cp->u.fax.columns)
-				pdf_dict_puts(imobj, "Columns", pdf_new_int(doc, cp->u.fax.columns));
+				pdf_dict_put(imobj, PDF_NAME(Columns), pdf_new_int(doc, cp->u.fax.columns));
 			if (cp->u.fax.rows)
-				pdf_dict_puts(imobj, "Rows", pdf_new_int(doc, cp->u.fax.rows));
+				pdf_dict_put(imobj, PDF_NAME(Rows), pdf_new_int(doc, cp->u.fax.rows));
 			if (cp->u.fax.k)
-				pdf_dict_puts(imobj, "K", pdf_new_int(doc, cp->u.fax.k));
+				pdf_dict_put(imobj, PDF_NAME(K), pdf_new_int(doc, cp->u.fax.k));
 			if (cp->u.fax.end_of_line)
-				pdf_dict_puts(imobj, "EndOfLine", pdf_new_int(doc, cp->u.fax.end_of_line));
+				pdf_dict_put(imobj, PDF_NAME(EndOfLine), pdf_new_int(doc, cp->u.fax.end_of_line));
 			if (cp->u.fax.encoded_byte_align)
-				pdf_dict_puts(imobj, "EncodedByteAlign", pdf_new_int(doc, cp->u.fax.encoded_byte_align));
+				pdf_dict_put(imobj, PDF_NAME(EncodedByteAlign), pdf_new_int(doc, cp->u.fax.encoded_byte_align));
 			if (cp->u.fax.end_of_block)
-				pdf_dict_puts(imobj, "EndOfBlock", pdf_new_int(doc, cp->u.fax.end_of_block));
+				pdf_dict_put(imobj, PDF_NAME(EndOfBlock), pdf_new_int(doc, cp->u.fax.end_of_block));
 			if (cp->u.fax.black_is_1)
-				pdf_dict_puts(imobj, "BlackIs1", pdf_new_int(doc, cp->u.fax.black_is_1));
+				pdf_dict_put(imobj, PDF_NAME(BlackIs1), pdf_new_int(doc, cp->u.fax.black_is_1));
 			if (cp->u.fax.damaged_rows_before_error)
-				pdf_dict_puts(imobj, "DamagedRowsBeforeError", pdf_new_int(doc, cp->u.fax.damaged_rows_before_error));
-			pdf_dict_puts(imobj, "Filter", pdf_new_name(doc, "CCITTFaxDecode"));
+				pdf_dict_put(imobj, PDF_NAME(DamagedRowsBeforeError), pdf_new_int(doc, cp->u.fax.damaged_rows_before_error));
+			pdf_dict_put(imobj, PDF_NAME(Filter), pdf_new_name(doc, "CCITTFaxDecode"));
 			break;
 		case FZ_IMAGE_JBIG2:
 			/* FIXME - jbig2globals */
@@ -252,42 +252,42 @@ send_image(pdf_device *pdev, fz_image *image, int mask, int smask)
 			break;
 		case FZ_IMAGE_FLATE:
 			if (cp->u.flate.columns)
-				pdf_dict_puts(imobj, "Columns", pdf_new_int(doc, cp->u.flate.columns));
+				pdf_dict_put(imobj, PDF_NAME(Columns), pdf_new_int(doc, cp->u.flate.columns));
 			if (cp->u.flate.colors)
-				pdf_dict_puts(imobj, "Colors", pdf_new_int(doc, cp->u.flate.colors));
+				pdf_dict_put(imobj, PDF_NAME(Colors), pdf_new_int(doc, cp->u.flate.colors));
 			if (cp->u.flate.predictor)
-				pdf_dict_puts(imobj, "Predictor", pdf_new_int(doc, cp->u.flate.predictor));
-			pdf_dict_puts(imobj, "Filter", pdf_new_name(doc, "FlateDecode"));
-			pdf_dict_puts_drop(imobj, "BitsPerComponent", pdf_new_int(doc, image->bpc));
+				pdf_dict_put(imobj, PDF_NAME(Predictor), pdf_new_int(doc, cp->u.flate.predictor));
+			pdf_dict_put(imobj, PDF_NAME(Filter), pdf_new_name(doc, "FlateDecode"));
+			pdf_dict_put_drop(imobj, PDF_NAME(BitsPerComponent), pdf_new_int(doc, image->bpc));
 			break;
 		case FZ_IMAGE_LZW:
 			if (cp->u.lzw.columns)
-				pdf_dict_puts(imobj, "Columns", pdf_new_int(doc, cp->u.lzw.columns));
+				pdf_dict_put(imobj, PDF_NAME(Columns), pdf_new_int(doc, cp->u.lzw.columns));
 			if (cp->u.lzw.colors)
-				pdf_dict_puts(imobj, "Colors", pdf_new_int(doc, cp->u.lzw.colors));
+				pdf_dict_put(imobj, PDF_NAME(Colors), pdf_new_int(doc, cp->u.lzw.colors));
 			if (cp->u.lzw.predictor)
-				pdf_dict_puts(imobj, "Predictor", pdf_new_int(doc, cp->u.lzw.predictor));
+				pdf_dict_put(imobj, PDF_NAME(Predictor), pdf_new_int(doc, cp->u.lzw.predictor));
 			if (cp->u.lzw.early_change)
-				pdf_dict_puts(imobj, "EarlyChange", pdf_new_int(doc, cp->u.lzw.early_change));
-			pdf_dict_puts(imobj, "Filter", pdf_new_name(doc, "LZWDecode"));
+				pdf_dict_put(imobj, PDF_NAME(EarlyChange), pdf_new_int(doc, cp->u.lzw.early_change));
+			pdf_dict_put(imobj, PDF_NAME(Filter), pdf_new_name(doc, "LZWDecode"));
 			break;
 		case FZ_IMAGE_RLD:
-			pdf_dict_puts(imobj, "Filter", pdf_new_name(doc, "RunLengthDecode"));
+			pdf_dict_put(imobj, PDF_NAME(Filter), pdf_new_name(doc, "RunLengthDecode"));
 			break;
 		}
 		if (mask)
 		{
-			pdf_dict_puts_drop(imobj, "ImageMask", pdf_new_bool(doc, 1));
+			pdf_dict_put_drop(imobj, PDF_NAME(ImageMask), pdf_new_bool(doc, 1));
 		}
 		if (image->mask)
 		{
 			int smasknum = send_image(pdev, image->mask, 0, 1);
-			pdf_dict_puts(imobj, "SMask", pdev->images[smasknum].ref);
+			pdf_dict_put(imobj, PDF_NAME(SMask), pdev->images[smasknum].ref);
 		}
 
 		imref = pdf_new_ref(doc, imobj);
 		pdf_update_stream(doc, pdf_to_num(imref), buffer);
-		pdf_dict_puts_drop(imobj, "Length", pdf_new_int(doc, buffer->len));
+		pdf_dict_put_drop(imobj, PDF_NAME(Length), pdf_new_int(doc, buffer->len));
 
 		{
 			char text[32];
@@ -578,10 +578,10 @@ pdf_dev_font(pdf_device *pdev, fz_font *font, float size)
 		fz_try(ctx)
 		{
 			char text[32];
-			pdf_dict_puts_drop(o, "Type", pdf_new_name(doc, "Font"));
-			pdf_dict_puts_drop(o, "Subtype", pdf_new_name(doc, "Type1"));
-			pdf_dict_puts_drop(o, "BaseFont", pdf_new_name(doc, font->name));
-			pdf_dict_puts_drop(o, "Encoding", pdf_new_name(doc, "WinAnsiEncoding"));
+			pdf_dict_put_drop(o, PDF_NAME(Type), pdf_new_name(doc, "Font"));
+			pdf_dict_put_drop(o, PDF_NAME(Subtype), pdf_new_name(doc, "Type1"));
+			pdf_dict_put_drop(o, PDF_NAME(BaseFont), pdf_new_name(doc, font->name));
+			pdf_dict_put_drop(o, PDF_NAME(Encoding), pdf_new_name(doc, "WinAnsiEncoding"));
 			ref = pdf_new_ref(doc, o);
 			snprintf(text, sizeof(text), "Font/F%d", i);
 			pdf_dict_putp(pdev->resources, text, ref);
@@ -808,18 +808,18 @@ pdf_dev_new_form(pdf_obj **form_ref, pdf_device *pdev, const fz_rect *bbox, int
 		group = pdf_new_dict(doc, 5);
 		fz_try(ctx)
 		{
-			pdf_dict_puts_drop(group, "Type", pdf_new_name(doc, "Group"));
-			pdf_dict_puts_drop(group, "S", pdf_new_name(doc, "Transparency"));
-			pdf_dict_puts_drop(group, "K", pdf_new_bool(doc, knockout));
-			pdf_dict_puts_drop(group, "I", pdf_new_bool(doc, isolated));
+			pdf_dict_put_drop(group, PDF_NAME(Type), pdf_new_name(doc, "Group"));
+			pdf_dict_put_drop(group, PDF_NAME(S), pdf_new_name(doc, "Transparency"));
+			pdf_dict_put_drop(group, PDF_NAME(K), pdf_new_bool(doc, knockout));
+			pdf_dict_put_drop(group, PDF_NAME(I), pdf_new_bool(doc, isolated));
 			if (!colorspace)
 			{}
 			else if (colorspace->n == 1)
-				pdf_dict_puts_drop(group, "CS", pdf_new_name(doc, "DeviceGray"));
+				pdf_dict_put_drop(group, PDF_NAME(CS), pdf_new_name(doc, "DeviceGray"));
 			else if (colorspace->n == 4)
-				pdf_dict_puts_drop(group, "CS", pdf_new_name(doc, "DeviceCMYK"));
+				pdf_dict_put_drop(group, PDF_NAME(CS), pdf_new_name(doc, "DeviceCMYK"));
 			else
-				pdf_dict_puts_drop(group, "CS", pdf_new_name(doc, "DeviceRGB"));
+				pdf_dict_put_drop(group, PDF_NAME(CS), pdf_new_name(doc, "DeviceRGB"));
 			group_ref = pdev->groups[num].ref = pdf_new_ref(doc, group);
 		}
 		fz_always(ctx)
@@ -837,10 +837,10 @@ pdf_dev_new_form(pdf_obj **form_ref, pdf_device *pdev, const fz_rect *bbox, int
 	form = pdf_new_dict(doc, 4);
 	fz_try(ctx)
 	{
-		pdf_dict_puts_drop(form, "Subtype", pdf_new_name(doc, "Form"));
-		pdf_dict_puts(form, "Group", group_ref);
-		pdf_dict_puts_drop(form, "FormType", pdf_new_int(doc, 1));
-		pdf_dict_puts_drop(form, "BBox", pdf_new_rect(doc, bbox));
+		pdf_dict_put_drop(form, PDF_NAME(Subtype), pdf_new_name(doc, "Form"));
+		pdf_dict_put(form, PDF_NAME(Group), group_ref);
+		pdf_dict_put_drop(form, PDF_NAME(FormType), pdf_new_int(doc, 1));
+		pdf_dict_put_drop(form, PDF_NAME(BBox), pdf_new_rect(doc, bbox));
 		*form_ref = pdf_new_ref(doc, form);
 	}
 	fz_catch(ctx)
@@ -1100,18 +1100,18 @@ pdf_dev_begin_mask(fz_device *dev, const fz_rect *bbox, int luminosity, fz_color
 	fz_try(ctx)
 	{
 		smask = pdf_new_dict(doc, 4);
-		pdf_dict_puts(smask, "Type", pdf_new_name(doc, "Mask"));
-		pdf_dict_puts_drop(smask, "S", pdf_new_name(doc, (luminosity ? "Luminosity" : "Alpha")));
-		pdf_dict_puts(smask, "G", form_ref);
+		pdf_dict_put(smask, PDF_NAME(Type), pdf_new_name(doc, "Mask"));
+		pdf_dict_put_drop(smask, PDF_NAME(S), pdf_new_name(doc, (luminosity ? "Luminosity" : "Alpha")));
+		pdf_dict_put(smask, PDF_NAME(G), form_ref);
 		color_obj = pdf_new_array(doc, colorspace->n);
 		for (i = 0; i < colorspace->n; i++)
 			pdf_array_push(color_obj, pdf_new_real(doc, color[i]));
-		pdf_dict_puts_drop(smask, "BC", color_obj);
+		pdf_dict_put_drop(smask, PDF_NAME(BC), color_obj);
 		color_obj = NULL;
 
 		egs = pdf_new_dict(doc, 5);
-		pdf_dict_puts_drop(egs, "Type", pdf_new_name(doc, "ExtGState"));
-		pdf_dict_puts_drop(egs, "SMask", pdf_new_ref(doc, smask));
+		pdf_dict_put_drop(egs, PDF_NAME(Type), pdf_new_name(doc, "ExtGState"));
+		pdf_dict_put_drop(egs, PDF_NAME(SMask), pdf_new_ref(doc, smask));
 		egs_ref = pdf_new_ref(doc, egs);
 
 		{
@@ -1152,7 +1152,7 @@ pdf_dev_end_mask(fz_device *dev)
 	/* Here we do part of the pop, but not all of it. */
 	pdf_dev_end_text(pdev);
 	fz_buffer_printf(ctx, buf, "Q\n");
-	pdf_dict_puts_drop(form_ref, "Length", pdf_new_int(doc, buf->len));
+	pdf_dict_put_drop(form_ref, PDF_NAME(Length), pdf_new_int(doc, buf->len));
 	pdf_update_stream(doc, pdf_to_num(form_ref), buf);
 	fz_drop_buffer(ctx, buf);
 	gs->buf = fz_keep_buffer(ctx, gs[-1].buf);
@@ -1185,8 +1185,8 @@ pdf_dev_begin_group(fz_device *dev, const fz_rect *bbox, int isolated, int knock
 		{
 			/* No, better make one */
 			obj = pdf_new_dict(pdev->doc, 2);
-			pdf_dict_puts_drop(obj, "Type", pdf_new_name(doc, "ExtGState"));
-			pdf_dict_puts_drop(obj, "BM", pdf_new_name(doc, fz_blendmode_name(blendmode)));
+			pdf_dict_put_drop(obj, PDF_NAME(Type), pdf_new_name(doc, "ExtGState"));
+			pdf_dict_put_drop(obj, PDF_NAME(BM), pdf_new_name(doc, fz_blendmode_name(blendmode)));
 			pdf_dict_putp_drop(pdev->resources, text, obj);
 		}
 	}
@@ -1212,7 +1212,7 @@ pdf_dev_end_group(fz_device *dev)
 
 	pdf_dev_end_text(pdev);
 	form_ref = (pdf_obj *)pdf_dev_pop(pdev);
-	pdf_dict_puts_drop(form_ref, "Length", pdf_new_int(doc, gs->buf->len));
+	pdf_dict_put_drop(form_ref, PDF_NAME(Length), pdf_new_int(doc, gs->buf->len));
 	pdf_update_stream(doc, pdf_to_num(form_ref), buf);
 	fz_drop_buffer(ctx, buf);
 	pdf_drop_obj(form_ref);
@@ -1248,7 +1248,7 @@ pdf_dev_free_user(fz_device *dev)
 
 	pdf_dev_end_text(pdev);
 
-	pdf_dict_puts_drop(pdev->contents, "Length", pdf_new_int(doc, gs->buf->len));
+	pdf_dict_put_drop(pdev->contents, PDF_NAME(Length), pdf_new_int(doc, gs->buf->len));
 
 	for (i = pdev->num_gstates-1; i >= 0; i--)
 	{
@@ -1358,14 +1358,14 @@ fz_device *pdf_new_pdf_device(pdf_document *doc, pdf_obj *contents, pdf_obj *res
 fz_device *pdf_page_write(pdf_document *doc, pdf_page *page)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *resources = pdf_dict_gets(page->me, "Resources");
+	pdf_obj *resources = pdf_dict_get(page->me, PDF_NAME(Resources));
 	fz_matrix ctm;
 	fz_pre_translate(fz_scale(&ctm, 1, -1), 0, page->mediabox.y0-page->mediabox.y1);
 
 	if (resources == NULL)
 	{
 		resources = pdf_new_dict(doc, 0);
-		pdf_dict_puts_drop(page->me, "Resources", resources);
+		pdf_dict_put_drop(page->me, PDF_NAME(Resources), resources);
 	}
 
 	if (page->contents == NULL)
@@ -1374,7 +1374,7 @@ fz_device *pdf_page_write(pdf_document *doc, pdf_page *page)
 		fz_try(ctx)
 		{
 			page->contents = pdf_new_ref(doc, obj);
-			pdf_dict_puts(page->me, "Contents", page->contents);
+			pdf_dict_put(page->me, PDF_NAME(Contents), page->contents);
 		}
 		fz_always(ctx)
 		{
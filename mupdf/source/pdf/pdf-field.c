@@ -9,10 +9,10 @@ pdf_obj *pdf_get_inheritable(pdf_document *doc, pdf_obj *obj, char *key)
 		fobj = pdf_dict_gets(obj, key);
 
 		if (!fobj)
-			obj = pdf_dict_gets(obj, "Parent");
+			obj = pdf_dict_get(obj, PDF_NAME(Parent));
 	}
 
-	return fobj ? fobj : pdf_dict_gets(pdf_dict_gets(pdf_dict_gets(pdf_trailer(doc), "Root"), "AcroForm"), key);
+	return fobj ? fobj : pdf_dict_gets(pdf_dict_get(pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)), PDF_NAME(AcroForm)), key);
 }
 
 char *pdf_get_string_or_stream(pdf_document *doc, pdf_obj *obj)
@@ -140,13 +140,13 @@ void pdf_set_field_type(pdf_document *doc, pdf_obj *obj, int type)
 	}
 
 	if (typename)
-		pdf_dict_puts_drop(obj, "FT", pdf_new_name(doc, typename));
+		pdf_dict_put_drop(obj, PDF_NAME(FT), pdf_new_name(doc, typename));
 
 	if (setbits != 0 || clearbits != 0)
 	{
-		int bits = pdf_to_int(pdf_dict_gets(obj, "Ff"));
+		int bits = pdf_to_int(pdf_dict_get(obj, PDF_NAME(Ff)));
 		bits &= ~clearbits;
 		bits |= setbits;
-		pdf_dict_puts_drop(obj, "Ff", pdf_new_int(doc, bits));
+		pdf_dict_put_drop(obj, PDF_NAME(Ff), pdf_new_int(doc, bits));
 	}
 }
@@ -488,12 +488,12 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 	{
 		fontdesc = pdf_new_font_desc(ctx);
 
-		descriptor = pdf_dict_gets(dict, "FontDescriptor");
+		descriptor = pdf_dict_get(dict, PDF_NAME(FontDescriptor));
 		/* cf. http://bugs.ghostscript.com/show_bug.cgi?id=691690 */
 		fz_try(ctx)
 		{
 		if (descriptor)
-			pdf_load_font_descriptor(fontdesc, doc, descriptor, NULL, basefont, 0, pdf_dict_gets(dict, "Encoding") != NULL);
+			pdf_load_font_descriptor(fontdesc, doc, descriptor, NULL, basefont, 0, pdf_dict_get(dict, PDF_NAME(Encoding)) != NULL);
 		else
 			pdf_load_builtin_font(ctx, fontdesc, basefont, 0);
 		/* cf. http://bugs.ghostscript.com/show_bug.cgi?id=691690 */
@@ -513,10 +513,10 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 		}
 
 		/* Some chinese documents mistakenly consider WinAnsiEncoding to be codepage 936 */
-		if (descriptor && pdf_is_string(pdf_dict_gets(descriptor, "FontName")) &&
-			!pdf_dict_gets(dict, "ToUnicode") &&
-			!strcmp(pdf_to_name(pdf_dict_gets(dict, "Encoding")), "WinAnsiEncoding") &&
-			pdf_to_int(pdf_dict_gets(descriptor, "Flags")) == 4)
+		if (descriptor && pdf_is_string(pdf_dict_get(descriptor, PDF_NAME(FontName))) &&
+			!pdf_dict_get(dict, PDF_NAME(ToUnicode)) &&
+			pdf_name_eq(pdf_dict_get(dict, PDF_NAME(Encoding)), PDF_NAME(WinAnsiEncoding)) &&
+			pdf_to_int(pdf_dict_get(descriptor, PDF_NAME(Flags))) == 4)
 		{
 			char *cp936fonts[] = {
 				"\xCB\xCE\xCC\xE5", "SimSun,Regular",
@@ -596,7 +596,7 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 			etable[i] = 0;
 		}
 
-		encoding = pdf_dict_gets(dict, "Encoding");
+		encoding = pdf_dict_get(dict, PDF_NAME(Encoding));
 		if (encoding)
 		{
 			if (pdf_is_name(encoding))
@@ -606,13 +606,13 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 			{
 				pdf_obj *base, *diff, *item;
 
-				base = pdf_dict_gets(encoding, "BaseEncoding");
+				base = pdf_dict_get(encoding, PDF_NAME(BaseEncoding));
 				if (pdf_is_name(base))
 					pdf_load_encoding(estrings, pdf_to_name(base));
 				else if (!fontdesc->is_embedded && !symbolic)
 					pdf_load_encoding(estrings, "StandardEncoding");
 
-				diff = pdf_dict_gets(encoding, "Differences");
+				diff = pdf_dict_get(encoding, PDF_NAME(Differences));
 				if (pdf_is_array(diff))
 				{
 					n = pdf_array_len(diff);
@@ -639,7 +639,7 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 		has_lock = 1;
 
 		/* built-in and substitute fonts may be a different type than what the document expects */
-		subtype = pdf_to_name(pdf_dict_gets(dict, "Subtype"));
+		subtype = pdf_to_name(pdf_dict_get(dict, PDF_NAME(Subtype)));
 		if (!strcmp(subtype, "Type1"))
 			kind = TYPE1;
 		else if (!strcmp(subtype, "MMType1"))
@@ -708,7 +708,7 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 			else if (!symbolic && face->charmap && face->charmap->platform_id == 1)
 			{
 				/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=2123 */
-				if (pdf_is_name(encoding) && !strcmp(pdf_to_name(encoding), "MacExpertEncoding"))
+				if (pdf_is_name(encoding) && pdf_name_eq(encoding, PDF_NAME(MacExpertEncoding)))
 				{
 					if (FT_HAS_GLYPH_NAMES(face))
 						for (i = 0; i < 256; i++)
@@ -791,7 +791,7 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 
 		fz_try(ctx)
 		{
-			pdf_load_to_unicode(doc, fontdesc, estrings, NULL, pdf_dict_gets(dict, "ToUnicode"));
+			pdf_load_to_unicode(doc, fontdesc, estrings, NULL, pdf_dict_get(dict, PDF_NAME(ToUnicode)));
 		}
 		fz_catch(ctx)
 		{
@@ -805,13 +805,13 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 
 		pdf_set_default_hmtx(ctx, fontdesc, fontdesc->missing_width);
 
-		widths = pdf_dict_gets(dict, "Widths");
+		widths = pdf_dict_get(dict, PDF_NAME(Widths));
 		if (widths)
 		{
 			int first, last;
 
-			first = pdf_to_int(pdf_dict_gets(dict, "FirstChar"));
-			last = pdf_to_int(pdf_dict_gets(dict, "LastChar"));
+			first = pdf_to_int(pdf_dict_get(dict, PDF_NAME(FirstChar)));
+			last = pdf_to_int(pdf_dict_get(dict, PDF_NAME(LastChar)));
 
 			if (first < 0 || last > 255 || first > last)
 				first = last = 0;
@@ -861,7 +861,7 @@ pdf_load_simple_font_by_name(pdf_document *doc, pdf_obj *dict, char *basefont)
 static pdf_font_desc *
 pdf_load_simple_font(pdf_document *doc, pdf_obj *dict)
 {
-	char *basefont = pdf_to_name(pdf_dict_gets(dict, "BaseFont"));
+	char *basefont = pdf_to_name(pdf_dict_get(dict, PDF_NAME(BaseFont)));
 
 	return pdf_load_simple_font_by_name(doc, dict, basefont);
 }
@@ -957,18 +957,18 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 	{
 		/* Get font name and CID collection */
 
-		basefont = pdf_to_name(pdf_dict_gets(dict, "BaseFont"));
+		basefont = pdf_to_name(pdf_dict_get(dict, PDF_NAME(BaseFont)));
 
 		{
 			pdf_obj *cidinfo;
 			char tmpstr[64];
 			int tmplen;
 
-			cidinfo = pdf_dict_gets(dict, "CIDSystemInfo");
+			cidinfo = pdf_dict_get(dict, PDF_NAME(CIDSystemInfo));
 			if (!cidinfo)
 				fz_throw(ctx, FZ_ERROR_GENERIC, "cid font is missing info");
 
-			obj = pdf_dict_gets(cidinfo, "Registry");
+			obj = pdf_dict_get(cidinfo, PDF_NAME(Registry));
 			tmplen = fz_mini(sizeof tmpstr - 1, pdf_to_str_len(obj));
 			memcpy(tmpstr, pdf_to_str_buf(obj), tmplen);
 			tmpstr[tmplen] = '\0';
@@ -976,7 +976,7 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 
 			fz_strlcat(collection, "-", sizeof collection);
 
-			obj = pdf_dict_gets(cidinfo, "Ordering");
+			obj = pdf_dict_get(cidinfo, PDF_NAME(Ordering));
 			tmplen = fz_mini(sizeof tmpstr - 1, pdf_to_str_len(obj));
 			memcpy(tmpstr, pdf_to_str_buf(obj), tmplen);
 			tmpstr[tmplen] = '\0';
@@ -987,7 +987,7 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 
 		fontdesc = pdf_new_font_desc(ctx);
 
-		descriptor = pdf_dict_gets(dict, "FontDescriptor");
+		descriptor = pdf_dict_get(dict, PDF_NAME(FontDescriptor));
 		if (!descriptor)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "syntaxerror: missing font descriptor");
 		pdf_load_font_descriptor(fontdesc, doc, descriptor, collection, basefont, 1, 1);
@@ -999,9 +999,9 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 
 		if (pdf_is_name(encoding))
 		{
-			if (!strcmp(pdf_to_name(encoding), "Identity-H"))
+			if (pdf_name_eq(encoding, PDF_NAME(Identity_H)))
 				fontdesc->encoding = pdf_new_identity_cmap(ctx, 0, 2);
-			else if (!strcmp(pdf_to_name(encoding), "Identity-V"))
+			else if (pdf_name_eq(encoding, PDF_NAME(Identity_V)))
 				fontdesc->encoding = pdf_new_identity_cmap(ctx, 1, 2);
 			else
 				fontdesc->encoding = pdf_load_system_cmap(ctx, pdf_to_name(encoding));
@@ -1020,13 +1020,13 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 
 		if (kind == TRUETYPE ||
 			/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=1565 */
-			!strcmp(pdf_to_name(pdf_dict_gets(dict, "Subtype")), "CIDFontType2") ||
+			pdf_name_eq(pdf_dict_get(dict, PDF_NAME(Subtype)), PDF_NAME(CIDFontType2)) ||
 			/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=1997 */
-			pdf_is_indirect(pdf_dict_gets(dict, "CIDToGIDMap")))
+			pdf_is_indirect(pdf_dict_get(dict, PDF_NAME(CIDToGIDMap))))
 		{
 			pdf_obj *cidtogidmap;
 
-			cidtogidmap = pdf_dict_gets(dict, "CIDToGIDMap");
+			cidtogidmap = pdf_dict_get(dict, PDF_NAME(CIDToGIDMap));
 			if (pdf_is_indirect(cidtogidmap))
 			{
 				fz_buffer *buf;
@@ -1095,12 +1095,12 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 		/* Horizontal */
 
 		dw = 1000;
-		obj = pdf_dict_gets(dict, "DW");
+		obj = pdf_dict_get(dict, PDF_NAME(DW));
 		if (obj)
 			dw = pdf_to_int(obj);
 		pdf_set_default_hmtx(ctx, fontdesc, dw);
 
-		widths = pdf_dict_gets(dict, "W");
+		widths = pdf_dict_get(dict, PDF_NAME(W));
 		if (widths)
 		{
 			int c0, c1, w, n, m;
@@ -1139,7 +1139,7 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 			int dw2y = 880;
 			int dw2w = -1000;
 
-			obj = pdf_dict_gets(dict, "DW2");
+			obj = pdf_dict_get(dict, PDF_NAME(DW2));
 			if (obj)
 			{
 				dw2y = pdf_to_int(pdf_array_get(obj, 0));
@@ -1148,7 +1148,7 @@ load_cid_font(pdf_document *doc, pdf_obj *dict, pdf_obj *encoding, pdf_obj *to_u
 
 			pdf_set_default_vmtx(ctx, fontdesc, dw2y, dw2w);
 
-			widths = pdf_dict_gets(dict, "W2");
+			widths = pdf_dict_get(dict, PDF_NAME(W2));
 			if (widths)
 			{
 				int c0, c1, w, x, y, n;
@@ -1203,19 +1203,19 @@ pdf_load_type0_font(pdf_document *doc, pdf_obj *dict)
 	pdf_obj *encoding;
 	pdf_obj *to_unicode;
 
-	dfonts = pdf_dict_gets(dict, "DescendantFonts");
+	dfonts = pdf_dict_get(dict, PDF_NAME(DescendantFonts));
 	if (!dfonts)
 		fz_throw(doc->ctx, FZ_ERROR_GENERIC, "cid font is missing descendant fonts");
 
 	dfont = pdf_array_get(dfonts, 0);
 
-	subtype = pdf_dict_gets(dfont, "Subtype");
-	encoding = pdf_dict_gets(dict, "Encoding");
-	to_unicode = pdf_dict_gets(dict, "ToUnicode");
+	subtype = pdf_dict_get(dfont, PDF_NAME(Subtype));
+	encoding = pdf_dict_get(dict, PDF_NAME(Encoding));
+	to_unicode = pdf_dict_get(dict, PDF_NAME(ToUnicode));
 
-	if (pdf_is_name(subtype) && !strcmp(pdf_to_name(subtype), "CIDFontType0"))
+	if (pdf_is_name(subtype) && pdf_name_eq(subtype, PDF_NAME(CIDFontType0)))
 		return load_cid_font(doc, dfont, encoding, to_unicode);
-	if (pdf_is_name(subtype) && !strcmp(pdf_to_name(subtype), "CIDFontType2"))
+	if (pdf_is_name(subtype) && pdf_name_eq(subtype, PDF_NAME(CIDFontType2)))
 		return load_cid_font(doc, dfont, encoding, to_unicode);
 	fz_throw(doc->ctx, FZ_ERROR_GENERIC, "syntaxerror: unknown cid font type");
 }
@@ -1236,24 +1236,24 @@ pdf_load_font_descriptor(pdf_font_desc *fontdesc, pdf_document *doc, pdf_obj *di
 	fontname = basefont;
 
 	/* SumatraPDF: handle /BaseFont /Arial,Bold+000041 /FontName /Arial,Bold */
-	if (strchr(basefont, '+') && pdf_is_name(pdf_dict_gets(dict, "FontName")))
-		fontname = pdf_to_name(pdf_dict_gets(dict, "FontName"));
+	if (strchr(basefont, '+') && pdf_is_name(pdf_dict_get(dict, PDF_NAME(FontName))))
+		fontname = pdf_to_name(pdf_dict_get(dict, PDF_NAME(FontName)));
 
 	/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=1616 */
 	if (strlen(fontname) > 7 && fontname[6] == '+')
 		fontname += 7;
 
-	fontdesc->flags = pdf_to_int(pdf_dict_gets(dict, "Flags"));
-	fontdesc->italic_angle = pdf_to_real(pdf_dict_gets(dict, "ItalicAngle"));
-	fontdesc->ascent = pdf_to_real(pdf_dict_gets(dict, "Ascent"));
-	fontdesc->descent = pdf_to_real(pdf_dict_gets(dict, "Descent"));
-	fontdesc->cap_height = pdf_to_real(pdf_dict_gets(dict, "CapHeight"));
-	fontdesc->x_height = pdf_to_real(pdf_dict_gets(dict, "XHeight"));
-	fontdesc->missing_width = pdf_to_real(pdf_dict_gets(dict, "MissingWidth"));
-
-	obj1 = pdf_dict_gets(dict, "FontFile");
-	obj2 = pdf_dict_gets(dict, "FontFile2");
-	obj3 = pdf_dict_gets(dict, "FontFile3");
+	fontdesc->flags = pdf_to_int(pdf_dict_get(dict, PDF_NAME(Flags)));
+	fontdesc->italic_angle = pdf_to_real(pdf_dict_get(dict, PDF_NAME(ItalicAngle)));
+	fontdesc->ascent = pdf_to_real(pdf_dict_get(dict, PDF_NAME(Ascent)));
+	fontdesc->descent = pdf_to_real(pdf_dict_get(dict, PDF_NAME(Descent)));
+	fontdesc->cap_height = pdf_to_real(pdf_dict_get(dict, PDF_NAME(CapHeight)));
+	fontdesc->x_height = pdf_to_real(pdf_dict_get(dict, PDF_NAME(XHeight)));
+	fontdesc->missing_width = pdf_to_real(pdf_dict_get(dict, PDF_NAME(MissingWidth)));
+
+	obj1 = pdf_dict_get(dict, PDF_NAME(FontFile));
+	obj2 = pdf_dict_get(dict, PDF_NAME(FontFile2));
+	obj3 = pdf_dict_get(dict, PDF_NAME(FontFile3));
 	obj = obj1 ? obj1 : obj2 ? obj2 : obj3;
 
 	if (pdf_is_indirect(obj))
@@ -1356,9 +1356,9 @@ pdf_load_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict, int nested_depth)
 		return fontdesc;
 	}
 
-	subtype = pdf_to_name(pdf_dict_gets(dict, "Subtype"));
-	dfonts = pdf_dict_gets(dict, "DescendantFonts");
-	charprocs = pdf_dict_gets(dict, "CharProcs");
+	subtype = pdf_to_name(pdf_dict_get(dict, PDF_NAME(Subtype)));
+	dfonts = pdf_dict_get(dict, PDF_NAME(DescendantFonts));
+	charprocs = pdf_dict_get(dict, PDF_NAME(CharProcs));
 
 	if (subtype && !strcmp(subtype, "Type0"))
 		fontdesc = pdf_load_type0_font(doc, dict);
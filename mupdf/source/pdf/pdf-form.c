@@ -19,15 +19,15 @@ enum
  * share the same name */
 static pdf_obj *find_head_of_field_group(pdf_obj *obj)
 {
-	if (obj == NULL || pdf_dict_gets(obj, "T"))
+	if (obj == NULL || pdf_dict_get(obj, PDF_NAME(T)))
 		return obj;
 	else
-		return find_head_of_field_group(pdf_dict_gets(obj, "Parent"));
+		return find_head_of_field_group(pdf_dict_get(obj, PDF_NAME(Parent)));
 }
 
 static void pdf_field_mark_dirty(pdf_document *doc, pdf_obj *field)
 {
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
 	if (kids)
 	{
 		int i, n = pdf_array_len(kids);
@@ -60,7 +60,7 @@ static void update_field_value(pdf_document *doc, pdf_obj *obj, char *text)
 	fz_try(ctx)
 	{
 		sobj = pdf_new_string(doc, text, strlen(text));
-		pdf_dict_puts(obj, "V", sobj);
+		pdf_dict_put(obj, PDF_NAME(V), sobj);
 	}
 	fz_always(ctx)
 	{
@@ -85,7 +85,7 @@ static pdf_obj *find_field(pdf_obj *dict, char *name, int len)
 		char *part;
 
 		field = pdf_array_get(dict, i);
-		part = pdf_to_str_buf(pdf_dict_gets(field, "T"));
+		part = pdf_to_str_buf(pdf_dict_get(field, PDF_NAME(T)));
 		if (strlen(part) == (size_t)len && !memcmp(part, name, len))
 			return field;
 	}
@@ -112,7 +112,7 @@ pdf_obj *pdf_lookup_field(pdf_obj *form, char *name)
 		len = dot ? dot - namep : strlen(namep);
 		dict = find_field(form, namep, len);
 		if (dot)
-			form = pdf_dict_gets(dict, "Kids");
+			form = pdf_dict_get(dict, PDF_NAME(Kids));
 	}
 
 	return dict;
@@ -128,13 +128,13 @@ static void reset_field(pdf_document *doc, pdf_obj *field)
 	 * At the bottom of the hierarchy we may find widget annotations
 	 * that aren't also fields, but DV and V will not be present in their
 	 * dictionaries, and attempts to remove V will be harmless. */
-	pdf_obj *dv = pdf_dict_gets(field, "DV");
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
+	pdf_obj *dv = pdf_dict_get(field, PDF_NAME(DV));
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
 
 	if (dv)
-		pdf_dict_puts(field, "V", dv);
+		pdf_dict_put(field, PDF_NAME(V), dv);
 	else
-		pdf_dict_dels(field, "V");
+		pdf_dict_del(field, PDF_NAME(V));
 
 	if (kids == NULL)
 	{
@@ -156,7 +156,7 @@ static void reset_field(pdf_document *doc, pdf_obj *field)
 
 				fz_try(ctx)
 				{
-					pdf_dict_puts(field, "AS", leafv);
+					pdf_dict_put(field, PDF_NAME(AS), leafv);
 				}
 				fz_always(ctx)
 				{
@@ -183,7 +183,7 @@ static void reset_field(pdf_document *doc, pdf_obj *field)
 
 void pdf_field_reset(pdf_document *doc, pdf_obj *field)
 {
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
 
 	reset_field(doc, field);
 
@@ -198,8 +198,8 @@ void pdf_field_reset(pdf_document *doc, pdf_obj *field)
 
 static void add_field_hierarchy_to_array(pdf_obj *array, pdf_obj *field)
 {
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
-	pdf_obj *exclude = pdf_dict_gets(field, "Exclude");
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
+	pdf_obj *exclude = pdf_dict_get(field, PDF_NAME(Exclude));
 
 	if (exclude)
 		return;
@@ -250,7 +250,7 @@ static pdf_obj *specified_fields(pdf_document *doc, pdf_obj *fields, int exclude
 					field = pdf_lookup_field(form, pdf_to_str_buf(field));
 
 				if (field)
-					pdf_dict_puts(field, "Exclude", nil);
+					pdf_dict_put(field, PDF_NAME(Exclude), nil);
 			}
 
 			/* Act upon all unmarked fields */
@@ -270,7 +270,7 @@ static pdf_obj *specified_fields(pdf_document *doc, pdf_obj *fields, int exclude
 					field = pdf_lookup_field(form, pdf_to_str_buf(field));
 
 				if (field)
-					pdf_dict_dels(field, "Exclude");
+					pdf_dict_del(field, PDF_NAME(Exclude));
 			}
 		}
 		else
@@ -329,11 +329,11 @@ static void execute_action(pdf_document *doc, pdf_obj *obj, pdf_obj *a)
 	fz_context *ctx = doc->ctx;
 	if (a)
 	{
-		char *type = pdf_to_name(pdf_dict_gets(a, "S"));
+		char *type = pdf_to_name(pdf_dict_get(a, PDF_NAME(S)));
 
 		if (!strcmp(type, "JavaScript"))
 		{
-			pdf_obj *js = pdf_dict_gets(a, "JS");
+			pdf_obj *js = pdf_dict_get(a, PDF_NAME(JS));
 			if (js)
 			{
 				char *code = pdf_to_utf8(doc, js);
@@ -353,11 +353,11 @@ static void execute_action(pdf_document *doc, pdf_obj *obj, pdf_obj *a)
 		}
 		else if (!strcmp(type, "ResetForm"))
 		{
-			reset_form(doc, pdf_dict_gets(a, "Fields"), pdf_to_int(pdf_dict_gets(a, "Flags")) & 1);
+			reset_form(doc, pdf_dict_get(a, PDF_NAME(Fields)), pdf_to_int(pdf_dict_get(a, PDF_NAME(Flags))) & 1);
 		}
 		else if (!strcmp(type, "Named"))
 		{
-			char *name = pdf_to_name(pdf_dict_gets(a, "N"));
+			char *name = pdf_to_name(pdf_dict_get(a, PDF_NAME(N)));
 
 			if (!strcmp(name, "Print"))
 				pdf_event_issue_print(doc);
@@ -367,7 +367,7 @@ static void execute_action(pdf_document *doc, pdf_obj *obj, pdf_obj *a)
 
 static void execute_action_chain(pdf_document *doc, pdf_obj *obj)
 {
-	pdf_obj *a = pdf_dict_gets(obj, "A");
+	pdf_obj *a = pdf_dict_get(obj, PDF_NAME(A));
 	pdf_js_event e;
 
 	e.target = obj;
@@ -377,7 +377,7 @@ static void execute_action_chain(pdf_document *doc, pdf_obj *obj)
 	while (a)
 	{
 		execute_action(doc, obj, a);
-		a = pdf_dict_gets(a, "Next");
+		a = pdf_dict_get(a, PDF_NAME(Next));
 	}
 }
 
@@ -405,7 +405,7 @@ static void check_off(pdf_document *doc, pdf_obj *obj)
 	fz_try(ctx);
 	{
 		off = pdf_new_name(doc, "Off");
-		pdf_dict_puts(obj, "AS", off);
+		pdf_dict_put(obj, PDF_NAME(AS), off);
 	}
 	fz_always(ctx)
 	{
@@ -433,7 +433,7 @@ static void set_check(pdf_document *doc, pdf_obj *chk, char *name)
 		else
 			val = pdf_new_name(doc, "Off");
 
-		pdf_dict_puts(chk, "AS", val);
+		pdf_dict_put(chk, PDF_NAME(AS), val);
 	}
 	fz_always(ctx)
 	{
@@ -449,7 +449,7 @@ static void set_check(pdf_document *doc, pdf_obj *chk, char *name)
  * in the hierarchy */
 static void set_check_grp(pdf_document *doc, pdf_obj *grp, char *val)
 {
-	pdf_obj *kids = pdf_dict_gets(grp, "Kids");
+	pdf_obj *kids = pdf_dict_get(grp, PDF_NAME(Kids));
 
 	if (kids == NULL)
 	{
@@ -513,11 +513,11 @@ static void recalculate(pdf_document *doc)
 static void toggle_check_box(pdf_document *doc, pdf_obj *obj)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *as = pdf_dict_gets(obj, "AS");
+	pdf_obj *as = pdf_dict_get(obj, PDF_NAME(AS));
 	int ff = pdf_get_field_flags(doc, obj);
 	int radio = ((ff & (Ff_Pushbutton|Ff_Radio)) == Ff_Radio);
 	char *val = NULL;
-	pdf_obj *grp = radio ? pdf_dict_gets(obj, "Parent") : find_head_of_field_group(obj);
+	pdf_obj *grp = radio ? pdf_dict_get(obj, PDF_NAME(Parent)) : find_head_of_field_group(obj);
 
 	if (!grp)
 		grp = obj;
@@ -558,13 +558,13 @@ static void toggle_check_box(pdf_document *doc, pdf_obj *obj)
 		{
 			/* For radio buttons, first turn off all buttons in the group and
 			 * then set the one that was clicked */
-			pdf_obj *kids = pdf_dict_gets(grp, "Kids");
+			pdf_obj *kids = pdf_dict_get(grp, PDF_NAME(Kids));
 
 			len = pdf_array_len(kids);
 			for (i = 0; i < len; i++)
 				check_off(doc, pdf_array_get(kids, i));
 
-			pdf_dict_puts(obj, "AS", key);
+			pdf_dict_put(obj, PDF_NAME(AS), key);
 		}
 		else
 		{
@@ -587,7 +587,7 @@ static void toggle_check_box(pdf_document *doc, pdf_obj *obj)
 		fz_try(ctx)
 		{
 			v = pdf_new_string(doc, val, strlen(val));
-			pdf_dict_puts(grp, "V", v);
+			pdf_dict_put(grp, PDF_NAME(V), v);
 		}
 		fz_always(ctx)
 		{
@@ -626,7 +626,7 @@ int pdf_pass_event(pdf_document *doc, pdf_page *page, pdf_ui_event *ui_event)
 
 	if (annot)
 	{
-		int f = pdf_to_int(pdf_dict_gets(annot->obj, "F"));
+		int f = pdf_to_int(pdf_dict_get(annot->obj, PDF_NAME(F)));
 
 		if (f & (F_Hidden|F_NoView))
 			annot = NULL;
@@ -808,7 +808,7 @@ pdf_widget *pdf_create_widget(pdf_document *doc, pdf_page *page, int type, char
 	fz_try(ctx)
 	{
 		pdf_set_field_type(doc, annot->obj, type);
-		pdf_dict_puts_drop(annot->obj, "T", pdf_new_string(doc, fieldname, strlen(fieldname)));
+		pdf_dict_put_drop(annot->obj, PDF_NAME(T), pdf_new_string(doc, fieldname, strlen(fieldname)));
 		annot->widget_type = type;
 
 		if (type == PDF_WIDGET_TYPE_SIGNATURE)
@@ -879,7 +879,7 @@ static int set_text_field_value(pdf_document *doc, pdf_obj *field, char *text)
 static void update_checkbox_selector(pdf_document *doc, pdf_obj *field, char *val)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
 
 	if (kids)
 	{
@@ -901,7 +901,7 @@ static void update_checkbox_selector(pdf_document *doc, pdf_obj *field, char *va
 			else
 				oval = pdf_new_name(doc, "Off");
 
-			pdf_dict_puts(field, "AS", oval);
+			pdf_dict_put(field, PDF_NAME(AS), oval);
 		}
 		fz_always(ctx)
 		{
@@ -1028,10 +1028,10 @@ int pdf_field_display(pdf_document *doc, pdf_obj *field)
 	/* Base response on first of children. Not ideal,
 	 * but not clear how to handle children with
 	 * differing values */
-	while ((kids = pdf_dict_gets(field, "Kids")) != NULL)
+	while ((kids = pdf_dict_get(field, PDF_NAME(Kids))) != NULL)
 		field = pdf_array_get(kids, 0);
 
-	f = pdf_to_int(pdf_dict_gets(field, "F"));
+	f = pdf_to_int(pdf_dict_get(field, PDF_NAME(F)));
 
 	if (f & F_Hidden)
 	{
@@ -1061,8 +1061,8 @@ static char *get_field_name(pdf_document *doc, pdf_obj *field, int spare)
 {
 	fz_context *ctx = doc->ctx;
 	char *res = NULL;
-	pdf_obj *parent = pdf_dict_gets(field, "Parent");
-	char *lname = pdf_to_str_buf(pdf_dict_gets(field, "T"));
+	pdf_obj *parent = pdf_dict_get(field, PDF_NAME(Parent));
+	char *lname = pdf_to_str_buf(pdf_dict_get(field, PDF_NAME(T)));
 	int llen = strlen(lname);
 
 	/*
@@ -1101,12 +1101,12 @@ char *pdf_field_name(pdf_document *doc, pdf_obj *field)
 void pdf_field_set_display(pdf_document *doc, pdf_obj *field, int d)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *kids = pdf_dict_gets(field, "Kids");
+	pdf_obj *kids = pdf_dict_get(field, PDF_NAME(Kids));
 
 	if (!kids)
 	{
 		int mask = (F_Hidden|F_Print|F_NoView);
-		int f = pdf_to_int(pdf_dict_gets(field, "F")) & ~mask;
+		int f = pdf_to_int(pdf_dict_get(field, PDF_NAME(F))) & ~mask;
 		pdf_obj *fo = NULL;
 
 		switch (d)
@@ -1128,7 +1128,7 @@ void pdf_field_set_display(pdf_document *doc, pdf_obj *field, int d)
 		fz_try(ctx)
 		{
 			fo = pdf_new_int(doc, f);
-			pdf_dict_puts(field, "F", fo);
+			pdf_dict_put(field, PDF_NAME(F), fo);
 		}
 		fz_always(ctx)
 		{
@@ -1187,7 +1187,7 @@ void pdf_field_set_text_color(pdf_document *doc, pdf_obj *field, pdf_obj *col)
 		pdf_fzbuf_print_da(ctx, fzbuf, &di);
 		len = fz_buffer_storage(ctx, fzbuf, &buf);
 		daobj = pdf_new_string(doc, (char *)buf, len);
-		pdf_dict_puts(field, "DA", daobj);
+		pdf_dict_put(field, PDF_NAME(DA), daobj);
 		pdf_field_mark_dirty(doc, field);
 	}
 	fz_always(ctx)
@@ -1325,7 +1325,7 @@ int pdf_choice_widget_options(pdf_document *doc, pdf_widget *tw, char *opts[])
 	if (!annot)
 		return 0;
 
-	optarr = pdf_dict_gets(annot->obj, "Opt");
+	optarr = pdf_dict_get(annot->obj, PDF_NAME(Opt));
 	n = pdf_array_len(optarr);
 
 	if (opts)
@@ -1364,7 +1364,7 @@ int pdf_choice_widget_value(pdf_document *doc, pdf_widget *tw, char *opts[])
 	if (!annot)
 		return 0;
 
-	optarr = pdf_dict_gets(annot->obj, "V");
+	optarr = pdf_dict_get(annot->obj, PDF_NAME(V));
 
 	if (pdf_is_string(optarr))
 	{
@@ -1420,18 +1420,18 @@ void pdf_choice_widget_set_value(pdf_document *doc, pdf_widget *tw, int n, char
 				opt = NULL;
 			}
 
-			pdf_dict_puts(annot->obj, "V", optarr);
+			pdf_dict_put(annot->obj, PDF_NAME(V), optarr);
 			pdf_drop_obj(optarr);
 		}
 		else
 		{
 			opt = pdf_new_string(doc, opts[0], strlen(opts[0]));
-			pdf_dict_puts(annot->obj, "V", opt);
+			pdf_dict_put(annot->obj, PDF_NAME(V), opt);
 			pdf_drop_obj(opt);
 		}
 
 		/* FIXME: when n > 1, we should be regenerating the indexes */
-		pdf_dict_dels(annot->obj, "I");
+		pdf_dict_del(annot->obj, PDF_NAME(I));
 
 		pdf_field_mark_dirty(doc, annot->obj);
 		doc->dirty = 1;
@@ -1486,7 +1486,7 @@ void pdf_signature_set_value(pdf_document *doc, pdf_obj *field, pdf_signer *sign
 
 	vnum = pdf_create_object(doc);
 	indv = pdf_new_indirect(doc, vnum, 0);
-	pdf_dict_puts_drop(field, "V", indv);
+	pdf_dict_put_drop(field, PDF_NAME(V), indv);
 
 	fz_var(v);
 	fz_try(ctx)
@@ -1504,13 +1504,13 @@ void pdf_signature_set_value(pdf_document *doc, pdf_obj *field, pdf_signer *sign
 	}
 
 	byte_range = pdf_new_array(doc, 4);
-	pdf_dict_puts_drop(v, "ByteRange", byte_range);
+	pdf_dict_put_drop(v, PDF_NAME(ByteRange), byte_range);
 
 	contents = pdf_new_string(doc, buf, sizeof(buf));
-	pdf_dict_puts_drop(v, "Contents", contents);
+	pdf_dict_put_drop(v, PDF_NAME(Contents), contents);
 
-	pdf_dict_puts_drop(v, "Filter", pdf_new_name(doc, "Adobe.PPKLite"));
-	pdf_dict_puts_drop(v, "SubFilter", pdf_new_name(doc, "adbe.pkcs7.detached"));
+	pdf_dict_put_drop(v, PDF_NAME(Filter), pdf_new_name(doc, "Adobe.PPKLite"));
+	pdf_dict_put_drop(v, PDF_NAME(SubFilter), pdf_new_name(doc, "adbe.pkcs7.detached"));
 
 	/* Record details within the document structure so that contents
 	 * and byte_range can be updated with their correct values at
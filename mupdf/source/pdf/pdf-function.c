@@ -1,6 +1,7 @@
 #include "mupdf/pdf.h"
 
 typedef struct psobj_s psobj;
+typedef struct psinst_s psinst;
 
 enum
 {
@@ -28,6 +29,8 @@ struct pdf_function_s
 			float encode[FZ_FN_MAXM][2];
 			float decode[FZ_FN_MAXN][2];
 			float *samples;
+			/* SumatraPDF: distance between neighboring samples for each input */
+			int scale[FZ_FN_MAXM];
 		} sa;
 
 		struct {
@@ -46,6 +49,8 @@ struct pdf_function_s
 		struct {
 			psobj *code;
 			int cap;
+			/* SumatraPDF: compiled form of code (NULL if it couldn't be compiled) */
+			psinst *prog;
 		} p;
 	} u;
 };
@@ -103,9 +108,11 @@ struct psobj_s
 
 typedef struct ps_stack_s ps_stack;
 
+#define PS_STACK_SIZE 100
+
 struct ps_stack_s
 {
-	psobj stack[100];
+	psobj stack[PS_STACK_SIZE];
 	int sp;
 };
 
@@ -191,19 +198,25 @@ ps_push_int(ps_stack *st, int n)
 	}
 }
 
+static inline float
+ps_fix_real(float n)
+{
+	if (isnan(n))
+	{
+		/* Push 1.0, as it's a small known value that won't
+		 * cause a divide by 0. Same reason as in fz_atof. */
+		n = 1.0;
+	}
+	return fz_clamp(n, -FLT_MAX, FLT_MAX);
+}
+
 static void
 ps_push_real(ps_stack *st, float n)
 {
 	if (!ps_overflow(st, 1))
 	{
 		st->stack[st->sp].type = PS_REAL;
-		if (isnan(n))
-		{
-			/* Push 1.0, as it's a small known value that won't
-			 * cause a divide by 0. Same reason as in fz_atof. */
-			n = 1.0;
-		}
-		st->stack[st->sp].u.f = fz_clamp(n, -FLT_MAX, FLT_MAX);
+		st->stack[st->sp].u.f = ps_fix_real(n);
 		st->sp++;
 	}
 }
@@ -681,6 +694,602 @@ ps_run(fz_context *ctx, psobj *code, ps_stack *st, int pc)
 	}
 }
 
+/*
+ * SumatraPDF: Compiled PostScript calculator
+ *
+ * Most calculator functions leave a stack behind whose depth and types
+ * don't depend on the input values. For these, every stack slot can be
+ * turned into a register and every operator into a single instruction
+ * with known operand types, so that evaluating the function no longer
+ * needs any type checks or stack bookkeeping. Programs for which this
+ * static analysis fails (e.g. a "roll" with a computed count or branches
+ * leaving different stacks behind) are still run through ps_run.
+ */
+
+enum
+{
+	PSC_LDI, PSC_LDR, PSC_MOV, PSC_CVI, PSC_CVR,
+	PSC_ABSI, PSC_ADDI, PSC_ANDI, PSC_BITSHIFT, PSC_IDIV, PSC_MOD,
+	PSC_MULI, PSC_NEGI, PSC_NOTB, PSC_NOTI, PSC_ORI, PSC_SUBI, PSC_XORI,
+	PSC_EQI, PSC_NEI, PSC_GEI, PSC_GTI, PSC_LEI, PSC_LTI,
+	PSC_ABSR, PSC_ADDR, PSC_ATAN, PSC_CEILING, PSC_COS, PSC_DIV,
+	PSC_EXP, PSC_FLOOR, PSC_LN, PSC_LOG, PSC_MULR, PSC_NEGR, PSC_ROUND,
+	PSC_SIN, PSC_SQRT, PSC_SUBR, PSC_TRUNCATE,
+	PSC_EQR, PSC_NER, PSC_GER, PSC_GTR, PSC_LER, PSC_LTR,
+	PSC_JZ, PSC_JMP, PSC_END
+};
+
+/* one register per stack slot plus scratch space for "roll" */
+#define PS_MAX_REGS (2 * PS_STACK_SIZE)
+#define PS_MAX_COMPILED_NESTING 16
+
+typedef union
+{
+	int i;				/* integer and boolean */
+	float f;			/* real */
+} psreg;
+
+struct psinst_s
+{
+	unsigned char op;
+	unsigned char dst, a, b;	/* register numbers */
+	union
+	{
+		int i;			/* integer literal or jump target */
+		float f;		/* real literal */
+	} u;
+};
+
+typedef struct ps_slot_s ps_slot;
+
+struct ps_slot_s
+{
+	unsigned char type;		/* PS_BOOL, PS_INT or PS_REAL */
+	unsigned char is_const;		/* integer with a value known at compile time */
+	int value;
+};
+
+typedef struct ps_compiler_s ps_compiler;
+
+struct ps_compiler_s
+{
+	fz_context *ctx;
+	pdf_function *func;
+	int len, cap;
+	ps_slot slot[PS_MAX_REGS];
+	int sp;
+};
+
+static void
+ps_exec(const psinst *prog, psreg *r)
+{
+	const psinst *ip = prog;
+	int i1, i2;
+	float r1, r2;
+
+	while (1)
+	{
+		switch (ip->op)
+		{
+		case PSC_LDI: r[ip->dst].i = ip->u.i; break;
+		case PSC_LDR: r[ip->dst].f = ip->u.f; break;
+		case PSC_MOV: r[ip->dst] = r[ip->a]; break;
+		case PSC_CVI: r[ip->dst].i = r[ip->a].f; break;
+		case PSC_CVR: r[ip->dst].f = r[ip->a].i; break;
+
+		case PSC_ABSI: r[ip->dst].i = abs(r[ip->a].i); break;
+		case PSC_ADDI: r[ip->dst].i = r[ip->a].i + r[ip->b].i; break;
+		case PSC_ANDI: r[ip->dst].i = r[ip->a].i & r[ip->b].i; break;
+		case PSC_BITSHIFT:
+			i1 = r[ip->a].i;
+			i2 = r[ip->b].i;
+			if (i2 > 0 && i2 < 8 * sizeof (i2))
+				r[ip->dst].i = i1 << i2;
+			else if (i2 < 0 && i2 > -8 * (int)sizeof (i2))
+				r[ip->dst].i = (int)((unsigned int)i1 >> -i2);
+			else
+				r[ip->dst].i = i1;
+			break;
+		case PSC_IDIV:
+			i1 = r[ip->a].i;
+			i2 = r[ip->b].i;
+			r[ip->dst].i = i2 != 0 ? i1 / i2 : DIV_BY_ZERO(i1, i2, INT_MIN, INT_MAX);
+			break;
+		case PSC_MOD:
+			i1 = r[ip->a].i;
+			i2 = r[ip->b].i;
+			r[ip->dst].i = i2 != 0 ? i1 % i2 : DIV_BY_ZERO(i1, i2, INT_MIN, INT_MAX);
+			break;
+		case PSC_MULI: r[ip->dst].i = r[ip->a].i * r[ip->b].i; break;
+		case PSC_NEGI: r[ip->dst].i = -r[ip->a].i; break;
+		case PSC_NOTB: r[ip->dst].i = !r[ip->a].i; break;
+		case PSC_NOTI: r[ip->dst].i = ~r[ip->a].i; break;
+		case PSC_ORI: r[ip->dst].i = r[ip->a].i | r[ip->b].i; break;
+		case PSC_SUBI: r[ip->dst].i = r[ip->a].i - r[ip->b].i; break;
+		case PSC_XORI: r[ip->dst].i = r[ip->a].i ^ r[ip->b].i; break;
+
+		case PSC_EQI: r[ip->dst].i = r[ip->a].i == r[ip->b].i; break;
+		case PSC_NEI: r[ip->dst].i = r[ip->a].i != r[ip->b].i; break;
+		case PSC_GEI: r[ip->dst].i = r[ip->a].i >= r[ip->b].i; break;
+		case PSC_GTI: r[ip->dst].i = r[ip->a].i > r[ip->b].i; break;
+		case PSC_LEI: r[ip->dst].i = r[ip->a].i <= r[ip->b].i; break;
+		case PSC_LTI: r[ip->dst].i = r[ip->a].i < r[ip->b].i; break;
+
+		case PSC_ABSR: r[ip->dst].f = ps_fix_real(fabsf(r[ip->a].f)); break;
+		case PSC_ADDR: r[ip->dst].f = ps_fix_real(r[ip->a].f + r[ip->b].f); break;
+		case PSC_ATAN:
+			r1 = atan2f(r[ip->a].f, r[ip->b].f) * RADIAN;
+			if (r1 < 0)
+				r1 += 360;
+			r[ip->dst].f = ps_fix_real(r1);
+			break;
+		case PSC_CEILING: r[ip->dst].f = ps_fix_real(ceilf(r[ip->a].f)); break;
+		case PSC_COS: r[ip->dst].f = ps_fix_real(cosf(r[ip->a].f/RADIAN)); break;
+		case PSC_DIV:
+			r1 = r[ip->a].f;
+			r2 = r[ip->b].f;
+			if (fabsf(r2) >= FLT_EPSILON)
+				r[ip->dst].f = ps_fix_real(r1 / r2);
+			else
+				r[ip->dst].f = ps_fix_real(DIV_BY_ZERO(r1, r2, -FLT_MAX, FLT_MAX));
+			break;
+		case PSC_EXP: r[ip->dst].f = ps_fix_real(powf(r[ip->a].f, r[ip->b].f)); break;
+		case PSC_FLOOR: r[ip->dst].f = ps_fix_real(floorf(r[ip->a].f)); break;
+		case PSC_LN:
+			/* Bug 692941 - logf as separate statement */
+			r2 = logf(r[ip->a].f);
+			r[ip->dst].f = ps_fix_real(r2);
+			break;
+		case PSC_LOG: r[ip->dst].f = ps_fix_real(log10f(r[ip->a].f)); break;
+		case PSC_MULR: r[ip->dst].f = ps_fix_real(r[ip->a].f * r[ip->b].f); break;
+		case PSC_NEGR: r[ip->dst].f = ps_fix_real(-r[ip->a].f); break;
+		case PSC_ROUND:
+			r1 = r[ip->a].f;
+			r[ip->dst].f = ps_fix_real((r1 >= 0) ? floorf(r1 + 0.5f) : ceilf(r1 - 0.5f));
+			break;
+		case PSC_SIN: r[ip->dst].f = ps_fix_real(sinf(r[ip->a].f/RADIAN)); break;
+		case PSC_SQRT: r[ip->dst].f = ps_fix_real(sqrtf(r[ip->a].f)); break;
+		case PSC_SUBR: r[ip->dst].f = ps_fix_real(r[ip->a].f - r[ip->b].f); break;
+		case PSC_TRUNCATE:
+			r1 = r[ip->a].f;
+			r[ip->dst].f = ps_fix_real((r1 >= 0) ? floorf(r1) : ceilf(r1));
+			break;
+
+		case PSC_EQR: r[ip->dst].i = r[ip->a].f == r[ip->b].f; break;
+		case PSC_NER: r[ip->dst].i = r[ip->a].f != r[ip->b].f; break;
+		case PSC_GER: r[ip->dst].i = r[ip->a].f >= r[ip->b].f; break;
+		case PSC_GTR: r[ip->dst].i = r[ip->a].f > r[ip->b].f; break;
+		case PSC_LER: r[ip->dst].i = r[ip->a].f <= r[ip->b].f; break;
+		case PSC_LTR: r[ip->dst].i = r[ip->a].f < r[ip->b].f; break;
+
+		case PSC_JZ:
+			if (!r[ip->a].i)
+			{
+				ip = prog + ip->u.i;
+				continue;
+			}
+			break;
+		case PSC_JMP:
+			ip = prog + ip->u.i;
+			continue;
+		case PSC_END:
+			return;
+		}
+		ip++;
+	}
+}
+
+static int
+ps_emit(ps_compiler *cc, int op, int dst, int a, int b)
+{
+	psinst *inst;
+
+	if (cc->len == cc->cap)
+	{
+		int new_cap = cc->cap + 64;
+		cc->func->u.p.prog = fz_resize_array(cc->ctx, cc->func->u.p.prog, new_cap, sizeof(psinst));
+		cc->cap = new_cap;
+	}
+	inst = &cc->func->u.p.prog[cc->len];
+	inst->op = op;
+	inst->dst = dst;
+	inst->a = a;
+	inst->b = b;
+	inst->u.i = 0;
+	return cc->len++;
+}
+
+static int
+ps_compile_push(ps_compiler *cc, int type)
+{
+	/* ps_run silently drops values pushed onto a full stack */
+	if (cc->sp + 1 >= PS_STACK_SIZE)
+		return -1;
+	cc->slot[cc->sp].type = type;
+	cc->slot[cc->sp].is_const = 0;
+	cc->slot[cc->sp].value = 0;
+	return cc->sp++;
+}
+
+/* converts a number in place the way ps_pop_int and ps_pop_real do */
+static int
+ps_compile_coerce(ps_compiler *cc, int k, int type)
+{
+	ps_slot *slot = &cc->slot[k];
+
+	if (slot->type == PS_BOOL)
+		return 0;
+	if (slot->type != type)
+	{
+		ps_emit(cc, type == PS_INT ? PSC_CVI : PSC_CVR, k, k, 0);
+		slot->type = type;
+		slot->is_const = 0;
+	}
+	return 1;
+}
+
+/* operators which ps_run only implements for integers have no rop,
+ * operators only implemented for reals have no iop */
+static int
+ps_compile_unary(ps_compiler *cc, int iop, int rop)
+{
+	int a = cc->sp - 1;
+	int type;
+
+	if (cc->sp < 1)
+		return 0;
+	type = iop >= 0 && (rop < 0 || cc->slot[a].type == PS_INT) ? PS_INT : PS_REAL;
+	if (!ps_compile_coerce(cc, a, type))
+		return 0;
+	ps_emit(cc, type == PS_INT ? iop : rop, a, a, 0);
+	cc->slot[a].is_const = 0;
+	return 1;
+}
+
+static int
+ps_compile_binary(ps_compiler *cc, int iop, int rop, int is_cmp)
+{
+	int a = cc->sp - 2, b = cc->sp - 1;
+	int type;
+
+	if (cc->sp < 2)
+		return 0;
+	type = iop >= 0 && (rop < 0 || (cc->slot[a].type == PS_INT && cc->slot[b].type == PS_INT)) ? PS_INT : PS_REAL;
+	if (!ps_compile_coerce(cc, a, type) || !ps_compile_coerce(cc, b, type))
+		return 0;
+	ps_emit(cc, type == PS_INT ? iop : rop, a, a, b);
+	cc->sp--;
+	cc->slot[a].type = is_cmp ? PS_BOOL : type;
+	cc->slot[a].is_const = 0;
+	return 1;
+}
+
+/* booleans are always 0 or 1, so the integer instructions work for them as well */
+static int
+ps_compile_logical(ps_compiler *cc, int op, int ints_only)
+{
+	if (cc->sp < 2)
+		return 0;
+	if (cc->slot[cc->sp - 2].type == PS_BOOL && cc->slot[cc->sp - 1].type == PS_BOOL)
+	{
+		ps_emit(cc, op, cc->sp - 2, cc->sp - 2, cc->sp - 1);
+		cc->sp--;
+		return 1;
+	}
+	if (ints_only && (cc->slot[cc->sp - 2].type != PS_INT || cc->slot[cc->sp - 1].type != PS_INT))
+		return 0;
+	return ps_compile_binary(cc, op, -1, 0);
+}
+
+static int
+ps_compile_pop_const(ps_compiler *cc, int *value)
+{
+	ps_slot *slot;
+
+	if (cc->sp < 1)
+		return 0;
+	slot = &cc->slot[cc->sp - 1];
+	if (slot->type != PS_INT || !slot->is_const)
+		return 0;
+	*value = slot->value;
+	cc->sp--;
+	return 1;
+}
+
+static void
+ps_compile_move(ps_compiler *cc, int dst, int src)
+{
+	ps_emit(cc, PSC_MOV, dst, src, 0);
+	cc->slot[dst] = cc->slot[src];
+}
+
+static int
+ps_compile_copy(ps_compiler *cc, int n)
+{
+	int i;
+
+	/* same conditions as in ps_copy */
+	if (n < 0 || cc->sp - n < 0 || cc->sp + n >= PS_STACK_SIZE)
+		return 1;
+	for (i = 0; i < n; i++)
+		ps_compile_move(cc, cc->sp + i, cc->sp - n + i);
+	cc->sp += n;
+	return 1;
+}
+
+static int
+ps_compile_index(ps_compiler *cc, int n)
+{
+	/* same conditions as in ps_index */
+	if (cc->sp + 1 >= PS_STACK_SIZE || n < 0 || cc->sp - n < 0)
+		return 1;
+	if (n >= cc->sp)
+		return 0;
+	ps_compile_move(cc, cc->sp, cc->sp - n - 1);
+	cc->sp++;
+	return 1;
+}
+
+static int
+ps_compile_roll(ps_compiler *cc, int n, int j)
+{
+	int base = cc->sp - n;
+	int i;
+
+	/* same conditions as in ps_roll */
+	if (n < 0 || cc->sp - n < 0 || j == 0 || n == 0)
+		return 1;
+	if (j >= 0)
+	{
+		j %= n;
+	}
+	else
+	{
+		j = -j % n;
+		if (j != 0)
+			j = n - j;
+	}
+	if (j == 0)
+		return 1;
+
+	/* move the window to the scratch registers above the stack and back */
+	for (i = 0; i < n; i++)
+		ps_compile_move(cc, cc->sp + i, base + i);
+	for (i = 0; i < n; i++)
+		ps_compile_move(cc, base + (i + j) % n, cc->sp + i);
+	return 1;
+}
+
+/* a stack slot is only the same after both branches if it has the same type */
+static int
+ps_compile_merge(ps_compiler *cc, ps_slot *other, int other_sp)
+{
+	int i;
+
+	if (cc->sp != other_sp)
+		return 0;
+	for (i = 0; i < cc->sp; i++)
+	{
+		if (cc->slot[i].type != other[i].type)
+			return 0;
+		if (!other[i].is_const || other[i].value != cc->slot[i].value)
+			cc->slot[i].is_const = 0;
+	}
+	return 1;
+}
+
+static int
+ps_compile_block(ps_compiler *cc, int pc, int nesting)
+{
+	psobj *code = cc->func->u.p.code;
+	ps_slot saved[PS_STACK_SIZE], taken[PS_STACK_SIZE];
+	int saved_sp, taken_sp;
+	int k, n, j, op, inst, jz, jmp;
+
+	if (nesting > PS_MAX_COMPILED_NESTING)
+		return 0;
+
+	while (1)
+	{
+		switch (code[pc].type)
+		{
+		case PS_INT:
+			if ((k = ps_compile_push(cc, PS_INT)) < 0)
+				return 0;
+			inst = ps_emit(cc, PSC_LDI, k, 0, 0);
+			cc->func->u.p.prog[inst].u.i = code[pc].u.i;
+			cc->slot[k].is_const = 1;
+			cc->slot[k].value = code[pc++].u.i;
+			break;
+
+		case PS_REAL:
+			if ((k = ps_compile_push(cc, PS_REAL)) < 0)
+				return 0;
+			inst = ps_emit(cc, PSC_LDR, k, 0, 0);
+			cc->func->u.p.prog[inst].u.f = ps_fix_real(code[pc++].u.f);
+			break;
+
+		case PS_OPERATOR:
+			switch (op = code[pc++].u.op)
+			{
+			case PS_OP_ABS: if (!ps_compile_unary(cc, PSC_ABSI, PSC_ABSR)) return 0; break;
+			case PS_OP_ADD: if (!ps_compile_binary(cc, PSC_ADDI, PSC_ADDR, 0)) return 0; break;
+			case PS_OP_AND: if (!ps_compile_logical(cc, PSC_ANDI, 1)) return 0; break;
+			case PS_OP_ATAN: if (!ps_compile_binary(cc, -1, PSC_ATAN, 0)) return 0; break;
+			case PS_OP_BITSHIFT: if (!ps_compile_binary(cc, PSC_BITSHIFT, -1, 0)) return 0; break;
+			case PS_OP_CEILING: if (!ps_compile_unary(cc, -1, PSC_CEILING)) return 0; break;
+			case PS_OP_COS: if (!ps_compile_unary(cc, -1, PSC_COS)) return 0; break;
+			case PS_OP_DIV: if (!ps_compile_binary(cc, -1, PSC_DIV, 0)) return 0; break;
+			case PS_OP_EXP: if (!ps_compile_binary(cc, -1, PSC_EXP, 0)) return 0; break;
+			case PS_OP_FLOOR: if (!ps_compile_unary(cc, -1, PSC_FLOOR)) return 0; break;
+			case PS_OP_GE: if (!ps_compile_binary(cc, PSC_GEI, PSC_GER, 1)) return 0; break;
+			case PS_OP_GT: if (!ps_compile_binary(cc, PSC_GTI, PSC_GTR, 1)) return 0; break;
+			case PS_OP_IDIV: if (!ps_compile_binary(cc, PSC_IDIV, -1, 0)) return 0; break;
+			case PS_OP_LE: if (!ps_compile_binary(cc, PSC_LEI, PSC_LER, 1)) return 0; break;
+			case PS_OP_LN: if (!ps_compile_unary(cc, -1, PSC_LN)) return 0; break;
+			case PS_OP_LOG: if (!ps_compile_unary(cc, -1, PSC_LOG)) return 0; break;
+			case PS_OP_LT: if (!ps_compile_binary(cc, PSC_LTI, PSC_LTR, 1)) return 0; break;
+			case PS_OP_MOD: if (!ps_compile_binary(cc, PSC_MOD, -1, 0)) return 0; break;
+			case PS_OP_MUL: if (!ps_compile_binary(cc, PSC_MULI, PSC_MULR, 0)) return 0; break;
+			case PS_OP_NEG: if (!ps_compile_unary(cc, PSC_NEGI, PSC_NEGR)) return 0; break;
+			case PS_OP_OR: if (!ps_compile_logical(cc, PSC_ORI, 0)) return 0; break;
+			case PS_OP_SIN: if (!ps_compile_unary(cc, -1, PSC_SIN)) return 0; break;
+			case PS_OP_SQRT: if (!ps_compile_unary(cc, -1, PSC_SQRT)) return 0; break;
+			case PS_OP_SUB: if (!ps_compile_binary(cc, PSC_SUBI, PSC_SUBR, 0)) return 0; break;
+			case PS_OP_XOR: if (!ps_compile_logical(cc, PSC_XORI, 0)) return 0; break;
+
+			case PS_OP_EQ:
+			case PS_OP_NE:
+				if (cc->sp >= 2 && cc->slot[cc->sp - 2].type == PS_BOOL && cc->slot[cc->sp - 1].type == PS_BOOL)
+				{
+					ps_emit(cc, op == PS_OP_EQ ? PSC_EQI : PSC_NEI, cc->sp - 2, cc->sp - 2, cc->sp - 1);
+					cc->sp--;
+				}
+				else if (!ps_compile_binary(cc, op == PS_OP_EQ ? PSC_EQI : PSC_NEI, op == PS_OP_EQ ? PSC_EQR : PSC_NER, 1))
+					return 0;
+				break;
+
+			case PS_OP_CVI:
+			case PS_OP_CVR:
+				if (cc->sp < 1 || !ps_compile_coerce(cc, cc->sp - 1, op == PS_OP_CVI ? PS_INT : PS_REAL))
+					return 0;
+				break;
+
+			case PS_OP_NOT:
+				if (cc->sp < 1)
+					return 0;
+				if (cc->slot[cc->sp - 1].type == PS_BOOL)
+					ps_emit(cc, PSC_NOTB, cc->sp - 1, cc->sp - 1, 0);
+				else if (!ps_compile_unary(cc, PSC_NOTI, -1))
+					return 0;
+				break;
+
+			case PS_OP_ROUND:
+			case PS_OP_TRUNCATE:
+				if (cc->sp < 1 || cc->slot[cc->sp - 1].type == PS_BOOL)
+					return 0;
+				if (cc->slot[cc->sp - 1].type == PS_REAL)
+					ps_emit(cc, op == PS_OP_ROUND ? PSC_ROUND : PSC_TRUNCATE, cc->sp - 1, cc->sp - 1, 0);
+				break;
+
+			case PS_OP_FALSE:
+			case PS_OP_TRUE:
+				if ((k = ps_compile_push(cc, PS_BOOL)) < 0)
+					return 0;
+				inst = ps_emit(cc, PSC_LDI, k, 0, 0);
+				cc->func->u.p.prog[inst].u.i = op == PS_OP_TRUE;
+				break;
+
+			case PS_OP_POP:
+				if (cc->sp > 0)
+					cc->sp--;
+				break;
+
+			case PS_OP_DUP:
+				ps_compile_copy(cc, 1);
+				break;
+
+			case PS_OP_EXCH:
+				ps_compile_roll(cc, 2, 1);
+				break;
+
+			case PS_OP_COPY:
+				if (!ps_compile_pop_const(cc, &n) || !ps_compile_copy(cc, n))
+					return 0;
+				break;
+
+			case PS_OP_INDEX:
+				if (!ps_compile_pop_const(cc, &n) || !ps_compile_index(cc, n))
+					return 0;
+				break;
+
+			case PS_OP_ROLL:
+				if (!ps_compile_pop_const(cc, &j) || !ps_compile_pop_const(cc, &n) || !ps_compile_roll(cc, n, j))
+					return 0;
+				break;
+
+			case PS_OP_IF:
+			case PS_OP_IFELSE:
+				if (cc->sp < 1 || cc->slot[cc->sp - 1].type != PS_BOOL)
+					return 0;
+				cc->sp--;
+				jz = ps_emit(cc, PSC_JZ, 0, cc->sp, 0);
+				memcpy(saved, cc->slot, cc->sp * sizeof(ps_slot));
+				saved_sp = cc->sp;
+				if (!ps_compile_block(cc, code[pc + 1].u.block, nesting + 1))
+					return 0;
+				if (op == PS_OP_IFELSE)
+				{
+					jmp = ps_emit(cc, PSC_JMP, 0, 0, 0);
+					cc->func->u.p.prog[jz].u.i = cc->len;
+					memcpy(taken, cc->slot, cc->sp * sizeof(ps_slot));
+					taken_sp = cc->sp;
+					memcpy(cc->slot, saved, saved_sp * sizeof(ps_slot));
+					cc->sp = saved_sp;
+					if (!ps_compile_block(cc, code[pc + 0].u.block, nesting + 1))
+						return 0;
+					cc->func->u.p.prog[jmp].u.i = cc->len;
+					if (!ps_compile_merge(cc, taken, taken_sp))
+						return 0;
+				}
+				else
+				{
+					cc->func->u.p.prog[jz].u.i = cc->len;
+					if (!ps_compile_merge(cc, saved, saved_sp))
+						return 0;
+				}
+				pc = code[pc + 2].u.block;
+				break;
+
+			case PS_OP_RETURN:
+				return 1;
+
+			default:
+				return 0;
+			}
+			break;
+
+		default:
+			return 0;
+		}
+	}
+}
+
+static void
+ps_compile(fz_context *ctx, pdf_function *func)
+{
+	ps_compiler cc;
+	int i, ok;
+
+	cc.ctx = ctx;
+	cc.func = func;
+	cc.len = cc.cap = 0;
+	cc.sp = 0;
+	func->u.p.prog = NULL;
+
+	for (i = 0; i < func->base.m; i++)
+		ps_compile_push(&cc, PS_REAL);
+
+	ok = ps_compile_block(&cc, 0, 0) && cc.sp >= func->base.n;
+	/* the outputs are the topmost values as reals, moved to the first registers */
+	for (i = 0; ok && i < func->base.n; i++)
+	{
+		ok = ps_compile_coerce(&cc, cc.sp - func->base.n + i, PS_REAL);
+		if (ok && cc.sp - func->base.n > 0)
+			ps_compile_move(&cc, i, cc.sp - func->base.n + i);
+	}
+	if (ok)
+		ps_emit(&cc, PSC_END, 0, 0, 0);
+
+	if (!ok)
+	{
+		fz_free(ctx, func->u.p.prog);
+		func->u.p.prog = NULL;
+		return;
+	}
+	func->base.size += cc.cap * sizeof(psinst);
+}
+
 static void
 resize_code(fz_context *ctx, pdf_function *func, int newsize)
 {
@@ -876,6 +1485,8 @@ load_postscript_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int n
 	}
 
 	func->base.size += func->u.p.cap * sizeof(psobj);
+
+	ps_compile(ctx, func);
 }
 
 static void
@@ -885,6 +1496,21 @@ eval_postscript_func(fz_context *ctx, pdf_function *func, const float *in, float
 	float x;
 	int i;
 
+	/* SumatraPDF: run the compiled program if there is one */
+	if (func->u.p.prog)
+	{
+		psreg reg[PS_MAX_REGS];
+
+		for (i = 0; i < func->base.m; i++)
+			reg[i].f = ps_fix_real(fz_clamp(in[i], func->domain[i][0], func->domain[i][1]));
+
+		ps_exec(func->u.p.prog, reg);
+
+		for (i = 0; i < func->base.n; i++)
+			out[i] = fz_clamp(reg[i].f, func->range[i][0], func->range[i][1]);
+		return;
+	}
+
 	ps_init_stack(&st);
 
 	for (i = 0; i < func->base.m; i++)
@@ -920,7 +1546,7 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 
 	func->u.sa.samples = NULL;
 
-	obj = pdf_dict_gets(dict, "Size");
+	obj = pdf_dict_get(dict, PDF_NAME(Size));
 	if (pdf_array_len(obj) < func->base.m)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "too few sample function dimension sizes");
 	if (pdf_array_len(obj) > func->base.m)
@@ -935,7 +1561,7 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 		}
 	}
 
-	obj = pdf_dict_gets(dict, "BitsPerSample");
+	obj = pdf_dict_get(dict, PDF_NAME(BitsPerSample));
 	func->u.sa.bps = bps = pdf_to_int(obj);
 
 	for (i = 0; i < func->base.m; i++)
@@ -943,7 +1569,7 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 		func->u.sa.encode[i][0] = 0;
 		func->u.sa.encode[i][1] = func->u.sa.size[i] - 1;
 	}
-	obj = pdf_dict_gets(dict, "Encode");
+	obj = pdf_dict_get(dict, PDF_NAME(Encode));
 	if (pdf_is_array(obj))
 	{
 		int ranges = fz_mini(func->base.m, pdf_array_len(obj) / 2);
@@ -963,7 +1589,7 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 		func->u.sa.decode[i][1] = func->range[i][1];
 	}
 
-	obj = pdf_dict_gets(dict, "Decode");
+	obj = pdf_dict_get(dict, PDF_NAME(Decode));
 	if (pdf_is_array(obj))
 	{
 		int ranges = fz_mini(func->base.n, pdf_array_len(obj) / 2);
@@ -983,6 +1609,10 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 	if (samplecount > MAX_SAMPLE_FUNCTION_SIZE)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "sample function too large");
 
+	func->u.sa.scale[0] = func->base.n;
+	for (i = 1; i < func->base.m; i++)
+		func->u.sa.scale[i] = func->u.sa.scale[i - 1] * func->u.sa.size[i - 1];
+
 	func->u.sa.samples = fz_malloc_array(ctx, samplecount, sizeof(float));
 	func->base.size += samplecount * sizeof(float);
 
@@ -1036,6 +1666,9 @@ load_sample_func(pdf_function *func, pdf_document *doc, pdf_obj *dict, int num,
 	fz_close(stream);
 }
 
+/* SumatraPDF: sample functions with up to this many inputs are interpolated without recursion */
+#define MAX_FLAT_SAMPLE_INPUTS 8
+
 static float
 interpolate_sample(pdf_function *func, int *scale, int *e0, int *e1, float *efrac, int dim, int idx)
 {
@@ -1062,10 +1695,13 @@ interpolate_sample(pdf_function *func, int *scale, int *e0, int *e1, float *efra
 static void
 eval_sample_func(fz_context *ctx, pdf_function *func, const float *in, float *out)
 {
-	int e0[FZ_FN_MAXM], e1[FZ_FN_MAXM], scale[FZ_FN_MAXM];
+	int e0[FZ_FN_MAXM], e1[FZ_FN_MAXM];
+	int *scale = func->u.sa.scale;
 	float efrac[FZ_FN_MAXM];
+	int corner[1 << MAX_FLAT_SAMPLE_INPUTS];
+	float v[1 << MAX_FLAT_SAMPLE_INPUTS];
 	float x;
-	int i;
+	int i, k, d, count;
 
 	/* encode input coordinates */
 	for (i = 0; i < func->base.m; i++)
@@ -1079,9 +1715,17 @@ eval_sample_func(fz_context *ctx, pdf_function *func, const float *in, float *ou
 		efrac[i] = x - floorf(x);
 	}
 
-	scale[0] = func->base.n;
-	for (i = 1; i < func->base.m; i++)
-		scale[i] = scale[i - 1] * func->u.sa.size[i-1];
+	/* SumatraPDF: for more than two inputs, find the offsets of the 2^m
+	 * samples surrounding the input point once for all outputs */
+	if (func->base.m > 2 && func->base.m <= MAX_FLAT_SAMPLE_INPUTS)
+	{
+		corner[0] = 0;
+		for (d = 0; d < func->base.m; d++)
+			corner[0] += e0[d] * scale[d];
+		for (d = 0; d < func->base.m; d++)
+			for (k = 0; k < 1 << d; k++)
+				corner[k | 1 << d] = corner[k] + (e1[d] - e0[d]) * scale[d];
+	}
 
 	for (i = 0; i < func->base.n; i++)
 	{
@@ -1114,6 +1758,24 @@ eval_sample_func(fz_context *ctx, pdf_function *func, const float *in, float *ou
 			out[i] = fz_clamp(out[i], func->range[i][0], func->range[i][1]);
 		}
 
+		else if (func->base.m <= MAX_FLAT_SAMPLE_INPUTS)
+		{
+			/* interpolate along one input after the other, in the same
+			 * order (and thus with the same result) as interpolate_sample */
+			count = 1 << func->base.m;
+			for (k = 0; k < count; k++)
+				v[k] = func->u.sa.samples[corner[k] + i];
+			for (d = 0; d < func->base.m; d++)
+			{
+				count >>= 1;
+				for (k = 0; k < count; k++)
+					v[k] = v[2 * k] + (v[2 * k + 1] - v[2 * k]) * efrac[d];
+			}
+
+			out[i] = lerp(v[0], 0, 1, func->u.sa.decode[i][0], func->u.sa.decode[i][1]);
+			out[i] = fz_clamp(out[i], func->range[i][0], func->range[i][1]);
+		}
+
 		else
 		{
 			x = interpolate_sample(func, scale, e0, e1, efrac, func->base.m - 1, i);
@@ -1137,7 +1799,7 @@ load_exponential_func(fz_context *ctx, pdf_function *func, pdf_obj *dict)
 		fz_warn(ctx, "exponential functions have at most one input");
 	func->base.m = 1;
 
-	obj = pdf_dict_gets(dict, "N");
+	obj = pdf_dict_get(dict, PDF_NAME(N));
 	func->u.e.n = pdf_to_real(obj);
 
 	/* See exponential functions (PDF 1.7 section 3.9.2) */
@@ -1163,7 +1825,7 @@ load_exponential_func(fz_context *ctx, pdf_function *func, pdf_obj *dict)
 		func->u.e.c1[i] = 1;
 	}
 
-	obj = pdf_dict_gets(dict, "C0");
+	obj = pdf_dict_get(dict, PDF_NAME(C0));
 	if (pdf_is_array(obj))
 	{
 		int ranges = fz_mini(func->base.n, pdf_array_len(obj));
@@ -1174,7 +1836,7 @@ load_exponential_func(fz_context *ctx, pdf_function *func, pdf_obj *dict)
 			func->u.e.c0[i] = pdf_to_real(pdf_array_get(obj, i));
 	}
 
-	obj = pdf_dict_gets(dict, "C1");
+	obj = pdf_dict_get(dict, PDF_NAME(C1));
 	if (pdf_is_array(obj))
 	{
 		int ranges = fz_mini(func->base.n, pdf_array_len(obj));
@@ -1229,7 +1891,7 @@ load_stitching_func(pdf_function *func, pdf_document *doc, pdf_obj *dict)
 		fz_warn(ctx, "stitching functions have at most one input");
 	func->base.m = 1;
 
-	obj = pdf_dict_gets(dict, "Functions");
+	obj = pdf_dict_get(dict, PDF_NAME(Functions));
 	if (!pdf_is_array(obj))
 		fz_throw(ctx, FZ_ERROR_GENERIC, "stitching function has no input functions");
 
@@ -1266,7 +1928,7 @@ load_stitching_func(pdf_function *func, pdf_document *doc, pdf_obj *dict)
 		fz_rethrow(ctx);
 	}
 
-	obj = pdf_dict_gets(dict, "Bounds");
+	obj = pdf_dict_get(dict, PDF_NAME(Bounds));
 	if (!pdf_is_array(obj))
 		fz_throw(ctx, FZ_ERROR_GENERIC, "stitching function has no bounds");
 	{
@@ -1294,7 +1956,7 @@ load_stitching_func(pdf_function *func, pdf_document *doc, pdf_obj *dict)
 		func->u.st.encode[i * 2 + 1] = 0;
 	}
 
-	obj = pdf_dict_gets(dict, "Encode");
+	obj = pdf_dict_get(dict, PDF_NAME(Encode));
 	if (pdf_is_array(obj))
 	{
 		int ranges = fz_mini(k, pdf_array_len(obj) / 2);
@@ -1377,6 +2039,7 @@ pdf_free_function_imp(fz_context *ctx, fz_storable *func_)
 		break;
 	case POSTSCRIPT:
 		fz_free(ctx, func->u.p.code);
+		fz_free(ctx, func->u.p.prog);
 		break;
 	}
 	fz_free(ctx, func);
@@ -1643,11 +2306,11 @@ pdf_load_function(pdf_document *doc, pdf_obj *dict, int in, int out)
 	func->base.debug = pdf_debug_function;
 #endif
 
-	obj = pdf_dict_gets(dict, "FunctionType");
+	obj = pdf_dict_get(dict, PDF_NAME(FunctionType));
 	func->type = pdf_to_int(obj);
 
 	/* required for all */
-	obj = pdf_dict_gets(dict, "Domain");
+	obj = pdf_dict_get(dict, PDF_NAME(Domain));
 	func->base.m = fz_clampi(pdf_array_len(obj) / 2, 1, FZ_FN_MAXM);
 	for (i = 0; i < func->base.m; i++)
 	{
@@ -1656,7 +2319,7 @@ pdf_load_function(pdf_document *doc, pdf_obj *dict, int in, int out)
 	}
 
 	/* required for type0 and type4, optional otherwise */
-	obj = pdf_dict_gets(dict, "Range");
+	obj = pdf_dict_get(dict, PDF_NAME(Range));
 	if (pdf_is_array(obj))
 	{
 		func->has_range = 1;
@@ -54,13 +54,13 @@ pdf_load_image_imp(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict, fz_stream *cs
 			break; /* Out of fz_try */
 		}
 
-		w = pdf_to_int(pdf_dict_getsa(dict, "Width", "W"));
-		h = pdf_to_int(pdf_dict_getsa(dict, "Height", "H"));
-		bpc = pdf_to_int(pdf_dict_getsa(dict, "BitsPerComponent", "BPC"));
+		w = pdf_to_int(pdf_dict_geta(dict, PDF_NAME(Width), PDF_NAME(W)));
+		h = pdf_to_int(pdf_dict_geta(dict, PDF_NAME(Height), PDF_NAME(H)));
+		bpc = pdf_to_int(pdf_dict_geta(dict, PDF_NAME(BitsPerComponent), PDF_NAME(BPC)));
 		if (bpc == 0)
 			bpc = 8;
-		imagemask = pdf_to_bool(pdf_dict_getsa(dict, "ImageMask", "IM"));
-		interpolate = pdf_to_bool(pdf_dict_getsa(dict, "Interpolate", "I"));
+		imagemask = pdf_to_bool(pdf_dict_geta(dict, PDF_NAME(ImageMask), PDF_NAME(IM)));
+		interpolate = pdf_to_bool(pdf_dict_geta(dict, PDF_NAME(Interpolate), PDF_NAME(I)));
 
 		indexed = 0;
 		usecolorkey = 0;
@@ -81,13 +81,13 @@ pdf_load_image_imp(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict, fz_stream *cs
 		if (h > (1 << 16))
 			fz_throw(ctx, FZ_ERROR_GENERIC, "image is too high");
 
-		obj = pdf_dict_getsa(dict, "ColorSpace", "CS");
+		obj = pdf_dict_geta(dict, PDF_NAME(ColorSpace), PDF_NAME(CS));
 		if (obj && !imagemask && !forcemask)
 		{
 			/* colorspace resource lookup is only done for inline images */
 			if (pdf_is_name(obj))
 			{
-				res = pdf_dict_get(pdf_dict_gets(rdb, "ColorSpace"), obj);
+				res = pdf_dict_get(pdf_dict_get(rdb, PDF_NAME(ColorSpace)), obj);
 				if (res)
 					obj = res;
 			}
@@ -102,7 +102,7 @@ pdf_load_image_imp(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict, fz_stream *cs
 			n = 1;
 		}
 
-		obj = pdf_dict_getsa(dict, "Decode", "D");
+		obj = pdf_dict_geta(dict, PDF_NAME(Decode), PDF_NAME(D));
 		if (obj)
 		{
 			for (i = 0; i < n * 2; i++)
@@ -115,7 +115,7 @@ pdf_load_image_imp(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict, fz_stream *cs
 				decode[i] = i & 1 ? maxval : 0;
 		}
 
-		obj = pdf_dict_getsa(dict, "SMask", "Mask");
+		obj = pdf_dict_geta(dict, PDF_NAME(SMask), PDF_NAME(Mask));
 		if (pdf_is_dict(obj))
 		{
 			/* Not allowed for inline images or soft masks */
@@ -200,12 +200,12 @@ pdf_is_jpx_image(fz_context *ctx, pdf_obj *dict)
 	pdf_obj *filter;
 	int i, n;
 
-	filter = pdf_dict_gets(dict, "Filter");
-	if (!strcmp(pdf_to_name(filter), "JPXDecode"))
+	filter = pdf_dict_get(dict, PDF_NAME(Filter));
+	if (pdf_name_eq(filter, PDF_NAME(JPXDecode)))
 		return 1;
 	n = pdf_array_len(filter);
 	for (i = 0; i < n; i++)
-		if (!strcmp(pdf_to_name(pdf_array_get(filter, i)), "JPXDecode"))
+		if (pdf_name_eq(pdf_array_get(filter, i), PDF_NAME(JPXDecode)))
 			return 1;
 	return 0;
 }
@@ -231,7 +231,7 @@ pdf_load_jpx(pdf_document *doc, pdf_obj *dict, int forcemask)
 	/* FIXME: We can't handle decode arrays for indexed images currently */
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(dict, "ColorSpace");
+		obj = pdf_dict_get(dict, PDF_NAME(ColorSpace));
 		if (obj)
 		{
 			colorspace = pdf_load_colorspace(doc, obj);
@@ -240,7 +240,7 @@ pdf_load_jpx(pdf_document *doc, pdf_obj *dict, int forcemask)
 
 		img = fz_load_jpx(ctx, buf->data, buf->len, colorspace, indexed);
 
-		obj = pdf_dict_getsa(dict, "SMask", "Mask");
+		obj = pdf_dict_geta(dict, PDF_NAME(SMask), PDF_NAME(Mask));
 		if (pdf_is_dict(obj))
 		{
 			if (forcemask)
@@ -249,7 +249,7 @@ pdf_load_jpx(pdf_document *doc, pdf_obj *dict, int forcemask)
 				mask = pdf_load_image_imp(doc, NULL, obj, NULL, 1);
 		}
 
-		obj = pdf_dict_getsa(dict, "Decode", "D");
+		obj = pdf_dict_geta(dict, PDF_NAME(Decode), PDF_NAME(D));
 		if (obj && !indexed)
 		{
 			float decode[FZ_MAX_COLORS * 2];
@@ -541,7 +541,7 @@ pdf_process_annot(pdf_document *doc, pdf_page *page, pdf_annot *annot, const pdf
 	csi = pdf_new_csi(doc, cookie, process);
 	fz_try(ctx)
 	{
-		flags = pdf_to_int(pdf_dict_gets(annot->obj, "F"));
+		flags = pdf_to_int(pdf_dict_get(annot->obj, PDF_NAME(F)));
 
 		/* Check not invisible (bit 0) and hidden (bit 1) */
 		/* TODO: NoZoom and NoRotate */
@@ -22,6 +22,41 @@
 #define RANGE_A_F \
 	'A':case'B':case'C':case'D':case'E':case'F'
 
+/*
+ * Character classes for scanning directly over the stream buffer
+ * (between f->rp and f->wp). The scanners below consume as much as
+ * they can from the buffer and fall back to fz_read_byte when they
+ * reach its end.
+ */
+enum
+{
+	LEX_WHITE = 1,
+	LEX_DELIM = 2,
+	LEX_NAME = 4, /* regular characters except '#' */
+	LEX_STRING = 8, /* literal string characters except '(', ')' and '\\' */
+	LEX_HEX = 16
+};
+
+static const unsigned char lex_class[256] =
+{
+	 9, 12, 12, 12, 12, 12, 12, 12, 12,  9,  9, 12,  9,  9, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	 9, 12, 12,  8, 12, 10, 12, 12,  2,  2, 12, 12, 12, 12, 12, 10,
+	28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 12, 12, 10, 12, 10, 12,
+	12, 28, 28, 28, 28, 28, 28, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 10,  4, 10, 12, 12,
+	12, 28, 28, 28, 28, 28, 28, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 10, 12, 10, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+};
+
 static inline int iswhite(int ch)
 {
 	return
@@ -45,20 +80,42 @@ static void
 lex_white(fz_stream *f)
 {
 	int c;
-	do {
+	while (1)
+	{
+		unsigned char *p = f->rp;
+		while (p < f->wp && (lex_class[*p] & LEX_WHITE))
+			p++;
+		f->rp = p;
+		if (p < f->wp)
+			return;
 		c = fz_read_byte(f);
-	} while ((c <= 32) && (iswhite(c)));
-	if (c != EOF)
+		if (c == EOF)
+			return;
 		fz_unread_byte(f);
+		if (!iswhite(c))
+			return;
+	}
 }
 
 static void
 lex_comment(fz_stream *f)
 {
 	int c;
-	do {
+	while (1)
+	{
+		unsigned char *p = f->rp;
+		while (p < f->wp && *p != '\012' && *p != '\015')
+			p++;
+		if (p < f->wp)
+		{
+			f->rp = p + 1;
+			return;
+		}
+		f->rp = p;
 		c = fz_read_byte(f);
-	} while ((c != '\012') && (c != '\015') && (c != EOF));
+		if ((c == '\012') || (c == '\015') || (c == EOF))
+			return;
+	}
 }
 
 static int
@@ -164,7 +221,18 @@ lex_name(fz_stream *f, pdf_lexbuf *buf)
 
 	while (n > 1)
 	{
-		int c = fz_read_byte(f);
+		unsigned char *p = f->rp;
+		unsigned char *e = f->wp - p < n - 1 ? f->wp : p + n - 1;
+		int c;
+
+		while (p < e && (lex_class[*p] & LEX_NAME))
+			*s++ = *p++;
+		n -= p - f->rp;
+		f->rp = p;
+		if (n <= 1)
+			break;
+
+		c = fz_read_byte(f);
 		switch (c)
 		{
 		case IS_WHITE:
@@ -246,11 +314,22 @@ lex_string(fz_stream *f, pdf_lexbuf *lb)
 
 	while (1)
 	{
+		unsigned char *p, *pe;
+
 		if (s == e)
 		{
 			s += pdf_lexbuf_grow(lb);
 			e = lb->scratch + lb->size;
 		}
+
+		p = f->rp;
+		pe = f->wp - p < e - s ? f->wp : p + (e - s);
+		while (p < pe && (lex_class[*p] & LEX_STRING))
+			*s++ = *p++;
+		f->rp = p;
+		if (s == e)
+			continue;
+
 		c = fz_read_byte(f);
 		switch (c)
 		{
@@ -348,6 +427,20 @@ lex_hex_string(fz_stream *f, pdf_lexbuf *lb)
 			s += pdf_lexbuf_grow(lb);
 			e = lb->scratch + lb->size;
 		}
+
+		if (!x)
+		{
+			unsigned char *p = f->rp;
+			while (p + 1 < f->wp && s < e && (lex_class[p[0]] & lex_class[p[1]] & LEX_HEX))
+			{
+				*s++ = unhex(p[0]) * 16 + unhex(p[1]);
+				p += 2;
+			}
+			f->rp = p;
+			if (s == e)
+				continue;
+		}
+
 		c = fz_read_byte(f);
 		switch (c)
 		{
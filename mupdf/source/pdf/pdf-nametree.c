@@ -3,8 +3,8 @@
 static pdf_obj *
 pdf_lookup_name_imp(fz_context *ctx, pdf_obj *node, pdf_obj *needle)
 {
-	pdf_obj *kids = pdf_dict_gets(node, "Kids");
-	pdf_obj *names = pdf_dict_gets(node, "Names");
+	pdf_obj *kids = pdf_dict_get(node, PDF_NAME(Kids));
+	pdf_obj *names = pdf_dict_get(node, PDF_NAME(Names));
 
 	if (pdf_is_array(kids))
 	{
@@ -15,7 +15,7 @@ pdf_lookup_name_imp(fz_context *ctx, pdf_obj *node, pdf_obj *needle)
 		{
 			int m = (l + r) >> 1;
 			pdf_obj *kid = pdf_array_get(kids, m);
-			pdf_obj *limits = pdf_dict_gets(kid, "Limits");
+			pdf_obj *limits = pdf_dict_get(kid, PDF_NAME(Limits));
 			pdf_obj *first = pdf_array_get(limits, 0);
 			pdf_obj *last = pdf_array_get(limits, 1);
 
@@ -74,8 +74,8 @@ pdf_lookup_name(pdf_document *doc, char *which, pdf_obj *needle)
 {
 	fz_context *ctx = doc->ctx;
 
-	pdf_obj *root = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pdf_obj *names = pdf_dict_gets(root, "Names");
+	pdf_obj *root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pdf_obj *names = pdf_dict_get(root, PDF_NAME(Names));
 	pdf_obj *tree = pdf_dict_gets(names, which);
 	return pdf_lookup_name_imp(ctx, tree, needle);
 }
@@ -85,9 +85,9 @@ pdf_lookup_dest(pdf_document *doc, pdf_obj *needle)
 {
 	fz_context *ctx = doc->ctx;
 
-	pdf_obj *root = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pdf_obj *dests = pdf_dict_gets(root, "Dests");
-	pdf_obj *names = pdf_dict_gets(root, "Names");
+	pdf_obj *root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pdf_obj *dests = pdf_dict_get(root, PDF_NAME(Dests));
+	pdf_obj *names = pdf_dict_get(root, PDF_NAME(Names));
 	pdf_obj *dest = NULL;
 
 	/* PDF 1.1 has destinations in a dictionary */
@@ -102,7 +102,7 @@ pdf_lookup_dest(pdf_document *doc, pdf_obj *needle)
 	/* PDF 1.2 has destinations in a name tree */
 	if (names && !dest)
 	{
-		pdf_obj *tree = pdf_dict_gets(names, "Dests");
+		pdf_obj *tree = pdf_dict_get(names, PDF_NAME(Dests));
 		return pdf_lookup_name_imp(ctx, tree, needle);
 	}
 
@@ -113,8 +113,8 @@ static void
 pdf_load_name_tree_imp(pdf_obj *dict, pdf_document *doc, pdf_obj *node)
 {
 	fz_context *ctx = doc->ctx;
-	pdf_obj *kids = pdf_dict_gets(node, "Kids");
-	pdf_obj *names = pdf_dict_gets(node, "Names");
+	pdf_obj *kids = pdf_dict_get(node, PDF_NAME(Kids));
+	pdf_obj *names = pdf_dict_get(node, PDF_NAME(Names));
 	int i;
 
 	UNUSED(ctx);
@@ -151,8 +151,8 @@ pdf_load_name_tree_imp(pdf_obj *dict, pdf_document *doc, pdf_obj *node)
 pdf_obj *
 pdf_load_name_tree(pdf_document *doc, char *which)
 {
-	pdf_obj *root = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pdf_obj *names = pdf_dict_gets(root, "Names");
+	pdf_obj *root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pdf_obj *names = pdf_dict_get(root, PDF_NAME(Names));
 	pdf_obj *tree = pdf_dict_gets(names, which);
 	if (pdf_is_dict(tree))
 	{
@@ -62,6 +62,39 @@ struct pdf_obj_s
 	} u;
 };
 
+/* constant name objects are small integers (see PDF_NAME) */
+#define OBJ_IS_ATOM(obj) ((size_t)(obj) - 1 < PDF_OBJ_ENUM_NAME__LIMIT - 1)
+#define OBJ_IS_PTR(obj) ((size_t)(obj) >= PDF_OBJ_ENUM_NAME__LIMIT)
+
+static char *PDF_NAME_LIST[] =
+{
+	"",
+#define PDF_MAKE_NAME(STRING,NAME) STRING,
+#include "mupdf/pdf/name-table.h"
+#undef PDF_MAKE_NAME
+};
+
+static pdf_obj *
+pdf_find_atom(const char *str)
+{
+	int l = 1;
+	int r = PDF_OBJ_ENUM_NAME__LIMIT - 1;
+
+	while (l <= r)
+	{
+		int m = (l + r) >> 1;
+		int c = strcmp(str, PDF_NAME_LIST[m]);
+		if (c < 0)
+			r = m - 1;
+		else if (c > 0)
+			l = m + 1;
+		else
+			return (pdf_obj *)(intptr_t)m;
+	}
+
+	return NULL;
+}
+
 pdf_obj *
 pdf_new_null(pdf_document *doc)
 {
@@ -143,6 +176,9 @@ pdf_new_name(pdf_document *doc, const char *str)
 {
 	pdf_obj *obj;
 	fz_context *ctx = doc->ctx;
+	obj = pdf_find_atom(str);
+	if (obj)
+		return obj;
 	obj = Memento_label(fz_malloc(ctx, offsetof(pdf_obj, u.n) + strlen(str) + 1), "pdf_obj(name)");
 	obj->doc = doc;
 	obj->refs = 1;
@@ -176,19 +212,19 @@ pdf_new_indirect(pdf_document *doc, int num, int gen)
 pdf_obj *
 pdf_keep_obj(pdf_obj *obj)
 {
-	if (obj)
+	if (OBJ_IS_PTR(obj))
 		obj->refs ++;
 	return obj;
 }
 
 int pdf_is_indirect(pdf_obj *obj)
 {
-	return obj ? obj->kind == PDF_INDIRECT : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_INDIRECT : 0;
 }
 
 #define RESOLVE(obj) \
 	do { \
-		if (obj && obj->kind == PDF_INDIRECT) \
+		if (OBJ_IS_PTR(obj) && obj->kind == PDF_INDIRECT) \
 		{\
 			obj = pdf_resolve_indirect(obj); \
 		} \
@@ -197,61 +233,63 @@ int pdf_is_indirect(pdf_obj *obj)
 int pdf_is_null(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_NULL : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_NULL : 0;
 }
 
 int pdf_is_bool(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_BOOL : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_BOOL : 0;
 }
 
 int pdf_is_int(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_INT : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_INT : 0;
 }
 
 int pdf_is_real(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_REAL : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_REAL : 0;
 }
 
 int pdf_is_number(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? (obj->kind == PDF_REAL || obj->kind == PDF_INT) : 0;
+	return OBJ_IS_PTR(obj) ? (obj->kind == PDF_REAL || obj->kind == PDF_INT) : 0;
 }
 
 int pdf_is_string(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_STRING : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_STRING : 0;
 }
 
 int pdf_is_name(pdf_obj *obj)
 {
 	RESOLVE(obj);
+	if (OBJ_IS_ATOM(obj))
+		return 1;
 	return obj ? obj->kind == PDF_NAME : 0;
 }
 
 int pdf_is_array(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_ARRAY : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_ARRAY : 0;
 }
 
 int pdf_is_dict(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return obj ? obj->kind == PDF_DICT : 0;
+	return OBJ_IS_PTR(obj) ? obj->kind == PDF_DICT : 0;
 }
 
 int pdf_to_bool(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	return obj->kind == PDF_BOOL ? obj->u.b : 0;
 }
@@ -259,7 +297,7 @@ int pdf_to_bool(pdf_obj *obj)
 int pdf_to_int(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	if (obj->kind == PDF_INT)
 		return obj->u.i;
@@ -271,7 +309,7 @@ int pdf_to_int(pdf_obj *obj)
 float pdf_to_real(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	if (obj->kind == PDF_REAL)
 		return obj->u.f;
@@ -283,7 +321,9 @@ float pdf_to_real(pdf_obj *obj)
 char *pdf_to_name(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_NAME)
+	if (OBJ_IS_ATOM(obj))
+		return PDF_NAME_LIST[(intptr_t)obj];
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_NAME)
 		return "";
 	return obj->u.n;
 }
@@ -291,7 +331,7 @@ char *pdf_to_name(pdf_obj *obj)
 char *pdf_to_str_buf(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_STRING)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_STRING)
 		return "";
 	return obj->u.s.buf;
 }
@@ -299,14 +339,14 @@ char *pdf_to_str_buf(pdf_obj *obj)
 int pdf_to_str_len(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_STRING)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_STRING)
 		return 0;
 	return obj->u.s.len;
 }
 
 void pdf_set_int(pdf_obj *obj, int i)
 {
-	if (!obj || obj->kind != PDF_INT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_INT)
 		return;
 	obj->u.i = i;
 }
@@ -315,7 +355,7 @@ void pdf_set_int(pdf_obj *obj, int i)
 void pdf_set_str_len(pdf_obj *obj, int newlen)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_STRING)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_STRING)
 		return; /* This should never happen */
 	if (newlen > obj->u.s.len)
 		return; /* This should never happen */
@@ -325,26 +365,26 @@ void pdf_set_str_len(pdf_obj *obj, int newlen)
 pdf_obj *pdf_to_dict(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	return (obj && obj->kind == PDF_DICT ? obj : NULL);
+	return (OBJ_IS_PTR(obj) && obj->kind == PDF_DICT ? obj : NULL);
 }
 
 int pdf_to_num(pdf_obj *obj)
 {
-	if (!obj || obj->kind != PDF_INDIRECT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_INDIRECT)
 		return 0;
 	return obj->u.r.num;
 }
 
 int pdf_to_gen(pdf_obj *obj)
 {
-	if (!obj || obj->kind != PDF_INDIRECT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_INDIRECT)
 		return 0;
 	return obj->u.r.gen;
 }
 
 pdf_document *pdf_get_indirect_document(pdf_obj *obj)
 {
-	if (!obj || obj->kind != PDF_INDIRECT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_INDIRECT)
 		return NULL;
 	return obj->doc;
 }
@@ -360,6 +400,13 @@ pdf_objcmp(pdf_obj *a, pdf_obj *b)
 	if (!a || !b)
 		return 1;
 
+	if (OBJ_IS_ATOM(a) || OBJ_IS_ATOM(b))
+	{
+		if (!pdf_is_name(a) || !pdf_is_name(b))
+			return 1;
+		return strcmp(pdf_to_name(a), pdf_to_name(b));
+	}
+
 	if (a->kind != b->kind)
 		return 1;
 
@@ -428,11 +475,28 @@ pdf_objcmp(pdf_obj *a, pdf_obj *b)
 	return 1;
 }
 
+int
+pdf_name_eq(pdf_obj *a, pdf_obj *b)
+{
+	RESOLVE(a);
+	RESOLVE(b);
+	if (a == b)
+		return 1;
+	/* a name listed in name-table.h only ever exists as its constant */
+	if (OBJ_IS_ATOM(a) && OBJ_IS_ATOM(b))
+		return 0;
+	if (!pdf_is_name(a) || !pdf_is_name(b))
+		return 0;
+	return !strcmp(pdf_to_name(a), pdf_to_name(b));
+}
+
 static char *
 pdf_objkindstr(pdf_obj *obj)
 {
 	if (!obj)
 		return "<NULL>";
+	if (OBJ_IS_ATOM(obj))
+		return "name";
 	switch (obj->kind)
 	{
 	case PDF_NULL: return "null";
@@ -502,7 +566,7 @@ pdf_copy_array(pdf_obj *obj)
 	fz_context *ctx = obj->doc->ctx;
 
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return NULL; /* Can't warn :( */
 	if (obj->kind != PDF_ARRAY)
 		fz_warn(ctx, "assert: not an array (%s)", pdf_objkindstr(obj));
@@ -519,7 +583,7 @@ int
 pdf_array_len(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_ARRAY)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_ARRAY)
 		return 0;
 	return obj->u.a.len;
 }
@@ -529,7 +593,7 @@ pdf_array_get(pdf_obj *obj, int i)
 {
 	RESOLVE(obj);
 
-	if (!obj || obj->kind != PDF_ARRAY)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_ARRAY)
 		return NULL;
 
 	if (i < 0 || i >= obj->u.a.len)
@@ -544,7 +608,13 @@ static void object_altered(pdf_obj *obj, pdf_obj *val)
 	parent_num = 0 while an object is being parsed from the file.
 	No further action is necessary.
 	*/
-	if (obj->parent_num == 0 || obj->doc->freeze_updates)
+	if (obj->parent_num == 0)
+		return;
+
+	/* SumatraPDF: the page tree index caches the page order and inherited values */
+	pdf_page_tree_altered(obj->doc, obj->parent_num);
+
+	if (obj->doc->freeze_updates)
 		return;
 
 	/*
@@ -561,7 +631,7 @@ pdf_array_put(pdf_obj *obj, int i, pdf_obj *item)
 {
 	RESOLVE(obj);
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_ARRAY)
 		fz_warn(obj->doc->ctx, "assert: not an array (%s)", pdf_objkindstr(obj));
@@ -583,7 +653,7 @@ pdf_array_push(pdf_obj *obj, pdf_obj *item)
 {
 	RESOLVE(obj);
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_ARRAY)
 		fz_warn(obj->doc->ctx, "assert: not an array (%s)", pdf_objkindstr(obj));
@@ -622,7 +692,7 @@ pdf_array_insert(pdf_obj *obj, pdf_obj *item, int i)
 {
 	RESOLVE(obj);
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_ARRAY)
 		fz_warn(obj->doc->ctx, "assert: not an array (%s)", pdf_objkindstr(obj));
@@ -663,7 +733,7 @@ pdf_array_delete(pdf_obj *obj, int i)
 {
 	RESOLVE(obj);
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_ARRAY)
 		fz_warn(obj->doc->ctx, "assert: not an array (%s)", pdf_objkindstr(obj));
@@ -851,7 +921,7 @@ pdf_copy_dict(pdf_obj *obj)
 	pdf_document *doc;
 
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return NULL; /* Can't warn :( */
 	doc = obj->doc;
 	if (obj->kind != PDF_DICT)
@@ -869,7 +939,7 @@ int
 pdf_dict_len(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_DICT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return 0;
 	return obj->u.d.len;
 }
@@ -878,7 +948,7 @@ pdf_obj *
 pdf_dict_get_key(pdf_obj *obj, int i)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_DICT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return NULL;
 
 	if (i < 0 || i >= obj->u.d.len)
@@ -891,7 +961,7 @@ pdf_obj *
 pdf_dict_get_val(pdf_obj *obj, int i)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_DICT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return NULL;
 
 	if (i < 0 || i >= obj->u.d.len)
@@ -945,13 +1015,31 @@ pdf_dict_finds(pdf_obj *obj, const char *key, int *location)
 	return -1;
 }
 
+static int
+pdf_dict_find(pdf_obj *obj, pdf_obj *key, int *location)
+{
+	if (OBJ_IS_ATOM(key) && !(obj->flags & PDF_FLAGS_SORTED))
+	{
+		int i;
+		for (i = 0; i < obj->u.d.len; i++)
+			if (obj->u.d.items[i].k == key)
+				return i;
+
+		if (location)
+			*location = obj->u.d.len;
+		return -1;
+	}
+
+	return pdf_dict_finds(obj, pdf_to_name(key), location);
+}
+
 pdf_obj *
 pdf_dict_gets(pdf_obj *obj, const char *key)
 {
 	int i;
 
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_DICT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return NULL;
 
 	i = pdf_dict_finds(obj, key, NULL);
@@ -994,9 +1082,29 @@ pdf_dict_getp(pdf_obj *obj, const char *keys)
 pdf_obj *
 pdf_dict_get(pdf_obj *obj, pdf_obj *key)
 {
-	if (!key || key->kind != PDF_NAME)
+	int i;
+
+	RESOLVE(obj);
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return NULL;
-	return pdf_dict_gets(obj, pdf_to_name(key));
+	if (!pdf_is_name(key))
+		return NULL;
+
+	i = pdf_dict_find(obj, key, NULL);
+	if (i >= 0)
+		return obj->u.d.items[i].v;
+
+	return NULL;
+}
+
+pdf_obj *
+pdf_dict_geta(pdf_obj *obj, pdf_obj *key, pdf_obj *abbrev)
+{
+	pdf_obj *v;
+	v = pdf_dict_get(obj, key);
+	if (v)
+		return v;
+	return pdf_dict_get(obj, abbrev);
 }
 
 pdf_obj *
@@ -1017,7 +1125,7 @@ pdf_dict_put(pdf_obj *obj, pdf_obj *key, pdf_obj *val)
 	int i;
 
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_DICT)
 	{
@@ -1026,7 +1134,7 @@ pdf_dict_put(pdf_obj *obj, pdf_obj *key, pdf_obj *val)
 	}
 
 	RESOLVE(key);
-	if (!key || key->kind != PDF_NAME)
+	if (!pdf_is_name(key))
 	{
 		fz_warn(obj->doc->ctx, "assert: key is not a name (%s)", pdf_objkindstr(obj));
 		return;
@@ -1043,7 +1151,7 @@ pdf_dict_put(pdf_obj *obj, pdf_obj *key, pdf_obj *val)
 	if (obj->u.d.len > 100 && !(obj->flags & PDF_FLAGS_SORTED))
 		pdf_sort_dict(obj);
 
-	i = pdf_dict_finds(obj, s, &location);
+	i = pdf_dict_find(obj, key, &location);
 	if (i >= 0 && i < obj->u.d.len)
 	{
 		if (obj->u.d.items[i].v != val)
@@ -1072,6 +1180,25 @@ pdf_dict_put(pdf_obj *obj, pdf_obj *key, pdf_obj *val)
 	object_altered(obj, val);
 }
 
+void
+pdf_dict_put_drop(pdf_obj *obj, pdf_obj *key, pdf_obj *val)
+{
+	fz_context *ctx = obj->doc->ctx;
+
+	fz_try(ctx)
+	{
+		pdf_dict_put(obj, key, val);
+	}
+	fz_always(ctx)
+	{
+		pdf_drop_obj(val);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
+}
+
 void
 pdf_dict_puts(pdf_obj *obj, const char *key, pdf_obj *val)
 {
@@ -1198,12 +1325,22 @@ pdf_dict_putp_drop(pdf_obj *obj, const char *keys, pdf_obj *val)
 	}
 }
 
+static void
+pdf_dict_remove(pdf_obj *obj, int i)
+{
+	pdf_drop_obj(obj->u.d.items[i].k);
+	pdf_drop_obj(obj->u.d.items[i].v);
+	obj->flags &= ~PDF_FLAGS_SORTED;
+	obj->u.d.items[i] = obj->u.d.items[obj->u.d.len-1];
+	obj->u.d.len --;
+}
+
 void
 pdf_dict_dels(pdf_obj *obj, const char *key)
 {
 	RESOLVE(obj);
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return; /* Can't warn :( */
 	if (obj->kind != PDF_DICT)
 		fz_warn(obj->doc->ctx, "assert: not a dict (%s)", pdf_objkindstr(obj));
@@ -1211,13 +1348,7 @@ pdf_dict_dels(pdf_obj *obj, const char *key)
 	{
 		int i = pdf_dict_finds(obj, key, NULL);
 		if (i >= 0)
-		{
-			pdf_drop_obj(obj->u.d.items[i].k);
-			pdf_drop_obj(obj->u.d.items[i].v);
-			obj->flags &= ~PDF_FLAGS_SORTED;
-			obj->u.d.items[i] = obj->u.d.items[obj->u.d.len-1];
-			obj->u.d.len --;
-		}
+			pdf_dict_remove(obj, i);
 	}
 
 	object_altered(obj, NULL);
@@ -1226,18 +1357,29 @@ pdf_dict_dels(pdf_obj *obj, const char *key)
 void
 pdf_dict_del(pdf_obj *obj, pdf_obj *key)
 {
+	RESOLVE(obj);
 	RESOLVE(key);
-	if (!key || key->kind != PDF_NAME)
+
+	if (!OBJ_IS_PTR(obj))
+		return; /* Can't warn :( */
+	if (!pdf_is_name(key))
 		fz_warn(obj->doc->ctx, "assert: key is not a name (%s)", pdf_objkindstr(obj));
+	else if (obj->kind != PDF_DICT)
+		fz_warn(obj->doc->ctx, "assert: not a dict (%s)", pdf_objkindstr(obj));
 	else
-		pdf_dict_dels(obj, key->u.n);
+	{
+		int i = pdf_dict_find(obj, key, NULL);
+		if (i >= 0)
+			pdf_dict_remove(obj, i);
+		object_altered(obj, NULL);
+	}
 }
 
 void
 pdf_sort_dict(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj || obj->kind != PDF_DICT)
+	if (!OBJ_IS_PTR(obj) || obj->kind != PDF_DICT)
 		return;
 	if (!(obj->flags & PDF_FLAGS_SORTED))
 	{
@@ -1250,7 +1392,7 @@ int
 pdf_obj_marked(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	return !!(obj->flags & PDF_FLAGS_MARKED);
 }
@@ -1260,7 +1402,7 @@ pdf_mark_obj(pdf_obj *obj)
 {
 	int marked;
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	marked = !!(obj->flags & PDF_FLAGS_MARKED);
 	obj->flags |= PDF_FLAGS_MARKED;
@@ -1271,7 +1413,7 @@ void
 pdf_unmark_obj(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return;
 	obj->flags &= ~PDF_FLAGS_MARKED;
 }
@@ -1279,6 +1421,8 @@ pdf_unmark_obj(pdf_obj *obj)
 void
 pdf_set_obj_memo(pdf_obj *obj, int memo)
 {
+	if (!OBJ_IS_PTR(obj))
+		return;
 	obj->flags |= PDF_FLAGS_MEMO;
 	if (memo)
 		obj->flags |= PDF_FLAGS_MEMO_BOOL;
@@ -1289,6 +1433,8 @@ pdf_set_obj_memo(pdf_obj *obj, int memo)
 int
 pdf_obj_memo(pdf_obj *obj, int *memo)
 {
+	if (!OBJ_IS_PTR(obj))
+		return 0;
 	if (!(obj->flags & PDF_FLAGS_MEMO))
 		return 0;
 	*memo = !!(obj->flags & PDF_FLAGS_MEMO_BOOL);
@@ -1298,7 +1444,7 @@ pdf_obj_memo(pdf_obj *obj, int *memo)
 int pdf_obj_is_dirty(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return 0;
 	return !!(obj->flags & PDF_FLAGS_DIRTY);
 }
@@ -1306,14 +1452,14 @@ int pdf_obj_is_dirty(pdf_obj *obj)
 void pdf_dirty_obj(pdf_obj *obj)
 {
 	RESOLVE(obj);
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return;
 	obj->flags |= PDF_FLAGS_DIRTY;
 }
 
 void pdf_clean_obj(pdf_obj *obj)
 {
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return;
 	obj->flags &= ~PDF_FLAGS_DIRTY;
 }
@@ -1349,7 +1495,7 @@ pdf_free_dict(pdf_obj *obj)
 void
 pdf_drop_obj(pdf_obj *obj)
 {
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return;
 	if (--obj->refs)
 		return;
@@ -1366,7 +1512,7 @@ pdf_set_obj_parent(pdf_obj *obj, int num)
 {
 	int n, i;
 
-	if (!obj)
+	if (!OBJ_IS_PTR(obj))
 		return;
 
 	obj->parent_num = num;
@@ -1388,6 +1534,8 @@ pdf_set_obj_parent(pdf_obj *obj, int num)
 
 int pdf_obj_parent_num(pdf_obj *obj)
 {
+	if (!OBJ_IS_PTR(obj))
+		return 0;
 	return obj->parent_num;
 }
 
@@ -1781,5 +1929,5 @@ pdf_print_ref(pdf_obj *ref)
 
 int pdf_obj_refs(pdf_obj *ref)
 {
-	return (ref ? ref->refs : 0);
+	return (OBJ_IS_PTR(ref) ? ref->refs : 0);
 }
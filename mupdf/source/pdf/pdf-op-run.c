@@ -164,7 +164,7 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 	/* If we've been handed a name, look it up in the properties. */
 	if (pdf_is_name(ocg))
 	{
-		ocg = pdf_dict_gets(pdf_dict_gets(rdb, "Properties"), pdf_to_name(ocg));
+		ocg = pdf_dict_gets(pdf_dict_get(rdb, PDF_NAME(Properties)), pdf_to_name(ocg));
 	}
 	/* If we haven't been given an ocg at all, then we're visible */
 	if (!ocg)
@@ -173,7 +173,7 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 	fz_strlcpy(event_state, pr->event, sizeof event_state);
 	fz_strlcat(event_state, "State", sizeof event_state);
 
-	type = pdf_to_name(pdf_dict_gets(ocg, "Type"));
+	type = pdf_to_name(pdf_dict_get(ocg, PDF_NAME(Type)));
 
 	if (strcmp(type, "OCG") == 0)
 	{
@@ -196,7 +196,7 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 
 		/* Check Intents; if our intent is not part of the set given
 		 * by the current config, we should ignore it. */
-		obj = pdf_dict_gets(ocg, "Intent");
+		obj = pdf_dict_get(ocg, PDF_NAME(Intent));
 		if (pdf_is_name(obj))
 		{
 			/* If it doesn't match, it's hidden */
@@ -232,7 +232,7 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 		 * correspond to entries in the AS list in the OCG config.
 		 * Given that we don't handle Zoom or User, or Language
 		 * dicts, this is not really a problem. */
-		obj = pdf_dict_gets(ocg, "Usage");
+		obj = pdf_dict_get(ocg, PDF_NAME(Usage));
 		if (!pdf_is_dict(obj))
 			return default_value;
 		/* FIXME: Should look at Zoom (and return hidden if out of
@@ -256,12 +256,12 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 		char *name;
 		int combine, on;
 
-		obj = pdf_dict_gets(ocg, "VE");
+		obj = pdf_dict_get(ocg, PDF_NAME(VE));
 		if (pdf_is_array(obj)) {
 			/* FIXME: Calculate visibility from array */
 			return 0;
 		}
-		name = pdf_to_name(pdf_dict_gets(ocg, "P"));
+		name = pdf_to_name(pdf_dict_get(ocg, PDF_NAME(P)));
 		/* Set combine; Bit 0 set => AND, Bit 1 set => true means
 		 * Off, otherwise true means On */
 		if (strcmp(name, "AllOn") == 0)
@@ -285,7 +285,7 @@ pdf_is_hidden_ocg(pdf_obj *ocg, pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb)
 			return 0; /* Should never happen */
 		fz_try(ctx)
 		{
-			obj = pdf_dict_gets(ocg, "OCGs");
+			obj = pdf_dict_get(ocg, PDF_NAME(OCGs));
 			on = combine & 1;
 			if (pdf_is_array(obj)) {
 				int i, len;
@@ -1667,7 +1667,7 @@ pdf_run_extgstate(pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb, pdf_obj *extgst
 					gstate->softmask_tr = NULL;
 				}
 
-				group = pdf_dict_gets(val, "G");
+				group = pdf_dict_get(val, PDF_NAME(G));
 				if (!group)
 					fz_throw(ctx, FZ_ERROR_GENERIC, "cannot load softmask xobject (%d %d R)", pdf_to_num(val), pdf_to_gen(val));
 				xobj = pdf_load_xobject(csi->doc, group);
@@ -1683,25 +1683,25 @@ pdf_run_extgstate(pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb, pdf_obj *extgst
 				for (k = 0; k < colorspace->n; k++)
 					gstate->softmask_bc[k] = 0;
 
-				bc = pdf_dict_gets(val, "BC");
+				bc = pdf_dict_get(val, PDF_NAME(BC));
 				if (pdf_is_array(bc))
 				{
 					for (k = 0; k < colorspace->n; k++)
 						gstate->softmask_bc[k] = pdf_to_real(pdf_array_get(bc, k));
 				}
 
-				luminosity = pdf_dict_gets(val, "S");
-				if (pdf_is_name(luminosity) && !strcmp(pdf_to_name(luminosity), "Luminosity"))
+				luminosity = pdf_dict_get(val, PDF_NAME(S));
+				if (pdf_is_name(luminosity) && pdf_name_eq(luminosity, PDF_NAME(Luminosity)))
 					gstate->luminosity = 1;
 				else
 					gstate->luminosity = 0;
 
-				tr = pdf_dict_gets(val, "TR");
+				tr = pdf_dict_get(val, PDF_NAME(TR));
 				/* SumatraPDF: support transfer functions */
 				if (tr)
 					gstate->softmask_tr = pdf_load_transfer_function(csi->doc, tr, 0);
 			}
-			else if (pdf_is_name(val) && !strcmp(pdf_to_name(val), "None"))
+			else if (pdf_is_name(val) && pdf_name_eq(val, PDF_NAME(None)))
 			{
 				if (gstate->softmask)
 				{
@@ -1712,7 +1712,7 @@ pdf_run_extgstate(pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb, pdf_obj *extgst
 		}
 
 		/* SumatraPDF: support transfer functions */
-		else if ((!strcmp(s, "TR") && !pdf_dict_gets(extgstate, "TR2")) || !strcmp(s, "TR2"))
+		else if ((!strcmp(s, "TR") && !pdf_dict_get(extgstate, PDF_NAME(TR2))) || !strcmp(s, "TR2"))
 		{
 			fz_drop_transfer_function(ctx, gstate->tr);
 			gstate->tr = NULL;
@@ -1721,6 +1721,330 @@ pdf_run_extgstate(pdf_csi *csi, pdf_run_state *pr, pdf_obj *rdb, pdf_obj *extgst
 	}
 }
 
+/* SumatraPDF: cache display lists for repeatedly used Form XObjects */
+
+#define FORM_CACHE_VARIANTS 4
+
+typedef struct pdf_form_state_s pdf_form_state;
+typedef struct pdf_form_cache_s pdf_form_cache;
+
+/* everything a form's content stream inherits from the place it is
+ * invoked from (except for the CTM and the clip, which are applied when
+ * replaying the recorded display list) */
+struct pdf_form_state_s
+{
+	int iteration;
+	pdf_obj *resources;
+	const char *event;
+	int hints;
+	fz_stroke_state *stroke_state;
+	pdf_material stroke;
+	pdf_material fill;
+	float char_space;
+	float word_space;
+	float scale;
+	float leading;
+	pdf_font_desc *font;
+	float size;
+	int render;
+	float rise;
+	int blendmode;
+};
+
+struct pdf_form_cache_s
+{
+	fz_storable storable;
+	int len;
+	pdf_form_state state[FORM_CACHE_VARIANTS];
+	fz_display_list *list[FORM_CACHE_VARIANTS];
+	unsigned int size;
+};
+
+static void
+pdf_keep_form_state(fz_context *ctx, pdf_form_state *state)
+{
+	pdf_keep_obj(state->resources);
+	fz_keep_stroke_state(ctx, state->stroke_state);
+	pdf_keep_material(ctx, &state->stroke);
+	pdf_keep_material(ctx, &state->fill);
+	if (state->font)
+		pdf_keep_font(ctx, state->font);
+}
+
+static void
+pdf_drop_form_state(fz_context *ctx, pdf_form_state *state)
+{
+	pdf_drop_obj(state->resources);
+	fz_drop_stroke_state(ctx, state->stroke_state);
+	pdf_drop_material(ctx, &state->stroke);
+	pdf_drop_material(ctx, &state->fill);
+	if (state->font)
+		pdf_drop_font(ctx, state->font);
+}
+
+static void
+pdf_free_form_cache_imp(fz_context *ctx, fz_storable *cache_)
+{
+	pdf_form_cache *cache = (pdf_form_cache *)cache_;
+	int i;
+
+	for (i = 0; i < cache->len; i++)
+	{
+		pdf_drop_form_state(ctx, &cache->state[i]);
+		fz_drop_display_list(ctx, cache->list[i]);
+	}
+	fz_free(ctx, cache);
+}
+
+static void
+pdf_copy_material_state(pdf_material *dst, pdf_material *src)
+{
+	int i, n = src->colorspace ? src->colorspace->n : 0;
+
+	dst->kind = src->kind;
+	if (src->kind != PDF_MAT_COLOR)
+		return;
+	dst->colorspace = src->colorspace;
+	dst->alpha = src->alpha;
+	for (i = 0; i < n && i < FZ_MAX_COLORS; i++)
+		dst->v[i] = src->v[i];
+}
+
+/* returns 0 if the form's content depends on state a display list can't
+ * capture (patterns and soft masks are positioned absolutely, etc.) */
+static int
+pdf_get_form_state(pdf_run_state *pr, pdf_obj *resources, pdf_xobject *xobj, pdf_form_state *state)
+{
+	pdf_gstate *gstate = pr->gstate + pr->gtop;
+
+	/* Type 3 glyphs are cached by other means */
+	if (pr->nested_depth > 0 || pr->in_hidden_ocg > 0)
+		return 0;
+	if (!pdf_is_indirect(xobj->me) || !xobj->contents)
+		return 0;
+	if (gstate->fill.kind != PDF_MAT_NONE && gstate->fill.kind != PDF_MAT_COLOR)
+		return 0;
+	if (gstate->stroke.kind != PDF_MAT_NONE && gstate->stroke.kind != PDF_MAT_COLOR)
+		return 0;
+	if (gstate->softmask || gstate->tr || gstate->softmask_tr)
+		return 0;
+
+	/* zero out all padding so that states can be compared with memcmp */
+	memset(state, 0, sizeof(pdf_form_state));
+	state->iteration = xobj->iteration;
+	state->resources = resources;
+	state->event = pr->event;
+	state->hints = pr->dev->hints;
+	state->stroke_state = gstate->stroke_state;
+	pdf_copy_material_state(&state->stroke, &gstate->stroke);
+	pdf_copy_material_state(&state->fill, &gstate->fill);
+	state->char_space = gstate->char_space;
+	state->word_space = gstate->word_space;
+	state->scale = gstate->scale;
+	state->leading = gstate->leading;
+	state->font = gstate->font;
+	state->size = gstate->size;
+	state->render = gstate->render;
+	state->rise = gstate->rise;
+	state->blendmode = gstate->blendmode;
+
+	return 1;
+}
+
+static int
+pdf_form_state_eq(pdf_form_state *a, pdf_form_state *b)
+{
+	fz_stroke_state *sa = a->stroke_state, *sb = b->stroke_state;
+	pdf_form_state tmp;
+
+	if (sa != sb)
+	{
+		/* stroke states are often copied without being modified */
+		if (sa->start_cap != sb->start_cap || sa->dash_cap != sb->dash_cap || sa->end_cap != sb->end_cap ||
+			sa->linejoin != sb->linejoin || sa->linewidth != sb->linewidth ||
+			sa->miterlimit != sb->miterlimit || sa->dash_phase != sb->dash_phase ||
+			sa->dash_len != sb->dash_len ||
+			memcmp(sa->dash_list, sb->dash_list, sa->dash_len * sizeof(float)) != 0)
+			return 0;
+	}
+
+	/* copy including padding */
+	memcpy(&tmp, b, sizeof(pdf_form_state));
+	tmp.stroke_state = a->stroke_state;
+	return !memcmp(a, &tmp, sizeof(pdf_form_state));
+}
+
+static fz_display_list *
+pdf_record_form(pdf_csi *csi, pdf_run_state *pr, pdf_obj *resources, pdf_xobject *xobj, int *complete)
+{
+	fz_context *ctx = pr->ctx;
+	fz_display_list *list = fz_new_display_list(ctx);
+	fz_device *dev = NULL;
+	fz_device *save_dev = pr->dev;
+	fz_matrix save_gparent_ctm = pr->gstate[pr->gparent].ctm;
+	int save_gbot = pr->gbot;
+	int errors = csi->cookie ? csi->cookie->errors : 0;
+
+	fz_var(dev);
+
+	fz_try(ctx)
+	{
+		dev = fz_new_list_device(ctx, list);
+		dev->hints = save_dev->hints;
+
+		/* record in form space (the CTM is applied when replaying) and
+		 * make sure that all clips and gstates pushed by the content
+		 * stream are also popped while recording */
+		pdf_gsave(pr);
+		pr->gbot = pr->gtop;
+		pr->gstate[pr->gtop].ctm = fz_identity;
+		pr->gstate[pr->gparent].ctm = fz_identity;
+		pr->dev = dev;
+
+		pdf_process_contents_object(csi, resources, xobj->contents);
+	}
+	fz_always(ctx)
+	{
+		if (pr->dev == dev)
+		{
+			pr->gbot = save_gbot;
+			pdf_grestore(pr);
+		}
+		pr->dev = save_dev;
+		pr->gstate[pr->gparent].ctm = save_gparent_ctm;
+		fz_free_device(dev);
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_display_list(ctx, list);
+		fz_rethrow(ctx);
+	}
+
+	/* don't cache incomplete content */
+	*complete = !csi->cookie || (!csi->cookie->abort && csi->cookie->errors == errors);
+
+	return list;
+}
+
+static void
+pdf_store_form(fz_context *ctx, pdf_xobject *xobj, pdf_form_cache *old, pdf_form_state *state, fz_display_list *list)
+{
+	pdf_form_cache *cache = fz_malloc_struct(ctx, pdf_form_cache);
+	int i, skip;
+
+	FZ_INIT_STORABLE(cache, 1, pdf_free_form_cache_imp);
+	cache->size = sizeof(pdf_form_cache);
+	if (list)
+	{
+		memcpy(&cache->state[0], state, sizeof(pdf_form_state));
+		pdf_keep_form_state(ctx, &cache->state[0]);
+		cache->list[0] = fz_keep_display_list(ctx, list);
+		cache->size += fz_display_list_size(ctx, list);
+		cache->len = 1;
+	}
+	/* keep the most recently recorded variants */
+	skip = old && old->len == FORM_CACHE_VARIANTS ? 1 : 0;
+	for (i = 0; old && i < old->len - skip && cache->len < FORM_CACHE_VARIANTS; i++)
+	{
+		memcpy(&cache->state[cache->len], &old->state[i], sizeof(pdf_form_state));
+		pdf_keep_form_state(ctx, &cache->state[cache->len]);
+		cache->list[cache->len] = fz_keep_display_list(ctx, old->list[i]);
+		cache->size += fz_display_list_size(ctx, old->list[i]);
+		cache->len++;
+	}
+
+	if (old)
+		pdf_remove_item(ctx, pdf_free_form_cache_imp, xobj->me);
+	pdf_store_item(ctx, xobj->me, cache, cache->size);
+	fz_drop_storable(ctx, &cache->storable);
+}
+
+/* Forms are interpreted directly when first used. From then on, their
+ * content is recorded into a display list once per inherited state and
+ * that list is replayed instead of reinterpreting the content stream */
+static void
+pdf_run_form_contents(pdf_csi *csi, pdf_run_state *pr, pdf_obj *resources, pdf_xobject *xobj)
+{
+	fz_context *ctx = pr->ctx;
+	fz_matrix ctm = pr->gstate[pr->gtop].ctm;
+	pdf_form_cache *cache;
+	fz_display_list *list = NULL;
+	pdf_form_state state;
+	int i, complete, progress, progress_max;
+
+	if (!pdf_get_form_state(pr, resources, xobj, &state))
+	{
+		pdf_process_contents_object(csi, resources, xobj->contents);
+		return;
+	}
+
+	cache = pdf_find_item(ctx, pdf_free_form_cache_imp, xobj->me);
+	for (i = 0; cache && i < cache->len && !list; i++)
+	{
+		if (pdf_form_state_eq(&cache->state[i], &state))
+			list = fz_keep_display_list(ctx, cache->list[i]);
+	}
+
+	if (!cache)
+	{
+		/* remember having seen this form, but don't record it just yet */
+		fz_try(ctx)
+		{
+			pdf_store_form(ctx, xobj, NULL, NULL, NULL);
+		}
+		fz_catch(ctx)
+		{
+			fz_rethrow_if(ctx, FZ_ERROR_TRYLATER);
+		}
+		pdf_process_contents_object(csi, resources, xobj->contents);
+		return;
+	}
+
+	fz_var(list);
+
+	fz_try(ctx)
+	{
+		if (!list)
+		{
+			list = pdf_record_form(csi, pr, resources, xobj, &complete);
+			if (complete)
+			{
+				fz_try(ctx)
+				{
+					pdf_store_form(ctx, xobj, cache, &state, list);
+				}
+				fz_catch(ctx)
+				{
+					fz_rethrow_if(ctx, FZ_ERROR_TRYLATER);
+				}
+			}
+		}
+		/* the replay can be aborted and counts its errors like the
+		 * content stream would, but it mustn't reset the progress of
+		 * the content stream the form is invoked from */
+		if (csi->cookie)
+		{
+			progress = csi->cookie->progress;
+			progress_max = csi->cookie->progress_max;
+		}
+		fz_run_display_list(list, pr->dev, &ctm, &fz_infinite_rect, csi->cookie);
+		if (csi->cookie)
+		{
+			csi->cookie->progress += progress;
+			csi->cookie->progress_max = progress_max;
+		}
+	}
+	fz_always(ctx)
+	{
+		fz_drop_display_list(ctx, list);
+		fz_drop_storable(ctx, &cache->storable);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
+}
+
 static void
 run_xobject(pdf_csi *csi, void *state, pdf_obj *resources, pdf_xobject *xobj, const fz_matrix *transform)
 {
@@ -1789,7 +2113,8 @@ run_xobject(pdf_csi *csi, void *state, pdf_obj *resources, pdf_xobject *xobj, co
 		if (xobj->resources)
 			resources = xobj->resources;
 
-		pdf_process_contents_object(csi, resources, xobj->contents);
+		/* SumatraPDF: cache display lists for repeatedly used Form XObjects */
+		pdf_run_form_contents(csi, pr, resources, xobj);
 	}
 	fz_always(ctx)
 	{
@@ -1842,7 +2167,7 @@ static void pdf_run_BDC(pdf_csi *csi, void *state)
 
 	if (pdf_is_name(csi->obj))
 	{
-		ocg = pdf_dict_gets(pdf_dict_gets(rdb, "Properties"), pdf_to_name(csi->obj));
+		ocg = pdf_dict_gets(pdf_dict_get(rdb, PDF_NAME(Properties)), pdf_to_name(csi->obj));
 	}
 	else
 		ocg = csi->obj;
@@ -1853,7 +2178,7 @@ static void pdf_run_BDC(pdf_csi *csi, void *state)
 		 * means visible. */
 		return;
 	}
-	if (strcmp(pdf_to_name(pdf_dict_gets(ocg, "Type")), "OCG") != 0)
+	if (strcmp(pdf_to_name(pdf_dict_get(ocg, PDF_NAME(Type))), "OCG") != 0)
 	{
 		/* Wrong type of property */
 		return;
@@ -1929,7 +2254,7 @@ static void pdf_run_cs_imp(pdf_csi *csi, pdf_run_state *pr, int what)
 			colorspace = fz_device_cmyk(ctx); /* No fz_keep_colorspace as static */
 		else
 		{
-			dict = pdf_dict_gets(rdb, "ColorSpace");
+			dict = pdf_dict_get(rdb, PDF_NAME(ColorSpace));
 			if (!dict)
 				fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find ColorSpace dictionary");
 			obj = pdf_dict_gets(dict, csi->name);
@@ -1975,7 +2300,7 @@ static void pdf_run_Do(pdf_csi *csi, void *state)
 	pdf_obj *subtype;
 	pdf_obj *rdb = csi->rdb;
 
-	dict = pdf_dict_gets(rdb, "XObject");
+	dict = pdf_dict_get(rdb, PDF_NAME(XObject));
 	if (!dict)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find XObject dictionary when looking for: '%s'", csi->name);
 
@@ -1983,17 +2308,17 @@ static void pdf_run_Do(pdf_csi *csi, void *state)
 	if (!obj)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find xobject resource: '%s'", csi->name);
 
-	subtype = pdf_dict_gets(obj, "Subtype");
+	subtype = pdf_dict_get(obj, PDF_NAME(Subtype));
 	if (!pdf_is_name(subtype))
 		fz_throw(ctx, FZ_ERROR_GENERIC, "no XObject subtype specified");
 
-	if (pdf_is_hidden_ocg(pdf_dict_gets(obj, "OC"), csi, pr, rdb))
+	if (pdf_is_hidden_ocg(pdf_dict_get(obj, PDF_NAME(OC)), csi, pr, rdb))
 		return;
 
-	if (!strcmp(pdf_to_name(subtype), "Form") && pdf_dict_gets(obj, "Subtype2"))
-		subtype = pdf_dict_gets(obj, "Subtype2");
+	if (pdf_name_eq(subtype, PDF_NAME(Form)) && pdf_dict_get(obj, PDF_NAME(Subtype2)))
+		subtype = pdf_dict_get(obj, PDF_NAME(Subtype2));
 
-	if (!strcmp(pdf_to_name(subtype), "Form"))
+	if (pdf_name_eq(subtype, PDF_NAME(Form)))
 	{
 		pdf_xobject *xobj;
 
@@ -2017,7 +2342,7 @@ static void pdf_run_Do(pdf_csi *csi, void *state)
 		}
 	}
 
-	else if (!strcmp(pdf_to_name(subtype), "Image"))
+	else if (pdf_name_eq(subtype, PDF_NAME(Image)))
 	{
 		if ((pr->dev->hints & FZ_IGNORE_IMAGE) == 0)
 		{
@@ -2038,7 +2363,7 @@ static void pdf_run_Do(pdf_csi *csi, void *state)
 		}
 	}
 
-	else if (!strcmp(pdf_to_name(subtype), "PS"))
+	else if (pdf_name_eq(subtype, PDF_NAME(PS)))
 	{
 		fz_warn(ctx, "ignoring XObject with subtype PS");
 	}
@@ -2166,7 +2491,7 @@ static void pdf_run_SC_imp(pdf_csi *csi, pdf_run_state *pr, int what, pdf_materi
 		break;
 
 	case PDF_MAT_PATTERN:
-		dict = pdf_dict_gets(rdb, "Pattern");
+		dict = pdf_dict_get(rdb, PDF_NAME(Pattern));
 		if (!dict)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find Pattern dictionary");
 
@@ -2174,7 +2499,7 @@ static void pdf_run_SC_imp(pdf_csi *csi, pdf_run_state *pr, int what, pdf_materi
 		if (!obj)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find pattern resource '%s'", csi->name);
 
-		patterntype = pdf_dict_gets(obj, "PatternType");
+		patterntype = pdf_dict_get(obj, PDF_NAME(PatternType));
 
 		if (pdf_to_int(patterntype) == 1)
 		{
@@ -2268,7 +2593,7 @@ static void pdf_run_Tf(pdf_csi *csi, void *state)
 		pdf_drop_font(ctx, gstate->font);
 	gstate->font = NULL;
 
-	dict = pdf_dict_gets(rdb, "Font");
+	dict = pdf_dict_get(rdb, PDF_NAME(Font));
 	if (!dict)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find Font dictionary");
 
@@ -2489,7 +2814,7 @@ static void pdf_run_gs(pdf_csi *csi, void *state)
 	fz_context *ctx = csi->doc->ctx;
 	pdf_obj *rdb = csi->rdb;
 
-	dict = pdf_dict_gets(rdb, "ExtGState");
+	dict = pdf_dict_get(rdb, PDF_NAME(ExtGState));
 	if (!dict)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find ExtGState dictionary");
 
@@ -2611,7 +2936,7 @@ static void pdf_run_sh(pdf_csi *csi, void *state)
 	pdf_obj *obj;
 	fz_shade *shd;
 
-	dict = pdf_dict_gets(rdb, "Shading");
+	dict = pdf_dict_get(rdb, PDF_NAME(Shading));
 	if (!dict)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find shading dictionary");
 
@@ -2740,10 +3065,10 @@ process_annot(pdf_csi *csi, void *state, pdf_obj *resources, pdf_annot *annot)
 	fz_context *ctx = pr->ctx;
 	int flags;
 
-	if (pdf_is_hidden_ocg(pdf_dict_gets(annot->obj, "OC"), csi, pr, resources))
+	if (pdf_is_hidden_ocg(pdf_dict_get(annot->obj, PDF_NAME(OC)), csi, pr, resources))
 		return;
 
-	flags = pdf_to_int(pdf_dict_gets(annot->obj, "F"));
+	flags = pdf_to_int(pdf_dict_get(annot->obj, PDF_NAME(F)));
 	if (!strcmp(pr->event, "Print") && !(flags & (1 << 2))) /* Print */
 		return;
 	if (!strcmp(pr->event, "View") && (flags & (1 << 5))) /* NoView */
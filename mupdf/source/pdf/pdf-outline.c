@@ -27,35 +27,35 @@ pdf_load_outline_imp(pdf_document *doc, pdf_obj *dict)
 			*prev = node;
 			prev = &node->next;
 
-			obj = pdf_dict_gets(dict, "Title");
+			obj = pdf_dict_get(dict, PDF_NAME(Title));
 			if (obj)
 				node->title = pdf_to_utf8(doc, obj);
 
 			/* SumatraPDF: support expansion states */
-			node->is_open = pdf_to_int(pdf_dict_gets(dict, "Count")) >= 0;
+			node->is_open = pdf_to_int(pdf_dict_get(dict, PDF_NAME(Count))) >= 0;
 
 			/* SumatraPDF: tolerate invalid link destinations and actions */
 			fz_try(ctx)
 			{
 
-			if ((obj = pdf_dict_gets(dict, "Dest")) != NULL)
+			if ((obj = pdf_dict_get(dict, PDF_NAME(Dest))) != NULL)
 				node->dest = pdf_parse_link_dest(doc, FZ_LINK_GOTO, obj);
-			else if ((obj = pdf_dict_gets(dict, "A")) != NULL)
+			else if ((obj = pdf_dict_get(dict, PDF_NAME(A))) != NULL)
 				node->dest = pdf_parse_action(doc, obj);
 
 			}
 			fz_catch(ctx) { }
 
-			obj = pdf_dict_gets(dict, "First");
+			obj = pdf_dict_get(dict, PDF_NAME(First));
 			if (obj)
 				node->down = pdf_load_outline_imp(doc, obj);
 
-			dict = pdf_dict_gets(dict, "Next");
+			dict = pdf_dict_get(dict, PDF_NAME(Next));
 		}
 	}
 	fz_always(ctx)
 	{
-		for (dict = odict; dict && pdf_obj_marked(dict); dict = pdf_dict_gets(dict, "Next"))
+		for (dict = odict; dict && pdf_obj_marked(dict); dict = pdf_dict_get(dict, PDF_NAME(Next)))
 			pdf_unmark_obj(dict);
 	}
 	fz_catch(ctx)
@@ -72,9 +72,9 @@ pdf_load_outline(pdf_document *doc)
 {
 	pdf_obj *root, *obj, *first;
 
-	root = pdf_dict_gets(pdf_trailer(doc), "Root");
-	obj = pdf_dict_gets(root, "Outlines");
-	first = pdf_dict_gets(obj, "First");
+	root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	obj = pdf_dict_get(root, PDF_NAME(Outlines));
+	first = pdf_dict_get(obj, PDF_NAME(First));
 	if (first)
 		return pdf_load_outline_imp(doc, first);
 
@@ -11,6 +11,322 @@ pdf_count_pages(pdf_document *doc)
 	return doc->page_count;
 }
 
+/* SumatraPDF: page tree index */
+
+enum
+{
+	INHERIT_MEDIABOX, INHERIT_CROPBOX, INHERIT_ROTATE, INHERIT_RESOURCES, INHERIT_COUNT
+};
+
+static const char *inherit_keys[INHERIT_COUNT] = { "MediaBox", "CropBox", "Rotate", "Resources" };
+
+enum
+{
+	/* deeper page trees are most likely cyclic */
+	PAGE_TREE_MAX_DEPTH = 1024
+};
+
+typedef struct pdf_page_tree_item_s
+{
+	pdf_obj *page;
+	/* the values inherited from the page's ancestors (the page's own
+	   values are looked up directly, so that editing pages is safe) */
+	pdf_obj *inherited[INHERIT_COUNT];
+} pdf_page_tree_item;
+
+typedef struct pdf_page_tree_node_s
+{
+	pdf_obj *kids;
+	int i, len;
+	pdf_obj *inherited[INHERIT_COUNT];
+} pdf_page_tree_node;
+
+struct pdf_page_tree_s
+{
+	int len, cap;
+	pdf_page_tree_item *items;
+	/* maps object numbers to page numbers (open addressing, -1 for empty) */
+	int *buckets;
+	int mask;
+	/* the state of the tree walk (continued on demand) */
+	int depth, max_depth;
+	pdf_page_tree_node *stack;
+	int done;
+	/* bitmap of the object numbers of the catalog and of all /Pages nodes
+	   walked so far: modifying any of them invalidates the index, since both
+	   the page order and the inherited values might change */
+	unsigned char *nodes;
+	int nodes_len;
+	/* set by pdf_page_tree_altered, the index is dropped on next use */
+	int stale;
+};
+
+static pdf_obj *
+pdf_get_inherited(pdf_obj *node, int key)
+{
+	switch (key)
+	{
+	case INHERIT_MEDIABOX: return pdf_dict_get(node, PDF_NAME(MediaBox));
+	case INHERIT_CROPBOX: return pdf_dict_get(node, PDF_NAME(CropBox));
+	case INHERIT_ROTATE: return pdf_dict_get(node, PDF_NAME(Rotate));
+	default: return pdf_dict_get(node, PDF_NAME(Resources));
+	}
+}
+
+static unsigned int
+pdf_page_tree_hash(int num)
+{
+	return (unsigned int)num * 2654435761U;
+}
+
+static int
+pdf_page_tree_find(pdf_page_tree *tree, int num)
+{
+	unsigned int pos;
+	for (pos = pdf_page_tree_hash(num) & tree->mask; tree->buckets[pos] >= 0; pos = (pos + 1) & tree->mask)
+	{
+		if (pdf_to_num(tree->items[tree->buckets[pos]].page) == num)
+			return tree->buckets[pos];
+	}
+	return -1;
+}
+
+static void
+pdf_page_tree_insert(pdf_page_tree *tree, int num, int page_no)
+{
+	unsigned int pos;
+	for (pos = pdf_page_tree_hash(num) & tree->mask; tree->buckets[pos] >= 0; pos = (pos + 1) & tree->mask)
+	{
+		/* pages referenced more than once map to their first occurrence */
+		if (pdf_to_num(tree->items[tree->buckets[pos]].page) == num)
+			return;
+	}
+	tree->buckets[pos] = page_no;
+}
+
+static void
+pdf_page_tree_mark_node(pdf_page_tree *tree, pdf_obj *node)
+{
+	int num = pdf_to_num(node);
+	if (num > 0 && num < tree->nodes_len)
+		tree->nodes[num >> 3] |= 1 << (num & 7);
+}
+
+static void
+pdf_page_tree_push(pdf_document *doc, pdf_page_tree *tree, pdf_obj *node)
+{
+	pdf_page_tree_node *parent, *top;
+	int k;
+
+	if (tree->depth == PAGE_TREE_MAX_DEPTH)
+		fz_throw(doc->ctx, FZ_ERROR_GENERIC, "cycle in page tree");
+	if (tree->depth == tree->max_depth)
+	{
+		int new_max = tree->max_depth ? tree->max_depth * 2 : 16;
+		tree->stack = fz_resize_array(doc->ctx, tree->stack, new_max, sizeof(pdf_page_tree_node));
+		tree->max_depth = new_max;
+	}
+
+	pdf_page_tree_mark_node(tree, node);
+	parent = tree->depth > 0 ? &tree->stack[tree->depth - 1] : NULL;
+	top = &tree->stack[tree->depth++];
+	top->kids = pdf_keep_obj(pdf_dict_get(node, PDF_NAME(Kids)));
+	top->i = -1;
+	top->len = pdf_array_len(top->kids);
+	for (k = 0; k < INHERIT_COUNT; k++)
+	{
+		pdf_obj *val = pdf_get_inherited(node, k);
+		top->inherited[k] = pdf_keep_obj(val || !parent ? val : parent->inherited[k]);
+	}
+}
+
+static void
+pdf_page_tree_pop(pdf_page_tree *tree)
+{
+	pdf_page_tree_node *top = &tree->stack[--tree->depth];
+	int k;
+
+	pdf_drop_obj(top->kids);
+	for (k = 0; k < INHERIT_COUNT; k++)
+		pdf_drop_obj(top->inherited[k]);
+}
+
+static pdf_page_tree *
+pdf_new_page_tree(pdf_document *doc)
+{
+	fz_context *ctx = doc->ctx;
+	pdf_page_tree *tree = fz_malloc_struct(ctx, pdf_page_tree);
+	int size = 16;
+
+	fz_try(ctx)
+	{
+		tree->cap = fz_maxi(pdf_count_pages(doc), 0);
+		while (size < tree->cap * 2)
+			size *= 2;
+		tree->items = fz_malloc_array(ctx, tree->cap, sizeof(pdf_page_tree_item));
+		tree->buckets = fz_malloc_array(ctx, size, sizeof(int));
+		memset(tree->buckets, -1, size * sizeof(int));
+		tree->mask = size - 1;
+		tree->nodes_len = pdf_xref_len(doc);
+		tree->nodes = fz_calloc(ctx, (tree->nodes_len + 7) >> 3, 1);
+		pdf_page_tree_mark_node(tree, pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)));
+		pdf_page_tree_push(doc, tree, pdf_dict_getp(pdf_trailer(doc), "Root/Pages"));
+	}
+	fz_catch(ctx)
+	{
+		fz_free(ctx, tree->nodes);
+		fz_free(ctx, tree->buckets);
+		fz_free(ctx, tree->items);
+		fz_free(ctx, tree);
+		fz_rethrow(ctx);
+	}
+
+	return tree;
+}
+
+/* walks the page tree until either needle pages or the page with object number stop_num have been indexed */
+static void
+pdf_page_tree_advance(pdf_document *doc, pdf_page_tree *tree, int needle, int stop_num)
+{
+	fz_context *ctx = doc->ctx;
+
+	fz_try(ctx)
+	{
+		while (!tree->done && tree->len < needle)
+		{
+			pdf_page_tree_node *top = &tree->stack[tree->depth - 1];
+			pdf_obj *kid, *type;
+
+			if (++top->i >= top->len)
+			{
+				pdf_page_tree_pop(tree);
+				tree->done = tree->depth == 0;
+				continue;
+			}
+
+			kid = pdf_array_get(top->kids, top->i);
+			type = pdf_dict_get(kid, PDF_NAME(Type));
+			if (pdf_name_eq(type, PDF_NAME(Page)) || (!type && pdf_dict_get(kid, PDF_NAME(MediaBox))))
+			{
+				pdf_page_tree_item *item;
+				int k, num = pdf_to_num(kid);
+
+				if (tree->len == tree->cap)
+					fz_throw(ctx, FZ_ERROR_GENERIC, "found more /Page objects than anticipated");
+
+				item = &tree->items[tree->len];
+				item->page = pdf_keep_obj(kid);
+				for (k = 0; k < INHERIT_COUNT; k++)
+					item->inherited[k] = pdf_keep_obj(top->inherited[k]);
+				if (num > 0)
+					pdf_page_tree_insert(tree, num, tree->len);
+				tree->len++;
+
+				if (num > 0 && num == stop_num)
+					break;
+			}
+			else if (pdf_name_eq(type, PDF_NAME(Pages)) || (!type && pdf_dict_get(kid, PDF_NAME(Kids))))
+			{
+				if (pdf_to_int(pdf_dict_get(kid, PDF_NAME(Count))) > 0)
+					pdf_page_tree_push(doc, tree, kid);
+			}
+			else
+			{
+				fz_throw(ctx, FZ_ERROR_GENERIC, "non-page object in page tree (%s)", pdf_to_name(type));
+			}
+		}
+	}
+	fz_catch(ctx)
+	{
+		/* keep what has been indexed so far and don't try again */
+		while (tree->depth > 0)
+			pdf_page_tree_pop(tree);
+		tree->done = 1;
+		fz_rethrow(ctx);
+	}
+}
+
+static pdf_page_tree *
+pdf_get_page_tree(pdf_document *doc)
+{
+	if (doc->page_tree && doc->page_tree->stale)
+		pdf_drop_page_tree(doc);
+	if (!doc->page_tree && !doc->file_reading_linearly)
+		doc->page_tree = pdf_new_page_tree(doc);
+	return doc->page_tree;
+}
+
+int
+pdf_load_page_tree(pdf_document *doc, int count)
+{
+	pdf_page_tree *tree = pdf_get_page_tree(doc);
+	if (!tree)
+		return 0;
+	pdf_page_tree_advance(doc, tree, count < 0 ? INT_MAX : count, 0);
+	return tree->len;
+}
+
+void
+pdf_drop_page_tree(pdf_document *doc)
+{
+	pdf_page_tree *tree = doc->page_tree;
+	int i, k;
+
+	if (!tree)
+		return;
+	while (tree->depth > 0)
+		pdf_page_tree_pop(tree);
+	for (i = 0; i < tree->len; i++)
+	{
+		pdf_drop_obj(tree->items[i].page);
+		for (k = 0; k < INHERIT_COUNT; k++)
+			pdf_drop_obj(tree->items[i].inherited[k]);
+	}
+	fz_free(doc->ctx, tree->nodes);
+	fz_free(doc->ctx, tree->stack);
+	fz_free(doc->ctx, tree->buckets);
+	fz_free(doc->ctx, tree->items);
+	fz_free(doc->ctx, tree);
+	doc->page_tree = NULL;
+}
+
+void
+pdf_page_tree_altered(pdf_document *doc, int num)
+{
+	pdf_page_tree *tree = doc->page_tree;
+
+	/* objects can be modified while the tree is being walked (e.g.
+	   during repair), so the index isn't dropped right away */
+	if (tree && num > 0 && num < tree->nodes_len && (tree->nodes[num >> 3] & (1 << (num & 7))))
+		tree->stale = 1;
+}
+
+/* returns the indexed page object for needle or NULL (in which case the page tree has to be walked) */
+static pdf_obj *
+pdf_lookup_indexed_page(pdf_document *doc, int needle)
+{
+	fz_context *ctx = doc->ctx;
+	pdf_page_tree *tree = NULL;
+
+	fz_var(tree);
+
+	if (needle < 0)
+		return NULL;
+	fz_try(ctx)
+	{
+		tree = pdf_get_page_tree(doc);
+		if (tree)
+			pdf_page_tree_advance(doc, tree, needle + 1, 0);
+	}
+	fz_catch(ctx)
+	{
+		fz_warn(ctx, "cannot index page tree: %s", fz_caught_message(ctx));
+	}
+	if (!tree || needle >= tree->len)
+		return NULL;
+	return tree->items[needle].page;
+}
+
 enum
 {
 	LOCAL_STACK_SIZE = 16
@@ -37,7 +353,7 @@ pdf_lookup_page_loc_imp(pdf_document *doc, pdf_obj *node, int *skip, pdf_obj **p
 	{
 		do
 		{
-			kids = pdf_dict_gets(node, "Kids");
+			kids = pdf_dict_get(node, PDF_NAME(Kids));
 			len = pdf_array_len(kids);
 
 			if (len == 0)
@@ -63,8 +379,8 @@ pdf_lookup_page_loc_imp(pdf_document *doc, pdf_obj *node, int *skip, pdf_obj **p
 			for (i = 0; i < len; i++)
 			{
 				pdf_obj *kid = pdf_array_get(kids, i);
-				char *type = pdf_to_name(pdf_dict_gets(kid, "Type"));
-				if (!strcmp(type, "Page") || (!*type && pdf_dict_gets(kid, "MediaBox")))
+				char *type = pdf_to_name(pdf_dict_get(kid, PDF_NAME(Type)));
+				if (!strcmp(type, "Page") || (!*type && pdf_dict_get(kid, PDF_NAME(MediaBox))))
 				{
 					if (*skip == 0)
 					{
@@ -78,9 +394,9 @@ pdf_lookup_page_loc_imp(pdf_document *doc, pdf_obj *node, int *skip, pdf_obj **p
 						(*skip)--;
 					}
 				}
-				else if (!strcmp(type, "Pages") || (!*type && pdf_dict_gets(kid, "Kids")))
+				else if (!strcmp(type, "Pages") || (!*type && pdf_dict_get(kid, PDF_NAME(Kids))))
 				{
-					int count = pdf_to_int(pdf_dict_gets(kid, "Count"));
+					int count = pdf_to_int(pdf_dict_get(kid, PDF_NAME(Count)));
 					if (*skip < count)
 					{
 						node = kid;
@@ -117,8 +433,8 @@ pdf_lookup_page_loc_imp(pdf_document *doc, pdf_obj *node, int *skip, pdf_obj **p
 pdf_obj *
 pdf_lookup_page_loc(pdf_document *doc, int needle, pdf_obj **parentp, int *indexp)
 {
-	pdf_obj *root = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pdf_obj *node = pdf_dict_gets(root, "Pages");
+	pdf_obj *root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pdf_obj *node = pdf_dict_get(root, PDF_NAME(Pages));
 	int skip = needle;
 	pdf_obj *hit;
 
@@ -134,22 +450,26 @@ pdf_lookup_page_loc(pdf_document *doc, int needle, pdf_obj **parentp, int *index
 pdf_obj *
 pdf_lookup_page_obj(pdf_document *doc, int needle)
 {
+	/* SumatraPDF: use the page tree index where possible */
+	pdf_obj *hit = pdf_lookup_indexed_page(doc, needle);
+	if (hit)
+		return hit;
 	return pdf_lookup_page_loc(doc, needle, NULL, NULL);
 }
 
 static int
 pdf_count_pages_before_kid(pdf_document *doc, pdf_obj *parent, int kid_num)
 {
-	pdf_obj *kids = pdf_dict_gets(parent, "Kids");
+	pdf_obj *kids = pdf_dict_get(parent, PDF_NAME(Kids));
 	int i, total = 0, len = pdf_array_len(kids);
 	for (i = 0; i < len; i++)
 	{
 		pdf_obj *kid = pdf_array_get(kids, i);
 		if (pdf_to_num(kid) == kid_num)
 			return total;
-		if (!strcmp(pdf_to_name(pdf_dict_gets(kid, "Type")), "Pages"))
+		if (pdf_name_eq(pdf_dict_get(kid, PDF_NAME(Type)), PDF_NAME(Pages)))
 		{
-			pdf_obj *count = pdf_dict_gets(kid, "Count");
+			pdf_obj *count = pdf_dict_get(kid, PDF_NAME(Count));
 			int n = pdf_to_int(count);
 			if (count == NULL || n <= 0)
 				fz_throw(doc->ctx, FZ_ERROR_GENERIC, "illegal or missing count in pages tree");
@@ -169,10 +489,35 @@ pdf_lookup_page_number(pdf_document *doc, pdf_obj *node)
 	int total = 0;
 	pdf_obj *parent, *parent2;
 
-	if (strcmp(pdf_to_name(pdf_dict_gets(node, "Type")), "Page") != 0)
+	if (strcmp(pdf_to_name(pdf_dict_get(node, PDF_NAME(Type))), "Page") != 0)
 		fz_throw(ctx, FZ_ERROR_GENERIC, "invalid page object");
 
-	parent2 = parent = pdf_dict_gets(node, "Parent");
+	/* SumatraPDF: use the page tree index where possible */
+	if (needle > 0)
+	{
+		pdf_page_tree *tree = NULL;
+		int page_no = -1;
+		fz_var(tree);
+		fz_var(page_no);
+		fz_try(ctx)
+		{
+			tree = pdf_get_page_tree(doc);
+			if (tree && (page_no = pdf_page_tree_find(tree, needle)) < 0 && !tree->done)
+			{
+				pdf_page_tree_advance(doc, tree, INT_MAX, needle);
+				page_no = pdf_page_tree_find(tree, needle);
+			}
+		}
+		fz_catch(ctx)
+		{
+			fz_warn(ctx, "cannot index page tree: %s", fz_caught_message(ctx));
+			page_no = tree ? pdf_page_tree_find(tree, needle) : -1;
+		}
+		if (page_no >= 0)
+			return page_no;
+	}
+
+	parent2 = parent = pdf_dict_get(node, PDF_NAME(Parent));
 	fz_var(parent);
 	fz_try(ctx)
 	{
@@ -182,7 +527,7 @@ pdf_lookup_page_number(pdf_document *doc, pdf_obj *node)
 				fz_throw(ctx, FZ_ERROR_GENERIC, "cycle in page tree (parents)");
 			total += pdf_count_pages_before_kid(doc, parent, needle);
 			needle = pdf_to_num(parent);
-			parent = pdf_dict_gets(parent, "Parent");
+			parent = pdf_dict_get(parent, PDF_NAME(Parent));
 		}
 	}
 	fz_always(ctx)
@@ -193,7 +538,7 @@ pdf_lookup_page_number(pdf_document *doc, pdf_obj *node)
 			pdf_unmark_obj(parent2);
 			if (parent2 == parent)
 				break;
-			parent2 = pdf_dict_gets(parent2, "Parent");
+			parent2 = pdf_dict_get(parent2, PDF_NAME(Parent));
 		}
 	}
 	fz_catch(ctx)
@@ -223,7 +568,7 @@ pdf_lookup_inherited_page_item(pdf_document *doc, pdf_obj *node, const char *key
 				break;
 			if (pdf_mark_obj(node))
 				fz_throw(ctx, FZ_ERROR_GENERIC, "cycle in page tree (parents)");
-			node = pdf_dict_gets(node, "Parent");
+			node = pdf_dict_get(node, PDF_NAME(Parent));
 		}
 		while (node);
 	}
@@ -234,7 +579,7 @@ pdf_lookup_inherited_page_item(pdf_document *doc, pdf_obj *node, const char *key
 			pdf_unmark_obj(node2);
 			if (node2 == node)
 				break;
-			node2 = pdf_dict_gets(node2, "Parent");
+			node2 = pdf_dict_get(node2, PDF_NAME(Parent));
 		}
 		while (node2);
 	}
@@ -246,6 +591,27 @@ pdf_lookup_inherited_page_item(pdf_document *doc, pdf_obj *node, const char *key
 	return val;
 }
 
+pdf_obj *
+pdf_lookup_page_item(pdf_document *doc, int number, pdf_obj *pageobj, const char *key)
+{
+	pdf_page_tree *tree = doc->page_tree;
+	pdf_obj *val;
+	int k;
+
+	if (tree && !tree->stale && number >= 0 && number < tree->len &&
+		pdf_resolve_indirect(tree->items[number].page) == pdf_resolve_indirect(pageobj))
+	{
+		for (k = 0; k < INHERIT_COUNT; k++)
+		{
+			if (strcmp(key, inherit_keys[k]))
+				continue;
+			val = pdf_get_inherited(pageobj, k);
+			return val ? val : tree->items[number].inherited[k];
+		}
+	}
+	return pdf_lookup_inherited_page_item(doc, pageobj, key);
+}
+
 /* We need to know whether to install a page-level transparency group */
 
 static int pdf_resources_use_blending(pdf_document *doc, pdf_obj *rdb);
@@ -253,7 +619,7 @@ static int pdf_resources_use_blending(pdf_document *doc, pdf_obj *rdb);
 static int
 pdf_extgstate_uses_blending(pdf_document *doc, pdf_obj *dict)
 {
-	pdf_obj *obj = pdf_dict_gets(dict, "BM");
+	pdf_obj *obj = pdf_dict_get(dict, PDF_NAME(BM));
 	/* SumatraPDF: properly support /BM arrays */
 	if (pdf_is_array(obj))
 	{
@@ -269,7 +635,7 @@ pdf_extgstate_uses_blending(pdf_document *doc, pdf_obj *dict)
 	if (pdf_is_name(obj) && strcmp(pdf_to_name(obj), "Normal"))
 		return 1;
 	/* SumatraPDF: support transfer functions */
-	obj = pdf_dict_getsa(dict, "TR", "TR2");
+	obj = pdf_dict_geta(dict, PDF_NAME(TR), PDF_NAME(TR2));
 	if (obj && !pdf_is_name(obj))
 		return 1;
 	return 0;
@@ -279,19 +645,19 @@ static int
 pdf_pattern_uses_blending(pdf_document *doc, pdf_obj *dict)
 {
 	pdf_obj *obj;
-	obj = pdf_dict_gets(dict, "Resources");
+	obj = pdf_dict_get(dict, PDF_NAME(Resources));
 	if (pdf_resources_use_blending(doc, obj))
 		return 1;
-	obj = pdf_dict_gets(dict, "ExtGState");
+	obj = pdf_dict_get(dict, PDF_NAME(ExtGState));
 	return pdf_extgstate_uses_blending(doc, obj);
 }
 
 static int
 pdf_xobject_uses_blending(pdf_document *doc, pdf_obj *dict)
 {
-	pdf_obj *obj = pdf_dict_gets(dict, "Resources");
+	pdf_obj *obj = pdf_dict_get(dict, PDF_NAME(Resources));
 	/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=2540 */
-	if (!strcmp(pdf_to_name(pdf_dict_getp(dict, "Group/S")), "Transparency"))
+	if (pdf_name_eq(pdf_dict_getp(dict, "Group/S"), PDF_NAME(Transparency)))
 		return 1;
 	return pdf_resources_use_blending(doc, obj);
 }
@@ -316,19 +682,19 @@ pdf_resources_use_blending(pdf_document *doc, pdf_obj *rdb)
 
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(rdb, "ExtGState");
+		obj = pdf_dict_get(rdb, PDF_NAME(ExtGState));
 		n = pdf_dict_len(obj);
 		for (i = 0; i < n; i++)
 			if (pdf_extgstate_uses_blending(doc, pdf_dict_get_val(obj, i)))
 				goto found;
 
-		obj = pdf_dict_gets(rdb, "Pattern");
+		obj = pdf_dict_get(rdb, PDF_NAME(Pattern));
 		n = pdf_dict_len(obj);
 		for (i = 0; i < n; i++)
 			if (pdf_pattern_uses_blending(doc, pdf_dict_get_val(obj, i)))
 				goto found;
 
-		obj = pdf_dict_gets(rdb, "XObject");
+		obj = pdf_dict_get(rdb, PDF_NAME(XObject));
 		n = pdf_dict_len(obj);
 		for (i = 0; i < n; i++)
 			if (pdf_xobject_uses_blending(doc, pdf_dict_get_val(obj, i)))
@@ -359,18 +725,18 @@ pdf_load_transition(pdf_document *doc, pdf_page *page, pdf_obj *transdict)
 	pdf_obj *obj;
 	int type;
 
-	obj = pdf_dict_gets(transdict, "D");
+	obj = pdf_dict_get(transdict, PDF_NAME(D));
 	page->transition.duration = (obj ? pdf_to_real(obj) : 1);
 
-	page->transition.vertical = (pdf_to_name(pdf_dict_gets(transdict, "Dm"))[0] != 'H');
-	page->transition.outwards = (pdf_to_name(pdf_dict_gets(transdict, "M"))[0] != 'I');
+	page->transition.vertical = (pdf_to_name(pdf_dict_get(transdict, PDF_NAME(Dm)))[0] != 'H');
+	page->transition.outwards = (pdf_to_name(pdf_dict_get(transdict, PDF_NAME(M)))[0] != 'I');
 	/* FIXME: If 'Di' is None, it should be handled differently, but
 	 * this only affects Fly, and we don't implement that currently. */
-	page->transition.direction = (pdf_to_int(pdf_dict_gets(transdict, "Di")));
+	page->transition.direction = (pdf_to_int(pdf_dict_get(transdict, PDF_NAME(Di))));
 	/* FIXME: Read SS for Fly when we implement it */
 	/* FIXME: Read B for Fly when we implement it */
 
-	name = pdf_to_name(pdf_dict_gets(transdict, "S"));
+	name = pdf_to_name(pdf_dict_get(transdict, PDF_NAME(S)));
 	if (!strcmp(name, "Split"))
 		type = FZ_TRANSITION_SPLIT;
 	else if (!strcmp(name, "Blinds"))
@@ -442,14 +808,15 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 	page->tmp_annots = NULL;
 	page->me = pdf_keep_obj(pageobj);
 	page->incomplete = 0;
+	page->number = number;
 
-	obj = pdf_dict_gets(pageobj, "UserUnit");
+	obj = pdf_dict_get(pageobj, PDF_NAME(UserUnit));
 	if (pdf_is_real(obj))
 		userunit = pdf_to_real(obj);
 	else
 		userunit = 1;
 
-	pdf_to_rect(ctx, pdf_lookup_inherited_page_item(doc, pageobj, "MediaBox"), &mediabox);
+	pdf_to_rect(ctx, pdf_lookup_page_item(doc, number, pageobj, "MediaBox"), &mediabox);
 	if (fz_is_empty_rect(&mediabox))
 	{
 		fz_warn(ctx, "cannot find page size for page %d", number + 1);
@@ -459,7 +826,7 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 		mediabox.y1 = 792;
 	}
 
-	pdf_to_rect(ctx, pdf_lookup_inherited_page_item(doc, pageobj, "CropBox"), &cropbox);
+	pdf_to_rect(ctx, pdf_lookup_page_item(doc, number, pageobj, "CropBox"), &cropbox);
 	if (!fz_is_empty_rect(&cropbox))
 		fz_intersect_rect(&mediabox, &cropbox);
 
@@ -474,7 +841,7 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 		page->mediabox = fz_unit_rect;
 	}
 
-	page->rotate = pdf_to_int(pdf_lookup_inherited_page_item(doc, pageobj, "Rotate"));
+	page->rotate = pdf_to_int(pdf_lookup_page_item(doc, number, pageobj, "Rotate"));
 	/* Snap page->rotate to 0, 90, 180 or 270 */
 	if (page->rotate < 0)
 		page->rotate = 360 - ((-page->rotate) % 360);
@@ -492,7 +859,7 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(pageobj, "Annots");
+		obj = pdf_dict_get(pageobj, PDF_NAME(Annots));
 		if (obj)
 		{
 			page->links = pdf_load_link_annots(doc, obj, &page->ctm);
@@ -507,9 +874,9 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 		page->incomplete |= PDF_PAGE_INCOMPLETE_ANNOTS;
 	}
 
-	page->duration = pdf_to_real(pdf_dict_gets(pageobj, "Dur"));
+	page->duration = pdf_to_real(pdf_dict_get(pageobj, PDF_NAME(Dur)));
 
-	obj = pdf_dict_gets(pageobj, "Trans");
+	obj = pdf_dict_get(pageobj, PDF_NAME(Trans));
 	page->transition_present = (obj != NULL);
 	if (obj)
 	{
@@ -517,11 +884,11 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 	}
 
 	// TODO: inherit
-	page->resources = pdf_lookup_inherited_page_item(doc, pageobj, "Resources");
+	page->resources = pdf_lookup_page_item(doc, number, pageobj, "Resources");
 	if (page->resources)
 		pdf_keep_obj(page->resources);
 
-	obj = pdf_dict_gets(pageobj, "Contents");
+	obj = pdf_dict_get(pageobj, PDF_NAME(Contents));
 	fz_try(ctx)
 	{
 		page->contents = pdf_keep_obj(obj);
@@ -529,7 +896,7 @@ pdf_load_page_by_obj(pdf_document *doc, int number, pdf_obj *pageref)
 		if (pdf_resources_use_blending(doc, page->resources))
 			page->transparency = 1;
 		/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=2107 */
-		else if (!strcmp(pdf_to_name(pdf_dict_getp(pageobj, "Group/S")), "Transparency"))
+		else if (pdf_name_eq(pdf_dict_getp(pageobj, "Group/S"), PDF_NAME(Transparency)))
 			page->transparency = 1;
 
 		for (annot = page->annots; annot && !page->transparency; annot = annot->next)
@@ -598,14 +965,16 @@ pdf_delete_page(pdf_document *doc, int at)
 	int i;
 
 	pdf_lookup_page_loc(doc, at, &parent, &i);
-	kids = pdf_dict_gets(parent, "Kids");
+	kids = pdf_dict_get(parent, PDF_NAME(Kids));
 	pdf_array_delete(kids, i);
+	/* SumatraPDF: page tree index */
+	pdf_drop_page_tree(doc);
 
 	while (parent)
 	{
-		int count = pdf_to_int(pdf_dict_gets(parent, "Count"));
-		pdf_dict_puts_drop(parent, "Count", pdf_new_int(doc, count - 1));
-		parent = pdf_dict_gets(parent, "Parent");
+		int count = pdf_to_int(pdf_dict_get(parent, PDF_NAME(Count)));
+		pdf_dict_put_drop(parent, PDF_NAME(Count), pdf_new_int(doc, count - 1));
+		parent = pdf_dict_get(parent, PDF_NAME(Parent));
 	}
 }
 
@@ -619,17 +988,19 @@ pdf_insert_page(pdf_document *doc, pdf_page *page, int at)
 	int i;
 
 	page_ref = pdf_new_ref(doc, page->me);
+	/* SumatraPDF: page tree index */
+	pdf_drop_page_tree(doc);
 
 	fz_try(ctx)
 	{
 		if (count == 0)
 		{
-			pdf_obj *root = pdf_dict_gets(pdf_trailer(doc), "Root");
-			parent = pdf_dict_gets(root, "Pages");
+			pdf_obj *root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+			parent = pdf_dict_get(root, PDF_NAME(Pages));
 			if (!parent)
 				fz_throw(doc->ctx, FZ_ERROR_GENERIC, "cannot find page tree");
 
-			kids = pdf_dict_gets(parent, "Kids");
+			kids = pdf_dict_get(parent, PDF_NAME(Kids));
 			if (!kids)
 				fz_throw(doc->ctx, FZ_ERROR_GENERIC, "malformed page tree");
 
@@ -645,25 +1016,25 @@ pdf_insert_page(pdf_document *doc, pdf_page *page, int at)
 
 			/* append after last page */
 			pdf_lookup_page_loc(doc, count - 1, &parent, &i);
-			kids = pdf_dict_gets(parent, "Kids");
+			kids = pdf_dict_get(parent, PDF_NAME(Kids));
 			pdf_array_insert(kids, page_ref, i + 1);
 		}
 		else
 		{
 			/* insert before found page */
 			pdf_lookup_page_loc(doc, at, &parent, &i);
-			kids = pdf_dict_gets(parent, "Kids");
+			kids = pdf_dict_get(parent, PDF_NAME(Kids));
 			pdf_array_insert(kids, page_ref, i);
 		}
 
-		pdf_dict_puts(page->me, "Parent", parent);
+		pdf_dict_put(page->me, PDF_NAME(Parent), parent);
 
 		/* Adjust page counts */
 		while (parent)
 		{
-			int count = pdf_to_int(pdf_dict_gets(parent, "Count"));
-			pdf_dict_puts_drop(parent, "Count", pdf_new_int(doc, count + 1));
-			parent = pdf_dict_gets(parent, "Parent");
+			int count = pdf_to_int(pdf_dict_get(parent, PDF_NAME(Count)));
+			pdf_dict_put_drop(parent, PDF_NAME(Count), pdf_new_int(doc, count + 1));
+			parent = pdf_dict_get(parent, PDF_NAME(Parent));
 		}
 
 	}
@@ -705,13 +1076,13 @@ pdf_create_page(pdf_document *doc, fz_rect mediabox, int res, int rotate)
 		page->annots = NULL;
 		page->me = pageobj = pdf_new_dict(doc, 4);
 
-		pdf_dict_puts_drop(pageobj, "Type", pdf_new_name(doc, "Page"));
+		pdf_dict_put_drop(pageobj, PDF_NAME(Type), pdf_new_name(doc, "Page"));
 
 		page->mediabox.x0 = fz_min(mediabox.x0, mediabox.x1) * userunit;
 		page->mediabox.y0 = fz_min(mediabox.y0, mediabox.y1) * userunit;
 		page->mediabox.x1 = fz_max(mediabox.x0, mediabox.x1) * userunit;
 		page->mediabox.y1 = fz_max(mediabox.y0, mediabox.y1) * userunit;
-		pdf_dict_puts_drop(pageobj, "MediaBox", pdf_new_rect(doc, &page->mediabox));
+		pdf_dict_put_drop(pageobj, PDF_NAME(MediaBox), pdf_new_rect(doc, &page->mediabox));
 
 		/* Snap page->rotate to 0, 90, 180 or 270 */
 		if (page->rotate < 0)
@@ -721,7 +1092,7 @@ pdf_create_page(pdf_document *doc, fz_rect mediabox, int res, int rotate)
 		page->rotate = 90*((page->rotate + 45)/90);
 		if (page->rotate > 360)
 			page->rotate = 0;
-		pdf_dict_puts_drop(pageobj, "Rotate", pdf_new_int(doc, page->rotate));
+		pdf_dict_put_drop(pageobj, PDF_NAME(Rotate), pdf_new_int(doc, page->rotate));
 
 		fz_pre_rotate(fz_scale(&ctm, 1, -1), -page->rotate);
 		realbox = page->mediabox;
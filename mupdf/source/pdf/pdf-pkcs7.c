@@ -746,7 +746,7 @@ void pdf_sign_signature(pdf_document *doc, pdf_widget *widget, const char *sigfi
 
 		pdf_signature_set_value(doc, wobj, signer);
 
-		pdf_to_rect(ctx, pdf_dict_gets(wobj, "Rect"), &rect);
+		pdf_to_rect(ctx, pdf_dict_get(wobj, PDF_NAME(Rect)), &rect);
 		/* Create an appearance stream only if the signature is intended to be visible */
 		if (!fz_is_empty_rect(&rect))
 		{
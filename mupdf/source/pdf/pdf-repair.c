@@ -55,17 +55,17 @@ pdf_repair_obj(pdf_document *doc, pdf_lexbuf *buf, int *stmofsp, int *stmlenp, p
 
 		if (encrypt && id)
 		{
-			obj = pdf_dict_gets(dict, "Type");
-			if (pdf_is_name(obj) && !strcmp(pdf_to_name(obj), "XRef"))
+			obj = pdf_dict_get(dict, PDF_NAME(Type));
+			if (pdf_is_name(obj) && pdf_name_eq(obj, PDF_NAME(XRef)))
 			{
-				obj = pdf_dict_gets(dict, "Encrypt");
+				obj = pdf_dict_get(dict, PDF_NAME(Encrypt));
 				if (obj)
 				{
 					pdf_drop_obj(*encrypt);
 					*encrypt = pdf_keep_obj(obj);
 				}
 
-				obj = pdf_dict_gets(dict, "ID");
+				obj = pdf_dict_get(dict, PDF_NAME(ID));
 				if (obj)
 				{
 					pdf_drop_obj(*id);
@@ -74,14 +74,14 @@ pdf_repair_obj(pdf_document *doc, pdf_lexbuf *buf, int *stmofsp, int *stmlenp, p
 			}
 		}
 
-		obj = pdf_dict_gets(dict, "Length");
+		obj = pdf_dict_get(dict, PDF_NAME(Length));
 		if (!pdf_is_indirect(obj) && pdf_is_int(obj))
 			stm_len = pdf_to_int(obj);
 
 		if (doc->file_reading_linearly && page)
 		{
-			obj = pdf_dict_gets(dict, "Type");
-			if (!strcmp(pdf_to_name(obj), "Page"))
+			obj = pdf_dict_get(dict, PDF_NAME(Type));
+			if (pdf_name_eq(obj, PDF_NAME(Page)))
 			{
 				pdf_drop_obj(*page);
 				*page = pdf_keep_obj(dict);
@@ -184,7 +184,7 @@ pdf_repair_obj_stm(pdf_document *doc, int num, int gen)
 	{
 		obj = pdf_load_object(doc, num, gen);
 
-		count = pdf_to_int(pdf_dict_gets(obj, "N"));
+		count = pdf_to_int(pdf_dict_get(obj, PDF_NAME(N)));
 
 		pdf_drop_obj(obj);
 
@@ -405,28 +405,28 @@ pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf)
 					continue;
 				}
 
-				obj = pdf_dict_gets(dict, "Encrypt");
+				obj = pdf_dict_get(dict, PDF_NAME(Encrypt));
 				if (obj)
 				{
 					pdf_drop_obj(encrypt);
 					encrypt = pdf_keep_obj(obj);
 				}
 
-				obj = pdf_dict_gets(dict, "ID");
+				obj = pdf_dict_get(dict, PDF_NAME(ID));
 				if (obj)
 				{
 					pdf_drop_obj(id);
 					id = pdf_keep_obj(obj);
 				}
 
-				obj = pdf_dict_gets(dict, "Root");
+				obj = pdf_dict_get(dict, PDF_NAME(Root));
 				if (obj)
 				{
 					pdf_drop_obj(root);
 					root = pdf_keep_obj(obj);
 				}
 
-				obj = pdf_dict_gets(dict, "Info");
+				obj = pdf_dict_get(dict, PDF_NAME(Info));
 				if (obj)
 				{
 					pdf_drop_obj(info);
@@ -489,7 +489,7 @@ pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf)
 				dict = pdf_load_object(doc, list[i].num, list[i].gen);
 
 				length = pdf_new_int(doc, list[i].stm_len);
-				pdf_dict_puts(dict, "Length", length);
+				pdf_dict_put(dict, PDF_NAME(Length), length);
 				pdf_drop_obj(length);
 
 				pdf_drop_obj(dict);
@@ -524,19 +524,19 @@ pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf)
 		obj = NULL;
 
 		obj = pdf_new_int(doc, maxnum + 1);
-		pdf_dict_puts(pdf_trailer(doc), "Size", obj);
+		pdf_dict_put(pdf_trailer(doc), PDF_NAME(Size), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
 		if (root)
 		{
-			pdf_dict_puts(pdf_trailer(doc), "Root", root);
+			pdf_dict_put(pdf_trailer(doc), PDF_NAME(Root), root);
 			pdf_drop_obj(root);
 			root = NULL;
 		}
 		if (info)
 		{
-			pdf_dict_puts(pdf_trailer(doc), "Info", info);
+			pdf_dict_put(pdf_trailer(doc), PDF_NAME(Info), info);
 			pdf_drop_obj(info);
 			info = NULL;
 		}
@@ -551,7 +551,7 @@ pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf)
 				encrypt = obj;
 				obj = NULL;
 			}
-			pdf_dict_puts(pdf_trailer(doc), "Encrypt", encrypt);
+			pdf_dict_put(pdf_trailer(doc), PDF_NAME(Encrypt), encrypt);
 			pdf_drop_obj(encrypt);
 			encrypt = NULL;
 		}
@@ -566,7 +566,7 @@ pdf_repair_xref(pdf_document *doc, pdf_lexbuf *buf)
 				id = obj;
 				obj = NULL;
 			}
-			pdf_dict_puts(pdf_trailer(doc), "ID", id);
+			pdf_dict_put(pdf_trailer(doc), PDF_NAME(ID), id);
 			pdf_drop_obj(id);
 			id = NULL;
 		}
@@ -602,7 +602,7 @@ pdf_repair_obj_stms(pdf_document *doc)
 			dict = pdf_load_object(doc, i, 0);
 			fz_try(ctx)
 			{
-				if (!strcmp(pdf_to_name(pdf_dict_gets(dict, "Type")), "ObjStm"))
+				if (pdf_name_eq(pdf_dict_get(dict, PDF_NAME(Type)), PDF_NAME(ObjStm)))
 					pdf_repair_obj_stm(doc, i, 0);
 			}
 			fz_catch(ctx)
@@ -59,7 +59,7 @@ pdf_load_function_based_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dic
 
 	x0 = y0 = 0;
 	x1 = y1 = 1;
-	obj = pdf_dict_gets(dict, "Domain");
+	obj = pdf_dict_get(dict, PDF_NAME(Domain));
 	if (obj)
 	{
 		x0 = pdf_to_real(pdf_array_get(obj, 0));
@@ -68,7 +68,7 @@ pdf_load_function_based_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dic
 		y1 = pdf_to_real(pdf_array_get(obj, 3));
 	}
 
-	obj = pdf_dict_gets(dict, "Matrix");
+	obj = pdf_dict_get(dict, PDF_NAME(Matrix));
 	if (obj)
 		pdf_to_matrix(ctx, obj, &matrix);
 	else
@@ -105,7 +105,7 @@ pdf_load_linear_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 	int e0, e1;
 	fz_context *ctx = doc->ctx;
 
-	obj = pdf_dict_gets(dict, "Coords");
+	obj = pdf_dict_get(dict, PDF_NAME(Coords));
 	shade->u.l_or_r.coords[0][0] = pdf_to_real(pdf_array_get(obj, 0));
 	shade->u.l_or_r.coords[0][1] = pdf_to_real(pdf_array_get(obj, 1));
 	shade->u.l_or_r.coords[1][0] = pdf_to_real(pdf_array_get(obj, 2));
@@ -113,7 +113,7 @@ pdf_load_linear_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 
 	d0 = 0;
 	d1 = 1;
-	obj = pdf_dict_gets(dict, "Domain");
+	obj = pdf_dict_get(dict, PDF_NAME(Domain));
 	if (obj)
 	{
 		d0 = pdf_to_real(pdf_array_get(obj, 0));
@@ -121,7 +121,7 @@ pdf_load_linear_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 	}
 
 	e0 = e1 = 0;
-	obj = pdf_dict_gets(dict, "Extend");
+	obj = pdf_dict_get(dict, PDF_NAME(Extend));
 	if (obj)
 	{
 		e0 = pdf_to_bool(pdf_array_get(obj, 0));
@@ -142,7 +142,7 @@ pdf_load_radial_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 	int e0, e1;
 	fz_context *ctx = doc->ctx;
 
-	obj = pdf_dict_gets(dict, "Coords");
+	obj = pdf_dict_get(dict, PDF_NAME(Coords));
 	shade->u.l_or_r.coords[0][0] = pdf_to_real(pdf_array_get(obj, 0));
 	shade->u.l_or_r.coords[0][1] = pdf_to_real(pdf_array_get(obj, 1));
 	shade->u.l_or_r.coords[0][2] = pdf_to_real(pdf_array_get(obj, 2));
@@ -152,7 +152,7 @@ pdf_load_radial_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 
 	d0 = 0;
 	d1 = 1;
-	obj = pdf_dict_gets(dict, "Domain");
+	obj = pdf_dict_get(dict, PDF_NAME(Domain));
 	if (obj)
 	{
 		d0 = pdf_to_real(pdf_array_get(obj, 0));
@@ -160,7 +160,7 @@ pdf_load_radial_shading(fz_shade *shade, pdf_document *doc, pdf_obj *dict, int f
 	}
 
 	e0 = e1 = 0;
-	obj = pdf_dict_gets(dict, "Extend");
+	obj = pdf_dict_get(dict, PDF_NAME(Extend));
 	if (obj)
 	{
 		e0 = pdf_to_bool(pdf_array_get(obj, 0));
@@ -202,12 +202,12 @@ pdf_load_mesh_params(fz_shade *shade, pdf_document *doc, pdf_obj *dict)
 		shade->u.m.c1[i] = 1;
 	}
 
-	shade->u.m.vprow = pdf_to_int(pdf_dict_gets(dict, "VerticesPerRow"));
-	shade->u.m.bpflag = pdf_to_int(pdf_dict_gets(dict, "BitsPerFlag"));
-	shade->u.m.bpcoord = pdf_to_int(pdf_dict_gets(dict, "BitsPerCoordinate"));
-	shade->u.m.bpcomp = pdf_to_int(pdf_dict_gets(dict, "BitsPerComponent"));
+	shade->u.m.vprow = pdf_to_int(pdf_dict_get(dict, PDF_NAME(VerticesPerRow)));
+	shade->u.m.bpflag = pdf_to_int(pdf_dict_get(dict, PDF_NAME(BitsPerFlag)));
+	shade->u.m.bpcoord = pdf_to_int(pdf_dict_get(dict, PDF_NAME(BitsPerCoordinate)));
+	shade->u.m.bpcomp = pdf_to_int(pdf_dict_get(dict, PDF_NAME(BitsPerComponent)));
 
-	obj = pdf_dict_gets(dict, "Decode");
+	obj = pdf_dict_get(dict, PDF_NAME(Decode));
 	if (pdf_array_len(obj) >= 6)
 	{
 		n = (pdf_array_len(obj) - 4) / 2;
@@ -341,15 +341,15 @@ pdf_load_shading_dict(pdf_document *doc, pdf_obj *dict, const fz_matrix *transfo
 
 		funcs = 0;
 
-		obj = pdf_dict_gets(dict, "ShadingType");
+		obj = pdf_dict_get(dict, PDF_NAME(ShadingType));
 		type = pdf_to_int(obj);
 
-		obj = pdf_dict_gets(dict, "ColorSpace");
+		obj = pdf_dict_get(dict, PDF_NAME(ColorSpace));
 		if (!obj)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "shading colorspace is missing");
 		shade->colorspace = pdf_load_colorspace(doc, obj);
 
-		obj = pdf_dict_gets(dict, "Background");
+		obj = pdf_dict_get(dict, PDF_NAME(Background));
 		if (obj)
 		{
 			shade->use_background = 1;
@@ -357,11 +357,11 @@ pdf_load_shading_dict(pdf_document *doc, pdf_obj *dict, const fz_matrix *transfo
 				shade->background[i] = pdf_to_real(pdf_array_get(obj, i));
 		}
 
-		obj = pdf_dict_gets(dict, "BBox");
+		obj = pdf_dict_get(dict, PDF_NAME(BBox));
 		if (pdf_is_array(obj))
 			pdf_to_rect(ctx, obj, &shade->bbox);
 
-		obj = pdf_dict_gets(dict, "Function");
+		obj = pdf_dict_get(dict, PDF_NAME(Function));
 		if (pdf_is_dict(obj))
 		{
 			funcs = 1;
@@ -462,24 +462,24 @@ pdf_load_shading(pdf_document *doc, pdf_obj *dict)
 	}
 
 	/* Type 2 pattern dictionary */
-	if (pdf_dict_gets(dict, "PatternType"))
+	if (pdf_dict_get(dict, PDF_NAME(PatternType)))
 	{
-		obj = pdf_dict_gets(dict, "Matrix");
+		obj = pdf_dict_get(dict, PDF_NAME(Matrix));
 		if (obj)
 			pdf_to_matrix(ctx, obj, &mat);
 		else
 			mat = fz_identity;
 
-		obj = pdf_dict_gets(dict, "ExtGState");
+		obj = pdf_dict_get(dict, PDF_NAME(ExtGState));
 		if (obj)
 		{
-			if (pdf_dict_gets(obj, "CA") || pdf_dict_gets(obj, "ca"))
+			if (pdf_dict_get(obj, PDF_NAME(CA)) || pdf_dict_get(obj, PDF_NAME(ca)))
 			{
 				fz_warn(ctx, "shading with alpha not supported");
 			}
 		}
 
-		obj = pdf_dict_gets(dict, "Shading");
+		obj = pdf_dict_get(dict, PDF_NAME(Shading));
 		if (!obj)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "syntaxerror: missing shading dictionary");
 
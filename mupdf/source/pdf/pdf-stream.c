@@ -27,10 +27,10 @@ pdf_stream_has_crypt(fz_context *ctx, pdf_obj *stm)
 	pdf_obj *obj;
 	int i;
 
-	filters = pdf_dict_getsa(stm, "Filter", "F");
+	filters = pdf_dict_geta(stm, PDF_NAME(Filter), PDF_NAME(F));
 	if (filters)
 	{
-		if (!strcmp(pdf_to_name(filters), "Crypt"))
+		if (pdf_name_eq(filters, PDF_NAME(Crypt)))
 			return 1;
 		if (pdf_is_array(filters))
 		{
@@ -38,7 +38,7 @@ pdf_stream_has_crypt(fz_context *ctx, pdf_obj *stm)
 			for (i = 0; i < n; i++)
 			{
 				obj = pdf_array_get(filters, i);
-				if (!strcmp(pdf_to_name(obj), "Crypt"))
+				if (pdf_name_eq(obj, PDF_NAME(Crypt)))
 					return 1;
 			}
 		}
@@ -87,11 +87,11 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 	fz_context *ctx = chain->ctx;
 	char *s = pdf_to_name(f);
 
-	int predictor = pdf_to_int(pdf_dict_gets(p, "Predictor"));
-	pdf_obj *columns_obj = pdf_dict_gets(p, "Columns");
+	int predictor = pdf_to_int(pdf_dict_get(p, PDF_NAME(Predictor)));
+	pdf_obj *columns_obj = pdf_dict_get(p, PDF_NAME(Columns));
 	int columns = pdf_to_int(columns_obj);
-	int colors = pdf_to_int(pdf_dict_gets(p, "Colors"));
-	int bpc = pdf_to_int(pdf_dict_gets(p, "BitsPerComponent"));
+	int colors = pdf_to_int(pdf_dict_get(p, PDF_NAME(Colors)));
+	int bpc = pdf_to_int(pdf_dict_get(p, PDF_NAME(BitsPerComponent)));
 
 	if (params)
 		params->type = FZ_IMAGE_RAW;
@@ -104,12 +104,12 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 
 	else if (!strcmp(s, "CCITTFaxDecode") || !strcmp(s, "CCF"))
 	{
-		pdf_obj *k = pdf_dict_gets(p, "K");
-		pdf_obj *eol = pdf_dict_gets(p, "EndOfLine");
-		pdf_obj *eba = pdf_dict_gets(p, "EncodedByteAlign");
-		pdf_obj *rows = pdf_dict_gets(p, "Rows");
-		pdf_obj *eob = pdf_dict_gets(p, "EndOfBlock");
-		pdf_obj *bi1 = pdf_dict_gets(p, "BlackIs1");
+		pdf_obj *k = pdf_dict_get(p, PDF_NAME(K));
+		pdf_obj *eol = pdf_dict_get(p, PDF_NAME(EndOfLine));
+		pdf_obj *eba = pdf_dict_get(p, PDF_NAME(EncodedByteAlign));
+		pdf_obj *rows = pdf_dict_get(p, PDF_NAME(Rows));
+		pdf_obj *eob = pdf_dict_get(p, PDF_NAME(EndOfBlock));
+		pdf_obj *bi1 = pdf_dict_get(p, PDF_NAME(BlackIs1));
 		if (params)
 		{
 			/* We will shortstop here */
@@ -135,7 +135,7 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 
 	else if (!strcmp(s, "DCTDecode") || !strcmp(s, "DCT"))
 	{
-		pdf_obj *ct = pdf_dict_gets(p, "ColorTransform");
+		pdf_obj *ct = pdf_dict_get(p, PDF_NAME(ColorTransform));
 		if (params)
 		{
 			/* We will shortstop here */
@@ -176,7 +176,7 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 
 	else if (!strcmp(s, "LZWDecode") || !strcmp(s, "LZW"))
 	{
-		pdf_obj *ec = pdf_dict_gets(p, "EarlyChange");
+		pdf_obj *ec = pdf_dict_get(p, PDF_NAME(EarlyChange));
 		if (params)
 		{
 			/* We will shortstop here */
@@ -197,7 +197,7 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 	else if (!strcmp(s, "JBIG2Decode"))
 	{
 		fz_jbig2_globals *globals = NULL;
-		pdf_obj *obj = pdf_dict_gets(p, "JBIG2Globals");
+		pdf_obj *obj = pdf_dict_get(p, PDF_NAME(JBIG2Globals));
 		if (pdf_is_indirect(obj))
 			globals = pdf_load_jbig2_globals(doc, obj);
 		/* fz_open_jbig2d takes possession of globals */
@@ -217,7 +217,7 @@ build_filter(fz_stream *chain, pdf_document *doc, pdf_obj *f, pdf_obj *p, int nu
 			return chain;
 		}
 
-		name = pdf_dict_gets(p, "Name");
+		name = pdf_dict_get(p, PDF_NAME(Name));
 		if (pdf_is_name(name))
 			return pdf_open_crypt_with_filter(chain, doc->crypt, pdf_to_name(name), num, gen);
 
@@ -289,7 +289,7 @@ pdf_open_raw_filter(fz_stream *chain, pdf_document *doc, pdf_obj *stmobj, int nu
 	/* don't close chain when we close this filter */
 	fz_keep_stream(chain);
 
-	len = pdf_to_int(pdf_dict_gets(stmobj, "Length"));
+	len = pdf_to_int(pdf_dict_get(stmobj, PDF_NAME(Length)));
 	chain = fz_open_null(chain, len, offset);
 
 	hascrypt = pdf_stream_has_crypt(ctx, stmobj);
@@ -309,8 +309,8 @@ pdf_open_filter(fz_stream *chain, pdf_document *doc, pdf_obj *stmobj, int num, i
 	pdf_obj *filters;
 	pdf_obj *params;
 
-	filters = pdf_dict_getsa(stmobj, "Filter", "F");
-	params = pdf_dict_getsa(stmobj, "DecodeParms", "DP");
+	filters = pdf_dict_geta(stmobj, PDF_NAME(Filter), PDF_NAME(F));
+	params = pdf_dict_geta(stmobj, PDF_NAME(DecodeParms), PDF_NAME(DP));
 
 	chain = pdf_open_raw_filter(chain, doc, stmobj, num, num, gen, offset);
 
@@ -350,8 +350,8 @@ pdf_open_inline_stream(pdf_document *doc, pdf_obj *stmobj, int length, fz_stream
 	pdf_obj *filters;
 	pdf_obj *params;
 
-	filters = pdf_dict_getsa(stmobj, "Filter", "F");
-	params = pdf_dict_getsa(stmobj, "DecodeParms", "DP");
+	filters = pdf_dict_geta(stmobj, PDF_NAME(Filter), PDF_NAME(F));
+	params = pdf_dict_geta(stmobj, PDF_NAME(DecodeParms), PDF_NAME(DP));
 
 	/* don't close chain when we close this filter */
 	fz_keep_stream(chain);
@@ -483,7 +483,7 @@ pdf_load_raw_renumbered_stream(pdf_document *doc, int num, int gen, int orig_num
 
 	dict = pdf_load_object(doc, num, gen);
 
-	len = pdf_to_int(pdf_dict_gets(dict, "Length"));
+	len = pdf_to_int(pdf_dict_get(dict, PDF_NAME(Length)));
 
 	pdf_drop_obj(dict);
 
@@ -531,8 +531,8 @@ pdf_load_image_stream(pdf_document *doc, int num, int gen, int orig_num, int ori
 
 	dict = pdf_load_object(doc, num, gen);
 
-	len = pdf_to_int(pdf_dict_gets(dict, "Length"));
-	obj = pdf_dict_gets(dict, "Filter");
+	len = pdf_to_int(pdf_dict_get(dict, PDF_NAME(Length)));
+	obj = pdf_dict_get(dict, PDF_NAME(Filter));
 	len = pdf_guess_filter_length(len, pdf_to_name(obj));
 	n = pdf_array_len(obj);
 	for (i = 0; i < n; i++)
@@ -44,7 +44,7 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(dict, "Name");
+		obj = pdf_dict_get(dict, PDF_NAME(Name));
 		if (pdf_is_name(obj))
 			fz_strlcpy(buf, pdf_to_name(obj), sizeof buf);
 		else
@@ -52,10 +52,10 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 
 		fontdesc = pdf_new_font_desc(ctx);
 
-		obj = pdf_dict_gets(dict, "FontMatrix");
+		obj = pdf_dict_get(dict, PDF_NAME(FontMatrix));
 		pdf_to_matrix(ctx, obj, &matrix);
 
-		obj = pdf_dict_gets(dict, "FontBBox");
+		obj = pdf_dict_get(dict, PDF_NAME(FontBBox));
 		fz_transform_rect(pdf_to_rect(ctx, obj, &bbox), &matrix);
 
 		fontdesc->font = fz_new_type3_font(ctx, buf, &matrix);
@@ -64,14 +64,14 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 		fz_set_font_bbox(ctx, fontdesc->font, bbox.x0, bbox.y0, bbox.x1, bbox.y1);
 
 		/* SumatraPDF: expose Type3 FontDescriptor flags */
-		fontdesc->flags = pdf_to_int(pdf_dict_gets(pdf_dict_gets(dict, "FontDescriptor"), "Flags"));
+		fontdesc->flags = pdf_to_int(pdf_dict_get(pdf_dict_get(dict, PDF_NAME(FontDescriptor)), PDF_NAME(Flags)));
 
 		/* Encoding */
 
 		for (i = 0; i < 256; i++)
 			estrings[i] = NULL;
 
-		encoding = pdf_dict_gets(dict, "Encoding");
+		encoding = pdf_dict_get(dict, PDF_NAME(Encoding));
 		if (!encoding)
 		{
 			fz_throw(ctx, FZ_ERROR_GENERIC, "syntaxerror: Type3 font missing Encoding");
@@ -84,11 +84,11 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 		{
 			pdf_obj *base, *diff, *item;
 
-			base = pdf_dict_gets(encoding, "BaseEncoding");
+			base = pdf_dict_get(encoding, PDF_NAME(BaseEncoding));
 			if (pdf_is_name(base))
 				pdf_load_encoding(estrings, pdf_to_name(base));
 
-			diff = pdf_dict_gets(encoding, "Differences");
+			diff = pdf_dict_get(encoding, PDF_NAME(Differences));
 			if (pdf_is_array(diff))
 			{
 				n = pdf_array_len(diff);
@@ -107,7 +107,7 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 		fontdesc->encoding = pdf_new_identity_cmap(ctx, 0, 1);
 		fontdesc->size += pdf_cmap_size(ctx, fontdesc->encoding);
 
-		pdf_load_to_unicode(doc, fontdesc, estrings, NULL, pdf_dict_gets(dict, "ToUnicode"));
+		pdf_load_to_unicode(doc, fontdesc, estrings, NULL, pdf_dict_get(dict, PDF_NAME(ToUnicode)));
 
 		/* SumatraPDF: trying to match Adobe Reader's behavior */
 		if (!(fontdesc->flags & PDF_FD_SYMBOLIC) && fontdesc->cid_to_ucs_len >= 128)
@@ -119,8 +119,8 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 
 		pdf_set_default_hmtx(ctx, fontdesc, 0);
 
-		first = pdf_to_int(pdf_dict_gets(dict, "FirstChar"));
-		last = pdf_to_int(pdf_dict_gets(dict, "LastChar"));
+		first = pdf_to_int(pdf_dict_get(dict, PDF_NAME(FirstChar)));
+		last = pdf_to_int(pdf_dict_get(dict, PDF_NAME(LastChar)));
 
 		/* cf. http://code.google.com/p/sumatrapdf/issues/detail?id=1966 */
 		if (first >= 256 && last - first < 256)
@@ -133,7 +133,7 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 		if (first < 0 || last > 255 || first > last)
 			first = last = 0;
 
-		widths = pdf_dict_gets(dict, "Widths");
+		widths = pdf_dict_get(dict, PDF_NAME(Widths));
 		if (!widths)
 		{
 			fz_throw(ctx, FZ_ERROR_GENERIC, "syntaxerror: Type3 font missing Widths");
@@ -152,7 +152,7 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 		/* Resources -- inherit page resources if the font doesn't have its own */
 
 		fontdesc->font->t3freeres = pdf_t3_free_resources;
-		fontdesc->font->t3resources = pdf_dict_gets(dict, "Resources");
+		fontdesc->font->t3resources = pdf_dict_get(dict, PDF_NAME(Resources));
 		if (!fontdesc->font->t3resources)
 			fontdesc->font->t3resources = rdb;
 		if (fontdesc->font->t3resources)
@@ -165,7 +165,7 @@ pdf_load_type3_font(pdf_document *doc, pdf_obj *rdb, pdf_obj *dict)
 
 		/* CharProcs */
 
-		charprocs = pdf_dict_gets(dict, "CharProcs");
+		charprocs = pdf_dict_get(dict, PDF_NAME(CharProcs));
 		if (!charprocs)
 		{
 			fz_throw(ctx, FZ_ERROR_GENERIC, "syntaxerror: Type3 font missing CharProcs");
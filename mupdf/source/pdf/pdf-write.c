@@ -1,5 +1,11 @@
 #include "mupdf/pdf.h"
 
+#include <zlib.h>
+
+#if defined(_WIN32) && !defined(_WINRT)
+#include <windows.h>
+#endif
+
 /* #define DEBUG_LINEARIZATION */
 /* #define DEBUG_HEAP_SORT */
 /* #define DEBUG_WRITING */
@@ -79,6 +85,14 @@ struct pdf_write_options_s
 	pdf_obj *hints_length;
 	int page_count;
 	page_objects_list *page_object_lists;
+	/* SumatraPDF: The following are required for object streams */
+	int do_objstms;
+	int do_appending;
+	int *objstm_list;
+	int *objstm_index;
+	int objstm_count;
+	struct objstm_s *objstms;
+	volatile long next_objstm;
 };
 
 /*
@@ -522,12 +536,12 @@ static pdf_obj *sweepref(pdf_document *doc, pdf_write_options *opts, pdf_obj *ob
 	{
 		if (pdf_is_stream(doc, num, gen))
 		{
-			pdf_obj *len = pdf_dict_gets(obj, "Length");
+			pdf_obj *len = pdf_dict_get(obj, PDF_NAME(Length));
 			if (pdf_is_indirect(len))
 			{
 				opts->use_list[pdf_to_num(len)] = 0;
 				len = pdf_resolve_indirect(len);
-				pdf_dict_puts(obj, "Length", len);
+				pdf_dict_put(obj, PDF_NAME(Length), len);
 			}
 		}
 	}
@@ -563,24 +577,128 @@ static void sweepobj(pdf_document *doc, pdf_write_options *opts, pdf_obj *obj)
 }
 
 /*
- * Scan for and remove duplicate objects (slow)
+ * Scan for and remove duplicate objects
+ *
+ * Objects are put into buckets by a structural hash which agrees with
+ * pdf_objcmp, so that an object only has to be compared against the
+ * preceding objects with the same hash instead of against all of them.
  */
 
+static unsigned int hashbytes(unsigned int h, const void *data, int len)
+{
+	const unsigned char *s = data;
+	while (len-- > 0)
+		h = (h ^ *s++) * 16777619;
+	return h;
+}
+
+static unsigned int hashint(unsigned int h, int i)
+{
+	return hashbytes(h, &i, sizeof(i));
+}
+
+static unsigned int hashobj(unsigned int h, pdf_obj *obj)
+{
+	int i, n;
+
+	/* pdf_objcmp resolves indirect references when comparing them to names */
+	if (pdf_is_name(obj))
+	{
+		char *name = pdf_to_name(obj);
+		return hashbytes(hashint(h, 'n'), name, strlen(name));
+	}
+	if (pdf_is_indirect(obj))
+		return hashint(hashint(hashint(h, 'r'), pdf_to_num(obj)), pdf_to_gen(obj));
+	if (!obj || pdf_is_null(obj))
+		return hashint(h, 0);
+	if (pdf_is_bool(obj))
+		return hashint(hashint(h, 'b'), pdf_to_bool(obj));
+	if (pdf_is_int(obj))
+		return hashint(hashint(h, 'i'), pdf_to_int(obj));
+	if (pdf_is_real(obj))
+	{
+		/* 0 and -0 compare equal (parsed reals are never NaN) */
+		float f = pdf_to_real(obj);
+		if (f == 0)
+			f = 0;
+		return hashbytes(hashint(h, 'f'), &f, sizeof(f));
+	}
+	if (pdf_is_string(obj))
+		return hashbytes(hashint(h, 's'), pdf_to_str_buf(obj), pdf_to_str_len(obj));
+	if (pdf_is_array(obj))
+	{
+		n = pdf_array_len(obj);
+		h = hashint(hashint(h, 'a'), n);
+		for (i = 0; i < n; i++)
+			h = hashobj(h, pdf_array_get(obj, i));
+		return h;
+	}
+	if (pdf_is_dict(obj))
+	{
+		/* pdf_objcmp compares entries in their current order */
+		n = pdf_dict_len(obj);
+		h = hashint(hashint(h, 'd'), n);
+		for (i = 0; i < n; i++)
+		{
+			h = hashobj(h, pdf_dict_get_key(obj, i));
+			h = hashobj(h, pdf_dict_get_val(obj, i));
+		}
+		return h;
+	}
+	return h;
+}
+
+enum
+{
+	DEDUP_STREAM = 1,
+	DEDUP_DATA_HASHED = 2
+};
+
+static unsigned int hashstream(fz_context *ctx, fz_buffer *buf)
+{
+	unsigned char *data;
+	int len = fz_buffer_storage(ctx, buf, &data);
+	return hashbytes(hashint(2166136261u, len), data, len);
+}
+
 static void removeduplicateobjs(pdf_document *doc, pdf_write_options *opts)
 {
-	int num, other;
+	int num, other, newnum, bucket, size;
 	fz_context *ctx = doc->ctx;
 	int xref_len = pdf_xref_len(doc);
+	unsigned int *hashes = NULL, *datahashes = NULL;
+	unsigned char *flags = NULL;
+	int *next = NULL, *heads = NULL, *tails = NULL;
+	fz_buffer *sa = NULL;
+	fz_buffer *sb = NULL;
+
+	fz_var(hashes);
+	fz_var(datahashes);
+	fz_var(flags);
+	fz_var(next);
+	fz_var(heads);
+	fz_var(tails);
+	fz_var(sa);
+	fz_var(sb);
+
+	for (size = 64; size < xref_len; size <<= 1)
+		;
 
-	for (num = 1; num < xref_len; num++)
+	fz_try(ctx)
 	{
-		/* Only compare an object to objects preceding it */
-		for (other = 1; other < num; other++)
+		hashes = fz_malloc_array(ctx, xref_len, sizeof(*hashes));
+		datahashes = fz_malloc_array(ctx, xref_len, sizeof(*datahashes));
+		flags = fz_calloc(ctx, xref_len, sizeof(*flags));
+		next = fz_calloc(ctx, xref_len, sizeof(*next));
+		heads = fz_calloc(ctx, size, sizeof(*heads));
+		tails = fz_calloc(ctx, size, sizeof(*tails));
+
+		for (num = 1; num < xref_len; num++)
 		{
 			pdf_obj *a, *b;
-			int differ, newnum, streama, streamb;
+			int differ, streama;
 
-			if (num == other || !opts->use_list[num] || !opts->use_list[other])
+			if (!opts->use_list[num])
 				continue;
 
 			/*
@@ -592,10 +710,7 @@ static void removeduplicateobjs(pdf_document *doc, pdf_write_options *opts)
 			fz_try(ctx)
 			{
 				streama = pdf_is_stream(doc, num, 0);
-				streamb = pdf_is_stream(doc, other, 0);
-				differ = streama || streamb;
-				if (streama && streamb && opts->do_garbage >= 4)
-					differ = 0;
+				differ = streama && opts->do_garbage < 4;
 			}
 			fz_catch(ctx)
 			{
@@ -606,59 +721,101 @@ static void removeduplicateobjs(pdf_document *doc, pdf_write_options *opts)
 				continue;
 
 			a = pdf_get_xref_entry(doc, num)->obj;
-			b = pdf_get_xref_entry(doc, other)->obj;
-
 			a = pdf_resolve_indirect(a);
-			b = pdf_resolve_indirect(b);
 
-			if (pdf_objcmp(a, b))
-				continue;
+			hashes[num] = hashobj(2166136261u, a);
+			if (streama)
+				flags[num] = DEDUP_STREAM;
+			bucket = hashes[num] & (size - 1);
 
-			if (streama && streamb)
+			/* Only compare an object to (used) objects preceding it, lowest first */
+			for (other = heads[bucket]; other; other = next[other])
 			{
-				/* Check to see if streams match too. */
-				fz_buffer *sa = NULL;
-				fz_buffer *sb = NULL;
+				if (hashes[other] != hashes[num] || (flags[other] ^ flags[num]) & DEDUP_STREAM)
+					continue;
 
-				fz_var(sa);
-				fz_var(sb);
+				b = pdf_get_xref_entry(doc, other)->obj;
+				b = pdf_resolve_indirect(b);
 
-				differ = 1;
-				fz_try(ctx)
+				if (pdf_objcmp(a, b))
+					continue;
+
+				if (streama)
 				{
+					/* Check to see if streams match too. */
 					unsigned char *dataa, *datab;
 					int lena, lenb;
-					sa = pdf_load_raw_renumbered_stream(doc, num, 0, num, 0);
-					sb = pdf_load_raw_renumbered_stream(doc, other, 0, other, 0);
+
+					if (!sa)
+					{
+						sa = pdf_load_raw_renumbered_stream(doc, num, 0, num, 0);
+						datahashes[num] = hashstream(ctx, sa);
+						flags[num] |= DEDUP_DATA_HASHED;
+					}
+					if (!(flags[other] & DEDUP_DATA_HASHED))
+					{
+						sb = pdf_load_raw_renumbered_stream(doc, other, 0, other, 0);
+						datahashes[other] = hashstream(ctx, sb);
+						flags[other] |= DEDUP_DATA_HASHED;
+					}
+					if (datahashes[num] != datahashes[other])
+					{
+						fz_drop_buffer(ctx, sb);
+						sb = NULL;
+						continue;
+					}
+
+					if (!sb)
+						sb = pdf_load_raw_renumbered_stream(doc, other, 0, other, 0);
 					lena = fz_buffer_storage(ctx, sa, &dataa);
 					lenb = fz_buffer_storage(ctx, sb, &datab);
-					if (lena == lenb && memcmp(dataa, datab, lena) == 0)
-						differ = 0;
-				}
-				fz_always(ctx)
-				{
-					fz_drop_buffer(ctx, sa);
+					differ = lena != lenb || memcmp(dataa, datab, lena) != 0;
 					fz_drop_buffer(ctx, sb);
+					sb = NULL;
+					if (differ)
+						continue;
 				}
-				fz_catch(ctx)
-				{
-					fz_rethrow(ctx);
-				}
-				if (differ)
-					continue;
+
+				/* Keep the lowest numbered object */
+				newnum = fz_mini(num, other);
+				opts->renumber_map[num] = newnum;
+				opts->renumber_map[other] = newnum;
+				opts->rev_renumber_map[newnum] = num; /* Either will do */
+				opts->use_list[fz_maxi(num, other)] = 0;
+
+				/* One duplicate was found, do not look for another */
+				break;
 			}
 
-			/* Keep the lowest numbered object */
-			newnum = fz_mini(num, other);
-			opts->renumber_map[num] = newnum;
-			opts->renumber_map[other] = newnum;
-			opts->rev_renumber_map[newnum] = num; /* Either will do */
-			opts->use_list[fz_maxi(num, other)] = 0;
+			fz_drop_buffer(ctx, sa);
+			sa = NULL;
 
-			/* One duplicate was found, do not look for another */
-			break;
+			/* Unique objects become candidates for the following ones */
+			if (!other)
+			{
+				if (tails[bucket])
+					next[tails[bucket]] = num;
+				else
+					heads[bucket] = num;
+				tails[bucket] = num;
+			}
 		}
 	}
+	fz_always(ctx)
+	{
+		fz_drop_buffer(ctx, sa);
+		fz_drop_buffer(ctx, sb);
+		fz_free(ctx, hashes);
+		fz_free(ctx, datahashes);
+		fz_free(ctx, flags);
+		fz_free(ctx, next);
+		fz_free(ctx, heads);
+		fz_free(ctx, tails);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
 }
 
 /*
@@ -927,7 +1084,7 @@ mark_pages(pdf_document *doc, pdf_write_options *opts, pdf_obj *val, int pagenum
 	{
 		if (pdf_is_dict(val))
 		{
-			if (!strcmp("Page", pdf_to_name(pdf_dict_gets(val, "Type"))))
+			if (!strcmp("Page", pdf_to_name(pdf_dict_get(val, PDF_NAME(Type)))))
 			{
 				int num = pdf_to_num(val);
 				pdf_unmark_obj(val);
@@ -1017,7 +1174,7 @@ mark_root(pdf_document *doc, pdf_write_options *opts, pdf_obj *dict)
 				int section;
 				/* Look at PageMode to decide whether to
 				 * USE_OTHER_OBJECTS or USE_PAGE1 here. */
-				if (strcmp(pdf_to_name(pdf_dict_gets(dict, "PageMode")), "UseOutlines") == 0)
+				if (strcmp(pdf_to_name(pdf_dict_get(dict, PDF_NAME(PageMode))), "UseOutlines") == 0)
 					section = USE_PAGE1;
 				else
 					section = USE_OTHER_OBJECTS;
@@ -1098,24 +1255,24 @@ add_linearization_objs(pdf_document *doc, pdf_write_options *opts)
 		opts->rev_renumber_map[params_num] = params_num;
 		opts->gen_list[params_num] = 0;
 		opts->rev_gen_list[params_num] = 0;
-		pdf_dict_puts_drop(params_obj, "Linearized", pdf_new_real(doc, 1.0));
+		pdf_dict_put_drop(params_obj, PDF_NAME(Linearized), pdf_new_real(doc, 1.0));
 		opts->linear_l = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(params_obj, "L", opts->linear_l);
+		pdf_dict_put(params_obj, PDF_NAME(L), opts->linear_l);
 		opts->linear_h0 = pdf_new_int(doc, INT_MIN);
 		o = pdf_new_array(doc, 2);
 		pdf_array_push(o, opts->linear_h0);
 		opts->linear_h1 = pdf_new_int(doc, INT_MIN);
 		pdf_array_push(o, opts->linear_h1);
-		pdf_dict_puts_drop(params_obj, "H", o);
+		pdf_dict_put_drop(params_obj, PDF_NAME(H), o);
 		o = NULL;
 		opts->linear_o = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(params_obj, "O", opts->linear_o);
+		pdf_dict_put(params_obj, PDF_NAME(O), opts->linear_o);
 		opts->linear_e = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(params_obj, "E", opts->linear_e);
+		pdf_dict_put(params_obj, PDF_NAME(E), opts->linear_e);
 		opts->linear_n = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(params_obj, "N", opts->linear_n);
+		pdf_dict_put(params_obj, PDF_NAME(N), opts->linear_n);
 		opts->linear_t = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(params_obj, "T", opts->linear_t);
+		pdf_dict_put(params_obj, PDF_NAME(T), opts->linear_t);
 
 		/* Primary hint stream */
 		hint_obj = pdf_new_dict(doc, 10);
@@ -1127,9 +1284,9 @@ add_linearization_objs(pdf_document *doc, pdf_write_options *opts)
 		opts->rev_renumber_map[hint_num] = hint_num;
 		opts->gen_list[hint_num] = 0;
 		opts->rev_gen_list[hint_num] = 0;
-		pdf_dict_puts_drop(hint_obj, "P", pdf_new_int(doc, 0));
+		pdf_dict_put_drop(hint_obj, PDF_NAME(P), pdf_new_int(doc, 0));
 		opts->hints_s = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(hint_obj, "S", opts->hints_s);
+		pdf_dict_put(hint_obj, PDF_NAME(S), opts->hints_s);
 		/* FIXME: Do we have thumbnails? Do a T entry */
 		/* FIXME: Do we have outlines? Do an O entry */
 		/* FIXME: Do we have article threads? Do an A entry */
@@ -1138,9 +1295,9 @@ add_linearization_objs(pdf_document *doc, pdf_write_options *opts)
 		/* FIXME: Do we have document information? Do an I entry */
 		/* FIXME: Do we have logical structure heirarchy? Do a C entry */
 		/* FIXME: Do L, Page Label hint table */
-		pdf_dict_puts_drop(hint_obj, "Filter", pdf_new_name(doc, "FlateDecode"));
+		pdf_dict_put_drop(hint_obj, PDF_NAME(Filter), pdf_new_name(doc, "FlateDecode"));
 		opts->hints_length = pdf_new_int(doc, INT_MIN);
-		pdf_dict_puts(hint_obj, "Length", opts->hints_length);
+		pdf_dict_put(hint_obj, PDF_NAME(Length), opts->hints_length);
 		pdf_get_xref_entry(doc, hint_num)->stm_ofs = -1;
 	}
 	fz_always(ctx)
@@ -1208,12 +1365,12 @@ lpr_inherit_res(fz_context *ctx, pdf_obj *node, int depth, pdf_obj *dict)
 	{
 		pdf_obj *o;
 
-		node = pdf_dict_gets(node, "Parent");
+		node = pdf_dict_get(node, PDF_NAME(Parent));
 		depth--;
 		if (!node || depth < 0)
 			break;
 
-		o = pdf_dict_gets(node, "Resources");
+		o = pdf_dict_get(node, PDF_NAME(Resources));
 		if (o)
 		{
 			lpr_inherit_res_contents(ctx, dict, o, "ExtGState");
@@ -1237,7 +1394,7 @@ lpr_inherit(fz_context *ctx, pdf_obj *node, char *text, int depth)
 
 		if (o)
 			return pdf_resolve_indirect(o);
-		node = pdf_dict_gets(node, "Parent");
+		node = pdf_dict_get(node, PDF_NAME(Parent));
 		depth--;
 	}
 	while (depth >= 0 && node);
@@ -1260,53 +1417,53 @@ lpr(pdf_document *doc, pdf_obj *node, int depth, int page)
 
 	fz_try(ctx)
 	{
-		if (!strcmp("Page", pdf_to_name(pdf_dict_gets(node, "Type"))))
+		if (!strcmp("Page", pdf_to_name(pdf_dict_get(node, PDF_NAME(Type)))))
 		{
 			pdf_obj *r; /* r is deliberately not cleaned up */
 
 			/* Copy resources down to the child */
-			o = pdf_keep_obj(pdf_dict_gets(node, "Resources"));
+			o = pdf_keep_obj(pdf_dict_get(node, PDF_NAME(Resources)));
 			if (!o)
 			{
 				o = pdf_keep_obj(pdf_new_dict(doc, 2));
-				pdf_dict_puts(node, "Resources", o);
+				pdf_dict_put(node, PDF_NAME(Resources), o);
 			}
 			lpr_inherit_res(ctx, node, depth, o);
 			r = lpr_inherit(ctx, node, "MediaBox", depth);
 			if (r)
-				pdf_dict_puts(node, "MediaBox", r);
+				pdf_dict_put(node, PDF_NAME(MediaBox), r);
 			r = lpr_inherit(ctx, node, "CropBox", depth);
 			if (r)
-				pdf_dict_puts(node, "CropBox", r);
+				pdf_dict_put(node, PDF_NAME(CropBox), r);
 			r = lpr_inherit(ctx, node, "BleedBox", depth);
 			if (r)
-				pdf_dict_puts(node, "BleedBox", r);
+				pdf_dict_put(node, PDF_NAME(BleedBox), r);
 			r = lpr_inherit(ctx, node, "TrimBox", depth);
 			if (r)
-				pdf_dict_puts(node, "TrimBox", r);
+				pdf_dict_put(node, PDF_NAME(TrimBox), r);
 			r = lpr_inherit(ctx, node, "ArtBox", depth);
 			if (r)
-				pdf_dict_puts(node, "ArtBox", r);
+				pdf_dict_put(node, PDF_NAME(ArtBox), r);
 			r = lpr_inherit(ctx, node, "Rotate", depth);
 			if (r)
-				pdf_dict_puts(node, "Rotate", r);
+				pdf_dict_put(node, PDF_NAME(Rotate), r);
 			page++;
 		}
 		else
 		{
-			kids = pdf_dict_gets(node, "Kids");
+			kids = pdf_dict_get(node, PDF_NAME(Kids));
 			n = pdf_array_len(kids);
 			for(i = 0; i < n; i++)
 			{
 				page = lpr(doc, pdf_array_get(kids, i), depth+1, page);
 			}
-			pdf_dict_dels(node, "Resources");
-			pdf_dict_dels(node, "MediaBox");
-			pdf_dict_dels(node, "CropBox");
-			pdf_dict_dels(node, "BleedBox");
-			pdf_dict_dels(node, "TrimBox");
-			pdf_dict_dels(node, "ArtBox");
-			pdf_dict_dels(node, "Rotate");
+			pdf_dict_del(node, PDF_NAME(Resources));
+			pdf_dict_del(node, PDF_NAME(MediaBox));
+			pdf_dict_del(node, PDF_NAME(CropBox));
+			pdf_dict_del(node, PDF_NAME(BleedBox));
+			pdf_dict_del(node, PDF_NAME(TrimBox));
+			pdf_dict_del(node, PDF_NAME(ArtBox));
+			pdf_dict_del(node, PDF_NAME(Rotate));
 		}
 	}
 	fz_always(ctx)
@@ -1514,8 +1671,8 @@ static void addhexfilter(pdf_document *doc, pdf_obj *dict)
 	nullobj = pdf_new_null(doc);
 	newf = newdp = NULL;
 
-	f = pdf_dict_gets(dict, "Filter");
-	dp = pdf_dict_gets(dict, "DecodeParms");
+	f = pdf_dict_get(dict, PDF_NAME(Filter));
+	dp = pdf_dict_get(dict, PDF_NAME(DecodeParms));
 
 	if (pdf_is_name(f))
 	{
@@ -1540,9 +1697,9 @@ static void addhexfilter(pdf_document *doc, pdf_obj *dict)
 	else
 		f = ahx;
 
-	pdf_dict_puts(dict, "Filter", f);
+	pdf_dict_put(dict, PDF_NAME(Filter), f);
 	if (dp)
-		pdf_dict_puts(dict, "DecodeParms", dp);
+		pdf_dict_put(dict, PDF_NAME(DecodeParms), dp);
 
 	pdf_drop_obj(ahx);
 	pdf_drop_obj(nullobj);
@@ -1571,7 +1728,7 @@ static void copystream(pdf_document *doc, pdf_write_options *opts, pdf_obj *obj_
 		addhexfilter(doc, obj);
 
 		newlen = pdf_new_int(doc, buf->len);
-		pdf_dict_puts(obj, "Length", newlen);
+		pdf_dict_put(obj, PDF_NAME(Length), newlen);
 		pdf_drop_obj(newlen);
 	}
 
@@ -1600,8 +1757,8 @@ static void expandstream(pdf_document *doc, pdf_write_options *opts, pdf_obj *ob
 		(*opts->errors)++;
 
 	obj = pdf_copy_dict(obj_orig);
-	pdf_dict_dels(obj, "Filter");
-	pdf_dict_dels(obj, "DecodeParms");
+	pdf_dict_del(obj, PDF_NAME(Filter));
+	pdf_dict_del(obj, PDF_NAME(DecodeParms));
 
 	if (opts->do_ascii && isbinarystream(buf))
 	{
@@ -1613,7 +1770,7 @@ static void expandstream(pdf_document *doc, pdf_write_options *opts, pdf_obj *ob
 	}
 
 	newlen = pdf_new_int(doc, buf->len);
-	pdf_dict_puts(obj, "Length", newlen);
+	pdf_dict_put(obj, PDF_NAME(Length), newlen);
 	pdf_drop_obj(newlen);
 
 	fprintf(opts->out, "%d %d obj\n", num, gen);
@@ -1683,14 +1840,14 @@ static void writeobject(pdf_document *doc, pdf_write_options *opts, int num, int
 	/* skip ObjStm and XRef objects */
 	if (pdf_is_dict(obj))
 	{
-		type = pdf_dict_gets(obj, "Type");
-		if (pdf_is_name(type) && !strcmp(pdf_to_name(type), "ObjStm"))
+		type = pdf_dict_get(obj, PDF_NAME(Type));
+		if (pdf_is_name(type) && pdf_name_eq(type, PDF_NAME(ObjStm)))
 		{
 			opts->use_list[num] = 0;
 			pdf_drop_obj(obj);
 			return;
 		}
-		if (skip_xrefs && pdf_is_name(type) && !strcmp(pdf_to_name(type), "XRef"))
+		if (skip_xrefs && pdf_is_name(type) && pdf_name_eq(type, PDF_NAME(XRef)))
 		{
 			opts->use_list[num] = 0;
 			pdf_drop_obj(obj);
@@ -1718,26 +1875,26 @@ static void writeobject(pdf_document *doc, pdf_write_options *opts, int num, int
 		{
 			pdf_obj *o;
 
-			if ((o = pdf_dict_gets(obj, "Type"), !strcmp(pdf_to_name(o), "XObject")) &&
-				(o = pdf_dict_gets(obj, "Subtype"), !strcmp(pdf_to_name(o), "Image")))
+			if ((o = pdf_dict_get(obj, PDF_NAME(Type)), pdf_name_eq(o, PDF_NAME(XObject))) &&
+				(o = pdf_dict_get(obj, PDF_NAME(Subtype)), pdf_name_eq(o, PDF_NAME(Image))))
 				dontexpand = !(opts->do_expand & fz_expand_images);
-			if (o = pdf_dict_gets(obj, "Type"), !strcmp(pdf_to_name(o), "Font"))
+			if (o = pdf_dict_get(obj, PDF_NAME(Type)), pdf_name_eq(o, PDF_NAME(Font)))
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (o = pdf_dict_gets(obj, "Type"), !strcmp(pdf_to_name(o), "FontDescriptor"))
+			if (o = pdf_dict_get(obj, PDF_NAME(Type)), pdf_name_eq(o, PDF_NAME(FontDescriptor)))
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (pdf_dict_gets(obj, "Length1") != NULL)
+			if (pdf_dict_get(obj, PDF_NAME(Length1)) != NULL)
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (pdf_dict_gets(obj, "Length2") != NULL)
+			if (pdf_dict_get(obj, PDF_NAME(Length2)) != NULL)
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (pdf_dict_gets(obj, "Length3") != NULL)
+			if (pdf_dict_get(obj, PDF_NAME(Length3)) != NULL)
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (o = pdf_dict_gets(obj, "Subtype"), !strcmp(pdf_to_name(o), "Type1C"))
+			if (o = pdf_dict_get(obj, PDF_NAME(Subtype)), pdf_name_eq(o, PDF_NAME(Type1C)))
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (o = pdf_dict_gets(obj, "Subtype"), !strcmp(pdf_to_name(o), "CIDFontType0C"))
+			if (o = pdf_dict_get(obj, PDF_NAME(Subtype)), pdf_name_eq(o, PDF_NAME(CIDFontType0C)))
 				dontexpand = !(opts->do_expand & fz_expand_fonts);
-			if (o = pdf_dict_gets(obj, "Filter"), filter_implies_image(doc, o))
+			if (o = pdf_dict_get(obj, PDF_NAME(Filter)), filter_implies_image(doc, o))
 				dontexpand = !(opts->do_expand & fz_expand_images);
-			if (pdf_dict_gets(obj, "Width") != NULL && pdf_dict_gets(obj, "Height") != NULL)
+			if (pdf_dict_get(obj, PDF_NAME(Width)) != NULL && pdf_dict_get(obj, PDF_NAME(Height)) != NULL)
 				dontexpand = !(opts->do_expand & fz_expand_images);
 		}
 		fz_try(ctx)
@@ -1768,6 +1925,345 @@ static void writeobject(pdf_document *doc, pdf_write_options *opts, int num, int
 	pdf_drop_obj(obj);
 }
 
+/*
+ * SumatraPDF: Pack objects into compressed object streams
+ *
+ * All objects which may live in an object stream (i.e. no streams, no
+ * objects with a non-zero generation number and not the encryption
+ * dictionary) are collected into object streams of up to
+ * OBJSTM_MAX_OBJECTS objects each. Object streams are independent of each
+ * other, so they're all deflated (on background threads where available)
+ * before any object is written.
+ */
+
+#define OBJSTM_MAX_OBJECTS 100
+#define OBJSTM_MAX_THREADS 8
+
+struct objstm_s
+{
+	int num;
+	int count;
+	int first;
+	fz_buffer *data;
+	fz_buffer *out;
+	int err;
+};
+
+static void deflateobjstm(struct objstm_s *stm)
+{
+	uLongf len = stm->out->cap;
+	stm->err = compress(stm->out->data, &len, stm->data->data, stm->data->len);
+	stm->out->len = (int)len;
+}
+
+#if defined(_WIN32) && !defined(_WINRT)
+
+static DWORD WINAPI deflateobjstmsthread(LPVOID arg)
+{
+	pdf_write_options *opts = (pdf_write_options *)arg;
+	long i;
+
+	while ((i = InterlockedIncrement(&opts->next_objstm) - 1) < opts->objstm_count)
+		deflateobjstm(&opts->objstms[i]);
+	return 0;
+}
+
+static void deflateobjstms(pdf_write_options *opts)
+{
+	HANDLE threads[OBJSTM_MAX_THREADS];
+	SYSTEM_INFO si;
+	int i, count = 0;
+
+	GetSystemInfo(&si);
+	opts->next_objstm = 0;
+	/* the calling thread does its share of the work */
+	for (i = 1; i < fz_mini(fz_mini(si.dwNumberOfProcessors, OBJSTM_MAX_THREADS), opts->objstm_count); i++)
+	{
+		threads[count] = CreateThread(NULL, 0, deflateobjstmsthread, opts, 0, NULL);
+		if (!threads[count])
+			break;
+		count++;
+	}
+	deflateobjstmsthread(opts);
+	for (i = 0; i < count; i++)
+	{
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+	}
+}
+
+#else
+
+static void deflateobjstms(pdf_write_options *opts)
+{
+	int i;
+
+	for (i = 0; i < opts->objstm_count; i++)
+		deflateobjstm(&opts->objstms[i]);
+}
+
+#endif
+
+/* SumatraPDF: whether an object is part of an incremental update */
+static int isincremental(pdf_document *doc, pdf_write_options *opts, int num)
+{
+	if (opts->do_appending)
+		return pdf_xref_is_incremental(doc, num);
+	return pdf_xref_is_altered(doc, num);
+}
+
+static int isobjstmobject(pdf_document *doc, pdf_write_options *opts, int num)
+{
+	pdf_xref_entry *entry = pdf_get_xref_entry(doc, num);
+	fz_context *ctx = doc->ctx;
+	pdf_obj *type;
+	int ok = 0;
+
+	if (!opts->use_list[num] || (entry->type != 'n' && entry->type != 'o'))
+		return 0;
+	if (opts->do_incremental && !isincremental(doc, opts, num))
+		return 0;
+	/* objects in object streams implicitly have generation number 0 */
+	if (entry->type == 'n' && entry->gen != 0 && opts->do_garbage < 2)
+		return 0;
+	if (num == pdf_to_num(pdf_dict_get(pdf_trailer(doc), PDF_NAME(Encrypt))))
+		return 0;
+
+	fz_try(ctx)
+	{
+		/* pdf_is_stream makes sure that the object is loaded */
+		if (!pdf_is_stream(doc, num, 0))
+		{
+			/* writeobject skips these */
+			type = pdf_dict_get(pdf_get_xref_entry(doc, num)->obj, PDF_NAME(Type));
+			ok = !pdf_name_eq(type, PDF_NAME(ObjStm)) && !pdf_name_eq(type, PDF_NAME(XRef));
+		}
+	}
+	fz_catch(ctx)
+	{
+		/* leave broken objects to writeobject */
+		ok = 0;
+	}
+	return ok;
+}
+
+static void growwritelists(fz_context *ctx, pdf_write_options *opts, int from, int to)
+{
+	int num;
+
+	opts->use_list = fz_resize_array(ctx, opts->use_list, to + 3, sizeof(int));
+	opts->ofs_list = fz_resize_array(ctx, opts->ofs_list, to + 3, sizeof(int));
+	opts->gen_list = fz_resize_array(ctx, opts->gen_list, to + 3, sizeof(int));
+	opts->renumber_map = fz_resize_array(ctx, opts->renumber_map, to + 3, sizeof(int));
+	opts->rev_renumber_map = fz_resize_array(ctx, opts->rev_renumber_map, to + 3, sizeof(int));
+	opts->rev_gen_list = fz_resize_array(ctx, opts->rev_gen_list, to + 3, sizeof(int));
+
+	for (num = from; num < to + 3; num++)
+	{
+		opts->use_list[num] = 0;
+		opts->ofs_list[num] = 0;
+		opts->gen_list[num] = 0;
+		opts->renumber_map[num] = num;
+		opts->rev_renumber_map[num] = num;
+		opts->rev_gen_list[num] = 0;
+	}
+}
+
+static void packobjstms(pdf_document *doc, pdf_write_options *opts)
+{
+	fz_context *ctx = doc->ctx;
+	int xref_len = pdf_xref_len(doc);
+	int *list = NULL;
+	fz_buffer *head = NULL;
+	int count = 0;
+	int num, i, j;
+
+	fz_var(list);
+	fz_var(head);
+
+	fz_try(ctx)
+	{
+		list = fz_malloc_array(ctx, xref_len, sizeof(int));
+		for (num = 1; num < xref_len; num++)
+			if (isobjstmobject(doc, opts, num))
+				list[count++] = num;
+
+		if (count > 0)
+		{
+			opts->objstm_count = (count + OBJSTM_MAX_OBJECTS - 1) / OBJSTM_MAX_OBJECTS;
+			opts->objstms = fz_calloc(ctx, opts->objstm_count, sizeof(struct objstm_s));
+			for (i = 0; i < opts->objstm_count; i++)
+				opts->objstms[i].num = pdf_create_object(doc);
+
+			growwritelists(ctx, opts, xref_len, pdf_xref_len(doc));
+			opts->objstm_list = fz_calloc(ctx, pdf_xref_len(doc) + 3, sizeof(int));
+			opts->objstm_index = fz_calloc(ctx, pdf_xref_len(doc) + 3, sizeof(int));
+		}
+
+		for (i = 0; i < opts->objstm_count; i++)
+		{
+			struct objstm_s *stm = &opts->objstms[i];
+			int tight = opts->do_expand == 0;
+
+			stm->count = fz_mini(count - i * OBJSTM_MAX_OBJECTS, OBJSTM_MAX_OBJECTS);
+			stm->data = fz_new_buffer(ctx, 1024);
+			head = fz_new_buffer(ctx, stm->count * 12);
+
+			for (j = 0; j < stm->count; j++)
+			{
+				pdf_obj *obj;
+				int n;
+
+				num = list[i * OBJSTM_MAX_OBJECTS + j];
+				opts->objstm_list[num] = stm->num;
+				opts->objstm_index[num] = j;
+				fz_buffer_printf(ctx, head, "%d %d ", num, stm->data->len);
+
+				obj = pdf_get_xref_entry(doc, num)->obj;
+				n = pdf_sprint_obj(NULL, 0, obj, tight);
+				if (stm->data->len + n + 1 > stm->data->cap)
+					fz_resize_buffer(ctx, stm->data, fz_maxi(stm->data->cap * 2, stm->data->len + n + 1));
+				pdf_sprint_obj((char *)stm->data->data + stm->data->len, n + 1, obj, tight);
+				stm->data->len += n;
+				fz_write_buffer_byte(ctx, stm->data, '\n');
+			}
+
+			/* the offsets of all objects precede the objects themselves */
+			stm->first = head->len;
+			fz_write_buffer(ctx, head, stm->data->data, stm->data->len);
+			fz_drop_buffer(ctx, stm->data);
+			stm->data = head;
+			head = NULL;
+
+			stm->out = fz_new_buffer(ctx, compressBound(stm->data->len));
+		}
+
+		deflateobjstms(opts);
+
+		for (i = 0; i < opts->objstm_count; i++)
+			if (opts->objstms[i].err != Z_OK)
+				fz_throw(ctx, FZ_ERROR_GENERIC, "cannot compress object stream (%d 0 R)", opts->objstms[i].num);
+	}
+	fz_always(ctx)
+	{
+		fz_free(ctx, list);
+		fz_drop_buffer(ctx, head);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
+}
+
+static void writeobjstms(pdf_document *doc, pdf_write_options *opts)
+{
+	fz_context *ctx = doc->ctx;
+	pdf_obj *dict = NULL;
+	int i;
+
+	fz_var(dict);
+
+	fz_try(ctx)
+	{
+		for (i = 0; i < opts->objstm_count; i++)
+		{
+			struct objstm_s *stm = &opts->objstms[i];
+
+			dict = pdf_new_dict(doc, 5);
+			pdf_dict_put_drop(dict, PDF_NAME(Type), pdf_new_name(doc, "ObjStm"));
+			pdf_dict_put_drop(dict, PDF_NAME(N), pdf_new_int(doc, stm->count));
+			pdf_dict_put_drop(dict, PDF_NAME(First), pdf_new_int(doc, stm->first));
+			pdf_dict_put_drop(dict, PDF_NAME(Filter), pdf_new_name(doc, "FlateDecode"));
+			pdf_dict_put_drop(dict, PDF_NAME(Length), pdf_new_int(doc, stm->out->len));
+
+			opts->use_list[stm->num] = 1;
+			opts->gen_list[stm->num] = 0;
+			opts->ofs_list[stm->num] = ftell(opts->out);
+
+			fprintf(opts->out, "%d 0 obj\n", stm->num);
+			pdf_fprint_obj(opts->out, dict, opts->do_expand == 0);
+			fprintf(opts->out, "stream\n");
+			fwrite(stm->out->data, 1, stm->out->len, opts->out);
+			fprintf(opts->out, "endstream\nendobj\n\n");
+
+			pdf_drop_obj(dict);
+			dict = NULL;
+		}
+	}
+	fz_catch(ctx)
+	{
+		pdf_drop_obj(dict);
+		fz_rethrow(ctx);
+	}
+}
+
+static void dropobjstms(fz_context *ctx, pdf_write_options *opts)
+{
+	int i;
+
+	for (i = 0; i < opts->objstm_count; i++)
+	{
+		fz_drop_buffer(ctx, opts->objstms[i].data);
+		fz_drop_buffer(ctx, opts->objstms[i].out);
+	}
+	fz_free(ctx, opts->objstms);
+	fz_free(ctx, opts->objstm_list);
+	fz_free(ctx, opts->objstm_index);
+}
+
+/* SumatraPDF: the object streams only exist in the written file, so remove the free
+ * entries pdf_create_object added for them to the incremental xref section (which
+ * would otherwise count as altered for all later saves); pdf_xref_len doesn't shrink,
+ * so their numbers aren't reused by later appended updates */
+static void dropobjstmentries(pdf_document *doc, pdf_write_options *opts)
+{
+	pdf_xref *xref = &doc->xref_sections[0];
+	int i, num;
+
+	for (i = 0; i < opts->objstm_count; i++)
+	{
+		num = opts->objstms[i].num;
+		if (num > 0 && num < xref->len && xref->table[num].type == 'f')
+			memset(&xref->table[num], 0, sizeof(pdf_xref_entry));
+	}
+}
+
+/* SumatraPDF: apply the PNG Up predictor to the xref stream before deflating it */
+static fz_buffer *deflatexrefstream(fz_context *ctx, fz_buffer *buf, int columns)
+{
+	fz_buffer *rows, *out = NULL;
+	uLongf len;
+	int i, j, err;
+
+	rows = fz_new_buffer(ctx, buf->len + buf->len / columns + 1);
+	fz_var(out);
+	fz_try(ctx)
+	{
+		for (i = 0; i + columns <= buf->len; i += columns)
+		{
+			rows->data[rows->len++] = 2;
+			for (j = 0; j < columns; j++)
+				rows->data[rows->len++] = buf->data[i + j] - (i > 0 ? buf->data[i + j - columns] : 0);
+		}
+		out = fz_new_buffer(ctx, compressBound(rows->len));
+		len = out->cap;
+		err = compress(out->data, &len, rows->data, rows->len);
+		if (err != Z_OK)
+			fz_throw(ctx, FZ_ERROR_GENERIC, "cannot compress xref stream");
+		out->len = (int)len;
+	}
+	fz_always(ctx)
+	{
+		fz_drop_buffer(ctx, rows);
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_buffer(ctx, out);
+		fz_rethrow(ctx);
+	}
+	return out;
+}
+
 static void writexrefsubsect(pdf_write_options *opts, int from, int to)
 {
 	int num;
@@ -1799,11 +2295,11 @@ static void writexref(pdf_document *doc, pdf_write_options *opts, int from, int
 
 		while (subfrom < to)
 		{
-			while (subfrom < to && !pdf_xref_is_incremental(doc, subfrom))
+			while (subfrom < to && !isincremental(doc, opts, subfrom))
 				subfrom++;
 
 			subto = subfrom;
-			while (subto < to && pdf_xref_is_incremental(doc, subto))
+			while (subto < to && isincremental(doc, opts, subto))
 				subto++;
 
 			if (subfrom < subto)
@@ -1827,8 +2323,8 @@ static void writexref(pdf_document *doc, pdf_write_options *opts, int from, int
 		if (opts->do_incremental)
 		{
 			trailer = pdf_keep_obj(pdf_trailer(doc));
-			pdf_dict_puts_drop(trailer, "Size", pdf_new_int(doc, pdf_xref_len(doc)));
-			pdf_dict_puts_drop(trailer, "Prev", pdf_new_int(doc, doc->startxref));
+			pdf_dict_put_drop(trailer, PDF_NAME(Size), pdf_new_int(doc, pdf_xref_len(doc)));
+			pdf_dict_put_drop(trailer, PDF_NAME(Prev), pdf_new_int(doc, doc->startxref));
 			doc->startxref = startxref;
 		}
 		else
@@ -1836,28 +2332,28 @@ static void writexref(pdf_document *doc, pdf_write_options *opts, int from, int
 			trailer = pdf_new_dict(doc, 5);
 
 			nobj = pdf_new_int(doc, to);
-			pdf_dict_puts(trailer, "Size", nobj);
+			pdf_dict_put(trailer, PDF_NAME(Size), nobj);
 			pdf_drop_obj(nobj);
 			nobj = NULL;
 
 			if (first)
 			{
-				obj = pdf_dict_gets(pdf_trailer(doc), "Info");
+				obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Info));
 				if (obj)
-					pdf_dict_puts(trailer, "Info", obj);
+					pdf_dict_put(trailer, PDF_NAME(Info), obj);
 
-				obj = pdf_dict_gets(pdf_trailer(doc), "Root");
+				obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
 				if (obj)
-					pdf_dict_puts(trailer, "Root", obj);
+					pdf_dict_put(trailer, PDF_NAME(Root), obj);
 
-				obj = pdf_dict_gets(pdf_trailer(doc), "ID");
+				obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(ID));
 				if (obj)
-					pdf_dict_puts(trailer, "ID", obj);
+					pdf_dict_put(trailer, PDF_NAME(ID), obj);
 			}
 			if (main_xref_offset != 0)
 			{
 				nobj = pdf_new_int(doc, main_xref_offset);
-				pdf_dict_puts(trailer, "Prev", nobj);
+				pdf_dict_put(trailer, PDF_NAME(Prev), nobj);
 				pdf_drop_obj(nobj);
 				nobj = NULL;
 			}
@@ -1891,12 +2387,24 @@ static void writexrefstreamsubsect(pdf_document *doc, pdf_write_options *opts, p
 	pdf_array_push_drop(index, pdf_new_int(doc, to - from));
 	for (num = from; num < to; num++)
 	{
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->use_list[num] ? 1 : 0);
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->ofs_list[num]>>24);
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->ofs_list[num]>>16);
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->ofs_list[num]>>8);
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->ofs_list[num]);
-		fz_write_buffer_byte(doc->ctx, fzbuf, opts->gen_list[num]);
+		int type = opts->use_list[num] ? 1 : 0;
+		int ofs = opts->ofs_list[num];
+		int gen = opts->gen_list[num];
+
+		/* SumatraPDF: packed objects refer to their object stream and index */
+		if (opts->objstm_list && opts->objstm_list[num])
+		{
+			type = 2;
+			ofs = opts->objstm_list[num];
+			gen = opts->objstm_index[num];
+		}
+
+		fz_write_buffer_byte(doc->ctx, fzbuf, type);
+		fz_write_buffer_byte(doc->ctx, fzbuf, ofs>>24);
+		fz_write_buffer_byte(doc->ctx, fzbuf, ofs>>16);
+		fz_write_buffer_byte(doc->ctx, fzbuf, ofs>>8);
+		fz_write_buffer_byte(doc->ctx, fzbuf, ofs);
+		fz_write_buffer_byte(doc->ctx, fzbuf, gen);
 	}
 }
 
@@ -1925,51 +2433,55 @@ static void writexrefstream(pdf_document *doc, pdf_write_options *opts, int from
 
 		if (first)
 		{
-			obj = pdf_dict_gets(pdf_trailer(doc), "Info");
+			obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Info));
 			if (obj)
-				pdf_dict_puts(dict, "Info", obj);
+				pdf_dict_put(dict, PDF_NAME(Info), obj);
 
-			obj = pdf_dict_gets(pdf_trailer(doc), "Root");
+			obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
 			if (obj)
-				pdf_dict_puts(dict, "Root", obj);
+				pdf_dict_put(dict, PDF_NAME(Root), obj);
 
-			obj = pdf_dict_gets(pdf_trailer(doc), "ID");
+			obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(ID));
 			if (obj)
-				pdf_dict_puts(dict, "ID", obj);
+				pdf_dict_put(dict, PDF_NAME(ID), obj);
 
 			if (opts->do_incremental)
 			{
-				obj = pdf_dict_gets(pdf_trailer(doc), "Encrypt");
+				obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Encrypt));
 				if (obj)
-					pdf_dict_puts(dict, "Encrypt", obj);
+					pdf_dict_put(dict, PDF_NAME(Encrypt), obj);
 			}
 		}
 
-		pdf_dict_puts_drop(dict, "Size", pdf_new_int(doc, to));
+		pdf_dict_put_drop(dict, PDF_NAME(Size), pdf_new_int(doc, to));
 
 		if (opts->do_incremental)
 		{
-			pdf_dict_puts_drop(dict, "Prev", pdf_new_int(doc, doc->startxref));
+			pdf_dict_put_drop(dict, PDF_NAME(Prev), pdf_new_int(doc, doc->startxref));
 			doc->startxref = startxref;
 		}
 		else
 		{
 			if (main_xref_offset != 0)
-				pdf_dict_puts_drop(dict, "Prev", pdf_new_int(doc, main_xref_offset));
+				pdf_dict_put_drop(dict, PDF_NAME(Prev), pdf_new_int(doc, main_xref_offset));
 		}
 
-		pdf_dict_puts_drop(dict, "Type", pdf_new_name(doc, "XRef"));
+		pdf_dict_put_drop(dict, PDF_NAME(Type), pdf_new_name(doc, "XRef"));
 
 		w = pdf_new_array(doc, 3);
-		pdf_dict_puts(dict, "W", w);
+		pdf_dict_put(dict, PDF_NAME(W), w);
 		pdf_array_push_drop(w, pdf_new_int(doc, 1));
 		pdf_array_push_drop(w, pdf_new_int(doc, 4));
 		pdf_array_push_drop(w, pdf_new_int(doc, 1));
 
 		index = pdf_new_array(doc, 2);
-		pdf_dict_puts_drop(dict, "Index", index);
+		pdf_dict_put_drop(dict, PDF_NAME(Index), index);
 
 		opts->ofs_list[num] = opts->first_xref_entry_offset;
+		opts->use_list[num] = 1;
+		opts->gen_list[num] = 0;
+		opts->rev_renumber_map[num] = num;
+		opts->rev_gen_list[num] = 0;
 
 		fzbuf = fz_new_buffer(ctx, 4*(to-from));
 
@@ -1980,11 +2492,11 @@ static void writexrefstream(pdf_document *doc, pdf_write_options *opts, int from
 
 			while (subfrom < to)
 			{
-				while (subfrom < to && !pdf_xref_is_incremental(doc, subfrom))
+				while (subfrom < to && !isincremental(doc, opts, subfrom))
 					subfrom++;
 
 				subto = subfrom;
-				while (subto < to && pdf_xref_is_incremental(doc, subto))
+				while (subto < to && isincremental(doc, opts, subto))
 					subto++;
 
 				if (subfrom < subto)
@@ -1998,11 +2510,27 @@ static void writexrefstream(pdf_document *doc, pdf_write_options *opts, int from
 			writexrefstreamsubsect(doc, opts, index, fzbuf, from, to);
 		}
 
+		/* SumatraPDF: compress the xref stream along with the object streams
+		 * (unless streams are being expanded, as writeobject would expand the
+		 * xref stream without decompressing it, since its data is in stm_buf) */
+		if (opts->do_objstms && !opts->do_expand)
+		{
+			fz_buffer *zbuf = deflatexrefstream(ctx, fzbuf, 6);
+			fz_drop_buffer(ctx, fzbuf);
+			fzbuf = zbuf;
+			pdf_dict_put_drop(dict, PDF_NAME(Filter), pdf_new_name(doc, "FlateDecode"));
+			obj = pdf_new_dict(doc, 2);
+			pdf_dict_put_drop(dict, PDF_NAME(DecodeParms), obj);
+			pdf_dict_put_drop(obj, PDF_NAME(Predictor), pdf_new_int(doc, 12));
+			pdf_dict_put_drop(obj, PDF_NAME(Columns), pdf_new_int(doc, 6));
+		}
+
 		pdf_update_stream(doc, num, fzbuf);
-		pdf_dict_puts_drop(dict, "Length", pdf_new_int(doc, fz_buffer_storage(ctx, fzbuf, NULL)));
+		pdf_dict_put_drop(dict, PDF_NAME(Length), pdf_new_int(doc, fz_buffer_storage(ctx, fzbuf, NULL)));
 
 		writeobject(doc, opts, num, 0, 0);
 		fprintf(opts->out, "startxref\n%d\n%%%%EOF\n", startxref);
+		doc->has_xref_streams = 1;
 	}
 	fz_always(ctx)
 	{
@@ -2051,12 +2579,16 @@ dowriteobject(pdf_document *doc, pdf_write_options *opts, int num, int pass)
 	if (opts->do_garbage && !opts->use_list[num])
 		return;
 
+	/* SumatraPDF: packed objects are written as part of their object stream */
+	if (opts->objstm_list && opts->objstm_list[num])
+		return;
+
 	if (entry->type == 'n' || entry->type == 'o')
 	{
 		if (pass > 0)
 			padto(opts->out, opts->ofs_list[num]);
 		opts->ofs_list[num] = ftell(opts->out);
-		if (!opts->do_incremental || pdf_xref_is_incremental(doc, num))
+		if (!opts->do_incremental || isincremental(doc, opts, num))
 			writeobject(doc, opts, num, opts->gen_list[num], 1);
 	}
 	else
@@ -2607,6 +3139,12 @@ void pdf_write_document(pdf_document *doc, char *filename, fz_write_options *fz_
 		opts.do_ascii = fz_opts->do_ascii;
 		opts.do_linear = fz_opts->do_linear;
 		opts.do_clean = fz_opts->do_clean;
+		/* SumatraPDF: object streams require PDF 1.5, aren't supported for
+		 * linearized files and can't hold unsaved signatures (which are
+		 * completed in place) or objects to be encrypted (which we don't do) */
+		opts.do_objstms = fz_opts->do_objstms && !opts.do_linear && !opts.do_ascii && !doc->unsaved_sigs &&
+			!(opts.do_incremental && (doc->crypt || doc->version < 15));
+		opts.do_appending = fz_opts->do_incremental && fz_opts->do_appending;
 		opts.start = 0;
 		opts.main_xref_offset = INT_MIN;
 		/* We deliberately make these arrays long enough to cope with
@@ -2663,7 +3201,18 @@ void pdf_write_document(pdf_document *doc, char *filename, fz_write_options *fz_
 			linearize(doc, &opts);
 		}
 
+		if (opts.do_objstms)
+		{
+			packobjstms(doc, &opts);
+			if (opts.objstm_count > 0)
+				xref_len = pdf_xref_len(doc);
+			if (!opts.do_incremental && doc->version < 15)
+				doc->version = 15;
+		}
+
 		writeobjects(doc, &opts, 0);
+		if (opts.objstm_count > 0)
+			writeobjstms(doc, &opts);
 
 #ifdef DEBUG_WRITING
 		dump_object_details(doc, &opts);
@@ -2673,7 +3222,7 @@ void pdf_write_document(pdf_document *doc, char *filename, fz_write_options *fz_
 		{
 			for (num = 0; num < xref_len; num++)
 			{
-				if (!opts.use_list[num] && pdf_xref_is_incremental(doc, num))
+				if (!opts.use_list[num] && isincremental(doc, &opts, num))
 				{
 					/* Make unreusable. FIXME: would be better to link to existing free list */
 					opts.gen_list[num] = 65535;
@@ -2715,7 +3264,7 @@ void pdf_write_document(pdf_document *doc, char *filename, fz_write_options *fz_
 		else
 		{
 			opts.first_xref_offset = ftell(opts.out);
-			if (opts.do_incremental && doc->has_xref_streams)
+			if (opts.do_incremental ? doc->has_xref_streams || opts.objstm_count > 0 : opts.do_objstms)
 				writexrefstream(doc, &opts, 0, xref_len, 1, 0, opts.first_xref_offset);
 			else
 				writexref(doc, &opts, 0, xref_len, 1, 0, opts.first_xref_offset);
@@ -2749,6 +3298,9 @@ void pdf_write_document(pdf_document *doc, char *filename, fz_write_options *fz_
 		pdf_drop_obj(opts.hints_s);
 		pdf_drop_obj(opts.hints_length);
 		page_objects_list_destroy(ctx, opts.page_object_lists);
+		if (opts.objstms)
+			dropobjstmentries(doc, &opts);
+		dropobjstms(ctx, &opts);
 		if (opts.out)
 			fclose(opts.out);
 		doc->freeze_updates = 0;
@@ -2787,10 +3339,10 @@ make_page_tree_node(pdf_document *doc, int l, int r, pdf_obj *parent_ref, int ro
 	fz_try(ctx)
 	{
 		me = pdf_new_dict(doc, 2);
-		pdf_dict_puts_drop(me, "Type", pdf_new_name(doc, "Pages"));
-		pdf_dict_puts_drop(me, "Count", pdf_new_int(doc, r-l));
+		pdf_dict_put_drop(me, PDF_NAME(Type), pdf_new_name(doc, "Pages"));
+		pdf_dict_put_drop(me, PDF_NAME(Count), pdf_new_int(doc, r-l));
 		if (!root)
-			pdf_dict_puts(me, "Parent", parent_ref);
+			pdf_dict_put(me, PDF_NAME(Parent), parent_ref);
 		a = pdf_new_array(doc, KIDS_PER_LEVEL);
 		me_ref = pdf_new_ref(doc, me);
 
@@ -2799,7 +3351,7 @@ make_page_tree_node(pdf_document *doc, int l, int r, pdf_obj *parent_ref, int ro
 			if (spaces >= r-l)
 			{
 				o = pdf_keep_obj(doc->page_refs[l++]);
-				pdf_dict_puts(o, "Parent", me_ref);
+				pdf_dict_put(o, PDF_NAME(Parent), me_ref);
 			}
 			else
 			{
@@ -2813,7 +3365,7 @@ make_page_tree_node(pdf_document *doc, int l, int r, pdf_obj *parent_ref, int ro
 			pdf_drop_obj(o);
 			o = NULL;
 		}
-		pdf_dict_puts_drop(me, "Kids", a);
+		pdf_dict_put_drop(me, PDF_NAME(Kids), a);
 		a = NULL;
 	}
 	fz_always(ctx)
@@ -2839,9 +3391,9 @@ pdf_rebalance_page_tree(pdf_document *doc)
 	if (!doc || !doc->needs_page_tree_rebuild)
 		return;
 
-	catalog = pdf_dict_gets(pdf_trailer(doc), "Root");
+	catalog = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
 	pages = make_page_tree_node(doc, 0, doc->page_len, catalog, 1);
-	pdf_dict_puts_drop(catalog, "Pages", pages);
+	pdf_dict_put_drop(catalog, PDF_NAME(Pages), pages);
 
 	doc->needs_page_tree_rebuild = 0;
 }
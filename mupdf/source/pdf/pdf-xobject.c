@@ -58,10 +58,10 @@ pdf_load_xobject(pdf_document *doc, pdf_obj *dict)
 
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(dict, "BBox");
+		obj = pdf_dict_get(dict, PDF_NAME(BBox));
 		pdf_to_rect(ctx, obj, &form->bbox);
 
-		obj = pdf_dict_gets(dict, "Matrix");
+		obj = pdf_dict_get(dict, PDF_NAME(Matrix));
 		if (obj)
 			pdf_to_matrix(ctx, obj, &form->matrix);
 		else
@@ -71,19 +71,19 @@ pdf_load_xobject(pdf_document *doc, pdf_obj *dict)
 		form->knockout = 0;
 		form->transparency = 0;
 
-		obj = pdf_dict_gets(dict, "Group");
+		obj = pdf_dict_get(dict, PDF_NAME(Group));
 		if (obj)
 		{
 			pdf_obj *attrs = obj;
 
-			form->isolated = pdf_to_bool(pdf_dict_gets(attrs, "I"));
-			form->knockout = pdf_to_bool(pdf_dict_gets(attrs, "K"));
+			form->isolated = pdf_to_bool(pdf_dict_get(attrs, PDF_NAME(I)));
+			form->knockout = pdf_to_bool(pdf_dict_get(attrs, PDF_NAME(K)));
 
-			obj = pdf_dict_gets(attrs, "S");
-			if (pdf_is_name(obj) && !strcmp(pdf_to_name(obj), "Transparency"))
+			obj = pdf_dict_get(attrs, PDF_NAME(S));
+			if (pdf_is_name(obj) && pdf_name_eq(obj, PDF_NAME(Transparency)))
 				form->transparency = 1;
 
-			obj = pdf_dict_gets(attrs, "CS");
+			obj = pdf_dict_get(attrs, PDF_NAME(CS));
 			if (obj)
 			{
 				fz_try(ctx)
@@ -97,7 +97,7 @@ pdf_load_xobject(pdf_document *doc, pdf_obj *dict)
 			}
 		}
 
-		form->resources = pdf_dict_gets(dict, "Resources");
+		form->resources = pdf_dict_get(dict, PDF_NAME(Resources));
 		if (form->resources)
 			pdf_keep_obj(form->resources);
 
@@ -137,22 +137,22 @@ pdf_new_xobject(pdf_document *doc, const fz_rect *bbox, const fz_matrix *mat)
 		dict = pdf_new_dict(doc, 0);
 
 		obj = pdf_new_rect(doc, bbox);
-		pdf_dict_puts(dict, "BBox", obj);
+		pdf_dict_put(dict, PDF_NAME(BBox), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
 		obj = pdf_new_int(doc, 1);
-		pdf_dict_puts(dict, "FormType", obj);
+		pdf_dict_put(dict, PDF_NAME(FormType), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
 		obj = pdf_new_int(doc, 0);
-		pdf_dict_puts(dict, "Length", obj);
+		pdf_dict_put(dict, PDF_NAME(Length), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
 		obj = pdf_new_matrix(doc, mat);
-		pdf_dict_puts(dict, "Matrix", obj);
+		pdf_dict_put(dict, PDF_NAME(Matrix), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
@@ -166,18 +166,18 @@ pdf_new_xobject(pdf_document *doc, const fz_rect *bbox, const fz_matrix *mat)
 		pdf_array_push(procset, obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
-		pdf_dict_puts(res, "ProcSet", procset);
+		pdf_dict_put(res, PDF_NAME(ProcSet), procset);
 		pdf_drop_obj(procset);
 		procset = NULL;
-		pdf_dict_puts(dict, "Resources", res);
+		pdf_dict_put(dict, PDF_NAME(Resources), res);
 
 		obj = pdf_new_name(doc, "Form");
-		pdf_dict_puts(dict, "Subtype", obj);
+		pdf_dict_put(dict, PDF_NAME(Subtype), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
 		obj = pdf_new_name(doc, "XObject");
-		pdf_dict_puts(dict, "Type", obj);
+		pdf_dict_put(dict, PDF_NAME(Type), obj);
 		pdf_drop_obj(obj);
 		obj = NULL;
 
@@ -230,8 +230,8 @@ pdf_new_xobject(pdf_document *doc, const fz_rect *bbox, const fz_matrix *mat)
 
 void pdf_update_xobject_contents(pdf_document *doc, pdf_xobject *form, fz_buffer *buffer)
 {
-	pdf_dict_dels(form->contents, "Filter");
-	pdf_dict_puts_drop(form->contents, "Length", pdf_new_int(doc, buffer->len));
+	pdf_dict_del(form->contents, PDF_NAME(Filter));
+	pdf_dict_put_drop(form->contents, PDF_NAME(Length), pdf_new_int(doc, buffer->len));
 	pdf_update_stream(doc, pdf_to_num(form->contents), buffer);
 	form->iteration ++;
 }
@@ -48,6 +48,7 @@ static void pdf_free_xref_sections(pdf_document *doc)
 	fz_free(ctx, doc->xref_sections);
 	doc->xref_sections = NULL;
 	doc->num_xref_sections = 0;
+	doc->num_incremental_sections = 0;
 }
 
 static void pdf_resize_xref(fz_context *ctx, pdf_xref *xref, int newlen)
@@ -194,6 +195,7 @@ static void ensure_incremental_xref(pdf_document *doc)
 			xref->trailer = trailer;
 			xref->pre_repair_trailer = NULL;
 			doc->num_xref_sections++;
+			doc->num_incremental_sections++;
 			doc->xref_altered = 1;
 		}
 		fz_catch(ctx)
@@ -228,6 +230,24 @@ int pdf_xref_is_incremental(pdf_document *doc, int num)
 	return doc->xref_altered && num < xref->len && xref->table[num].type;
 }
 
+void pdf_xref_end_incremental_section(pdf_document *doc)
+{
+	doc->xref_altered = 0;
+}
+
+int pdf_xref_is_altered(pdf_document *doc, int num)
+{
+	int i;
+
+	for (i = 0; i < doc->num_incremental_sections; i++)
+	{
+		pdf_xref *xref = &doc->xref_sections[i];
+		if (num < xref->len && xref->table[num].type)
+			return 1;
+	}
+	return 0;
+}
+
 /* Ensure that an object has been cloned into the incremental xref section */
 void pdf_xref_ensure_incremental_object(pdf_document *doc, int num)
 {
@@ -277,6 +297,7 @@ void pdf_replace_xref(pdf_document *doc, pdf_xref_entry *entries, int n)
 
 		doc->xref_sections = xref;
 		doc->num_xref_sections = 1;
+		doc->num_incremental_sections = doc->xref_altered;
 	}
 	fz_catch(ctx)
 	{
@@ -400,7 +421,7 @@ pdf_xref_size_from_old_trailer(pdf_document *doc, pdf_lexbuf *buf)
 
 		trailer = pdf_parse_dict(doc, doc->file, buf);
 
-		size = pdf_to_int(pdf_dict_gets(trailer, "Size"));
+		size = pdf_to_int(pdf_dict_get(trailer, PDF_NAME(Size)));
 		if (!size)
 			fz_throw(doc->ctx, FZ_ERROR_GENERIC, "trailer missing Size entry");
 	}
@@ -593,7 +614,7 @@ pdf_read_new_xref(pdf_document *doc, pdf_lexbuf *buf)
 
 	fz_try(ctx)
 	{
-		obj = pdf_dict_gets(trailer, "Size");
+		obj = pdf_dict_get(trailer, PDF_NAME(Size));
 		if (!obj)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "xref stream missing Size entry (%d %d R)", num, gen);
 
@@ -602,7 +623,7 @@ pdf_read_new_xref(pdf_document *doc, pdf_lexbuf *buf)
 		if (size > 0)
 			(void)pdf_get_populating_xref_entry(doc, size-1);
 
-		obj = pdf_dict_gets(trailer, "W");
+		obj = pdf_dict_get(trailer, PDF_NAME(W));
 		if (!obj)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "xref stream missing W entry (%d %d R)", num, gen);
 		w0 = pdf_to_int(pdf_array_get(obj, 0));
@@ -620,7 +641,7 @@ pdf_read_new_xref(pdf_document *doc, pdf_lexbuf *buf)
 		w1 = w1 < 0 ? 0 : w1;
 		w2 = w2 < 0 ? 0 : w2;
 
-		index = pdf_dict_gets(trailer, "Index");
+		index = pdf_dict_get(trailer, PDF_NAME(Index));
 
 		stm = pdf_open_stream_with_offset(doc, num, gen, trailer, stm_ofs);
 
@@ -727,7 +748,7 @@ read_xref_section(pdf_document *doc, int ofs, pdf_lexbuf *buf, ofs_list *offsets
 
 		/* FIXME: do we overwrite free entries properly? */
 		/* FIXME: Does this work properly with progression? */
-		xrefstmofs = pdf_to_int(pdf_dict_gets(trailer, "XRefStm"));
+		xrefstmofs = pdf_to_int(pdf_dict_get(trailer, PDF_NAME(XRefStm)));
 		if (xrefstmofs)
 		{
 			if (xrefstmofs < 0)
@@ -741,7 +762,7 @@ read_xref_section(pdf_document *doc, int ofs, pdf_lexbuf *buf, ofs_list *offsets
 			pdf_drop_obj(pdf_read_xref(doc, xrefstmofs, buf));
 		}
 
-		prevofs = pdf_to_int(pdf_dict_gets(trailer, "Prev"));
+		prevofs = pdf_to_int(pdf_dict_get(trailer, PDF_NAME(Prev)));
 		if (prevofs < 0)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "negative xref stream offset for previous xref stream");
 	}
@@ -857,27 +878,27 @@ pdf_load_linear(pdf_document *doc)
 		dict = pdf_parse_ind_obj(doc, doc->file, &doc->lexbuf.base, &num, &gen, &stmofs, NULL);
 		if (!pdf_is_dict(dict))
 			fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to read linearized dictionary");
-		o = pdf_dict_gets(dict, "Linearized");
+		o = pdf_dict_get(dict, PDF_NAME(Linearized));
 		if (o == NULL)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to read linearized dictionary");
 		lin = pdf_to_int(o);
 		if (lin != 1)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "Unexpected version of Linearized tag (%d)", lin);
-		len = pdf_to_int(pdf_dict_gets(dict, "L"));
+		len = pdf_to_int(pdf_dict_get(dict, PDF_NAME(L)));
 		if (len != doc->file_length)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "File has been updated since linearization");
 
 		pdf_read_xref_sections(doc, fz_tell(doc->file), &doc->lexbuf.base, 0);
 
-		doc->page_count = pdf_to_int(pdf_dict_gets(dict, "N"));
+		doc->page_count = pdf_to_int(pdf_dict_get(dict, PDF_NAME(N)));
 		doc->linear_page_refs = fz_resize_array(ctx, doc->linear_page_refs, doc->page_count, sizeof(pdf_obj *));
 		memset(doc->linear_page_refs, 0, doc->page_count * sizeof(pdf_obj*));
 		doc->linear_obj = dict;
 		doc->linear_pos = fz_tell(doc->file);
-		doc->linear_page1_obj_num = pdf_to_int(pdf_dict_gets(dict, "O"));
+		doc->linear_page1_obj_num = pdf_to_int(pdf_dict_get(dict, PDF_NAME(O)));
 		doc->linear_page_refs[0] = pdf_new_indirect(doc, doc->linear_page1_obj_num, 0);
 		doc->linear_page_num = 0;
-		hint = pdf_dict_gets(dict, "H");
+		hint = pdf_dict_get(dict, PDF_NAME(H));
 		doc->hint_object_offset = pdf_to_int(pdf_array_get(hint, 0));
 		doc->hint_object_length = pdf_to_int(pdf_array_get(hint, 1));
 
@@ -901,7 +922,7 @@ pdf_ocg_set_config(pdf_document *doc, int config)
 	pdf_obj *obj, *cobj;
 	char *name;
 
-	obj = pdf_dict_gets(pdf_dict_gets(pdf_trailer(doc), "Root"), "OCProperties");
+	obj = pdf_dict_get(pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)), PDF_NAME(OCProperties));
 	if (!obj)
 	{
 		if (config == 0)
@@ -911,24 +932,24 @@ pdf_ocg_set_config(pdf_document *doc, int config)
 	}
 	if (config == 0)
 	{
-		cobj = pdf_dict_gets(obj, "D");
+		cobj = pdf_dict_get(obj, PDF_NAME(D));
 		if (!cobj)
 			fz_throw(doc->ctx, FZ_ERROR_GENERIC, "No default OCG config");
 	}
 	else
 	{
-		cobj = pdf_array_get(pdf_dict_gets(obj, "Configs"), config);
+		cobj = pdf_array_get(pdf_dict_get(obj, PDF_NAME(Configs)), config);
 		if (!cobj)
 			fz_throw(doc->ctx, FZ_ERROR_GENERIC, "Illegal OCG config");
 	}
 
 	pdf_drop_obj(desc->intent);
-	desc->intent = pdf_dict_gets(cobj, "Intent");
+	desc->intent = pdf_dict_get(cobj, PDF_NAME(Intent));
 	if (desc->intent)
 		pdf_keep_obj(desc->intent);
 
 	len = desc->len;
-	name = pdf_to_name(pdf_dict_gets(cobj, "BaseState"));
+	name = pdf_to_name(pdf_dict_get(cobj, PDF_NAME(BaseState)));
 	if (strcmp(name, "Unchanged") == 0)
 	{
 		/* Do nothing */
@@ -948,7 +969,7 @@ pdf_ocg_set_config(pdf_document *doc, int config)
 		}
 	}
 
-	obj = pdf_dict_gets(cobj, "ON");
+	obj = pdf_dict_get(cobj, PDF_NAME(ON));
 	len2 = pdf_array_len(obj);
 	for (i = 0; i < len2; i++)
 	{
@@ -965,7 +986,7 @@ pdf_ocg_set_config(pdf_document *doc, int config)
 		}
 	}
 
-	obj = pdf_dict_gets(cobj, "OFF");
+	obj = pdf_dict_get(cobj, PDF_NAME(OFF));
 	len2 = pdf_array_len(obj);
 	for (i = 0; i < len2; i++)
 	{
@@ -1007,10 +1028,10 @@ pdf_read_ocg(pdf_document *doc)
 
 	fz_var(desc);
 
-	obj = pdf_dict_gets(pdf_dict_gets(pdf_trailer(doc), "Root"), "OCProperties");
+	obj = pdf_dict_get(pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)), PDF_NAME(OCProperties));
 	if (!obj)
 		return;
-	ocg = pdf_dict_gets(obj, "OCGs");
+	ocg = pdf_dict_get(obj, PDF_NAME(OCGs));
 	if (!ocg || !pdf_is_array(ocg))
 		/* Not ever supposed to happen, but live with it. */
 		return;
@@ -1108,8 +1129,8 @@ pdf_init_document(pdf_document *doc)
 		if (repaired)
 			pdf_repair_xref(doc, &doc->lexbuf.base);
 
-		encrypt = pdf_dict_gets(pdf_trailer(doc), "Encrypt");
-		id = pdf_dict_gets(pdf_trailer(doc), "ID");
+		encrypt = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Encrypt));
+		id = pdf_dict_get(pdf_trailer(doc), PDF_NAME(ID));
 		if (pdf_is_dict(encrypt))
 			doc->crypt = pdf_new_crypt(ctx, encrypt, id);
 
@@ -1121,8 +1142,8 @@ pdf_init_document(pdf_document *doc)
 			int xref_len = pdf_xref_len(doc);
 			pdf_repair_obj_stms(doc);
 
-			hasroot = (pdf_dict_gets(pdf_trailer(doc), "Root") != NULL);
-			hasinfo = (pdf_dict_gets(pdf_trailer(doc), "Info") != NULL);
+			hasroot = (pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root)) != NULL);
+			hasinfo = (pdf_dict_get(pdf_trailer(doc), PDF_NAME(Info)) != NULL);
 
 			for (i = 1; i < xref_len; i++)
 			{
@@ -1143,11 +1164,11 @@ pdf_init_document(pdf_document *doc)
 
 				if (!hasroot)
 				{
-					obj = pdf_dict_gets(dict, "Type");
-					if (pdf_is_name(obj) && !strcmp(pdf_to_name(obj), "Catalog"))
+					obj = pdf_dict_get(dict, PDF_NAME(Type));
+					if (pdf_is_name(obj) && pdf_name_eq(obj, PDF_NAME(Catalog)))
 					{
 						nobj = pdf_new_indirect(doc, i, 0);
-						pdf_dict_puts(pdf_trailer(doc), "Root", nobj);
+						pdf_dict_put(pdf_trailer(doc), PDF_NAME(Root), nobj);
 						pdf_drop_obj(nobj);
 						nobj = NULL;
 					}
@@ -1155,10 +1176,10 @@ pdf_init_document(pdf_document *doc)
 
 				if (!hasinfo)
 				{
-					if (pdf_dict_gets(dict, "Creator") || pdf_dict_gets(dict, "Producer"))
+					if (pdf_dict_get(dict, PDF_NAME(Creator)) || pdf_dict_get(dict, PDF_NAME(Producer)))
 					{
 						nobj = pdf_new_indirect(doc, i, 0);
-						pdf_dict_puts(pdf_trailer(doc), "Info", nobj);
+						pdf_dict_put(pdf_trailer(doc), PDF_NAME(Info), nobj);
 						pdf_drop_obj(nobj);
 						nobj = NULL;
 					}
@@ -1219,6 +1240,8 @@ pdf_close_document(pdf_document *doc)
 	if (doc->js)
 		doc->drop_js(doc->js);
 
+	/* SumatraPDF: page tree index */
+	pdf_drop_page_tree(doc);
 	pdf_free_xref_sections(doc);
 
 	if (doc->focus_obj)
@@ -1288,8 +1311,9 @@ pdf_print_xref(pdf_document *doc)
  * compressed object streams
  */
 
+/* SumatraPDF: data may hold the already decoded stream (cf. pdf_finish_obj_stm_job) */
 static void
-pdf_load_obj_stm(pdf_document *doc, int num, int gen, pdf_lexbuf *buf)
+pdf_load_obj_stm(pdf_document *doc, int num, int gen, pdf_lexbuf *buf, fz_buffer *data)
 {
 	fz_stream *stm = NULL;
 	pdf_obj *objstm = NULL;
@@ -1312,8 +1336,8 @@ pdf_load_obj_stm(pdf_document *doc, int num, int gen, pdf_lexbuf *buf)
 	{
 		objstm = pdf_load_object(doc, num, gen);
 
-		count = pdf_to_int(pdf_dict_gets(objstm, "N"));
-		first = pdf_to_int(pdf_dict_gets(objstm, "First"));
+		count = pdf_to_int(pdf_dict_get(objstm, PDF_NAME(N)));
+		first = pdf_to_int(pdf_dict_get(objstm, PDF_NAME(First)));
 
 		if (count < 0)
 			fz_throw(ctx, FZ_ERROR_GENERIC, "negative number of objects in object stream");
@@ -1323,7 +1347,10 @@ pdf_load_obj_stm(pdf_document *doc, int num, int gen, pdf_lexbuf *buf)
 		numbuf = fz_calloc(ctx, count, sizeof(int));
 		ofsbuf = fz_calloc(ctx, count, sizeof(int));
 
-		stm = pdf_open_stream(doc, num, gen);
+		if (data)
+			stm = fz_open_buffer(ctx, data);
+		else
+			stm = pdf_open_stream(doc, num, gen);
 		for (i = 0; i < count; i++)
 		{
 			tok = pdf_lex(stm, buf);
@@ -1391,6 +1418,180 @@ pdf_load_obj_stm(pdf_document *doc, int num, int gen, pdf_lexbuf *buf)
 	}
 }
 
+/* SumatraPDF: decode object streams ahead of time (and on several threads) */
+pdf_obj_stm_job *
+pdf_new_obj_stm_jobs(pdf_document *doc, int max_raw_len, int *count)
+{
+	fz_context *ctx = doc->ctx;
+	pdf_obj_stm_job *jobs = NULL;
+	unsigned char *seen = NULL;
+	int xref_len = pdf_xref_len(doc);
+	int n = 0, cap = 0, raw_len = 0, full = 0;
+	int i;
+
+	fz_var(jobs);
+	fz_var(seen);
+	fz_var(n);
+	fz_var(cap);
+	fz_var(raw_len);
+	fz_var(full);
+	fz_var(i);
+
+	fz_try(ctx)
+	{
+		seen = fz_calloc(ctx, xref_len, 1);
+		for (i = 0; i < xref_len && !full; i++)
+		{
+			pdf_xref_entry *x = pdf_get_xref_entry(doc, i);
+			pdf_xref_entry *stmx;
+			pdf_obj *dict = NULL;
+			fz_buffer *raw = NULL;
+			fz_stream *chain = NULL;
+			int num = x->ofs;
+
+			if (x->type != 'o' || x->obj || num <= 0 || num >= xref_len || seen[num])
+				continue;
+			seen[num] = 1;
+			stmx = pdf_get_xref_entry(doc, num);
+			if (stmx->type != 'n' || stmx->stm_buf)
+				continue;
+
+			if (n == cap)
+			{
+				cap = cap ? cap * 2 : 32;
+				jobs = fz_resize_array(ctx, jobs, cap, sizeof(pdf_obj_stm_job));
+			}
+
+			fz_var(dict);
+			fz_var(raw);
+			fz_var(chain);
+			fz_try(ctx)
+			{
+				dict = pdf_load_object(doc, num, 0);
+				raw = pdf_load_raw_stream(doc, num, 0);
+				/* stop before the stream that would exceed the budget */
+				if (raw->len > max_raw_len - raw_len)
+				{
+					full = 1;
+				}
+				else
+				{
+					chain = fz_open_buffer(ctx, raw);
+					/* the decoding filters run on a worker's context, so they mustn't access doc->file */
+					jobs[n].stm = pdf_open_inline_stream(doc, dict, raw->len, chain, NULL);
+					jobs[n].num = num;
+					jobs[n].data = NULL;
+					n++;
+					raw_len += raw->len;
+				}
+			}
+			fz_always(ctx)
+			{
+				fz_close(chain);
+				fz_drop_buffer(ctx, raw);
+				pdf_drop_obj(dict);
+			}
+			fz_catch(ctx)
+			{
+				fz_warn(ctx, "cannot prepare object stream (%d 0 R)", num);
+			}
+		}
+	}
+	fz_always(ctx)
+	{
+		fz_free(ctx, seen);
+	}
+	fz_catch(ctx)
+	{
+		pdf_drop_obj_stm_jobs(doc, jobs, n);
+		fz_rethrow(ctx);
+	}
+
+	*count = n;
+	return jobs;
+}
+
+void
+pdf_run_obj_stm_job(fz_context *ctx, pdf_obj_stm_job *job, int max_len)
+{
+	fz_stream *stm = job->stm;
+	fz_buffer *buf = NULL;
+	int n;
+
+	if (!stm)
+		return;
+	job->stm = NULL;
+	fz_rebind_stream(stm, ctx);
+
+	fz_var(buf);
+
+	fz_try(ctx)
+	{
+		buf = fz_new_buffer(ctx, 1024);
+		while ((n = fz_read(stm, buf->data + buf->len, buf->cap - buf->len)) > 0)
+		{
+			buf->len += n;
+			if (buf->len > max_len)
+				fz_throw(ctx, FZ_ERROR_GENERIC, "decoded object stream exceeds %d bytes", max_len);
+			if (buf->len == buf->cap)
+				fz_grow_buffer(ctx, buf);
+		}
+		job->data = buf;
+	}
+	fz_always(ctx)
+	{
+		fz_close(stm);
+	}
+	fz_catch(ctx)
+	{
+		/* the objects will be loaded on demand */
+		fz_drop_buffer(ctx, buf);
+		job->data = NULL;
+	}
+}
+
+void
+pdf_finish_obj_stm_job(pdf_document *doc, pdf_obj_stm_job *job)
+{
+	fz_context *ctx = doc->ctx;
+
+	if (job->stm)
+	{
+		fz_close(job->stm);
+		job->stm = NULL;
+	}
+	if (!job->data)
+		return;
+
+	fz_try(ctx)
+	{
+		pdf_load_obj_stm(doc, job->num, 0, &doc->lexbuf.base, job->data);
+	}
+	fz_always(ctx)
+	{
+		fz_drop_buffer(ctx, job->data);
+		job->data = NULL;
+	}
+	fz_catch(ctx)
+	{
+		/* the objects will be loaded (or fail to load) on demand */
+		fz_warn(ctx, "cannot warm up object stream (%d 0 R)", job->num);
+	}
+}
+
+void
+pdf_drop_obj_stm_jobs(pdf_document *doc, pdf_obj_stm_job *jobs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		fz_close(jobs[i].stm);
+		fz_drop_buffer(doc->ctx, jobs[i].data);
+	}
+	fz_free(doc->ctx, jobs);
+}
+
 /*
  * object loading
  */
@@ -1538,7 +1739,7 @@ pdf_load_hinted_page(pdf_document *doc, int pagenum)
 	{
 		int num = doc->hint_page[pagenum].number;
 		pdf_obj *page = pdf_load_object(doc, num, 0);
-		if (!strcmp("Page", pdf_to_name(pdf_dict_gets(page, "Type"))))
+		if (!strcmp("Page", pdf_to_name(pdf_dict_get(page, PDF_NAME(Type)))))
 		{
 			/* We have found the page object! */
 			DEBUGMESS((ctx, "LoadHintedPage pagenum=%d num=%d", pagenum, num));
@@ -1699,7 +1900,7 @@ object_updated:
 		{
 			fz_try(ctx)
 			{
-				pdf_load_obj_stm(doc, x->ofs, 0, &doc->lexbuf.base);
+				pdf_load_obj_stm(doc, x->ofs, 0, &doc->lexbuf.base, NULL);
 			}
 			fz_catch(ctx)
 			{
@@ -1823,6 +2024,9 @@ pdf_delete_object(pdf_document *doc, int num)
 		return;
 	}
 
+	/* SumatraPDF: cf. pdf_page_tree_altered */
+	pdf_page_tree_altered(doc, num);
+
 	x = pdf_get_incremental_xref_entry(doc, num);
 
 	fz_drop_buffer(doc->ctx, x->stm_buf);
@@ -1847,6 +2051,9 @@ pdf_update_object(pdf_document *doc, int num, pdf_obj *newobj)
 		return;
 	}
 
+	/* SumatraPDF: cf. pdf_page_tree_altered */
+	pdf_page_tree_altered(doc, num);
+
 	x = pdf_get_incremental_xref_entry(doc, num);
 
 	pdf_drop_obj(x->obj);
@@ -1922,7 +2129,7 @@ pdf_meta(pdf_document *doc, int key, void *ptr, int size)
 	}
 	case FZ_META_INFO:
 	{
-		pdf_obj *info = pdf_dict_gets(pdf_trailer(doc), "Info");
+		pdf_obj *info = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Info));
 		if (!info)
 		{
 			if (ptr)
@@ -2081,7 +2288,7 @@ pdf_load_hints(pdf_document *doc, int objnum, int gennum)
 		if (dict == NULL || !pdf_is_dict(dict))
 			fz_throw(ctx, FZ_ERROR_GENERIC, "malformed hint object");
 
-		shared_hint_offset = pdf_to_int(pdf_dict_gets(dict, "S"));
+		shared_hint_offset = pdf_to_int(pdf_dict_get(dict, PDF_NAME(S)));
 
 		/* Malloc the structures (use realloc to cope with the fact we
 		 * may try this several times before enough data is loaded) */
@@ -2355,8 +2562,8 @@ pdf_obj *pdf_progressive_advance(pdf_document *doc, int pagenum)
 			pdf_obj *pages;
 			doc->linear_pos = doc->file_length;
 			pdf_load_xref(doc, buf);
-			catalog = pdf_dict_gets(pdf_trailer(doc), "Root");
-			pages = pdf_dict_gets(catalog, "Pages");
+			catalog = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+			pages = pdf_dict_get(catalog, PDF_NAME(Pages));
 
 			if (!pdf_is_dict(pages))
 				fz_throw(ctx, FZ_ERROR_GENERIC, "missing page tree");
@@ -2410,20 +2617,21 @@ pdf_document *pdf_create_document(fz_context *ctx)
 		doc->num_xref_sections = 0;
 		pdf_get_populating_xref_entry(doc, 0);
 		doc->xref_altered = 1;
+		doc->num_incremental_sections = 1;
 		trailer = pdf_new_dict(doc, 2);
-		pdf_dict_puts_drop(trailer, "Size", pdf_new_int(doc, 3));
+		pdf_dict_put_drop(trailer, PDF_NAME(Size), pdf_new_int(doc, 3));
 		o = root = pdf_new_dict(doc, 2);
-		pdf_dict_puts_drop(trailer, "Root", pdf_new_ref(doc, o));
+		pdf_dict_put_drop(trailer, PDF_NAME(Root), pdf_new_ref(doc, o));
 		pdf_drop_obj(o);
 		o = NULL;
-		pdf_dict_puts_drop(root, "Type", pdf_new_name(doc, "Catalog"));
+		pdf_dict_put_drop(root, PDF_NAME(Type), pdf_new_name(doc, "Catalog"));
 		o = pages = pdf_new_dict(doc, 3);
-		pdf_dict_puts_drop(root, "Pages", pdf_new_ref(doc, o));
+		pdf_dict_put_drop(root, PDF_NAME(Pages), pdf_new_ref(doc, o));
 		pdf_drop_obj(o);
 		o = NULL;
-		pdf_dict_puts_drop(pages, "Type", pdf_new_name(doc, "Pages"));
-		pdf_dict_puts_drop(pages, "Count", pdf_new_int(doc, 0));
-		pdf_dict_puts_drop(pages, "Kids", pdf_new_array(doc, 1));
+		pdf_dict_put_drop(pages, PDF_NAME(Type), pdf_new_name(doc, "Pages"));
+		pdf_dict_put_drop(pages, PDF_NAME(Count), pdf_new_int(doc, 0));
+		pdf_dict_put_drop(pages, PDF_NAME(Kids), pdf_new_array(doc, 1));
 		pdf_set_populating_xref_trailer(doc, trailer);
 	}
 	fz_catch(ctx)
@@ -11,9 +11,12 @@
 /* SumatraPDF: add support for GDI+ draw device */
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
 #define GDI_PLUS_BMP_RENDERER
 #else
 #include <sys/time.h>
+#include <sys/resource.h>
+#include <pthread.h>
 #endif
 
 enum { TEXT_PLAIN = 1, TEXT_HTML = 2, TEXT_XML = 3 };
@@ -136,6 +139,8 @@ static fz_text_sheet *sheet = NULL;
 static fz_colorspace *colorspace;
 static char *filename;
 static int files = 0;
+static int threads = 1;
+static fz_png_options png_opts = { -1, FZ_PNG_FILTER_SUB, 0 };
 fz_output *out = NULL;
 
 static struct {
@@ -146,6 +151,31 @@ static struct {
 	char *maxfilename;
 } timing;
 
+/* SumatraPDF: structured benchmark mode (-J) */
+#define MAX_BENCH_VALUES 8
+
+typedef struct
+{
+	char name[64];
+	int count, cap;
+	double *samples;
+} bench_phase;
+
+static char *benchjson = NULL;
+static char *resolution_list = NULL;
+static char *rotation_list = NULL;
+static float bench_zoom[MAX_BENCH_VALUES];
+static float bench_rotate[MAX_BENCH_VALUES];
+static int bench_zoom_count = 0;
+static int bench_rotate_count = 0;
+static bench_phase *bench_phases = NULL;
+static int bench_phase_count = 0;
+static int bench_pages = 0;
+static int bench_errors = 0;
+static double bench_start = 0;
+static fz_store_stats bench_store;
+static fz_glyph_cache_stats bench_glyphs;
+
 static void usage(void)
 {
 	fprintf(stderr,
@@ -173,6 +203,10 @@ static void usage(void)
 		"\t-I\tinvert output\n"
 		"\t-l\tprint outline\n"
 		"\t-i\tignore errors and continue with the next file\n"
+		"\t-J -\twrite benchmark results as JSON (-r and -R accept lists)\n"
+		"\t-j -\tnumber of threads for rendering pages in parallel\n"
+		"\t-z -\tpng compression level (0 to 9)\n"
+		"\t-Z -\tpng filter {none,sub,up,average,paeth,adaptive}\n"
 		"\tpages\tcomma separated list of ranges\n");
 	exit(1);
 }
@@ -191,6 +225,22 @@ static int gettime(void)
 	return (now.tv_sec - first.tv_sec) * 1000 + (now.tv_usec - first.tv_usec) / 1000;
 }
 
+static double benchtime(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER freq = { 0 };
+	LARGE_INTEGER now;
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return now.QuadPart * 1000.0 / freq.QuadPart;
+#else
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+#endif
+}
+
 static int isrange(char *s)
 {
 	while (*s)
@@ -345,18 +395,577 @@ static void drawbmp(fz_context *ctx, fz_document *doc, fz_page *page, fz_display
 }
 #endif
 
+/* SumatraPDF: rasterize a page (from its display list, if there is one)
+ * into its output file and return the size of the rendered pixel data */
+static int drawpixmap(fz_context *ctx, fz_document *doc, fz_page *page, fz_display_list *list, const fz_rect *bounds, int pagenum, fz_cookie *cookie, unsigned char *digest)
+{
+	float zoom;
+	fz_matrix ctm;
+	fz_rect tbounds;
+	fz_irect ibounds;
+	fz_pixmap *pix = NULL;
+	fz_device *dev = NULL;
+	int w, h, bytes = 0;
+	fz_output *output_file = NULL;
+	fz_png_output_context *poc = NULL;
+
+	fz_var(pix);
+	fz_var(dev);
+	fz_var(poc);
+
+	zoom = resolution / 72;
+	fz_pre_scale(fz_rotate(&ctm, rotation), zoom, zoom);
+	tbounds = *bounds;
+	fz_round_rect(&ibounds, fz_transform_rect(&tbounds, &ctm));
+
+	/* Make local copies of our width/height */
+	w = width;
+	h = height;
+
+	/* If a resolution is specified, check to see whether w/h are
+	 * exceeded; if not, unset them. */
+	if (res_specified)
+	{
+		int t;
+		t = ibounds.x1 - ibounds.x0;
+		if (w && t <= w)
+			w = 0;
+		t = ibounds.y1 - ibounds.y0;
+		if (h && t <= h)
+			h = 0;
+	}
+
+	/* Now w or h will be 0 unless they need to be enforced. */
+	if (w || h)
+	{
+		float scalex = w / (tbounds.x1 - tbounds.x0);
+		float scaley = h / (tbounds.y1 - tbounds.y0);
+		fz_matrix scale_mat;
+
+		if (fit)
+		{
+			if (w == 0)
+				scalex = 1.0f;
+			if (h == 0)
+				scaley = 1.0f;
+		}
+		else
+		{
+			if (w == 0)
+				scalex = scaley;
+			if (h == 0)
+				scaley = scalex;
+		}
+		if (!fit)
+		{
+			if (scalex > scaley)
+				scalex = scaley;
+			else
+				scaley = scalex;
+		}
+		fz_scale(&scale_mat, scalex, scaley);
+		fz_concat(&ctm, &ctm, &scale_mat);
+		tbounds = *bounds;
+		fz_transform_rect(&tbounds, &ctm);
+	}
+	fz_round_rect(&ibounds, &tbounds);
+	fz_rect_from_irect(&tbounds, &ibounds);
+
+	/* TODO: banded rendering and multi-page ppm */
+	fz_try(ctx)
+	{
+		int savealpha = (out_cs == CS_GRAY_ALPHA || out_cs == CS_RGB_ALPHA || out_cs == CS_CMYK_ALPHA);
+		fz_irect band_ibounds = ibounds;
+		int band, bands = 1;
+		char filename_buf[512];
+		int totalheight = ibounds.y1 - ibounds.y0;
+		int drawheight = totalheight;
+
+		if (bandheight != 0)
+		{
+			/* Banded rendering; we'll only render to a
+			 * given height at a time. */
+			drawheight = bandheight;
+			if (totalheight > bandheight)
+				band_ibounds.y1 = band_ibounds.y0 + bandheight;
+			bands = (totalheight + bandheight-1)/bandheight;
+			tbounds.y1 = tbounds.y0 + bandheight + 2;
+		}
+
+		pix = fz_new_pixmap_with_bbox(ctx, colorspace, &band_ibounds);
+		fz_pixmap_set_resolution(pix, resolution);
+
+		if (output)
+		{
+			if (!strcmp(output, "-"))
+				output_file = fz_new_output_with_file(ctx, stdout);
+			else
+			{
+				sprintf(filename_buf, output, pagenum);
+				output_file = fz_new_output_to_filename(ctx, filename_buf);
+			}
+
+			if (output_format == OUT_PGM || output_format == OUT_PPM || output_format == OUT_PNM)
+				fz_output_pnm_header(output_file, pix->w, totalheight, pix->n);
+			else if (output_format == OUT_PAM)
+				fz_output_pam_header(output_file, pix->w, totalheight, pix->n, savealpha);
+			else if (output_format == OUT_PNG)
+				poc = fz_output_png_header_with_options(output_file, pix->w, totalheight, pix->n, savealpha, &png_opts);
+		}
+
+		for (band = 0; band < bands; band++)
+		{
+			if (savealpha)
+				fz_clear_pixmap(ctx, pix);
+			else
+				fz_clear_pixmap_with_value(ctx, pix, 255);
+
+			dev = fz_new_draw_device(ctx, pix);
+			if (alphabits == 0)
+				fz_enable_device_hints(dev, FZ_DONT_INTERPOLATE_IMAGES);
+			if (list)
+				fz_run_display_list(list, dev, &ctm, &tbounds, cookie);
+			else
+				fz_run_page(doc, page, dev, &ctm, cookie);
+			fz_free_device(dev);
+			dev = NULL;
+
+			if (invert)
+				fz_invert_pixmap(ctx, pix);
+			if (gamma_value != 1)
+				fz_gamma_pixmap(ctx, pix, gamma_value);
+
+			if (savealpha)
+				fz_unmultiply_pixmap(ctx, pix);
+
+			if (output)
+			{
+				if (output_format == OUT_PGM || output_format == OUT_PPM || output_format == OUT_PNM)
+					fz_output_pnm_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples);
+				else if (output_format == OUT_PAM)
+					fz_output_pam_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples, savealpha);
+				else if (output_format == OUT_PNG)
+					fz_output_png_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples, savealpha, poc);
+				else if (output_format == OUT_PWG)
+				{
+					if (strstr(output, "%d") != NULL)
+						append = 0;
+					if (out_cs == CS_MONO)
+					{
+						fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
+						fz_write_pwg_bitmap(ctx, bit, filename_buf, append, NULL);
+						fz_drop_bitmap(ctx, bit);
+					}
+					else
+						fz_write_pwg(ctx, pix, filename_buf, append, NULL);
+					append = 1;
+				}
+				else if (output_format == OUT_PCL)
+				{
+					fz_pcl_options options;
+
+					fz_pcl_preset(ctx, &options, "ljet4");
+
+					if (strstr(output, "%d") != NULL)
+						append = 0;
+					if (out_cs == CS_MONO)
+					{
+						fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
+						fz_write_pcl_bitmap(ctx, bit, filename_buf, append, &options);
+						fz_drop_bitmap(ctx, bit);
+					}
+					else
+						fz_write_pcl(ctx, pix, filename_buf, append, &options);
+					append = 1;
+				}
+				else if (output_format == OUT_PBM) {
+					fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
+					fz_write_pbm(ctx, bit, filename_buf);
+					fz_drop_bitmap(ctx, bit);
+				}
+				else if (output_format == OUT_TGA)
+				{
+					fz_write_tga(ctx, pix, filename_buf, savealpha);
+				}
+			}
+			ctm.f -= drawheight;
+		}
+
+		if (digest)
+			fz_md5_pixmap(pix, digest);
+		bytes = pix->w * totalheight * pix->n;
+	}
+	fz_always(ctx)
+	{
+		if (output)
+		{
+			if (output_format == OUT_PNG)
+				fz_output_png_trailer(output_file, poc);
+		}
+
+		fz_free_device(dev);
+		dev = NULL;
+		fz_drop_pixmap(ctx, pix);
+		if (output_file)
+			fz_close_output(output_file);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
+
+	return bytes;
+}
+
+static void addtiming(char *name, int pagenum, int diff)
+{
+	if (diff < timing.min)
+	{
+		timing.min = diff;
+		timing.minpage = pagenum;
+		timing.minfilename = name;
+	}
+	if (diff > timing.max)
+	{
+		timing.max = diff;
+		timing.maxpage = pagenum;
+		timing.maxfilename = name;
+	}
+	timing.total += diff;
+	timing.count ++;
+}
+
+/* SumatraPDF: parallel rendering (-j). Pages are loaded and converted
+ * into display lists one after another, while their rasterization is
+ * queued for worker threads running on clones of the main context
+ * (which share the store and the glyph cache). */
+
+#ifdef _WIN32
+
+typedef CRITICAL_SECTION draw_mutex;
+typedef HANDLE draw_sem;
+typedef HANDLE draw_thread;
+
+static void draw_mutex_init(draw_mutex *m) { InitializeCriticalSection(m); }
+static void draw_mutex_lock(draw_mutex *m) { EnterCriticalSection(m); }
+static void draw_mutex_unlock(draw_mutex *m) { LeaveCriticalSection(m); }
+static void draw_mutex_fin(draw_mutex *m) { DeleteCriticalSection(m); }
+
+static void draw_sem_init(draw_sem *s, int count) { *s = CreateSemaphore(NULL, count, 0x7fffffff, NULL); }
+static void draw_sem_wait(draw_sem *s) { WaitForSingleObject(*s, INFINITE); }
+static void draw_sem_post(draw_sem *s) { ReleaseSemaphore(*s, 1, NULL); }
+static void draw_sem_fin(draw_sem *s) { CloseHandle(*s); }
+
+#else
+
+typedef pthread_mutex_t draw_mutex;
+typedef struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+} draw_sem;
+typedef pthread_t draw_thread;
+
+static void draw_mutex_init(draw_mutex *m) { pthread_mutex_init(m, NULL); }
+static void draw_mutex_lock(draw_mutex *m) { pthread_mutex_lock(m); }
+static void draw_mutex_unlock(draw_mutex *m) { pthread_mutex_unlock(m); }
+static void draw_mutex_fin(draw_mutex *m) { pthread_mutex_destroy(m); }
+
+static void draw_sem_init(draw_sem *s, int count)
+{
+	pthread_mutex_init(&s->mutex, NULL);
+	pthread_cond_init(&s->cond, NULL);
+	s->count = count;
+}
+
+static void draw_sem_wait(draw_sem *s)
+{
+	pthread_mutex_lock(&s->mutex);
+	while (s->count == 0)
+		pthread_cond_wait(&s->cond, &s->mutex);
+	s->count--;
+	pthread_mutex_unlock(&s->mutex);
+}
+
+static void draw_sem_post(draw_sem *s)
+{
+	pthread_mutex_lock(&s->mutex);
+	s->count++;
+	pthread_cond_signal(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+
+static void draw_sem_fin(draw_sem *s)
+{
+	pthread_cond_destroy(&s->cond);
+	pthread_mutex_destroy(&s->mutex);
+}
+
+#endif
+
+typedef struct draw_job_s draw_job;
+
+struct draw_job_s
+{
+	fz_display_list *list; /* NULL tells a worker to exit */
+	fz_rect bounds;
+	char *filename;
+	int pagenum;
+	int time; /* spent on loading the page and creating its display list */
+	draw_job *next;
+};
+
+typedef struct
+{
+	fz_context *ctx;
+	draw_thread thread;
+} draw_worker;
+
+static draw_mutex fz_mutexes[FZ_LOCK_MAX];
+/* also guards printing and the statistics below */
+static draw_mutex job_mutex;
+/* number of queued jobs and of free queue slots */
+static draw_sem job_ready, job_slots;
+static draw_job *job_head = NULL, *job_tail = NULL;
+static draw_worker *workers = NULL;
+static int parallel_pages = 0;
+static double parallel_bytes = 0;
+
+static void benchrender(fz_context *ctx, fz_display_list *list, const fz_rect *pagebounds, fz_cookie *cookie);
+
+static void lock_fz_mutex(void *user, int lock)
+{
+	draw_mutex_lock(&((draw_mutex *)user)[lock]);
+}
+
+static void unlock_fz_mutex(void *user, int lock)
+{
+	draw_mutex_unlock(&((draw_mutex *)user)[lock]);
+}
+
+static fz_locks_context draw_locks = { fz_mutexes, lock_fz_mutex, unlock_fz_mutex };
+
+static void queuepage(fz_context *ctx, fz_display_list *list, const fz_rect *bounds, int pagenum, int time)
+{
+	draw_job *job = fz_malloc_struct(ctx, draw_job);
+
+	job->list = list ? fz_keep_display_list(ctx, list) : NULL;
+	if (bounds)
+		job->bounds = *bounds;
+	job->filename = filename;
+	job->pagenum = pagenum;
+	job->time = time;
+
+	/* don't let the display lists pile up if rendering can't keep up */
+	draw_sem_wait(&job_slots);
+	draw_mutex_lock(&job_mutex);
+	if (job_tail)
+		job_tail->next = job;
+	else
+		job_head = job;
+	job_tail = job;
+	draw_mutex_unlock(&job_mutex);
+	draw_sem_post(&job_ready);
+}
+
+/* for -J, only the renderings at all zoom levels and rotations are
+ * benchmarked in parallel (the other phases depend on the document) */
+static void benchjob(fz_context *ctx, draw_job *job)
+{
+	fz_cookie cookie = { 0 };
+	int failed = 0;
+
+	fz_try(ctx)
+	{
+		benchrender(ctx, job->list, &job->bounds, &cookie);
+	}
+	fz_catch(ctx)
+	{
+		failed = 1;
+	}
+	fz_drop_display_list(ctx, job->list);
+
+	draw_mutex_lock(&job_mutex);
+	if (failed)
+	{
+		fprintf(stderr, "warning: cannot benchmark page %d in file '%s'\n", job->pagenum, job->filename);
+		bench_errors++;
+	}
+	else
+		bench_pages++;
+	if (cookie.errors)
+		errored = 1;
+	draw_mutex_unlock(&job_mutex);
+
+	fz_flush_warnings(ctx);
+}
+
+static void drawjob(fz_context *ctx, draw_job *job)
+{
+	fz_cookie cookie = { 0 };
+	unsigned char digest[16];
+	int start = gettime();
+	int bytes = 0, failed = 0;
+	int diff, i;
+
+	fz_try(ctx)
+	{
+		bytes = drawpixmap(ctx, NULL, NULL, job->list, &job->bounds, job->pagenum, &cookie, showmd5 ? digest : NULL);
+	}
+	fz_catch(ctx)
+	{
+		failed = 1;
+	}
+	fz_drop_display_list(ctx, job->list);
+	diff = job->time + gettime() - start;
+
+	/* print complete lines in the same format as when rendering serially */
+	draw_mutex_lock(&job_mutex);
+	if (failed)
+	{
+		fprintf(stderr, "error: cannot draw page %d in file '%s'\n", job->pagenum, job->filename);
+		errored = 1;
+	}
+	else
+	{
+		if (showmd5 || showtime)
+			printf("page %s %d", job->filename, job->pagenum);
+		if (showmd5)
+		{
+			printf(" ");
+			for (i = 0; i < 16; i++)
+				printf("%02x", digest[i]);
+		}
+		if (showtime)
+		{
+			addtiming(job->filename, job->pagenum, diff);
+			printf(" %dms", diff);
+		}
+		if (showmd5 || showtime)
+			printf("\n");
+		parallel_pages++;
+		parallel_bytes += bytes;
+	}
+	if (cookie.errors)
+		errored = 1;
+	draw_mutex_unlock(&job_mutex);
+
+	fz_flush_warnings(ctx);
+}
+
+static void drawworker(fz_context *ctx)
+{
+	for (;;)
+	{
+		draw_job *job;
+
+		draw_sem_wait(&job_ready);
+		draw_mutex_lock(&job_mutex);
+		job = job_head;
+		job_head = job->next;
+		if (!job_head)
+			job_tail = NULL;
+		draw_mutex_unlock(&job_mutex);
+		draw_sem_post(&job_slots);
+
+		if (!job->list)
+		{
+			fz_free(ctx, job);
+			break;
+		}
+		if (benchjson)
+			benchjob(ctx, job);
+		else
+			drawjob(ctx, job);
+		fz_free(ctx, job);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI drawthread(LPVOID arg)
+{
+	drawworker((fz_context *)arg);
+	return 0;
+}
+#else
+static void *drawthread(void *arg)
+{
+	drawworker((fz_context *)arg);
+	return NULL;
+}
+#endif
+
+static void startworkers(fz_context *ctx)
+{
+	int i;
+
+	draw_mutex_init(&job_mutex);
+	draw_sem_init(&job_ready, 0);
+	draw_sem_init(&job_slots, 2 * threads);
+
+	workers = fz_malloc_array(ctx, threads, sizeof(draw_worker));
+	for (i = 0; i < threads; i++)
+	{
+		workers[i].ctx = fz_clone_context(ctx);
+		if (!workers[i].ctx)
+			break;
+#ifdef _WIN32
+		workers[i].thread = CreateThread(NULL, 0, drawthread, workers[i].ctx, 0, NULL);
+		if (!workers[i].thread)
+#else
+		if (pthread_create(&workers[i].thread, NULL, drawthread, workers[i].ctx) != 0)
+#endif
+		{
+			fz_free_context(workers[i].ctx);
+			break;
+		}
+	}
+	if (i < threads)
+	{
+		fz_warn(ctx, "only started %d of %d rendering threads", i, threads);
+		/* with less than two workers, pages are rendered serially */
+		threads = i;
+	}
+}
+
+static void finishworkers(fz_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < threads; i++)
+		queuepage(ctx, NULL, NULL, 0, 0);
+	for (i = 0; i < threads; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(workers[i].thread, INFINITE);
+		CloseHandle(workers[i].thread);
+#else
+		pthread_join(workers[i].thread, NULL);
+#endif
+		fz_free_context(workers[i].ctx);
+	}
+	fz_free(ctx, workers);
+	workers = NULL;
+
+	draw_sem_fin(&job_slots);
+	draw_sem_fin(&job_ready);
+	draw_mutex_fin(&job_mutex);
+}
+
 static void drawpage(fz_context *ctx, fz_document *doc, int pagenum)
 {
 	fz_page *page;
 	fz_display_list *list = NULL;
 	fz_device *dev = NULL;
 	int start;
+	int parallel;
 	fz_cookie cookie = { 0 };
 
 	fz_var(list);
 	fz_var(dev);
 
-	if (showtime)
+	if (showtime || threads > 1)
 	{
 		start = gettime();
 	}
@@ -461,7 +1070,10 @@ static void drawpage(fz_context *ctx, fz_document *doc, int pagenum)
 		}
 	}
 
-	if (showmd5 || showtime)
+	/* pages rendered in parallel are printed once they're done */
+	parallel = threads > 1 && list;
+
+	if ((showmd5 || showtime) && !parallel)
 		printf("page %s %d", filename, pagenum);
 
 	if (pdfout)
@@ -563,272 +1175,361 @@ static void drawpage(fz_context *ctx, fz_document *doc, int pagenum)
 #endif
 	if ((output && output_format != OUT_SVG && !pdfout)|| showmd5 || showtime)
 	{
-		float zoom;
-		fz_matrix ctm;
-		fz_rect bounds, tbounds;
-		fz_irect ibounds;
-		fz_pixmap *pix = NULL;
-		int w, h;
-		fz_output *output_file = NULL;
-		fz_png_output_context *poc = NULL;
-
-		fz_var(pix);
-		fz_var(poc);
+		fz_rect bounds;
+		unsigned char digest[16];
+		int i;
 
 		fz_bound_page(doc, page, &bounds);
-		zoom = resolution / 72;
-		fz_pre_scale(fz_rotate(&ctm, rotation), zoom, zoom);
-		tbounds = bounds;
-		fz_round_rect(&ibounds, fz_transform_rect(&tbounds, &ctm));
-
-		/* Make local copies of our width/height */
-		w = width;
-		h = height;
-
-		/* If a resolution is specified, check to see whether w/h are
-		 * exceeded; if not, unset them. */
-		if (res_specified)
+		if (parallel)
 		{
-			int t;
-			t = ibounds.x1 - ibounds.x0;
-			if (w && t <= w)
-				w = 0;
-			t = ibounds.y1 - ibounds.y0;
-			if (h && t <= h)
-				h = 0;
+			queuepage(ctx, list, &bounds, pagenum, gettime() - start);
 		}
-
-		/* Now w or h will be 0 unless they need to be enforced. */
-		if (w || h)
+		else
 		{
-			float scalex = w / (tbounds.x1 - tbounds.x0);
-			float scaley = h / (tbounds.y1 - tbounds.y0);
-			fz_matrix scale_mat;
-
-			if (fit)
+			fz_try(ctx)
 			{
-				if (w == 0)
-					scalex = 1.0f;
-				if (h == 0)
-					scaley = 1.0f;
+				drawpixmap(ctx, doc, page, list, &bounds, pagenum, &cookie, showmd5 ? digest : NULL);
 			}
-			else
+			fz_catch(ctx)
 			{
-				if (w == 0)
-					scalex = scaley;
-				if (h == 0)
-					scaley = scalex;
+				fz_drop_display_list(ctx, list);
+				fz_free_page(doc, page);
+				fz_rethrow(ctx);
 			}
-			if (!fit)
+
+			if (showmd5)
 			{
-				if (scalex > scaley)
-					scalex = scaley;
-				else
-					scaley = scalex;
+				printf(" ");
+				for (i = 0; i < 16; i++)
+					printf("%02x", digest[i]);
 			}
-			fz_scale(&scale_mat, scalex, scaley);
-			fz_concat(&ctm, &ctm, &scale_mat);
-			tbounds = bounds;
-			fz_transform_rect(&tbounds, &ctm);
 		}
-		fz_round_rect(&ibounds, &tbounds);
-		fz_rect_from_irect(&tbounds, &ibounds);
+	}
+	if (list)
+		fz_drop_display_list(ctx, list);
 
-		/* TODO: banded rendering and multi-page ppm */
-		fz_try(ctx)
-		{
-			int savealpha = (out_cs == CS_GRAY_ALPHA || out_cs == CS_RGB_ALPHA || out_cs == CS_CMYK_ALPHA);
-			fz_irect band_ibounds = ibounds;
-			int band, bands = 1;
-			char filename_buf[512];
-			int totalheight = ibounds.y1 - ibounds.y0;
-			int drawheight = totalheight;
-
-			if (bandheight != 0)
-			{
-				/* Banded rendering; we'll only render to a
-				 * given height at a time. */
-				drawheight = bandheight;
-				if (totalheight > bandheight)
-					band_ibounds.y1 = band_ibounds.y0 + bandheight;
-				bands = (totalheight + bandheight-1)/bandheight;
-				tbounds.y1 = tbounds.y0 + bandheight + 2;
-			}
+	fz_free_page(doc, page);
 
-			pix = fz_new_pixmap_with_bbox(ctx, colorspace, &band_ibounds);
-			fz_pixmap_set_resolution(pix, resolution);
+	if (showtime && !parallel)
+	{
+		int end = gettime();
+		int diff = end - start;
 
-			if (output)
-			{
-				if (!strcmp(output, "-"))
-					output_file = fz_new_output_with_file(ctx, stdout);
-				else
-				{
-					sprintf(filename_buf, output, pagenum);
-					output_file = fz_new_output_to_filename(ctx, filename_buf);
-				}
+		addtiming(filename, pagenum, diff);
+		printf(" %dms", diff);
+	}
 
-				if (output_format == OUT_PGM || output_format == OUT_PPM || output_format == OUT_PNM)
-					fz_output_pnm_header(output_file, pix->w, totalheight, pix->n);
-				else if (output_format == OUT_PAM)
-					fz_output_pam_header(output_file, pix->w, totalheight, pix->n, savealpha);
-				else if (output_format == OUT_PNG)
-					poc = fz_output_png_header(output_file, pix->w, totalheight, pix->n, savealpha);
-			}
+	if ((showmd5 || showtime) && !parallel)
+		printf("\n");
 
-			for (band = 0; band < bands; band++)
-			{
-				if (savealpha)
-					fz_clear_pixmap(ctx, pix);
-				else
-					fz_clear_pixmap_with_value(ctx, pix, 255);
+	if (showmemory)
+	{
+		fz_dump_glyph_cache_stats(ctx);
+	}
 
-				dev = fz_new_draw_device(ctx, pix);
-				if (alphabits == 0)
-					fz_enable_device_hints(dev, FZ_DONT_INTERPOLATE_IMAGES);
-				if (list)
-					fz_run_display_list(list, dev, &ctm, &tbounds, &cookie);
-				else
-					fz_run_page(doc, page, dev, &ctm, &cookie);
-				fz_free_device(dev);
-				dev = NULL;
+	fz_flush_warnings(ctx);
 
-				if (invert)
-					fz_invert_pixmap(ctx, pix);
-				if (gamma_value != 1)
-					fz_gamma_pixmap(ctx, pix, gamma_value);
+	if (cookie.errors)
+		errored = 1;
+}
 
-				if (savealpha)
-					fz_unmultiply_pixmap(ctx, pix);
+static void add_bench_sample_locked(const char *name, double ms)
+{
+	bench_phase *phase;
+	int i;
 
-				if (output)
-				{
-					if (output_format == OUT_PGM || output_format == OUT_PPM || output_format == OUT_PNM)
-						fz_output_pnm_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples);
-					else if (output_format == OUT_PAM)
-						fz_output_pam_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples, savealpha);
-					else if (output_format == OUT_PNG)
-						fz_output_png_band(output_file, pix->w, totalheight, pix->n, band, drawheight, pix->samples, savealpha, poc);
-					else if (output_format == OUT_PWG)
-					{
-						if (strstr(output, "%d") != NULL)
-							append = 0;
-						if (out_cs == CS_MONO)
-						{
-							fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
-							fz_write_pwg_bitmap(ctx, bit, filename_buf, append, NULL);
-							fz_drop_bitmap(ctx, bit);
-						}
-						else
-							fz_write_pwg(ctx, pix, filename_buf, append, NULL);
-						append = 1;
-					}
-					else if (output_format == OUT_PCL)
-					{
-						fz_pcl_options options;
-
-						fz_pcl_preset(ctx, &options, "ljet4");
-
-						if (strstr(output, "%d") != NULL)
-							append = 0;
-						if (out_cs == CS_MONO)
-						{
-							fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
-							fz_write_pcl_bitmap(ctx, bit, filename_buf, append, &options);
-							fz_drop_bitmap(ctx, bit);
-						}
-						else
-							fz_write_pcl(ctx, pix, filename_buf, append, &options);
-						append = 1;
-					}
-					else if (output_format == OUT_PBM) {
-						fz_bitmap *bit = fz_halftone_pixmap(ctx, pix, NULL);
-						fz_write_pbm(ctx, bit, filename_buf);
-						fz_drop_bitmap(ctx, bit);
-					}
-					else if (output_format == OUT_TGA)
-					{
-						fz_write_tga(ctx, pix, filename_buf, savealpha);
-					}
-				}
-				ctm.f -= drawheight;
-			}
+	for (i = 0; i < bench_phase_count; i++)
+		if (!strcmp(bench_phases[i].name, name))
+			break;
+	if (i == bench_phase_count)
+	{
+		/* samples are kept outside of the context's allocator so
+		 * that they don't show up in the heap statistics */
+		phase = realloc(bench_phases, (i + 1) * sizeof(bench_phase));
+		if (!phase)
+			return;
+		bench_phases = phase;
+		phase = &bench_phases[bench_phase_count++];
+		memset(phase, 0, sizeof(bench_phase));
+		fz_strlcpy(phase->name, name, sizeof(phase->name));
+	}
+	phase = &bench_phases[i];
+	if (phase->count == phase->cap)
+	{
+		int cap = phase->cap ? phase->cap * 2 : 64;
+		double *samples = realloc(phase->samples, cap * sizeof(double));
+		if (!samples)
+			return;
+		phase->samples = samples;
+		phase->cap = cap;
+	}
+	phase->samples[phase->count++] = ms;
+}
 
-			if (showmd5)
-			{
-				unsigned char digest[16];
-				int i;
+static void add_bench_sample(const char *name, double ms)
+{
+	/* renderings are timed on the worker threads for -j */
+	if (workers)
+		draw_mutex_lock(&job_mutex);
+	add_bench_sample_locked(name, ms);
+	if (workers)
+		draw_mutex_unlock(&job_mutex);
+}
 
-				fz_md5_pixmap(pix, digest);
-				printf(" ");
-				for (i = 0; i < 16; i++)
-					printf("%02x", digest[i]);
-			}
-		}
-		fz_always(ctx)
+/* keep the peak usage, as documents empty the caches when closed */
+static void update_bench_cache_stats(fz_context *ctx)
+{
+	fz_store_stats store;
+	fz_glyph_cache_stats glyphs;
+
+	fz_get_store_stats(ctx, &store);
+	fz_get_glyph_cache_stats(ctx, &glyphs);
+	store.size = fz_maxi(store.size, bench_store.size);
+	store.items = fz_maxi(store.items, bench_store.items);
+	glyphs.size = fz_maxi(glyphs.size, bench_glyphs.size);
+	glyphs.entries = fz_maxi(glyphs.entries, bench_glyphs.entries);
+	bench_store = store;
+	bench_glyphs = glyphs;
+}
+
+static int parse_bench_values(char *list, float *values, float fallback)
+{
+	int count = 0;
+	char *s = list;
+
+	while (s && *s && count < MAX_BENCH_VALUES)
+	{
+		values[count++] = atof(s);
+		s = strchr(s, ',');
+		if (s)
+			s++;
+	}
+	if (count == 0)
+		values[count++] = fallback;
+	return count;
+}
+
+/* renders a page at all requested zoom levels and rotations */
+static void benchrender(fz_context *ctx, fz_display_list *list, const fz_rect *pagebounds, fz_cookie *cookie)
+{
+	fz_device *dev = NULL;
+	fz_pixmap *pix = NULL;
+	int i, j;
+
+	fz_var(dev);
+	fz_var(pix);
+
+	fz_try(ctx)
+	{
+		for (i = 0; i < bench_zoom_count; i++)
 		{
-			if (output)
+			for (j = 0; j < bench_rotate_count; j++)
 			{
-				if (output_format == OUT_PNG)
-					fz_output_png_trailer(output_file, poc);
-			}
+				fz_matrix ctm;
+				fz_rect bounds = *pagebounds;
+				fz_irect ibounds;
+				char name[64];
+				double start = benchtime();
+
+				fz_pre_scale(fz_rotate(&ctm, bench_rotate[j]), bench_zoom[i] / 72, bench_zoom[i] / 72);
+				fz_round_rect(&ibounds, fz_transform_rect(&bounds, &ctm));
+				fz_rect_from_irect(&bounds, &ibounds);
+				pix = fz_new_pixmap_with_bbox(ctx, colorspace, &ibounds);
+				fz_clear_pixmap_with_value(ctx, pix, 255);
+				dev = fz_new_draw_device(ctx, pix);
+				fz_run_display_list(list, dev, &ctm, &bounds, cookie);
+				fz_free_device(dev);
+				dev = NULL;
+				fz_drop_pixmap(ctx, pix);
+				pix = NULL;
 
-			fz_free_device(dev);
-			dev = NULL;
-			fz_drop_pixmap(ctx, pix);
-			if (output_file)
-				fz_close_output(output_file);
-		}
-		fz_catch(ctx)
-		{
-			fz_drop_display_list(ctx, list);
-			fz_free_page(doc, page);
-			fz_rethrow(ctx);
+				/* name renderings by zoom level in percent, as SumatraPDF does */
+				sprintf(name, "render z=%g r=%g", bench_zoom[i] * 100 / 72, bench_rotate[j]);
+				add_bench_sample(name, benchtime() - start);
+			}
 		}
 	}
+	fz_always(ctx)
+	{
+		fz_free_device(dev);
+		fz_drop_pixmap(ctx, pix);
+	}
+	fz_catch(ctx)
+	{
+		fz_rethrow(ctx);
+	}
+}
 
-	if (list)
-		fz_drop_display_list(ctx, list);
+static void benchpage(fz_context *ctx, fz_document *doc, int pagenum)
+{
+	fz_page *page = NULL;
+	fz_display_list *list = NULL;
+	fz_device *dev = NULL;
+	fz_text_page *text = NULL;
+	fz_cookie cookie = { 0 };
+	fz_rect bounds;
+	double start;
 
-	fz_free_page(doc, page);
+	fz_var(page);
+	fz_var(list);
+	fz_var(dev);
+	fz_var(text);
 
-	if (showtime)
+	fz_try(ctx)
 	{
-		int end = gettime();
-		int diff = end - start;
+		start = benchtime();
+		page = fz_load_page(doc, pagenum - 1);
+		add_bench_sample("load", benchtime() - start);
 
-		if (diff < timing.min)
-		{
-			timing.min = diff;
-			timing.minpage = pagenum;
-			timing.minfilename = filename;
-		}
-		if (diff > timing.max)
-		{
-			timing.max = diff;
-			timing.maxpage = pagenum;
-			timing.maxfilename = filename;
-		}
-		timing.total += diff;
-		timing.count ++;
+		start = benchtime();
+		list = fz_new_display_list(ctx);
+		dev = fz_new_list_device(ctx, list);
+		fz_run_page(doc, page, dev, &fz_identity, &cookie);
+		fz_free_device(dev);
+		dev = NULL;
+		add_bench_sample("list", benchtime() - start);
 
-		printf(" %dms", diff);
+		fz_bound_page(doc, page, &bounds);
+		if (threads < 2)
+			benchrender(ctx, list, &bounds, &cookie);
+
+		/* text extraction shares the text sheet, so it always happens here */
+		start = benchtime();
+		text = fz_new_text_page(ctx);
+		dev = fz_new_text_device(ctx, sheet, text);
+		fz_run_display_list(list, dev, &fz_identity, &fz_infinite_rect, &cookie);
+		fz_free_device(dev);
+		dev = NULL;
+		add_bench_sample("text", benchtime() - start);
+
+		/* pages rendered in parallel are counted once they're done */
+		if (threads > 1)
+			queuepage(ctx, list, &bounds, pagenum, 0);
+		else
+			bench_pages++;
 	}
-
-	if (showmd5 || showtime)
-		printf("\n");
-
-	if (showmemory)
+	fz_always(ctx)
 	{
-		fz_dump_glyph_cache_stats(ctx);
+		fz_free_device(dev);
+		fz_free_text_page(ctx, text);
+		fz_drop_display_list(ctx, list);
+		if (page)
+			fz_free_page(doc, page);
+	}
+	fz_catch(ctx)
+	{
+		bench_errors++;
+		fz_warn(ctx, "cannot benchmark page %d in file '%s'", pagenum, filename);
 	}
 
+	update_bench_cache_stats(ctx);
 	fz_flush_warnings(ctx);
 
 	if (cookie.errors)
 		errored = 1;
 }
 
+static int cmp_sample(const void *a, const void *b)
+{
+	double d = *(const double *)a - *(const double *)b;
+	return d < 0 ? -1 : d > 0 ? 1 : 0;
+}
+
+/* nearest-rank percentile of sorted samples */
+static double percentile(bench_phase *phase, int pct)
+{
+	int rank = (phase->count * pct + 99) / 100;
+	return phase->samples[fz_clampi(rank, 1, phase->count) - 1];
+}
+
+static double peak_rss(void)
+{
+#ifdef _WIN32
+	/* avoid a link-time dependency on psapi.lib */
+	typedef BOOL (WINAPI *GetProcessMemoryInfoProc)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
+	PROCESS_MEMORY_COUNTERS pmc = { sizeof(pmc) };
+	HMODULE psapi = LoadLibraryA("psapi.dll");
+	GetProcessMemoryInfoProc proc = psapi ? (GetProcessMemoryInfoProc)GetProcAddress(psapi, "GetProcessMemoryInfo") : NULL;
+	if (proc && proc(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return (double)pmc.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss;
+#else
+	return usage.ru_maxrss * 1024.0;
+#endif
+#endif
+}
+
+static void print_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			fprintf(f, "\\u%04x", *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void write_bench_json(fz_context *ctx, char **argv, int argc)
+{
+	FILE *f;
+	int i, n;
+
+	f = strcmp(benchjson, "-") ? fopen(benchjson, "w") : stdout;
+	if (!f)
+	{
+		fprintf(stderr, "cannot open file '%s': %s\n", benchjson, strerror(errno));
+		errored = 1;
+		return;
+	}
+
+	update_bench_cache_stats(ctx);
+
+	fprintf(f, "{\n\t\"tool\": \"mudraw\",\n\t\"threads\": %d,\n\t\"files\": [", threads);
+	for (i = n = 0; i < argc; i++)
+	{
+		if (isrange(argv[i]))
+			continue;
+		if (n++ > 0)
+			fprintf(f, ", ");
+		print_json_string(f, argv[i]);
+	}
+	fprintf(f, "],\n\t\"pages\": %d,\n\t\"errors\": %d,\n\t\"wall_time\": %.3f,\n\t\"phases\": {",
+		bench_pages, bench_errors, benchtime() - bench_start);
+	for (i = 0; i < bench_phase_count; i++)
+	{
+		bench_phase *phase = &bench_phases[i];
+		double total = 0;
+		int k;
+
+		qsort(phase->samples, phase->count, sizeof(double), cmp_sample);
+		for (k = 0; k < phase->count; k++)
+			total += phase->samples[k];
+		fprintf(f, "%s\n\t\t\"%s\": { \"count\": %d, \"total\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }",
+			i > 0 ? "," : "", phase->name, phase->count, total, phase->samples[0],
+			percentile(phase, 50), percentile(phase, 95), percentile(phase, 99), phase->samples[phase->count - 1]);
+	}
+	fprintf(f, "\n\t},\n");
+	fprintf(f, "\t\"memory\": { \"peak_rss\": %.0f, \"peak_heap\": %d },\n", peak_rss(), memtrace_peak);
+	fprintf(f, "\t\"store\": { \"peak_size\": %u, \"max\": %u, \"peak_items\": %d, \"hits\": %d, \"misses\": %d },\n",
+		bench_store.size, bench_store.max, bench_store.items, bench_store.hits, bench_store.misses);
+	fprintf(f, "\t\"glyph_cache\": { \"peak_size\": %d, \"peak_entries\": %d, \"hits\": %d, \"misses\": %d }\n}\n",
+		bench_glyphs.size, bench_glyphs.entries, bench_glyphs.hits, bench_glyphs.misses);
+
+	if (f != stdout)
+		fclose(f);
+}
+
 static void drawrange(fz_context *ctx, fz_document *doc, char *range)
 {
 	int page, spage, epage, pagecount;
@@ -858,10 +1559,16 @@ static void drawrange(fz_context *ctx, fz_document *doc, char *range)
 
 		if (spage < epage)
 			for (page = spage; page <= epage; page++)
-				drawpage(ctx, doc, page);
+				if (benchjson)
+					benchpage(ctx, doc, page);
+				else
+					drawpage(ctx, doc, page);
 		else
 			for (page = spage; page >= epage; page--)
-				drawpage(ctx, doc, page);
+				if (benchjson)
+					benchpage(ctx, doc, page);
+				else
+					drawpage(ctx, doc, page);
 
 		spec = fz_strsep(&range, ",");
 	}
@@ -906,6 +1613,20 @@ parse_colorspace(const char *name)
 	exit(1);
 }
 
+static int
+parse_png_filter(const char *name)
+{
+	static const char *names[] = { "none", "sub", "up", "average", "paeth", "adaptive" };
+	int i;
+
+	for (i = 0; i < nelem(names); i++)
+		if (!strcmp(name, names[i]))
+			return FZ_PNG_FILTER_NONE + i;
+	fprintf(stderr, "Unknown png filter '%s'\n", name);
+	exit(1);
+	return FZ_PNG_FILTER_SUB;
+}
+
 static void *
 trace_malloc(void *arg, unsigned int size)
 {
@@ -966,19 +1687,20 @@ int main(int argc, char **argv)
 	fz_document *doc = NULL;
 	int c;
 	fz_context *ctx;
+	int firstfile;
 	fz_alloc_context alloc_ctx = { NULL, trace_malloc, trace_realloc, trace_free };
 
 	fz_var(doc);
 
-	while ((c = fz_getopt(argc, argv, "lo:F:p:r:R:b:c:dgmtx5G:Iw:h:fiMB:")) != -1)
+	while ((c = fz_getopt(argc, argv, "lo:F:p:r:R:b:c:dgmtx5G:Iw:h:fiMB:J:j:z:Z:")) != -1)
 	{
 		switch (c)
 		{
 		case 'o': output = fz_optarg; break;
 		case 'F': format = fz_optarg; break;
 		case 'p': password = fz_optarg; break;
-		case 'r': resolution = atof(fz_optarg); res_specified = 1; break;
-		case 'R': rotation = atof(fz_optarg); break;
+		case 'r': resolution = atof(fz_optarg); resolution_list = fz_optarg; res_specified = 1; break;
+		case 'R': rotation = atof(fz_optarg); rotation_list = fz_optarg; break;
 		case 'b': alphabits = atoi(fz_optarg); break;
 		case 'B': bandheight = atoi(fz_optarg); break;
 		case 'l': showoutline++; break;
@@ -996,6 +1718,10 @@ int main(int argc, char **argv)
 		case 'f': fit = 1; break;
 		case 'I': invert++; break;
 		case 'i': ignore_errors = 1; break;
+		case 'J': benchjson = fz_optarg; break;
+		case 'j': threads = atoi(fz_optarg); break;
+		case 'z': png_opts.level = atoi(fz_optarg); break;
+		case 'Z': png_opts.filter = parse_png_filter(fz_optarg); break;
 		default: usage(); break;
 		}
 	}
@@ -1003,13 +1729,26 @@ int main(int argc, char **argv)
 	if (fz_optind == argc)
 		usage();
 
-	if (!showtext && !showxml && !showtime && !showmd5 && !showoutline && !output)
+	if (!showtext && !showxml && !showtime && !showmd5 && !showoutline && !output && !benchjson)
 	{
 		printf("nothing to do\n");
 		exit(0);
 	}
 
-	ctx = fz_new_context((showmemory == 0 ? NULL : &alloc_ctx), NULL, FZ_STORE_DEFAULT);
+	if (benchjson)
+	{
+		bench_zoom_count = parse_bench_values(resolution_list, bench_zoom, resolution);
+		bench_rotate_count = parse_bench_values(rotation_list, bench_rotate, rotation);
+	}
+
+	if (threads > 1)
+	{
+		int i;
+		for (i = 0; i < FZ_LOCK_MAX; i++)
+			draw_mutex_init(&fz_mutexes[i]);
+	}
+
+	ctx = fz_new_context((showmemory == 0 && !benchjson ? NULL : &alloc_ctx), threads > 1 ? &draw_locks : NULL, FZ_STORE_DEFAULT);
 	if (!ctx)
 	{
 		fprintf(stderr, "cannot initialise context\n");
@@ -1129,6 +1868,33 @@ int main(int argc, char **argv)
 		pdfout = pdf_create_document(ctx);
 	}
 
+	/* SumatraPDF: only rasterization into separate files (or for -5, -m
+	 * and -J) happens in parallel, everything else depends on the order
+	 * of pages (-J doesn't write any output, so it always supports -j) */
+	if (threads > 1 && !benchjson)
+	{
+		if (!uselist || showtext || showxml ||
+			output_format == OUT_SVG || output_format == OUT_PDF ||
+			output_format == OUT_PWG || output_format == OUT_PCL ||
+#ifdef GDI_PLUS_BMP_RENDERER
+			output_format == OUT_BMP || output_format == OUT_TGA && !gamma_value ||
+#endif
+			(output && !strcmp(output, "-")))
+		{
+			fprintf(stderr, "warning: -j is not supported with these options, rendering serially\n");
+			threads = 1;
+		}
+		/* all pages would be written to the same file at the same time */
+		else if (output && !strstr(output, "%d"))
+		{
+			fprintf(stderr, "warning: -j requires %%d in the output filename, rendering serially\n");
+			threads = 1;
+		}
+		/* pages are already compressed in parallel */
+		else
+			png_opts.threads = 1;
+	}
+
 	timing.count = 0;
 	timing.total = 0;
 	timing.min = 1 << 30;
@@ -1144,7 +1910,7 @@ int main(int argc, char **argv)
 	if (showxml || showtext == TEXT_XML)
 		fz_printf(out, "<?xml version=\"1.0\"?>\n");
 
-	if (showtext)
+	if (showtext || benchjson)
 		sheet = fz_new_text_sheet(ctx);
 
 	if (showtext == TEXT_HTML)
@@ -1161,14 +1927,22 @@ int main(int argc, char **argv)
 		fz_printf(out, "<body>\n");
 	}
 
+	firstfile = fz_optind;
+	bench_start = benchtime();
+
 	fz_try(ctx)
 	{
 		fz_register_document_handlers(ctx);
 
+		if (threads > 1)
+			startworkers(ctx);
+
 		while (fz_optind < argc)
 		{
 			fz_try(ctx)
 			{
+				double start = benchtime();
+
 				filename = argv[fz_optind++];
 				files++;
 
@@ -1187,13 +1961,20 @@ int main(int argc, char **argv)
 						fz_throw(ctx, FZ_ERROR_GENERIC, "cannot authenticate password: %s", filename);
 				}
 
+				/* opening includes counting pages, as some formats defer that */
+				if (benchjson)
+				{
+					fz_count_pages(doc);
+					add_bench_sample("open", benchtime() - start);
+				}
+
 				if (showxml || showtext == TEXT_XML)
 					fz_printf(out, "<document name=\"%s\">\n", filename);
 
 				if (showoutline)
 					drawoutline(ctx, doc);
 
-				if (showtext || showxml || showtime || showmd5 || output)
+				if (showtext || showxml || showtime || showmd5 || output || benchjson)
 				{
 					if (fz_optind == argc || !isrange(argv[fz_optind]))
 						drawrange(ctx, doc, "1-");
@@ -1225,6 +2006,17 @@ int main(int argc, char **argv)
 		errored = 1;
 	}
 
+	if (workers)
+	{
+		double elapsed;
+
+		finishworkers(ctx);
+		elapsed = (benchtime() - bench_start) / 1000;
+		if (elapsed > 0 && !benchjson)
+			fprintf(stderr, "rendered %d pages in %.2fs with %d threads: %.2f pages/s, %.2f MB/s\n",
+				parallel_pages, elapsed, threads, parallel_pages / elapsed, parallel_bytes / elapsed / (1 << 20));
+	}
+
 	if (pdfout)
 	{
 		fz_write_options opts = { 0 };
@@ -1241,7 +2033,10 @@ int main(int argc, char **argv)
 		fz_printf(out, "</style>\n");
 	}
 
-	if (showtext)
+	if (benchjson)
+		write_bench_json(ctx, argv + firstfile, argc - firstfile);
+
+	if (showtext || benchjson)
 		fz_free_text_sheet(ctx, sheet);
 
 	if (showxml || showtext)
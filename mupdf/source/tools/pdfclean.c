@@ -31,6 +31,7 @@ static void usage(void)
 		"\t-i\ttoggle decompression of image streams\n"
 		"\t-f\ttoggle decompression of font streams\n"
 		"\t-a\tascii hex encode binary streams\n"
+		"\t-o\tpack objects into object streams\n"
 		"\tpages\tcomma separated list of ranges\n");
 	exit(1);
 }
@@ -59,7 +60,7 @@ static void retainpage(pdf_document *doc, pdf_obj *parent, pdf_obj *kids, int pa
 	pdf_obj *pageref = pdf_lookup_page_obj(doc, page-1);
 	pdf_obj *pageobj = pdf_resolve_indirect(pageref);
 
-	pdf_dict_puts(pageobj, "Parent", parent);
+	pdf_dict_put(pageobj, PDF_NAME(Parent), parent);
 
 	/* Store page object in new kids array */
 	pdf_array_push(kids, pageref);
@@ -76,13 +77,13 @@ static void retainpages(globals *glo, int argc, char **argv)
 
 	/* Keep only pages/type and (reduced) dest entries to avoid
 	 * references to unretained pages */
-	oldroot = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pages = pdf_dict_gets(oldroot, "Pages");
+	oldroot = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pages = pdf_dict_get(oldroot, PDF_NAME(Pages));
 	olddests = pdf_load_name_tree(doc, "Dests");
 
 	root = pdf_new_dict(doc, 2);
-	pdf_dict_puts(root, "Type", pdf_dict_gets(oldroot, "Type"));
-	pdf_dict_puts(root, "Pages", pdf_dict_gets(oldroot, "Pages"));
+	pdf_dict_put(root, PDF_NAME(Type), pdf_dict_get(oldroot, PDF_NAME(Type)));
+	pdf_dict_put(root, PDF_NAME(Pages), pdf_dict_get(oldroot, PDF_NAME(Pages)));
 
 	pdf_update_object(doc, pdf_to_num(oldroot), root);
 
@@ -138,9 +139,9 @@ static void retainpages(globals *glo, int argc, char **argv)
 
 	/* Update page count and kids array */
 	countobj = pdf_new_int(doc, pdf_array_len(kids));
-	pdf_dict_puts(pages, "Count", countobj);
+	pdf_dict_put(pages, PDF_NAME(Count), countobj);
 	pdf_drop_obj(countobj);
-	pdf_dict_puts(pages, "Kids", kids);
+	pdf_dict_put(pages, PDF_NAME(Kids), kids);
 	pdf_drop_obj(kids);
 
 	/* Also preserve the (partial) Dests name tree */
@@ -156,10 +157,10 @@ static void retainpages(globals *glo, int argc, char **argv)
 		{
 			pdf_obj *key = pdf_dict_get_key(olddests, i);
 			pdf_obj *val = pdf_dict_get_val(olddests, i);
-			pdf_obj *dest = pdf_dict_gets(val, "D");
+			pdf_obj *dest = pdf_dict_get(val, PDF_NAME(D));
 
 			dest = pdf_array_get(dest ? dest : val, 0);
-			if (pdf_array_contains(pdf_dict_gets(pages, "Kids"), dest))
+			if (pdf_array_contains(pdf_dict_get(pages, PDF_NAME(Kids)), dest))
 			{
 				pdf_obj *key_str = pdf_new_string(doc, pdf_to_name(key), strlen(pdf_to_name(key)));
 				pdf_array_push(names_list, key_str);
@@ -168,10 +169,10 @@ static void retainpages(globals *glo, int argc, char **argv)
 			}
 		}
 
-		root = pdf_dict_gets(pdf_trailer(doc), "Root");
-		pdf_dict_puts(dests, "Names", names_list);
-		pdf_dict_puts(names, "Dests", dests);
-		pdf_dict_puts(root, "Names", names);
+		root = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+		pdf_dict_put(dests, PDF_NAME(Names), names_list);
+		pdf_dict_put(names, PDF_NAME(Dests), dests);
+		pdf_dict_put(root, PDF_NAME(Names), names);
 
 		pdf_drop_obj(names);
 		pdf_drop_obj(dests);
@@ -190,7 +191,7 @@ static void retainpages(globals *glo, int argc, char **argv)
 		pdf_obj *pageref = pdf_lookup_page_obj(doc, i);
 		pdf_obj *pageobj = pdf_resolve_indirect(pageref);
 
-		pdf_obj *annots = pdf_dict_gets(pageobj, "Annots");
+		pdf_obj *annots = pdf_dict_get(pageobj, PDF_NAME(Annots));
 
 		int len = pdf_array_len(annots);
 		int j;
@@ -200,14 +201,14 @@ static void retainpages(globals *glo, int argc, char **argv)
 			pdf_obj *o = pdf_array_get(annots, j);
 			pdf_obj *p;
 
-			if (strcmp(pdf_to_name(pdf_dict_gets(o, "Subtype")), "Link"))
+			if (strcmp(pdf_to_name(pdf_dict_get(o, PDF_NAME(Subtype))), "Link"))
 				continue;
 
-			p = pdf_dict_gets(o, "A");
-			if (strcmp(pdf_to_name(pdf_dict_gets(p, "S")), "GoTo"))
+			p = pdf_dict_get(o, PDF_NAME(A));
+			if (strcmp(pdf_to_name(pdf_dict_get(p, PDF_NAME(S))), "GoTo"))
 				continue;
 
-			if (string_in_names_list(pdf_dict_gets(p, "D"), names_list))
+			if (string_in_names_list(pdf_dict_get(p, PDF_NAME(D)), names_list))
 				continue;
 
 			/* FIXME: Should probably look at Next too */
@@ -267,8 +268,10 @@ int pdfclean_main(int argc, char **argv)
 	opts.continue_on_error = 1;
 	opts.errors = &errors;
 	opts.do_clean = 0;
+	opts.do_objstms = 0;
+	opts.do_appending = 0;
 
-	while ((c = fz_getopt(argc, argv, "adfgilp:s")) != -1)
+	while ((c = fz_getopt(argc, argv, "adfgilop:s")) != -1)
 	{
 		switch (c)
 		{
@@ -279,6 +282,7 @@ int pdfclean_main(int argc, char **argv)
 		case 'i': opts.do_expand ^= fz_expand_images; break;
 		case 'l': opts.do_linear ++; break;
 		case 'a': opts.do_ascii ++; break;
+		case 'o': opts.do_objstms ++; break;
 		case 's': opts.do_clean ++; break;
 		default: usage(); break;
 		}
@@ -18,14 +18,14 @@ static void usage(void)
 
 static int isimage(pdf_obj *obj)
 {
-	pdf_obj *type = pdf_dict_gets(obj, "Subtype");
-	return pdf_is_name(type) && !strcmp(pdf_to_name(type), "Image");
+	pdf_obj *type = pdf_dict_get(obj, PDF_NAME(Subtype));
+	return pdf_is_name(type) && pdf_name_eq(type, PDF_NAME(Image));
 }
 
 static int isfontdesc(pdf_obj *obj)
 {
-	pdf_obj *type = pdf_dict_gets(obj, "Type");
-	return pdf_is_name(type) && !strcmp(pdf_to_name(type), "FontDescriptor");
+	pdf_obj *type = pdf_dict_get(obj, PDF_NAME(Type));
+	return pdf_is_name(type) && pdf_name_eq(type, PDF_NAME(FontDescriptor));
 }
 
 static void writepixmap(fz_context *ctx, fz_pixmap *pix, char *file, int rgb)
@@ -95,30 +95,30 @@ static void savefont(pdf_obj *dict, int num)
 	int n, len;
 	unsigned char *data;
 
-	obj = pdf_dict_gets(dict, "FontName");
+	obj = pdf_dict_get(dict, PDF_NAME(FontName));
 	if (obj)
 		fontname = pdf_to_name(obj);
 
-	obj = pdf_dict_gets(dict, "FontFile");
+	obj = pdf_dict_get(dict, PDF_NAME(FontFile));
 	if (obj)
 	{
 		stream = obj;
 		ext = "pfa";
 	}
 
-	obj = pdf_dict_gets(dict, "FontFile2");
+	obj = pdf_dict_get(dict, PDF_NAME(FontFile2));
 	if (obj)
 	{
 		stream = obj;
 		ext = "ttf";
 	}
 
-	obj = pdf_dict_gets(dict, "FontFile3");
+	obj = pdf_dict_get(dict, PDF_NAME(FontFile3));
 	if (obj)
 	{
 		stream = obj;
 
-		obj = pdf_dict_gets(obj, "Subtype");
+		obj = pdf_dict_get(obj, PDF_NAME(Subtype));
 		if (obj && !pdf_is_name(obj))
 			fz_throw(ctx, FZ_ERROR_GENERIC, "Invalid font descriptor subtype");
 
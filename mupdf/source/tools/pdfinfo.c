@@ -172,14 +172,14 @@ showglobalinfo(globals *glo)
 
 	fz_printf(out, "\nPDF-%d.%d\n", doc->version / 10, doc->version % 10);
 
-	obj = pdf_dict_gets(pdf_trailer(doc), "Info");
+	obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Info));
 	if (obj)
 	{
 		fz_printf(out, "Info object (%d %d R):\n", pdf_to_num(obj), pdf_to_gen(obj));
 		pdf_output_obj(out, pdf_resolve_indirect(obj), 1);
 	}
 
-	obj = pdf_dict_gets(pdf_trailer(doc), "Encrypt");
+	obj = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Encrypt));
 	if (obj)
 	{
 		fz_printf(out, "\nEncryption object (%d %d R):\n", pdf_to_num(obj), pdf_to_gen(obj));
@@ -196,13 +196,13 @@ gatherdimensions(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj)
 	pdf_obj *obj;
 	int j;
 
-	obj = pdf_dict_gets(pageobj, "MediaBox");
+	obj = pdf_dict_get(pageobj, PDF_NAME(MediaBox));
 	if (!pdf_is_array(obj))
 		return;
 
 	pdf_to_rect(glo->ctx, obj, &bbox);
 
-	obj = pdf_dict_gets(pageobj, "UserUnit");
+	obj = pdf_dict_get(pageobj, PDF_NAME(UserUnit));
 	if (pdf_is_real(obj))
 	{
 		float unit = pdf_to_real(obj);
@@ -252,10 +252,10 @@ gatherfonts(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_obj
 			continue;
 		}
 
-		subtype = pdf_dict_gets(fontdict, "Subtype");
-		basefont = pdf_dict_gets(fontdict, "BaseFont");
+		subtype = pdf_dict_get(fontdict, PDF_NAME(Subtype));
+		basefont = pdf_dict_get(fontdict, PDF_NAME(BaseFont));
 		if (!basefont || pdf_is_null(basefont))
-			name = pdf_dict_gets(fontdict, "Name");
+			name = pdf_dict_get(fontdict, PDF_NAME(Name));
 
 		for (k = 0; k < glo->fonts; k++)
 			if (!pdf_objcmp(glo->font[k].u.font.obj, fontdict))
@@ -301,20 +301,20 @@ gatherimages(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_obj
 			continue;
 		}
 
-		type = pdf_dict_gets(imagedict, "Subtype");
+		type = pdf_dict_get(imagedict, PDF_NAME(Subtype));
 		if (strcmp(pdf_to_name(type), "Image"))
 			continue;
 
-		filter = pdf_dict_gets(imagedict, "Filter");
+		filter = pdf_dict_get(imagedict, PDF_NAME(Filter));
 
 		altcs = NULL;
-		cs = pdf_dict_gets(imagedict, "ColorSpace");
+		cs = pdf_dict_get(imagedict, PDF_NAME(ColorSpace));
 		if (pdf_is_array(cs))
 		{
 			pdf_obj *cses = cs;
 
 			cs = pdf_array_get(cses, 0);
-			if (pdf_is_name(cs) && (!strcmp(pdf_to_name(cs), "DeviceN") || !strcmp(pdf_to_name(cs), "Separation")))
+			if (pdf_is_name(cs) && (pdf_name_eq(cs, PDF_NAME(DeviceN)) || pdf_name_eq(cs, PDF_NAME(Separation))))
 			{
 				altcs = pdf_array_get(cses, 2);
 				if (pdf_is_array(altcs))
@@ -322,9 +322,9 @@ gatherimages(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_obj
 			}
 		}
 
-		width = pdf_dict_gets(imagedict, "Width");
-		height = pdf_dict_gets(imagedict, "Height");
-		bpc = pdf_dict_gets(imagedict, "BitsPerComponent");
+		width = pdf_dict_get(imagedict, PDF_NAME(Width));
+		height = pdf_dict_get(imagedict, PDF_NAME(Height));
+		bpc = pdf_dict_get(imagedict, PDF_NAME(BitsPerComponent));
 
 		for (k = 0; k < glo->images; k++)
 			if (!pdf_objcmp(glo->image[k].u.image.obj, imagedict))
@@ -372,17 +372,17 @@ gatherforms(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_obj
 			continue;
 		}
 
-		type = pdf_dict_gets(xobjdict, "Subtype");
+		type = pdf_dict_get(xobjdict, PDF_NAME(Subtype));
 		if (strcmp(pdf_to_name(type), "Form"))
 			continue;
 
-		subtype = pdf_dict_gets(xobjdict, "Subtype2");
-		if (!strcmp(pdf_to_name(subtype), "PS"))
+		subtype = pdf_dict_get(xobjdict, PDF_NAME(Subtype2));
+		if (pdf_name_eq(subtype, PDF_NAME(PS)))
 			continue;
 
-		group = pdf_dict_gets(xobjdict, "Group");
-		groupsubtype = pdf_dict_gets(group, "S");
-		reference = pdf_dict_gets(xobjdict, "Ref");
+		group = pdf_dict_get(xobjdict, PDF_NAME(Group));
+		groupsubtype = pdf_dict_get(group, PDF_NAME(S));
+		reference = pdf_dict_get(xobjdict, PDF_NAME(Ref));
 
 		for (k = 0; k < glo->forms; k++)
 			if (!pdf_objcmp(glo->form[k].u.form.obj, xobjdict))
@@ -423,8 +423,8 @@ gatherpsobjs(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_obj
 			continue;
 		}
 
-		type = pdf_dict_gets(xobjdict, "Subtype");
-		subtype = pdf_dict_gets(xobjdict, "Subtype2");
+		type = pdf_dict_get(xobjdict, PDF_NAME(Subtype));
+		subtype = pdf_dict_get(xobjdict, PDF_NAME(Subtype2));
 		if (strcmp(pdf_to_name(type), "PS") &&
 			(strcmp(pdf_to_name(type), "Form") || strcmp(pdf_to_name(subtype), "PS")))
 			continue;
@@ -465,7 +465,7 @@ gathershadings(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_o
 			continue;
 		}
 
-		type = pdf_dict_gets(shade, "ShadingType");
+		type = pdf_dict_get(shade, PDF_NAME(ShadingType));
 		if (!pdf_is_int(type) || pdf_to_int(type) < 1 || pdf_to_int(type) > 7)
 		{
 			fz_warn(glo->ctx, "not a shading type (%d %d R)", pdf_to_num(shade), pdf_to_gen(shade));
@@ -512,7 +512,7 @@ gatherpatterns(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_o
 			continue;
 		}
 
-		type = pdf_dict_gets(patterndict, "PatternType");
+		type = pdf_dict_get(patterndict, PDF_NAME(PatternType));
 		if (!pdf_is_int(type) || pdf_to_int(type) < 1 || pdf_to_int(type) > 2)
 		{
 			fz_warn(glo->ctx, "not a pattern type (%d %d R)", pdf_to_num(patterndict), pdf_to_gen(patterndict));
@@ -521,14 +521,14 @@ gatherpatterns(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_o
 
 		if (pdf_to_int(type) == 1)
 		{
-			paint = pdf_dict_gets(patterndict, "PaintType");
+			paint = pdf_dict_get(patterndict, PDF_NAME(PaintType));
 			if (!pdf_is_int(paint) || pdf_to_int(paint) < 1 || pdf_to_int(paint) > 2)
 			{
 				fz_warn(glo->ctx, "not a pattern paint type (%d %d R)", pdf_to_num(patterndict), pdf_to_gen(patterndict));
 				paint = NULL;
 			}
 
-			tiling = pdf_dict_gets(patterndict, "TilingType");
+			tiling = pdf_dict_get(patterndict, PDF_NAME(TilingType));
 			if (!pdf_is_int(tiling) || pdf_to_int(tiling) < 1 || pdf_to_int(tiling) > 3)
 			{
 				fz_warn(glo->ctx, "not a pattern tiling type (%d %d R)", pdf_to_num(patterndict), pdf_to_gen(patterndict));
@@ -537,7 +537,7 @@ gatherpatterns(globals *glo, int page, pdf_obj *pageref, pdf_obj *pageobj, pdf_o
 		}
 		else
 		{
-			shading = pdf_dict_gets(patterndict, "Shading");
+			shading = pdf_dict_get(patterndict, PDF_NAME(Shading));
 		}
 
 		for (k = 0; k < glo->patterns; k++)
@@ -579,7 +579,7 @@ gatherresourceinfo(globals *glo, int page, pdf_obj *rsrc, int show)
 	if (!pageobj)
 		fz_throw(glo->ctx, FZ_ERROR_GENERIC, "cannot retrieve info from page %d", page);
 
-	font = pdf_dict_gets(rsrc, "Font");
+	font = pdf_dict_get(rsrc, PDF_NAME(Font));
 	if (show & FONTS && font)
 	{
 		int n;
@@ -590,13 +590,13 @@ gatherresourceinfo(globals *glo, int page, pdf_obj *rsrc, int show)
 		{
 			pdf_obj *obj = pdf_dict_get_val(font, i);
 
-			subrsrc = pdf_dict_gets(obj, "Resources");
+			subrsrc = pdf_dict_get(obj, PDF_NAME(Resources));
 			if (subrsrc && pdf_objcmp(rsrc, subrsrc))
 				gatherresourceinfo(glo, page, subrsrc, show);
 		}
 	}
 
-	xobj = pdf_dict_gets(rsrc, "XObject");
+	xobj = pdf_dict_get(rsrc, PDF_NAME(XObject));
 	if (show & XOBJS && xobj)
 	{
 		int n;
@@ -608,17 +608,17 @@ gatherresourceinfo(globals *glo, int page, pdf_obj *rsrc, int show)
 		for (i = 0; i < n; i++)
 		{
 			pdf_obj *obj = pdf_dict_get_val(xobj, i);
-			subrsrc = pdf_dict_gets(obj, "Resources");
+			subrsrc = pdf_dict_get(obj, PDF_NAME(Resources));
 			if (subrsrc && pdf_objcmp(rsrc, subrsrc))
 				gatherresourceinfo(glo, page, subrsrc, show);
 		}
 	}
 
-	shade = pdf_dict_gets(rsrc, "Shading");
+	shade = pdf_dict_get(rsrc, PDF_NAME(Shading));
 	if (show & SHADINGS && shade)
 		gathershadings(glo, page, pageref, pageobj, shade);
 
-	pattern = pdf_dict_gets(rsrc, "Pattern");
+	pattern = pdf_dict_get(rsrc, PDF_NAME(Pattern));
 	if (show & PATTERNS && pattern)
 	{
 		int n;
@@ -627,7 +627,7 @@ gatherresourceinfo(globals *glo, int page, pdf_obj *rsrc, int show)
 		for (i = 0; i < n; i++)
 		{
 			pdf_obj *obj = pdf_dict_get_val(pattern, i);
-			subrsrc = pdf_dict_gets(obj, "Resources");
+			subrsrc = pdf_dict_get(obj, PDF_NAME(Resources));
 			if (subrsrc && pdf_objcmp(rsrc, subrsrc))
 				gatherresourceinfo(glo, page, subrsrc, show);
 		}
@@ -649,7 +649,7 @@ gatherpageinfo(globals *glo, int page, int show)
 
 	gatherdimensions(glo, page, pageref, pageobj);
 
-	rsrc = pdf_dict_gets(pageobj, "Resources");
+	rsrc = pdf_dict_get(pageobj, PDF_NAME(Resources));
 	gatherresourceinfo(glo, page, rsrc, show);
 }
 
@@ -27,12 +27,12 @@ static void decimatepages(pdf_document *doc)
 	int num_pages = pdf_count_pages(doc);
 	int page, kidcount;
 
-	oldroot = pdf_dict_gets(pdf_trailer(doc), "Root");
-	pages = pdf_dict_gets(oldroot, "Pages");
+	oldroot = pdf_dict_get(pdf_trailer(doc), PDF_NAME(Root));
+	pages = pdf_dict_get(oldroot, PDF_NAME(Pages));
 
 	root = pdf_new_dict(doc, 2);
-	pdf_dict_puts(root, "Type", pdf_dict_gets(oldroot, "Type"));
-	pdf_dict_puts(root, "Pages", pdf_dict_gets(oldroot, "Pages"));
+	pdf_dict_put(root, PDF_NAME(Type), pdf_dict_get(oldroot, PDF_NAME(Type)));
+	pdf_dict_put(root, PDF_NAME(Pages), pdf_dict_get(oldroot, PDF_NAME(Pages)));
 
 	pdf_update_object(doc, pdf_to_num(oldroot), root);
 
@@ -95,8 +95,8 @@ static void decimatepages(pdf_document *doc)
 				pdf_array_push(newmediabox, pdf_new_real(doc, mb.x1));
 				pdf_array_push(newmediabox, pdf_new_real(doc, mb.y1));
 
-				pdf_dict_puts(newpageobj, "Parent", parent);
-				pdf_dict_puts(newpageobj, "MediaBox", newmediabox);
+				pdf_dict_put(newpageobj, PDF_NAME(Parent), parent);
+				pdf_dict_put(newpageobj, PDF_NAME(MediaBox), newmediabox);
 
 				/* Store page object in new kids array */
 				pdf_array_push(kids, newpageref);
@@ -109,8 +109,8 @@ static void decimatepages(pdf_document *doc)
 	pdf_drop_obj(parent);
 
 	/* Update page count and kids array */
-	pdf_dict_puts(pages, "Count", pdf_new_int(doc, kidcount));
-	pdf_dict_puts(pages, "Kids", kids);
+	pdf_dict_put(pages, PDF_NAME(Count), pdf_new_int(doc, kidcount));
+	pdf_dict_put(pages, PDF_NAME(Kids), kids);
 	pdf_drop_obj(kids);
 }
 
@@ -11,28 +11,53 @@
 #define ZIP64_END_OF_CENTRAL_DIRECTORY_SIG 0x06064b50
 #define ZIP64_EXTRA_FIELD_SIG 0x0001
 
+/* SumatraPDF: don't keep more than this many bytes of unused prefetched parts */
+#define MAX_PREFETCHED_SIZE (32 << 20)
+
 static void xps_init_document(xps_document *doc);
 
-xps_part *
-xps_new_part(xps_document *doc, char *name, int size)
+/* SumatraPDF: parts may be read with a different context than doc->ctx */
+static xps_part *
+xps_new_part_ctx(fz_context *ctx, char *name, int size)
 {
 	xps_part *part;
 
-	part = fz_malloc(doc->ctx, sizeof(xps_part));
-	part->name = fz_strdup(doc->ctx, name);
-	part->size = size;
-	part->data = fz_malloc(doc->ctx, size + 1);
-	part->data[size] = 0; /* null-terminate for xml parser */
+	part = fz_malloc_struct(ctx, xps_part);
+	fz_try(ctx)
+	{
+		part->name = fz_strdup(ctx, name);
+		part->size = size;
+		part->data = fz_malloc(ctx, size + 1);
+		part->data[size] = 0; /* null-terminate for xml parser */
+	}
+	fz_catch(ctx)
+	{
+		fz_free(ctx, part->name);
+		fz_free(ctx, part);
+		fz_rethrow(ctx);
+	}
 
 	return part;
 }
 
+static void
+xps_free_part_ctx(fz_context *ctx, xps_part *part)
+{
+	fz_free(ctx, part->name);
+	fz_free(ctx, part->data);
+	fz_free(ctx, part);
+}
+
+xps_part *
+xps_new_part(xps_document *doc, char *name, int size)
+{
+	return xps_new_part_ctx(doc->ctx, name, size);
+}
+
 void
 xps_free_part(xps_document *doc, xps_part *part)
 {
-	fz_free(doc->ctx, part->name);
-	fz_free(doc->ctx, part->data);
-	fz_free(doc->ctx, part);
+	xps_free_part_ctx(doc->ctx, part);
 }
 
 static inline int getshort(fz_stream *file)
@@ -58,55 +83,188 @@ static inline int getlong64(fz_stream *file)
 	return b != 0 ? -1 : a;
 }
 
+static inline int getshort_mem(unsigned char *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static inline int getlong_mem(unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+}
+
 static void *
-xps_zip_alloc_items(xps_document *doc, int items, int size)
+xps_zip_alloc_items(fz_context *ctx, int items, int size)
 {
-	return fz_malloc_array(doc->ctx, items, size);
+	return fz_malloc_array(ctx, items, size);
 }
 
 static void
-xps_zip_free(xps_document *doc, void *ptr)
+xps_zip_free(fz_context *ctx, void *ptr)
 {
-	fz_free(doc->ctx, ptr);
+	fz_free(ctx, ptr);
 }
 
-static int
-xps_compare_entries(const void *a0, const void *b0)
+/*
+ * SumatraPDF: look up zip entries through a hash table instead of
+ * binary searching a sorted table, as large XPS documents may easily
+ * contain tens of thousands of parts and pieces.
+ */
+
+static inline int xps_tolower(int c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c + 32;
+	return c;
+}
+
+static unsigned int
+xps_hash_name(char *name)
+{
+	/* case-insensitive FNV-1a (cf. xps_strcasecmp) */
+	unsigned int h = 2166136261U;
+	for (; *name; name++)
+		h = (h ^ (unsigned char)xps_tolower(*name)) * 16777619U;
+	return h;
+}
+
+static void
+xps_build_zip_hash(xps_document *doc)
 {
-	xps_entry *a = (xps_entry*) a0;
-	xps_entry *b = (xps_entry*) b0;
-	return xps_strcasecmp(a->name, b->name);
+	int i, size = 16;
+	unsigned int h;
+
+	while (size < doc->zip_count * 2)
+		size *= 2;
+	doc->zip_hash = fz_malloc_array(doc->ctx, size, sizeof(int));
+	memset(doc->zip_hash, 0, size * sizeof(int));
+	doc->zip_hash_size = size;
+
+	for (i = 0; i < doc->zip_count; i++)
+	{
+		/* the first of several entries with the same name wins */
+		for (h = xps_hash_name(doc->zip_table[i].name) & (size - 1); doc->zip_hash[h]; h = (h + 1) & (size - 1))
+		{
+			if (!xps_strcasecmp(doc->zip_table[i].name, doc->zip_table[doc->zip_hash[h] - 1].name))
+				break;
+		}
+		if (!doc->zip_hash[h])
+			doc->zip_hash[h] = i + 1;
+	}
 }
 
 static xps_entry *
 xps_lookup_zip_entry(xps_document *doc, char *name)
 {
-	int l = 0;
-	int r = doc->zip_count - 1;
-	while (l <= r)
+	unsigned int h, mask = doc->zip_hash_size - 1;
+
+	if (!doc->zip_hash)
+		return NULL;
+
+	for (h = xps_hash_name(name) & mask; doc->zip_hash[h]; h = (h + 1) & mask)
 	{
-		int m = (l + r) >> 1;
-		int c = xps_strcasecmp(name, doc->zip_table[m].name);
-		if (c < 0)
-			r = m - 1;
-		else if (c > 0)
-			l = m + 1;
-		else
-			return &doc->zip_table[m];
+		xps_entry *ent = &doc->zip_table[doc->zip_hash[h] - 1];
+		if (!xps_strcasecmp(name, ent->name))
+			return ent;
 	}
 	return NULL;
 }
 
 static void
-xps_read_zip_entry(xps_document *doc, xps_entry *ent, unsigned char *outbuf)
+xps_inflate_zip_entry(fz_context *ctx, unsigned char *inbuf, int inlen, unsigned char *outbuf, int outlen)
 {
 	z_stream stream;
+	int code;
+
+	memset(&stream, 0, sizeof(z_stream));
+	stream.zalloc = (alloc_func) xps_zip_alloc_items;
+	stream.zfree = (free_func) xps_zip_free;
+	stream.opaque = ctx;
+	stream.next_in = inbuf;
+	stream.avail_in = inlen;
+	stream.next_out = outbuf;
+	stream.avail_out = outlen;
+
+	code = inflateInit2(&stream, -15);
+	if (code != Z_OK)
+	{
+		fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflateInit2 error: %s", stream.msg);
+	}
+	code = inflate(&stream, Z_FINISH);
+	if (code != Z_STREAM_END)
+	{
+		inflateEnd(&stream);
+		fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflate error: %s", stream.msg);
+	}
+	code = inflateEnd(&stream);
+	if (code != Z_OK)
+	{
+		fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflateEnd error: %s", stream.msg);
+	}
+
+	if (stream.avail_out > 0)
+	{
+		fz_warn(ctx, "Truncated zipfile entry found, possibly corrupt data");
+		memset(stream.next_out, 0, stream.avail_out);
+	}
+}
+
+/*
+ * SumatraPDF: for documents loaded into memory (or mapped), read entries
+ * straight from doc->zip_data without copying compressed data around
+ * and without touching doc->file (so that this is safe to call from
+ * several threads at once, cf. xps_run_prefetch_job).
+ */
+static void
+xps_read_zip_entry_mem(fz_context *ctx, xps_document *doc, xps_entry *ent, unsigned char *outbuf)
+{
+	unsigned char *p;
+	int sig, method, avail;
+
+	if (ent->offset > doc->zip_data_len - 30)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "zip local file header out of range");
+	p = doc->zip_data + ent->offset;
+
+	sig = getlong_mem(p);
+	if (sig != ZIP_LOCAL_FILE_SIG)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "wrong zip local file signature (0x%x)", sig);
+	method = getshort_mem(p + 8);
+	avail = doc->zip_data_len - ent->offset - 30 - getshort_mem(p + 26) - getshort_mem(p + 28);
+	p += 30 + getshort_mem(p + 26) + getshort_mem(p + 28);
+
+	if (method == 0)
+	{
+		avail = fz_maxi(0, fz_mini(avail, ent->usize));
+		memcpy(outbuf, p, avail);
+		if (avail < ent->usize)
+		{
+			fz_warn(ctx, "Truncated zipfile entry found, possibly corrupt data");
+			memset(outbuf + avail, 0, ent->usize - avail);
+		}
+	}
+	else if (method == 8)
+	{
+		xps_inflate_zip_entry(ctx, p, fz_maxi(0, fz_mini(avail, ent->csize)), outbuf, ent->usize);
+	}
+	else
+	{
+		fz_throw(ctx, FZ_ERROR_GENERIC, "unknown compression method (%d)", method);
+	}
+}
+
+static void
+xps_read_zip_entry(fz_context *ctx, xps_document *doc, xps_entry *ent, unsigned char *outbuf)
+{
 	unsigned char *inbuf;
 	int sig;
 	int method;
 	int namelength, extralength;
-	int code;
-	fz_context *ctx = doc->ctx;
+
+	if (doc->zip_data)
+	{
+		xps_read_zip_entry_mem(ctx, doc, ent, outbuf);
+		return;
+	}
 
 	fz_seek(doc->file, ent->offset, 0);
 
@@ -137,43 +295,18 @@ xps_read_zip_entry(xps_document *doc, xps_entry *ent, unsigned char *outbuf)
 	{
 		inbuf = fz_malloc(ctx, ent->csize);
 
-		fz_read(doc->file, inbuf, ent->csize);
-
-		memset(&stream, 0, sizeof(z_stream));
-		stream.zalloc = (alloc_func) xps_zip_alloc_items;
-		stream.zfree = (free_func) xps_zip_free;
-		stream.opaque = doc;
-		stream.next_in = inbuf;
-		stream.avail_in = ent->csize;
-		stream.next_out = outbuf;
-		stream.avail_out = ent->usize;
-
-		code = inflateInit2(&stream, -15);
-		if (code != Z_OK)
+		fz_try(ctx)
 		{
-			fz_free(ctx, inbuf);
-			fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflateInit2 error: %s", stream.msg);
+			fz_read(doc->file, inbuf, ent->csize);
+			xps_inflate_zip_entry(ctx, inbuf, ent->csize, outbuf, ent->usize);
 		}
-		code = inflate(&stream, Z_FINISH);
-		if (code != Z_STREAM_END)
+		fz_always(ctx)
 		{
-			inflateEnd(&stream);
 			fz_free(ctx, inbuf);
-			fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflate error: %s", stream.msg);
 		}
-		code = inflateEnd(&stream);
-		if (code != Z_OK)
+		fz_catch(ctx)
 		{
-			fz_free(ctx, inbuf);
-			fz_throw(ctx, FZ_ERROR_GENERIC, "zlib inflateEnd error: %s", stream.msg);
-		}
-
-		fz_free(ctx, inbuf);
-
-		if (stream.avail_out > 0)
-		{
-			fz_warn(ctx, "Truncated zipfile entry found, possibly corrupt data");
-			memset(stream.next_out, 0, stream.avail_out);
+			fz_rethrow(ctx);
 		}
 	}
 	else
@@ -294,7 +427,7 @@ xps_read_zip_dir(xps_document *doc, int start_offset)
 		fz_seek(doc->file, commentsize, 1);
 	}
 
-	qsort(doc->zip_table, count, sizeof(xps_entry), xps_compare_entries);
+	xps_build_zip_hash(doc);
 }
 
 static void
@@ -333,15 +466,45 @@ xps_find_and_read_zip_dir(xps_document *doc)
 /*
  * Read and interleave split parts from a ZIP file.
  */
+
+/* SumatraPDF: returns the number of pieces of a split part (or 0 if there are none) */
+static int
+xps_count_zip_pieces(xps_document *doc, char *name, int *size)
+{
+	char buf[2048];
+	xps_entry *ent;
+	int count = 0;
+	int seen_last = 0;
+
+	*size = 0;
+	while (!seen_last)
+	{
+		sprintf(buf, "%s/[%d].piece", name, count);
+		ent = xps_lookup_zip_entry(doc, buf);
+		if (!ent)
+		{
+			sprintf(buf, "%s/[%d].last.piece", name, count);
+			ent = xps_lookup_zip_entry(doc, buf);
+			seen_last = (ent != NULL);
+		}
+		if (!ent)
+			break;
+		count ++;
+		*size += ent->usize;
+	}
+	if (!seen_last)
+		return count ? -1 : 0;
+	return count;
+}
+
 static xps_part *
-xps_read_zip_part(xps_document *doc, char *partname)
+xps_read_zip_part_ctx(fz_context *ctx, xps_document *doc, char *partname)
 {
 	char buf[2048];
 	xps_entry *ent;
 	xps_part *part;
 	int count, size, offset, i;
 	char *name;
-	int seen_last = 0;
 
 	name = partname;
 	if (name[0] == '/')
@@ -351,44 +514,28 @@ xps_read_zip_part(xps_document *doc, char *partname)
 	ent = xps_lookup_zip_entry(doc, name);
 	if (ent)
 	{
-		part = xps_new_part(doc, partname, ent->usize);
-		fz_try(doc->ctx)
+		part = xps_new_part_ctx(ctx, partname, ent->usize);
+		fz_try(ctx)
 		{
-			xps_read_zip_entry(doc, ent, part->data);
+			xps_read_zip_entry(ctx, doc, ent, part->data);
 		}
-		fz_catch(doc->ctx)
+		fz_catch(ctx)
 		{
-			xps_free_part(doc, part);
-			fz_rethrow(doc->ctx);
+			xps_free_part_ctx(ctx, part);
+			fz_rethrow(ctx);
 		}
 		return part;
 	}
 
 	/* Count the number of pieces and their total size */
-	count = 0;
-	size = 0;
-	while (!seen_last)
-	{
-		sprintf(buf, "%s/[%d].piece", name, count);
-		ent = xps_lookup_zip_entry(doc, buf);
-		if (!ent)
-		{
-			sprintf(buf, "%s/[%d].last.piece", name, count);
-			ent = xps_lookup_zip_entry(doc, buf);
-			seen_last = (ent != NULL);
-		}
-		if (!ent)
-			break;
-		count ++;
-		size += ent->usize;
-	}
-	if (!seen_last)
-		fz_throw(doc->ctx, FZ_ERROR_GENERIC, "cannot find all pieces for part '%s'", partname);
+	count = xps_count_zip_pieces(doc, name, &size);
+	if (count < 0)
+		fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find all pieces for part '%s'", partname);
 
 	/* Inflate the pieces */
 	if (count)
 	{
-		part = xps_new_part(doc, partname, size);
+		part = xps_new_part_ctx(ctx, partname, size);
 		offset = 0;
 		for (i = 0; i < count; i++)
 		{
@@ -397,21 +544,27 @@ xps_read_zip_part(xps_document *doc, char *partname)
 			else
 				sprintf(buf, "%s/[%d].last.piece", name, i);
 			ent = xps_lookup_zip_entry(doc, buf);
-			fz_try(doc->ctx)
+			fz_try(ctx)
 			{
-				xps_read_zip_entry(doc, ent, part->data + offset);
+				xps_read_zip_entry(ctx, doc, ent, part->data + offset);
 			}
-			fz_catch(doc->ctx)
+			fz_catch(ctx)
 			{
-				xps_free_part(doc, part);
-				fz_rethrow(doc->ctx);
+				xps_free_part_ctx(ctx, part);
+				fz_rethrow(ctx);
 			}
 			offset += ent->usize;
 		}
 		return part;
 	}
 
-	fz_throw(doc->ctx, FZ_ERROR_GENERIC, "cannot find part '%s'", partname);
+	fz_throw(ctx, FZ_ERROR_GENERIC, "cannot find part '%s'", partname);
+}
+
+static xps_part *
+xps_read_zip_part(xps_document *doc, char *partname)
+{
+	return xps_read_zip_part_ctx(doc->ctx, doc, partname);
 }
 
 static int
@@ -540,11 +693,231 @@ xps_has_dir_part(xps_document *doc, char *name)
 	return 0;
 }
 
+/*
+ * SumatraPDF: collect the parts a page refers to (fonts, images and remote
+ * resource dictionaries), so that they can be inflated in parallel before
+ * the page is run for the first time.
+ */
+
+typedef struct xps_prefetch_list_s
+{
+	xps_prefetch_job *jobs;
+	int count, cap;
+	int len, max_len;
+	char base_uri[1024];
+} xps_prefetch_list;
+
+static int
+xps_has_cached_font(xps_document *doc, char *partname)
+{
+	/* fonts are cached by part name with an optional "#Style" suffix (cf. xps_parse_glyphs) */
+	xps_font_cache *cache;
+	char *a, *b;
+	for (cache = doc->font_table; cache; cache = cache->next)
+	{
+		for (a = cache->name, b = partname; *a && xps_tolower(*a) == xps_tolower(*b); a++, b++);
+		if (!*b && (!*a || *a == '#'))
+			return 1;
+	}
+	return 0;
+}
+
+static int
+xps_is_prefetched(xps_document *doc, xps_prefetch_list *list, char *partname)
+{
+	xps_part *part;
+	int i;
+	for (i = 0; i < list->count; i++)
+		if (!strcmp(list->jobs[i].name, partname))
+			return 1;
+	for (part = doc->prefetched; part; part = part->next)
+		if (!strcmp(part->name, partname))
+			return 1;
+	return 0;
+}
+
+static void
+xps_add_prefetch_job(xps_document *doc, xps_prefetch_list *list, char *uri, int is_font)
+{
+	char partname[1024];
+	xps_entry *ent;
+	char *name, *p;
+	int size;
+
+	if (!uri)
+		return;
+
+	xps_resolve_url(partname, list->base_uri, uri, sizeof partname);
+	if (is_font)
+	{
+		/* strip the subfont index */
+		p = strrchr(partname, '#');
+		if (p)
+			*p = 0;
+		if (xps_has_cached_font(doc, partname))
+			return;
+	}
+	if (xps_is_prefetched(doc, list, partname))
+		return;
+
+	name = partname[0] == '/' ? partname + 1 : partname;
+	ent = xps_lookup_zip_entry(doc, name);
+	if (ent)
+		size = ent->usize;
+	else if (xps_count_zip_pieces(doc, name, &size) <= 0)
+		return;
+
+	if (list->count == list->cap)
+	{
+		list->cap = list->cap ? list->cap * 2 : 16;
+		list->jobs = fz_resize_array(doc->ctx, list->jobs, list->cap, sizeof(xps_prefetch_job));
+	}
+	list->jobs[list->count].name = fz_strdup(doc->ctx, partname);
+	list->jobs[list->count].part = NULL;
+	list->count++;
+	list->len += size;
+}
+
+static void
+xps_add_image_prefetch_job(xps_document *doc, xps_prefetch_list *list, char *image_source_att)
+{
+	char buf[1024];
+	char *p;
+
+	if (!image_source_att)
+		return;
+
+	/* "{ColorConvertedBitmap /Resources/Image.tiff /Resources/Profile.icc}" */
+	if (strstr(image_source_att, "{ColorConvertedBitmap") == image_source_att)
+	{
+		p = strchr(image_source_att, ' ');
+		if (!p)
+			return;
+		fz_strlcpy(buf, p + 1, sizeof buf);
+		p = strchr(buf, ' ');
+		if (p)
+			*p = 0;
+		image_source_att = buf;
+	}
+
+	xps_add_prefetch_job(doc, list, image_source_att, 0);
+}
+
+static void
+xps_collect_prefetch_jobs(xps_document *doc, xps_prefetch_list *list, fz_xml *node)
+{
+	for (; node && list->len < list->max_len; node = fz_xml_next(node))
+	{
+		if (!strcmp(fz_xml_tag(node), "Glyphs"))
+			xps_add_prefetch_job(doc, list, fz_xml_att(node, "FontUri"), 1);
+		else if (!strcmp(fz_xml_tag(node), "ImageBrush"))
+			xps_add_image_prefetch_job(doc, list, fz_xml_att(node, "ImageSource"));
+		else if (!strcmp(fz_xml_tag(node), "ResourceDictionary"))
+			xps_add_prefetch_job(doc, list, fz_xml_att(node, "Source"), 0);
+		xps_collect_prefetch_jobs(doc, list, fz_xml_down(node));
+	}
+}
+
+xps_prefetch_job *
+xps_new_prefetch_jobs(xps_document *doc, xps_page *page, int max_len, int *count)
+{
+	xps_prefetch_list list = { 0 };
+	char *s;
+
+	*count = 0;
+	if (!doc->zip_data || !page->root)
+		return NULL;
+
+	list.max_len = max_len;
+	fz_strlcpy(list.base_uri, page->name, sizeof list.base_uri);
+	s = strrchr(list.base_uri, '/');
+	if (s)
+		s[1] = 0;
+
+	fz_try(doc->ctx)
+	{
+		xps_collect_prefetch_jobs(doc, &list, page->root);
+	}
+	fz_catch(doc->ctx)
+	{
+		xps_finish_prefetch_jobs(doc, list.jobs, list.count);
+		fz_rethrow(doc->ctx);
+	}
+
+	*count = list.count;
+	return list.jobs;
+}
+
+void
+xps_run_prefetch_job(fz_context *ctx, xps_document *doc, xps_prefetch_job *job)
+{
+	fz_try(ctx)
+	{
+		job->part = xps_read_zip_part_ctx(ctx, doc, job->name);
+	}
+	fz_catch(ctx)
+	{
+		/* the part will be read (and the error reported) again when it's needed */
+		job->part = NULL;
+	}
+}
+
+void
+xps_finish_prefetch_jobs(xps_document *doc, xps_prefetch_job *jobs, int count)
+{
+	xps_part **last, *part;
+	int i;
+
+	/* keep the list in order, so that the oldest unused parts are dropped first */
+	for (last = &doc->prefetched; *last; last = &(*last)->next);
+	for (i = 0; i < count; i++)
+	{
+		if (jobs[i].part)
+		{
+			*last = jobs[i].part;
+			last = &jobs[i].part->next;
+			doc->prefetched_size += jobs[i].part->size;
+		}
+		fz_free(doc->ctx, jobs[i].name);
+	}
+	fz_free(doc->ctx, jobs);
+
+	while (doc->prefetched && doc->prefetched_size > MAX_PREFETCHED_SIZE)
+	{
+		part = doc->prefetched;
+		doc->prefetched = part->next;
+		doc->prefetched_size -= part->size;
+		xps_free_part(doc, part);
+	}
+}
+
+static xps_part *
+xps_take_prefetched_part(xps_document *doc, char *partname)
+{
+	xps_part **prev, *part;
+	for (prev = &doc->prefetched; (part = *prev) != NULL; prev = &part->next)
+	{
+		if (!strcmp(part->name, partname))
+		{
+			*prev = part->next;
+			part->next = NULL;
+			doc->prefetched_size -= part->size;
+			return part;
+		}
+	}
+	return NULL;
+}
+
 xps_part *
 xps_read_part(xps_document *doc, char *partname)
 {
+	xps_part *part;
 	if (doc->directory)
 		return xps_read_dir_part(doc, partname);
+	/* SumatraPDF: use parts inflated ahead of time */
+	part = xps_take_prefetched_part(doc, partname);
+	if (part)
+		return part;
 	return xps_read_zip_part(doc, partname);
 }
 
@@ -592,6 +965,13 @@ xps_open_document_with_stream(fz_context *ctx, fz_stream *file)
 	fz_try(ctx)
 	{
 		xps_find_and_read_zip_dir(doc);
+		/* SumatraPDF: read parts straight from memory, if the whole file is available there */
+		if (fz_stream_meta(file, FZ_STREAM_META_MEMORY, 0, NULL) > 0)
+		{
+			fz_seek(file, 0, 0);
+			doc->zip_data = file->rp;
+			doc->zip_data_len = file->wp - file->rp;
+		}
 		xps_read_page_list(doc);
 	}
 	fz_catch(ctx)
@@ -655,6 +1035,14 @@ xps_close_document(xps_document *doc)
 	for (i = 0; i < doc->zip_count; i++)
 		fz_free(doc->ctx, doc->zip_table[i].name);
 	fz_free(doc->ctx, doc->zip_table);
+	fz_free(doc->ctx, doc->zip_hash);
+
+	while (doc->prefetched)
+	{
+		xps_part *part = doc->prefetched;
+		doc->prefetched = part->next;
+		xps_free_part(doc, part);
+	}
 
 	font = doc->font_table;
 	while (font)
@@ -118,8 +118,13 @@ solution "all_tests"
       "src/AppUtil*",
       "src/UnitTests.cpp",
       "src/mui/SvgPath*",
+      "src/SyncTexIndex*",
+      "ext/synctex/synctex_parser.c",
+      "ext/synctex/synctex_parser_utils.c",
+      "ext/zlib/*.c",
+      "mupdf/source/fitz/crypt-aes.c",
       "tools/tests/UnitMain.cpp"
     }
-    includedirs { "src/utils", "src/utils/msvc" }
+    includedirs { "src/utils", "src/utils/msvc", "mupdf/include", "ext/synctex", "ext/zlib" }
     links { "gdiplus", "comctl32", "shlwapi", "Version" }
 
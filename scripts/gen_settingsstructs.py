@@ -191,6 +191,9 @@ EbookUI = [
 	Field("UseFixedPageUI", Bool, False,
 		"if true, the UI used for PDF documents will be used for ebooks as well " +
 		"(enables printing and searching, disables automatic reflow)"),
+	Field("ImageCacheSize", Int, 32,
+		"maximum size (in MB) of image data kept in memory per EPUB document. " +
+		"0 disables caching", version="2.5"),
 ]
 
 ComicBookUI = [
@@ -379,6 +382,10 @@ GlobalPrefs = [
 		"actual resolution of the main screen in DPI (if this value " +
 		" isn't positive, the system's UI setting is used)",
 		expert=True, version="2.5"),
+	Field("WarmUpPdfObjectStreams", Bool, False,
+		"if true, compressed objects of PDF documents are decoded in the background " +
+		"right after loading, which makes navigating faster at the cost of memory and CPU time",
+		expert=True, version="2.5"),
 	Struct("AnnotationDefaults", AnnotationDefaults,
 		"default values for user added annotations in FixedPageUI documents " +
 		"(preliminary and still subject to change)",
@@ -0,0 +1,157 @@
+"""
+Generates a synthetic .pdfsync file of a given size (in MB, default 8)
+next to a matching PDF document and times how long SumatraPDF takes for
+rebuilding its index (the "sync" phase of -bench), e.g.
+
+pdfsync-benchmark.py -size 16 pdfsyncbench.pdf
+pdfsync-benchmark.py obj-dbg\SumatraPDF.exe -size 4 -shuffle -json new.json pdfsyncbench.pdf
+
+-shuffle declares records out of order (pdfsync.sty numbers them in order)
+-generate only writes the files without running the benchmark
+
+Note: If SumatraPDF.exe can't be found in either ..\obj-rel\ or %PATH%,
+      pass a path to it as the first argument.
+"""
+
+import os, sys, json, random, tempfile
+from subprocess import Popen, PIPE
+
+# pdfsync coordinates are in scaled points (1/65536 pt, i.e. 65781.76 per bp)
+SP_PER_BP = 65781.76
+PAGE_WIDTH, PAGE_HEIGHT = 612, 792
+POINTS_PER_LINE = 3
+
+def log(str):
+	sys.stderr.write(str + "\n")
+
+def popOption(args, name, default=None):
+	if name in args:
+		ix = args.index(name)
+		value = args[ix + 1]
+		del args[ix:ix + 2]
+		return value
+	return default
+
+def popFlag(args, name):
+	if name in args:
+		args.remove(name)
+		return True
+	return False
+
+def writePdf(path, pageCount):
+	objects = ["<< /Type /Catalog /Pages 2 0 R >>", None, "<< /Length 0 >>\nstream\n\nendstream"]
+	kids = []
+	for i in range(pageCount):
+		objects.append("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %d %d] /Contents 3 0 R >>" % (PAGE_WIDTH, PAGE_HEIGHT))
+		kids.append("%d 0 R" % len(objects))
+	objects[1] = "<< /Type /Pages /Kids [%s] /Count %d >>" % (" ".join(kids), pageCount)
+
+	pdf = "%PDF-1.4\n"
+	offsets = []
+	for i, obj in enumerate(objects):
+		offsets.append(len(pdf))
+		pdf += "%d 0 obj\n%s\nendobj\n" % (i + 1, obj)
+	startxref = len(pdf)
+	pdf += "xref\n0 %d\n0000000000 65535 f \n" % (len(objects) + 1)
+	for ofs in offsets:
+		pdf += "%010d 00000 n \n" % ofs
+	pdf += "trailer\n<< /Size %d /Root 1 0 R >>\nstartxref\n%d\n%%%%EOF\n" % (len(objects) + 1, startxref)
+	open(path, "wb").write(pdf.encode("latin-1"))
+
+# writes about <size> bytes of 'l' and 'p' lines for a few included files,
+# spread over <pageCount> sheets; returns the number of records
+def writePdfsync(path, jobName, size, pageCount, shuffle):
+	rnd = random.Random(42)
+	out = open(path, "wb")
+	def emit(line):
+		out.write((line + "\n").encode("latin-1"))
+
+	emit(jobName)
+	emit("version 1")
+	# an 'l' line and its 'p' lines take about 90 bytes
+	recordCount = size // 90 + 1
+	records = list(range(recordCount))
+	if shuffle:
+		rnd.shuffle(records)
+	recordsPerPage = recordCount // pageCount + 1
+	srcLine, page, inChapter = 1, 0, False
+	for ix, record in enumerate(records):
+		if ix % recordsPerPage == 0:
+			page += 1
+			# every ten pages (after the first ten), switch to the next chapter file
+			if page % 10 == 1 and page > 1:
+				if inChapter:
+					emit(")")
+				emit("(chapter%d.tex" % (page // 10))
+				inChapter, srcLine = True, 1
+			emit("s %d" % page)
+		srcLine += rnd.randint(0, 2)
+		if rnd.random() < 0.5:
+			emit("l %d %d" % (record, srcLine))
+		else:
+			emit("l %d %d %d" % (record, srcLine, rnd.randint(0, 80)))
+		y = int((PAGE_HEIGHT - 72 - (ix % recordsPerPage) * (PAGE_HEIGHT - 144) // recordsPerPage) * SP_PER_BP)
+		for i in range(POINTS_PER_LINE):
+			x = int(rnd.randint(72, PAGE_WIDTH - 72) * SP_PER_BP)
+			emit("p%s %d %d %d" % (i == 0 and "*" or "", record, x, y))
+	if inChapter:
+		emit(")")
+	out.close()
+	return recordCount
+
+def runBenchmark(exe, pdfPath, repeats, jsonPath):
+	args = ["-bench-json", jsonPath]
+	for i in range(repeats):
+		args += ["-bench", pdfPath, "loadonly"]
+	proc = Popen([exe] + args, stdout=PIPE, stderr=PIPE)
+	proc.communicate()
+	return json.load(open(jsonPath))
+
+def main():
+	args = sys.argv[1:]
+	if not args:
+		log("Usage: %s [<SumatraPDF.exe>] [-size <MB>] [-pages <count>] [-shuffle] [-generate] [-json <path>] <file.pdf>" % (os.path.split(sys.argv[0])[1]))
+		sys.exit(0)
+
+	size = float(popOption(args, "-size", "8"))
+	pageCount = int(popOption(args, "-pages", "200"))
+	shuffle = popFlag(args, "-shuffle")
+	generateOnly = popFlag(args, "-generate")
+	jsonPath = popOption(args, "-json")
+
+	if args[0].lower().endswith(".exe"):
+		exe = args.pop(0)
+	else:
+		exe = os.path.join(os.path.dirname(__file__), "..", "obj-rel", "SumatraPDF.exe")
+		if not os.path.exists(exe):
+			exe = "SumatraPDF.exe"
+
+	pdfPath = args[0]
+	base = os.path.splitext(pdfPath)[0]
+	writePdf(pdfPath, pageCount)
+	records = writePdfsync(base + ".pdfsync", os.path.basename(base), int(size * 1024 * 1024), pageCount, shuffle)
+	log("Generated %s.pdfsync (%.1f MB, %d records, %d pages)" % (base, os.path.getsize(base + ".pdfsync") / 1048576.0, records, pageCount))
+	if generateOnly:
+		return
+
+	outPath = jsonPath or os.path.join(tempfile.gettempdir(), "pdfsync-benchmark.json")
+	log("Running benchmark with %s..." % os.path.relpath(exe))
+	try:
+		result = runBenchmark(exe, pdfPath, 10, outPath)
+	except (OSError, IOError, ValueError):
+		log("Error: failed to run %s" % os.path.relpath(exe))
+		return
+	finally:
+		if not jsonPath and os.path.exists(outPath):
+			os.remove(outPath)
+
+	phase = result["phases"].get("sync")
+	if not phase:
+		log("Error: no sync timings (%d errors)" % result["errors"])
+		return
+	print("Phase\tCount\tTotal (in ms)\tp50\tp95\tp99\tMax")
+	print("sync\t%d\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f" % (phase["count"], phase["total"], phase["p50"], phase["p95"], phase["p99"], phase["max"]))
+	print("%.1f MB/s (median)" % (os.path.getsize(base + ".pdfsync") / 1048576.0 / max(phase["p50"], 0.001) * 1000))
+
+if __name__ == "__main__":
+	main()
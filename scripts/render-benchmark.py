@@ -1,90 +1,140 @@
 """
 Runs a loading and rendering benchmark for a given number of files
-(10 times each).
+(10 times each) and summarizes the timings of each phase (open, load,
+list, render and text) as percentiles.
 
 Note: If SumatraPDF.exe can't be found in either ..\obj-rel\ or %PATH%,
-      pass a path to it as the first argument.
+      pass a path to it as the first argument (mudraw can be used as well).
 
 render-benchmark.py obj-dbg\SumatraPDF.exe file1.pdf file2.xps
+render-benchmark.py -zoom 100,200 -rotation 0,90 -threads 4 -json new.json file1.pdf
+render-benchmark.py -compare old.json new.json [-threshold 10]
+
+-compare lists the phases whose median (or 95th percentile) got slower
+by more than the threshold (in percent, default 10) and exits with 1 if
+there are any such regressions.
 """
 
-import os, re, sys
+import os, sys, json, tempfile
 from subprocess import Popen, PIPE
 
 def log(str):
 	sys.stderr.write(str + "\n")
 
-def runBenchmark(SumatraPDFExe, file, repeats):
-	log("-> %s (%d times)" % (file, repeats))
-	proc = Popen([SumatraPDFExe] + ["-bench", file] * repeats, stdout=PIPE, stderr=PIPE)
-	return proc.communicate()[1]
-
-def matchLine(line, regex, result=None):
-	match = re.findall(regex, line)
-	if match and type(match[0]) == str:
-		match[0] = (match[0],)
-	if match and result is not None:
-		result.extend(match[0])
-	return match
-
-def parseBenchOutput(output):
-	result = {}
-	current, data = None, []
-	
-	for line in output.replace("\r", "\n").split("\n"):
-		match = []
-		if matchLine(line, r"Starting: (.*)", match):
-			if current or data:
-				log("Ignoring data for failed run for %s" % (current))
-			current, data = match[0], []
-			if not current in result:
-				result[current] = []
-		
-		elif matchLine(line, r"load: (\d+(?:\.\d+)?) ms", match):
-			assert not data
-			data.append(float(match[0]))
-		
-		elif matchLine(line, r"Finished \(in (\d+(?:\.\d+)?) ms\): (.*)", match):
-			assert len(data) == 1
-			data.append(float(match[0]))
-			result[current].append(data)
-			current, data = None, []
-	
-	return result
+def isMudraw(exe):
+	return os.path.splitext(os.path.basename(exe))[0].lower() == "mudraw"
+
+def runBenchmark(exe, files, repeats, zoom, rotation, threads, jsonPath):
+	log("-> %s (%d times)" % (", ".join(files), repeats))
+	if isMudraw(exe):
+		# mudraw expects resolutions instead of zoom levels (100% == 72 dpi)
+		args = ["-J", jsonPath]
+		if zoom:
+			args += ["-r", ",".join(["%g" % (float(z) * 72 / 100) for z in zoom.split(",")])]
+		if rotation:
+			args += ["-R", rotation]
+		args += files * repeats
+	else:
+		args = ["-bench-json", jsonPath, "-n", str(threads)]
+		if zoom:
+			args += ["-bench-zoom", zoom]
+		if rotation:
+			args += ["-bench-rotation", rotation]
+		for file in files * repeats:
+			args += ["-bench", file]
+	proc = Popen([exe] + args, stdout=PIPE, stderr=PIPE)
+	proc.communicate()
+	return json.load(open(jsonPath))
 
 def displayBenchResults(result):
-	print "Filename\tLoad time (in ms)\tRender time (in ms)\tRuns"
-	for (file, data) in result.items():
-		count = len(data)
-		
-		loadMin = min([item[0] for item in data])
-		renderMin = min([item[1] for item in data])
-		
-		print "%(file)s\t%(loadMin).2f\t%(renderMin).2f\t%(count)d" % locals()
+	print("%s: %d pages, %d errors, %d thread(s)" % (result["tool"], result["pages"], result["errors"], result.get("threads", 1)))
+	print("Phase\tCount\tTotal (in ms)\tp50\tp95\tp99\tMax")
+	for (name, phase) in sorted(result["phases"].items()):
+		print("%s\t%d\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f" % (name, phase["count"], phase["total"], phase["p50"], phase["p95"], phase["p99"], phase["max"]))
+	for section in ("memory", "store", "glyph_cache"):
+		if section in result:
+			print("%s\t%s" % (section, ", ".join(["%s: %d" % item for item in sorted(result[section].items())])))
+
+# returns a list of (phase, percentile, old value, new value, change in percent)
+# for all timings that got slower by more than threshold percent
+def compareBenchResults(old, new, threshold):
+	regressions = []
+	for (name, phase) in sorted(new["phases"].items()):
+		if name not in old["phases"]:
+			continue
+		for key in ("p50", "p95"):
+			before, after = old["phases"][name][key], phase[key]
+			# ignore changes below the timers' resolution
+			if before <= 0 or after - before < 0.5:
+				continue
+			change = (after - before) * 100.0 / before
+			if change > threshold:
+				regressions.append((name, key, before, after, change))
+	for (section, key) in (("memory", "peak_rss"), (None, "wall_time")):
+		before = (section and old.get(section, {}) or old).get(key, 0)
+		after = (section and new.get(section, {}) or new).get(key, 0)
+		if before > 0 and (after - before) * 100.0 / before > threshold:
+			regressions.append((section or "total", key, before, after, (after - before) * 100.0 / before))
+	return regressions
+
+def displayComparison(old, new, threshold):
+	print("Phase\tOld p50\tNew p50\tOld p95\tNew p95")
+	for (name, phase) in sorted(new["phases"].items()):
+		if name in old["phases"]:
+			prev = old["phases"][name]
+			print("%s\t%.2f\t%.2f\t%.2f\t%.2f" % (name, prev["p50"], phase["p50"], prev["p95"], phase["p95"]))
+	regressions = compareBenchResults(old, new, threshold)
+	for (name, key, before, after, change) in regressions:
+		print("REGRESSION: %s %s: %.2f -> %.2f (+%.1f%%)" % (name, key, before, after, change))
+	if not regressions:
+		print("No regressions above %g%%" % threshold)
+	return regressions
+
+def popOption(args, name, default=None):
+	if name in args:
+		ix = args.index(name)
+		value = args[ix + 1]
+		del args[ix:ix + 2]
+		return value
+	return default
 
 def main():
-	if not sys.argv[1:]:
-		log("Usage: %s [<SumatraPDF.exe>] <file1.pdf> [<file2.pdf> ...]" % (os.path.split(sys.argv[0])[1]))
+	args = sys.argv[1:]
+	if not args:
+		log("Usage: %s [<SumatraPDF.exe>] [-zoom <list>] [-rotation <list>] [-threads <n>] [-json <path>] <file1.pdf> [<file2.pdf> ...]" % (os.path.split(sys.argv[0])[1]))
+		log("       %s -compare <old.json> <new.json> [-threshold <percent>]" % (os.path.split(sys.argv[0])[1]))
 		sys.exit(0)
-	
-	if sys.argv[1].lower().endswith(".exe"):
-		SumatraPDFExe = sys.argv.pop(1)
+
+	threshold = float(popOption(args, "-threshold", "10"))
+	if args[0] == "-compare":
+		old, new = json.load(open(args[1])), json.load(open(args[2]))
+		sys.exit(displayComparison(old, new, threshold) and 1 or 0)
+
+	zoom = popOption(args, "-zoom")
+	rotation = popOption(args, "-rotation")
+	threads = int(popOption(args, "-threads", "1"))
+	jsonPath = popOption(args, "-json")
+
+	if args[0].lower().endswith(".exe") or isMudraw(args[0]):
+		exe = args.pop(0)
 	else:
-		SumatraPDFExe = os.path.join(os.path.dirname(__file__), "..", "obj-rel", "SumatraPDF.exe")
-		if not os.path.exists(SumatraPDFExe):
-			SumatraPDFExe = "SumatraPDF.exe"
-	
-	benchData = ""
-	log("Running benchmark with %s..." % os.path.relpath(SumatraPDFExe))
-	for file in sys.argv[1:]:
-		try:
-			benchData += runBenchmark(SumatraPDFExe, file, 10) + "\n"
-		except:
-			log("Error: %s not found" % os.path.relpath(SumatraPDFExe))
-			return
+		exe = os.path.join(os.path.dirname(__file__), "..", "obj-rel", "SumatraPDF.exe")
+		if not os.path.exists(exe):
+			exe = "SumatraPDF.exe"
+
+	outPath = jsonPath or os.path.join(tempfile.gettempdir(), "render-benchmark.json")
+	log("Running benchmark with %s..." % os.path.relpath(exe))
+	try:
+		result = runBenchmark(exe, args, 10, zoom, rotation, threads, outPath)
+	except (OSError, IOError, ValueError):
+		log("Error: failed to run %s" % os.path.relpath(exe))
+		return
+	finally:
+		if not jsonPath and os.path.exists(outPath):
+			os.remove(outPath)
 	log("")
-	
-	displayBenchResults(parseBenchOutput(benchData))
+
+	displayBenchResults(result)
 
 if __name__ == "__main__":
 	main()
@@ -16,6 +16,7 @@
 #include "FileTransactions.h"
 #include "FileUtil.h"
 #include "FileWatcher.h"
+#include "PdfEngine.h"
 #include "SumatraPDF.h"
 #include "Translations.h"
 #include "UITask.h"
@@ -269,6 +270,8 @@ bool Load()
     // TODO: verify that all states have a non-NULL file path?
     gFileHistory.UpdateStatesSource(gGlobalPrefs->fileStates);
     SetDefaultEbookFont(gGlobalPrefs->ebookUI.fontName, gGlobalPrefs->ebookUI.fontSize);
+    SetEbookImageCacheSize(gGlobalPrefs->ebookUI.imageCacheSize);
+    EnablePdfObjStmWarmUp(gGlobalPrefs->warmUpPdfObjectStreams);
 
     if (!file::Exists(path))
         Save();
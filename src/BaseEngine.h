@@ -214,6 +214,14 @@ public:
     virtual void Abort() = 0;
 };
 
+// usage of an engine's internal caches (for benchmarking)
+struct EngineCacheStats {
+    size_t storeSize, storeItems;
+    size_t glyphCacheSize, glyphCacheEntries;
+    int storeHits, storeMisses;
+    int glyphCacheHits, glyphCacheMisses;
+};
+
 class BaseEngine {
 public:
     virtual ~BaseEngine() { }
@@ -227,6 +235,10 @@ public:
 
     // the box containing the visible page content (usually RectD(0, 0, pageWidth, pageHeight))
     virtual RectD PageMediabox(int pageNo) = 0;
+    // whether PageMediabox can be called for this page without having to
+    // first parse (parts of) the document (for lazily loaded documents with
+    // many pages, the caller is expected to estimate the page's size instead)
+    virtual bool IsPageMediaboxKnown(int pageNo) { return true; }
     // the box inside PageMediabox that actually contains any relevant content
     // (used for auto-cropping in Fit Content mode, can be PageMediabox)
     virtual RectD PageContentBox(int pageNo, RenderTarget target=Target_View) {
@@ -325,6 +337,12 @@ public:
     // loads the given page so that the time required can be measured
     // without also measuring rendering times
     virtual bool BenchLoadPage(int pageNo) = 0;
+    // prepares the given page for rendering (e.g. by building a display list)
+    // so that the time required can be measured apart from rasterizing
+    virtual bool BenchPreparePage(int pageNo) { return BenchLoadPage(pageNo); }
+    // reports the current usage of the engine's internal caches
+    // (returns false for engines without such caches)
+    virtual bool GetBenchCacheStats(EngineCacheStats *stats) { return false; }
 };
 
 #endif
@@ -145,6 +145,11 @@ void DisplayModel::DisplayStateFromModel(DisplayState *ds)
 SizeD DisplayModel::PageSizeAfterRotation(int pageNo, bool fitToContent)
 {
     PageInfo *pageInfo = GetPageInfo(pageNo);
+    if (pageInfo->estimated) {
+        // don't make the engine determine the page's actual size just yet
+        SizeD size = pageInfo->page.Size();
+        return rotation % 180 == 0 ? size : SizeD(size.dy, size.dx);
+    }
     if (fitToContent && pageInfo->contentBox.IsEmpty()) {
         pageInfo->contentBox = engine->PageContentBox(pageNo);
         if (pageInfo->contentBox.IsEmpty())
@@ -283,12 +288,23 @@ void DisplayModel::BuildPagesInfo()
     int newStartPage = startPage;
     if (DisplayModeShowCover(displayMode) && newStartPage == 1 && columns > 1)
         newStartPage--;
+    RectD lastMeasured = defaultRect;
     for (int pageNo = 1; pageNo <= pageCount; pageNo++) {
         PageInfo *pageInfo = GetPageInfo(pageNo);
-        pageInfo->page = engine->PageMediabox(pageNo);
-        // layout pages with an empty mediabox as A4 size (resp. letter size)
-        if (pageInfo->page.IsEmpty())
-            pageInfo->page = defaultRect;
+        // for documents with many pages, the sizes of pages not yet known
+        // are estimated from the closest preceding page (and then fixed up
+        // in MeasureVisiblePages once these pages become visible)
+        if (pageNo > 1 && !engine->IsPageMediaboxKnown(pageNo)) {
+            pageInfo->page = lastMeasured;
+            pageInfo->estimated = true;
+        }
+        else {
+            pageInfo->page = engine->PageMediabox(pageNo);
+            // layout pages with an empty mediabox as A4 size (resp. letter size)
+            if (pageInfo->page.IsEmpty())
+                pageInfo->page = defaultRect;
+            lastMeasured = pageInfo->page;
+        }
         pageInfo->visibleRatio = 0.0;
         pageInfo->shown = false;
         if (IsContinuous(displayMode))
@@ -763,6 +779,41 @@ void DisplayModel::RecalcVisibleParts()
         pageInfo->pageOnScreen = pageRect;
         pageInfo->pageOnScreen.Offset(-viewPort.x, -viewPort.y);
     }
+
+    MeasureVisiblePages();
+}
+
+/* Replace the estimated sizes of all visible pages with their actual sizes
+   and update the layout without moving the content currently on screen */
+void DisplayModel::MeasureVisiblePages()
+{
+    int anchorPageNo = 0;
+    bool changed = false;
+    for (int pageNo = 1; pageNo <= PageCount(); ++pageNo) {
+        PageInfo *pageInfo = GetPageInfo(pageNo);
+        if (0.0 == pageInfo->visibleRatio)
+            continue;
+        if (!anchorPageNo)
+            anchorPageNo = pageNo;
+        if (!pageInfo->estimated)
+            continue;
+        RectD page = engine->PageMediabox(pageNo);
+        pageInfo->estimated = false;
+        if (!page.IsEmpty() && page != pageInfo->page) {
+            pageInfo->page = page;
+            changed = true;
+        }
+    }
+    if (!changed)
+        return;
+
+    // pages above the first visible one keep their size, so keeping
+    // that page at the same position on screen prevents any jumps
+    int anchorY = GetPageInfo(anchorPageNo)->pageOnScreen.y;
+    Relayout(zoomVirtual, rotation);
+    viewPort.y = limitValue(GetPageInfo(anchorPageNo)->pos.y - anchorY, 0, canvasSize.dy - viewPort.dy);
+    // newly measured pages might have revealed further estimated ones
+    RecalcVisibleParts();
 }
 
 int DisplayModel::GetPageNoByPoint(PointI pt)
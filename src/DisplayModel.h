@@ -19,6 +19,9 @@ extern bool gPredictiveRender;
 struct PageInfo {
     /* data that is constant for a given page. page size in document units */
     RectD           page;
+    /* whether page is only an estimate (to be replaced with the page's actual
+       size once it becomes visible, cf. DisplayModel::MeasureVisiblePages()) */
+    bool            estimated;
 
     /* data that is calculated when needed. actual content size within a page (View target) */
     RectD           contentBox;
@@ -194,6 +197,7 @@ protected:
     PointI          GetContentStart(int pageNo);
     void            SetZoomVirtual(float zoomVirtual);
     void            RecalcVisibleParts();
+    void            MeasureVisiblePages();
     void            RenderVisibleParts();
 
     void            AddNavPoint();
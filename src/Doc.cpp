@@ -231,8 +231,6 @@ WCHAR *Doc::GetProperty(DocumentProperty prop)
 const char *Doc::GetHtmlData(size_t &len)
 {
     switch (type) {
-    case Doc_Epub:
-        return epubDoc->GetTextData(&len);
     case Doc_Fb2:
         return fb2Doc->GetTextData(&len);
     case Doc_Mobi:
@@ -15,6 +15,35 @@ struct ImageData {
     size_t      len;
 };
 
+// documents which don't keep all image data in memory (such as EpubDoc)
+// hand out references to images which are only loaded when drawn
+class ImageDataLoader {
+public:
+    virtual ~ImageDataLoader() { }
+    // returns a newly allocated copy of the data for image imageIdx
+    // (the caller must free it); must be thread-safe
+    virtual char *LoadImageData(size_t imageIdx, size_t *lenOut) = 0;
+};
+
+struct ImageRef {
+    ImageDataLoader *   loader;
+    size_t              idx;
+
+    char *Load(size_t *lenOut) const { return loader->LoadImageData(idx, lenOut); }
+};
+
+// documents which don't keep all of their HTML in memory (such as EpubDoc)
+// hand it out in consecutive sections which are only loaded once the
+// formatter reaches them (reparse indices refer to the sections' concatenation)
+class HtmlSectionLoader {
+public:
+    virtual ~HtmlSectionLoader() { }
+    // returns a newly allocated copy of the first non-empty section ending
+    // after offset idx (the caller must free it) along with its offset
+    // and length or NULL at the end of the text; must be thread-safe
+    virtual char *LoadHtmlSection(size_t idx, size_t *startOut, size_t *lenOut) = 0;
+};
+
 class EbookTocVisitor {
 public:
     virtual void Visit(const WCHAR *name, const WCHAR *url, int level) = 0;
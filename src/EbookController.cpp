@@ -521,7 +521,8 @@ void EbookController::TriggerBookFormatting()
     CrashIf(formattingTemp.pagesFromBeginning.Count() > 0);
     CrashIf(formattingTemp.pagesFromPage.Count() > 0);
     CrashIf(formattingTemp.reparseIdx < 0);
-    CrashIf(formattingTemp.reparseIdx > (int)doc.GetHtmlDataSize());
+    // (for EPUB documents, this measures the whole text once)
+    CrashIf(formattingTemp.reparseIdx > 0 && formattingTemp.reparseIdx > (int)doc.GetHtmlDataSize());
 
     ShowPage(newPage, newPage != NULL);
     HtmlFormatterArgs *args = CreateFormatterArgsDoc2(doc, size.dx, size.dy, &textAllocator);
@@ -688,7 +689,7 @@ void EbookController::SetDoc(Doc newDoc, int startReparseIdxArg)
 {
     CrashIf(!newDoc.IsEbook());
     startReparseIdx = startReparseIdxArg;
-    if ((size_t)startReparseIdx >= newDoc.GetHtmlDataSize())
+    if (startReparseIdx > 0 && (size_t)startReparseIdx >= newDoc.GetHtmlDataSize())
         startReparseIdx = -1;
     CloseCurrentDocument();
     doc = newDoc;
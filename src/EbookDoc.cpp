@@ -5,6 +5,8 @@
 #include "EbookDoc.h"
 
 #include "FileUtil.h"
+using namespace Gdiplus;
+#include "GdiPlusUtil.h"
 #include "HtmlPullParser.h"
 #include "MobiDoc.h"
 #include "PalmDbReader.h"
@@ -223,20 +225,30 @@ const char *EPUB_OPF_NS = "http://www.idpf.org/2007/opf";
 const char *EPUB_NCX_NS = "http://www.daisy.org/z3986/2005/ncx/";
 const char *EPUB_ENC_NS = "http://www.w3.org/2001/04/xmlenc#";
 
+static size_t gImageCacheBudget = EPUB_IMAGE_CACHE_BUDGET;
+
 EpubDoc::EpubDoc(const WCHAR *fileName) :
-    zip(fileName, Zip_Deflate), fileName(str::Dup(fileName)),
-    isNcxToc(false), isRtlDoc(false) { }
+    zip(fileName, Zip_Deflate), cachedSpineSize(0), cachedImagesSize(0),
+    fileName(str::Dup(fileName)), isNcxToc(false), isRtlDoc(false)
+{
+    InitializeCriticalSection(&zipAccess);
+}
 
 EpubDoc::EpubDoc(IStream *stream) :
-    zip(stream, Zip_Deflate), fileName(NULL),
-    isNcxToc(false), isRtlDoc(false) { }
+    zip(stream, Zip_Deflate), cachedSpineSize(0), cachedImagesSize(0),
+    fileName(NULL), isNcxToc(false), isRtlDoc(false)
+{
+    InitializeCriticalSection(&zipAccess);
+}
 
 EpubDoc::~EpubDoc()
 {
+    FreeVecMembers(spineData);
     for (size_t i = 0; i < images.Count(); i++) {
-        free(images.At(i).base.data);
+        free(images.At(i).data);
         free(images.At(i).id);
     }
+    DeleteCriticalSection(&zipAccess);
 }
 
 bool EpubDoc::Load()
@@ -303,7 +315,7 @@ bool EpubDoc::Load()
             if (encList.Contains(imgPath))
                 continue;
             // load the image lazily
-            ImageData2 data = { 0 };
+            EpubImage data = { 0 };
             data.id = str::conv::ToUtf8(imgPath);
             str::UrlDecodeInPlace(imgPath);
             data.idx = zip.GetFileIndex(imgPath);
@@ -353,21 +365,100 @@ bool EpubDoc::Load()
             continue;
 
         ScopedMem<WCHAR> fullPath(str::Join(contentPath, pathList.At(idList.Find(idref))));
-        ScopedMem<char> utf8_path(str::conv::ToUtf8(fullPath));
-        str::UrlDecodeInPlace(fullPath);
-        ScopedMem<char> html(zip.GetFileDataByName(fullPath));
-        if (!html)
+        ScopedMem<WCHAR> zipPath(str::Dup(fullPath));
+        str::UrlDecodeInPlace(zipPath);
+        if (zip.GetFileIndex(zipPath) == (size_t)-1)
             continue;
+        // spine items are decompressed in LoadSpineItem
+        spinePaths.Append(fullPath.StealData());
+        spineData.Append(NULL);
+    }
+    spineOffsets.Append(0);
+
+    return spinePaths.Count() > 0;
+}
+
+// returns a copy of a spine item's HTML (empty for items which fail to load)
+// and records where the following item starts when it's decompressed first
+char *EpubDoc::LoadSpineItem(size_t itemIdx, size_t *lenOut)
+{
+    CrashIf(itemIdx >= spineOffsets.Count());
+    char *data = spineData.At(itemIdx);
+    if (data) {
+        cachedSpineItems.Remove(itemIdx);
+        cachedSpineItems.Append(itemIdx);
+        *lenOut = spineOffsets.At(itemIdx + 1) - spineOffsets.At(itemIdx);
+        return (char *)memdup(data, *lenOut + 1);
+    }
+
+    str::Str<char> section;
+    ScopedMem<WCHAR> zipPath(str::Dup(spinePaths.At(itemIdx)));
+    str::UrlDecodeInPlace(zipPath);
+    ScopedMem<char> html(zip.GetFileDataByName(zipPath));
+    if (html)
         html.Set(DecodeTextToUtf8(html, true));
-        if (!html)
-            continue;
+    if (html) {
         // insert explicit page-breaks between sections including
         // an anchor with the file name at the top (for internal links)
-        htmlData.AppendFmt("<pagebreak page_path=\"%s\" page_marker />", utf8_path);
-        htmlData.Append(html);
+        ScopedMem<char> utf8_path(str::conv::ToUtf8(spinePaths.At(itemIdx)));
+        section.AppendFmt("<pagebreak page_path=\"%s\" page_marker />", utf8_path);
+        section.Append(html);
     }
 
-    return htmlData.Count() > 0;
+    if (itemIdx + 1 == spineOffsets.Count())
+        spineOffsets.Append(spineOffsets.At(itemIdx) + section.Size());
+    // the text must not shift under already formatted pages
+    CrashIf(spineOffsets.At(itemIdx + 1) - spineOffsets.At(itemIdx) != section.Size());
+    *lenOut = section.Size();
+    CacheSpineItem(itemIdx, section.Get(), section.Size());
+    return section.StealData();
+}
+
+// keeps a copy of a spine item's HTML around until it's evicted as one of
+// the least recently used items for exceeding EPUB_TEXT_CACHE_BUDGET
+void EpubDoc::CacheSpineItem(size_t itemIdx, char *data, size_t len)
+{
+    size_t budget = EPUB_TEXT_CACHE_BUDGET;
+    if (len > budget) {
+        TrimSpineCache(budget);
+        return;
+    }
+    TrimSpineCache(budget - len);
+    char *copy = (char *)memdup(data, len + 1);
+    if (!copy)
+        return;
+    spineData.At(itemIdx) = copy;
+    cachedSpineItems.Append(itemIdx);
+    cachedSpineSize += len;
+}
+
+void EpubDoc::TrimSpineCache(size_t maxSize)
+{
+    while (cachedSpineSize > maxSize && cachedSpineItems.Count() > 0) {
+        size_t lru = cachedSpineItems.At(0);
+        cachedSpineSize -= spineOffsets.At(lru + 1) - spineOffsets.At(lru);
+        free(spineData.At(lru));
+        spineData.At(lru) = NULL;
+        cachedSpineItems.RemoveAt(0);
+    }
+}
+
+char *EpubDoc::LoadHtmlSection(size_t idx, size_t *startOut, size_t *lenOut)
+{
+    ScopedCritSec scope(&zipAccess);
+    for (size_t i = 0; i < spinePaths.Count(); i++) {
+        // items are measured in order until the one containing idx is found
+        ScopedMem<char> data;
+        if (i + 1 == spineOffsets.Count())
+            data.Set(LoadSpineItem(i, lenOut));
+        if (idx >= spineOffsets.At(i + 1) || spineOffsets.At(i) == spineOffsets.At(i + 1))
+            continue;
+        *startOut = spineOffsets.At(i);
+        if (data)
+            return data.StealData();
+        return LoadSpineItem(i, lenOut);
+    }
+    return NULL;
 }
 
 void EpubDoc::ParseMetadata(const char *content)
@@ -412,19 +503,22 @@ void EpubDoc::ParseMetadata(const char *content)
     }
 }
 
-const char *EpubDoc::GetTextData(size_t *lenOut)
-{
-    *lenOut = htmlData.Size();
-    return htmlData.Get();
-}
-
+// the text's size is only known once each spine item has been decompressed
+// (which doesn't keep more than EPUB_TEXT_CACHE_BUDGET in memory, though)
 size_t EpubDoc::GetTextDataSize()
 {
-    return htmlData.Size();
+    ScopedCritSec scope(&zipAccess);
+    for (size_t i = spineOffsets.Count() - 1; i < spinePaths.Count(); i++) {
+        size_t len;
+        free(LoadSpineItem(i, &len));
+    }
+    return spineOffsets.Last();
 }
 
-ImageData *EpubDoc::GetImageData(const char *id, const char *pagePath)
+size_t EpubDoc::FindImage(const char *id, const char *pagePath)
 {
+    ScopedCritSec scope(&zipAccess);
+
     if (!pagePath) {
         // if we're reparsing, we might not have pagePath, which is needed to
         // build the exact url so try to find a partial match
@@ -434,15 +528,10 @@ ImageData *EpubDoc::GetImageData(const char *id, const char *pagePath)
         // format specific state such as hiddenDepth and titleCount) and store it
         // in every HtmlPage, but this should work well enough for now
         for (size_t i = 0; i < images.Count(); i++) {
-            ImageData2 *img = &images.At(i);
-            if (str::EndsWithI(img->id, id)) {
-                if (!img->base.data)
-                    img->base.data = zip.GetFileDataByIdx(img->idx, &img->base.len);
-                if (img->base.data)
-                    return &img->base;
-            }
+            if (str::EndsWithI(images.At(i).id, id))
+                return i;
         }
-        return NULL;
+        return (size_t)-1;
     }
 
     ScopedMem<char> url(NormalizeURL(id, pagePath));
@@ -450,30 +539,130 @@ ImageData *EpubDoc::GetImageData(const char *id, const char *pagePath)
     if (str::FindChar(url, '\\'))
         str::TransChars(url, "\\", "/");
     for (size_t i = 0; i < images.Count(); i++) {
-        ImageData2 *img = &images.At(i);
-        if (str::Eq(img->id, url)) {
-            if (!img->base.data)
-                img->base.data = zip.GetFileDataByIdx(img->idx, &img->base.len);
-            if (img->base.data)
-                return &img->base;
-        }
+        if (str::Eq(images.At(i).id, url))
+            return i;
     }
 
     // try to also load images which aren't registered in the manifest
-    ImageData2 data = { 0 };
+    EpubImage data = { 0 };
     ScopedMem<WCHAR> imgPath(str::conv::FromUtf8(url));
     str::UrlDecodeInPlace(imgPath);
     data.idx = zip.GetFileIndex(imgPath);
-    if (data.idx != (size_t)-1) {
-        data.base.data = zip.GetFileDataByIdx(data.idx, &data.base.len);
-        if (data.base.data) {
-            data.id = str::Dup(url);
-            images.Append(data);
-            return &images.Last().base;
+    if (data.idx == (size_t)-1)
+        return (size_t)-1;
+    data.id = str::Dup(url);
+    images.Append(data);
+    return images.Count() - 1;
+}
+
+// returns a copy of the image's data if it's cached (and marks it as most recently used)
+char *EpubDoc::GetCachedImageData(size_t imageIdx, size_t *lenOut)
+{
+    EpubImage *img = &images.At(imageIdx);
+    if (!img->data)
+        return NULL;
+    cachedImages.Remove(imageIdx);
+    cachedImages.Append(imageIdx);
+    *lenOut = img->len;
+    return (char *)memdup(img->data, img->len);
+}
+
+// keeps a copy of the image's data around until it's evicted as
+// one of the least recently used images for exceeding gImageCacheBudget
+void EpubDoc::CacheImageData(size_t imageIdx, char *data, size_t len)
+{
+    size_t budget = gImageCacheBudget;
+    if (len > budget) {
+        TrimImageCache(budget);
+        return;
+    }
+    TrimImageCache(budget - len);
+    EpubImage *img = &images.At(imageIdx);
+    img->data = (char *)memdup(data, len);
+    if (!img->data)
+        return;
+    img->len = len;
+    cachedImages.Append(imageIdx);
+    cachedImagesSize += len;
+}
+
+char *EpubDoc::LoadImageData(size_t imageIdx, size_t *lenOut)
+{
+    ScopedCritSec scope(&zipAccess);
+    if (imageIdx >= images.Count())
+        return NULL;
+    char *data = GetCachedImageData(imageIdx, lenOut);
+    if (data)
+        return data;
+    data = zip.GetFileDataByIdx(images.At(imageIdx).idx, lenOut);
+    if (data)
+        CacheImageData(imageIdx, data, *lenOut);
+    return data;
+}
+
+SizeI EpubDoc::GetImageSize(size_t imageIdx)
+{
+    size_t zipIdx;
+    {
+        ScopedCritSec scope(&zipAccess);
+        if (imageIdx >= images.Count())
+            return SizeI();
+        if (!images.At(imageIdx).size.IsEmpty())
+            return images.At(imageIdx).size;
+        zipIdx = images.At(imageIdx).idx;
+    }
+
+    // most formats store the dimensions close to the start of the file, so
+    // try to only decompress the header while formatting (the whole image
+    // is only needed once it's drawn)
+    Size size;
+    bool isComplete = false;
+    for (size_t maxLen = 4096; size.Empty() && !isComplete && maxLen <= 256 * 1024; maxLen *= 8) {
+        size_t len;
+        ScopedMem<char> data;
+        {
+            ScopedCritSec scope(&zipAccess);
+            data.Set(zip.GetFileDataPrefix(zipIdx, maxLen, &len));
         }
+        if (!data)
+            break;
+        isComplete = len < maxLen;
+        size = BitmapSizeFromData(data, len);
+    }
+    if (size.Empty() && !isComplete) {
+        // e.g. for TIFF images the dimensions might be stored at the very end
+        size_t len;
+        ScopedMem<char> data(LoadImageData(imageIdx, &len));
+        if (!data)
+            return SizeI();
+        size = BitmapSizeFromData(data, len);
     }
 
-    return NULL;
+    ScopedCritSec scope(&zipAccess);
+    images.At(imageIdx).size = SizeI(size.Width, size.Height);
+    return images.At(imageIdx).size;
+}
+
+ImageRef EpubDoc::GetImageRef(size_t imageIdx)
+{
+    ImageRef ref = { this, imageIdx };
+    return ref;
+}
+
+void EpubDoc::TrimImageCache(size_t maxSize)
+{
+    while (cachedImagesSize > maxSize && cachedImages.Count() > 0) {
+        EpubImage *lru = &images.At(cachedImages.At(0));
+        cachedImagesSize -= lru->len;
+        free(lru->data);
+        lru->data = NULL;
+        cachedImages.RemoveAt(0);
+    }
+}
+
+void EpubDoc::SetImageCacheBudget(size_t budget)
+{
+    gImageCacheBudget = budget;
 }
 
 char *EpubDoc::GetFileData(const char *relPath, const char *pagePath, size_t *lenOut)
@@ -483,6 +672,7 @@ char *EpubDoc::GetFileData(const char *relPath, const char *pagePath, size_t *le
 
     ScopedMem<char> url(NormalizeURL(relPath, pagePath));
     ScopedMem<WCHAR> zipPath(str::conv::FromUtf8(url));
+    ScopedCritSec scope(&zipAccess);
     return zip.GetFileDataByName(zipPath, lenOut);
 }
 
@@ -608,7 +798,11 @@ bool EpubDoc::ParseToc(EbookTocVisitor *visitor)
     if (!tocPath)
         return false;
     size_t tocDataLen;
-    ScopedMem<char> tocData(zip.GetFileDataByName(tocPath, &tocDataLen));
+    ScopedMem<char> tocData;
+    {
+        ScopedCritSec scope(&zipAccess);
+        tocData.Set(zip.GetFileDataByName(tocPath, &tocDataLen));
+    }
     if (!tocData)
         return false;
 
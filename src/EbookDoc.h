@@ -27,10 +27,38 @@ public:
 
 /* ********** EPUB ********** */
 
-class EpubDoc {
+// default for EpubDoc::SetImageCacheBudget (per document)
+#define EPUB_IMAGE_CACHE_BUDGET (32 * 1024 * 1024)
+// how much decompressed HTML an EpubDoc keeps around for reformatting
+#define EPUB_TEXT_CACHE_BUDGET (4 * 1024 * 1024)
+
+struct EpubImage {
+    char *  id;     // path by which content refers to this image
+    size_t  idx;    // index into the EPUB's ZipFile
+    SizeI   size;   // cached for (re)formatting (empty if not known yet)
+    char *  data;   // NULL unless cached (see EpubDoc::cachedImages)
+    size_t  len;
+};
+
+class EpubDoc : public ImageDataLoader, public HtmlSectionLoader {
     ZipFile zip;
-    str::Str<char> htmlData;
-    Vec<ImageData2> images;
+    // spine items are only decompressed once the formatter reaches them
+    WStrVec spinePaths;
+    // offsets of the spine items within the text (known for
+    // the items decompressed so far and the item following them)
+    Vec<size_t> spineOffsets;
+    // decompressed HTML of a spine item (NULL unless cached)
+    Vec<char *> spineData;
+    // indices of spine items with data in memory, least recently used first
+    Vec<size_t> cachedSpineItems;
+    size_t cachedSpineSize;
+    Vec<EpubImage> images;
+    // indices of images with data in memory, least recently used first
+    Vec<size_t> cachedImages;
+    size_t cachedImagesSize;
+    // protects zip, the spine item caches, images and cachedImages, as images
+    // are loaded while drawing (in parallel to formatting)
+    CRITICAL_SECTION zipAccess;
     ScopedMem<WCHAR> tocPath;
     ScopedMem<WCHAR> fileName;
     PropertyMap props;
@@ -38,18 +66,30 @@ class EpubDoc {
     bool isRtlDoc;
 
     bool Load();
+    char *LoadSpineItem(size_t itemIdx, size_t *lenOut);
+    void CacheSpineItem(size_t itemIdx, char *data, size_t len);
+    void TrimSpineCache(size_t maxSize);
     void ParseMetadata(const char *content);
+    char *GetCachedImageData(size_t imageIdx, size_t *lenOut);
+    void CacheImageData(size_t imageIdx, char *data, size_t len);
+    void TrimImageCache(size_t maxSize);
     bool ParseNavToc(const char *data, size_t dataLen, const char *pagePath, EbookTocVisitor *visitor);
     bool ParseNcxToc(const char *data, size_t dataLen, const char *pagePath, EbookTocVisitor *visitor);
 
 public:
     EpubDoc(const WCHAR *fileName);
     EpubDoc(IStream *stream);
-    ~EpubDoc();
+    virtual ~EpubDoc();
 
-    const char *GetTextData(size_t *lenOut);
+    // the text is handed out one spine item at a time
+    virtual char *LoadHtmlSection(size_t idx, size_t *startOut, size_t *lenOut);
     size_t GetTextDataSize();
-    ImageData *GetImageData(const char *id, const char *pagePath);
+    // images are only referenced by index, as their data is loaded on demand
+    // and dropped again once more than the image cache budget is used
+    size_t FindImage(const char *id, const char *pagePath);
+    SizeI GetImageSize(size_t imageIdx);
+    ImageRef GetImageRef(size_t imageIdx);
+    virtual char *LoadImageData(size_t imageIdx, size_t *lenOut);
     char *GetFileData(const char *relPath, const char *pagePath, size_t *lenOut);
 
     WCHAR *GetProperty(DocumentProperty prop) const;
@@ -62,6 +102,8 @@ public:
     static bool IsSupportedFile(const WCHAR *fileName, bool sniff=false);
     static EpubDoc *CreateFromFile(const WCHAR *fileName);
     static EpubDoc *CreateFromStream(IStream *stream);
+    // applies to all documents (already cached images are evicted lazily)
+    static void SetImageCacheBudget(size_t budget);
 };
 
 /* ********** FictionBook (FB2) ********** */
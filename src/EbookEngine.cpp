@@ -47,6 +47,12 @@ void SetDefaultEbookFont(const WCHAR *name, float size)
     gDefaultFontSize = size * 0.8f;
 }
 
+void SetEbookImageCacheSize(int sizeInMB)
+{
+    // 0 disables caching (images are then decompressed for every drawing)
+    EpubDoc::SetImageCacheBudget((size_t)limitValue(sizeInMB, 0, 1024) * 1024 * 1024);
+}
+
 /* common classes for EPUB, FictionBook2, Mobi, PalmDOC, CHM, TCR, HTML and TXT engines */
 
 inline bool IsAbsoluteUrl(const WCHAR *url)
@@ -197,11 +203,14 @@ public:
 class ImageDataElement : public PageElement {
     int pageNo;
     ImageData *id; // owned by *EngineImpl::pages
+    ImageRef *ref; // for images loaded on demand (id is NULL)
     RectI bbox;
 
 public:
     ImageDataElement(int pageNo, ImageData *id, RectI bbox) :
-        pageNo(pageNo), id(id), bbox(bbox) { }
+        pageNo(pageNo), id(id), ref(NULL), bbox(bbox) { }
+    ImageDataElement(int pageNo, ImageRef *ref, RectI bbox) :
+        pageNo(pageNo), id(NULL), ref(ref), bbox(bbox) { }
 
     virtual PageElementType GetType() const { return Element_Image; }
     virtual int GetPageNo() const { return pageNo; }
@@ -210,7 +219,16 @@ public:
 
     virtual RenderedBitmap *GetImage() {
         HBITMAP hbmp;
-        Bitmap *bmp = BitmapFromData(id->data, id->len);
+        Bitmap *bmp = NULL;
+        if (id) {
+            bmp = BitmapFromData(id->data, id->len);
+        }
+        else {
+            size_t len;
+            ScopedMem<char> data(ref->Load(&len));
+            if (data)
+                bmp = BitmapFromData(data, len);
+        }
         if (!bmp || bmp->GetHBITMAP((ARGB)Color::White, &hbmp) != Ok) {
             delete bmp;
             return NULL;
@@ -539,6 +557,8 @@ Vec<PageElement *> *EbookEngine::GetElements(int pageNo)
         DrawInstr *i = &pageInstrs->At(k);
         if (InstrImage == i->type)
             els->Append(new ImageDataElement(pageNo, &i->img, GetInstrBbox(i, pageBorder)));
+        else if (InstrImageRef == i->type)
+            els->Append(new ImageDataElement(pageNo, &i->imgRef, GetInstrBbox(i, pageBorder)));
         else if (InstrLinkStart == i->type && !i->bbox.IsEmptyArea()) {
             PageElement *link = CreatePageLink(i, GetInstrBbox(i, pageBorder), pageNo);
             if (link)
@@ -772,7 +792,7 @@ bool EpubEngineImpl::FinishLoading()
         return false;
 
     HtmlFormatterArgs args;
-    args.htmlStr = doc->GetTextData(&args.htmlStrLen);
+    args.sectionLoader = doc;
     args.pageDx = (float)pageRect.dx - 2 * pageBorder;
     args.pageDy = (float)pageRect.dy - 2 * pageBorder;
     args.SetFontName(GetDefaultFontName());
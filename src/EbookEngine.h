@@ -56,5 +56,6 @@ public:
 };
 
 void SetDefaultEbookFont(const WCHAR *name, float size);
+void SetEbookImageCacheSize(int sizeInMB);
 
 #endif
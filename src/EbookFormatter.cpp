@@ -13,8 +13,11 @@ using namespace Gdiplus;
 HtmlFormatterArgs *CreateFormatterArgsDoc(Doc doc, int dx, int dy, PoolAllocator *textAllocator)
 {
     HtmlFormatterArgs *args = new HtmlFormatterArgs();
-    args->htmlStr = doc.GetHtmlData(args->htmlStrLen);
-    CrashIf(!args->htmlStr);
+    if (doc.AsEpub())
+        args->sectionLoader = doc.AsEpub();
+    else
+        args->htmlStr = doc.GetHtmlData(args->htmlStrLen);
+    CrashIf(!args->htmlStr && !args->sectionLoader);
     args->SetFontName(L"Georgia");
     args->fontSize = 12.5f;
     args->pageDx = (REAL)dx;
@@ -161,8 +164,7 @@ void EpubFormatter::HandleTagImg(HtmlToken *t)
     AttrInfo *attr = t->GetAttrByName("src");
     if (attr) {
         ScopedMem<char> src(str::DupN(attr->val, attr->valLen));
-        ImageData *img = epubDoc->GetImageData(src, pagePath);
-        needAlt = !img || !EmitImage(img);
+        needAlt = !EmitEpubImage(src);
     }
     if (needAlt && (attr = t->GetAttrByName("alt")) != NULL)
         HandleText(attr->val, attr->valLen);
@@ -175,7 +177,11 @@ void EpubFormatter::HandleTagPagebreak(HtmlToken *t)
         ForceNewPage();
     if (attr) {
         RectF bbox(0, currY, pageDx, 0);
-        currPage->instructions.Append(DrawInstr::Anchor(attr->val, attr->valLen, bbox));
+        // EbookEngine::ExtractPageAnchors looks for the page_marker after the path
+        size_t len = attr->valLen;
+        if (str::StartsWith(attr->val + len, "\" page_marker />"))
+            len += str::Len("\" page_marker />");
+        currPage->instructions.Append(DrawInstr::Anchor(KeepText(attr->val, len), attr->valLen, bbox));
         pagePath.Set(str::DupN(attr->val, attr->valLen));
         // reset CSS style rules for the new document
         styleRules.Reset();
@@ -215,9 +221,18 @@ void EpubFormatter::HandleTagSvgImage(HtmlToken *t)
     if (!attr)
         return;
     ScopedMem<char> src(str::DupN(attr->val, attr->valLen));
-    ImageData *img = epubDoc->GetImageData(src, pagePath);
-    if (img)
-        EmitImage(img);
+    EmitEpubImage(src);
+}
+
+// image data is only loaded for determining the image's size
+// (once) and then again whenever the image is drawn
+bool EpubFormatter::EmitEpubImage(const char *src)
+{
+    size_t imageIdx = epubDoc->FindImage(src, pagePath);
+    if (imageIdx == (size_t)-1)
+        return false;
+    SizeI size = epubDoc->GetImageSize(imageIdx);
+    return EmitImage(epubDoc->GetImageRef(imageIdx), Size(size.dx, size.dy));
 }
 
 void EpubFormatter::HandleHtmlTag(HtmlToken *t)
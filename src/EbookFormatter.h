@@ -39,6 +39,7 @@ class EpubFormatter : public HtmlFormatter {
     virtual bool IgnoreText();
 
     void HandleTagSvgImage(HtmlToken *t);
+    bool EmitEpubImage(const char *src);
 
     EpubDoc *epubDoc;
     ScopedMem<char> pagePath;
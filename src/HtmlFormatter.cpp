@@ -60,8 +60,9 @@ Control objects further to make allocating hundreds of them cheaper or introduce
 other base element(s) with less functionality and less overhead).
 */
 
-bool ValidReparseIdx(ptrdiff_t idx, HtmlPullParser *parser)
+bool ValidReparseIdx(ptrdiff_t idx, HtmlPullParser *parser, size_t sectionStart=0)
 {
+    idx -= sectionStart;
     if ((idx < 0) || (idx > (int)parser->Len()))
         return false;
     return true;
@@ -98,6 +99,14 @@ DrawInstr DrawInstr::Image(char *data, size_t len, RectF bbox)
     return di;
 }
 
+DrawInstr DrawInstr::ImageByRef(ImageRef ref, RectF bbox)
+{
+    DrawInstr di(InstrImageRef);
+    di.imgRef = ref;
+    di.bbox = bbox;
+    return di;
+}
+
 DrawInstr DrawInstr::LinkStart(const char *s, size_t len)
 {
     DrawInstr di(InstrLinkStart);
@@ -172,12 +181,20 @@ HtmlFormatter::HtmlFormatter(HtmlFormatterArgs *args) :
     currX(0), currY(0), currLineTopPadding(0), currLinkIdx(0),
     listDepth(0), preFormatted(false), dirRtl(false), currPage(NULL),
     finishedParsing(false), pageCount(0), measureAlgo(args->measureAlgo),
-    keepTagNesting(false)
+    keepTagNesting(false), htmlParser(NULL),
+    sectionLoader(args->sectionLoader), sectionStart(0)
 {
     currReparseIdx = args->reparseIdx;
-    htmlParser = new HtmlPullParser(args->htmlStr, args->htmlStrLen);
-    htmlParser->SetCurrPosOff(currReparseIdx);
-    CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser));
+    if (!sectionLoader) {
+        htmlParser = new HtmlPullParser(args->htmlStr, args->htmlStrLen);
+        htmlParser->SetCurrPosOff(currReparseIdx);
+    }
+    else if (!LoadSection(currReparseIdx)) {
+        // reparseIdx is at the end of the text
+        htmlParser = new HtmlPullParser("", (size_t)0);
+        sectionStart = currReparseIdx;
+    }
+    CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser, sectionStart));
 
     gfx = mui::AllocGraphicsForMeasureText();
     defaultFontName.Set(str::Dup(args->GetFontName()));
@@ -207,12 +224,40 @@ HtmlFormatter::~HtmlFormatter()
     mui::FreeGraphicsForMeasureText(gfx);
 }
 
+// switches to the section containing idx (or the next non-empty one)
+bool HtmlFormatter::LoadSection(size_t idx)
+{
+    size_t start, len;
+    char *data = sectionLoader->LoadHtmlSection(idx, &start, &len);
+    if (!data)
+        return false;
+    delete htmlParser;
+    htmlParser = new HtmlPullParser(data, len);
+    if (idx > start)
+        htmlParser->SetCurrPosOff(idx - start);
+    sectionData.Set(data);
+    sectionStart = start;
+    return true;
+}
+
+// a section's html is freed once the next section is loaded, so
+// strings referenced by DrawInstr must be copied in that case
+const char *HtmlFormatter::KeepText(const char *s, size_t len)
+{
+    if (!sectionLoader)
+        return s;
+    char *copy = (char *)Allocator::Dup(textAllocator, s, len, 1);
+    if (copy)
+        copy[len] = '\0';
+    return copy;
+}
+
 void HtmlFormatter::AppendInstr(DrawInstr di)
 {
     currLineInstr.Append(di);
     if (-1 == currLineReparseIdx) {
         currLineReparseIdx = currReparseIdx;
-        CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser));
+        CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser, sectionStart));
     }
 }
 
@@ -283,12 +328,17 @@ static bool IsVisibleDrawInstr(DrawInstr *i)
     switch (i->type) {
         case InstrString: case InstrRtlString:
         case InstrLine:
-        case InstrImage:
+        case InstrImage: case InstrImageRef:
             return true;
     }
     return false;
 }
 
+static bool IsImageDrawInstr(DrawInstr *i)
+{
+    return InstrImage == i->type || InstrImageRef == i->type;
+}
+
 // sum of widths of all elements with a fixed size and flexible
 // spaces (using minimum value for its width)
 REAL HtmlFormatter::CurrLineDx()
@@ -297,7 +347,7 @@ REAL HtmlFormatter::CurrLineDx()
     for (DrawInstr *i = currLineInstr.IterStart(); i; i = currLineInstr.IterNext()) {
         if (InstrString == i->type || InstrRtlString == i->type) {
             dx += i->bbox.Width;
-        } else if (InstrImage == i->type) {
+        } else if (IsImageDrawInstr(i)) {
             dx += i->bbox.Width;
         } else if (InstrElasticSpace == i->type) {
             dx += spaceDx;
@@ -343,7 +393,7 @@ void HtmlFormatter::LayoutLeftStartingAt(REAL offX)
 
     REAL x = offX + NewLineX();
     for (DrawInstr *i = currLineInstr.IterStart(); i; i = currLineInstr.IterNext()) {
-        if (InstrString == i->type || InstrRtlString == i->type || InstrImage == i->type) {
+        if (InstrString == i->type || InstrRtlString == i->type || IsImageDrawInstr(i)) {
             i->bbox.X = x;
             x += i->bbox.Width;
             lastInstr = i;
@@ -356,7 +406,7 @@ void HtmlFormatter::LayoutLeftStartingAt(REAL offX)
     }
 
     // center a single image
-    if (instrCount == 1 && InstrImage == lastInstr->type)
+    if (instrCount == 1 && IsImageDrawInstr(lastInstr))
         lastInstr->bbox.X = (pageDx - lastInstr->bbox.Width) / 2.f;
 }
 
@@ -397,7 +447,7 @@ void HtmlFormatter::JustifyLineBoth()
         }
         else if (InstrString == i->type || InstrRtlString == i->type)
             endsWithSpace = false;
-        else if (InstrImage == i->type)
+        else if (IsImageDrawInstr(i))
             endsWithSpace = false;
     }
     // don't take a space at the end of the line into account 
@@ -413,7 +463,7 @@ void HtmlFormatter::JustifyLineBoth()
     for (DrawInstr *i = currLineInstr.IterStart(); i; i = currLineInstr.IterNext()) {
         if (InstrElasticSpace == i->type)
             offX += extraSpaceDx;
-        else if (InstrString == i->type || InstrRtlString == i->type || InstrImage == i->type) {
+        else if (InstrString == i->type || InstrRtlString == i->type || IsImageDrawInstr(i)) {
             i->bbox.X += offX;
             lastStr = i;
         }
@@ -597,7 +647,7 @@ static bool HasPreviousLineSingleImage(Vec<DrawInstr>& instrs)
             // it must be completely above it (previous line)
             return i->bbox.Y + i->bbox.Height <= imageY;
         }
-        if (InstrImage != i->type)
+        if (!IsImageDrawInstr(i))
             return false;
         imageY = i->bbox.Y;
     }
@@ -608,6 +658,18 @@ bool HtmlFormatter::EmitImage(ImageData *img)
 {
     CrashIf(!img->data);
     Size imgSize = BitmapSizeFromData(img->data, img->len);
+    return EmitImageInstr(DrawInstr::Image(img->data, img->len, RectF()), imgSize);
+}
+
+// for images which are only loaded when drawn, the size has to be determined beforehand
+bool HtmlFormatter::EmitImage(ImageRef ref, Size imgSize)
+{
+    CrashIf(!ref.loader);
+    return EmitImageInstr(DrawInstr::ImageByRef(ref, RectF()), imgSize);
+}
+
+bool HtmlFormatter::EmitImageInstr(DrawInstr instr, Size imgSize)
+{
     if (imgSize.Empty())
         return false;
 
@@ -636,9 +698,9 @@ bool HtmlFormatter::EmitImage(ImageData *img)
         }
     }
 
-    RectF bbox(PointF(currX, 0), newSize);
-    AppendInstr(DrawInstr::Image(img->data, img->len, bbox));
-    currX += bbox.Width;
+    instr.bbox = RectF(PointF(currX, 0), newSize);
+    AppendInstr(instr);
+    currX += instr.bbox.Width;
 
     return true;
 }
@@ -706,8 +768,8 @@ void HtmlFormatter::EmitElasticSpace()
 // a text run is a string of consecutive text with uniform style
 void HtmlFormatter::EmitTextRun(const char *s, const char *end)
 {
-    currReparseIdx = s - htmlParser->Start();
-    CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser));
+    currReparseIdx = sectionStart + (s - htmlParser->Start());
+    CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser, sectionStart));
     CrashIf(IsSpaceOnly(s, end) && !preFormatted);
     const char *tmp = ResolveHtmlEntities(s, end, textAllocator);
     bool resolved = tmp != s;
@@ -719,13 +781,13 @@ void HtmlFormatter::EmitTextRun(const char *s, const char *end)
     while (s < end) {
         // don't update the reparseIdx if s doesn't point into the original source
         if (!resolved)
-            currReparseIdx = s - htmlParser->Start();
+            currReparseIdx = sectionStart + (s - htmlParser->Start());
 
         size_t strLen = str::Utf8ToWcharBuf(s, end - s, buf, dimof(buf));
         RectF bbox = MeasureText(gfx, CurrFont(), buf, strLen, measureAlgo);
         EnsureDx(bbox.Width);
         if (bbox.Width <= pageDx - currX) {
-            AppendInstr(DrawInstr::Str(s, end - s, bbox, dirRtl));
+            AppendInstr(DrawInstr::Str(resolved ? s : KeepText(s, end - s), end - s, bbox, dirRtl));
             currX += bbox.Width;
             break;
         }
@@ -748,7 +810,7 @@ void HtmlFormatter::EmitTextRun(const char *s, const char *end)
         for (size_t i = lenThatFits; i > 0; i--) {
             lenThatFits += buf[i-1] < 0x80 ? 0 : buf[i-1] < 0x800 ? 1 : 2;
         }
-        AppendInstr(DrawInstr::Str(s, lenThatFits, bbox, dirRtl));
+        AppendInstr(DrawInstr::Str(resolved ? s : KeepText(s, lenThatFits), lenThatFits, bbox, dirRtl));
         currX += bbox.Width;
         s += lenThatFits;
     }
@@ -769,7 +831,7 @@ void HtmlFormatter::HandleAnchorAttr(HtmlToken *t, bool idsOnly)
     RectF bbox(0, currY, pageDx, 0);
     // append at the start of the line to prevent the anchor
     // from being flushed to the next page (with wrong currY value)
-    currPage->instructions.Append(DrawInstr::Anchor(attr->val, attr->valLen, bbox));
+    currPage->instructions.Append(DrawInstr::Anchor(KeepText(attr->val, attr->valLen), attr->valLen, bbox));
 }
 
 void HtmlFormatter::HandleDirAttr(HtmlToken *t)
@@ -871,7 +933,7 @@ bool HtmlFormatter::HandleTagA(HtmlToken *t, const char *linkAttr, const char *a
     if (t->IsStartTag() && !currLinkIdx) {
         AttrInfo *attr = attrNS ? t->GetAttrByNameNS(linkAttr, attrNS) : t->GetAttrByName(linkAttr);
         if (attr) {
-            AppendInstr(DrawInstr::LinkStart(attr->val, attr->valLen));
+            AppendInstr(DrawInstr::LinkStart(KeepText(attr->val, attr->valLen), attr->valLen));
             currLinkIdx = currLineInstr.Count();
             return true;
         }
@@ -1212,7 +1274,7 @@ void HtmlFormatter::HandleText(const char *s, size_t sLen)
         // don't collapse whitespace and respect text newlines
         while (curr < end) {
             const char *text = curr;
-            currReparseIdx = curr - htmlParser->Start();
+            currReparseIdx = sectionStart + (curr - htmlParser->Start());
             // skip to the next newline
             for (; curr < end && *curr != '\n'; curr++);
             if (curr < end && curr > text && *(curr - 1) == '\r')
@@ -1230,13 +1292,13 @@ void HtmlFormatter::HandleText(const char *s, size_t sLen)
     // whitespace or all non-whitespace
     while (curr < end) {
         // collapse multiple, consecutive white-spaces into a single space
-        currReparseIdx = curr - htmlParser->Start();
+        currReparseIdx = sectionStart + (curr - htmlParser->Start());
         bool skipped = SkipWs(curr, end);
         if (skipped)
             EmitElasticSpace();
 
         const char *text = curr;
-        currReparseIdx = curr - htmlParser->Start();
+        currReparseIdx = sectionStart + (curr - htmlParser->Start());
         skipped = SkipNonWs(curr, end);
         if (skipped)
             EmitTextRun(text, curr);
@@ -1301,11 +1363,13 @@ HtmlPage *HtmlFormatter::Next(bool skipEmptyPages)
         if (finishedParsing)
             return NULL;
         HtmlToken *t = htmlParser->Next();
+        if (!t && sectionLoader && LoadSection(sectionStart + htmlParser->Len()))
+            continue;
         if (!t || t->IsError())
             break;
 
-        currReparseIdx = t->GetReparsePoint() - htmlParser->Start();
-        CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser));
+        currReparseIdx = sectionStart + (t->GetReparsePoint() - htmlParser->Start());
+        CrashIf(!ValidReparseIdx(currReparseIdx, htmlParser, sectionStart));
         if (t->IsTag())
             HandleHtmlTag(t);
         else if (!IgnoreText())
@@ -1378,6 +1442,13 @@ void DrawHtmlPage(Graphics *g, Vec<DrawInstr> *drawInstructions, REAL offX, REAL
             if (bmp)
                 g->DrawImage(bmp, bbox, 0, 0, (REAL)bmp->GetWidth(), (REAL)bmp->GetHeight(), UnitPixel);
             delete bmp;
+        } else if (InstrImageRef == i->type) {
+            size_t len;
+            ScopedMem<char> data(i->imgRef.Load(&len));
+            Bitmap *bmp = data ? BitmapFromData(data, len) : NULL;
+            if (bmp)
+                g->DrawImage(bmp, bbox, 0, 0, (REAL)bmp->GetWidth(), (REAL)bmp->GetHeight(), UnitPixel);
+            delete bmp;
         } else if (InstrLinkStart == i->type) {
             // TODO: set text color to blue
             REAL y = floorf(bbox.Y + bbox.Height + 0.5f);
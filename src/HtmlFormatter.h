@@ -26,6 +26,8 @@ enum DrawInstrType {
     InstrSetFont,
     // an image (raw data for e.g. BitmapFromData)
     InstrImage,
+    // an image whose data is only loaded when drawn (see ImageDataLoader)
+    InstrImageRef,
     // marks the beginning of a link (<a> tag)
     InstrLinkStart,
     // marks end of the link (must have matching InstrLinkStart)
@@ -46,6 +48,7 @@ struct DrawInstr {
         }                   str;          // InstrString, InstrLinkStart, InstrAnchor, InstrRtlString
         Font *              font;         // InstrSetFont
         ImageData           img;          // InstrImage
+        ImageRef            imgRef;       // InstrImageRef
     };
     RectF bbox; // common to most instructions
 
@@ -56,6 +59,7 @@ struct DrawInstr {
     // helper constructors for instructions that need additional arguments
     static DrawInstr Str(const char *s, size_t len, RectF bbox, bool rtl=false);
     static DrawInstr Image(char *data, size_t len, RectF bbox);
+    static DrawInstr ImageByRef(ImageRef ref, RectF bbox);
     static DrawInstr SetFont(Font *font);
     static DrawInstr FixedSpace(float dx);
     static DrawInstr LinkStart(const char *s, size_t len);
@@ -107,7 +111,7 @@ public:
     HtmlFormatterArgs() :
       pageDx(0), pageDy(0), fontName(NULL), fontSize(0),
       textAllocator(NULL), htmlStr(0), htmlStrLen(0),
-      reparseIdx(0), measureAlgo(NULL)
+      sectionLoader(NULL), reparseIdx(0), measureAlgo(NULL)
     { }
 
     ~HtmlFormatterArgs() {
@@ -137,6 +141,8 @@ public:
 
     const char *    htmlStr;
     size_t          htmlStrLen;
+    // if set, the html is loaded section by section instead of from htmlStr
+    HtmlSectionLoader *sectionLoader;
 
     // we start parsing from htmlStr + reparseIdx
     int             reparseIdx;
@@ -184,6 +190,8 @@ protected:
     void  UpdateLinkBboxes(HtmlPage *page);
 
     bool  EmitImage(ImageData *img);
+    bool  EmitImage(ImageRef ref, Size imgSize);
+    bool  EmitImageInstr(DrawInstr instr, Size imgSize);
     void  EmitHr();
     void  EmitTextRun(const char *s, const char *end);
     void  EmitElasticSpace();
@@ -205,6 +213,9 @@ protected:
     StyleRule *FindStyleRule(HtmlTag tag, const char *clazz, size_t clazzLen);
     StyleRule ComputeStyleRule(HtmlToken *t);
 
+    bool  LoadSection(size_t idx);
+    const char *KeepText(const char *s, size_t len);
+
     void  AppendInstr(DrawInstr di);
     bool  IsCurrLineEmpty();
     virtual bool IgnoreText();
@@ -256,6 +267,10 @@ protected:
     ptrdiff_t           currReparseIdx;
 
     HtmlPullParser *    htmlParser;
+    // the section currently parsed by htmlParser (if loaded through sectionLoader)
+    HtmlSectionLoader * sectionLoader;
+    ScopedMem<char>     sectionData;
+    size_t              sectionStart;
 
     // list of pages that we've created but haven't yet sent to client
     Vec<HtmlPage*>      pagesToSend;
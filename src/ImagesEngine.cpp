@@ -4,11 +4,14 @@
 #include "BaseUtil.h"
 #include "ImagesEngine.h"
 
+#include "DebugLog.h"
 #include "FileUtil.h"
 using namespace Gdiplus;
 #include "GdiPlusUtil.h"
 #include "HtmlPullParser.h"
 #include "JsonParser.h"
+#include "ThreadUtil.h"
+#include "Timer.h"
 #include "WinUtil.h"
 #include "ZipUtil.h"
 
@@ -21,6 +24,8 @@ using namespace Gdiplus;
 ///// ImagesEngine methods apply to all types of engines handling full-page images /////
 
 class ImagesEngine : public virtual BaseEngine {
+    friend class ImageElement;
+
 public:
     ImagesEngine() : fileName(NULL), fileExt(NULL) { }
     virtual ~ImagesEngine() {
@@ -71,12 +76,19 @@ protected:
     Vec<Bitmap *> pages;
 
     void GetTransform(Matrix& m, int pageNo, float zoom, int rotation);
+    // draws bmp (of size bmpSize) so that it covers the whole page
+    bool RenderImage(HDC hDC, RectI screenRect, Bitmap *bmp, SizeI bmpSize,
+                     int pageNo, float zoom, int rotation, RectD *pageRect);
 
     // override for lazily loading images
     virtual Bitmap *LoadImage(int pageNo) {
         assert(1 <= pageNo && pageNo <= PageCount());
         return pages.At(pageNo - 1);
     }
+    // override for engines which free images again (the image
+    // must remain valid until ReleaseImage is called)
+    virtual Bitmap *AcquireImage(int pageNo) { return LoadImage(pageNo); }
+    virtual void ReleaseImage(int pageNo) { }
 };
 
 RenderedBitmap *ImagesEngine::RenderBitmap(int pageNo, float zoom, int rotation, RectD *pageRect, RenderTarget target, AbortCookie **cookie_out)
@@ -106,7 +118,12 @@ bool ImagesEngine::RenderPage(HDC hDC, RectI screenRect, int pageNo, float zoom,
     Bitmap *bmp = LoadImage(pageNo);
     if (!bmp)
         return false;
+    SizeI bmpSize = PageMediabox(pageNo).Round().Size();
+    return RenderImage(hDC, screenRect, bmp, bmpSize, pageNo, zoom, rotation, pageRect);
+}
 
+bool ImagesEngine::RenderImage(HDC hDC, RectI screenRect, Bitmap *bmp, SizeI bmpSize, int pageNo, float zoom, int rotation, RectD *pageRect)
+{
     RectD pageRc = pageRect ? *pageRect : PageMediabox(pageNo);
     RectI screen = Transform(pageRc, pageNo, zoom, rotation).Round();
 
@@ -129,7 +146,7 @@ bool ImagesEngine::RenderPage(HDC hDC, RectI screenRect, int pageNo, float zoom,
     RectI pageRcI = PageMediabox(pageNo).Round();
     ImageAttributes imgAttrs;
     imgAttrs.SetWrapMode(WrapModeTileFlipXY);
-    Status ok = g.DrawImage(bmp, pageRcI.ToGdipRect(), 0, 0, pageRcI.dx, pageRcI.dy, UnitPixel, &imgAttrs);
+    Status ok = g.DrawImage(bmp, pageRcI.ToGdipRect(), 0, 0, bmpSize.dx, bmpSize.dy, UnitPixel, &imgAttrs);
     return ok == Ok;
 }
 
@@ -164,22 +181,30 @@ RectD ImagesEngine::Transform(RectD rect, int pageNo, float zoom, int rotation,
 }
 
 class ImageElement : public PageElement {
-    Bitmap *bmp;
+    ImagesEngine *engine;
     int pageNo;
+    RectD rect;
 
 public:
-    ImageElement(int pageNo, Bitmap *bmp) : pageNo(pageNo), bmp(bmp) { }
+    ImageElement(ImagesEngine *engine, int pageNo) : engine(engine),
+        pageNo(pageNo), rect(engine->PageMediabox(pageNo)) { }
 
     virtual PageElementType GetType() const { return Element_Image; }
     virtual int GetPageNo() const { return pageNo; }
-    virtual RectD GetRect() const { return RectD(0, 0, bmp->GetWidth(), bmp->GetHeight()); }
+    virtual RectD GetRect() const { return rect; }
     virtual WCHAR *GetValue() const { return NULL; }
 
+    // the page's image might have been freed in the meantime
     virtual RenderedBitmap *GetImage() {
-        HBITMAP hbmp;
-        if (bmp->GetHBITMAP((ARGB)Color::White, &hbmp) != Ok)
+        Bitmap *bmp = engine->AcquireImage(pageNo);
+        if (!bmp)
             return NULL;
-        return new RenderedBitmap(hbmp, SizeI(bmp->GetWidth(), bmp->GetHeight()));
+        HBITMAP hbmp;
+        RenderedBitmap *rendered = NULL;
+        if (bmp->GetHBITMAP((ARGB)Color::White, &hbmp) == Ok)
+            rendered = new RenderedBitmap(hbmp, SizeI(bmp->GetWidth(), bmp->GetHeight()));
+        engine->ReleaseImage(pageNo);
+        return rendered;
     }
 };
 
@@ -190,7 +215,7 @@ Vec<PageElement *> *ImagesEngine::GetElements(int pageNo)
         return NULL;
 
     Vec<PageElement *> *els = new Vec<PageElement *>();
-    els->Append(new ImageElement(pageNo, bmp));
+    els->Append(new ImageElement(this, pageNo));
     return els;
 }
 
@@ -201,7 +226,7 @@ PageElement *ImagesEngine::GetElementAtPos(int pageNo, PointD pt)
     Bitmap *bmp = LoadImage(pageNo);
     if (!bmp)
         return NULL;
-    return new ImageElement(pageNo, bmp);
+    return new ImageElement(this, pageNo);
 }
 
 unsigned char *ImagesEngine::GetFileData(size_t *cbCount)
@@ -595,12 +620,61 @@ ImageDirEngine *ImageDirEngine::CreateFromFile(const WCHAR *fileName)
 
 ///// CbxEngine handles comic book files (either .cbz or .cbr) /////
 
+// number of pages following the most recently loaded one
+// which are decoded ahead of time in the background
+#define CBX_PREFETCH_PAGES 3
+// number of pages preceding the most recently rendered one which are
+// kept decoded (the images of all other pages are freed again)
+#define CBX_KEEP_PAGES_BEHIND 2
+// maximum amount of memory used for page images downscaled for display
+#define CBX_SCALED_CACHE_BUDGET (64 * 1024 * 1024)
+// maximum amount of memory used for the still encoded images of .cbr pages
+#define CBR_DATA_CACHE_BUDGET   (32 * 1024 * 1024)
+
+class CbxPrefetchThread;
+
+// the still encoded image of a page (data is NULL if it's not currently cached)
+class ImagesPage {
+public:
+    ScopedMem<WCHAR>fileName; // for sorting image files
+    char *          data;
+    size_t          len;
+    Size            size;
+    // position of the file's header in a .cbr archive (for RARSeekToHeader)
+    bool            hasHeaderPos;
+    unsigned int    headerPosLow, headerPosHigh;
+
+    ImagesPage(const WCHAR *fileName, char *data, size_t len, Size size) :
+        fileName(str::Dup(fileName)), data(data), len(len), size(size),
+        hasHeaderPos(false), headerPosLow(0), headerPosHigh(0) { }
+    ~ImagesPage() { free(data); }
+
+    static int cmpPageByName(const void *o1, const void *o2) {
+        ImagesPage *p1 = *(ImagesPage **)o1;
+        ImagesPage *p2 = *(ImagesPage **)o2;
+        return wcscmp(p1->fileName, p2->fileName);
+    }
+};
+
+// a page image downscaled to the size it was last displayed at
+struct ScaledPage {
+    int pageNo;
+    Bitmap *bmp;
+    SizeI size;
+};
+
 class CbxEngineImpl : public ImagesEngine, public CbxEngine, public json::ValueVisitor {
     friend CbxEngine;
+    friend CbxPrefetchThread;
 
 public:
-    CbxEngineImpl() : cbzFile(NULL) {
+    CbxEngineImpl() : cbzFile(NULL), currPageNo(0), cbrDataSize(0), prefetchThread(NULL),
+        prefetchPageNo(0), prefetchZoom(0), prefetchingPageNo(0), scaledPagesSize(0) {
         InitializeCriticalSection(&fileAccess);
+        InitializeCriticalSection(&cbrAccess);
+        InitializeCriticalSection(&scaledAccess);
+        prefetchRequested = CreateEvent(NULL, FALSE, FALSE, NULL);
+        prefetchDone = CreateEvent(NULL, TRUE, TRUE, NULL);
     }
     virtual ~CbxEngineImpl();
 
@@ -616,6 +690,8 @@ public:
         return NULL;
     }
     virtual RectD PageMediabox(int pageNo);
+    virtual bool RenderPage(HDC hDC, RectI screenRect, int pageNo, float zoom, int rotation,
+                         RectD *pageRect=NULL, RenderTarget target=Target_View, AbortCookie **cookie_out=NULL);
 
     virtual WCHAR *GetProperty(DocumentProperty prop);
 
@@ -633,9 +709,20 @@ protected:
     bool FinishLoadingCbz();
     void ParseComicInfoXml(const char *xmlData);
     bool LoadCbrFile(const WCHAR *fileName);
+    char *LoadCbrPageData(int pageNo, size_t *lenOut);
+    void UpdateCbrDataCache(int pageNo);
 
     virtual Bitmap *LoadImage(int pageNo);
+    virtual Bitmap *AcquireImage(int pageNo);
+    virtual void ReleaseImage(int pageNo);
+    void DropDistantPages();
     char *GetImageData(int pageNo, size_t& len);
+    const char *GetImageDataView(int pageNo, size_t& len);
+    Bitmap *DecodeImage(int pageNo);
+    void PrefetchPages(CbxPrefetchThread *thread);
+    void PrefetchPage(int pageNo, float zoom);
+    void StartPrefetching(int pageNo, float zoom);
+    Bitmap *GetScaledPage(int pageNo, Bitmap *bmp, SizeI size);
 
     Vec<RectD> mediaboxes;
 
@@ -649,22 +736,80 @@ protected:
     // temporary state needed for extracting metadata
     ScopedMem<WCHAR> propAuthorTmp;
 
-    // used for lazily loading page images (only supported for .cbz files)
+    // used for lazily loading page images (pages, pageUsers, currPageNo, mediaboxes,
+    // isDecoding and the prefetch* values are protected by fileAccess)
     CRITICAL_SECTION fileAccess;
     ZipFile *cbzFile;
     Vec<size_t> fileIdxs;
+    // number of callers currently using a page's image (see AcquireImage)
+    Vec<int> pageUsers;
+    // only the images of the pages around the most recently rendered one are kept
+    int currPageNo;
+    // for .cbr files, all pages are extracted (but not decoded) in a single pass
+    // and the data of the most recently used pages is kept within CBR_DATA_CACHE_BUDGET
+    // (evicted pages are extracted again by seeking to their file header
+    // or by searching for them in solid archives)
+    CRITICAL_SECTION cbrAccess;
+    Vec<ImagesPage *> cbrPages;
+    Vec<int> cbrDataLru;
+    size_t cbrDataSize;
+
+    // decodes the pages following the most recently rendered one
+    // (the thread is only started once and then waits for further requests)
+    CbxPrefetchThread *prefetchThread;
+    HANDLE prefetchRequested;
+    int prefetchPageNo;
+    float prefetchZoom;
+    // signaled unless the prefetch thread is decoding prefetchingPageNo
+    HANDLE prefetchDone;
+    int prefetchingPageNo;
+    Vec<bool> isDecoding;
+
+    // page images downscaled for display, least recently used first
+    CRITICAL_SECTION scaledAccess;
+    Vec<ScaledPage> scaledPages;
+    size_t scaledPagesSize;
+};
+
+class CbxPrefetchThread : public ThreadBase {
+public:
+    CbxEngineImpl *engine;
+
+    CbxPrefetchThread(CbxEngineImpl *engine) :
+        ThreadBase("CbxPrefetchThread"), engine(engine) { }
+    virtual ~CbxPrefetchThread() { }
+
+    virtual void Run() { engine->PrefetchPages(this); }
+
+    bool WasCancelRequested() { return ThreadBase::WasCancelRequested(); }
 };
 
 CbxEngineImpl::~CbxEngineImpl()
 {
+    if (prefetchThread) {
+        prefetchThread->RequestCancel();
+        SetEvent(prefetchRequested);
+        prefetchThread->Join();
+        delete prefetchThread;
+    }
+    CloseHandle(prefetchRequested);
+    CloseHandle(prefetchDone);
+    for (size_t i = 0; i < scaledPages.Count(); i++) {
+        delete scaledPages.At(i).bmp;
+    }
+    DeleteVecMembers(cbrPages);
     delete cbzFile;
 
+    DeleteCriticalSection(&scaledAccess);
+    DeleteCriticalSection(&cbrAccess);
     DeleteCriticalSection(&fileAccess);
 }
 
 RectD CbxEngineImpl::PageMediabox(int pageNo)
 {
     assert(1 <= pageNo && pageNo <= PageCount());
+    // also called from the prefetch thread
+    ScopedCritSec scope(&fileAccess);
     if (!mediaboxes.At(pageNo - 1).IsEmpty())
         return mediaboxes.At(pageNo - 1);
 
@@ -675,6 +820,13 @@ RectD CbxEngineImpl::PageMediabox(int pageNo)
     }
 
     size_t len;
+    const char *bmpView = GetImageDataView(pageNo, len);
+    if (bmpView) {
+        Size size = BitmapSizeFromData(bmpView, len);
+        mediaboxes.At(pageNo - 1) = RectD(0, 0, size.Width, size.Height);
+        return mediaboxes.At(pageNo - 1);
+    }
+
     ScopedMem<char> bmpData(GetImageData(pageNo, len));
     if (bmpData) {
         Size size = BitmapSizeFromData(bmpData, len);
@@ -683,18 +835,263 @@ RectD CbxEngineImpl::PageMediabox(int pageNo)
     return mediaboxes.At(pageNo - 1);
 }
 
+// note: the result might be freed at any time, so it should only be checked for NULL
 Bitmap *CbxEngineImpl::LoadImage(int pageNo)
+{
+    Bitmap *bmp = AcquireImage(pageNo);
+    if (bmp)
+        ReleaseImage(pageNo);
+    return bmp;
+}
+
+// decodes the page's image (if needed) and keeps it until ReleaseImage is called
+Bitmap *CbxEngineImpl::AcquireImage(int pageNo)
 {
     assert(1 <= pageNo && pageNo <= PageCount());
-    if (pages.At(pageNo - 1))
+    ScopedCritSec scope(&fileAccess);
+    // wait for the page to be decoded if it's currently being prefetched
+    while (prefetchingPageNo == pageNo) {
+        LeaveCriticalSection(&fileAccess);
+        WaitForSingleObject(prefetchDone, INFINITE);
+        EnterCriticalSection(&fileAccess);
+    }
+    if (pages.At(pageNo - 1)) {
+        pageUsers.At(pageNo - 1)++;
         return pages.At(pageNo - 1);
+    }
+
+    // note: if another rendering thread is decoding the same page,
+    // the page is decoded twice (instead of waiting for that thread)
+    isDecoding.At(pageNo - 1) = true;
+    LeaveCriticalSection(&fileAccess);
+    Timer t(true);
+    Bitmap *bmp = DecodeImage(pageNo);
+    dbglog::LogF("CbxEngine: decoding page %d took %.2f ms", pageNo, t.GetTimeInMs());
+    EnterCriticalSection(&fileAccess);
+    isDecoding.At(pageNo - 1) = false;
+
+    if (pages.At(pageNo - 1)) {
+        delete bmp;
+        bmp = pages.At(pageNo - 1);
+    }
+    if (!bmp)
+        return NULL;
+    pages.At(pageNo - 1) = bmp;
+    pageUsers.At(pageNo - 1)++;
+    return bmp;
+}
+
+void CbxEngineImpl::ReleaseImage(int pageNo)
+{
+    ScopedCritSec scope(&fileAccess);
+    CrashIf(pageUsers.At(pageNo - 1) <= 0);
+    pageUsers.At(pageNo - 1)--;
+}
 
+// frees the images of all pages not around currPageNo which aren't in use,
+// so that memory use doesn't grow with the number of pages viewed
+// caller must hold fileAccess
+void CbxEngineImpl::DropDistantPages()
+{
+    for (int pageNo = 1; pageNo <= PageCount(); pageNo++) {
+        if (currPageNo - CBX_KEEP_PAGES_BEHIND <= pageNo && pageNo <= currPageNo + CBX_PREFETCH_PAGES)
+            continue;
+        if (pages.At(pageNo - 1) && 0 == pageUsers.At(pageNo - 1)) {
+            delete pages.At(pageNo - 1);
+            pages.At(pageNo - 1) = NULL;
+        }
+    }
+}
+
+// returns the page's encoded image data without copying it, if possible
+const char *CbxEngineImpl::GetImageDataView(int pageNo, size_t& len)
+{
+    // note: cached .cbr data might be evicted at any time
+    if (cbzFile)
+        return cbzFile->GetFileDataView(fileIdxs.At(pageNo - 1), &len);
+    return NULL;
+}
+
+Bitmap *CbxEngineImpl::DecodeImage(int pageNo)
+{
+    // uncompressed images can be decoded straight from the memory mapped file
     size_t len;
+    const char *bmpView = GetImageDataView(pageNo, len);
+    if (bmpView)
+        return BitmapFromData(bmpView, len);
     ScopedMem<char> bmpData(GetImageData(pageNo, len));
     if (bmpData)
-        pages.At(pageNo - 1) = BitmapFromData(bmpData, len);
+        return BitmapFromData(bmpData, len);
+    return NULL;
+}
 
-    return pages.At(pageNo - 1);
+void CbxEngineImpl::StartPrefetching(int pageNo, float zoom)
+{
+    if (pageNo > PageCount())
+        return;
+
+    ScopedCritSec scope(&fileAccess);
+    if (prefetchPageNo == pageNo && prefetchZoom == zoom)
+        return;
+    // supersedes any previous request (which the prefetch thread
+    // abandons after the page it's currently decoding)
+    prefetchPageNo = pageNo;
+    prefetchZoom = zoom;
+    if (!prefetchThread) {
+        prefetchThread = new CbxPrefetchThread(this);
+        prefetchThread->Start();
+    }
+    SetEvent(prefetchRequested);
+}
+
+void CbxEngineImpl::PrefetchPages(CbxPrefetchThread *thread)
+{
+    for (;;) {
+        WaitForSingleObject(prefetchRequested, INFINITE);
+        if (thread->WasCancelRequested())
+            break;
+
+        int pageNo;
+        float zoom;
+        {
+            ScopedCritSec scope(&fileAccess);
+            pageNo = prefetchPageNo;
+            zoom = prefetchZoom;
+        }
+        int lastPageNo = min(pageNo + CBX_PREFETCH_PAGES - 1, PageCount());
+        for (int i = pageNo; i <= lastPageNo && !thread->WasCancelRequested(); i++) {
+            {
+                ScopedCritSec scope(&fileAccess);
+                // prefetchRequested has been signaled again for a newer request
+                if (prefetchPageNo != pageNo || prefetchZoom != zoom)
+                    break;
+            }
+            PrefetchPage(i, zoom);
+        }
+    }
+}
+
+void CbxEngineImpl::PrefetchPage(int pageNo, float zoom)
+{
+    Bitmap *bmp;
+    {
+        ScopedCritSec scope(&fileAccess);
+        // the page is already being decoded by a rendering thread
+        if (isDecoding.At(pageNo - 1))
+            return;
+        bmp = pages.At(pageNo - 1);
+        if (!bmp) {
+            isDecoding.At(pageNo - 1) = true;
+            prefetchingPageNo = pageNo;
+            ResetEvent(prefetchDone);
+            LeaveCriticalSection(&fileAccess);
+            Timer t(true);
+            // note: ZipFile allows reading in parallel to the rendering thread
+            bmp = DecodeImage(pageNo);
+            dbglog::LogF("CbxEngine: prefetching page %d took %.2f ms", pageNo, t.GetTimeInMs());
+            EnterCriticalSection(&fileAccess);
+            isDecoding.At(pageNo - 1) = false;
+            pages.At(pageNo - 1) = bmp;
+            prefetchingPageNo = 0;
+            SetEvent(prefetchDone);
+        }
+        // keep the image while it's being downscaled
+        if (bmp)
+            pageUsers.At(pageNo - 1)++;
+    }
+
+    // also prepare the downscaled image for display at the requested zoom level
+    if (bmp && zoom > 0) {
+        RectI screen = Transform(PageMediabox(pageNo), pageNo, zoom, 0).Round();
+        ScopedCritSec scope(&scaledAccess);
+        GetScaledPage(pageNo, bmp, screen.Size());
+    }
+    if (bmp)
+        ReleaseImage(pageNo);
+}
+
+bool CbxEngineImpl::RenderPage(HDC hDC, RectI screenRect, int pageNo, float zoom, int rotation, RectD *pageRect, RenderTarget target, AbortCookie **cookie_out)
+{
+    // page-flip latency (including waiting for a page being prefetched)
+    Timer t(true);
+    // pages are usually viewed in order, so already decode the following ones
+    StartPrefetching(pageNo + 1, zoom);
+
+    Bitmap *bmp = AcquireImage(pageNo);
+    if (!bmp)
+        return false;
+    {
+        ScopedCritSec scope(&fileAccess);
+        currPageNo = pageNo;
+        DropDistantPages();
+    }
+
+    RectI pageRcI = PageMediabox(pageNo).Round();
+    // the downscaled image is independent of rotation
+    RectI screen = Transform(pageRcI.Convert<double>(), pageNo, zoom, 0).Round();
+
+    bool ok;
+    {
+        ScopedCritSec scope(&scaledAccess);
+        Bitmap *scaled = GetScaledPage(pageNo, bmp, screen.Size());
+        if (scaled)
+            ok = RenderImage(hDC, screenRect, scaled, screen.Size(), pageNo, zoom, rotation, pageRect);
+        else
+            ok = RenderImage(hDC, screenRect, bmp, pageRcI.Size(), pageNo, zoom, rotation, pageRect);
+    }
+    ReleaseImage(pageNo);
+    dbglog::LogF("CbxEngine: rendering page %d took %.2f ms", pageNo, t.GetTimeInMs());
+    return ok;
+}
+
+// returns the page image downscaled to size (or NULL if no downscaling is needed)
+// caller must hold scaledAccess for as long as the result is in use
+Bitmap *CbxEngineImpl::GetScaledPage(int pageNo, Bitmap *bmp, SizeI size)
+{
+    // downscaling only pays off for significantly smaller sizes
+    if (size.IsEmpty() || size.dx * 4 > (int)bmp->GetWidth() * 3 && size.dy * 4 > (int)bmp->GetHeight() * 3)
+        return NULL;
+
+    for (size_t i = 0; i < scaledPages.Count(); i++) {
+        ScaledPage page = scaledPages.At(i);
+        if (page.pageNo != pageNo || page.size != size)
+            continue;
+        // move to the end of the LRU list
+        scaledPages.RemoveAt(i);
+        scaledPages.Append(page);
+        return page.bmp;
+    }
+
+    size_t bytes = (size_t)size.dx * size.dy * 4;
+    if (bytes > CBX_SCALED_CACHE_BUDGET)
+        return NULL;
+    while (scaledPagesSize + bytes > CBX_SCALED_CACHE_BUDGET && scaledPages.Count() > 0) {
+        ScaledPage& lru = scaledPages.At(0);
+        scaledPagesSize -= (size_t)lru.size.dx * lru.size.dy * 4;
+        delete lru.bmp;
+        scaledPages.RemoveAt(0);
+    }
+
+    ScaledPage page = { pageNo, new Bitmap(size.dx, size.dy, PixelFormat32bppARGB), size };
+    if (page.bmp->GetLastStatus() != Ok) {
+        delete page.bmp;
+        return NULL;
+    }
+    Graphics g(page.bmp);
+    g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+    g.SetPixelOffsetMode(PixelOffsetModeHighQuality);
+    ImageAttributes imgAttrs;
+    imgAttrs.SetWrapMode(WrapModeTileFlipXY);
+    Rect dst(0, 0, size.dx, size.dy);
+    RectI src = PageMediabox(pageNo).Round();
+    if (g.DrawImage(bmp, dst, 0, 0, src.dx, src.dy, UnitPixel, &imgAttrs) != Ok) {
+        delete page.bmp;
+        return NULL;
+    }
+
+    scaledPages.Append(page);
+    scaledPagesSize += bytes;
+    return page.bmp;
 }
 
 bool CbxEngineImpl::LoadCbzFile(const WCHAR *file)
@@ -769,6 +1166,8 @@ bool CbxEngineImpl::FinishLoadingCbz()
 
     pages.AppendBlanks(fileIdxs.Count());
     mediaboxes.AppendBlanks(fileIdxs.Count());
+    isDecoding.AppendBlanks(fileIdxs.Count());
+    pageUsers.AppendBlanks(fileIdxs.Count());
 
     return true;
 }
@@ -883,22 +1282,6 @@ WCHAR *CbxEngineImpl::GetProperty(DocumentProperty prop)
     }
 }
 
-class ImagesPage {
-public:
-    ScopedMem<WCHAR>fileName; // for sorting image files
-    Bitmap *        bmp;
-
-    ImagesPage(const WCHAR *fileName, Bitmap *bmp) : bmp(bmp),
-        fileName(str::Dup(fileName)) { }
-    ~ImagesPage() { delete bmp; }
-
-    static int cmpPageByName(const void *o1, const void *o2) {
-        ImagesPage *p1 = *(ImagesPage **)o1;
-        ImagesPage *p2 = *(ImagesPage **)o2;
-        return wcscmp(p1->fileName, p2->fileName);
-    }
-};
-
 struct RarDecompressData {
     unsigned    totalSize;
     char *      buf;
@@ -956,11 +1339,12 @@ static ImagesPage *LoadCurrentCbrPage(HANDLE hArc, RARHeaderDataEx& rarHeader)
     if (!bmpData)
         return NULL;
 
-    Bitmap *bmp = BitmapFromData(bmpData, bmpDataSize);
-    if (!bmp)
+    // images are only decoded when needed (see CbxEngineImpl::LoadImage)
+    Size size = BitmapSizeFromData(bmpData, bmpDataSize);
+    if (size.Empty())
         return NULL;
 
-    return new ImagesPage(rarHeader.FileNameW, bmp);
+    return new ImagesPage(rarHeader.FileNameW, bmpData.StealData(), bmpDataSize, size);
 }
 
 bool CbxEngineImpl::LoadCbrFile(const WCHAR *file)
@@ -979,7 +1363,10 @@ bool CbxEngineImpl::LoadCbrFile(const WCHAR *file)
         return false;
 
     // UnRAR does not seem to support extracting a single file by name,
-    // so lazy image loading doesn't seem possible
+    // so all images are extracted in a single pass (for determining their
+    // size) and only decoded lazily. For non-solid archives, the files'
+    // header positions are remembered for extracting them again later
+    bool canSeek = !(arcData.Flags & (0x01 /* volume */ | 0x08 /* solid */));
 
     Vec<ImagesPage *> found;
     for (;;) {
@@ -990,7 +1377,14 @@ bool CbxEngineImpl::LoadCbrFile(const WCHAR *file)
 
         const WCHAR *fileName = rarHeader.FileNameW;
         if (ImageEngine::IsSupportedFile(fileName)) {
+            unsigned int posLow, posHigh;
+            bool hasPos = canSeek && RARGetHeaderPos(hArc, &posLow, &posHigh) == ERAR_SUCCESS;
             ImagesPage *page = LoadCurrentCbrPage(hArc, rarHeader);
+            if (page && hasPos) {
+                page->hasHeaderPos = true;
+                page->headerPosLow = posLow;
+                page->headerPosHigh = posHigh;
+            }
             if (page)
                 found.Append(page);
         }
@@ -1010,21 +1404,104 @@ bool CbxEngineImpl::LoadCbrFile(const WCHAR *file)
     found.Sort(ImagesPage::cmpPageByName);
 
     for (size_t i = 0; i < found.Count(); i++) {
-        pages.Append(found.At(i)->bmp);
-        found.At(i)->bmp = NULL;
+        Size size = found.At(i)->size;
+        mediaboxes.Append(RectD(0, 0, size.Width, size.Height));
+    }
+    cbrPages.Append(found.LendData(), found.Count());
+    pages.AppendBlanks(cbrPages.Count());
+    isDecoding.AppendBlanks(cbrPages.Count());
+    pageUsers.AppendBlanks(cbrPages.Count());
+
+    // only keep the data of the first pages (which are the most likely to be viewed first)
+    for (size_t i = 0; i < cbrPages.Count(); i++) {
+        ImagesPage *page = cbrPages.At(i);
+        if (cbrDataSize + page->len <= CBR_DATA_CACHE_BUDGET) {
+            cbrDataSize += page->len;
+            cbrDataLru.Append((int)i + 1);
+        }
+        else {
+            free(page->data);
+            page->data = NULL;
+        }
     }
-    mediaboxes.AppendBlanks(pages.Count());
 
-    DeleteVecMembers(found);
     return true;
 }
 
+// extracts a page's image file again (seeking straight to its header
+// if possible and searching the archive for it otherwise)
+char *CbxEngineImpl::LoadCbrPageData(int pageNo, size_t *lenOut)
+{
+    RAROpenArchiveDataEx  arcData = { 0 };
+    arcData.ArcNameW = fileName;
+    arcData.OpenMode = RAR_OM_EXTRACT;
+
+    HANDLE hArc = RAROpenArchiveEx(&arcData);
+    if (!hArc || arcData.OpenResult != 0)
+        return NULL;
+
+    char *data = NULL;
+    ImagesPage *page = cbrPages.At(pageNo - 1);
+    if (page->hasHeaderPos && RARSeekToHeader(hArc, page->headerPosLow, page->headerPosHigh) == ERAR_SUCCESS) {
+        RARHeaderDataEx rarHeader;
+        if (RARReadHeaderEx(hArc, &rarHeader) == 0 && str::Eq(rarHeader.FileNameW, page->fileName))
+            data = LoadCurrentCbrFile(hArc, rarHeader, lenOut);
+        RARCloseArchive(hArc);
+        return data;
+    }
+
+    for (;;) {
+        RARHeaderDataEx rarHeader;
+        int res = RARReadHeaderEx(hArc, &rarHeader);
+        if (0 != res)
+            break;
+        if (str::Eq(rarHeader.FileNameW, cbrPages.At(pageNo - 1)->fileName)) {
+            data = LoadCurrentCbrFile(hArc, rarHeader, lenOut);
+            break;
+        }
+        RARProcessFile(hArc, RAR_SKIP, NULL, NULL);
+    }
+    RARCloseArchive(hArc);
+
+    return data;
+}
+
+// marks a page's data as most recently used and evicts the data of
+// the least recently used pages beyond CBR_DATA_CACHE_BUDGET
+// caller must hold cbrAccess
+void CbxEngineImpl::UpdateCbrDataCache(int pageNo)
+{
+    cbrDataLru.Remove(pageNo);
+    cbrDataLru.Append(pageNo);
+    while (cbrDataSize > CBR_DATA_CACHE_BUDGET && cbrDataLru.Count() > 1) {
+        ImagesPage *lru = cbrPages.At(cbrDataLru.At(0) - 1);
+        cbrDataSize -= lru->len;
+        free(lru->data);
+        lru->data = NULL;
+        cbrDataLru.RemoveAt(0);
+    }
+}
+
 char *CbxEngineImpl::GetImageData(int pageNo, size_t& len)
 {
-    if (cbzFile) {
-        ScopedCritSec scope(&fileAccess);
-        return cbzFile->GetFileDataByIdx(fileIdxs.At(pageNo - 1), &len);
+    if (cbrPages.Count() > 0) {
+        ScopedCritSec scope(&cbrAccess);
+        ImagesPage *page = cbrPages.At(pageNo - 1);
+        if (!page->data) {
+            size_t dataLen;
+            page->data = LoadCbrPageData(pageNo, &dataLen);
+            if (!page->data)
+                return NULL;
+            page->len = dataLen;
+            cbrDataSize += page->len;
+        }
+        UpdateCbrDataCache(pageNo);
+        len = page->len;
+        return (char *)memdup(page->data, len + sizeof(WCHAR));
     }
+    // ZipFile does its own locking (if it's needed at all)
+    if (cbzFile)
+        return cbzFile->GetFileDataByIdx(fileIdxs.At(pageNo - 1), &len);
     return NULL;
 }
 
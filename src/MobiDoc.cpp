@@ -10,6 +10,7 @@
 using namespace Gdiplus;
 #include "GdiPlusUtil.h"
 #include "PalmDbReader.h"
+#include "ThreadUtil.h"
 #include "DebugLog.h"
 
 // Parse mobi format http://wiki.mobileread.com/wiki/MOBI
@@ -171,7 +172,7 @@ struct CdicHeader
 {
     char        id[4];      // "CIDC"
     uint32      hdrLen;     // should be 16
-    uint32      unknown;
+    uint32      phrasesCount; // total number of phrases in all CDIC records
     uint32      codeLen;
 };
 
@@ -187,6 +188,18 @@ STATIC_ASSERT(kCdicHeaderLen == sizeof(CdicHeader), validCdicHeader);
 
 #define kCdicsMax 32
 
+// a dictionary phrase, expanded to the final text it decodes to
+// (non-terminal phrases are themselves HuffDic compressed and would
+// otherwise have to be re-decompressed at every occurrence)
+struct HuffDicSymbol
+{
+    enum State { Unexpanded = 0, Expanding, Expanded, Invalid };
+
+    uint32      offset; // within HuffDicDecompressor::symbolData
+    uint32      len;
+    State       state;
+};
+
 class HuffDicDecompressor
 {
     uint32      cacheTable[kCacheItemCount];
@@ -196,32 +209,43 @@ class HuffDicDecompressor
     // owned by the creator (in our case: by the PdbReader)
     uint8 *     dicts[kCdicsMax];
     uint32      dictSize[kCdicsMax];
+    // number of phrases in each dictionary and the index of its
+    // first phrase within symbols
+    uint32      dictPhrases[kCdicsMax];
+    uint32      dictFirstSymbol[kCdicsMax];
 
     uint32      codeLength;
+    uint32      phrasesCount;
+
+    Vec<HuffDicSymbol> symbols;
+    str::Str<char> symbolData;
+    bool        isExpanded;
 
-    Vec<uint32> recursionGuard;
+    bool DecodeCodes(uint8 *src, size_t srcSize, str::Str<char>& dst);
+    bool AppendSymbol(uint32 code, str::Str<char>& dst);
+    bool ExpandSymbol(uint16 dict, uint32 code, HuffDicSymbol& sym);
 
 public:
     HuffDicDecompressor();
 
     bool SetHuffData(uint8 *huffData, size_t huffDataLen);
     bool AddCdicData(uint8 *cdicData, uint32 cdicDataLen);
+    // expands all dictionary phrases once so that Decompress only
+    // has to copy them. After this, Decompress no longer modifies
+    // the decompressor and can be called from several threads at once
+    bool ExpandDictionary();
     bool Decompress(uint8 *src, size_t octets, str::Str<char>& dst);
-    bool DecodeOne(uint32 code, str::Str<char>& dst);
 };
 
-HuffDicDecompressor::HuffDicDecompressor() : codeLength(0), dictsCount(0) { }
+HuffDicDecompressor::HuffDicDecompressor() :
+    codeLength(0), phrasesCount(0), dictsCount(0), isExpanded(false) { }
 
-bool HuffDicDecompressor::DecodeOne(uint32 code, str::Str<char>& dst)
+bool HuffDicDecompressor::ExpandSymbol(uint16 dict, uint32 code, HuffDicSymbol& sym)
 {
-    uint16 dict = (uint16)(code >> codeLength);
-    if (dict >= dictsCount) {
-        lf("invalid dict value");
-        return false;
-    }
-    code &= ((1 << (codeLength)) - 1);
-    uint16 offset = UInt16BE(dicts[dict] + code * 2);
+    CrashIf(sym.state != HuffDicSymbol::Unexpanded);
+    sym.state = HuffDicSymbol::Invalid;
 
+    uint16 offset = UInt16BE(dicts[dict] + code * 2);
     if ((uint32)offset + 2 > dictSize[dict]) {
         lf("invalid offset");
         return false;
@@ -234,26 +258,60 @@ bool HuffDicDecompressor::DecodeOne(uint32 code, str::Str<char>& dst)
     }
 
     if (!(symLen & 0x8000)) {
-        if (recursionGuard.Contains(code)) {
-            lf("infinite recursion");
+        // the phrases this one consists of are appended to symbolData
+        // while decompressing, so collect the result separately
+        str::Str<char> expanded;
+        sym.state = HuffDicSymbol::Expanding;
+        if (!DecodeCodes(p, symLen, expanded)) {
+            sym.state = HuffDicSymbol::Invalid;
             return false;
         }
-        recursionGuard.Push(code);
-        if (!Decompress(p, symLen, dst))
-            return false;
-        recursionGuard.Pop();
+        sym.offset = (uint32)symbolData.Size();
+        sym.len = (uint32)expanded.Size();
+        symbolData.Append(expanded.Get(), expanded.Size());
     } else {
         symLen &= 0x7fff;
         if (symLen > 127) {
             lf("symLen too big");
             return false;
         }
-        dst.Append((char *)p, symLen);
+        sym.offset = (uint32)symbolData.Size();
+        sym.len = symLen;
+        symbolData.Append((char *)p, symLen);
     }
+    sym.state = HuffDicSymbol::Expanded;
     return true;
 }
 
-bool HuffDicDecompressor::Decompress(uint8 *src, size_t srcSize, str::Str<char>& dst)
+bool HuffDicDecompressor::AppendSymbol(uint32 code, str::Str<char>& dst)
+{
+    uint16 dict = (uint16)(code >> codeLength);
+    if (dict >= dictsCount) {
+        lf("invalid dict value");
+        return false;
+    }
+    code &= ((1 << (codeLength)) - 1);
+    if (code >= dictPhrases[dict]) {
+        lf("invalid code");
+        return false;
+    }
+
+    HuffDicSymbol& sym = symbols.At(dictFirstSymbol[dict] + code);
+    if (HuffDicSymbol::Unexpanded == sym.state) {
+        CrashIf(isExpanded);
+        ExpandSymbol(dict, code, sym);
+    }
+    if (HuffDicSymbol::Expanding == sym.state) {
+        lf("infinite recursion");
+        return false;
+    }
+    if (HuffDicSymbol::Expanded != sym.state)
+        return false;
+    dst.Append(symbolData.Get() + sym.offset, sym.len);
+    return true;
+}
+
+bool HuffDicDecompressor::DecodeCodes(uint8 *src, size_t srcSize, str::Str<char>& dst)
 {
     uint32    bitsConsumed = 0;
     uint32    bits = 0;
@@ -298,7 +356,7 @@ bool HuffDicDecompressor::Decompress(uint8 *src, size_t srcSize, str::Str<char>&
             code = baseTable[codeLen * 2 - 1] - (bits >> (32 - codeLen));
         }
 
-        if (!DecodeOne(code, dst))
+        if (!AppendSymbol(code, dst))
             return false;
         bitsConsumed = codeLen;
     }
@@ -309,6 +367,27 @@ bool HuffDicDecompressor::Decompress(uint8 *src, size_t srcSize, str::Str<char>&
     return true;
 }
 
+bool HuffDicDecompressor::ExpandDictionary()
+{
+    if (0 == dictsCount)
+        return false;
+    for (uint16 dict = 0; dict < dictsCount; dict++) {
+        for (uint32 code = 0; code < dictPhrases[dict]; code++) {
+            HuffDicSymbol& sym = symbols.At(dictFirstSymbol[dict] + code);
+            // corrupted phrases only matter if they're actually used
+            if (HuffDicSymbol::Unexpanded == sym.state)
+                ExpandSymbol(dict, code, sym);
+        }
+    }
+    isExpanded = true;
+    return true;
+}
+
+bool HuffDicDecompressor::Decompress(uint8 *src, size_t srcSize, str::Str<char>& dst)
+{
+    return DecodeCodes(src, srcSize, dst);
+}
+
 bool HuffDicDecompressor::SetHuffData(uint8 *huffData, size_t huffDataLen)
 {
     // for now catch cases where we don't have both big endian and little endian
@@ -358,6 +437,7 @@ bool HuffDicDecompressor::AddCdicData(uint8 *cdicData, uint32 cdicDataLen)
     if (!str::EqN("CDIC", (char *)cdicData, 4))
         return false;
     uint32 hdrLen = UInt32BE(cdicData + 4);
+    uint32 phrases = UInt32BE(cdicData + 8);
     uint32 codeLen = UInt32BE(cdicData + 12);
     if (0 == codeLength)
         codeLength = codeLen;
@@ -365,6 +445,8 @@ bool HuffDicDecompressor::AddCdicData(uint8 *cdicData, uint32 cdicDataLen)
         assert(codeLen == codeLength);
         codeLength = min(codeLength, codeLen);
     }
+    if (0 == phrasesCount)
+        phrasesCount = phrases;
     assert(hdrLen == kCdicHeaderLen);
     if (hdrLen != kCdicHeaderLen)
         return false;
@@ -373,8 +455,18 @@ bool HuffDicDecompressor::AddCdicData(uint8 *cdicData, uint32 cdicDataLen)
     uint32 maxSize = 1 << codeLength;
     if (maxSize >= size)
         return false;
+    // each dictionary holds up to 1 << codeLength phrases, the last one the rest
+    uint32 firstSymbol = (uint32)symbols.Count();
+    uint32 count = maxSize;
+    if (phrasesCount > firstSymbol && phrasesCount - firstSymbol < maxSize)
+        count = phrasesCount - firstSymbol;
+    // the phrase offset table must fit into the dictionary
+    count = min(count, size / 2);
     dicts[dictsCount] = cdicData + hdrLen;
     dictSize[dictsCount] = size;
+    dictPhrases[dictsCount] = count;
+    dictFirstSymbol[dictsCount] = firstSymbol;
+    symbols.AppendBlanks(count);
     ++dictsCount;
     return true;
 }
@@ -460,14 +552,17 @@ MobiDoc::MobiDoc(const WCHAR *filePath) :
     fileName(str::Dup(filePath)), pdbReader(NULL),
     docType(Pdb_Unknown), docRecCount(0), compressionType(0), docUncompressedSize(0),
     doc(NULL), multibyte(false), trailersCount(0), imageFirstRec(0), coverImageRec(0),
-    imagesCount(0), images(NULL), huffDic(NULL), textEncoding(CP_UTF8)
+    imagesCount(0), images(NULL), imagesLoaded(NULL), huffDic(NULL), textEncoding(CP_UTF8)
 {
+    InitializeCriticalSection(&imagesAccess);
 }
 
 MobiDoc::~MobiDoc()
 {
     free(fileName);
     free(images);
+    free(imagesLoaded);
+    DeleteCriticalSection(&imagesAccess);
     delete huffDic;
     delete doc;
     delete pdbReader;
@@ -587,6 +682,8 @@ bool MobiDoc::ParseHeader()
             if (!huffDic->AddCdicData((uint8*)recData, (uint32)huffRecSize))
                 return false;
         }
+        if (!huffDic->ExpandDictionary())
+            return false;
     }
 
     if ((mobiHdr.exthFlags & 0x40)) {
@@ -676,40 +773,48 @@ static bool KnownImageFormat(const char *data, size_t dataLen)
     return NULL != GfxFileExtFromData(data, dataLen);
 }
 
-// return false if we should stop loading images (because we
-// encountered eof record or ran out of memory)
-bool MobiDoc::LoadImage(size_t imageNo)
+// classifies an image record on first access (so that for large comic
+// books only the images actually displayed have to be read from disk)
+// caller must hold imagesAccess
+void MobiDoc::LoadImage(size_t imageNo) const
 {
+    if (imagesLoaded[imageNo])
+        return;
     size_t imageRec = imageFirstRec + imageNo;
     size_t imgDataLen;
 
     const char *imgData = pdbReader->GetRecord(imageRec, &imgDataLen);
-    if (!imgData || (0 == imgDataLen))
-        return true;
-    if (IsEofRecord((uint8 *)imgData, imgDataLen))
-        return false;
-    if (KnownNonImageRec((uint8 *)imgData, imgDataLen))
-        return true;
-    if (!KnownImageFormat(imgData, imgDataLen)) {
-        lf("Unknown image format");
-        return true;
+    if (imgData && imgDataLen > 0 && !KnownNonImageRec((uint8 *)imgData, imgDataLen)) {
+        if (KnownImageFormat(imgData, imgDataLen)) {
+            images[imageNo].data = (char *)imgData;
+            images[imageNo].len = imgDataLen;
+        } else {
+            lf("Unknown image format");
+        }
     }
-    images[imageNo].data = (char *)imgData;
-    if (!images[imageNo].data)
-        return false;
-    images[imageNo].len = imgDataLen;
-    return true;
+    imagesLoaded[imageNo] = true;
 }
 
 void MobiDoc::LoadImages()
 {
     if (0 == imagesCount)
         return;
-    images = AllocArray<ImageData>(imagesCount);
+    // images end at the eof record, which can be found from
+    // the record sizes alone without touching the image data
     for (size_t i = 0; i < imagesCount; i++) {
-        if (!LoadImage(i))
-            return;
+        if (pdbReader->GetRecordSize(imageFirstRec + i) != 4)
+            continue;
+        size_t recSize;
+        const char *recData = pdbReader->GetRecord(imageFirstRec + i, &recSize);
+        if (recData && IsEofRecord((uint8 *)recData, recSize)) {
+            imagesCount = i;
+            break;
+        }
     }
+    images = AllocArray<ImageData>(imagesCount);
+    imagesLoaded = AllocArray<bool>(imagesCount);
+    if (!images || !imagesLoaded)
+        imagesCount = 0;
 }
 
 // imgRecIndex corresponds to recindex attribute of <img> tag
@@ -721,6 +826,9 @@ ImageData *MobiDoc::GetImage(size_t imgRecIndex) const
     if ((imgRecIndex > imagesCount) || (imgRecIndex < 1))
         return NULL;
     --imgRecIndex;
+    // GetImage can be called from several threads at once
+    ScopedCritSec scope(const_cast<CRITICAL_SECTION *>(&imagesAccess));
+    LoadImage(imgRecIndex);
     if (!images[imgRecIndex].data || (0 == images[imgRecIndex].len))
         return NULL;
     return &images[imgRecIndex];
@@ -730,10 +838,7 @@ ImageData *MobiDoc::GetCoverImage()
 {
     if (!coverImageRec || coverImageRec < imageFirstRec)
         return NULL;
-    size_t imageNo = coverImageRec - imageFirstRec;
-    if (imageNo >= imagesCount || !images[imageNo].data)
-        return NULL;
-    return &images[imageNo];
+    return GetImage(coverImageRec - imageFirstRec + 1);
 }
 
 // each record can have extra data at the end, which we must discard
@@ -772,7 +877,9 @@ static size_t GetRealRecordSize(uint8 *recData, size_t recLen, size_t trailersCo
 bool MobiDoc::LoadDocRecordIntoBuffer(size_t recNo, str::Str<char>& strOut)
 {
     size_t recSize;
-    const char *recData = pdbReader->GetRecord(recNo, &recSize);
+    // text records are only needed once, so don't keep them in memory
+    ScopedMem<char> recBuf;
+    const char *recData = pdbReader->GetRecordTemp(recNo, &recSize, recBuf);
     if (NULL == recData)
         return false;
     recSize = GetRealRecordSize((uint8*)recData, recSize, trailersCount, multibyte);
@@ -800,6 +907,67 @@ bool MobiDoc::LoadDocRecordIntoBuffer(size_t recNo, str::Str<char>& strOut)
     return false;
 }
 
+// HuffDic decompression is CPU bound and each text record can be
+// decompressed independently, so larger documents are split into
+// consecutive ranges of records which are decompressed in parallel
+#define kMinHuffDicRecordsPerThread 64
+#define kMaxHuffDicThreads          8
+
+class HuffDicDecodeThread : public ThreadBase {
+    MobiDoc *       doc;
+    size_t          firstRec;
+    size_t          lastRec;
+
+public:
+    str::Str<char>  data;
+    bool            ok;
+
+    HuffDicDecodeThread(MobiDoc *doc, size_t firstRec, size_t lastRec, size_t sizeHint) :
+        ThreadBase("HuffDicDecodeThread"), doc(doc), firstRec(firstRec),
+        lastRec(lastRec), data(sizeHint), ok(false) { }
+    virtual ~HuffDicDecodeThread() { }
+
+    virtual void Run() {
+        for (size_t i = firstRec; i <= lastRec; i++) {
+            if (!doc->LoadDocRecordIntoBuffer(i, data))
+                return;
+        }
+        ok = true;
+    }
+};
+
+static size_t GetHuffDicThreadCount(size_t recCount)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t threads = min((size_t)si.dwNumberOfProcessors, (size_t)kMaxHuffDicThreads);
+    return max(min(threads, recCount / kMinHuffDicRecordsPerThread), (size_t)1);
+}
+
+bool MobiDoc::LoadHuffDicRecordsParallel(size_t threadsCount)
+{
+    size_t recsPerThread = (docRecCount + threadsCount - 1) / threadsCount;
+    size_t sizeHint = docUncompressedSize / threadsCount;
+    Vec<HuffDicDecodeThread *> threads;
+    for (size_t firstRec = 1; firstRec <= docRecCount; firstRec += recsPerThread) {
+        size_t lastRec = min(firstRec + recsPerThread - 1, docRecCount);
+        HuffDicDecodeThread *thread = new HuffDicDecodeThread(this, firstRec, lastRec, sizeHint);
+        threads.Append(thread);
+        thread->Start();
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < threads.Count(); i++) {
+        HuffDicDecodeThread *thread = threads.At(i);
+        thread->Join();
+        ok = ok && thread->ok;
+        if (ok)
+            doc->Append(thread->data.Get(), thread->data.Size());
+        delete thread;
+    }
+    return ok;
+}
+
 bool MobiDoc::LoadDocument()
 {
     if (!ParseHeader())
@@ -807,9 +975,17 @@ bool MobiDoc::LoadDocument()
 
     assert(!doc);
     doc = new str::Str<char>(docUncompressedSize);
-    for (size_t i = 1; i <= docRecCount; i++) {
-        if (!LoadDocRecordIntoBuffer(i, *doc))
+    size_t threadsCount = 1;
+    if (COMPRESSION_HUFF == compressionType && huffDic)
+        threadsCount = GetHuffDicThreadCount(docRecCount);
+    if (threadsCount > 1) {
+        if (!LoadHuffDicRecordsParallel(threadsCount))
             return false;
+    } else {
+        for (size_t i = 1; i <= docRecCount; i++) {
+            if (!LoadDocRecordIntoBuffer(i, *doc))
+                return false;
+        }
     }
     // replace unexpected \0 with spaces
     // cf. https://code.google.com/p/sumatrapdf/issues/detail?id=2529
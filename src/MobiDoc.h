@@ -14,6 +14,8 @@ enum PdbDocType { Pdb_Unknown, Pdb_Mobipocket, Pdb_PalmDoc, Pdb_TealDoc };
 
 class MobiDoc
 {
+    friend class HuffDicDecodeThread;
+
     WCHAR *             fileName;
 
     PdbReader *         pdbReader;
@@ -30,6 +32,9 @@ class MobiDoc
     size_t              coverImageRec; // 0 if no cover image
 
     ImageData *         images;
+    // images are only classified on first access
+    bool *              imagesLoaded;
+    CRITICAL_SECTION    imagesAccess;
 
     HuffDicDecompressor *huffDic;
 
@@ -43,8 +48,9 @@ class MobiDoc
 
     bool    ParseHeader();
     bool    LoadDocRecordIntoBuffer(size_t recNo, str::Str<char>& strOut);
+    bool    LoadHuffDicRecordsParallel(size_t threadsCount);
     void    LoadImages();
-    bool    LoadImage(size_t imageNo);
+    void    LoadImage(size_t imageNo) const;
     bool    LoadDocument();
     bool    DecodeExthHeader(const char *data, size_t dataLen);
 
@@ -243,6 +243,24 @@ void CommandLineInfo::ParseCommandLine(WCHAR *cmdLine)
             }
             pathsToBenchmark.Push(s);
             exitImmediately = true;
+        }
+        else if (is_arg_with_param("-bench-zoom")) {
+            // e.g. -bench foo.pdf -bench-zoom 100,250 -bench-rotation 0,90
+            // renders each page at 100% and 250%, upright and rotated
+            str::ReplacePtr(&benchZoomLevels, argList.At(++n));
+        }
+        else if (is_arg_with_param("-bench-rotation")) {
+            str::ReplacePtr(&benchRotations, argList.At(++n));
+        }
+        else if (is_arg_with_param("-bench-json")) {
+            // saves timing percentiles, memory usage and cache statistics
+            // (use -n <count> to benchmark with several engines concurrently)
+            str::ReplacePtr(&benchJsonPath, argList.At(++n));
+        }
+        else if (is_arg_with_param("-trace")) {
+            // records rendering, text extraction and image decoding
+            // and saves it for chrome://tracing when exiting
+            str::ReplacePtr(&tracePath, argList.At(++n));
         } else if (is_arg("-crash-on-open")) {
             // to make testing of crash reporting system in pre-release/release
             // builds possible
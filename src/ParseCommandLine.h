@@ -15,6 +15,14 @@ public:
     //   to benchmark. It can also be a string "loadonly" which means we'll
     //   only benchmark loading of the catalog
     WStrVec     pathsToBenchmark;
+    // comma separated zoom levels (in percent) and rotations at which
+    // to render benchmarked pages (default: "100" and "0")
+    WCHAR *     benchZoomLevels;
+    WCHAR *     benchRotations;
+    // where to save benchmark results as JSON (NULL for not saving them)
+    WCHAR *     benchJsonPath;
+    // where to save a trace of hot paths (NULL for not tracing)
+    WCHAR *     tracePath;
     bool        makeDefault;
     bool        exitWhenDone;
     bool        printDialog;
@@ -50,7 +58,7 @@ public:
     WCHAR *     stressTestFilter; // NULL is equivalent to "*" (i.e. all files)
     WCHAR *     stressTestRanges;
     int         stressTestCycles;
-    int         stressParallelCount;
+    int         stressParallelCount; // also the number of concurrent -bench threads
     bool        stressRandomizeFiles;
 
     bool        crashOnOpen;
@@ -59,6 +67,8 @@ public:
         printerName(NULL), printSettings(NULL), bgColor((COLORREF)-1),
         escToExit(false), reuseInstance(false), lang(NULL),
         destName(NULL), pageNumber(-1), inverseSearchCmdLine(NULL),
+        benchZoomLevels(NULL), benchRotations(NULL), benchJsonPath(NULL),
+        tracePath(NULL),
         restrictedUse(false), pluginURL(NULL),
         enterPresentation(false), enterFullScreen(false), hwndPluginParent(NULL),
         startView(DM_AUTOMATIC), startZoom(INVALID_ZOOM), startScroll(PointI(-1, -1)),
@@ -88,6 +98,10 @@ public:
         free(stressTestRanges);
         free(stressTestFilter);
         free(pluginURL);
+        free(benchZoomLevels);
+        free(benchRotations);
+        free(benchJsonPath);
+        free(tracePath);
     }
 
     void ParseCommandLine(WCHAR *cmdLine);
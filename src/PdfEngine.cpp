@@ -13,6 +13,8 @@ extern "C" {
 
 #include "FileUtil.h"
 #include "HtmlPullParser.h"
+#include "ThreadUtil.h"
+#include "Trace.h"
 #include "TrivialHtmlParser.h"
 #include "WinUtil.h"
 #include "ZipUtil.h"
@@ -26,6 +28,9 @@ extern "C" {
 #define MAX_PAGE_RUN_CACHE  8
 // maximum estimated memory requirement allowed for the run cache of one document
 #define MAX_PAGE_RUN_MEMORY (40 * 1024 * 1024)
+// for documents with more pages, page sizes are only determined on demand
+// (DisplayModel lays out the remaining pages with estimated sizes meanwhile)
+#define MAX_EAGERLY_MEASURED_PAGES 2000
 
 // maximum amount of memory that MuPDF should use per fz_context store
 #define MAX_CONTEXT_MEMORY  (256 * 1024 * 1024)
@@ -171,6 +176,95 @@ ProducingPaletteDone:
     return new RenderedBitmap(hbmp, SizeI(pixmap->w, pixmap->h));
 }
 
+struct mapped_file {
+    const char *data;
+    int len;
+    LONG refs;
+};
+
+extern "C" static int next_mapped(fz_stream *stm, int max)
+{
+    return EOF;
+}
+
+extern "C" static void seek_mapped(fz_stream *stm, int offset, int whence)
+{
+    mapped_file *state = (mapped_file *)stm->state;
+    if (1 == whence)
+        offset += (int)(stm->rp - (unsigned char *)state->data);
+    else if (2 == whence)
+        offset += state->len;
+    stm->rp = (unsigned char *)state->data + limitValue(offset, 0, state->len);
+}
+
+extern "C" static int meta_mapped(fz_stream *stm, int key, int size, void *ptr)
+{
+    // the mapping stays valid until the last clone is closed
+    return FZ_STREAM_META_MEMORY == key ? 1 : -1;
+}
+
+extern "C" static void close_mapped(fz_context *ctx, void *state_)
+{
+    mapped_file *state = (mapped_file *)state_;
+    if (0 == InterlockedDecrement(&state->refs)) {
+        file::UnmapView(state->data);
+        free(state);
+    }
+}
+
+static fz_stream *fz_open_mapped(fz_context *ctx, mapped_file *state);
+
+extern "C" static fz_stream *reopen_mapped(fz_context *ctx, fz_stream *stm)
+{
+    mapped_file *state = (mapped_file *)stm->state;
+    InterlockedIncrement(&state->refs);
+    return fz_open_mapped(ctx, state);
+}
+
+// the returned stream owns a reference to state
+static fz_stream *fz_open_mapped(fz_context *ctx, mapped_file *state)
+{
+    fz_stream *stm = fz_new_stream(ctx, state, next_mapped, close_mapped, NULL);
+    stm->seek = seek_mapped;
+    stm->meta = meta_mapped;
+    stm->reopen = reopen_mapped;
+
+    stm->rp = (unsigned char *)state->data;
+    stm->wp = stm->rp + state->len;
+    stm->pos = state->len;
+
+    return stm;
+}
+
+// reads a file directly from a memory mapping (so that mupdf's streams
+// and filters don't have to copy data through their buffers);
+// returns NULL if the file can't be mapped
+static fz_stream *fz_open_mapped_file(fz_context *ctx, const WCHAR *filePath)
+{
+    size_t len;
+    const char *data = file::MapView(filePath, &len);
+    if (!data)
+        return NULL;
+    mapped_file *state = len <= INT_MAX ? AllocStruct<mapped_file>() : NULL;
+    if (!state) {
+        file::UnmapView(data);
+        return NULL;
+    }
+    state->data = data;
+    state->len = (int)len;
+    state->refs = 1;
+
+    fz_stream *stm = NULL;
+    fz_try(ctx) {
+        stm = fz_open_mapped(ctx, state);
+    }
+    fz_catch(ctx) {
+        // state has been released by fz_new_stream
+        stm = NULL;
+    }
+    return stm;
+}
+
 fz_stream *fz_open_file2(fz_context *ctx, const WCHAR *filePath)
 {
     fz_stream *file = NULL;
@@ -193,6 +287,14 @@ fz_stream *fz_open_file2(fz_context *ctx, const WCHAR *filePath)
             return file;
     }
 
+    // larger files are memory mapped unless they're on a network or removable
+    // drive or have been modified recently
+    if (0 < fileSize && fileSize <= INT_MAX && file::IsSafeToMap(filePath)) {
+        file = fz_open_mapped_file(ctx, filePath);
+        if (file)
+            return file;
+    }
+
     fz_try(ctx) {
         file = fz_open_file_w(ctx, filePath);
     }
@@ -795,6 +897,34 @@ fz_unlock_context_cs(void *user, int lock)
     LeaveCriticalSection(cs);
 }
 
+// forwards fitz's fz_trace_begin/fz_trace_end to our tracing layer
+extern "C" static void
+fz_trace_span(const char *name, int begin)
+{
+    if (begin)
+        trace::BeginSpan(name);
+    else
+        trace::EndSpan(name);
+}
+
+// Note: make sure to only call with ctxAccess
+static void fz_get_cache_stats(fz_context *ctx, EngineCacheStats *stats)
+{
+    fz_store_stats store;
+    fz_get_store_stats(ctx, &store);
+    stats->storeSize = store.size;
+    stats->storeItems = store.items;
+    stats->storeHits = store.hits;
+    stats->storeMisses = store.misses;
+
+    fz_glyph_cache_stats glyphs;
+    fz_get_glyph_cache_stats(ctx, &glyphs);
+    stats->glyphCacheSize = glyphs.size;
+    stats->glyphCacheEntries = glyphs.entries;
+    stats->glyphCacheHits = glyphs.hits;
+    stats->glyphCacheMisses = glyphs.misses;
+}
+
 static Vec<PageAnnotation> fz_get_user_page_annots(Vec<PageAnnotation>& userAnnots, int pageNo)
 {
     Vec<PageAnnotation> result;
@@ -1079,68 +1209,143 @@ WStrVec *BuildPageLabelVec(pdf_obj *root, int pageCount)
     return labels;
 }
 
-struct PageTreeStackItem {
-    pdf_obj *kids;
-    int i, len;
+// decoding object streams is CPU bound and (once their raw data has been read)
+// independent of the document, so it's done on background threads; the last
+// thread to finish parses the decoded objects into the xref cache
+#define kMinObjStmsPerThread    16
+#define kMaxObjStmThreads       8
+#define MAX_OBJ_STM_WARM_UP_SIZE (32 * 1024 * 1024)
 
-    PageTreeStackItem() : kids(NULL), i(-1), len(0) { }
-    PageTreeStackItem(pdf_obj *kids) : kids(kids), i(-1), len(pdf_array_len(kids)) { }
-};
+// disabled by default, as warming up costs memory and CPU time for objects
+// which might never be needed (page objects are loaded on demand)
+static bool gWarmUpObjStms = false;
 
-static void
-pdf_load_page_objs(pdf_document *doc, pdf_obj **page_objs)
+void EnablePdfObjStmWarmUp(bool enable)
 {
-    fz_context *ctx = doc->ctx;
-    int page_no = 0;
+    gWarmUpObjStms = enable;
+}
 
-    Vec<PageTreeStackItem> stack;
-    PageTreeStackItem top(pdf_dict_getp(pdf_trailer(doc), "Root/Pages/Kids"));
+class ObjStmDecodeThread;
 
-    if (pdf_mark_obj(top.kids))
-        fz_throw(ctx, FZ_ERROR_GENERIC, "cycle in page tree");
+struct ObjStmWarmUp {
+    CRITICAL_SECTION *ctxAccess;
+    pdf_document *doc;
+    pdf_obj_stm_job *jobs;
+    int count;
+    LONG nextJob;
+    LONG decodedSize;
+    LONG runningThreads;
+    Vec<ObjStmDecodeThread *> threads;
+};
 
-    fz_try(ctx) {
-        for (;;) {
-            top.i++;
-            if (top.i == top.len) {
-                pdf_unmark_obj(top.kids);
-                if (stack.Size() == 0)
-                    break;
-                top = stack.Pop();
+class ObjStmDecodeThread : public ThreadBase {
+    ObjStmWarmUp *warmUp;
+
+    void DecodeJobs() {
+        // the document's context mustn't be used without holding ctxAccess,
+        // so each thread decodes with a context of its own (sharing the
+        // default allocator with the document's context)
+        fz_context *ctx = fz_new_context(NULL, NULL, 0);
+        if (!ctx)
+            return;
+        while (!WasCancelRequested()) {
+            LONG i = InterlockedIncrement(&warmUp->nextJob) - 1;
+            if (i >= warmUp->count)
+                break;
+            // stop once the memory budget has been used up (the remaining
+            // object streams will be decoded on demand)
+            LONG budget = MAX_OBJ_STM_WARM_UP_SIZE - warmUp->decodedSize;
+            if (budget <= 0)
+                break;
+            pdf_obj_stm_job *job = &warmUp->jobs[i];
+            pdf_run_obj_stm_job(ctx, job, budget);
+            if (!job->data)
                 continue;
-            }
-
-            pdf_obj *kid = pdf_array_get(top.kids, top.i);
-            char *type = pdf_to_name(pdf_dict_gets(kid, "Type"));
-            if (str::Eq(type, "Page") || str::IsEmpty(type) && pdf_dict_gets(kid, "MediaBox")) {
-                if (page_no >= pdf_count_pages(doc))
-                    fz_throw(ctx, FZ_ERROR_GENERIC, "found more /Page objects than anticipated");
-
-                page_objs[page_no] = pdf_keep_obj(kid);
-                page_no++;
-            }
-            else if (str::Eq(type, "Pages") || str::IsEmpty(type) && pdf_dict_gets(kid, "Kids")) {
-                int count = pdf_to_int(pdf_dict_gets(kid, "Count"));
-                if (count > 0) {
-                    stack.Push(top);
-                    top = PageTreeStackItem(pdf_dict_gets(kid, "Kids"));
-
-                    if (pdf_mark_obj(top.kids))
-                        fz_throw(ctx, FZ_ERROR_GENERIC, "cycle in page tree");
-                }
-            }
-            else {
-                fz_throw(ctx, FZ_ERROR_GENERIC, "non-page object in page tree (%s)", type);
+            // other threads might have used up the budget in the meantime
+            LONG len = (LONG)job->data->len;
+            if (InterlockedExchangeAdd(&warmUp->decodedSize, len) + len > MAX_OBJ_STM_WARM_UP_SIZE) {
+                InterlockedExchangeAdd(&warmUp->decodedSize, -len);
+                fz_drop_buffer(ctx, job->data);
+                job->data = NULL;
             }
         }
+        fz_free_context(ctx);
     }
-    fz_catch(ctx) {
-        for (size_t i = 0; i < stack.Size(); i++) {
-            pdf_unmark_obj(stack.At(i).kids);
+
+    void FinishJobs() {
+        // only hold ctxAccess for one object stream at a time, so that
+        // rendering isn't blocked for long
+        for (int i = 0; i < warmUp->count && !WasCancelRequested(); i++) {
+            ScopedCritSec scope(warmUp->ctxAccess);
+            pdf_finish_obj_stm_job(warmUp->doc, &warmUp->jobs[i]);
         }
-        pdf_unmark_obj(top.kids);
-        fz_rethrow(ctx);
+        ScopedCritSec scope(warmUp->ctxAccess);
+        pdf_drop_obj_stm_jobs(warmUp->doc, warmUp->jobs, warmUp->count);
+        warmUp->jobs = NULL;
+    }
+
+public:
+    ObjStmDecodeThread(ObjStmWarmUp *warmUp) :
+        ThreadBase("ObjStmDecodeThread"), warmUp(warmUp) { }
+    virtual ~ObjStmDecodeThread() { }
+
+    virtual void Run() {
+        DecodeJobs();
+        if (InterlockedDecrement(&warmUp->runningThreads) == 0)
+            FinishJobs();
+    }
+};
+
+// Note: make sure to only call with ctxAccess
+static ObjStmWarmUp *
+pdf_start_obj_stm_warm_up(pdf_document *doc, CRITICAL_SECTION *ctxAccess)
+{
+    int count = 0;
+    pdf_obj_stm_job *jobs = pdf_new_obj_stm_jobs(doc, MAX_OBJ_STM_WARM_UP_SIZE, &count);
+    if (!jobs)
+        return NULL;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t threadsCount = min((size_t)si.dwNumberOfProcessors, (size_t)kMaxObjStmThreads);
+    threadsCount = max(min(threadsCount, (size_t)count / kMinObjStmsPerThread), (size_t)1);
+
+    ObjStmWarmUp *warmUp = new ObjStmWarmUp();
+    warmUp->ctxAccess = ctxAccess;
+    warmUp->doc = doc;
+    warmUp->jobs = jobs;
+    warmUp->count = count;
+    warmUp->nextJob = 0;
+    warmUp->decodedSize = 0;
+    warmUp->runningThreads = (LONG)threadsCount;
+    for (size_t i = 0; i < threadsCount; i++) {
+        warmUp->threads.Append(new ObjStmDecodeThread(warmUp));
     }
+    for (size_t i = 0; i < threadsCount; i++) {
+        warmUp->threads.At(i)->Start();
+    }
+    return warmUp;
+}
+
+// Note: make sure to call without holding ctxAccess
+static void
+pdf_stop_obj_stm_warm_up(ObjStmWarmUp *warmUp)
+{
+    if (!warmUp)
+        return;
+    for (size_t i = 0; i < warmUp->threads.Count(); i++) {
+        warmUp->threads.At(i)->RequestCancel();
+    }
+    for (size_t i = 0; i < warmUp->threads.Count(); i++) {
+        warmUp->threads.At(i)->Join();
+    }
+    DeleteVecMembers(warmUp->threads);
+    // the jobs are only left if no thread got to finish them
+    if (warmUp->jobs) {
+        ScopedCritSec scope(warmUp->ctxAccess);
+        pdf_drop_obj_stm_jobs(warmUp->doc, warmUp->jobs, warmUp->count);
+    }
+    delete warmUp;
 }
 
 ///// Above are extensions to Fitz and MuPDF, now follows PdfEngine /////
@@ -1181,6 +1386,9 @@ public:
     }
 
     virtual RectD PageMediabox(int pageNo);
+    virtual bool IsPageMediaboxKnown(int pageNo) {
+        return PageCount() <= MAX_EAGERLY_MEASURED_PAGES || !_mediaboxes[pageNo-1].IsEmpty();
+    }
     virtual RectD PageContentBox(int pageNo, RenderTarget target=Target_View);
 
     virtual RenderedBitmap *RenderBitmap(int pageNo, float zoom, int rotation,
@@ -1216,17 +1424,19 @@ public:
     virtual const WCHAR *GetDefaultFileExt() const { return L".pdf"; }
 
     virtual bool BenchLoadPage(int pageNo) { return GetPdfPage(pageNo) != NULL; }
+    virtual bool BenchPreparePage(int pageNo);
+    virtual bool GetBenchCacheStats(EngineCacheStats *stats);
 
     virtual Vec<PageElement *> *GetElements(int pageNo);
     virtual PageElement *GetElementAtPos(int pageNo, PointD pt);
 
     virtual PageDestination *GetNamedDest(const WCHAR *name);
     virtual bool HasTocTree() const {
-        return outline != NULL || attachments != NULL;
+        return hasOutline || attachments != NULL;
     }
     virtual DocTocItem *GetTocTree();
 
-    virtual bool HasPageLabels() const { return _pagelabels != NULL; }
+    virtual bool HasPageLabels() const { return GetPageLabels() != NULL; }
     virtual WCHAR *GetPageLabel(int pageNo) const;
     virtual int GetPageByLabel(const WCHAR *label) const;
 
@@ -1249,6 +1459,9 @@ protected:
     pdf_page **     _pages;
     pdf_obj **      _pageObjs;
 
+    // decodes object streams in the background (cf. EnablePdfObjStmWarmUp)
+    ObjStmWarmUp  * objStmWarmUp;
+
     bool            Load(const WCHAR *fileName, PasswordUI *pwdUI=NULL);
     bool            Load(IStream *stream, PasswordUI *pwdUI=NULL);
     bool            Load(fz_stream *stm, PasswordUI *pwdUI=NULL);
@@ -1256,6 +1469,7 @@ protected:
     bool            FinishLoading();
 
     pdf_page      * GetPdfPage(int pageNo, bool failIfBusy=false);
+    pdf_obj       * GetPageObj(int pageNo);
     int             GetPageNo(pdf_page *page);
     fz_matrix       viewctm(int pageNo, float zoom, int rotation) {
         const fz_rect tmpRc = fz_RectD_to_rect(PageMediabox(pageNo));
@@ -1282,6 +1496,7 @@ protected:
     void            DropPageRun(PdfPageRun *run, bool forceRemove=false);
 
     PdfTocItem    * BuildTocTree(fz_outline *entry, int& idCounter);
+    WStrVec       * GetPageLabels() const;
     void            LinkifyPageText(pdf_page *page);
     pdf_annot    ** ProcessPageAnnotations(pdf_page *page);
     RenderedBitmap *GetPageImage(int pageNo, RectD rect, size_t imageIx);
@@ -1289,17 +1504,30 @@ protected:
     bool            IsLinearizedFile();
 
     bool            SaveEmbedded(LinkSaverUI& saveUI, int num, int gen);
-    bool            SaveUserAnnots(const WCHAR *fileName);
+    bool            SaveUserAnnots(const WCHAR *fileName, bool appendToSource=false);
 
     RectD         * _mediaboxes;
+    // the outline and page labels are only loaded on first use
+    // (both can take a while for documents with many pages)
     fz_outline    * outline;
+    bool            hasOutline, outlineLoaded;
     fz_outline    * attachments;
     pdf_obj       * _info;
     WStrVec       * _pagelabels;
+    bool            pageLabelsLoaded;
     pdf_annot   *** pageAnnots;
     fz_rect      ** imageRects;
 
     Vec<PageAnnotation> userAnnots;
+    // user annotations which have already been added to _doc
+    Vec<PageAnnotation> savedAnnots;
+    // last xref section of the loaded file resp. of _fileName after
+    // SaveUserAnnots has appended updates to it (fileSize is 0 until then)
+    struct XrefState {
+        int startxref;
+        int hasXrefStreams;
+        int64 fileSize;
+    } baseXref, appendedXref;
 };
 
 class PdfLink : public PageElement, public PageDestination {
@@ -1379,24 +1607,32 @@ public:
 
 PdfEngineImpl::PdfEngineImpl() : _fileName(NULL), _doc(NULL),
     _pages(NULL), _pageObjs(NULL), _mediaboxes(NULL), _info(NULL),
-    outline(NULL), attachments(NULL), _pagelabels(NULL),
+    outline(NULL), hasOutline(false), outlineLoaded(false),
+    attachments(NULL), _pagelabels(NULL), pageLabelsLoaded(false),
     _decryptionKey(NULL), isProtected(false),
-    pageAnnots(NULL), imageRects(NULL)
+    pageAnnots(NULL), imageRects(NULL), objStmWarmUp(NULL)
 {
     InitializeCriticalSection(&pagesAccess);
     InitializeCriticalSection(&ctxAccess);
+    ZeroMemory(&baseXref, sizeof(baseXref));
+    ZeroMemory(&appendedXref, sizeof(appendedXref));
 
     fz_locks_ctx.user = &ctxAccess;
     fz_locks_ctx.lock = fz_lock_context_cs;
     fz_locks_ctx.unlock = fz_unlock_context_cs;
     ctx = fz_new_context(NULL, &fz_locks_ctx, MAX_CONTEXT_MEMORY);
 
-    if (ctx)
+    if (ctx) {
         pdf_install_load_system_font_funcs(ctx);
+        if (trace::IsEnabled())
+            ctx->trace = fz_trace_span;
+    }
 }
 
 PdfEngineImpl::~PdfEngineImpl()
 {
+    pdf_stop_obj_stm_warm_up(objStmWarmUp);
+
     EnterCriticalSection(&pagesAccess);
     EnterCriticalSection(&ctxAccess);
 
@@ -1690,20 +1926,23 @@ bool PdfEngineImpl::FinishLoading()
 
     ScopedCritSec scope(&ctxAccess);
 
-    fz_try(ctx) {
-        pdf_load_page_objs(_doc, _pageObjs);
-    }
-    fz_catch(ctx) {
-        fz_warn(ctx, "Couldn't load all page objects");
+    if (gWarmUpObjStms) {
+        fz_try(ctx) {
+            // navigating is faster when compressed objects don't
+            // have to be decoded on demand
+            objStmWarmUp = pdf_start_obj_stm_warm_up(_doc, &ctxAccess);
+        }
+        fz_catch(ctx) {
+            fz_warn(ctx, "Couldn't warm up object streams");
+        }
     }
+    // page objects are only looked up on demand (see GetPageObj) and the
+    // outline and page labels on first use (see GetTocTree and GetPageLabels)
+    // so that documents with huge page trees can be displayed right away
     fz_try(ctx) {
-        outline = pdf_load_outline(_doc);
+        hasOutline = pdf_dict_getp(pdf_trailer(_doc), "Root/Outlines/First") != NULL;
     }
     fz_catch(ctx) {
-        // ignore errors from pdf_load_outline()
-        // this information is not critical and checking the
-        // error might prevent loading some pdfs that would
-        // otherwise get displayed
         fz_warn(ctx, "Couldn't load outline");
     }
     fz_try(ctx) {
@@ -1745,14 +1984,6 @@ bool PdfEngineImpl::FinishLoading()
         pdf_drop_obj(_info);
         _info = NULL;
     }
-    fz_try(ctx) {
-        pdf_obj *pagelabels = pdf_dict_getp(pdf_trailer(_doc), "Root/PageLabels");
-        if (pagelabels)
-            _pagelabels = BuildPageLabelVec(pagelabels, PageCount());
-    }
-    fz_catch(ctx) {
-        fz_warn(ctx, "Couldn't load page labels");
-    }
 
     AssertCrash(!pdf_js_supported(_doc));
 
@@ -1788,6 +2019,21 @@ DocTocItem *PdfEngineImpl::GetTocTree()
     PdfTocItem *node = NULL;
     int idCounter = 0;
 
+    ScopedCritSec scope(&ctxAccess);
+    if (hasOutline && !outlineLoaded) {
+        fz_try(ctx) {
+            outline = pdf_load_outline(_doc);
+        }
+        fz_catch(ctx) {
+            // ignore errors from pdf_load_outline()
+            // this information is not critical and checking the
+            // error might prevent loading some pdfs that would
+            // otherwise get displayed
+            fz_warn(ctx, "Couldn't load outline");
+        }
+        outlineLoaded = true;
+    }
+
     if (outline) {
         node = BuildTocTree(outline, idCounter);
         if (attachments)
@@ -1847,7 +2093,7 @@ pdf_page *PdfEngineImpl::GetPdfPage(int pageNo, bool failIfBusy)
         ScopedCritSec ctxScope(&ctxAccess);
         fz_var(page);
         fz_try(ctx) {
-            page = pdf_load_page_by_obj(_doc, pageNo - 1, _pageObjs[pageNo-1]);
+            page = pdf_load_page_by_obj(_doc, pageNo - 1, GetPageObj(pageNo));
             _pages[pageNo-1] = page;
             LinkifyPageText(page);
             pageAnnots[pageNo-1] = ProcessPageAnnotations(page);
@@ -1858,11 +2104,28 @@ pdf_page *PdfEngineImpl::GetPdfPage(int pageNo, bool failIfBusy)
     return page;
 }
 
+// Note: make sure to only call with ctxAccess
+pdf_obj *PdfEngineImpl::GetPageObj(int pageNo)
+{
+    if (!_pageObjs[pageNo-1]) {
+        fz_try(ctx) {
+            // only index the page tree as far as needed for this page
+            // (pages missing from a broken page tree are left blank)
+            if (pdf_load_page_tree(_doc, pageNo) >= pageNo)
+                _pageObjs[pageNo-1] = pdf_keep_obj(pdf_lookup_page_obj(_doc, pageNo - 1));
+        }
+        fz_catch(ctx) {
+            fz_warn(ctx, "Couldn't load page object for page %d", pageNo);
+        }
+    }
+    return _pageObjs[pageNo-1];
+}
+
 int PdfEngineImpl::GetPageNo(pdf_page *page)
 {
-    for (int i = 0; i < PageCount(); i++)
-        if (page == _pages[i])
-            return i + 1;
+    int pageNo = page->number + 1;
+    if (1 <= pageNo && pageNo <= PageCount() && page == _pages[pageNo - 1])
+        return pageNo;
     return 0;
 }
 
@@ -1924,6 +2187,7 @@ PdfPageRun *PdfEngineImpl::GetPageRun(pdf_page *page, bool tryOnly)
         }
 
         ScopedCritSec scope2(&ctxAccess);
+        ScopedTraceSpan span("GetPageRun");
 
         fz_display_list *list = NULL;
         fz_device *dev = NULL;
@@ -1958,6 +2222,7 @@ PdfPageRun *PdfEngineImpl::GetPageRun(pdf_page *page, bool tryOnly)
 
 bool PdfEngineImpl::RunPage(pdf_page *page, fz_device *dev, const fz_matrix *ctm, RenderTarget target, const fz_rect *cliprect, bool cacheRun, FitzAbortCookie *cookie)
 {
+    ScopedTraceSpan span("RunPage");
     bool ok = true;
 
     PdfPageRun *run;
@@ -2023,26 +2288,46 @@ void PdfEngineImpl::DropPageRun(PdfPageRun *run, bool forceRemove)
     LeaveCriticalSection(&pagesAccess);
 }
 
+bool PdfEngineImpl::BenchPreparePage(int pageNo)
+{
+    pdf_page *page = GetPdfPage(pageNo);
+    if (!page)
+        return false;
+    // the page run remains cached for subsequent renderings
+    PdfPageRun *run = GetPageRun(page);
+    if (!run)
+        return false;
+    DropPageRun(run);
+    return true;
+}
+
+bool PdfEngineImpl::GetBenchCacheStats(EngineCacheStats *stats)
+{
+    ScopedCritSec scope(&ctxAccess);
+    fz_get_cache_stats(ctx, stats);
+    return true;
+}
+
 RectD PdfEngineImpl::PageMediabox(int pageNo)
 {
     assert(1 <= pageNo && pageNo <= PageCount());
     if (!_mediaboxes[pageNo-1].IsEmpty())
         return _mediaboxes[pageNo-1];
 
-    pdf_obj *page = _pageObjs[pageNo - 1];
+    ScopedCritSec scope(&ctxAccess);
+
+    pdf_obj *page = GetPageObj(pageNo);
     if (!page)
         return RectD();
 
-    ScopedCritSec scope(&ctxAccess);
-
     // cf. pdf-page.c's pdf_load_page
     fz_rect mbox = fz_empty_rect, cbox = fz_empty_rect;
     int rotate = 0;
     float userunit = 1.0;
     fz_try(ctx) {
-        pdf_to_rect(ctx, pdf_lookup_inherited_page_item(_doc, page, "MediaBox"), &mbox);
-        pdf_to_rect(ctx, pdf_lookup_inherited_page_item(_doc, page, "CropBox"), &cbox);
-        rotate = pdf_to_int(pdf_lookup_inherited_page_item(_doc, page, "Rotate"));
+        pdf_to_rect(ctx, pdf_lookup_page_item(_doc, pageNo - 1, page, "MediaBox"), &mbox);
+        pdf_to_rect(ctx, pdf_lookup_page_item(_doc, pageNo - 1, page, "CropBox"), &cbox);
+        rotate = pdf_to_int(pdf_lookup_page_item(_doc, pageNo - 1, page, "Rotate"));
         pdf_obj *obj = pdf_dict_gets(page, "UserUnit");
         if (pdf_is_real(obj))
             userunit = pdf_to_real(obj);
@@ -2475,6 +2760,8 @@ WCHAR *PdfEngineImpl::ExtractPageText(pdf_page *page, WCHAR *lineSep, RectI **co
     if (!page)
         return NULL;
 
+    ScopedTraceSpan span("ExtractPageText");
+
     fz_text_sheet *sheet = NULL;
     fz_text_page *text = NULL;
     fz_device *dev = NULL;
@@ -2522,7 +2809,7 @@ WCHAR *PdfEngineImpl::ExtractPageText(int pageNo, WCHAR *lineSep, RectI **coords
 
     EnterCriticalSection(&ctxAccess);
     fz_try(ctx) {
-        page = pdf_load_page_by_obj(_doc, pageNo - 1, _pageObjs[pageNo-1]);
+        page = pdf_load_page_by_obj(_doc, pageNo - 1, GetPageObj(pageNo));
     }
     fz_catch(ctx) {
         LeaveCriticalSection(&ctxAccess);
@@ -2567,7 +2854,7 @@ bool PdfEngineImpl::IsLinearizedFile()
     if (pdf_to_int(pdf_dict_gets(obj, "L")) != _doc->file_size)
         return false;
     // /O must be the object number of the first page
-    if (pdf_to_int(pdf_dict_gets(obj, "O")) != pdf_to_num(_pageObjs[0]))
+    if (pdf_to_int(pdf_dict_gets(obj, "O")) != pdf_to_num(GetPageObj(1)))
         return false;
     // /N must be the total number of pages
     if (pdf_to_int(pdf_dict_gets(obj, "N")) != PageCount())
@@ -2748,9 +3035,13 @@ WCHAR *PdfEngineImpl::GetProperty(DocumentProperty prop)
 bool PdfEngineImpl::SupportsAnnotation(bool forSaving) const
 {
     if (forSaving) {
+        // page objects are loaded lazily, so this might have to index the
+        // entire page tree (which doesn't change the document's state, though)
+        PdfEngineImpl *self = const_cast<PdfEngineImpl *>(this);
+        ScopedCritSec scope(&self->ctxAccess);
         // TODO: support updating of documents where pages aren't all numbered objects?
-        for (int i = 0; i < PageCount(); i++) {
-            if (pdf_to_num(_pageObjs[i]) == 0)
+        for (int pageNo = 1; pageNo <= PageCount(); pageNo++) {
+            if (pdf_to_num(self->GetPageObj(pageNo)) == 0)
                 return false;
         }
     }
@@ -2822,6 +3113,25 @@ unsigned char *PdfEngineImpl::GetFileData(size_t *cbCount)
 
 bool PdfEngineImpl::SaveFileAs(const WCHAR *copyFileName)
 {
+    if (!baseXref.fileSize) {
+        ScopedCritSec scope(&ctxAccess);
+        fz_try(ctx) {
+            fz_seek(_doc->file, 0, 2);
+            baseXref.fileSize = fz_tell(_doc->file);
+        }
+        fz_catch(ctx) { }
+        baseXref.startxref = _doc->startxref;
+        baseXref.hasXrefStreams = _doc->has_xref_streams;
+    }
+    // when saving over the loaded file, only append the new annotations
+    // instead of rewriting the whole file (unless another program has
+    // modified the file in the meantime)
+    if (_fileName && !findEmbedMarks(_fileName) && path::IsSame(_fileName, copyFileName)) {
+        int64 expectedSize = appendedXref.fileSize ? appendedXref.fileSize : baseXref.fileSize;
+        if (file::GetSize(_fileName) == expectedSize)
+            return SaveUserAnnots(copyFileName, true);
+    }
+
     size_t dataLen;
     ScopedMem<unsigned char> data(GetFileData(&dataLen));
     if (data) {
@@ -2957,7 +3267,9 @@ static bool pdf_file_update_add_annotation(pdf_document *doc, pdf_page *page, pd
     return true;
 }
 
-bool PdfEngineImpl::SaveUserAnnots(const WCHAR *fileName)
+// appends all user annotations as an incremental update to fileName, which
+// must either be a copy of the loaded file or (for appendToSource) _fileName
+bool PdfEngineImpl::SaveUserAnnots(const WCHAR *fileName, bool appendToSource)
 {
     if (!userAnnots.Count())
         return true;
@@ -2971,36 +3283,69 @@ bool PdfEngineImpl::SaveUserAnnots(const WCHAR *fileName)
 
     fz_try(ctx) {
         for (int pageNo = 1; pageNo <= PageCount(); pageNo++) {
+            pageAnnots = fz_get_user_page_annots(userAnnots, pageNo);
+            // annotations added for a previous save are already part of _doc
+            for (size_t i = pageAnnots.Count(); i > 0; i--) {
+                if (savedAnnots.Contains(pageAnnots.At(i - 1)))
+                    pageAnnots.RemoveAt(i - 1);
+            }
+            if (pageAnnots.Count() == 0)
+                continue;
+            // only load the pages which actually receive new annotations
             pdf_page *page = GetPdfPage(pageNo);
+            pdf_obj *pageObj = GetPageObj(pageNo);
             // TODO: this will skip annotations for broken documents
-            if (!page || !pdf_to_num(_pageObjs[pageNo - 1])) {
+            if (!page || !pdf_to_num(pageObj)) {
                 ok = false;
                 break;
             }
-            pageAnnots = fz_get_user_page_annots(userAnnots, pageNo);
-            if (pageAnnots.Count() == 0)
-                continue;
             // get the page's /Annots array for appending
-            pdf_obj *annots = pdf_dict_gets(_pageObjs[pageNo - 1], "Annots");
+            pdf_obj *annots = pdf_dict_gets(pageObj, "Annots");
             if (!pdf_is_array(annots)) {
-                pdf_dict_puts_drop(_pageObjs[pageNo - 1], "Annots", pdf_new_array(_doc, (int)pageAnnots.Count()));
-                annots = pdf_dict_gets(_pageObjs[pageNo - 1], "Annots");
+                pdf_dict_puts_drop(pageObj, "Annots", pdf_new_array(_doc, (int)pageAnnots.Count()));
+                annots = pdf_dict_gets(pageObj, "Annots");
             }
             if (!pdf_is_indirect(annots)) {
                 // make /Annots indirect for the current /Page
-                pdf_dict_puts_drop(_pageObjs[pageNo - 1], "Annots", pdf_new_ref(_doc, annots));
+                pdf_dict_puts_drop(pageObj, "Annots", pdf_new_ref(_doc, annots));
             }
             // append all annotations for the current page
             for (size_t i = 0; i < pageAnnots.Count(); i++) {
-                ok &= pdf_file_update_add_annotation(_doc, page, _pageObjs[pageNo - 1], pageAnnots.At(i), annots);
+                if (pdf_file_update_add_annotation(_doc, page, pageObj, pageAnnots.At(i), annots))
+                    savedAnnots.Append(pageAnnots.At(i));
+                else
+                    ok = false;
             }
         }
         if (ok) {
+            // chain the update to the last xref section actually in fileName
+            // (pdf_write_document updates these for the file it's written to)
+            bool isAppending = appendToSource && appendedXref.fileSize;
+            XrefState& xref = isAppending ? appendedXref : baseXref;
+            _doc->startxref = xref.startxref;
+            _doc->has_xref_streams = xref.hasXrefStreams;
+
             fz_write_options opts = { 0 };
             opts.do_incremental = 1;
+            // pack the new objects into an object stream (where the file allows it)
+            opts.do_objstms = 1;
+            // _fileName already contains the changes up to the previous append,
+            // while copies of the loaded file need all changes since loading
+            opts.do_appending = isAppending;
             pdf_write_document(_doc, pathUtf8, &opts);
+
+            if (appendToSource) {
+                appendedXref.startxref = _doc->startxref;
+                appendedXref.hasXrefStreams = _doc->has_xref_streams;
+                appendedXref.fileSize = file::GetSize(fileName);
+                pdf_xref_end_incremental_section(_doc);
+            }
         }
     }
+    fz_always(ctx) {
+        _doc->startxref = baseXref.startxref;
+        _doc->has_xref_streams = baseXref.hasXrefStreams;
+    }
     fz_catch(ctx) {
         ok = false;
     }
@@ -3039,17 +3384,38 @@ bool PdfEngineImpl::HasClipOptimizations(int pageNo)
     return true;
 }
 
+WStrVec *PdfEngineImpl::GetPageLabels() const
+{
+    // building the labels doesn't change the document's state
+    PdfEngineImpl *self = const_cast<PdfEngineImpl *>(this);
+    ScopedCritSec scope(&self->ctxAccess);
+    if (!pageLabelsLoaded) {
+        fz_try(ctx) {
+            pdf_obj *pagelabels = pdf_dict_getp(pdf_trailer(_doc), "Root/PageLabels");
+            if (pagelabels)
+                self->_pagelabels = BuildPageLabelVec(pagelabels, PageCount());
+        }
+        fz_catch(ctx) {
+            fz_warn(ctx, "Couldn't load page labels");
+        }
+        self->pageLabelsLoaded = true;
+    }
+    return _pagelabels;
+}
+
 WCHAR *PdfEngineImpl::GetPageLabel(int pageNo) const
 {
-    if (!_pagelabels || pageNo < 1 || PageCount() < pageNo)
+    WStrVec *pagelabels = GetPageLabels();
+    if (!pagelabels || pageNo < 1 || PageCount() < pageNo)
         return BaseEngine::GetPageLabel(pageNo);
 
-    return str::Dup(_pagelabels->At(pageNo - 1));
+    return str::Dup(pagelabels->At(pageNo - 1));
 }
 
 int PdfEngineImpl::GetPageByLabel(const WCHAR *label) const
 {
-    int pageNo = _pagelabels ? _pagelabels->Find(label) + 1 : 0;
+    WStrVec *pagelabels = GetPageLabels();
+    int pageNo = pagelabels ? pagelabels->Find(label) + 1 : 0;
     if (!pageNo)
         return BaseEngine::GetPageByLabel(label);
 
@@ -3427,6 +3793,73 @@ xps_extract_doc_props(xps_document *doc)
     return props;
 }
 
+// inflating the fonts and images a page refers to is CPU bound and (for documents
+// read from memory) independent of the document, so it's spread over several
+// threads right after a page has been loaded (cf. pdf_start_obj_stm_warm_up)
+#define kMinXpsPartsPerThread   2
+#define kMaxXpsPrefetchThreads  8
+#define MAX_XPS_PREFETCH_SIZE   (32 * 1024 * 1024)
+
+class XpsPartPrefetchThread : public ThreadBase {
+    xps_document *doc;
+    xps_prefetch_job *jobs;
+    int count;
+    LONG *nextJob;
+
+public:
+    XpsPartPrefetchThread(xps_document *doc, xps_prefetch_job *jobs, int count, LONG *nextJob) :
+        ThreadBase("XpsPartPrefetchThread"), doc(doc), jobs(jobs), count(count), nextJob(nextJob) { }
+    virtual ~XpsPartPrefetchThread() { }
+
+    virtual void Run() {
+        // cf. ObjStmDecodeThread::DecodeJobs
+        fz_context *ctx = fz_new_context(NULL, NULL, 0);
+        if (!ctx)
+            return;
+        while (!WasCancelRequested()) {
+            LONG i = InterlockedIncrement(nextJob) - 1;
+            if (i >= count)
+                break;
+            xps_run_prefetch_job(ctx, doc, &jobs[i]);
+        }
+        fz_free_context(ctx);
+    }
+};
+
+// Note: make sure to only call with ctxAccess
+static void
+xps_prefetch_page_parts(xps_document *doc, xps_page *page)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t threadsCount = min((size_t)si.dwNumberOfProcessors, (size_t)kMaxXpsPrefetchThreads);
+    // on a single core, parts are read on demand just as quickly
+    if (threadsCount < 2)
+        return;
+
+    int count = 0;
+    xps_prefetch_job *jobs = xps_new_prefetch_jobs(doc, page, MAX_XPS_PREFETCH_SIZE, &count);
+    if (!jobs)
+        return;
+
+    threadsCount = min(threadsCount, (size_t)count / kMinXpsPartsPerThread);
+    LONG nextJob = 0;
+    if (threadsCount > 1) {
+        Vec<XpsPartPrefetchThread *> threads;
+        for (size_t i = 0; i < threadsCount; i++) {
+            XpsPartPrefetchThread *thread = new XpsPartPrefetchThread(doc, jobs, count, &nextJob);
+            threads.Append(thread);
+            thread->Start();
+        }
+        for (size_t i = 0; i < threads.Count(); i++) {
+            threads.At(i)->Join();
+        }
+        DeleteVecMembers(threads);
+    }
+
+    xps_finish_prefetch_jobs(doc, jobs, count);
+}
+
 ///// XpsEngine is also based on Fitz and shares quite some code with PdfEngine /////
 
 struct XpsPageRun {
@@ -3486,6 +3919,8 @@ public:
     virtual const WCHAR *GetDefaultFileExt() const { return L".xps"; }
 
     virtual bool BenchLoadPage(int pageNo) { return GetXpsPage(pageNo) != NULL; }
+    virtual bool BenchPreparePage(int pageNo);
+    virtual bool GetBenchCacheStats(EngineCacheStats *stats);
 
     virtual Vec<PageElement *> *GetElements(int pageNo);
     virtual PageElement *GetElementAtPos(int pageNo, PointD pt);
@@ -3633,6 +4068,8 @@ XpsEngineImpl::XpsEngineImpl() : _fileName(NULL), _doc(NULL), _pages(NULL), _med
     fz_locks_ctx.lock = fz_lock_context_cs;
     fz_locks_ctx.unlock = fz_unlock_context_cs;
     ctx = fz_new_context(NULL, &fz_locks_ctx, MAX_CONTEXT_MEMORY);
+    if (ctx && trace::IsEnabled())
+        ctx->trace = fz_trace_span;
 }
 
 XpsEngineImpl::~XpsEngineImpl()
@@ -3806,6 +4243,11 @@ xps_page *XpsEngineImpl::GetXpsPage(int pageNo, bool failIfBusy)
             // same xps_page object (without reference counting)
             page = xps_load_page(_doc, pageNo - 1);
             _pages[pageNo-1] = page;
+            // inflate the page's resources in parallel before running it
+            fz_try(ctx) {
+                xps_prefetch_page_parts(_doc, page);
+            }
+            fz_catch(ctx) { }
             LinkifyPageText(page, pageNo);
             assert(page->links_resolved);
         }
@@ -3881,6 +4323,7 @@ XpsPageRun *XpsEngineImpl::GetPageRun(xps_page *page, bool tryOnly)
         }
 
         ScopedCritSec ctxScope(&ctxAccess);
+        ScopedTraceSpan span("GetPageRun");
 
         fz_display_list *list = NULL;
         fz_device *dev = NULL;
@@ -3915,6 +4358,7 @@ XpsPageRun *XpsEngineImpl::GetPageRun(xps_page *page, bool tryOnly)
 
 bool XpsEngineImpl::RunPage(xps_page *page, fz_device *dev, const fz_matrix *ctm, const fz_rect *cliprect, bool cacheRun, FitzAbortCookie *cookie)
 {
+    ScopedTraceSpan span("RunPage");
     bool ok = true;
 
     XpsPageRun *run = GetPageRun(page, !cacheRun);
@@ -3975,6 +4419,26 @@ void XpsEngineImpl::DropPageRun(XpsPageRun *run, bool forceRemove)
     }
 }
 
+bool XpsEngineImpl::BenchPreparePage(int pageNo)
+{
+    xps_page *page = GetXpsPage(pageNo);
+    if (!page)
+        return false;
+    // the page run remains cached for subsequent renderings
+    XpsPageRun *run = GetPageRun(page);
+    if (!run)
+        return false;
+    DropPageRun(run);
+    return true;
+}
+
+bool XpsEngineImpl::GetBenchCacheStats(EngineCacheStats *stats)
+{
+    ScopedCritSec scope(&ctxAccess);
+    fz_get_cache_stats(ctx, stats);
+    return true;
+}
+
 RectD XpsEngineImpl::PageMediabox(int pageNo)
 {
     assert(1 <= pageNo && pageNo <= PageCount());
@@ -4190,6 +4654,8 @@ WCHAR *XpsEngineImpl::ExtractPageText(xps_page *page, WCHAR *lineSep, RectI **co
     if (!page)
         return NULL;
 
+    ScopedTraceSpan span("ExtractPageText");
+
     fz_text_sheet *sheet = NULL;
     fz_text_page *text = NULL;
     fz_device *dev = NULL;
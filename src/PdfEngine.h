@@ -27,6 +27,7 @@ public:
 };
 
 void CalcMD5Digest(const unsigned char *data, size_t byteCount, unsigned char digest[16]);
-void DebugGdiPlusDevice(bool enable);
+void DebugGdiPlusDevice(bool enable);
+void EnablePdfObjStmWarmUp(bool enable);
 
 #endif
@@ -6,6 +6,7 @@
 
 #include "FileUtil.h"
 #include "PdfEngine.h"
+#include "SyncTexIndex.h"
 
 #include "synctex_parser.h"
 
@@ -38,6 +39,11 @@ struct PdfsyncPoint {
     UINT page, x, y;
 };
 
+struct PdfsyncRecord {
+    UINT record;
+    UINT line; // index into lines
+};
+
 // Synchronizer based on .pdfsync file generated with the pdfsync tex package
 class Pdfsync : public Synchronizer
 {
@@ -53,12 +59,14 @@ public:
 
 private:
     int RebuildIndex();
+    int ParseSyncFile(const char *data, const char *dataEnd);
     UINT SourceToRecord(const WCHAR* srcfilename, UINT line, UINT col, Vec<size_t>& records);
 
     PdfEngine *engine;          // needed for converting between coordinate systems
     WStrVec srcfiles;           // source file names
     Vec<PdfsyncLine> lines;     // record-to-line mapping
     Vec<PdfsyncPoint> points;   // record-to-point mapping
+    Vec<PdfsyncRecord> records; // <lines> indices sorted by record number
     Vec<PdfsyncFileIndex> fileIndex; // start and end of entries for a file in <lines>
     Vec<size_t> sheetIndex;     // start of entries for a sheet in <points>
 };
@@ -68,23 +76,25 @@ class SyncTex : public Synchronizer
 {
 public:
     SyncTex(const WCHAR* syncfilename, PdfEngine *engine) :
-        Synchronizer(syncfilename), engine(engine), scanner(NULL)
+        Synchronizer(syncfilename), engine(engine), scanner(NULL), index(NULL)
     {
         assert(str::EndsWithI(syncfilename, SYNCTEX_EXTENSION));
     }
-    virtual ~SyncTex()
-    {
-        synctex_scanner_free(scanner);
-    }
+    virtual ~SyncTex();
 
     virtual int DocToSource(UINT pageNo, PointI pt, ScopedMem<WCHAR>& filename, UINT *line, UINT *col);
     virtual int SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT *page, Vec<RectI> &rects);
 
 private:
     int RebuildIndex();
+    WCHAR *GetSourcePath(const char *name) const;
+    int GetSourceTag(const WCHAR *srcfilepath);
+    int SourceToDocFromIndex(const WCHAR *srcfilepath, UINT line, UINT *page, Vec<RectI> &rects);
 
     PdfEngine *engine; // needed for converting between coordinate systems
-    synctex_scanner_t scanner;
+    synctex_scanner_t scanner; // only used if the index couldn't be built
+    SyncTexIndex *index;
+    WStrVec sourcePaths; // normalized paths of the index's inputs (same order)
 };
 
 Synchronizer::Synchronizer(const WCHAR* syncfilepath) :
@@ -190,44 +200,132 @@ WCHAR * Synchronizer::PrepareCommandline(const WCHAR* pattern, const WCHAR* file
 
 // PDFSYNC synchronizer
 
-// move to the next line in a list of zero-terminated lines
-static char *Advance0Line(char *line, char *end)
+// returns the end of the line starting at <line> (i.e. the next '\r' or '\n')
+static const char *FindLineEnd(const char *line, const char *end)
+{
+    for (; line < end && *line != '\n' && *line != '\r'; line++);
+    return line;
+}
+
+// move to the start of the next non-empty line
+static const char *SkipLineBreaks(const char *line, const char *end)
+{
+    for (; line < end && ('\n' == *line || '\r' == *line); line++);
+    return line;
+}
+
+// whitespace which doesn't end a line
+inline bool IsBlank(char c)
+{
+    return ' ' == c || '\t' == c || '\v' == c || '\f' == c;
+}
+
+// parses a space followed by an unsigned number (cf. str::Parse(" %u")) without
+// relying on zero-termination, returns NULL if there's no such number on the line
+static const char *ScanUInt(const char *s, const char *end, UINT *value)
 {
-    line += str::Len(line);
-    // skip all zeroes until the next non-empty line
-    for (; line < end && !*line; line++);
-    return line < end ? line : NULL;
+    if (s >= end || *s != ' ')
+        return NULL;
+    for (s++; s < end && IsBlank(*s); s++);
+    if (s >= end || !str::IsDigit(*s))
+        return NULL;
+    UINT n = 0;
+    for (; s < end && str::IsDigit(*s); s++)
+        n = n * 10 + (*s - '0');
+    *value = n;
+    return s;
+}
+
+// orders records by number and (for duplicate numbers) in declaration order
+static int cmpRecords(const void *a, const void *b)
+{
+    const PdfsyncRecord *ra = (const PdfsyncRecord *)a, *rb = (const PdfsyncRecord *)b;
+    if (ra->record != rb->record)
+        return ra->record < rb->record ? -1 : 1;
+    return ra->line < rb->line ? -1 : ra->line > rb->line ? 1 : 0;
+}
+
+// sorts <records> by record number with a stable LSD radix sort
+// (skipping all passes for bytes which are the same for all records)
+static void RadixSortRecords(Vec<PdfsyncRecord>& records)
+{
+    size_t count = records.Count();
+    ScopedMem<PdfsyncRecord> tmp(AllocArray<PdfsyncRecord>(count));
+    if (!tmp) {
+        // the radix sort needs a second buffer, qsort works in place
+        records.Sort(cmpRecords);
+        return;
+    }
+
+    size_t buckets[4][256] = { 0 };
+    PdfsyncRecord *src = records.LendData(), *dst = tmp;
+    for (size_t i = 0; i < count; i++) {
+        UINT record = src[i].record;
+        for (int byte = 0; byte < 4; byte++)
+            buckets[byte][(record >> (8 * byte)) & 0xFF]++;
+    }
+
+    for (int byte = 0; byte < 4; byte++) {
+        int shift = 8 * byte;
+        size_t *offsets = buckets[byte];
+        if (offsets[(src[0].record >> shift) & 0xFF] == count)
+            continue;
+        size_t offset = 0;
+        for (int i = 0; i < 256; i++) {
+            size_t bucketSize = offsets[i];
+            offsets[i] = offset;
+            offset += bucketSize;
+        }
+        for (size_t i = 0; i < count; i++)
+            dst[offsets[(src[i].record >> shift) & 0xFF]++] = src[i];
+        Swap(src, dst);
+    }
+    if (src != records.LendData())
+        memcpy(records.LendData(), src, count * sizeof(PdfsyncRecord));
 }
 
 // see http://itexmac.sourceforge.net/pdfsync.html for the specification
 int Pdfsync::RebuildIndex()
 {
+    // the file is parsed straight from a read-only mapping, which is why
+    // the parser mustn't rely on zero-termination (nor modify the data)
     size_t len;
-    ScopedMem<char> data(file::ReadAll(syncfilepath, &len));
+    const char *data = file::MapView(syncfilepath, &len);
     if (!data)
         return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
-    // convert the file data into a list of zero-terminated strings
-    str::TransChars(data, "\r\n", "\0\0");
+    int res = ParseSyncFile(data, data + len);
+    file::UnmapView(data);
+    if (res != PDFSYNCERR_SUCCESS)
+        return res;
+    return Synchronizer::RebuildIndex();
+}
 
+int Pdfsync::ParseSyncFile(const char *data, const char *dataEnd)
+{
     // parse preamble (jobname and version marker)
-    char *line = data;
-    char *dataEnd = data + len;
+    const char *line = data;
+    const char *lineEnd = FindLineEnd(line, dataEnd);
 
+    ScopedMem<WCHAR> jobName(line < lineEnd ? str::conv::FromAnsi(line, lineEnd - line) : str::Dup(L""));
+    if (!jobName)
+        return PDFSYNCERR_OUTOFMEMORY;
     // replace star by spaces (TeX uses stars instead of spaces in filenames)
-    str::TransChars(line, "*/", " \\");
-    ScopedMem<WCHAR> jobName(str::conv::FromAnsi(line));
+    str::TransChars(jobName, L"*/", L" \\");
     jobName.Set(str::Join(jobName, L".tex"));
     jobName.Set(PrependDir(jobName));
 
-    line = Advance0Line(line, dataEnd);
+    line = SkipLineBreaks(lineEnd, dataEnd);
+    lineEnd = FindLineEnd(line, dataEnd);
     UINT versionNumber = 0;
-    if (!line || !str::Parse(line, "version %u", &versionNumber) || versionNumber != 1)
+    if (lineEnd - line < 7 || !str::StartsWith(line, "version") ||
+        !ScanUInt(line + 7, lineEnd, &versionNumber) || versionNumber != 1)
         return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
 
     // reset synchronizer database
     srcfiles.Reset();
     lines.Reset();
     points.Reset();
+    records.Reset();
     fileIndex.Reset();
     sheetIndex.Reset();
 
@@ -243,27 +341,42 @@ int Pdfsync::RebuildIndex()
 
     PdfsyncLine psline;
     PdfsyncPoint pspoint;
+    // pdfsync.sty numbers records in the order in which they're declared,
+    // so that they usually don't have to be sorted at all
+    bool recordsSorted = true;
 
     // parse data
     UINT maxPageNo = engine->PageCount();
-    while ((line = Advance0Line(line, dataEnd)) != NULL) {
-        if (!line)
-            break;
+    const char *next;
+    for (line = SkipLineBreaks(lineEnd, dataEnd); line < dataEnd; line = SkipLineBreaks(FindLineEnd(next, dataEnd), dataEnd)) {
+        // valid lines are scanned up to their end, so that usually
+        // only the line break remains to be skipped afterwards
+        next = line + 1;
+        const char *s;
         switch (*line) {
         case 'l':
             psline.file = filestack.Last();
-            if (str::Parse(line, "l %u %u %u", &psline.record, &psline.line, &psline.column))
-                lines.Append(psline);
-            else if (str::Parse(line, "l %u %u", &psline.record, &psline.line)) {
-                psline.column = 0;
+            if ((s = ScanUInt(line + 1, dataEnd, &psline.record)) != NULL &&
+                (s = ScanUInt(s, dataEnd, &psline.line)) != NULL) {
+                next = ScanUInt(s, dataEnd, &psline.column);
+                if (!next) {
+                    psline.column = 0;
+                    next = s;
+                }
+                PdfsyncRecord psrecord = { psline.record, (UINT)lines.Count() };
+                if (records.Count() > 0 && records.Last().record > psline.record)
+                    recordsSorted = false;
+                records.Append(psrecord);
                 lines.Append(psline);
             }
             // else dbg("Bad 'l' line in the pdfsync file");
             break;
 
         case 's':
-            if (str::Parse(line, "s %u", &page))
+            if ((s = ScanUInt(line + 1, dataEnd, &page)) != NULL) {
                 sheetIndex.Append(points.Count());
+                next = s;
+            }
             // else dbg("Bad 's' line in the pdfsync file");
             // if (0 == page || page > maxPageNo)
             //     dbg("'s' line with invalid page number in the pdfsync file");
@@ -271,22 +384,33 @@ int Pdfsync::RebuildIndex()
 
         case 'p':
             pspoint.page = page;
+            // both "p" and "p*" lines declare a point
+            s = line + 1 < dataEnd && '*' == line[1] ? line + 2 : line + 1;
             if (0 == page || page > maxPageNo)
                 /* ignore point for invalid page number */;
-            else if (str::Parse(line, "p %u %u %u", &pspoint.record, &pspoint.x, &pspoint.y))
-                points.Append(pspoint);
-            else if (str::Parse(line, "p* %u %u %u", &pspoint.record, &pspoint.x, &pspoint.y))
+            else if ((s = ScanUInt(s, dataEnd, &pspoint.record)) != NULL &&
+                     (s = ScanUInt(s, dataEnd, &pspoint.x)) != NULL &&
+                     (s = ScanUInt(s, dataEnd, &pspoint.y)) != NULL) {
                 points.Append(pspoint);
+                next = s;
+            }
             // else dbg("Bad 'p' line in the pdfsync file");
             break;
 
         case '(':
             {
-                ScopedMem<WCHAR> filename(str::conv::FromAnsi(line + 1));
+                const char *name = line + 1;
+                next = FindLineEnd(name, dataEnd);
+                size_t nameLen = next - name;
                 // if the filename contains quotes then remove them
                 // TODO: this should never happen!?
-                if (filename[0] == '"' && filename[str::Len(filename) - 1] == '"')
-                    filename.Set(str::DupN(filename + 1, str::Len(filename) - 2));
+                if (nameLen >= 2 && '"' == name[0] && '"' == name[nameLen - 1]) {
+                    name++;
+                    nameLen -= 2;
+                }
+                ScopedMem<WCHAR> filename(nameLen > 0 ? str::conv::FromAnsi(name, nameLen) : str::Dup(L""));
+                if (!filename)
+                    return PDFSYNCERR_OUTOFMEMORY;
                 // undecorate the filepath: replace * by space and / by \ 
                 str::TransChars(filename, L"*/", L" \\");
                 // if the file name extension is not specified then add the suffix '.tex'
@@ -318,17 +442,15 @@ int Pdfsync::RebuildIndex()
     fileIndex.At(0).end = lines.Count();
     assert(filestack.Count() == 1);
 
-    return Synchronizer::RebuildIndex();
+    if (!recordsSorted)
+        RadixSortRecords(records);
+
+    return PDFSYNCERR_SUCCESS;
 }
 
 // convert a coordinate from the sync file into a PDF coordinate
 #define SYNC_TO_PDF_COORDINATE(c)  (c/65781.76)
 
-static int cmpLineRecords(const void *a, const void *b)
-{
-    return ((PdfsyncLine *)a)->record - ((PdfsyncLine *)b)->record;
-}
-
 int Pdfsync::DocToSource(UINT pageNo, PointI pt, ScopedMem<WCHAR>& filename, UINT *line, UINT *col)
 {
     if (IsIndexDiscarded())
@@ -377,11 +499,18 @@ int Pdfsync::DocToSource(UINT pageNo, PointI pt, ScopedMem<WCHAR>& filename, UIN
         return PDFSYNCERR_NO_SYNC_AT_LOCATION; // no record was found close enough to the hit point
 
     // We have a record number, we need to find its declaration ('l ...') in the syncfile
-    PdfsyncLine cmp; cmp.record = selected_record;
-    PdfsyncLine *found = (PdfsyncLine *)bsearch(&cmp, lines.LendData(), lines.Count(), sizeof(PdfsyncLine), cmpLineRecords);
-    assert(found);
-    if (!found)
+    size_t lo = 0, hi = records.Count();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (records.At(mid).record < selected_record)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    assert(lo < records.Count() && records.At(lo).record == selected_record);
+    if (lo == records.Count() || records.At(lo).record != selected_record)
         return PDFSYNCERR_NO_SYNC_AT_LOCATION;
+    PdfsyncLine *found = &lines.At(records.At(lo).line);
 
     filename.Set(str::Dup(srcfiles.At(found->file)));
     *line = found->line;
@@ -492,10 +621,31 @@ int Pdfsync::SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT *pa
 
 // SYNCTEX synchronizer
 
+SyncTex::~SyncTex()
+{
+    synctex_scanner_free(scanner);
+    delete index;
+}
+
 int SyncTex::RebuildIndex() {
     synctex_scanner_free(this->scanner);
     this->scanner = NULL;
+    delete this->index;
+    this->index = NULL;
+    sourcePaths.Reset();
+
+    // synctex_parser also falls back to the compressed file
+    ScopedMem<WCHAR> syncfile(str::Dup(syncfilepath));
+    if (!file::Exists(syncfile))
+        syncfile.Set(str::Join(syncfilepath, L".gz"));
+    if (!syncfile)
+        return PDFSYNCERR_OUTOFMEMORY;
 
+    index = SyncTexIndex::Create(syncfile);
+    if (index)
+        return Synchronizer::RebuildIndex();
+
+    // fall back to synctex_parser for files the index can't handle
     ScopedMem<char> syncfname(str::conv::ToAnsi(syncfilepath));
     if (!syncfname)
         return PDFSYNCERR_OUTOFMEMORY;
@@ -507,29 +657,14 @@ int SyncTex::RebuildIndex() {
     return Synchronizer::RebuildIndex();
 }
 
-int SyncTex::DocToSource(UINT pageNo, PointI pt, ScopedMem<WCHAR>& filename, UINT *line, UINT *col)
+// converts an input file name from the .synctex file into an absolute path
+WCHAR *SyncTex::GetSourcePath(const char *name) const
 {
-    if (IsIndexDiscarded())
-        if (RebuildIndex() != PDFSYNCERR_SUCCESS)
-            return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
-    assert(this->scanner);
-
-    if (synctex_edit_query(this->scanner, pageNo, (float)pt.x, (float)pt.y) < 0)
-        return PDFSYNCERR_NO_SYNC_AT_LOCATION;
-
-    synctex_node_t node = synctex_next_result(this->scanner);
-    if (!node)
-        return PDFSYNCERR_NO_SYNC_AT_LOCATION;
-
-    const char *name = synctex_scanner_get_name(this->scanner, synctex_node_tag(node));
-    if (!name)
-        return PDFSYNCERR_UNKNOWN_SOURCEFILE;
-
     bool isUtf8 = true;
-    filename.Set(str::conv::FromUtf8(name));
+    ScopedMem<WCHAR> filename(str::conv::FromUtf8(name));
 TryAgainAnsi:
     if (!filename)
-        return PDFSYNCERR_OUTOFMEMORY;
+        return NULL;
 
     // undecorate the filepath: replace * by space and / by \ 
     str::TransChars(filename, L"*/", L" \\");
@@ -544,8 +679,73 @@ TryAgainAnsi:
         goto TryAgainAnsi;
     }
 
-    *line = synctex_node_line(node);
-    *col = synctex_node_column(node);
+    return filename.StealData();
+}
+
+// returns the index's tag for a source file (or 0 if it's not an input)
+int SyncTex::GetSourceTag(const WCHAR *srcfilepath)
+{
+    if (sourcePaths.Count() == 0) {
+        for (int i = 0; i < index->InputCount(); i++) {
+            ScopedMem<WCHAR> path(GetSourcePath(index->GetInputName(i)));
+            sourcePaths.Append(path ? path::Normalize(path) : NULL);
+        }
+    }
+
+    ScopedMem<WCHAR> normpath(path::Normalize(srcfilepath));
+    if (!normpath)
+        return 0;
+    for (size_t i = 0; i < sourcePaths.Count(); i++) {
+        if (sourcePaths.At(i) && str::EqI(sourcePaths.At(i), normpath))
+            return index->GetInputTag((int)i);
+    }
+    // compare the actual files (in case of short names, links, etc.)
+    for (size_t i = 0; i < sourcePaths.Count(); i++) {
+        if (sourcePaths.At(i) && path::IsSame(sourcePaths.At(i), normpath))
+            return index->GetInputTag((int)i);
+    }
+    return 0;
+}
+
+int SyncTex::DocToSource(UINT pageNo, PointI pt, ScopedMem<WCHAR>& filename, UINT *line, UINT *col)
+{
+    if (IsIndexDiscarded())
+        if (RebuildIndex() != PDFSYNCERR_SUCCESS)
+            return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
+    assert(this->index || this->scanner);
+
+    const char *name;
+    UINT nodeLine, nodeCol;
+    if (this->index) {
+        int node = this->index->EditQuery(pageNo, (float)pt.x, (float)pt.y);
+        if (-1 == node)
+            return PDFSYNCERR_NO_SYNC_AT_LOCATION;
+        name = this->index->GetNameForTag(this->index->GetNode(node).tag);
+        nodeLine = this->index->GetNode(node).line;
+        // SyncTeX doesn't record columns
+        nodeCol = (UINT)-1;
+    }
+    else {
+        if (synctex_edit_query(this->scanner, pageNo, (float)pt.x, (float)pt.y) < 0)
+            return PDFSYNCERR_NO_SYNC_AT_LOCATION;
+
+        synctex_node_t node = synctex_next_result(this->scanner);
+        if (!node)
+            return PDFSYNCERR_NO_SYNC_AT_LOCATION;
+
+        name = synctex_scanner_get_name(this->scanner, synctex_node_tag(node));
+        nodeLine = synctex_node_line(node);
+        nodeCol = synctex_node_column(node);
+    }
+    if (!name)
+        return PDFSYNCERR_UNKNOWN_SOURCEFILE;
+
+    filename.Set(GetSourcePath(name));
+    if (!filename)
+        return PDFSYNCERR_OUTOFMEMORY;
+
+    *line = nodeLine;
+    *col = nodeCol;
 
     return PDFSYNCERR_SUCCESS;
 }
@@ -555,7 +755,7 @@ int SyncTex::SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT *pa
     if (IsIndexDiscarded())
         if (RebuildIndex() != PDFSYNCERR_SUCCESS)
             return PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED;
-    assert(this->scanner);
+    assert(this->index || this->scanner);
 
     ScopedMem<WCHAR> srcfilepath;
     // convert the source file to an absolute path
@@ -566,6 +766,9 @@ int SyncTex::SourceToDoc(const WCHAR* srcfilename, UINT line, UINT col, UINT *pa
     if (!srcfilepath)
         return PDFSYNCERR_OUTOFMEMORY;
 
+    if (this->index)
+        return SourceToDocFromIndex(srcfilepath, line, page, rects);
+
     bool isUtf8 = true;
     char *mb_srcfilepath = str::conv::ToUtf8(srcfilepath);
 TryAgainAnsi:
@@ -611,3 +814,27 @@ TryAgainAnsi:
         return PDFSYNCERR_NOSYNCPOINT_FOR_LINERECORD;
     return PDFSYNCERR_SUCCESS;
 }
+
+int SyncTex::SourceToDocFromIndex(const WCHAR *srcfilepath, UINT line, UINT *page, Vec<RectI> &rects)
+{
+    int tag = GetSourceTag(srcfilepath);
+    if (!tag)
+        return PDFSYNCERR_UNKNOWN_SOURCEFILE;
+
+    Vec<int> nodes;
+    if (!this->index->DisplayQuery(tag, line, nodes))
+        return PDFSYNCERR_NOSYNCPOINT_FOR_LINERECORD;
+
+    int firstpage = this->index->GetPage(nodes.At(0));
+    if (firstpage <= 0 || firstpage > engine->PageCount())
+        return PDFSYNCERR_NOSYNCPOINT_FOR_LINERECORD;
+    *page = (UINT)firstpage;
+
+    rects.Reset();
+    for (size_t i = 0; i < nodes.Count(); i++) {
+        if (this->index->GetPage(nodes.At(i)) == firstpage)
+            rects.Push(this->index->GetBoxRect(nodes.At(i)).Round());
+    }
+
+    return PDFSYNCERR_SUCCESS;
+}
@@ -4,6 +4,7 @@
 #include "BaseUtil.h"
 #include "RenderCache.h"
 #include "TextSelection.h"
+#include "Trace.h"
 #include "WinUtil.h"
 
 /* Define if you want to conserve memory by always freeing cached bitmaps
@@ -441,6 +442,7 @@ bool RenderCache::Render(DisplayModel *dm, int pageNo, int rotation, float zoom,
     newRequest->abortCookie = NULL;
     newRequest->timestamp = GetTickCount();
     newRequest->renderCb = renderCb;
+    trace::Counter("render queue", requestCount);
 
     SetEvent(startRendering);
 
@@ -560,6 +562,9 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data)
 
         if (!cache->GetNextRequest(&req))
             continue;
+        // time between a request being queued and being picked up
+        trace::Counter("render latency", (int)(GetTickCount() - req.timestamp));
+
         if (!req.dm->PageVisibleNearby(req.pageNo) && !req.renderCb)
             continue;
         if (req.dm->dontRenderFlag) {
@@ -571,11 +576,15 @@ DWORD WINAPI RenderCache::RenderCacheThread(LPVOID data)
         // make sure that we have extracted page text for
         // all rendered pages to allow text selection and
         // searching without any further delays
-        if (!req.dm->textCache->HasData(req.pageNo))
+        if (!req.dm->textCache->HasData(req.pageNo)) {
+            ScopedTraceSpan span("text extraction");
             req.dm->textCache->GetData(req.pageNo);
+        }
 
         CrashIf(req.abortCookie != NULL);
+        trace::BeginSpan("RenderBitmap");
         bmp = req.dm->engine->RenderBitmap(req.pageNo, req.zoom, req.rotation, &req.pageRect, Target_View, &req.abortCookie);
+        trace::EndSpan("RenderBitmap");
         if (req.abort) {
             delete bmp;
             if (req.renderCb)
@@ -637,6 +646,7 @@ UINT RenderCache::PaintTile(HDC hdc, RectI bounds, DisplayModel *dm, int pageNo,
         int ySrc = -min(tileOnScreen.y, 0);
         float factor = min(1.0f * bmpSize.dx / tileOnScreen.dx, 1.0f * bmpSize.dy / tileOnScreen.dy);
 
+        ScopedTraceSpan span("GDI blit");
         SelectObject(bmpDC, hbmp);
         if (factor != 1.0f)
             StretchBlt(hdc, bounds.x, bounds.y, bounds.dx, bounds.dy,
@@ -57,6 +57,9 @@ struct EbookUI {
     // if true, the UI used for PDF documents will be used for ebooks as
     // well (enables printing and searching, disables automatic reflow)
     bool useFixedPageUI;
+    // maximum size (in MB) of image data kept in memory per EPUB document.
+    // 0 disables caching
+    int imageCacheSize;
 };
 
 // customization options for Comic Book and images UI
@@ -257,6 +260,10 @@ struct GlobalPrefs {
     // actual resolution of the main screen in DPI (if this value isn't
     // positive, the system's UI setting is used)
     int customScreenDPI;
+    // if true, compressed objects of PDF documents are decoded in the
+    // background right after loading, which makes navigating faster at the
+    // cost of memory and CPU time
+    bool warmUpPdfObjectStreams;
     // default values for user added annotations in FixedPageUI documents
     // (preliminary and still subject to change)
     AnnotationDefaults annotationDefaults;
@@ -362,8 +369,9 @@ static const FieldInfo gEbookUIFields[] = {
     { offsetof(EbookUI, textColor),       Type_Color,  0x324b5f             },
     { offsetof(EbookUI, backgroundColor), Type_Color,  0xd9f0fb             },
     { offsetof(EbookUI, useFixedPageUI),  Type_Bool,   false                },
+    { offsetof(EbookUI, imageCacheSize),  Type_Int,    32                   },
 };
-static const StructInfo gEbookUIInfo = { sizeof(EbookUI), 5, gEbookUIFields, "FontName\0FontSize\0TextColor\0BackgroundColor\0UseFixedPageUI" };
+static const StructInfo gEbookUIInfo = { sizeof(EbookUI), 6, gEbookUIFields, "FontName\0FontSize\0TextColor\0BackgroundColor\0UseFixedPageUI\0ImageCacheSize" };
 
 static const FieldInfo gWindowMargin_1_Fields[] = {
     { offsetof(WindowMargin, top),    Type_Int, 0 },
@@ -495,6 +503,7 @@ static const FieldInfo gGlobalPrefsFields[] = {
     { offsetof(GlobalPrefs, defaultPasswords),         Type_String,     NULL                                                                                                                  },
     { offsetof(GlobalPrefs, reloadModifiedDocuments),  Type_Bool,       true                                                                                                                  },
     { offsetof(GlobalPrefs, customScreenDPI),          Type_Int,        0                                                                                                                     },
+    { offsetof(GlobalPrefs, warmUpPdfObjectStreams),   Type_Bool,       false                                                                                                                 },
     { offsetof(GlobalPrefs, annotationDefaults),       Type_Prerelease, (intptr_t)&gAnnotationDefaultsInfo                                                                                    },
     { (size_t)-1,                                      Type_Comment,    NULL                                                                                                                  },
     { offsetof(GlobalPrefs, rememberStatePerDocument), Type_Bool,       true                                                                                                                  },
@@ -522,7 +531,7 @@ static const FieldInfo gGlobalPrefsFields[] = {
     { offsetof(GlobalPrefs, timeOfLastUpdateCheck),    Type_Compact,    (intptr_t)&gFILETIMEInfo                                                                                              },
     { offsetof(GlobalPrefs, openCountWeek),            Type_Int,        0                                                                                                                     },
 };
-static const StructInfo gGlobalPrefsInfo = { sizeof(GlobalPrefs), 44, gGlobalPrefsFields, "\0\0MainWindowBackground\0EscToExit\0ReuseInstance\0FixedPageUI\0EbookUI\0ComicBookUI\0ChmUI\0ExternalViewers\0ShowMenubar\0ZoomLevels\0ZoomIncrement\0PrinterDefaults\0ForwardSearch\0DefaultPasswords\0ReloadModifiedDocuments\0CustomScreenDPI\0AnnotationDefaults\0\0RememberStatePerDocument\0UiLanguage\0ShowToolbar\0ShowFavorites\0AssociatedExtensions\0AssociateSilently\0CheckForUpdates\0VersionToSkip\0RememberOpenedFiles\0UseSysColors\0InverseSearchCmdLine\0EnableTeXEnhancements\0DefaultDisplayMode\0DefaultZoom\0WindowState\0WindowPos\0ShowToc\0SidebarDx\0TocDy\0ShowStartPage\0\0FileStates\0TimeOfLastUpdateCheck\0OpenCountWeek" };
+static const StructInfo gGlobalPrefsInfo = { sizeof(GlobalPrefs), 45, gGlobalPrefsFields, "\0\0MainWindowBackground\0EscToExit\0ReuseInstance\0FixedPageUI\0EbookUI\0ComicBookUI\0ChmUI\0ExternalViewers\0ShowMenubar\0ZoomLevels\0ZoomIncrement\0PrinterDefaults\0ForwardSearch\0DefaultPasswords\0ReloadModifiedDocuments\0CustomScreenDPI\0WarmUpPdfObjectStreams\0AnnotationDefaults\0\0RememberStatePerDocument\0UiLanguage\0ShowToolbar\0ShowFavorites\0AssociatedExtensions\0AssociateSilently\0CheckForUpdates\0VersionToSkip\0RememberOpenedFiles\0UseSysColors\0InverseSearchCmdLine\0EnableTeXEnhancements\0DefaultDisplayMode\0DefaultZoom\0WindowState\0WindowPos\0ShowToc\0SidebarDx\0TocDy\0ShowStartPage\0\0FileStates\0TimeOfLastUpdateCheck\0OpenCountWeek" };
 
 #endif
 
@@ -2,6 +2,7 @@
    License: GPLv3 */
 
 #include "BaseUtil.h"
+#include <psapi.h>
 #include "StressTesting.h"
 
 #include "AppPrefs.h"
@@ -12,10 +13,13 @@
 #include "HtmlWindow.h"
 #include "Notifications.h"
 #include "ParseCommandLine.h"
+#include "PdfEngine.h"
+#include "PdfSync.h"
 #include "RenderCache.h"
 #include "SimpleLog.h"
 #include "Search.h"
 #include "SumatraPDF.h"
+#include "ThreadUtil.h"
 #include "Timer.h"
 #include "WindowInfo.h"
 #include "WinUtil.h"
@@ -85,7 +89,149 @@ inline bool IsInRange(Vec<PageRange>& ranges, int pageNo)
     return false;
 }
 
-static void BenchLoadRender(BaseEngine *engine, int pagenum)
+// zoom levels and rotations at which to render all benchmarked pages
+struct BenchOptions {
+    Vec<float> zoomLevels; // 1.0 = 100%
+    Vec<int> rotations;
+};
+
+// collects the timings of all benchmarked phases (open, load, list, render
+// and text), summarizing them as percentiles in machine-readable JSON
+class BenchResults {
+    CRITICAL_SECTION access;
+    WStrVec phaseNames;
+    Vec<Vec<double> *> phaseSamples;
+    int pageCount, errorCount;
+    // peak sizes over all engines, hit counts summed up over all engines
+    EngineCacheStats cacheStats;
+
+public:
+    BenchResults() : pageCount(0), errorCount(0) {
+        InitializeCriticalSection(&access);
+        ZeroMemory(&cacheStats, sizeof(cacheStats));
+    }
+    ~BenchResults() {
+        DeleteVecMembers(phaseSamples);
+        DeleteCriticalSection(&access);
+    }
+
+    void AddSample(const WCHAR *phase, double timeMs) {
+        ScopedCritSec scope(&access);
+        int ix = phaseNames.Find(phase);
+        if (-1 == ix) {
+            ix = (int)phaseNames.Count();
+            phaseNames.Append(str::Dup(phase));
+            phaseSamples.Append(new Vec<double>());
+        }
+        phaseSamples.At(ix)->Append(timeMs);
+    }
+
+    void AddPage() {
+        ScopedCritSec scope(&access);
+        pageCount++;
+    }
+
+    void AddError() {
+        ScopedCritSec scope(&access);
+        errorCount++;
+    }
+
+    void UpdateCacheStats(BaseEngine *engine, bool engineDone=false) {
+        EngineCacheStats stats;
+        if (!engine->GetBenchCacheStats(&stats))
+            return;
+        ScopedCritSec scope(&access);
+        cacheStats.storeSize = max(cacheStats.storeSize, stats.storeSize);
+        cacheStats.storeItems = max(cacheStats.storeItems, stats.storeItems);
+        cacheStats.glyphCacheSize = max(cacheStats.glyphCacheSize, stats.glyphCacheSize);
+        cacheStats.glyphCacheEntries = max(cacheStats.glyphCacheEntries, stats.glyphCacheEntries);
+        if (engineDone) {
+            cacheStats.storeHits += stats.storeHits;
+            cacheStats.storeMisses += stats.storeMisses;
+            cacheStats.glyphCacheHits += stats.glyphCacheHits;
+            cacheStats.glyphCacheMisses += stats.glyphCacheMisses;
+        }
+    }
+
+    char *ToJson(WStrVec& pathsToBench, int threads, double wallTimeMs);
+};
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double diff = *(const double *)a - *(const double *)b;
+    return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+// nearest-rank percentile of sorted samples
+static double GetPercentile(Vec<double>& sorted, size_t percent)
+{
+    size_t rank = (sorted.Count() * percent + 99) / 100;
+    return sorted.At(limitValue(rank, (size_t)1, sorted.Count()) - 1);
+}
+
+static void AppendJsonString(str::Str<char>& json, const WCHAR *value)
+{
+    ScopedMem<char> utf8(str::conv::ToUtf8(value));
+    json.Append('"');
+    for (const char *c = utf8; *c; c++) {
+        if ('"' == *c || '\\' == *c)
+            json.Append('\\');
+        if ((unsigned char)*c < 0x20)
+            json.AppendFmt("\\u%04x", *c);
+        else
+            json.Append(*c);
+    }
+    json.Append('"');
+}
+
+static size_t GetPeakMemoryUsage()
+{
+    // psapi.dll is loaded dynamically so that SumatraPDF doesn't depend on it
+    typedef BOOL (WINAPI *GetProcessMemoryInfoProc)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
+    GetProcessMemoryInfoProc _GetProcessMemoryInfo = (GetProcessMemoryInfoProc)LoadDllFunc(L"psapi.dll", "GetProcessMemoryInfo");
+    PROCESS_MEMORY_COUNTERS pmc = { sizeof(pmc) };
+    if (!_GetProcessMemoryInfo || !_GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+}
+
+// the format matches the one of mudraw -J so that results can
+// be compared with scripts/render-benchmark.py --compare
+char *BenchResults::ToJson(WStrVec& pathsToBench, int threads, double wallTimeMs)
+{
+    ScopedCritSec scope(&access);
+    str::Str<char> json;
+
+    json.AppendFmt("{\n\t\"tool\": \"SumatraPDF\",\n\t\"threads\": %d,\n\t\"files\": [", threads);
+    for (size_t i = 0; i < pathsToBench.Count(); i += 2) {
+        if (i > 0)
+            json.Append(", ");
+        AppendJsonString(json, pathsToBench.At(i));
+    }
+    json.AppendFmt("],\n\t\"pages\": %d,\n\t\"errors\": %d,\n\t\"wall_time\": %.3f,\n\t\"phases\": {", pageCount, errorCount, wallTimeMs);
+    for (size_t i = 0; i < phaseNames.Count(); i++) {
+        Vec<double> *samples = phaseSamples.At(i);
+        samples->Sort(cmpDouble);
+        double total = 0;
+        for (size_t j = 0; j < samples->Count(); j++) {
+            total += samples->At(j);
+        }
+        json.Append(i > 0 ? ",\n\t\t" : "\n\t\t");
+        AppendJsonString(json, phaseNames.At(i));
+        json.AppendFmt(": { \"count\": %d, \"total\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }",
+            (int)samples->Count(), total, samples->At(0), GetPercentile(*samples, 50),
+            GetPercentile(*samples, 95), GetPercentile(*samples, 99), samples->Last());
+    }
+    json.AppendFmt("\n\t},\n\t\"memory\": { \"peak_rss\": %Iu },\n", GetPeakMemoryUsage());
+    json.AppendFmt("\t\"store\": { \"peak_size\": %Iu, \"peak_items\": %Iu, \"hits\": %d, \"misses\": %d },\n",
+        cacheStats.storeSize, cacheStats.storeItems, cacheStats.storeHits, cacheStats.storeMisses);
+    json.AppendFmt("\t\"glyph_cache\": { \"peak_size\": %Iu, \"peak_entries\": %Iu, \"hits\": %d, \"misses\": %d }\n}\n",
+        cacheStats.glyphCacheSize, cacheStats.glyphCacheEntries, cacheStats.glyphCacheHits, cacheStats.glyphCacheMisses);
+
+    return json.StealData();
+}
+
+static void BenchLoadRender(BaseEngine *engine, int pagenum, BenchOptions& opts, BenchResults& results)
 {
     Timer t(true);
     bool ok = engine->BenchLoadPage(pagenum);
@@ -93,22 +239,81 @@ static void BenchLoadRender(BaseEngine *engine, int pagenum)
 
     if (!ok) {
         logbench("Error: failed to load page %d", pagenum);
+        results.AddError();
         return;
     }
     double timems = t.GetTimeInMs();
     logbench("pageload   %3d: %.2f ms", pagenum, timems);
+    results.AddSample(L"load", timems);
+
+    // build the display list separately, so that it's cached for all renderings
+    t.Start();
+    ok = engine->BenchPreparePage(pagenum);
+    t.Stop();
+
+    if (!ok) {
+        logbench("Error: failed to prepare page %d", pagenum);
+        results.AddError();
+        return;
+    }
+    results.AddSample(L"list", t.GetTimeInMs());
+
+    for (size_t i = 0; i < opts.zoomLevels.Count(); i++) {
+        for (size_t j = 0; j < opts.rotations.Count(); j++) {
+            float zoom = opts.zoomLevels.At(i);
+            int rotation = opts.rotations.At(j);
+
+            t.Start();
+            RenderedBitmap *rendered = engine->RenderBitmap(pagenum, zoom, rotation);
+            t.Stop();
+
+            if (!rendered) {
+                logbench("Error: failed to render page %d", pagenum);
+                results.AddError();
+                return;
+            }
+            delete rendered;
+            timems = t.GetTimeInMs();
+            if (1.0f == zoom && 0 == rotation)
+                logbench("pagerender %3d: %.2f ms", pagenum, timems);
+            else
+                logbench("pagerender %3d (%g%%, %d deg): %.2f ms", pagenum, zoom * 100, rotation, timems);
+            ScopedMem<WCHAR> phase(str::Format(L"render z=%g r=%d", zoom * 100, rotation));
+            results.AddSample(phase, timems);
+        }
+    }
 
     t.Start();
-    RenderedBitmap *rendered = engine->RenderBitmap(pagenum, 1.0, 0);
+    ScopedMem<WCHAR> text(engine->ExtractPageText(pagenum, L"\n"));
     t.Stop();
+    results.AddSample(L"text", t.GetTimeInMs());
 
-    if (!rendered) {
-        logbench("Error: failed to render page %d", pagenum);
+    results.UpdateCacheStats(engine);
+    results.AddPage();
+}
+
+// times building the index of a .pdfsync or .synctex file next to a PDF document
+// (which happens when the first forward or inverse search is made after a compile)
+static void BenchSync(const WCHAR *filePath, BaseEngine *engine, BenchResults& results)
+{
+    Synchronizer *sync = NULL;
+    Timer t(true);
+    int err = Synchronizer::Create(filePath, static_cast<PdfEngine *>(engine), &sync);
+    if (err != PDFSYNCERR_SUCCESS)
+        return;
+    ScopedMem<WCHAR> srcfile;
+    UINT line, col;
+    err = sync->DocToSource(1, PointI(), srcfile, &line, &col);
+    t.Stop();
+    delete sync;
+
+    if (PDFSYNCERR_SYNCFILE_CANNOT_BE_OPENED == err) {
+        logbench("Error: failed to parse the sync file for %s", filePath);
+        results.AddError();
         return;
     }
-    delete rendered;
-    timems = t.GetTimeInMs();
-    logbench("pagerender %3d: %.2f ms", pagenum, timems);
+    logbench("sync: %.2f ms", t.GetTimeInMs());
+    results.AddSample(L"sync", t.GetTimeInMs());
 }
 
 // <s> can be:
@@ -119,7 +324,7 @@ bool IsBenchPagesInfo(const WCHAR *s)
     return str::EqI(s, L"loadonly") || IsValidPageRange(s);
 }
 
-static void BenchFile(WCHAR *filePath, const WCHAR *pagesSpec)
+static void BenchFile(WCHAR *filePath, const WCHAR *pagesSpec, BenchOptions& opts, BenchResults& results)
 {
     if (!file::Exists(filePath)) {
         return;
@@ -129,22 +334,40 @@ static void BenchFile(WCHAR *filePath, const WCHAR *pagesSpec)
     logbench("Starting: %s", filePath);
 
     Timer t(true);
-    BaseEngine *engine = EngineManager::CreateEngine(filePath, gGlobalPrefs->chmUI.useFixedPageUI);
+    DocType engineType;
+    BaseEngine *engine = EngineManager::CreateEngine(filePath, NULL, &engineType, gGlobalPrefs->chmUI.useFixedPageUI);
     t.Stop();
 
     if (!engine) {
         logbench("Error: failed to load %s", filePath);
+        results.AddError();
         return;
     }
 
     double timems = t.GetTimeInMs();
     logbench("load: %.2f ms", timems);
+    results.AddSample(L"open", timems);
+
+    // loading the same file a second time measures opening a file
+    // that's in the OS file cache
+    t.Start();
+    BaseEngine *engine2 = EngineManager::CreateEngine(filePath, gGlobalPrefs->chmUI.useFixedPageUI);
+    t.Stop();
+    if (engine2) {
+        logbench("load (warm): %.2f ms", t.GetTimeInMs());
+        results.AddSample(L"open (warm)", t.GetTimeInMs());
+    }
+    delete engine2;
+
+    if (Engine_PDF == engineType)
+        BenchSync(filePath, engine, results);
+
     int pages = engine->PageCount();
     logbench("page count: %d", pages);
 
     if (NULL == pagesSpec) {
         for (int i = 1; i <= pages; i++) {
-            BenchLoadRender(engine, i);
+            BenchLoadRender(engine, i, opts, results);
         }
     }
 
@@ -154,41 +377,107 @@ static void BenchFile(WCHAR *filePath, const WCHAR *pagesSpec)
         for (size_t i = 0; i < ranges.Count(); i++) {
             for (int j = ranges.At(i).start; j <= ranges.At(i).end; j++) {
                 if (1 <= j && j <= pages)
-                    BenchLoadRender(engine, j);
+                    BenchLoadRender(engine, j, opts, results);
             }
         }
     }
 
+    results.UpdateCacheStats(engine, true);
     delete engine;
     total.Stop();
 
     logbench("Finished (in %.2f ms): %s", total.GetTimeInMs(), filePath);
 }
 
-static void BenchDir(WCHAR *dir)
+// benchmarks all PDF, Mobi and comic book documents in a directory
+// (use "loadonly" as pagesSpec for only comparing load times over a corpus)
+static void BenchDir(WCHAR *dir, const WCHAR *pagesSpec, BenchOptions& opts, BenchResults& results)
 {
     WStrVec files;
-    ScopedMem<WCHAR> pattern(str::Format(L"%s\\*.pdf", dir));
+    ScopedMem<WCHAR> pattern(str::Format(L"%s\\*", dir));
     CollectPathsFromDirectory(pattern, files);
     for (size_t i = 0; i < files.Count(); i++) {
-        BenchFile(files.At(i), NULL);
+        if (path::Match(files.At(i), L"*.pdf;*.mobi;*.azw;*.prc;*.cbz;*.cbr"))
+            BenchFile(files.At(i), pagesSpec, opts, results);
     }
 }
 
-void BenchFileOrDir(WStrVec& pathsToBench)
+static void BenchPaths(WStrVec& pathsToBench, BenchOptions& opts, BenchResults& results)
 {
-    gLog = new slog::StderrLogger();
-
     size_t n = pathsToBench.Count() / 2;
     for (size_t i = 0; i < n; i++) {
         WCHAR *path = pathsToBench.At(2 * i);
         if (file::Exists(path))
-            BenchFile(path, pathsToBench.At(2 * i + 1));
+            BenchFile(path, pathsToBench.At(2 * i + 1), opts, results);
         else if (dir::Exists(path))
-            BenchDir(path);
+            BenchDir(path, pathsToBench.At(2 * i + 1), opts, results);
         else
             logbench("Error: file or dir %s doesn't exist", path);
     }
+}
+
+// benchmarks all paths with its own engines, concurrently with other BenchThreads
+class BenchThread : public ThreadBase {
+    WStrVec& pathsToBench;
+    BenchOptions& opts;
+    BenchResults& results;
+
+public:
+    BenchThread(WStrVec& pathsToBench, BenchOptions& opts, BenchResults& results) :
+        ThreadBase("BenchThread"), pathsToBench(pathsToBench), opts(opts), results(results) { }
+    virtual ~BenchThread() { }
+
+    virtual void Run() { BenchPaths(pathsToBench, opts, results); }
+};
+
+// parses a comma separated list of numbers (e.g. "100,200") into values
+// (returns the default value if the list is missing or invalid)
+template <typename T>
+static void ParseBenchValues(const WCHAR *list, Vec<T>& values, float scale, T defValue)
+{
+    WStrVec parts;
+    if (list)
+        parts.Split(list, L",", true);
+    for (size_t i = 0; i < parts.Count(); i++) {
+        float value;
+        if (str::Parse(parts.At(i), L"%f%$", &value))
+            values.Append((T)(value * scale));
+    }
+    if (values.Count() == 0)
+        values.Append(defValue);
+}
+
+void BenchFileOrDir(CommandLineInfo& i)
+{
+    gLog = new slog::StderrLogger();
+
+    BenchOptions opts;
+    ParseBenchValues(i.benchZoomLevels, opts.zoomLevels, 0.01f, 1.0f);
+    ParseBenchValues(i.benchRotations, opts.rotations, 1.0f, 0);
+    int threadCount = max(i.stressParallelCount, 1);
+
+    BenchResults results;
+    Timer total(true);
+    if (threadCount > 1) {
+        Vec<BenchThread *> threads;
+        for (int n = 0; n < threadCount; n++) {
+            threads.Append(new BenchThread(i.pathsToBenchmark, opts, results));
+            threads.Last()->Start();
+        }
+        for (size_t n = 0; n < threads.Count(); n++) {
+            threads.At(n)->Join();
+        }
+        DeleteVecMembers(threads);
+    }
+    else
+        BenchPaths(i.pathsToBenchmark, opts, results);
+    total.Stop();
+
+    if (i.benchJsonPath) {
+        ScopedMem<char> json(results.ToJson(i.pathsToBenchmark, threadCount, total.GetTimeInMs()));
+        if (!file::WriteAll(i.benchJsonPath, json, str::Len(json)))
+            logbench("Error: failed to write %s", i.benchJsonPath);
+    }
 
     delete gLog;
 }
@@ -4,15 +4,15 @@
 #ifndef StressTesting_h
 #define StressTesting_h
 
-bool IsValidPageRange(const WCHAR *ranges);
-bool IsBenchPagesInfo(const WCHAR *s);
-void BenchFileOrDir(WStrVec& pathsToBench);
-bool IsStressTesting();
-
 class WindowInfo;
 class RenderCache;
 class CommandLineInfo;
 
+bool IsValidPageRange(const WCHAR *ranges);
+bool IsBenchPagesInfo(const WCHAR *s);
+void BenchFileOrDir(CommandLineInfo& i);
+bool IsStressTesting();
+
 void StartStressTest(CommandLineInfo *, WindowInfo *, RenderCache *);
 
 void OnStressTestTimer(WindowInfo *win, int timerId);
@@ -5,6 +5,7 @@
 // and not compiled as stand-alone
 
 #include "DbgHelpDyn.h"
+#include "Trace.h"
 
 #ifdef DEBUG
 static bool TryLoadMemTrace()
@@ -348,6 +349,8 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 
     CommandLineInfo i;
     GetCommandLineInfo(i);
+    if (i.tracePath)
+        trace::Enable(true);
 
     SetCurrentLang(i.lang ? i.lang : gGlobalPrefs->uiLanguage);
 
@@ -356,7 +359,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
     if (i.makeDefault)
         AssociateExeWithPdfExtension();
     if (i.pathsToBenchmark.Count() > 0) {
-        BenchFileOrDir(i.pathsToBenchmark);
+        BenchFileOrDir(i);
         if (i.showConsole)
             system("pause");
     }
@@ -480,6 +483,8 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
     CleanUpThumbnailCache(gFileHistory);
 
 Exit:
+    if (i.tracePath)
+        trace::SaveChromeTrace(i.tracePath);
     prefs::UnregisterForFileChanges();
 
     while (gWindows.Count() > 0) {
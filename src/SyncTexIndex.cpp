@@ -0,0 +1,1031 @@
+/* Copyright 2014 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#include "BaseUtil.h"
+#include "SyncTexIndex.h"
+
+#include "FileUtil.h"
+#include "WinUtil.h"
+
+#include <zlib.h>
+
+#define SYNCTEX_INDEX_MAGIC     "SyncIdx"
+#define SYNCTEX_INDEX_VERSION   2
+// synctex_display_query looks for records at most this many lines below the requested one
+#define SYNCTEX_MAX_LINE_DELTA  1024
+// size of the buffer for reading (possibly gzip compressed) .synctex files
+#define SYNCTEX_READ_BUFFER     (64 * 1024)
+// number of cache files per path hash (for paths with colliding hashes)
+#define SYNCTEX_INDEX_CACHE_SLOTS   4
+// cached indices which haven't been used for this many seconds are deleted
+#define SYNCTEX_INDEX_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
+static int cmpSyncTexLines(const void *a, const void *b)
+{
+    const SyncTexLine *l1 = (const SyncTexLine *)a, *l2 = (const SyncTexLine *)b;
+    if (l1->tag != l2->tag)
+        return l1->tag < l2->tag ? -1 : 1;
+    if (l1->line != l2->line)
+        return l1->line < l2->line ? -1 : 1;
+    if (l1->rank != l2->rank)
+        return l1->rank - l2->rank;
+    return l1->node - l2->node;
+}
+
+static int cmpSyncTexPageBoxes(const void *a, const void *b)
+{
+    const SyncTexPageBox *b1 = (const SyncTexPageBox *)a, *b2 = (const SyncTexPageBox *)b;
+    if (b1->sheet != b2->sheet)
+        return b1->sheet - b2->sheet;
+    if (b1->top != b2->top)
+        return b1->top < b2->top ? -1 : 1;
+    return b1->order - b2->order;
+}
+
+// parses <count> integers separated by ':' or ',' (cf. _synctex_decode_int)
+static const char *ParseSyncTexInts(const char *s, int *values, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (':' == *s || ',' == *s)
+            s++;
+        bool negative = '-' == *s;
+        if (negative)
+            s++;
+        if (!str::IsDigit(*s))
+            return NULL;
+        unsigned int n = 0;
+        for (; str::IsDigit(*s); s++)
+            n = n * 10 + (*s - '0');
+        values[i] = negative ? -(int)n : (int)n;
+    }
+    return s;
+}
+
+// parses a dimension from the Post scriptum section and converts it to sp
+// (cf. _synctex_scan_float_and_dimension)
+static bool ParseSyncTexDimension(const char *s, float *value)
+{
+    static const struct {
+        const char *unit;
+        float factor;
+    } units[] = {
+        { "in", 72.27f * 65536 }, { "cm", 72.27f * 65536 / 2.54f }, { "mm", 72.27f * 65536 / 25.4f },
+        { "pt", 65536.0f }, { "bp", 72.27f / 72 * 65536.0f }, { "pc", 12.0f * 65536.0f },
+        { "sp", 1.0f }, { "dd", 1238.0f / 1157 * 65536.0f }, { "cc", 14856.0f / 1157 * 65536 },
+        { "nd", 685.0f / 642 * 65536 }, { "nc", 1370.0f / 107 * 65536 },
+    };
+    char *end;
+    float f = (float)strtod(s, &end);
+    if (end == s)
+        return false;
+    for (size_t i = 0; i < dimof(units); i++) {
+        if (str::StartsWith(end, units[i].unit)) {
+            f *= units[i].factor;
+            break;
+        }
+    }
+    *value = f;
+    return true;
+}
+
+// builds a SyncTexIndex in a single pass over a .synctex or .synctex.gz file
+class SyncTexIndexBuilder {
+public:
+    SyncTexIndexBuilder() : hasVersion(false), inContent(false), inPostamble(false),
+        inPostScriptum(false), inSheet(false), ignoreSheet(false), sheet(-1), nestedSheets(0), closeOrder(0),
+        preMagnification(1000), preUnit(8192), preXOffset(578), preYOffset(578),
+        postMagnification(0), postXOffset(6.027e23f), postYOffset(6.027e23f) { }
+
+    bool Parse(const WCHAR *syncfile);
+    char *Serialize(const WCHAR *syncfile, int64 syncFileSize, FILETIME syncFileTime, size_t *lenOut);
+
+private:
+    bool ParseLine(char *line);
+    bool ParseRecord(const char *line);
+    bool ParseInput(const char *line);
+    bool ParsePostScriptum(const char *line);
+    int AddNode(int type, int tag, int line, int h, int v, int width);
+    int AddBox(int type, const int values[7]);
+    void CloseBox(int type);
+    void AddLine(int node, int rank);
+    void WidenParent(int h);
+
+    bool hasVersion, inContent, inPostamble, inPostScriptum;
+    bool inSheet, ignoreSheet;
+    int sheet, nestedSheets;
+    Vec<int> boxStack; // currently open boxes (the current sheet's box at the bottom)
+    int closeOrder;
+
+    int preMagnification, preUnit, preXOffset, preYOffset;
+    float postMagnification, postXOffset, postYOffset;
+
+    Vec<SyncTexNode> nodes;
+    Vec<SyncTexBox> boxes;
+    Vec<SyncTexLine> lines;
+    Vec<SyncTexPageBox> pageBoxes;
+    Vec<int> pageSheets;
+    Vec<SyncTexInput> inputs;
+    str::Str<char> names;
+};
+
+bool SyncTexIndexBuilder::Parse(const WCHAR *syncfile)
+{
+    ScopedMem<char> buffer(AllocArray<char>(SYNCTEX_READ_BUFFER + 1));
+    if (!buffer)
+        return false;
+    // gzread transparently reads uncompressed files as well
+    gzFile file = gzopen_w(syncfile, "rb");
+    if (!file)
+        return false;
+
+    bool ok = true;
+    size_t len = 0;
+    while (ok) {
+        int read = gzread(file, buffer + len, (unsigned int)(SYNCTEX_READ_BUFFER - len));
+        if (read < 0) {
+            ok = false;
+            break;
+        }
+        len += read;
+        char *line = buffer, *end = buffer + len;
+        char *next;
+        while (ok && (next = (char *)memchr(line, '\n', end - line)) != NULL) {
+            *next = '\0';
+            if (next > line && '\r' == next[-1])
+                next[-1] = '\0';
+            ok = ParseLine(line);
+            line = next + 1;
+        }
+        len = end - line;
+        if (0 == read) {
+            // the last line doesn't have to be terminated
+            if (ok && len > 0) {
+                line[len] = '\0';
+                ok = ParseLine(line);
+            }
+            break;
+        }
+        // lines longer than the buffer are not expected
+        if (len == SYNCTEX_READ_BUFFER)
+            ok = false;
+        memmove(buffer, line, len);
+    }
+    gzclose(file);
+
+    return ok && inContent;
+}
+
+bool SyncTexIndexBuilder::ParseLine(char *line)
+{
+    if (!hasVersion) {
+        hasVersion = str::StartsWith(line, "SyncTeX Version:");
+        return hasVersion;
+    }
+    if (inSheet)
+        return ParseRecord(line);
+    if (inPostScriptum)
+        return ParsePostScriptum(line);
+    if (str::StartsWith(line, "Input:"))
+        return ParseInput(line + 6);
+    if (!inContent) {
+        if (!str::Parse(line, "Magnification:%d", &preMagnification) &&
+            !str::Parse(line, "Unit:%d", &preUnit) &&
+            !str::Parse(line, "X Offset:%d", &preXOffset) &&
+            !str::Parse(line, "Y Offset:%d", &preYOffset)) {
+            inContent = str::StartsWith(line, "Content:");
+        }
+        return true;
+    }
+    if (inPostamble) {
+        inPostScriptum = str::StartsWith(line, "Post scriptum:");
+        return true;
+    }
+    if (str::StartsWith(line, "Postamble:")) {
+        inPostamble = true;
+        return true;
+    }
+    if (*line != '{')
+        return true;
+
+    int page;
+    if (!ParseSyncTexInts(line + 1, &page, 1))
+        return false;
+    inSheet = true;
+    ignoreSheet = page <= 0 || page > (1 << 20);
+    if (ignoreSheet)
+        return true;
+
+    sheet = AddNode(SyncTex_Sheet, 0, 0, 0, 0, 0);
+    SyncTexBox box = { 0 };
+    box.node = sheet;
+    box.page = page;
+    nodes.At(sheet).box = (int)boxes.Count();
+    boxes.Append(box);
+    boxStack.Reset();
+    boxStack.Append(nodes.At(sheet).box);
+    if (pageSheets.Count() <= (size_t)page)
+        pageSheets.AppendBlanks(page + 1 - pageSheets.Count());
+    // synctex_edit_query uses the last sheet for duplicate page numbers
+    pageSheets.At(page) = sheet + 1;
+    return true;
+}
+
+bool SyncTexIndexBuilder::ParseRecord(const char *line)
+{
+    if ('{' == *line) {
+        // nested sheets (e.g. from \includegraphics with clipping) are ignored
+        nestedSheets++;
+        return true;
+    }
+    if ('}' == *line) {
+        if (nestedSheets > 0)
+            nestedSheets--;
+        else
+            inSheet = false;
+        return true;
+    }
+    if (nestedSheets > 0 || ignoreSheet)
+        return true;
+
+    int values[7], node;
+    switch (*line) {
+    case '[': case '(':
+        if (!ParseSyncTexInts(line + 1, values, 7))
+            return false;
+        if ('(' == *line) {
+            WidenParent(values[2]);
+            WidenParent(values[2] + abs(values[4]));
+        }
+        boxStack.Append(AddBox('[' == *line ? SyncTex_VBox : SyncTex_HBox, values));
+        break;
+    case ']': case ')':
+        CloseBox(']' == *line ? SyncTex_VBox : SyncTex_HBox);
+        break;
+    case 'v': case 'h':
+        if (!ParseSyncTexInts(line + 1, values, 7))
+            return false;
+        if ('h' == *line) {
+            WidenParent(values[2]);
+            WidenParent(values[2] + abs(values[4]));
+        }
+        node = boxes.At(AddBox('v' == *line ? SyncTex_VoidVBox : SyncTex_VoidHBox, values)).node;
+        AddLine(node, 2);
+        break;
+    case 'k':
+        if (!ParseSyncTexInts(line + 1, values, 5))
+            return false;
+        WidenParent(values[2]);
+        WidenParent(values[2] - values[4]);
+        AddLine(AddNode(SyncTex_Kern, values[0], values[1], values[2], values[3], values[4]), 1);
+        break;
+    case 'g': case '$': case 'x':
+        if (!ParseSyncTexInts(line + 1, values, 4))
+            return false;
+        WidenParent(values[2]);
+        node = AddNode('g' == *line ? SyncTex_Glue : '$' == *line ? SyncTex_Math : SyncTex_Boundary,
+                       values[0], values[1], values[2], values[3], 0);
+        AddLine(node, 'x' == *line ? 0 : 1);
+        break;
+    }
+    return true;
+}
+
+bool SyncTexIndexBuilder::ParseInput(const char *line)
+{
+    SyncTexInput input;
+    const char *name = ParseSyncTexInts(line, &input.tag, 1);
+    if (!name || *name != ':')
+        return false;
+    input.name = (int)names.Size();
+    names.Append(name + 1);
+    names.Append('\0');
+    inputs.Append(input);
+    return true;
+}
+
+bool SyncTexIndexBuilder::ParsePostScriptum(const char *line)
+{
+    if (str::StartsWith(line, "Magnification:")) {
+        char *end;
+        postMagnification = (float)strtod(line + 14, &end);
+        return end != line + 14 && postMagnification > 0;
+    }
+    if (str::StartsWith(line, "X Offset:"))
+        return ParseSyncTexDimension(line + 9, &postXOffset);
+    if (str::StartsWith(line, "Y Offset:"))
+        return ParseSyncTexDimension(line + 9, &postYOffset);
+    return true;
+}
+
+int SyncTexIndexBuilder::AddNode(int type, int tag, int line, int h, int v, int width)
+{
+    SyncTexNode node = { type, tag, line, h, v, width, -1, -1 };
+    if (boxStack.Count() > 0 && type != SyncTex_Sheet)
+        node.parent = boxStack.Last();
+    nodes.Append(node);
+    return (int)nodes.Count() - 1;
+}
+
+int SyncTexIndexBuilder::AddBox(int type, const int values[7])
+{
+    SyncTexBox box = { 0 };
+    box.node = AddNode(type, values[0], values[1], values[2], values[3], values[4]);
+    box.page = boxes.At(boxStack.At(0)).page;
+    box.height = values[5];
+    box.depth = values[6];
+    box.visibleH = values[2];
+    box.visibleWidth = values[4];
+    nodes.At(box.node).box = (int)boxes.Count();
+    boxes.Append(box);
+    return (int)boxes.Count() - 1;
+}
+
+void SyncTexIndexBuilder::CloseBox(int type)
+{
+    // unbalanced closings are ignored (same as synctex_parser)
+    if (boxStack.Count() < 2 || nodes.At(boxes.At(boxStack.Last()).node).type != type)
+        return;
+    SyncTexBox& box = boxes.At(boxStack.Pop());
+    SyncTexNode& node = nodes.At(box.node);
+    // only boxes without children are used for forward search
+    if (box.node == (int)nodes.Count() - 1)
+        AddLine(box.node, 2);
+    if (SyncTex_HBox == type) {
+        SyncTexPageBox pbox = { sheet, node.v - abs(box.height), node.box, closeOrder++ };
+        pageBoxes.Append(pbox);
+    }
+}
+
+void SyncTexIndexBuilder::AddLine(int node, int rank)
+{
+    SyncTexLine line = { nodes.At(node).tag, nodes.At(node).line, rank, node };
+    lines.Append(line);
+}
+
+// cf. _synctex_horiz_box_setup_visible
+void SyncTexIndexBuilder::WidenParent(int h)
+{
+    SyncTexBox& box = boxes.At(boxStack.Last());
+    if (nodes.At(box.node).type != SyncTex_HBox)
+        return;
+    if (box.visibleWidth < 0) {
+        int btm = box.visibleH, top = box.visibleH - box.visibleWidth;
+        if (h < btm) {
+            box.visibleH = h;
+            box.visibleWidth = box.visibleH - top;
+        }
+        else if (h > top) {
+            box.visibleWidth = box.visibleH - h;
+        }
+    }
+    else {
+        int btm = box.visibleH, top = box.visibleH + box.visibleWidth;
+        if (h < btm) {
+            box.visibleH = h;
+            box.visibleWidth = top - box.visibleH;
+        }
+        else if (h > top) {
+            box.visibleWidth = h - box.visibleH;
+        }
+    }
+}
+
+char *SyncTexIndexBuilder::Serialize(const WCHAR *syncfile, int64 syncFileSize, FILETIME syncFileTime, size_t *lenOut)
+{
+    SyncTexIndexHeader header = { 0 };
+    memcpy(header.magic, SYNCTEX_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SYNCTEX_INDEX_VERSION;
+    header.headerSize = sizeof(SyncTexIndexHeader);
+    header.syncFileSize = syncFileSize;
+    header.syncFileTime = syncFileTime;
+
+    // cf. synctex_scanner_parse
+    if (preUnit <= 0)
+        preUnit = 8192;
+    if (preMagnification <= 0)
+        preMagnification = 1000;
+    if (postMagnification <= 0)
+        header.unit = (float)(preUnit / 65781.76);
+    else
+        header.unit = (float)(postMagnification * (preUnit / 65781.76));
+    header.unit = (float)(header.unit * (preMagnification / 1000.0));
+    if (postXOffset > 6e23) {
+        header.xOffset = (float)(preXOffset * (preUnit / 65781.76));
+        header.yOffset = (float)(preYOffset * (preUnit / 65781.76));
+    }
+    else {
+        header.xOffset = postXOffset / 65781.76f;
+        header.yOffset = postYOffset / 65781.76f;
+    }
+
+    // collect the children of all boxes in document order
+    Vec<int> children;
+    children.AppendBlanks(nodes.Count());
+    int childCount = 0;
+    for (size_t i = 0; i < nodes.Count(); i++) {
+        if (nodes.At(i).parent != -1)
+            boxes.At(nodes.At(i).parent).childCount++;
+    }
+    for (size_t i = 0; i < boxes.Count(); i++) {
+        boxes.At(i).firstChild = childCount;
+        childCount += boxes.At(i).childCount;
+        boxes.At(i).childCount = 0;
+    }
+    for (size_t i = 0; i < nodes.Count(); i++) {
+        if (nodes.At(i).parent != -1) {
+            SyncTexBox& box = boxes.At(nodes.At(i).parent);
+            children.At(box.firstChild + box.childCount++) = (int)i;
+        }
+    }
+
+    lines.Sort(cmpSyncTexLines);
+    pageBoxes.Sort(cmpSyncTexPageBoxes);
+
+    Vec<SyncTexPage> pages;
+    for (size_t i = 0; i < pageSheets.Count(); i++) {
+        SyncTexPage page = { pageSheets.At(i) - 1, 0 };
+        pages.Append(page);
+    }
+    for (size_t i = 0; i < pageBoxes.Count(); i++) {
+        SyncTexBox& box = boxes.At(pageBoxes.At(i).box);
+        int page = box.page;
+        if (pages.At(page).sheet == pageBoxes.At(i).sheet)
+            pages.At(page).maxExtent = max(pages.At(page).maxExtent, abs(box.height) + abs(box.depth));
+    }
+    if (names.Size() == 0)
+        names.Append('\0');
+
+    header.nodeCount = (int)nodes.Count();
+    header.boxCount = (int)boxes.Count();
+    header.childCount = childCount;
+    header.lineCount = (int)lines.Count();
+    header.pageBoxCount = (int)pageBoxes.Count();
+    header.pageCount = (int)pages.Count();
+    header.inputCount = (int)inputs.Count();
+    header.syncPathLen = (int)str::Len(syncfile) + 1;
+    header.namesLen = (int)names.Size();
+
+    size_t len = sizeof(header) + nodes.Count() * sizeof(SyncTexNode) +
+                 boxes.Count() * sizeof(SyncTexBox) + childCount * sizeof(int) +
+                 lines.Count() * sizeof(SyncTexLine) + pageBoxes.Count() * sizeof(SyncTexPageBox) +
+                 pages.Count() * sizeof(SyncTexPage) + inputs.Count() * sizeof(SyncTexInput) +
+                 header.syncPathLen * sizeof(WCHAR) + names.Size();
+    char *data = AllocArray<char>(len);
+    if (!data)
+        return NULL;
+    char *ptr = data;
+#define AppendData(src, size) memcpy(ptr, src, size); ptr += size
+    AppendData(&header, sizeof(header));
+    AppendData(nodes.LendData(), nodes.Count() * sizeof(SyncTexNode));
+    AppendData(boxes.LendData(), boxes.Count() * sizeof(SyncTexBox));
+    AppendData(children.LendData(), childCount * sizeof(int));
+    AppendData(lines.LendData(), lines.Count() * sizeof(SyncTexLine));
+    AppendData(pageBoxes.LendData(), pageBoxes.Count() * sizeof(SyncTexPageBox));
+    AppendData(pages.LendData(), pages.Count() * sizeof(SyncTexPage));
+    AppendData(inputs.LendData(), inputs.Count() * sizeof(SyncTexInput));
+    AppendData(syncfile, header.syncPathLen * sizeof(WCHAR));
+    AppendData(names.LendData(), names.Size());
+#undef AppendData
+    CrashIf(ptr != data + len);
+
+    *lenOut = len;
+    return data;
+}
+
+SyncTexIndex::~SyncTexIndex()
+{
+    if (isMapped)
+        file::UnmapView(data);
+    else
+        free(data);
+}
+
+// deletes cached indices which haven't been used for a while
+static void PruneIndexCache(const WCHAR *tempDir)
+{
+    ScopedMem<WCHAR> pattern(path::Join(tempDir, L"SumatraPDF-synctex-*.idx"));
+    WIN32_FIND_DATA fdata;
+    HANDLE hfind = FindFirstFile(pattern, &fdata);
+    if (INVALID_HANDLE_VALUE == hfind)
+        return;
+
+    FILETIME currTime;
+    GetSystemTimeAsFileTime(&currTime);
+    do {
+        if (!(fdata.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+            FileTimeDiffInSecs(currTime, fdata.ftLastWriteTime) > SYNCTEX_INDEX_CACHE_MAX_AGE) {
+            ScopedMem<WCHAR> cachefile(path::Join(tempDir, fdata.cFileName));
+            file::Delete(cachefile);
+        }
+    } while (FindNextFile(hfind, &fdata));
+    FindClose(hfind);
+}
+
+SyncTexIndex *SyncTexIndex::Create(const WCHAR *syncfile)
+{
+    ScopedMem<WCHAR> tempDir(path::GetTempPath()), key(str::Dup(syncfile));
+    if (!tempDir || !key)
+        return Build(syncfile);
+
+    // the index is cached in the temp directory (the cached copy is only used
+    // if it was built for the same path and the .synctex file's size and
+    // timestamp match); paths with colliding hashes use different slots
+    str::ToLower(key);
+    UINT32 hash = MurmurHash2(key.Get(), str::Len(key) * sizeof(WCHAR));
+    ScopedMem<WCHAR> cachefile;
+    for (int slot = 0; slot < SYNCTEX_INDEX_CACHE_SLOTS && !cachefile; slot++) {
+        ScopedMem<WCHAR> name(str::Format(L"SumatraPDF-synctex-%08x-%d.idx", hash, slot));
+        ScopedMem<WCHAR> slotfile(path::Join(tempDir, name));
+        if (!file::Exists(slotfile)) {
+            cachefile.Set(slotfile.StealData());
+            break;
+        }
+        size_t len;
+        const char *data = file::MapView(slotfile, &len);
+        if (!data)
+            continue;
+        SyncTexIndex index((char *)data, len, true);
+        // reuse the slot if it belongs to this file or can't be used anyway
+        if (!index.Init() || str::EqI(index.syncPath, syncfile))
+            cachefile.Set(slotfile.StealData());
+    }
+
+    if (cachefile && file::Exists(cachefile)) {
+        // keep the index from being pruned while it's in use
+        // (this has to happen before the file is mapped into memory)
+        FILETIME currTime;
+        GetSystemTimeAsFileTime(&currTime);
+        file::SetModificationTime(cachefile, currTime);
+        SyncTexIndex *index = Load(cachefile, syncfile);
+        if (index)
+            return index;
+    }
+
+    SyncTexIndex *index = Build(syncfile);
+    if (index && cachefile && index->Save(cachefile))
+        PruneIndexCache(tempDir);
+    return index;
+}
+
+SyncTexIndex *SyncTexIndex::Build(const WCHAR *syncfile)
+{
+    // get the file's size and time before parsing so that a concurrent
+    // update makes the cached index stale instead of inconsistent
+    int64 fileSize = file::GetSize(syncfile);
+    FILETIME fileTime = file::GetModificationTime(syncfile);
+
+    SyncTexIndexBuilder builder;
+    if (!builder.Parse(syncfile))
+        return NULL;
+    size_t len;
+    char *data = builder.Serialize(syncfile, fileSize, fileTime, &len);
+    if (!data)
+        return NULL;
+
+    SyncTexIndex *index = new SyncTexIndex(data, len, false);
+    if (!index->Init()) {
+        delete index;
+        return NULL;
+    }
+    return index;
+}
+
+SyncTexIndex *SyncTexIndex::Load(const WCHAR *cachefile, const WCHAR *syncfile)
+{
+    size_t len;
+    const char *data = file::MapView(cachefile, &len);
+    if (!data)
+        return NULL;
+
+    SyncTexIndex *index = new SyncTexIndex((char *)data, len, true);
+    // the cache file's name is derived from a hash of the path, so the
+    // path itself has to be compared to rule out hash collisions
+    if (!index->Init() || !index->IsValid() || !str::EqI(index->syncPath, syncfile) ||
+        index->header->syncFileSize != file::GetSize(syncfile) ||
+        !FileTimeEq(index->header->syncFileTime, file::GetModificationTime(syncfile))) {
+        delete index;
+        return NULL;
+    }
+    return index;
+}
+
+bool SyncTexIndex::Save(const WCHAR *cachefile) const
+{
+    CrashIf(isMapped);
+    return file::WriteAll(cachefile, data, len);
+}
+
+bool SyncTexIndex::Init()
+{
+    if (len < sizeof(SyncTexIndexHeader))
+        return false;
+    header = (const SyncTexIndexHeader *)data;
+    if (!memeq(header->magic, SYNCTEX_INDEX_MAGIC, sizeof(header->magic)) ||
+        header->version != SYNCTEX_INDEX_VERSION || header->headerSize != sizeof(SyncTexIndexHeader)) {
+        return false;
+    }
+
+    size_t offset = sizeof(SyncTexIndexHeader);
+#define InitArray(ptr, type, count) \
+    if (count < 0 || (size_t)count > (len - offset) / sizeof(type)) \
+        return false; \
+    ptr = (const type *)(data + offset); \
+    offset += count * sizeof(type)
+    InitArray(nodes, SyncTexNode, header->nodeCount);
+    InitArray(boxes, SyncTexBox, header->boxCount);
+    InitArray(children, int, header->childCount);
+    InitArray(lines, SyncTexLine, header->lineCount);
+    InitArray(pageBoxes, SyncTexPageBox, header->pageBoxCount);
+    InitArray(pages, SyncTexPage, header->pageCount);
+    InitArray(inputs, SyncTexInput, header->inputCount);
+    InitArray(syncPath, WCHAR, header->syncPathLen);
+    InitArray(names, char, header->namesLen);
+#undef InitArray
+
+    return offset == len && header->syncPathLen > 0 && '\0' == syncPath[header->syncPathLen - 1] &&
+           header->namesLen > 0 && '\0' == names[header->namesLen - 1];
+}
+
+// makes sure that a cached index can't lead to out-of-bounds reads
+// or endless loops (each node's parent must precede it)
+bool SyncTexIndex::IsValid() const
+{
+    for (int i = 0; i < header->nodeCount; i++) {
+        const SyncTexNode& node = nodes[i];
+        if (node.type < SyncTex_Sheet || node.type > SyncTex_Boundary)
+            return false;
+        if ((SyncTex_Sheet == node.type) != (-1 == node.parent))
+            return false;
+        if (node.parent != -1 && (node.parent < 0 || node.parent >= header->boxCount || boxes[node.parent].node >= i))
+            return false;
+        if ((node.type > SyncTex_VoidHBox) != (-1 == node.box))
+            return false;
+        if (node.box != -1 && (node.box < 0 || node.box >= header->boxCount || boxes[node.box].node != i))
+            return false;
+    }
+    for (int i = 0; i < header->boxCount; i++) {
+        const SyncTexBox& box = boxes[i];
+        if (box.node < 0 || box.node >= header->nodeCount || box.firstChild < 0 || box.childCount < 0 ||
+            box.childCount > header->childCount - box.firstChild) {
+            return false;
+        }
+        for (int j = 0; j < box.childCount; j++) {
+            int child = children[box.firstChild + j];
+            if (child < 0 || child >= header->nodeCount || nodes[child].parent != i)
+                return false;
+        }
+    }
+    for (int i = 0; i < header->lineCount; i++) {
+        if (lines[i].node < 0 || lines[i].node >= header->nodeCount || nodes[lines[i].node].parent == -1)
+            return false;
+    }
+    for (int i = 0; i < header->pageBoxCount; i++) {
+        if (pageBoxes[i].box < 0 || pageBoxes[i].box >= header->boxCount)
+            return false;
+    }
+    for (int i = 0; i < header->pageCount; i++) {
+        int sheet = pages[i].sheet;
+        if (sheet != -1 && (sheet < 0 || sheet >= header->nodeCount || nodes[sheet].type != SyncTex_Sheet))
+            return false;
+    }
+    for (int i = 0; i < header->inputCount; i++) {
+        if (inputs[i].name < 0 || inputs[i].name >= header->namesLen)
+            return false;
+    }
+    return true;
+}
+
+const char *SyncTexIndex::GetNameForTag(int tag) const
+{
+    for (int i = 0; i < header->inputCount; i++) {
+        if (inputs[i].tag == tag)
+            return names + inputs[i].name;
+    }
+    return NULL;
+}
+
+int SyncTexIndex::GetPage(int node) const
+{
+    int box = nodes[node].parent != -1 ? nodes[node].parent : nodes[node].box;
+    return boxes[box].page;
+}
+
+// cf. synctex_node_box_visible_h/v/width/height/depth
+RectD SyncTexIndex::GetBoxRect(int node) const
+{
+    int ix = IsBox(node) ? nodes[node].box : nodes[node].parent;
+    if (-1 == ix || SyncTex_Sheet == nodes[boxes[ix].node].type)
+        return RectD();
+    const SyncTexBox& box = boxes[ix];
+    return RectD(box.visibleH * header->unit + header->xOffset,
+                 (nodes[box.node].v - box.height) * header->unit + header->yOffset,
+                 box.visibleWidth * header->unit, (box.height + box.depth) * header->unit);
+}
+
+bool SyncTexIndex::IsDescendant(int node, int box) const
+{
+    for (int parent = nodes[node].parent; parent != -1; parent = nodes[boxes[parent].node].parent) {
+        if (parent == box)
+            return true;
+    }
+    return false;
+}
+
+bool SyncTexIndex::DisplayQuery(int tag, int line, Vec<int>& results) const
+{
+    results.Reset();
+
+    // find the first record for the given line or (failing that) one of the following lines
+    int lo = 0, hi = header->lineCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (lines[mid].tag < tag || (lines[mid].tag == tag && lines[mid].line < line))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == header->lineCount || lines[lo].tag != tag || (int64)lines[lo].line - line >= SYNCTEX_MAX_LINE_DELTA)
+        return false;
+
+    // only use records of the most preferred kind and skip those
+    // inside the same box as the previously used record
+    const SyncTexLine& first = lines[lo];
+    for (int i = lo; i < header->lineCount; i++) {
+        if (lines[i].tag != first.tag || lines[i].line != first.line || lines[i].rank != first.rank)
+            break;
+        int node = lines[i].node;
+        if (results.Count() > 0 && IsDescendant(node, nodes[results.Last()].parent))
+            continue;
+        results.Append(node);
+    }
+    return true;
+}
+
+// cf. _synctex_point_h_distance
+int SyncTexIndex::HDistance(PointI pt, int node) const
+{
+    const SyncTexNode& n = nodes[node];
+    int min, max, med;
+    if (IsBox(node)) {
+        // visible dimensions only differ from the actual ones for hboxes
+        min = boxes[n.box].visibleH;
+        max = min + abs(boxes[n.box].visibleWidth);
+        if (pt.x < min)
+            return min - pt.x;
+        if (pt.x > max)
+            return max - pt.x;
+        return 0;
+    }
+    switch (n.type) {
+    case SyncTex_Kern:
+        // the location of the kern is recorded after the move
+        if (n.width < 0) {
+            min = n.h;
+            max = n.h - n.width;
+        }
+        else {
+            min = n.h - n.width;
+            max = n.h;
+        }
+        med = (min + max) / 2;
+        if (pt.x < min)
+            return min - pt.x + 1;
+        if (pt.x > max)
+            return max - pt.x - 1;
+        if (pt.x > med)
+            return max - pt.x + 1;
+        return min - pt.x - 1;
+    case SyncTex_Glue: case SyncTex_Math:
+        return n.h - pt.x;
+    }
+    return INT_MAX;
+}
+
+// cf. _synctex_point_v_distance
+int SyncTexIndex::VDistance(PointI pt, int node) const
+{
+    const SyncTexNode& n = nodes[node];
+    if (IsBox(node)) {
+        int min = n.v - abs(boxes[n.box].height);
+        int max = n.v + abs(boxes[n.box].depth);
+        if (pt.y < min)
+            return min - pt.y;
+        if (pt.y > max)
+            return max - pt.y;
+        return 0;
+    }
+    switch (n.type) {
+    case SyncTex_Kern: case SyncTex_Glue: case SyncTex_Math:
+        return n.v - pt.y;
+    }
+    return INT_MAX;
+}
+
+bool SyncTexIndex::IsPointInBox(PointI pt, int node) const
+{
+    return 0 == HDistance(pt, node) && 0 == VDistance(pt, node);
+}
+
+// cf. _synctex_node_distance_to_point
+int SyncTexIndex::DistanceToPoint(PointI pt, int node) const
+{
+    const SyncTexNode& n = nodes[node];
+    int minH, maxH, minV, maxV;
+    if (IsBox(node)) {
+        minH = n.h;
+        maxH = n.h + abs(n.width);
+        minV = n.v - abs(boxes[n.box].height);
+        maxV = n.v + abs(boxes[n.box].depth);
+    }
+    else if (SyncTex_Kern == n.type) {
+        minH = n.width < 0 ? n.h : n.h - n.width;
+        maxH = n.width < 0 ? n.h - n.width : n.h;
+        minV = maxV = n.v;
+    }
+    else if (SyncTex_Glue == n.type || SyncTex_Math == n.type) {
+        minH = maxH = n.h;
+        minV = maxV = n.v;
+    }
+    else
+        return INT_MAX;
+    // L1 distance to the node's bounds
+    int dh = pt.x < minH ? minH - pt.x : pt.x > maxH ? pt.x - maxH : 0;
+    int dv = pt.y < minV ? minV - pt.y : pt.y > maxV ? pt.y - maxV : 0;
+    return dh + dv;
+}
+
+// cf. _synctex_eq_deepest_container
+int SyncTexIndex::DeepestContainer(PointI pt, int node) const
+{
+    if (!IsContainer(node))
+        return -1;
+    int count = boxes[nodes[node].box].childCount;
+    for (int i = 0; i < count; i++) {
+        int result = DeepestContainer(pt, GetChild(node, i));
+        if (result != -1)
+            return result;
+    }
+    if (!IsPointInBox(pt, node))
+        return -1;
+    if (SyncTex_VBox == nodes[node].type) {
+        // use the closest child which has children of its own
+        int bestDistance = INT_MAX, best = node;
+        for (int i = 0; i < count; i++) {
+            int child = GetChild(node, i);
+            if (HasChildren(child)) {
+                int distance = DistanceToPoint(pt, child);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = child;
+                }
+            }
+        }
+        return best;
+    }
+    return node;
+}
+
+// cf. __synctex_eq_closest_child
+int SyncTexIndex::ClosestChild(PointI pt, int node, int *distance) const
+{
+    int best = -1;
+    int count = boxes[nodes[node].box].childCount;
+    for (int i = 0; i < count; i++) {
+        int child = GetChild(node, i);
+        int d = DistanceToPoint(pt, child);
+        if (d <= *distance) {
+            *distance = d;
+            best = child;
+        }
+        if (IsContainer(child)) {
+            int candidate = ClosestChild(pt, child, distance);
+            if (candidate != -1)
+                best = candidate;
+        }
+    }
+    return best;
+}
+
+// cf. _synctex_eq_closest_child
+int SyncTexIndex::ClosestChild(PointI pt, int node) const
+{
+    if (!IsContainer(node))
+        return -1;
+    int bestDistance = INT_MAX;
+    int best = ClosestChild(pt, node, &bestDistance);
+    if (best != -1 && HasChildren(best)) {
+        // note: synctex_parser never picks the first child here
+        int parent = best, count = boxes[nodes[parent].box].childCount;
+        bestDistance = DistanceToPoint(pt, GetChild(parent, 0));
+        for (int i = 1; i < count; i++) {
+            int distance = DistanceToPoint(pt, GetChild(parent, i));
+            if (distance <= bestDistance) {
+                bestDistance = distance;
+                best = GetChild(parent, i);
+            }
+        }
+    }
+    return best;
+}
+
+// cf. _synctex_eq_get_closest_children_in_box
+// (best[0] and distances[0] are for the left/top, best[1] and distances[1] for the right/bottom)
+void SyncTexIndex::GetClosestChildren(PointI pt, int node, int best[2], int distances[2]) const
+{
+    if (!IsContainer(node))
+        return;
+    bool isHBox = SyncTex_HBox == nodes[node].type;
+    bool updated[2] = { false, false };
+    int count = boxes[nodes[node].box].childCount;
+    for (int i = 0; i < count; i++) {
+        int child = GetChild(node, i);
+        int offset = isHBox ? HDistance(pt, child) : VDistance(pt, child);
+        if (0 == offset) {
+            distances[0] = distances[1] = 0;
+            best[0] = child;
+            best[1] = -1;
+            updated[0] = true;
+            continue;
+        }
+        int side = offset > 0 ? 1 : 0;
+        offset = abs(offset);
+        if (distances[side] > offset) {
+            distances[side] = offset;
+            best[side] = child;
+            updated[side] = true;
+        }
+        else if (distances[side] == offset && best[side] != -1 && nodes[best[side]].tag == nodes[child].tag &&
+                 nodes[best[side]].line > nodes[child].line) {
+            // prefer the earlier line for equally distant records
+            best[side] = child;
+            updated[side] = true;
+        }
+    }
+    // try to narrow the result
+    for (int side = 0; side < 2; side++) {
+        if (!updated[side] || -1 == best[side])
+            continue;
+        int result = DeepestContainer(pt, best[side]);
+        if (result != -1)
+            best[side] = result;
+        result = ClosestChild(pt, best[side]);
+        if (result != -1)
+            best[side] = result;
+    }
+}
+
+int SyncTexIndex::EditQuery(int page, float h, float v) const
+{
+    if (page <= 0 || page >= header->pageCount || -1 == pages[page].sheet || header->unit <= 0)
+        return -1;
+    int sheet = pages[page].sheet;
+    PointI pt((int)((h - header->xOffset) / header->unit), (int)((v - header->yOffset) / header->unit));
+
+    // find the smallest hbox containing the point among those with a matching top edge
+    int minTop = pt.y - pages[page].maxExtent;
+    int lo = 0, hi = header->pageBoxCount;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (pageBoxes[mid].sheet < sheet || (pageBoxes[mid].sheet == sheet && pageBoxes[mid].top < minTop))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    int container = -1, containerOrder = -1;
+    for (int i = lo; i < header->pageBoxCount && pageBoxes[i].sheet == sheet && pageBoxes[i].top <= pt.y; i++) {
+        const SyncTexBox& box = boxes[pageBoxes[i].box];
+        if (!IsPointInBox(pt, box.node))
+            continue;
+        if (container != -1) {
+            // cf. _synctex_smallest_container (which prefers the later box for equal sizes)
+            const SyncTexNode& n1 = nodes[container];
+            const SyncTexNode& n2 = nodes[box.node];
+            int height1 = abs(boxes[n1.box].height) + abs(boxes[n1.box].depth);
+            int height2 = abs(box.height) + abs(box.depth);
+            if (abs(n1.width) < abs(n2.width) || (abs(n1.width) == abs(n2.width) &&
+                (height1 < height2 || (height1 == height2 && containerOrder > pageBoxes[i].order)))) {
+                continue;
+            }
+        }
+        container = box.node;
+        containerOrder = pageBoxes[i].order;
+    }
+    if (-1 == container) {
+        if (0 == boxes[nodes[sheet].box].childCount)
+            return -1;
+        container = GetChild(sheet, 0);
+    }
+
+    int deepest = DeepestContainer(pt, container);
+    if (deepest != -1)
+        container = deepest;
+    int best[2] = { -1, -1 }, distances[2] = { INT_MAX, INT_MAX };
+    GetClosestChildren(pt, container, best, distances);
+    if (best[0] != -1 && best[1] != -1)
+        return distances[0] > distances[1] ? best[1] : best[0];
+    if (best[1] != -1)
+        return best[1];
+    if (best[0] != -1)
+        return best[0];
+    return container;
+}
@@ -0,0 +1,137 @@
+/* Copyright 2014 the SumatraPDF project authors (see AUTHORS file).
+   License: GPLv3 */
+
+#ifndef SyncTexIndex_h
+#define SyncTexIndex_h
+
+// SyncTexIndex holds the content of a .synctex file flattened into a few
+// arrays which are allocated as a single block so that they can be cached
+// on disk and memory-mapped back in when the same file is loaded again:
+// * nodes, boxes and children mirror the box tree built by synctex_parser
+// * lines are sorted by (tag, line) for forward search
+// * hboxes are sorted by sheet and top edge for inverse search
+// The query semantics follow synctex_display_query and synctex_edit_query
+// (see ext/synctex/synctex_parser.c) so that both give the same results.
+
+enum SyncTexNodeType {
+    SyncTex_Sheet, SyncTex_VBox, SyncTex_VoidVBox, SyncTex_HBox, SyncTex_VoidHBox,
+    SyncTex_Kern, SyncTex_Glue, SyncTex_Math, SyncTex_Boundary,
+};
+
+struct SyncTexNode {
+    int type;
+    int tag, line;
+    int h, v, width;
+    int parent; // index into boxes, -1 for sheets
+    int box;    // index into boxes, -1 for kerns, glues, maths and boundaries
+};
+
+struct SyncTexBox {
+    int node;
+    int page;
+    int height, depth;
+    // for hboxes widened to cover all children (same as _synctex_horiz_box_setup_visible)
+    int visibleH, visibleWidth;
+    int firstChild, childCount; // range in children
+};
+
+// forward-search entry (rank orders boundaries before kerns, glues
+// and maths before boxes, as synctex_display_query prefers them)
+struct SyncTexLine {
+    int tag, line, rank, node;
+};
+
+// inverse-search entry for an hbox
+struct SyncTexPageBox {
+    int sheet;  // index into nodes
+    int top;    // v - |height|
+    int box;
+    int order;  // closing order, for picking between identical overlapping boxes
+};
+
+struct SyncTexPage {
+    int sheet;      // index into nodes, -1 if there's no sheet for this page
+    int maxExtent;  // maximum |height| + |depth| of the sheet's hboxes
+};
+
+struct SyncTexInput {
+    int tag;
+    int name; // offset into names
+};
+
+// the arrays follow this header in the order in which they're counted
+struct SyncTexIndexHeader {
+    char magic[8];
+    int version, headerSize;
+    int64 syncFileSize;
+    FILETIME syncFileTime;
+    float unit, xOffset, yOffset;
+    int nodeCount, boxCount, childCount, lineCount, pageBoxCount, pageCount, inputCount;
+    // the path of the .synctex file the index was built for (zero-terminated)
+    int syncPathLen;
+    int namesLen;
+};
+
+class SyncTexIndex {
+public:
+    ~SyncTexIndex();
+
+    // loads the index from the cache in the temp directory (if it's still
+    // up-to-date) or builds it and updates the cache
+    static SyncTexIndex *Create(const WCHAR *syncfile);
+    static SyncTexIndex *Build(const WCHAR *syncfile);
+    static SyncTexIndex *Load(const WCHAR *cachefile, const WCHAR *syncfile);
+    bool Save(const WCHAR *cachefile) const;
+
+    int InputCount() const { return header->inputCount; }
+    int GetInputTag(int ix) const { return inputs[ix].tag; }
+    const char *GetInputName(int ix) const { return names + inputs[ix].name; }
+    const char *GetNameForTag(int tag) const;
+
+    const SyncTexNode& GetNode(int node) const { return nodes[node]; }
+    int GetPage(int node) const;
+    RectD GetBoxRect(int node) const;
+
+    // returns the nodes synctex_display_query would return
+    bool DisplayQuery(int tag, int line, Vec<int>& results) const;
+    // returns the first node synctex_edit_query would return (or -1)
+    int EditQuery(int page, float h, float v) const;
+
+private:
+    SyncTexIndex(char *data, size_t len, bool isMapped) :
+        data(data), len(len), isMapped(isMapped), header(NULL) { }
+    bool Init();
+    bool IsValid() const;
+
+    bool IsBox(int node) const { return nodes[node].box != -1 && nodes[node].type != SyncTex_Sheet; }
+    bool IsContainer(int node) const { return SyncTex_VBox == nodes[node].type || SyncTex_HBox == nodes[node].type; }
+    bool HasChildren(int node) const { return IsContainer(node) && boxes[nodes[node].box].childCount > 0; }
+    int GetChild(int node, int ix) const { return children[boxes[nodes[node].box].firstChild + ix]; }
+    bool IsDescendant(int node, int box) const;
+
+    int HDistance(PointI pt, int node) const;
+    int VDistance(PointI pt, int node) const;
+    bool IsPointInBox(PointI pt, int node) const;
+    int DistanceToPoint(PointI pt, int node) const;
+    int DeepestContainer(PointI pt, int node) const;
+    int ClosestChild(PointI pt, int node, int *distance) const;
+    int ClosestChild(PointI pt, int node) const;
+    void GetClosestChildren(PointI pt, int node, int best[2], int distances[2]) const;
+
+    char *data;
+    size_t len;
+    bool isMapped;
+
+    const SyncTexIndexHeader *header;
+    const SyncTexNode *nodes;
+    const SyncTexBox *boxes;
+    const int *children;
+    const SyncTexLine *lines;
+    const SyncTexPageBox *pageBoxes;
+    const SyncTexPage *pages;
+    const SyncTexInput *inputs;
+    const WCHAR *syncPath;
+    const char *names;
+};
+
+#endif
@@ -5,6 +5,12 @@
 #include "AppUtil.h"
 #include "FileUtil.h"
 #include "WinUtil.h"
+#include "SyncTexIndex.h"
+extern "C" {
+#include <mupdf/fitz.h>
+#include <mupdf/pdf.h>
+#include "synctex_parser.h"
+}
 
 // must be last due to assert() over-write
 #include "UtAssert.h"
@@ -64,6 +70,16 @@ static void ParseCommandLineTest()
         utassert(str::Eq(L"1,3,8-34", i.pathsToBenchmark.At(3)));
     }
 
+    {
+        CommandLineInfo i;
+        i.ParseCommandLine(L"SumatraPDF.exe -bench foo.pdf -bench-zoom 100,250 -bench-rotation 90 -bench-json out.json -n 4");
+        utassert(2 == i.pathsToBenchmark.Count());
+        utassert(str::Eq(L"100,250", i.benchZoomLevels));
+        utassert(str::Eq(L"90", i.benchRotations));
+        utassert(str::Eq(L"out.json", i.benchJsonPath));
+        utassert(4 == i.stressParallelCount);
+    }
+
     {
         CommandLineInfo i;
         utassert(i.textColor == WIN_COL_BLACK && i.backgroundColor == WIN_COL_WHITE);
@@ -192,6 +208,430 @@ static void hexstrTest()
     utassert(ok);
 }
 
+// verifies that the AES instructions (if available) and the table-based
+// implementation both reproduce the published test vectors and agree
+// with each other for all lengths, offsets and chaining patterns
+static void AesCheckCbc(const unsigned char *key, int keyBits, const unsigned char *iv, const unsigned char *plain, const unsigned char *cipher, int len)
+{
+    for (int hw = 0; hw < 2; hw++) {
+        fz_aes aes;
+        unsigned char ivCopy[16], out[64];
+        aes_setkey_enc(&aes, key, keyBits);
+        if (hw && !aes.hw)
+            break;
+        aes.hw = hw;
+        memcpy(ivCopy, iv, 16);
+        aes_crypt_cbc(&aes, AES_ENCRYPT, len, ivCopy, plain, out);
+        utassert(memeq(out, cipher, len));
+        utassert(memeq(ivCopy, cipher + len - 16, 16));
+
+        aes_setkey_dec(&aes, key, keyBits);
+        aes.hw = hw;
+        memcpy(ivCopy, iv, 16);
+        aes_crypt_cbc(&aes, AES_DECRYPT, len, ivCopy, cipher, out);
+        utassert(memeq(out, plain, len));
+        utassert(memeq(ivCopy, cipher + len - 16, 16));
+    }
+}
+
+static void AesCryptTest()
+{
+    // FIPS-197, appendix C (a single block with a zero IV is ECB)
+    static const unsigned char fipsCipher[3][16] = {
+        { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a },
+        { 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 },
+        { 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 },
+    };
+    unsigned char key[32], iv[16] = { 0 }, plain[64];
+    for (int i = 0; i < 32; i++)
+        key[i] = (unsigned char)i;
+    for (int i = 0; i < 16; i++)
+        plain[i] = (unsigned char)(i * 0x11);
+    for (int i = 0; i < 3; i++)
+        AesCheckCbc(key, 128 + 64 * i, iv, plain, fipsCipher[i], 16);
+
+    // NIST SP 800-38A, F.2.1 and F.2.5 (CBC-AES128 and CBC-AES256)
+    static const unsigned char spKey128[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+    };
+    static const unsigned char spKey256[32] = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+        0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+    };
+    static const unsigned char spPlain[64] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+        0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+        0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+        0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+    };
+    static const unsigned char spCipher128[64] = {
+        0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+        0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+        0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+        0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7
+    };
+    static const unsigned char spCipher256[64] = {
+        0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6,
+        0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d,
+        0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61,
+        0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9, 0xfc, 0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b
+    };
+    for (int i = 0; i < 16; i++)
+        iv[i] = (unsigned char)i;
+    // all prefixes, so that both the four-block and the single-block paths are covered
+    for (int len = 16; len <= 64; len += 16) {
+        AesCheckCbc(spKey128, 128, iv, spPlain, spCipher128, len);
+        AesCheckCbc(spKey256, 256, iv, spPlain, spCipher256, len);
+    }
+
+    // the AES instructions must match the table-based code for runs of up to 9 blocks
+    // (several four-block rounds plus a remainder), for unaligned buffers and
+    // for a chain split across two calls and decrypted in place
+    unsigned char data[16 * 9 + 3], expected[16 * 9], out[16 * 9 + 3], ivSw[16], ivHw[16];
+    for (size_t i = 0; i < dimof(data); i++)
+        data[i] = (unsigned char)(i * 7 + 3);
+    for (int keyBits = 128; keyBits <= 256; keyBits += 64) {
+        for (int mode = AES_DECRYPT; mode <= AES_ENCRYPT; mode++) {
+            fz_aes aes;
+            if (AES_DECRYPT == mode)
+                aes_setkey_dec(&aes, key, keyBits);
+            else
+                aes_setkey_enc(&aes, key, keyBits);
+            bool hasHw = aes.hw != 0;
+            for (int blocks = 1; blocks <= 9; blocks++) {
+                int len = blocks * 16;
+                for (int offset = 0; offset < 4; offset++) {
+                    aes.hw = 0;
+                    memcpy(ivSw, iv, 16);
+                    aes_crypt_cbc(&aes, mode, len, ivSw, data + offset, expected);
+                    if (!hasHw)
+                        continue;
+                    aes.hw = 1;
+                    memcpy(ivHw, iv, 16);
+                    aes_crypt_cbc(&aes, mode, len, ivHw, data + offset, out + 3 - offset);
+                    utassert(memeq(out + 3 - offset, expected, len));
+                    utassert(memeq(ivHw, ivSw, 16));
+
+                    int split = 16 * (offset % blocks);
+                    memcpy(out + offset, data, len);
+                    memcpy(ivHw, iv, 16);
+                    aes_crypt_cbc(&aes, mode, split, ivHw, out + offset, out + offset);
+                    aes_crypt_cbc(&aes, mode, len - split, ivHw, out + offset + split, out + offset + split);
+                    memcpy(ivSw, iv, 16);
+                    aes.hw = 0;
+                    aes_crypt_cbc(&aes, mode, len, ivSw, data, expected);
+                    utassert(memeq(out + offset, expected, len));
+                    utassert(memeq(ivHw, ivSw, 16));
+                }
+            }
+        }
+    }
+}
+
+// deterministic pseudo-random numbers in [min, max] for SyncTexIndexTest
+static int SyncTexRand(unsigned int& seed, int min, int max)
+{
+    seed = seed * 1103515245 + 12345;
+    return min + (int)((seed >> 16) % (unsigned int)(max - min + 1));
+}
+
+// appends an hbox or vbox with randomly placed content (including nested boxes)
+static void SyncTexGenBox(str::Str<char>& out, unsigned int& seed, int inputs, char kind, int h, int v, int width, int depth)
+{
+    const int unit = 65536;
+    int height = SyncTexRand(seed, 0, 20) * unit, boxDepth = SyncTexRand(seed, 0, 5) * unit;
+    out.AppendFmt("%c%d,%d:%d,%d:%d,%d,%d\n", kind, SyncTexRand(seed, 1, inputs), SyncTexRand(seed, 1, 60), h, v, width, height, boxDepth);
+    int count = depth < 5 ? SyncTexRand(seed, 0, 6) : 0;
+    int y = v - height;
+    for (int i = 0; i < count; i++) {
+        int x2, y2;
+        if ('(' == kind) {
+            x2 = h + SyncTexRand(seed, -10, width / unit + 10) * unit;
+            y2 = v + SyncTexRand(seed, -3, 3) * unit;
+        }
+        else {
+            y += SyncTexRand(seed, 0, 30) * unit;
+            x2 = h + SyncTexRand(seed, -5, 20) * unit;
+            y2 = y;
+        }
+        int tag = SyncTexRand(seed, 1, inputs), line = SyncTexRand(seed, 1, 60);
+        int kindOfChild = SyncTexRand(seed, 0, 99);
+        if (kindOfChild < 25 && depth < 5)
+            SyncTexGenBox(out, seed, inputs, SyncTexRand(seed, 0, 1) ? '(' : '[', x2, y2, SyncTexRand(seed, -5, 300) * unit, depth + 1);
+        else if (kindOfChild < 35)
+            out.AppendFmt("%c%d,%d:%d,%d:%d,%d,%d\n", SyncTexRand(seed, 0, 1) ? 'h' : 'v', tag, line, x2, y2,
+                          SyncTexRand(seed, -2, 50) * unit, SyncTexRand(seed, 0, 10) * unit, SyncTexRand(seed, 0, 3) * unit);
+        else if (kindOfChild < 50)
+            out.AppendFmt("k%d,%d:%d,%d:%d\n", tag, line, x2, y2, SyncTexRand(seed, -10, 10) * unit);
+        else if (kindOfChild < 65)
+            out.AppendFmt("g%d,%d:%d,%d\n", tag, line, x2, y2);
+        else if (kindOfChild < 75)
+            out.AppendFmt("$%d,%d:%d,%d\n", tag, line, x2, y2);
+        else
+            out.AppendFmt("x%d,%d:%d,%d\n", tag, line, x2, y2);
+    }
+    out.Append('(' == kind ? ")\n" : "]\n");
+}
+
+static char *SyncTexGenFile(unsigned int seed)
+{
+    static const int magnifications[] = { 1000, 1000, 1200 }, units[] = { 1, 1, 8192 };
+    str::Str<char> out;
+    int inputs = SyncTexRand(seed, 1, 4);
+    out.Append("SyncTeX Version:1\n");
+    for (int i = 1; i <= inputs; i++)
+        out.AppendFmt("Input:%d:./file%d.tex\n", i, i);
+    out.AppendFmt("Output:pdf\nMagnification:%d\nUnit:%d\nX Offset:%d\nY Offset:%d\nContent:\n",
+                  magnifications[SyncTexRand(seed, 0, 2)], units[SyncTexRand(seed, 0, 2)],
+                  SyncTexRand(seed, 0, 1) * 578, SyncTexRand(seed, 0, 1) * 578);
+    int pages = SyncTexRand(seed, 1, 4);
+    for (int page = 1; page <= pages; page++) {
+        out.AppendFmt("{%d\n", page);
+        for (int i = SyncTexRand(seed, 1, 4); i > 0; i--) {
+            SyncTexGenBox(out, seed, inputs, SyncTexRand(seed, 0, 1) ? '(' : '[', SyncTexRand(seed, 0, 100) * 65536,
+                          SyncTexRand(seed, 0, 800) * 65536, SyncTexRand(seed, 0, 500) * 65536, 0);
+        }
+        out.AppendFmt("}%d\n", page);
+        // inputs may also be declared in between pages
+        if (SyncTexRand(seed, 0, 9) < 3) {
+            inputs++;
+            out.AppendFmt("Input:%d:./file%d.tex\n", inputs, inputs);
+        }
+    }
+    out.Append("Postamble:\nCount:1\n");
+    if (SyncTexRand(seed, 0, 1))
+        out.Append("Post scriptum:\nMagnification:2.5\nX Offset:1in\nY Offset:12bp\n");
+    return out.StealData();
+}
+
+static bool SyncTexNearlyEq(double a, double b)
+{
+    return fabs(a - b) <= 1e-3 * (1 + fabs(a));
+}
+
+// SyncTexIndex must give the same results as synctex_parser for both
+// forward (display) and inverse (edit) searches
+static void SyncTexIndexTest()
+{
+    ScopedMem<WCHAR> tmpFile(path::GetTempPath(L"Stx"));
+    utassert(tmpFile);
+    if (!tmpFile)
+        return;
+    // synctex_parser looks for foo.synctex next to foo.pdf
+    ScopedMem<WCHAR> pdfFile(str::Join(tmpFile, L".pdf"));
+    ScopedMem<WCHAR> syncFile(str::Join(tmpFile, L".synctex"));
+    ScopedMem<WCHAR> cacheFile(str::Join(tmpFile, L".idx"));
+    ScopedMem<char> pdfFileA(str::conv::ToAnsi(pdfFile));
+
+    for (unsigned int seed = 1; seed <= 20; seed++) {
+        ScopedMem<char> data(SyncTexGenFile(seed));
+        bool ok = file::WriteAll(syncFile, data, str::Len(data));
+        utassert(ok);
+        SyncTexIndex *index = SyncTexIndex::Build(syncFile);
+        synctex_scanner_t scanner = synctex_scanner_new_with_output_file(pdfFileA, NULL, 1);
+        utassert(index && scanner);
+        if (!index || !scanner) {
+            delete index;
+            synctex_scanner_free(scanner);
+            break;
+        }
+
+        Vec<int> nodes;
+        for (int i = 0; i < index->InputCount(); i++) {
+            for (int line = 1; line <= 64; line++) {
+                bool found = index->DisplayQuery(index->GetInputTag(i), line, nodes);
+                utassert(found == (synctex_display_query(scanner, index->GetInputName(i), line, 0) > 0));
+                for (size_t j = 0; found && j < nodes.Count(); j++) {
+                    synctex_node_t node = synctex_next_result(scanner);
+                    utassert(node);
+                    if (!node)
+                        break;
+                    const SyncTexNode& n = index->GetNode(nodes.At(j));
+                    utassert(n.tag == synctex_node_tag(node) && n.line == synctex_node_line(node));
+                    utassert(index->GetPage(nodes.At(j)) == synctex_node_page(node));
+                    if (-1 == n.box)
+                        continue;
+                    RectD rc = index->GetBoxRect(nodes.At(j));
+                    float height = synctex_node_box_visible_height(node);
+                    utassert(SyncTexNearlyEq(rc.x, synctex_node_box_visible_h(node)));
+                    utassert(SyncTexNearlyEq(rc.y, synctex_node_box_visible_v(node) - height));
+                    utassert(SyncTexNearlyEq(rc.dx, synctex_node_box_visible_width(node)));
+                    utassert(SyncTexNearlyEq(rc.dy, height + synctex_node_box_visible_depth(node)));
+                }
+                utassert(!found || !synctex_next_result(scanner));
+            }
+        }
+
+        for (int page = 0; page <= 5; page++) {
+            for (int h = -100; h <= 800; h += 13) {
+                for (int v = -100; v <= 900; v += 17) {
+                    int node = index->EditQuery(page, (float)h, (float)v);
+                    synctex_node_t ref = NULL;
+                    if (synctex_edit_query(scanner, page, (float)h, (float)v) > 0)
+                        ref = synctex_next_result(scanner);
+                    utassert((-1 != node) == (NULL != ref));
+                    if (-1 == node || !ref)
+                        continue;
+                    const SyncTexNode& n = index->GetNode(node);
+                    utassert(n.tag == synctex_node_tag(ref) && n.line == synctex_node_line(ref));
+                    utassert(n.type == synctex_node_type(ref) - synctex_node_type_sheet);
+                }
+            }
+        }
+
+        // a cached index may only be used for the file it was built for
+        ok = index->Save(cacheFile);
+        utassert(ok);
+        SyncTexIndex *cached = SyncTexIndex::Load(cacheFile, syncFile);
+        utassert(cached && cached->InputCount() == index->InputCount());
+        delete cached;
+        cached = SyncTexIndex::Load(cacheFile, pdfFile);
+        utassert(!cached);
+        delete cached;
+
+        delete index;
+        synctex_scanner_free(scanner);
+    }
+
+    file::Delete(cacheFile);
+    file::Delete(syncFile);
+    file::Delete(tmpFile);
+}
+
+static pdf_document *PdfOpenDocument(fz_context *ctx, const WCHAR *filePath)
+{
+    pdf_document *doc = NULL;
+    fz_stream *stm = NULL;
+    fz_var(stm);
+    fz_try(ctx) {
+        stm = fz_open_file_w(ctx, filePath);
+        doc = pdf_open_document_with_stream(ctx, stm);
+    }
+    fz_always(ctx) {
+        fz_close(stm);
+    }
+    fz_catch(ctx) {
+        return NULL;
+    }
+    return doc;
+}
+
+// objects added for an incremental update must be readable after reopening
+static void PdfCheckUpdates(fz_context *ctx, const WCHAR *filePath, int updates)
+{
+    pdf_document *doc = PdfOpenDocument(ctx, filePath);
+    utassert(doc && !doc->repair_attempted);
+    if (!doc)
+        return;
+    for (int i = 1; i <= updates; i++) {
+        ScopedMem<char> key(str::Format("Root/Update%d/Round", i));
+        int round = 0;
+        fz_try(ctx) {
+            round = pdf_to_int(pdf_dict_getp(pdf_trailer(doc), key));
+        }
+        fz_catch(ctx) { }
+        utassert(i == round);
+    }
+    pdf_close_document(doc);
+}
+
+// saves two updates the way PdfEngineImpl::SaveUserAnnots does: appended to
+// the source (the second one only containing the changes since the first)
+// and to a copy of the original file (containing all changes at once)
+static void PdfIncrementalSaveTest()
+{
+    ScopedMem<WCHAR> tmpFile(path::GetTempPath(L"Pdf"));
+    utassert(tmpFile);
+    if (!tmpFile)
+        return;
+    ScopedMem<WCHAR> copyFile(str::Join(tmpFile, L".copy"));
+    ScopedMem<char> tmpFileUtf8(str::conv::ToUtf8(tmpFile));
+    ScopedMem<char> copyFileUtf8(str::conv::ToUtf8(copyFile));
+
+    fz_context *ctx = fz_new_context(NULL, NULL, FZ_STORE_UNLIMITED);
+    utassert(ctx);
+    if (!ctx)
+        return;
+
+    pdf_document *doc = NULL;
+    pdf_obj *obj = NULL;
+    fz_var(doc);
+    fz_var(obj);
+    fz_try(ctx) {
+        // object streams require PDF 1.5 (which writing them upgrades to)
+        fz_write_options opts = { 0 };
+        opts.do_objstms = 1;
+        doc = pdf_create_document(ctx);
+        pdf_write_document(doc, tmpFileUtf8, &opts);
+        pdf_close_document(doc);
+        doc = NULL;
+    }
+    fz_catch(ctx) {
+        pdf_close_document(doc);
+        doc = NULL;
+    }
+    size_t len;
+    ScopedMem<char> data(file::ReadAll(tmpFile, &len));
+    bool ok = data && file::WriteAll(copyFile, data, len);
+    utassert(ok);
+    if (ok)
+        doc = PdfOpenDocument(ctx, tmpFile);
+    utassert(doc);
+
+    int baseStartxref = doc ? doc->startxref : 0;
+    for (int i = 1; doc && i <= 2; i++) {
+        ScopedMem<char> update(str::Format("<< /Round %d >>", i));
+        ScopedMem<char> key(str::Format("Update%d", i));
+        fz_try(ctx) {
+            obj = pdf_new_obj_from_str(doc, update);
+            int objNum = pdf_create_object(doc);
+            pdf_update_object(doc, objNum, obj);
+            pdf_dict_puts_drop(pdf_dict_gets(pdf_trailer(doc), "Root"), key, pdf_new_indirect(doc, objNum, 0));
+
+            fz_write_options opts = { 0 };
+            opts.do_incremental = 1;
+            opts.do_objstms = 1;
+            opts.do_appending = i > 1;
+            pdf_write_document(doc, tmpFileUtf8, &opts);
+            pdf_xref_end_incremental_section(doc);
+
+            // the object streams only exist in the file, so they mustn't
+            // remain in the document as altered (free) objects
+            for (int num = 1; num < pdf_xref_len(doc); num++) {
+                if (pdf_xref_is_altered(doc, num))
+                    utassert(pdf_get_xref_entry(doc, num)->type != 'f');
+            }
+        }
+        fz_always(ctx) {
+            pdf_drop_obj(obj);
+            obj = NULL;
+        }
+        fz_catch(ctx) {
+            utassert(false);
+        }
+    }
+    if (doc) {
+        fz_try(ctx) {
+            fz_write_options opts = { 0 };
+            opts.do_incremental = 1;
+            opts.do_objstms = 1;
+            doc->startxref = baseStartxref;
+            pdf_write_document(doc, copyFileUtf8, &opts);
+        }
+        fz_catch(ctx) {
+            utassert(false);
+        }
+        pdf_close_document(doc);
+    }
+
+    PdfCheckUpdates(ctx, tmpFile, 2);
+    PdfCheckUpdates(ctx, copyFile, 2);
+
+    fz_free_context(ctx);
+    file::Delete(copyFile);
+    file::Delete(tmpFile);
+}
+
 void SumatraPDF_UnitTests()
 {
 #if 0
@@ -201,4 +641,7 @@ void SumatraPDF_UnitTests()
     versioncheck_test();
     UrlExtractTest();
     hexstrTest();
+    AesCryptTest();
+    SyncTexIndexTest();
+    PdfIncrementalSaveTest();
 }
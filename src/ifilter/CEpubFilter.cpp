@@ -56,46 +56,50 @@ static bool IsoDateParse(const WCHAR *isoDate, SYSTEMTIME *timeOut)
 
 static WCHAR *ExtractHtmlText(EpubDoc *doc)
 {
-    size_t len;
-    const char *data = doc->GetTextData(&len);
-
-    str::Str<char> text(len / 2);
-    HtmlPullParser p(data, len);
-    HtmlToken *t;
+    str::Str<char> text;
     Vec<HtmlTag> tagNesting;
-    while ((t = p.Next()) != NULL && !t->IsError()) {
-        if (t->IsText() && !tagNesting.Contains(Tag_Head) && !tagNesting.Contains(Tag_Script) && !tagNesting.Contains(Tag_Style)) {
-            // trim whitespace (TODO: also normalize within text?)
-            while (t->sLen > 0 && str::IsWs(t->s[0])) {
-                t->s++;
-                t->sLen--;
-            }
-            while (t->sLen > 0 && str::IsWs(t->s[t->sLen-1]))
-                t->sLen--;
-            if (t->sLen > 0) {
-                text.AppendAndFree(ResolveHtmlEntities(t->s, t->sLen));
-                text.Append(' ');
+    size_t start, len;
+    // parse the text one section (spine item) at a time
+    for (size_t idx = 0; ; idx = start + len) {
+        ScopedMem<char> data(doc->LoadHtmlSection(idx, &start, &len));
+        if (!data)
+            break;
+        HtmlPullParser p(data, len);
+        HtmlToken *t;
+        while ((t = p.Next()) != NULL && !t->IsError()) {
+            if (t->IsText() && !tagNesting.Contains(Tag_Head) && !tagNesting.Contains(Tag_Script) && !tagNesting.Contains(Tag_Style)) {
+                // trim whitespace (TODO: also normalize within text?)
+                while (t->sLen > 0 && str::IsWs(t->s[0])) {
+                    t->s++;
+                    t->sLen--;
+                }
+                while (t->sLen > 0 && str::IsWs(t->s[t->sLen-1]))
+                    t->sLen--;
+                if (t->sLen > 0) {
+                    text.AppendAndFree(ResolveHtmlEntities(t->s, t->sLen));
+                    text.Append(' ');
+                }
             }
-        }
-        else if (t->IsStartTag()) {
-            // TODO: force-close tags similar to HtmlFormatter.cpp's AutoCloseOnOpen?
-            if (!IsTagSelfClosing(t->tag))
-                tagNesting.Append(t->tag);
-        }
-        else if (t->IsEndTag()) {
-            if (!IsInlineTag(t->tag) && text.Size() > 0 && text.Last() == ' ') {
-                text.Pop();
-                text.Append("\r\n");
+            else if (t->IsStartTag()) {
+                // TODO: force-close tags similar to HtmlFormatter.cpp's AutoCloseOnOpen?
+                if (!IsTagSelfClosing(t->tag))
+                    tagNesting.Append(t->tag);
             }
-            // when closing a tag, if the top tag doesn't match but
-            // there are only potentially self-closing tags on the
-            // stack between the matching tag, we pop all of them
-            if (tagNesting.Contains(t->tag)) {
-                while (tagNesting.Last() != t->tag)
+            else if (t->IsEndTag()) {
+                if (!IsInlineTag(t->tag) && text.Size() > 0 && text.Last() == ' ') {
+                    text.Pop();
+                    text.Append("\r\n");
+                }
+                // when closing a tag, if the top tag doesn't match but
+                // there are only potentially self-closing tags on the
+                // stack between the matching tag, we pop all of them
+                if (tagNesting.Contains(t->tag)) {
+                    while (tagNesting.Last() != t->tag)
+                        tagNesting.Pop();
+                }
+                if (tagNesting.Count() > 0 && tagNesting.Last() == t->tag)
                     tagNesting.Pop();
             }
-            if (tagNesting.Count() > 0 && tagNesting.Last() == t->tag)
-                tagNesting.Pop();
         }
     }
 
@@ -335,6 +335,56 @@ char *ReadAllUtf(const char *filePath, size_t *fileSizeOut, Allocator *allocator
     return ReadAll(buf, fileSizeOut, allocator);
 }
 
+// note: the file can't be modified (but can be deleted) as long as it's mapped
+const char *MapView(const WCHAR *filePath, size_t *fileSizeOut)
+{
+    ScopedHandle h(OpenReadOnly(filePath));
+    if (h == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(h, &size) || 0 == size.QuadPart)
+        return NULL;
+#ifndef _WIN64
+    if (size.HighPart != 0)
+        return NULL;
+#endif
+
+    ScopedHandle hMap(CreateFileMapping(h, NULL, PAGE_READONLY, 0, 0, NULL));
+    if (!hMap)
+        return NULL;
+    // the view keeps the file mapping alive after the handles are closed
+    const char *data = (const char *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if (data && fileSizeOut)
+        *fileSizeOut = (size_t)size.QuadPart;
+    return data;
+}
+
+void UnmapView(const char *data)
+{
+    if (data)
+        UnmapViewOfFile(data);
+}
+
+// files modified within this time aren't mapped, as they might still be
+// overwritten (which a mapping prevents for as long as the file is open)
+#define MIN_MAPPED_FILE_AGE_SECS (24 * 60 * 60)
+
+bool IsSafeToMap(const WCHAR *filePath)
+{
+    // reading from a mapping fails hard if the drive goes away while the file is open
+    if (!path::IsOnFixedDrive(filePath))
+        return false;
+
+    FILETIME lastMod = GetModificationTime(filePath);
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER lastModVal = { lastMod.dwLowDateTime, lastMod.dwHighDateTime };
+    ULARGE_INTEGER nowVal = { now.dwLowDateTime, now.dwHighDateTime };
+    // FILETIME is in 100 nanosecond units
+    return nowVal.QuadPart >= lastModVal.QuadPart + MIN_MAPPED_FILE_AGE_SECS * 10000000ULL;
+}
+
 bool ReadAll(const WCHAR *filePath, char *buffer, size_t bufferLen)
 {
     ScopedHandle h(OpenReadOnly(filePath));
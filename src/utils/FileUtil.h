@@ -45,6 +45,14 @@ int          GetZoneIdentifier(const WCHAR *filePath);
 bool         SetZoneIdentifier(const WCHAR *filePath, int zoneId=URLZONE_INTERNET);
 
 HANDLE       OpenReadOnly(const WCHAR *filePath);
+// maps the whole file read-only into memory (only the parts which are
+// actually accessed are read from disk). Returns NULL if the file can't
+// be mapped (e.g. because it's empty). Release with UnmapView
+const char * MapView(const WCHAR *filePath, size_t *fileSizeOut);
+void         UnmapView(const char *data);
+// whether a file can be kept mapped while it's open (false for files on network
+// and removable drives and for recently modified ones, cf. MapView)
+bool         IsSafeToMap(const WCHAR *filePath);
 
 }
 
@@ -39,20 +39,67 @@ STATIC_ASSERT(sizeof(PdbHeader) == kPdbHeaderLen, pdbHeaderSize);
 STATIC_ASSERT(sizeof(PdbRecordHeader) == 8, pdbRecHeaderSize);
 
 PdbReader::PdbReader(const WCHAR *filePath) :
-    data(file::ReadAll(filePath, &dataSize))
+    mappedData(NULL), hFile(INVALID_HANDLE_VALUE), dataSize(0)
 {
+    InitializeCriticalSection(&readAccess);
+    if (file::IsSafeToMap(filePath))
+        mappedData = file::MapView(filePath, &dataSize);
+    if (!mappedData) {
+        // allow the file to be modified (or deleted) while it's open
+        hFile = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        LARGE_INTEGER size;
+        if (hFile != INVALID_HANDLE_VALUE && GetFileSizeEx(hFile, &size))
+            dataSize = (size_t)min(size.QuadPart, (uint32_t)-1);
+    }
     if (!ParseHeader())
         recOffsets.Reset();
 }
 
+PdbReader::~PdbReader()
+{
+    file::UnmapView(mappedData);
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+    FreeVecMembers(loadedRecords);
+    DeleteCriticalSection(&readAccess);
+}
+
+// returns a pointer into the mapped file or else reads the data into buf
+const char *PdbReader::GetData(size_t offset, size_t len, ScopedMem<char>& buf)
+{
+    if (offset > dataSize || len > dataSize - offset)
+        return NULL;
+    if (mappedData)
+        return mappedData + offset;
+    if (hFile == INVALID_HANDLE_VALUE)
+        return NULL;
+    // zero-terminate for convenience (as file::ReadAll does)
+    buf.Set(AllocArray<char>(len + 1));
+    if (!buf)
+        return NULL;
+    // read at an explicit offset so that no file pointer has to be shared
+    OVERLAPPED ov = { 0 };
+    ov.Offset = (DWORD)offset;
+    DWORD read;
+    ScopedCritSec scope(&readAccess);
+    if (!ReadFile(hFile, buf, (DWORD)len, &read, &ov) || read != len) {
+        buf.Set(NULL);
+        return NULL;
+    }
+    return buf;
+}
+
 bool PdbReader::ParseHeader()
 {
     CrashIf(recOffsets.Count() > 0);
 
     PdbHeader pdbHeader;
-    if (!data || dataSize < sizeof(pdbHeader))
+    ScopedMem<char> hdrBuf;
+    const char *hdrData = GetData(0, kPdbHeaderLen, hdrBuf);
+    if (!hdrData)
         return false;
-    ByteReader r(data, dataSize);
+    ByteReader r(hdrData, kPdbHeaderLen);
 
     bool ok = r.UnpackBE(&pdbHeader, sizeof(pdbHeader), "32b2w6d8b2dw");
     CrashIf(!ok);
@@ -64,8 +111,14 @@ bool PdbReader::ParseHeader()
     if (0 == pdbHeader.numRecords)
         return false;
 
+    size_t recHdrsLen = pdbHeader.numRecords * sizeof(PdbRecordHeader);
+    ScopedMem<char> recHdrsBuf;
+    const char *recHdrs = GetData(sizeof(pdbHeader), recHdrsLen, recHdrsBuf);
+    if (!recHdrs)
+        return false;
+    ByteReader rr(recHdrs, recHdrsLen);
     for (int i = 0; i < pdbHeader.numRecords; i++) {
-        uint32_t off = r.DWordBE(sizeof(pdbHeader) + i * sizeof(PdbRecordHeader));
+        uint32_t off = rr.DWordBE(i * sizeof(PdbRecordHeader));
         recOffsets.Append(off);
     }
     // add sentinel value to simplify use
@@ -79,6 +132,8 @@ bool PdbReader::ParseHeader()
         // but it's not true for mobi files, so we don't validate that
     }
 
+    if (!mappedData)
+        loadedRecords.AppendBlanks(pdbHeader.numRecords);
     return true;
 }
 
@@ -94,12 +149,47 @@ size_t PdbReader::GetRecordCount()
     return recOffsets.Count() - 1;
 }
 
+size_t PdbReader::GetRecordSize(size_t recNo)
+{
+    if (recNo + 1 >= recOffsets.Count())
+        return 0;
+    return recOffsets.At(recNo + 1) - recOffsets.At(recNo);
+}
+
 const char *PdbReader::GetRecord(size_t recNo, size_t *sizeOut)
 {
     if (recNo + 1 >= recOffsets.Count())
         return NULL;
     size_t offset = recOffsets.At(recNo);
+    size_t size = recOffsets.At(recNo + 1) - offset;
     if (sizeOut)
-        *sizeOut = recOffsets.At(recNo + 1) - offset;
-    return data + offset;
+        *sizeOut = size;
+    if (mappedData)
+        return mappedData + offset;
+
+    ScopedCritSec scope(&readAccess);
+    if (!loadedRecords.At(recNo)) {
+        ScopedMem<char> buf;
+        if (!GetData(offset, size, buf))
+            return NULL;
+        loadedRecords.At(recNo) = buf.StealData();
+    }
+    return loadedRecords.At(recNo);
+}
+
+const char *PdbReader::GetRecordTemp(size_t recNo, size_t *sizeOut, ScopedMem<char>& buf)
+{
+    if (recNo + 1 >= recOffsets.Count())
+        return NULL;
+    size_t offset = recOffsets.At(recNo);
+    size_t size = recOffsets.At(recNo + 1) - offset;
+    if (sizeOut)
+        *sizeOut = size;
+    if (!mappedData) {
+        // use an already cached copy, if there is one
+        ScopedCritSec scope(&readAccess);
+        if (loadedRecords.At(recNo))
+            return loadedRecords.At(recNo);
+    }
+    return GetData(offset, size, buf);
 }
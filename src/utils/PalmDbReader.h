@@ -7,8 +7,18 @@
 // http://en.wikipedia.org/wiki/PDB_(Palm_OS)
 #define kPdbHeaderLen 78
 
+// The file is memory mapped so that only the records actually
+// accessed are read. Files which mustn't be mapped (see file::IsSafeToMap)
+// are kept open without locking them and records are read on demand
+// instead. GetRecord and GetRecordTemp are thread-safe.
 class PdbReader {
-    ScopedMem<char> data;
+    // content of the whole file, if it could be memory mapped
+    const char *    mappedData;
+    // else records are read through hFile
+    HANDLE          hFile;
+    // records read through hFile (only for GetRecord)
+    Vec<char *>     loadedRecords;
+    CRITICAL_SECTION readAccess;
     size_t          dataSize;
     // offset of each pdb record within the file + a sentinel
     // value equal to file size to simplify use
@@ -17,13 +27,21 @@ class PdbReader {
     char            dbType[9];
 
     bool ParseHeader();
+    const char *GetData(size_t offset, size_t len, ScopedMem<char>& buf);
 
 public:
     PdbReader(const WCHAR *filePath);
+    ~PdbReader();
 
     const char *GetDbType();
     size_t GetRecordCount();
+    // the returned data remains valid for the lifetime of the reader
     const char *GetRecord(size_t recNo, size_t *sizeOut);
+    // for records which are only needed once: data read from disk isn't
+    // cached and only remains valid for the lifetime of buf
+    const char *GetRecordTemp(size_t recNo, size_t *sizeOut, ScopedMem<char>& buf);
+    // doesn't require reading the record
+    size_t GetRecordSize(size_t recNo);
 };
 
 #endif
@@ -0,0 +1,139 @@
+/* Copyright 2014 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#include "BaseUtil.h"
+#include "Trace.h"
+
+#include "FileUtil.h"
+
+namespace trace {
+
+// must be a power of two
+#define EVENTS_PER_THREAD 16384
+
+struct TraceEvent {
+    const char *name;
+    LONGLONG    time;
+    int         value;
+    char        type; // 'B'egin, 'E'nd or 'C'ounter
+};
+
+struct ThreadBuffer {
+    DWORD           threadId;
+    // number of events recorded (only ever modified by the owning thread)
+    volatile LONG   count;
+    ThreadBuffer *  next;
+    TraceEvent      events[EVENTS_PER_THREAD];
+};
+
+bool gEnabled = false;
+
+// buffers are never freed, so that the events of threads
+// that have exited in the meantime can still be saved
+static ThreadBuffer * volatile gBuffers = NULL;
+static DWORD gTlsIndex = TLS_OUT_OF_INDEXES;
+static LARGE_INTEGER gStartTime, gFrequency;
+
+void Enable(bool enable)
+{
+    if (enable && TLS_OUT_OF_INDEXES == gTlsIndex) {
+        gTlsIndex = TlsAlloc();
+        if (TLS_OUT_OF_INDEXES == gTlsIndex)
+            return;
+        QueryPerformanceFrequency(&gFrequency);
+        QueryPerformanceCounter(&gStartTime);
+        MemoryBarrier();
+    }
+    gEnabled = enable;
+}
+
+static ThreadBuffer *GetThreadBuffer()
+{
+    ThreadBuffer *buf = (ThreadBuffer *)TlsGetValue(gTlsIndex);
+    if (buf)
+        return buf;
+
+    buf = AllocStruct<ThreadBuffer>();
+    if (!buf)
+        return NULL;
+    buf->threadId = GetCurrentThreadId();
+    // prepend the buffer to the list of all buffers without locking
+    do {
+        buf->next = gBuffers;
+    } while (InterlockedCompareExchangePointer((PVOID volatile *)&gBuffers, buf, buf->next) != buf->next);
+    TlsSetValue(gTlsIndex, buf);
+    return buf;
+}
+
+static void Record(char type, const char *name, int value)
+{
+    if (!gEnabled)
+        return;
+    ThreadBuffer *buf = GetThreadBuffer();
+    if (!buf)
+        return;
+
+    TraceEvent *ev = &buf->events[buf->count & (EVENTS_PER_THREAD - 1)];
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    ev->name = name;
+    ev->time = now.QuadPart;
+    ev->value = value;
+    ev->type = type;
+    // only count the event once it's been completely written
+    InterlockedIncrement(&buf->count);
+}
+
+void BeginSpan(const char *name)
+{
+    Record('B', name, 0);
+}
+
+void EndSpan(const char *name)
+{
+    Record('E', name, 0);
+}
+
+void Counter(const char *name, int value)
+{
+    Record('C', name, value);
+}
+
+static void AppendEvent(str::Str<char>& json, ThreadBuffer *buf, TraceEvent *ev)
+{
+    double timeUs = (ev->time - gStartTime.QuadPart) * 1000000.0 / gFrequency.QuadPart;
+    json.Append(json.Count() > 0 ? ",\n" : "{\"traceEvents\":[\n");
+    json.Append("{\"name\":\"");
+    for (const char *c = ev->name; *c; c++) {
+        if ('"' == *c || '\\' == *c)
+            json.Append('\\');
+        json.Append(*c);
+    }
+    json.AppendFmt("\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u", ev->type, timeUs,
+                   GetCurrentProcessId(), buf->threadId);
+    if ('C' == ev->type)
+        json.AppendFmt(",\"args\":{\"value\":%d}", ev->value);
+    json.Append('}');
+}
+
+bool SaveChromeTrace(const WCHAR *filePath)
+{
+    if (TLS_OUT_OF_INDEXES == gTlsIndex)
+        return false;
+
+    str::Str<char> json;
+    for (ThreadBuffer *buf = gBuffers; buf; buf = buf->next) {
+        LONG count = buf->count;
+        // events still being recorded by other threads might be inconsistent
+        // if a buffer wraps around while saving (that's acceptable for tracing)
+        LONG first = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (LONG i = first; i < count; i++) {
+            AppendEvent(json, buf, &buf->events[i & (EVENTS_PER_THREAD - 1)]);
+        }
+    }
+    json.Append(json.Count() > 0 ? "\n]}\n" : "{\"traceEvents\":[]}\n");
+
+    return file::WriteAll(filePath, json.Get(), json.Count());
+}
+
+} // namespace trace
@@ -0,0 +1,56 @@
+/* Copyright 2014 the SumatraPDF project authors (see AUTHORS file).
+   License: Simplified BSD (see COPYING.BSD) */
+
+#ifndef Trace_h
+#define Trace_h
+
+/* Lightweight tracing of hot paths, for finding out where time goes
+(open the saved file at chrome://tracing).
+
+Tracing is always compiled in but disabled by default, in which case
+a span costs no more than checking a global flag. When enabled, events
+are recorded into a fixed-size ring buffer per thread without taking
+any locks (older events are overwritten once a buffer is full).
+
+void RenderSomething()
+{
+    ScopedTraceSpan span("RenderSomething");
+    trace::Counter("queue length", queueLength);
+    ...
+}
+
+Only pointers to span and counter names are recorded, so names
+must be string literals (or otherwise never be freed).
+*/
+
+namespace trace {
+
+extern bool gEnabled;
+
+inline bool IsEnabled() { return gEnabled; }
+void Enable(bool enable);
+
+void BeginSpan(const char *name);
+void EndSpan(const char *name);
+void Counter(const char *name, int value);
+
+// saves all events recorded so far in Chrome's trace event format
+bool SaveChromeTrace(const WCHAR *filePath);
+
+} // namespace trace
+
+class ScopedTraceSpan {
+    const char *name;
+
+public:
+    explicit ScopedTraceSpan(const char *name) : name(trace::IsEnabled() ? name : NULL) {
+        if (this->name)
+            trace::BeginSpan(this->name);
+    }
+    ~ScopedTraceSpan() {
+        if (name)
+            trace::EndSpan(name);
+    }
+};
+
+#endif
@@ -15,19 +15,34 @@
 
 ZipFile::ZipFile(const WCHAR *path, ZipMethod method, Allocator *allocator) :
     filenames(0, allocator), fileinfo(0, allocator), filepos(0, allocator),
-    allocator(allocator), commentLen(0)
+    allocator(allocator), commentLen(0), mappedData(NULL), mappedSize(0), filePath(NULL)
 {
+    InitializeCriticalSection(&ufAccess);
     zlib_filefunc64_def ffunc;
     fill_win32_filefunc64(&ffunc);
     uf = unzOpen2_64(path, &ffunc);
-    if (uf)
-        ExtractFilenames(method);
+    if (!uf)
+        return;
+    ExtractFilenames(method);
+    // mapped files can't be overwritten while they're open and reading from
+    // a mapping fails hard if the drive goes away, so the check comes first
+    if (!file::IsSafeToMap(path))
+        return;
+    mappedData = file::MapView(path, &mappedSize);
+    if (!mappedData)
+        return;
+    IndexMappedData();
+    // don't keep the file open a second time next to the mapping
+    filePath = str::Dup(path);
+    unzClose(uf);
+    uf = NULL;
 }
 
 ZipFile::ZipFile(IStream *stream, ZipMethod method, Allocator *allocator) :
     filenames(0, allocator), fileinfo(0, allocator), filepos(0, allocator),
-    allocator(allocator), commentLen(0)
+    allocator(allocator), commentLen(0), mappedData(NULL), mappedSize(0), filePath(NULL)
 {
+    InitializeCriticalSection(&ufAccess);
     zlib_filefunc64_def ffunc;
     fill_win32s_filefunc64(&ffunc);
     uf = unzOpen2_64(stream, &ffunc);
@@ -37,9 +52,12 @@ ZipFile::ZipFile(IStream *stream, ZipMethod method, Allocator *allocator) :
 
 ZipFile::~ZipFile()
 {
-    if (!uf)
-        return;
-    unzClose(uf);
+    if (mappedData)
+        file::UnmapView(mappedData);
+    if (uf)
+        unzClose(uf);
+    free(filePath);
+    DeleteCriticalSection(&ufAccess);
 }
 
 // cf. http://www.pkware.com/documents/casestudies/APPNOTE.TXT Appendix D
@@ -47,6 +65,22 @@ ZipFile::~ZipFile()
 
 #define INVALID_ZIP_FILE_POS ((ZPOS64_T)-1)
 
+struct ZipSortedName {
+    const WCHAR *name;
+    size_t idx;
+};
+
+static int cmpZipSortedName(const void *a, const void *b)
+{
+    const ZipSortedName *n1 = (const ZipSortedName *)a;
+    const ZipSortedName *n2 = (const ZipSortedName *)b;
+    int diff = _wcsicmp(n1->name, n2->name);
+    if (diff)
+        return diff;
+    // GetFileIndex returns the first one of several identical names
+    return n1->idx < n2->idx ? -1 : n1->idx > n2->idx ? 1 : 0;
+}
+
 void ZipFile::ExtractFilenames(ZipMethod method)
 {
     if (!uf)
@@ -81,11 +115,122 @@ void ZipFile::ExtractFilenames(ZipMethod method)
         err = unzGoToNextFile(uf);
     }
     commentLen = ginfo.size_comment;
+
+    Vec<ZipSortedName> sorted;
+    for (size_t i = 0; i < filenames.Count(); i++) {
+        ZipSortedName sn = { filenames.At(i), i };
+        sorted.Append(sn);
+    }
+    sorted.Sort(cmpZipSortedName);
+    for (size_t i = 0; i < sorted.Count(); i++) {
+        sortedIdxs.Append(sorted.At(i).idx);
+    }
+}
+
+#define ZIP_LOCAL_HEADER_SIG    0x04034b50
+#define ZIP_CENTRAL_HEADER_SIG  0x02014b50
+#define ZIP_END_OF_CD_SIG       0x06054b50
+#define ZIP_LOCAL_HEADER_SIZE   30
+#define ZIP_END_OF_CD_SIZE      22
+
+static uint16 ReadLE16(const char *data)
+{
+    const uint8 *d = (const uint8 *)data;
+    return (uint16)(d[0] | (d[1] << 8));
+}
+
+static uint32 ReadLE32(const char *data)
+{
+    const uint8 *d = (const uint8 *)data;
+    return (uint32)d[0] | ((uint32)d[1] << 8) | ((uint32)d[2] << 16) | ((uint32)d[3] << 24);
+}
+
+static uint64 ReadLE64(const char *data)
+{
+    return (uint64)ReadLE32(data) | ((uint64)ReadLE32(data + 4) << 32);
+}
+
+// determines where each entry's data starts within mappedData, so that entries
+// can be read without going through minizip (which also has to seek and parse
+// the local file header for every single entry)
+void ZipFile::IndexMappedData()
+{
+    // find the end of central directory record (which precedes the comment)
+    ZPOS64_T eocd = INVALID_ZIP_FILE_POS;
+    if (mappedSize >= ZIP_END_OF_CD_SIZE) {
+        size_t minPos = mappedSize > 0xFFFF + ZIP_END_OF_CD_SIZE ? mappedSize - 0xFFFF - ZIP_END_OF_CD_SIZE : 0;
+        for (size_t pos = mappedSize - ZIP_END_OF_CD_SIZE + 1; pos > minPos; pos--) {
+            if (ReadLE32(mappedData + pos - 1) == ZIP_END_OF_CD_SIG) {
+                eocd = pos - 1;
+                break;
+            }
+        }
+    }
+    if (INVALID_ZIP_FILE_POS == eocd)
+        return;
+
+    // the same as minizip's byte_before_the_zipfile (for e.g. self-extracting archives);
+    // only ZIP64 files where the central directory position overflows are handled by minizip
+    ZPOS64_T cdSize = ReadLE32(mappedData + eocd + 12);
+    ZPOS64_T cdOffset = ReadLE32(mappedData + eocd + 16);
+    if (cdOffset == 0xFFFFFFFF || cdSize == 0xFFFFFFFF || cdOffset + cdSize > eocd)
+        return;
+    ZPOS64_T bytesBefore = eocd - (cdOffset + cdSize);
+
+    for (size_t i = 0; i < filepos.Count(); i++) {
+        ZPOS64_T dataOffset = INVALID_ZIP_FILE_POS;
+        ZPOS64_T cdEntry = bytesBefore + filepos.At(i).pos_in_zip_directory;
+        if (filepos.At(i).num_of_file != INVALID_ZIP_FILE_POS && cdEntry + 46 <= eocd &&
+            ReadLE32(mappedData + cdEntry) == ZIP_CENTRAL_HEADER_SIG) {
+            ZPOS64_T localHeader = ReadLE32(mappedData + cdEntry + 42);
+            if (0xFFFFFFFF == localHeader) {
+                // the actual offset is stored in the ZIP64 extra field
+                const char *extra = mappedData + cdEntry + 46 + ReadLE16(mappedData + cdEntry + 28);
+                const char *extraEnd = extra + ReadLE16(mappedData + cdEntry + 30);
+                if (extraEnd > mappedData + eocd)
+                    extraEnd = extra;
+                for (; extra + 4 <= extraEnd; extra += 4 + ReadLE16(extra + 2)) {
+                    if (ReadLE16(extra) != 0x0001)
+                        continue;
+                    // skip the uncompressed and compressed sizes (if present)
+                    size_t skip = 0;
+                    if (0xFFFFFFFF == ReadLE32(mappedData + cdEntry + 24))
+                        skip += 8;
+                    if (0xFFFFFFFF == ReadLE32(mappedData + cdEntry + 20))
+                        skip += 8;
+                    if (extra + 4 + skip + 8 <= extraEnd && skip + 8 <= ReadLE16(extra + 2))
+                        localHeader = ReadLE64(extra + 4 + skip);
+                    break;
+                }
+            }
+            localHeader += bytesBefore;
+            if (localHeader + ZIP_LOCAL_HEADER_SIZE <= mappedSize &&
+                ReadLE32(mappedData + localHeader) == ZIP_LOCAL_HEADER_SIG) {
+                dataOffset = localHeader + ZIP_LOCAL_HEADER_SIZE +
+                             ReadLE16(mappedData + localHeader + 26) +
+                             ReadLE16(mappedData + localHeader + 28);
+                if (dataOffset > mappedSize || fileinfo.At(i).compressed_size > mappedSize - dataOffset)
+                    dataOffset = INVALID_ZIP_FILE_POS;
+            }
+        }
+        dataOffsets.Append(dataOffset);
+    }
 }
 
 size_t ZipFile::GetFileIndex(const WCHAR *fileName)
 {
-    return filenames.FindI(fileName);
+    // binary search for the first entry with a matching name
+    size_t lo = 0, hi = sortedIdxs.Count();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_wcsicmp(filenames.At(sortedIdxs.At(mid)), fileName) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < sortedIdxs.Count() && str::EqI(filenames.At(sortedIdxs.At(lo)), fileName))
+        return sortedIdxs.At(lo);
+    return (size_t)-1;
 }
 
 size_t ZipFile::GetFileCount() const
@@ -106,26 +251,81 @@ char *ZipFile::GetFileDataByName(const WCHAR *fileName, size_t *len)
     return GetFileDataByIdx(GetFileIndex(fileName), len);
 }
 
-char *ZipFile::GetFileDataByIdx(size_t fileindex, size_t *len)
+const char *ZipFile::GetFileDataView(size_t fileindex, size_t *len)
 {
-    if (!uf)
+    if (!mappedData || fileindex >= dataOffsets.Count())
         return NULL;
-    if (fileindex >= filenames.Count())
+    ZPOS64_T offset = dataOffsets.At(fileindex);
+    unz_file_info64& finfo = fileinfo.At(fileindex);
+    // encrypted entries are also not supported by GetFileDataByIdx
+    if (INVALID_ZIP_FILE_POS == offset || finfo.compression_method != Zip_None ||
+        (finfo.flag & 1) || finfo.compressed_size != finfo.uncompressed_size ||
+        (size_t)finfo.uncompressed_size != finfo.uncompressed_size) {
         return NULL;
+    }
+    *len = (size_t)finfo.uncompressed_size;
+    return mappedData + offset;
+}
 
-    int err = -1;
-    if (filepos.At(fileindex).num_of_file != INVALID_ZIP_FILE_POS)
-        err = unzGoToFilePos64(uf, &filepos.At(fileindex));
-    if (err != UNZ_OK) {
-        char fileNameA[MAX_PATH];
-        UINT cp = (fileinfo.At(fileindex).flag & (1 << 11)) ? CP_UTF8 : CP_ZIP;
-        str::conv::ToCodePageBuf(fileNameA, dimof(fileNameA), filenames.At(fileindex), cp);
-        err = unzLocateFile(uf, fileNameA, 0);
+// inflates the data directly from the mapping (without sharing any state
+// between threads), stored and deflated entries only
+char *ZipFile::GetFileDataFromMapping(size_t fileindex, size_t *len, size_t maxLen)
+{
+    unz_file_info64& finfo = fileinfo.At(fileindex);
+    ZPOS64_T offset = dataOffsets.At(fileindex);
+    const char *compressed = mappedData + offset;
+    unsigned int len2 = (unsigned int)finfo.uncompressed_size;
+    bool isPartial = maxLen < len2;
+    if (isPartial)
+        len2 = (unsigned int)maxLen;
+
+    char *result = (char *)Allocator::Alloc(allocator, len2 + sizeof(WCHAR));
+    if (!result)
+        return NULL;
+
+    bool ok = false;
+    if (Zip_None == finfo.compression_method) {
+        ok = finfo.compressed_size == finfo.uncompressed_size;
+        if (ok)
+            memcpy(result, compressed, len2);
     }
-    if (err != UNZ_OK)
+    else {
+        z_stream stream = { 0 };
+        stream.next_in = (Bytef *)compressed;
+        stream.avail_in = (uInt)finfo.compressed_size;
+        stream.next_out = (Bytef *)result;
+        stream.avail_out = len2;
+        // negative window bits: raw deflate data without zlib header
+        if (inflateInit2(&stream, -MAX_WBITS) == Z_OK) {
+            int res = inflate(&stream, isPartial ? Z_SYNC_FLUSH : Z_FINISH);
+            if (isPartial)
+                ok = (Z_OK == res || Z_STREAM_END == res || Z_BUF_ERROR == res) &&
+                     stream.total_out == len2;
+            else
+                ok = (Z_STREAM_END == res || Z_BUF_ERROR == res && 0 == stream.avail_in) &&
+                     stream.total_out == len2;
+            inflateEnd(&stream);
+        }
+    }
+    if (ok && !isPartial && crc32(0, (const Bytef *)result, len2) != finfo.crc) {
+        // CRC mismatch, file content is likely damaged
+        ok = false;
+    }
+    if (!ok) {
+        Allocator::Free(allocator, result);
         return NULL;
-    err = unzOpenCurrentFilePassword(uf, NULL);
-    if (err != UNZ_OK)
+    }
+
+    // zero-terminate for convenience
+    result[len2] = result[len2 + 1] = '\0';
+    if (len)
+        *len = len2;
+    return result;
+}
+
+char *ZipFile::GetFileDataByIdx(size_t fileindex, size_t *len)
+{
+    if (fileindex >= filenames.Count())
         return NULL;
 
     unsigned int len2 = (unsigned int)fileinfo.At(fileindex).uncompressed_size;
@@ -133,10 +333,20 @@ char *ZipFile::GetFileDataByIdx(size_t fileindex, size_t *len)
     if (len2 != fileinfo.At(fileindex).uncompressed_size ||
         len2 + sizeof(WCHAR) < sizeof(WCHAR) ||
         len2 / 1024 > fileinfo.At(fileindex).compressed_size) {
-        unzCloseCurrentFile(uf);
         return NULL;
     }
 
+    if (fileindex < dataOffsets.Count() && dataOffsets.At(fileindex) != INVALID_ZIP_FILE_POS &&
+        !(fileinfo.At(fileindex).flag & 1) &&
+        (Zip_None == fileinfo.At(fileindex).compression_method ||
+         Zip_Deflate == fileinfo.At(fileindex).compression_method)) {
+        return GetFileDataFromMapping(fileindex, len);
+    }
+
+    ScopedCritSec scope(&ufAccess);
+    if (!OpenCurrentFile(fileindex))
+        return NULL;
+
     char *result = (char *)Allocator::Alloc(allocator, len2 + sizeof(WCHAR));
     if (result) {
         unsigned int readBytes = unzReadCurrentFile(uf, result, len2);
@@ -151,7 +361,7 @@ char *ZipFile::GetFileDataByIdx(size_t fileindex, size_t *len)
         }
     }
 
-    err = unzCloseCurrentFile(uf);
+    int err = unzCloseCurrentFile(uf);
     if (err != UNZ_OK) {
         // CRC mismatch, file content is likely damaged
         Allocator::Free(allocator, result);
@@ -161,6 +371,78 @@ char *ZipFile::GetFileDataByIdx(size_t fileindex, size_t *len)
     return result;
 }
 
+char *ZipFile::GetFileDataPrefix(size_t fileindex, size_t maxLen, size_t *len)
+{
+    if (fileindex >= filenames.Count())
+        return NULL;
+    if (fileinfo.At(fileindex).uncompressed_size <= maxLen)
+        return GetFileDataByIdx(fileindex, len);
+
+    if (fileindex < dataOffsets.Count() && dataOffsets.At(fileindex) != INVALID_ZIP_FILE_POS &&
+        !(fileinfo.At(fileindex).flag & 1) &&
+        (Zip_None == fileinfo.At(fileindex).compression_method ||
+         Zip_Deflate == fileinfo.At(fileindex).compression_method)) {
+        return GetFileDataFromMapping(fileindex, len, maxLen);
+    }
+
+    unsigned int len2 = (unsigned int)maxLen;
+    if (len2 != maxLen || len2 + sizeof(WCHAR) < sizeof(WCHAR))
+        return NULL;
+
+    ScopedCritSec scope(&ufAccess);
+    if (!OpenCurrentFile(fileindex))
+        return NULL;
+
+    char *result = (char *)Allocator::Alloc(allocator, len2 + sizeof(WCHAR));
+    if (result) {
+        unsigned int readBytes = unzReadCurrentFile(uf, result, len2);
+        // zero-terminate for convenience
+        result[len2] = result[len2 + 1] = '\0';
+        if (readBytes != len2) {
+            Allocator::Free(allocator, result);
+            result = NULL;
+        }
+        else if (len) {
+            *len = len2;
+        }
+    }
+
+    // the CRC is only verified once the entry has been read completely
+    unzCloseCurrentFile(uf);
+    return result;
+}
+
+// reopens uf for memory mapped files (must be called inside ufAccess)
+bool ZipFile::OpenUnzFile()
+{
+    if (!uf && filePath) {
+        zlib_filefunc64_def ffunc;
+        fill_win32_filefunc64(&ffunc);
+        uf = unzOpen2_64(filePath, &ffunc);
+    }
+    return uf != NULL;
+}
+
+// positions uf at the given entry (must be called inside ufAccess)
+bool ZipFile::OpenCurrentFile(size_t fileindex)
+{
+    if (!OpenUnzFile())
+        return false;
+    int err = -1;
+    if (filepos.At(fileindex).num_of_file != INVALID_ZIP_FILE_POS)
+        err = unzGoToFilePos64(uf, &filepos.At(fileindex));
+    if (err != UNZ_OK) {
+        char fileNameA[MAX_PATH];
+        UINT cp = (fileinfo.At(fileindex).flag & (1 << 11)) ? CP_UTF8 : CP_ZIP;
+        str::conv::ToCodePageBuf(fileNameA, dimof(fileNameA), filenames.At(fileindex), cp);
+        err = unzLocateFile(uf, fileNameA, 0);
+    }
+    if (err != UNZ_OK)
+        return false;
+    err = unzOpenCurrentFilePassword(uf, NULL);
+    return UNZ_OK == err;
+}
+
 FILETIME ZipFile::GetFileTime(const WCHAR *fileName)
 {
     return GetFileTime(GetFileIndex(fileName));
@@ -169,7 +451,7 @@ FILETIME ZipFile::GetFileTime(const WCHAR *fileName)
 FILETIME ZipFile::GetFileTime(size_t fileindex)
 {
     FILETIME ft = { (DWORD)-1, (DWORD)-1 };
-    if (uf && fileindex < fileinfo.Count()) {
+    if (fileindex < fileinfo.Count()) {
         FILETIME ftLocal;
         DWORD dosDate = fileinfo.At(fileindex).dosDate;
         DosDateTimeToFileTime(HIWORD(dosDate), LOWORD(dosDate), &ftLocal);
@@ -180,7 +462,8 @@ FILETIME ZipFile::GetFileTime(size_t fileindex)
 
 char *ZipFile::GetComment(size_t *len)
 {
-    if (!uf)
+    ScopedCritSec scope(&ufAccess);
+    if (!OpenUnzFile())
         return NULL;
     char *comment = (char *)Allocator::Alloc(allocator, commentLen + 1);
     if (!comment)
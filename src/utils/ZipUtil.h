@@ -15,8 +15,26 @@ class ZipFile {
     Vec<unz_file_info64> fileinfo;
     Vec<unz64_file_pos> filepos;
     uLong commentLen;
+    // minizip's unzFile can only be used by a single thread at a time
+    CRITICAL_SECTION ufAccess;
+
+    // for files opened by path which file::IsSafeToMap accepts, the whole file
+    // is memory mapped and entries are read directly from the mapping (which
+    // allows concurrent access). uf is then closed after reading the directory
+    // and only reopened from filePath for entries which aren't read that way
+    const char *mappedData;
+    size_t mappedSize;
+    WCHAR *filePath;
+    // offsets of the (compressed) data of all entries within mappedData
+    Vec<ZPOS64_T> dataOffsets;
+    // file indices sorted by (case-insensitive) name for GetFileIndex
+    Vec<size_t> sortedIdxs;
 
     void ExtractFilenames(ZipMethod method=Zip_Any);
+    void IndexMappedData();
+    char *GetFileDataFromMapping(size_t fileindex, size_t *len, size_t maxLen=(size_t)-1);
+    bool OpenUnzFile();
+    bool OpenCurrentFile(size_t fileindex);
 
 public:
     ZipFile(const WCHAR *path, ZipMethod method=Zip_Any, Allocator *allocator=NULL);
@@ -30,8 +48,17 @@ public:
     size_t GetFileIndex(const WCHAR *filename);
 
     // caller must free() the result (or rather Allocator::Free it)
+    // note: this is thread-safe as long as allocator is
     char *GetFileDataByName(const WCHAR *filename, size_t *len=NULL);
     char *GetFileDataByIdx(size_t fileindex, size_t *len=NULL);
+    // same as GetFileDataByIdx but only decompresses the first maxLen bytes
+    // (e.g. for reading a file's header); the CRC of partial data isn't checked
+    char *GetFileDataPrefix(size_t fileindex, size_t maxLen, size_t *len);
+    // returns a pointer into the memory mapped file for uncompressed entries
+    // (or NULL for all others and if the file isn't mapped) which remains
+    // valid for ZipFile's lifetime
+    // note: the data isn't zero-terminated
+    const char *GetFileDataView(size_t fileindex, size_t *len);
 
     FILETIME GetFileTime(const WCHAR *filename);
     FILETIME GetFileTime(size_t fileindex);
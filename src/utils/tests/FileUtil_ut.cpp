@@ -50,4 +50,18 @@ void FileUtilTest()
     utassert(!path::Match(L"C:\\dir.xps\\file.pdf", L"*.xps;*.djvu"));
     utassert(!path::Match(L"C:\\file.pdf", L"f??f.p?f"));
     utassert(!path::Match(L"C:\\.pdf", L"?.pdf"));
+
+    ScopedMem<WCHAR> tmpPath(path::GetTempPath(L"Sum"));
+    utassert(tmpPath);
+    const char *data = "mapped file content";
+    utassert(file::WriteAll(tmpPath, data, str::Len(data)));
+    size_t size;
+    const char *view = file::MapView(tmpPath, &size);
+    utassert(view && size == str::Len(data) && memeq(view, data, size));
+    file::UnmapView(view);
+    // a file which has just been written might still be overwritten
+    utassert(!file::IsSafeToMap(tmpPath));
+    utassert(file::WriteAll(tmpPath, data, 0));
+    utassert(!file::MapView(tmpPath, &size));
+    utassert(file::Delete(tmpPath));
 }